@@ -0,0 +1,17 @@
+# - Find libzstd
+#
+#  This module defines
+#  ZSTD_FOUND         - True if libzstd has been found.
+#  ZSTD_LIBRARIES     - List of libraries when using libzstd.
+#  ZSTD_INCLUDE_DIRS  - libzstd include directories.
+
+# Look for the header file.
+find_path(ZSTD_INCLUDE_DIRS
+		NAMES zstd.h)
+
+# Find the library.
+find_library(ZSTD_LIBRARIES
+		NAMES zstd)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ZSTD DEFAULT_MSG ZSTD_LIBRARIES ZSTD_INCLUDE_DIRS)
@@ -92,6 +92,7 @@ INCLUDEPATH += \
 
 HEADERS += \
     $$PWD/backend/dab-audio.h \
+    $$PWD/backend/dab-data.h \
     $$PWD/backend/dab_decoder.h \
     $$PWD/backend/dabplus_decoder.h \
     $$PWD/backend/subchannel_sink.h \
@@ -99,9 +100,11 @@ HEADERS += \
     $$PWD/backend/dab-constants.h \
     $$PWD/backend/dab-processor.h \
     $$PWD/backend/dab-virtual.h \
+    $$PWD/backend/band-scanner.h \
     $$PWD/backend/mot_manager.h \
     $$PWD/backend/pad_decoder.h \
     $$PWD/backend/eep-protection.h \
+    $$PWD/backend/ensemble-cache.h \
     $$PWD/backend/energy_dispersal.h \
     $$PWD/backend/fib-processor.h \
     $$PWD/backend/fic-handler.h \
@@ -109,13 +112,17 @@ HEADERS += \
     $$PWD/backend/freq-interleaver.h \
     $$PWD/backend/ofdm-decoder.h \
     $$PWD/backend/ofdm-processor.h \
+    $$PWD/backend/packet-decoder.h \
     $$PWD/backend/phasereference.h \
     $$PWD/backend/phasetable.h \
     $$PWD/backend/tii-decoder.h \
+    $$PWD/backend/tii-stats.h \
     $$PWD/backend/protTables.h \
     $$PWD/backend/protection.h \
     $$PWD/backend/radio-controller.h \
     $$PWD/backend/radio-receiver.h \
+    $$PWD/backend/scan-precheck.h \
+    $$PWD/backend/spi-decoder.h \
     $$PWD/backend/tools.h \
     $$PWD/backend/uep-protection.h \
     $$PWD/backend/viterbi.h \\
@@ -133,6 +140,11 @@ HEADERS += \
     $$PWD/various/wavfile.h \
     $$PWD/various/Socket.h \
     $$PWD/various/MathHelper.h \
+    $$PWD/various/spectrum_engine.h \
+    $$PWD/various/metrics.h \
+    $$PWD/various/spsc_ring.h \
+    $$PWD/various/iq_recorder.h \
+    $$PWD/various/sigmf.h \
     $$PWD/libs/fec/char.h \
     $$PWD/libs/fec/decode_rs.h \
     $$PWD/libs/fec/encode_rs.h \
@@ -140,48 +152,70 @@ HEADERS += \
     $$PWD/libs/fec/init_rs.h \
     $$PWD/libs/fec/rs-common.h \
     $$PWD/backend/decoder_adapter.h \
+    $$PWD/input/channelizer.h \
+    $$PWD/input/ensemble_generator.h \
     $$PWD/input/input_factory.h \
+    $$PWD/input/iq_convert.h \
     $$PWD/input/null_device.h \
     $$PWD/input/raw_file.h \
+    $$PWD/input/resampler.h \
+    $$PWD/input/synthetic_input.h \
     $$PWD/input/virtual_input.h \
     $$PWD/input/rtl_tcp.h
 	
 SOURCES += \
     $$PWD/backend/dab-audio.cpp \
+    $$PWD/backend/dab-data.cpp \
     $$PWD/backend/dab_decoder.cpp \
     $$PWD/backend/dabplus_decoder.cpp \
     $$PWD/backend/charsets.cpp \
     $$PWD/backend/dab-constants.cpp \
+    $$PWD/backend/band-scanner.cpp \
     $$PWD/backend/mot_manager.cpp \
     $$PWD/backend/pad_decoder.cpp \
     $$PWD/backend/eep-protection.cpp \
+    $$PWD/backend/ensemble-cache.cpp \
     $$PWD/backend/fib-processor.cpp \
     $$PWD/backend/fic-handler.cpp \
     $$PWD/backend/msc-handler.cpp \
     $$PWD/backend/freq-interleaver.cpp \
     $$PWD/backend/ofdm-decoder.cpp \
     $$PWD/backend/ofdm-processor.cpp \
+    $$PWD/backend/packet-decoder.cpp \
     $$PWD/backend/phasereference.cpp \
     $$PWD/backend/phasetable.cpp \
     $$PWD/backend/tii-decoder.cpp \
+    $$PWD/backend/tii-stats.cpp \
     $$PWD/backend/protTables.cpp \
     $$PWD/backend/radio-receiver.cpp \
+    $$PWD/backend/scan-precheck.cpp \
+    $$PWD/backend/spi-decoder.cpp \
     $$PWD/backend/tools.cpp \
     $$PWD/backend/uep-protection.cpp \
     $$PWD/backend/viterbi.cpp \
     $$PWD/various/Xtan2.cpp \
     $$PWD/various/channels.cpp \
     $$PWD/various/fft.cpp \
+    $$PWD/various/spectrum_engine.cpp \
+    $$PWD/various/metrics.cpp \
+    $$PWD/various/spsc_ring.cpp \
+    $$PWD/various/iq_recorder.cpp \
+    $$PWD/various/sigmf.cpp \
     $$PWD/various/wavfile.c \
     $$PWD/various/Socket.cpp \
     $$PWD/libs/fec/encode_rs_char.c \
     $$PWD/libs/fec/decode_rs_char.c \
     $$PWD/libs/fec/init_rs_char.c \
     $$PWD/backend/decoder_adapter.cpp \
+    $$PWD/input/channelizer.cpp \
+    $$PWD/input/ensemble_generator.cpp \
     $$PWD/input/input_factory.cpp \
+    $$PWD/input/iq_convert.cpp \
     $$PWD/input/null_device.cpp \
     $$PWD/input/raw_file.cpp \
-    $$PWD/input/rtl_tcp.cpp
+    $$PWD/input/resampler.cpp \
+    $$PWD/input/rtl_tcp.cpp \
+    $$PWD/input/synthetic_input.cpp
 
 
 #### Built-in libraries ####
@@ -0,0 +1,252 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "band-scanner.h"
+#include "radio-receiver.h"
+#include "various/channels.h"
+#include <condition_variable>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+const char* scanOutcomeToString(ChannelScanResult::Outcome outcome)
+{
+    switch (outcome) {
+        case ChannelScanResult::Outcome::NoSignal: return "nosignal";
+        case ChannelScanResult::Outcome::NoEnsemble: return "noensemble";
+        case ChannelScanResult::Outcome::Ensemble: return "ensemble";
+    }
+    return "unknown";
+}
+
+// Waits for the verdict of the OFDMProcessor in scan mode
+class ScanListener : public RadioControllerInterface {
+    public:
+        enum class State { Waiting, Signal, NoSignal, InputFailure };
+
+        void onSNR(float) override {}
+        void onFrequencyCorrectorChange(int, int) override {}
+        void onSyncChange(char) override {}
+        void onSignalPresence(bool isSignal) override {
+            setState(isSignal ? State::Signal : State::NoSignal);
+        }
+        void onServiceDetected(uint32_t) override {}
+        void onNewEnsemble(uint16_t) override {}
+        void onSetEnsembleLabel(DabLabel&) override {}
+        void onDateTimeUpdate(const dab_date_time_t&) override {}
+        void onFIBDecodeSuccess(bool, const uint8_t*) override {}
+        void onNewImpulseResponse(std::vector<float>&&) override {}
+        void onConstellationPoints(std::vector<DSPCOMPLEX>&&) override {}
+        void onNewNullSymbol(std::vector<DSPCOMPLEX>&&) override {}
+        void onTIIMeasurement(tii_measurement_t&&) override {}
+        void onMessage(message_level_t, const std::string&, const std::string&) override {}
+        void onInputFailure(void) override { setState(State::InputFailure); }
+
+        // Returns Waiting on timeout
+        State wait(milliseconds timeout) {
+            unique_lock<mutex> lock(mut);
+            cv.wait_for(lock, timeout, [&]{ return state != State::Waiting; });
+            return state;
+        }
+
+        // After the verdict, returns true if the input failed within
+        // the timeout
+        bool waitForInputFailure(milliseconds timeout) {
+            unique_lock<mutex> lock(mut);
+            return cv.wait_for(lock, timeout, [&]{ return state == State::InputFailure; });
+        }
+
+    private:
+        void setState(State s) {
+            {
+                lock_guard<mutex> lock(mut);
+                // The first verdict counts
+                if (state == State::Waiting or s == State::InputFailure) {
+                    state = s;
+                }
+            }
+            cv.notify_all();
+        }
+
+        mutex mut;
+        condition_variable cv;
+        State state = State::Waiting;
+};
+
+BandScanner::BandScanner(vector<InputInterface*> tuners, Options options) :
+    tuners(move(tuners)),
+    options(options)
+{
+}
+
+vector<ChannelScanResult> BandScanner::scan(const vector<string>& channels,
+        ResultCallback callback)
+{
+    {
+        lock_guard<mutex> lock(mut);
+        this->channels = &channels;
+        this->callback = callback;
+        nextChannel = 0;
+        results.clear();
+        results.resize(channels.size());
+    }
+
+    running = true;
+    vector<thread> threads;
+    for (size_t tuner = 0; tuner < tuners.size(); tuner++) {
+        threads.emplace_back(&BandScanner::scanWith, this, tuner);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    running = false;
+
+    lock_guard<mutex> lock(mut);
+    vector<ChannelScanResult> scanned;
+    for (auto& r : results) {
+        if (r) {
+            scanned.push_back(move(*r));
+        }
+    }
+    results.clear();
+    this->channels = nullptr;
+    this->callback = nullptr;
+    return scanned;
+}
+
+void BandScanner::stop()
+{
+    running = false;
+}
+
+bool BandScanner::isComplete(const EnsembleSnapshot& ensemble)
+{
+    if (ensemble.ensembleLabel.fig1_label.empty() or ensemble.services.empty()) {
+        return false;
+    }
+
+    for (const auto& s : ensemble.services) {
+        if (s.serviceLabel.fig1_label.empty() or
+                ensemble.serviceComponents.count(s.serviceId) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BandScanner::scanWith(size_t tuner)
+{
+    while (running) {
+        size_t index = 0;
+        {
+            lock_guard<mutex> lock(mut);
+            if (nextChannel >= channels->size()) {
+                return;
+            }
+            index = nextChannel++;
+        }
+
+        auto result = scanChannel(tuner, (*channels)[index]);
+        if (not running) {
+            // Interrupted, the result means nothing
+            return;
+        }
+
+        lock_guard<mutex> lock(mut);
+        if (callback) {
+            callback(result);
+        }
+        results[index] = make_unique<ChannelScanResult>(move(result));
+    }
+}
+
+ChannelScanResult BandScanner::scanChannel(size_t tuner, const string& channel)
+{
+    const auto start = steady_clock::now();
+
+    ChannelScanResult result;
+    result.channel = channel;
+    result.tuner = tuner;
+
+    Channels channelList;
+    result.frequency = channelList.getFrequency(channel);
+    if (result.frequency == 0) {
+        std::clog << "BandScanner: unknown channel " << channel << std::endl;
+        return result;
+    }
+
+    auto& input = *tuners[tuner];
+    input.setFrequency(result.frequency);
+    input.reset();
+
+    ScanListener listener;
+    RadioReceiver rx(listener, input, options.rro);
+    rx.restart(true);
+
+    // Wait in short steps, to notice stop()
+    const milliseconds step(50);
+
+    auto state = ScanListener::State::Waiting;
+    for (auto waited = milliseconds(0);
+            running and state == ScanListener::State::Waiting and
+            waited < options.syncTimeout; waited += step) {
+        state = listener.wait(step);
+    }
+
+    if (state == ScanListener::State::Signal) {
+        result.outcome = ChannelScanResult::Outcome::NoEnsemble;
+
+        const auto signalTime = steady_clock::now();
+        auto changeTime = signalTime;
+        uint64_t version = 0;
+        while (running and steady_clock::now() - signalTime < options.ensembleTimeout) {
+            const auto ensemble = rx.getEnsemble();
+            const auto now = steady_clock::now();
+            if (ensemble->version != version) {
+                version = ensemble->version;
+                changeTime = now;
+            }
+            result.ensemble = ensemble;
+
+            if (isComplete(*ensemble) and now - changeTime >= options.settleTime) {
+                break;
+            }
+
+            if (listener.waitForInputFailure(step)) {
+                break;
+            }
+        }
+
+        if (result.ensemble and not result.ensemble->services.empty()) {
+            result.outcome = ChannelScanResult::Outcome::Ensemble;
+        }
+    }
+
+    rx.stop();
+    result.duration = duration_cast<milliseconds>(steady_clock::now() - start);
+    return result;
+}
@@ -0,0 +1,115 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "radio-controller.h"
+#include "radio-receiver-options.h"
+#include "fib-processor.h"
+
+struct ChannelScanResult {
+    enum class Outcome {
+        // The precheck or the synchronisation found nothing
+        NoSignal,
+        // Synchronised, but no service was received in time
+        NoEnsemble,
+        Ensemble,
+    };
+
+    std::string channel;
+    int frequency = 0;
+    // Index of the tuner that scanned the channel
+    size_t tuner = 0;
+    Outcome outcome = Outcome::NoSignal;
+    // The ensemble as it was when the scan of the channel ended
+    std::shared_ptr<const EnsembleSnapshot> ensemble;
+    // From tuning to the result
+    std::chrono::milliseconds duration{0};
+};
+
+const char* scanOutcomeToString(ChannelScanResult::Outcome outcome);
+
+/* Scans a list of channels for ensembles. Each channel gets a receiver in
+ * scan mode, which rejects empty channels after a short precheck, see
+ * ScanPrecheck, and decodes only the FIC of the others. A channel is done
+ * as soon as its ensemble is complete, instead of after a fixed time.
+ *
+ * With several tuners, the channels are distributed among them and
+ * scanned in parallel, one thread per tuner. */
+class BandScanner {
+    public:
+        struct Options {
+            RadioReceiverOptions rro;
+            // Longest wait for the synchronisation
+            std::chrono::milliseconds syncTimeout{3000};
+            // Longest wait for a complete ensemble after synchronisation
+            std::chrono::milliseconds ensembleTimeout{10000};
+            // A complete ensemble must not change for this long
+            std::chrono::milliseconds settleTime{1000};
+        };
+
+        // Called from the scanning threads, in the order the
+        // channels are finished
+        using ResultCallback = std::function<void(const ChannelScanResult&)>;
+
+        BandScanner(std::vector<InputInterface*> tuners, Options options);
+        BandScanner(const BandScanner&) = delete;
+        BandScanner& operator=(const BandScanner&) = delete;
+
+        // Blocks until all channels are scanned or stop() is called.
+        // The results are in the order of the channels, those that were
+        // not scanned because of stop() are left out.
+        std::vector<ChannelScanResult> scan(const std::vector<std::string>& channels,
+                ResultCallback callback = nullptr);
+
+        // Can be called from any thread
+        void stop();
+
+        // All services have a label and components, and the ensemble
+        // has a label
+        static bool isComplete(const EnsembleSnapshot& ensemble);
+
+    private:
+        void scanWith(size_t tuner);
+        ChannelScanResult scanChannel(size_t tuner, const std::string& channel);
+
+        const std::vector<InputInterface*> tuners;
+        const Options options;
+
+        std::atomic<bool> running = ATOMIC_VAR_INIT(false);
+
+        std::mutex mut;
+        const std::vector<std::string> *channels = nullptr;
+        size_t nextChannel = 0;
+        std::vector<std::unique_ptr<ChannelScanResult> > results;
+        ResultCallback callback;
+};
@@ -45,13 +45,15 @@
 //  fragmentsize == Length * CUSize
 DabAudio::DabAudio(
         AudioServiceComponentType dabModus,
+        int subChId,
         int16_t fragmentSize,
         int16_t bitRate,
         ProtectionSettings protection,
         ProgrammeHandlerInterface& phi,
-        const std::string& dumpFileName) :
+        const std::string& dumpFileName,
+        const std::string& metricsLabels) :
     myProgrammeHandler(phi),
-    mscBuffer(64 * 32768),
+    mscBuffer(64 * 32768, true),
     dumpFileName(dumpFileName)
 {
     this->dabModus         = dabModus;
@@ -76,7 +78,8 @@ DabAudio::DabAudio(
     }
 
     our_dabProcessor = make_unique<DecoderAdapter>(
-            myProgrammeHandler, bitRate, dabModus, dumpFileName);
+            myProgrammeHandler, subChId, bitRate, dabModus, dumpFileName,
+            metricsLabels);
 
     running = true;
     ourThread = std::thread(&DabAudio::run, this);
@@ -96,16 +99,16 @@ int32_t DabAudio::process(const softbit_t *v, int16_t cnt)
 {
     int32_t fr;
 
-    if (mscBuffer.GetRingBufferWriteAvailable () < cnt)
+    if ((int32_t)mscBuffer.writeAvailable() < cnt)
         fprintf (stderr, "dab-concurrent: buffer full\n");
 
-    while ((fr = mscBuffer.GetRingBufferWriteAvailable ()) <= cnt) {
+    while ((fr = mscBuffer.writeAvailable()) <= cnt) {
         if (!running)
             return 0;
         std::this_thread::sleep_for(std::chrono::microseconds(1));
     }
 
-    mscBuffer.putDataIntoBuffer(v, cnt);
+    mscBuffer.push(v, cnt);
     mscDataAvailable.notify_all();
     return fr;
 }
@@ -122,7 +125,7 @@ void DabAudio::run()
 
     while (running) {
         std::unique_lock<std::mutex> lock(ourMutex);
-        while (running && mscBuffer.GetRingBufferReadAvailable() <= fragmentSize) {
+        while (running && (int32_t)mscBuffer.readAvailable() <= fragmentSize) {
             mscDataAvailable.wait(lock);
         }
         if (!running)
@@ -132,16 +135,28 @@ void DabAudio::run()
         lock.unlock();
 
         PROFILE(DAGetMSCData);
-        mscBuffer.getDataFromBuffer(data.data(), fragmentSize);
+        // The ring is mirrored, so the fragment can be deinterleaved in
+        // place. Copy it out only if the mirror is not available and
+        // the fragment wraps around.
+        const auto fragment = mscBuffer.peek(fragmentSize);
+        const softbit_t *in = fragment.data;
+        if ((int16_t)fragment.size < fragmentSize) {
+            mscBuffer.pop(data.data(), fragmentSize);
+            in = data.data();
+        }
 
         PROFILE(DADeinterleave);
         for (i = 0; i < fragmentSize; i ++) {
             tempX[i] = interleaveData[(interleaverIndex +
                     interleaveMap[i & 017]) & 017][i];
-            interleaveData[interleaverIndex][i] = data[i];
+            interleaveData[interleaverIndex][i] = in[i];
         }
         interleaverIndex = (interleaverIndex + 1) & 0x0F;
 
+        if (in == fragment.data) {
+            mscBuffer.consume(fragmentSize);
+        }
+
         //  only continue when de-interleaver is filled
         if (countforInterleaver <= 15) {
             countforInterleaver ++;
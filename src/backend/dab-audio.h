@@ -33,7 +33,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <cstdio>
-#include "ringbuffer.h"
+#include "spsc_ring.h"
 #include "energy_dispersal.h"
 #include "radio-controller.h"
 
@@ -44,11 +44,13 @@ class DabAudio : public DabVirtual
 {
     public:
         DabAudio(AudioServiceComponentType dabModus,
+                  int subChId,
                   int16_t fragmentSize,
                   int16_t bitRate,
                   ProtectionSettings protection,
                   ProgrammeHandlerInterface& phi,
-                  const std::string& dumpFileName);
+                  const std::string& dumpFileName,
+                  const std::string& metricsLabels = "");
         virtual ~DabAudio(void);
         DabAudio(const DabAudio&) = delete;
         DabAudio& operator=(const DabAudio&) = delete;
@@ -74,7 +76,7 @@ class DabAudio : public DabVirtual
 
         std::unique_ptr<Protection> protectionHandler;
         std::unique_ptr<DabProcessor> our_dabProcessor;
-        RingBuffer<softbit_t> mscBuffer;
+        SpscRing<softbit_t> mscBuffer;
 
         const std::string dumpFileName;
 };
@@ -360,6 +360,7 @@ void DABParams::setMode(int mode)
             T_u = 2048;
             guardLength = 504;
             carrierDiff = 1000;
+            fibsPerCIF = 3;
             break;
 
         case 2:
@@ -372,6 +373,7 @@ void DABParams::setMode(int mode)
             T_u = 512;
             guardLength = 126;
             carrierDiff = 4000;
+            fibsPerCIF = 3;
             break;
 
         case 3:
@@ -384,6 +386,7 @@ void DABParams::setMode(int mode)
             T_u = 256;
             guardLength = 63;
             carrierDiff = 2000;
+            fibsPerCIF = 4;
             break;
 
         case 4:
@@ -396,6 +399,7 @@ void DABParams::setMode(int mode)
             T_u = 1024;
             guardLength = 252;
             carrierDiff = 2000;
+            fibsPerCIF = 3;
             break;
 
         default:
@@ -83,6 +83,7 @@ public:
     int16_t T_u; // Size of the FFT == symbol length without cyclic prefix
     int16_t guardLength;
     int16_t carrierDiff;
+    int16_t fibsPerCIF; // FIBs in the FIC of one CIF
 };
 
 struct DabLabel {
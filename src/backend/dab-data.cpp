@@ -0,0 +1,204 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <iostream>
+#include "dab-data.h"
+#include "eep-protection.h"
+#include "uep-protection.h"
+
+using namespace std;
+
+// CIFs queued per subchannel before the data is dropped
+static const size_t MAX_QUEUED_CIFS = 32;
+
+static const int16_t interleaveMap[] = {0,8,4,12,2,10,6,14,1,9,5,13,3,11,7,15};
+
+DabData::DabData(
+        int subChId,
+        int16_t fragmentSize,
+        int16_t bitRate,
+        ProtectionSettings protection,
+        bool fec) :
+    subChId(subChId),
+    fragmentSize(fragmentSize),
+    bitRate(bitRate),
+    mscBuffer(MAX_QUEUED_CIFS * fragmentSize),
+    fragment(fragmentSize),
+    tempX(fragmentSize),
+    outV(bitRate * 24),
+    bytes(bitRate * 3),
+    packetDecoder(fec)
+{
+    for (int i = 0; i < 16; i++) {
+        interleaveData[i].resize(fragmentSize);
+    }
+
+    if (protection.shortForm) {
+        protectionHandler = make_unique<UEPProtection>(bitRate, protection.uepLevel);
+    }
+    else {
+        const bool profile_is_eep_a =
+            protection.eepProfile == EEPProtectionProfile::EEP_A;
+        protectionHandler = make_unique<EEPProtection>(
+                bitRate, profile_is_eep_a, (int)protection.eepLevel);
+    }
+}
+
+DabData::~DabData()
+{
+}
+
+int32_t DabData::process(const softbit_t *v, int16_t cnt)
+{
+    // Called from the OFDM thread, which must never wait for the worker
+    if ((int32_t)mscBuffer.writeAvailable() < cnt) {
+        if (not bufferFullReported) {
+            cerr << "DabData: buffer of subchannel " << subChId <<
+                " full, dropping data" << endl;
+            bufferFullReported = true;
+        }
+        return 0;
+    }
+
+    mscBuffer.push(v, cnt);
+    return cnt;
+}
+
+void DabData::subscribe(uint16_t packetAddress, bool dataGroups,
+        PacketDataHandlerInterface& handler)
+{
+    lock_guard<mutex> lock(decoderMutex);
+    packetDecoder.subscribe(packetAddress, dataGroups, handler);
+}
+
+bool DabData::unsubscribe(uint16_t packetAddress)
+{
+    lock_guard<mutex> lock(decoderMutex);
+    packetDecoder.unsubscribe(packetAddress);
+    return packetDecoder.hasSubscriptions();
+}
+
+PacketDecoder::Stats DabData::getStats()
+{
+    lock_guard<mutex> lock(decoderMutex);
+    return packetDecoder.getStats();
+}
+
+void DabData::decode()
+{
+    while ((int32_t)mscBuffer.readAvailable() >= fragmentSize) {
+        mscBuffer.pop(fragment.data(), fragmentSize);
+
+        for (int16_t i = 0; i < fragmentSize; i++) {
+            tempX[i] = interleaveData[(interleaverIndex +
+                    interleaveMap[i & 017]) & 017][i];
+            interleaveData[interleaverIndex][i] = fragment[i];
+        }
+        interleaverIndex = (interleaverIndex + 1) & 0x0F;
+
+        //  only continue when de-interleaver is filled
+        if (countforInterleaver <= 15) {
+            countforInterleaver++;
+            continue;
+        }
+
+        protectionHandler->deconvolve(tempX.data(), fragmentSize, outV.data());
+        energyDispersal.dedisperse(outV);
+
+        for (size_t i = 0; i < bytes.size(); i++) {
+            uint8_t b = 0;
+            for (int j = 0; j < 8; j++) {
+                b = (b << 1) | (outV[8 * i + j] & 1);
+            }
+            bytes[i] = b;
+        }
+
+        lock_guard<mutex> lock(decoderMutex);
+        packetDecoder.process(bytes.data(), bytes.size());
+    }
+}
+
+DabDataWorker::~DabDataWorker()
+{
+    {
+        lock_guard<mutex> lock(workerMutex);
+        running = false;
+    }
+    dataAvailable.notify_all();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void DabDataWorker::add(shared_ptr<DabData> dabData)
+{
+    lock_guard<mutex> lock(workerMutex);
+    handlers.push_back(move(dabData));
+
+    if (not running) {
+        running = true;
+        thread = std::thread(&DabDataWorker::run, this);
+    }
+}
+
+void DabDataWorker::remove(const shared_ptr<DabData>& dabData)
+{
+    lock_guard<mutex> lock(workerMutex);
+    handlers.erase(std::remove(handlers.begin(), handlers.end(), dabData),
+            handlers.end());
+}
+
+void DabDataWorker::notify()
+{
+    {
+        lock_guard<mutex> lock(workerMutex);
+        pending = true;
+    }
+    dataAvailable.notify_one();
+}
+
+void DabDataWorker::run()
+{
+    unique_lock<mutex> lock(workerMutex);
+    while (running) {
+        dataAvailable.wait(lock, [&]{ return pending or not running; });
+        if (not running) {
+            break;
+        }
+        pending = false;
+
+        // The handlers may be removed while they decode,
+        // the copy keeps them alive.
+        const auto current = handlers;
+        lock.unlock();
+
+        for (const auto& h : current) {
+            h->decode();
+        }
+
+        lock.lock();
+    }
+}
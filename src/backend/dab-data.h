@@ -0,0 +1,122 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dab-virtual.h"
+#include "energy_dispersal.h"
+#include "packet-decoder.h"
+#include "radio-controller.h"
+#include "spsc_ring.h"
+
+class Protection;
+
+/* Decoder of a packet mode subchannel: time deinterleaving, Viterbi
+ * decoding and energy dispersal like for audio, followed by the
+ * PacketDecoder. process() only queues the CIF data, the decoding is
+ * done by the DabDataWorker, which serves all data subchannels.
+ *
+ * The handlers are called from the worker thread, and must not
+ * unsubscribe from there. */
+class DabData : public DabVirtual
+{
+    public:
+        // fragmentSize == Length * CUSize
+        DabData(int subChId,
+                int16_t fragmentSize,
+                int16_t bitRate,
+                ProtectionSettings protection,
+                bool fec);
+        virtual ~DabData();
+        DabData(const DabData&) = delete;
+        DabData& operator=(const DabData&) = delete;
+
+        int32_t process(const softbit_t *v, int16_t cnt) override;
+
+        void subscribe(uint16_t packetAddress, bool dataGroups,
+                PacketDataHandlerInterface& handler);
+        // Returns true if other addresses are still subscribed
+        bool unsubscribe(uint16_t packetAddress);
+
+        PacketDecoder::Stats getStats();
+
+        // Decode all queued CIFs, called by the worker
+        void decode();
+
+    private:
+        const int subChId;
+        const int16_t fragmentSize;
+        const int16_t bitRate;
+
+        std::unique_ptr<Protection> protectionHandler;
+        EnergyDispersal energyDispersal;
+        SpscRing<softbit_t> mscBuffer;
+        bool bufferFullReported = false;
+
+        // Only used by the worker
+        std::vector<softbit_t> interleaveData[16];
+        int16_t interleaverIndex = 0;
+        int16_t countforInterleaver = 0;
+        std::vector<softbit_t> fragment;
+        std::vector<softbit_t> tempX;
+        std::vector<uint8_t> outV;
+        std::vector<uint8_t> bytes;
+
+        std::mutex decoderMutex;
+        PacketDecoder packetDecoder;
+};
+
+/* One thread decoding all packet mode subchannels. Data subchannels have
+ * low bitrates, a thread each like for audio would mostly sleep. */
+class DabDataWorker
+{
+    public:
+        DabDataWorker() = default;
+        ~DabDataWorker();
+        DabDataWorker(const DabDataWorker&) = delete;
+        DabDataWorker& operator=(const DabDataWorker&) = delete;
+
+        // The thread is started with the first subchannel
+        void add(std::shared_ptr<DabData> dabData);
+        void remove(const std::shared_ptr<DabData>& dabData);
+
+        // New data was queued
+        void notify();
+
+    private:
+        void run();
+
+        std::mutex workerMutex;
+        std::condition_variable dataAvailable;
+        std::vector<std::shared_ptr<DabData> > handlers;
+        bool pending = false;
+        bool running = false;
+        std::thread thread;
+};
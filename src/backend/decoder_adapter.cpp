@@ -27,10 +27,25 @@
 #include <vector>
 #include "decoder_adapter.h"
 
-DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int16_t bitRate, AudioServiceComponentType &dabModus, const std::string &dumpFileName):
+static metrics::Counter& subchannel_counter(const char *name,
+        const char *help, const std::string& labels, int subChId)
+{
+    return metrics::registry().counter(name, help, metrics::join_labels(labels,
+                metrics::label("subchannel", std::to_string(subChId))));
+}
+
+DecoderAdapter::DecoderAdapter(ProgrammeHandlerInterface &mr, int subChId, int16_t bitRate, AudioServiceComponentType &dabModus, const std::string &dumpFileName, const std::string &metricsLabels):
     bitRate(bitRate),
     myInterface(mr),
-    padDecoder(this, true)
+    padDecoder(this, true),
+    rsCorrected(subchannel_counter("welle_subchannel_rs_corrected_bytes_total",
+                "Bytes corrected by the Reed-Solomon decoder", metricsLabels, subChId)),
+    rsUncorrected(subchannel_counter("welle_subchannel_rs_uncorrectable_total",
+                "Superframes with errors the Reed-Solomon decoder could not correct", metricsLabels, subChId)),
+    aacErrors(subchannel_counter("welle_subchannel_aac_errors_total",
+                "AAC access units that failed to decode", metricsLabels, subChId)),
+    frameErrors(subchannel_counter("welle_subchannel_frame_errors_total",
+                "Audio frames that were discarded", metricsLabels, subChId))
 {
     if (dabModus == AudioServiceComponentType::DAB)
         decoder = std::make_unique<MP2Decoder>(this, false);
@@ -128,15 +143,23 @@ void DecoderAdapter::AudioError(const std::string &hint)
 {
     (void)hint;
     frameErrorCounter++;
+    frameErrors.inc();
 }
 
 void DecoderAdapter::ACCFrameError(const unsigned char error)
 {
+    if (error) {
+        aacErrors.inc();
+    }
     myInterface.onAacErrors(error);
 }
 
 void DecoderAdapter::FECInfo(int total_corr_count, bool uncorr_errors)
 {
+    rsCorrected.inc(total_corr_count);
+    if (uncorr_errors) {
+        rsUncorrected.inc();
+    }
     myInterface.onRsErrors(uncorr_errors, total_corr_count);
 }
 
@@ -37,14 +37,17 @@
 #include "subchannel_sink.h"
 #include "dab_decoder.h"
 #include "dabplus_decoder.h"
+#include "various/metrics.h"
 
 class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public PADDecoderObserver
 {
     public:
         DecoderAdapter(ProgrammeHandlerInterface& mr,
+                     int subChId,
                      int16_t bitRate,
                      AudioServiceComponentType &dabModus,
-                     const std::string& dumpFileName);
+                     const std::string& dumpFileName,
+                     const std::string& metricsLabels = "");
 
         virtual void addtoFrame(uint8_t *v);
 
@@ -75,6 +78,12 @@ class DecoderAdapter: public DabProcessor, public SubchannelSinkObserver, public
         int audioSamplerate = 0;
         int audioChannels = 0;
         std::string audioFormat;
+
+        // Labelled with the subchannel
+        metrics::Counter& rsCorrected;
+        metrics::Counter& rsUncorrected;
+        metrics::Counter& aacErrors;
+        metrics::Counter& frameErrors;
 };
 #endif // DECODER_ADAPTER_H
 
@@ -34,6 +34,21 @@ EEPProtection::EEPProtection(int16_t bitRate, bool profile_is_eep_a, int level)
     outSize(24 * bitRate),
     viterbiBlock(outSize * 4 + 24)
 {
+    const auto p = puncturing(bitRate, profile_is_eep_a, level);
+    L1 = p.L1;
+    L2 = p.L2;
+    PI1 = p.PI1;
+    PI2 = p.PI2;
+}
+
+EEPProtection::Puncturing EEPProtection::puncturing(
+        int16_t bitRate, bool profile_is_eep_a, int level)
+{
+    int16_t L1;
+    int16_t L2;
+    const int8_t *PI1;
+    const int8_t *PI2;
+
     if (profile_is_eep_a) {
         switch (level) {
             case 1:
@@ -110,6 +125,13 @@ EEPProtection::EEPProtection(int16_t bitRate, bool profile_is_eep_a, int level)
                 throw std::logic_error("Invalid EEP_A level");
         }
     }
+
+    Puncturing p;
+    p.L1 = L1;
+    p.L2 = L2;
+    p.PI1 = PI1;
+    p.PI2 = PI2;
+    return p;
 }
 
 bool EEPProtection::deconvolve(const softbit_t *v, int32_t size, uint8_t *outBuffer)
@@ -32,6 +32,17 @@ class EEPProtection: public Protection, public Viterbi {
     public:
         EEPProtection(int16_t bitRate, bool profile_is_eep_a, int level);
         bool deconvolve(const softbit_t *v, int32_t size, uint8_t *outBuffer);
+
+        // The (L1, PI1), (L2, PI2) puncturing of a logical frame, also
+        // needed to encode one.
+        struct Puncturing {
+            int16_t L1;
+            int16_t L2;
+            const int8_t *PI1;
+            const int8_t *PI2;
+        };
+        static Puncturing puncturing(int16_t bitRate, bool profile_is_eep_a, int level);
+
     private:
         int16_t L1;
         int16_t L2;
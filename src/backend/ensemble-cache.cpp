@@ -0,0 +1,307 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ensemble-cache.h"
+#include "libs/json.hpp"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using json = nlohmann::json;
+
+// Increment when the meaning of the fields changes, older files are ignored
+static const int CACHE_VERSION = 1;
+
+// The labels are kept in their character set, which is not always UTF-8
+static string to_hex(const string& bytes)
+{
+    static const char digits[] = "0123456789abcdef";
+    string hex;
+    for (const unsigned char c : bytes) {
+        hex += digits[c >> 4];
+        hex += digits[c & 0x0F];
+    }
+    return hex;
+}
+
+static string from_hex(const string& hex)
+{
+    string bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes += (char)stoi(hex.substr(i, 2), nullptr, 16);
+    }
+    return bytes;
+}
+
+static json label_to_json(const DabLabel& label)
+{
+    return {
+        {"charset", (int)label.charset},
+        {"label", to_hex(label.fig1_label)},
+        {"flag", label.fig1_flag},
+    };
+}
+
+static DabLabel label_from_json(const json& j)
+{
+    DabLabel label;
+    label.charset = (CharacterSet)j.at("charset").get<int>();
+    label.fig1_label = from_hex(j.at("label").get<string>());
+    label.fig1_flag = j.at("flag").get<uint16_t>();
+    return label;
+}
+
+EnsembleCache::EnsembleCache(const string& directory) :
+    directory(directory)
+{
+}
+
+string EnsembleCache::path(const string& channel, const string& suffix) const
+{
+    // Channel names are short and harmless, but they become file names
+    string name;
+    for (const char c : channel) {
+        name += isalnum((unsigned char)c) ? c : '_';
+    }
+    return directory + "/" + name + suffix;
+}
+
+static bool read_file(const string& path, string& text)
+{
+    ifstream f(path);
+    if (not f) {
+        return false;
+    }
+
+    stringstream ss;
+    ss << f.rdbuf();
+    text = ss.str();
+    return true;
+}
+
+// Write to a temporary file first, so that readers never see a partial file
+static bool write_file(const string& path, const string& text)
+{
+    const string tmp = path + ".tmp";
+    {
+        ofstream f(tmp);
+        f << text;
+        if (not f) {
+            return false;
+        }
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static string eid_suffix(uint16_t ensembleId)
+{
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "_%04X.json", ensembleId);
+    return suffix;
+}
+
+shared_ptr<EnsembleSnapshot> EnsembleCache::load(const string& channel) const
+{
+    string last;
+    if (not read_file(path(channel, ".last"), last)) {
+        return nullptr;
+    }
+
+    try {
+        return load(channel, stoi(last, nullptr, 16));
+    }
+    catch (const exception&) {
+        return nullptr;
+    }
+}
+
+shared_ptr<EnsembleSnapshot> EnsembleCache::load(const string& channel,
+        uint16_t ensembleId) const
+{
+    string text;
+    if (not read_file(path(channel, eid_suffix(ensembleId)), text)) {
+        return nullptr;
+    }
+
+    auto e = fromJson(text);
+    if (e and e->ensembleId != ensembleId) {
+        return nullptr;
+    }
+    return e;
+}
+
+bool EnsembleCache::save(const string& channel, const EnsembleSnapshot& ensemble) const
+{
+    if (ensemble.provisional or ensemble.ensembleId == 0 or
+            ensemble.services.empty()) {
+        return false;
+    }
+
+    char last[8];
+    snprintf(last, sizeof(last), "%04X\n", ensemble.ensembleId);
+    return write_file(path(channel, eid_suffix(ensemble.ensembleId)), toJson(ensemble)) and
+        write_file(path(channel, ".last"), last);
+}
+
+string EnsembleCache::toJson(const EnsembleSnapshot& e)
+{
+    json services = json::array();
+    for (const auto& s : e.services) {
+        services.push_back({
+                {"sid", s.serviceId},
+                {"label", label_to_json(s.serviceLabel)},
+                {"language", s.language},
+                {"pty", s.programType},
+            });
+    }
+
+    json components = json::array();
+    for (const auto& c : e.components) {
+        components.push_back({
+                {"sid", c.SId},
+                {"tmid", c.TMid},
+                {"nr", c.componentNr},
+                {"label", label_to_json(c.componentLabel)},
+                {"ascty", c.ASCTy},
+                {"ps", c.PS_flag},
+                {"subchannel", c.subchannelId},
+                {"scid", c.SCId},
+                {"ca", c.CAflag},
+                {"dscty", c.DSCTy},
+                {"dg", c.DGflag},
+                {"packet_address", c.packetAddress},
+            });
+    }
+
+    json subchannels = json::array();
+    for (const auto& sub : e.subChannels) {
+        if (not sub.valid()) {
+            continue;
+        }
+        const auto& ps = sub.protectionSettings;
+        subchannels.push_back({
+                {"id", sub.subChId},
+                {"start", sub.startAddr},
+                {"length", sub.length},
+                {"programme", sub.programmeNotData},
+                {"short_form", ps.shortForm},
+                {"uep_index", ps.uepTableIndex},
+                {"uep_level", ps.uepLevel},
+                {"eep_profile", (int)ps.eepProfile},
+                {"eep_level", (int)ps.eepLevel},
+                {"language", sub.language},
+                {"fec", sub.fecScheme},
+            });
+    }
+
+    const json j = {
+        {"version", CACHE_VERSION},
+        {"eid", e.ensembleId},
+        {"ecc", e.ensembleEcc},
+        {"label", label_to_json(e.ensembleLabel)},
+        {"services", services},
+        {"components", components},
+        {"subchannels", subchannels},
+    };
+    return j.dump(1);
+}
+
+shared_ptr<EnsembleSnapshot> EnsembleCache::fromJson(const string& text)
+{
+    auto e = make_shared<EnsembleSnapshot>();
+    try {
+        const json j = json::parse(text);
+        if (j.at("version").get<int>() != CACHE_VERSION) {
+            return nullptr;
+        }
+
+        e->ensembleId = j.at("eid").get<uint16_t>();
+        e->ensembleEcc = j.at("ecc").get<uint8_t>();
+        e->ensembleLabel = label_from_json(j.at("label"));
+
+        for (const auto& js : j.at("services")) {
+            Service s(js.at("sid").get<uint32_t>());
+            s.serviceLabel = label_from_json(js.at("label"));
+            s.language = js.at("language").get<int16_t>();
+            s.programType = js.at("pty").get<int16_t>();
+            e->serviceIndex[s.serviceId] = e->services.size();
+            e->services.push_back(s);
+        }
+
+        for (const auto& jc : j.at("components")) {
+            ServiceComponent c;
+            c.SId = jc.at("sid").get<uint32_t>();
+            c.TMid = jc.at("tmid").get<int8_t>();
+            c.componentNr = jc.at("nr").get<int16_t>();
+            c.componentLabel = label_from_json(jc.at("label"));
+            c.ASCTy = jc.at("ascty").get<int16_t>();
+            c.PS_flag = jc.at("ps").get<int16_t>();
+            c.subchannelId = jc.at("subchannel").get<int16_t>();
+            c.SCId = jc.at("scid").get<uint16_t>();
+            c.CAflag = jc.at("ca").get<uint8_t>();
+            c.DSCTy = jc.at("dscty").get<int16_t>();
+            c.DGflag = jc.at("dg").get<uint8_t>();
+            c.packetAddress = jc.at("packet_address").get<int16_t>();
+            if (e->serviceIndex.count(c.SId) == 0) {
+                return nullptr;
+            }
+            e->serviceComponents[c.SId].push_back(e->components.size());
+            e->components.push_back(c);
+        }
+
+        e->subChannels.resize(64);
+        for (const auto& jsub : j.at("subchannels")) {
+            Subchannel sub;
+            sub.subChId = jsub.at("id").get<int32_t>();
+            if (sub.subChId < 0 or sub.subChId >= 64) {
+                return nullptr;
+            }
+            sub.startAddr = jsub.at("start").get<int32_t>();
+            sub.length = jsub.at("length").get<int32_t>();
+            sub.programmeNotData = jsub.at("programme").get<bool>();
+            auto& ps = sub.protectionSettings;
+            ps.shortForm = jsub.at("short_form").get<bool>();
+            ps.uepTableIndex = jsub.at("uep_index").get<int16_t>();
+            ps.uepLevel = jsub.at("uep_level").get<int16_t>();
+            ps.eepProfile = (EEPProtectionProfile)jsub.at("eep_profile").get<int>();
+            ps.eepLevel = (EEPProtectionLevel)jsub.at("eep_level").get<int>();
+            sub.language = jsub.at("language").get<int16_t>();
+            sub.fecScheme = jsub.at("fec").get<int16_t>();
+            if (ps.uepTableIndex < 0 or ps.uepTableIndex >= 64) {
+                return nullptr;
+            }
+            e->subChannels[sub.subChId] = sub;
+        }
+    }
+    catch (const exception&) {
+        // Not JSON, or a field missing or of the wrong type
+        return nullptr;
+    }
+
+    e->provisional = true;
+    return e;
+}
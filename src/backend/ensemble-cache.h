@@ -0,0 +1,63 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "fib-processor.h"
+
+/* Keeps the organisation of the ensembles received on each channel on
+ * disk, so that after tuning the service list, the labels and the
+ * subchannels are known before the FIGs are received again, see
+ * FIBProcessor::setProvisionalEnsemble.
+ *
+ * There is one JSON file per channel and EId in the directory, and per
+ * channel a file naming the EId received last. */
+class EnsembleCache {
+    public:
+        // The directory must exist
+        explicit EnsembleCache(const std::string& directory);
+
+        // The ensemble received last on the channel, marked provisional.
+        // nullptr if there is none or the file is damaged.
+        std::shared_ptr<EnsembleSnapshot> load(const std::string& channel) const;
+        std::shared_ptr<EnsembleSnapshot> load(const std::string& channel,
+                uint16_t ensembleId) const;
+
+        // Provisional and empty ensembles are not saved, for them and
+        // on errors, it returns false.
+        bool save(const std::string& channel, const EnsembleSnapshot& ensemble) const;
+
+        static std::string toJson(const EnsembleSnapshot& ensemble);
+        // Returns nullptr if the text is not a cached ensemble
+        static std::shared_ptr<EnsembleSnapshot> fromJson(const std::string& text);
+
+    private:
+        std::string path(const std::string& channel, const std::string& suffix) const;
+
+        const std::string directory;
+};
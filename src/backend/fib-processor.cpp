@@ -31,9 +31,46 @@
 #include "fib-processor.h"
 #include "charsets.h"
 #include "MathHelper.h"
+#include <unordered_set>
 
-FIBProcessor::FIBProcessor(RadioControllerInterface& mr) :
-    myRadioInterface(mr)
+// Assigns value to field, and tells if that changed anything
+template<typename T>
+static bool update(T& field, const T& value)
+{
+    if (field == value) {
+        return false;
+    }
+    field = value;
+    return true;
+}
+
+static bool update_fig1_label(DabLabel& l, const char *label,
+        uint16_t flag, uint8_t charset)
+{
+    const auto previous_charset = l.charset;
+    l.setCharset(charset);
+    bool changed = l.charset != previous_charset;
+    changed |= update(l.fig1_flag, flag);
+    if (l.fig1_label != label) {
+        l.fig1_label = label;
+        changed = true;
+    }
+    return changed;
+}
+
+static uint64_t component_key(uint32_t SId, int16_t SCIdS)
+{
+    return ((uint64_t)SId << 16) | (uint16_t)SCIdS;
+}
+
+constexpr size_t FIBProcessor::FIG_CACHE_SIZE;
+constexpr size_t FIBProcessor::FIG_CACHE_WAYS;
+
+FIBProcessor::FIBProcessor(RadioControllerInterface& mr,
+        const std::string& metricsLabels) :
+    myRadioInterface(mr),
+    figCache(FIG_CACHE_SIZE),
+    metricsLabels(metricsLabels)
 {
     clearEnsemble();
 }
@@ -51,6 +88,17 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
     (void)fib;
     while (processedBytes  < 30) {
         const uint8_t FIGtype = getBits_3 (d, 0);
+        if (isRepeatedFig(d, processedBytes)) {
+            processedBytes += getBits_5 (d, 3) + 1;
+            d = p + processedBytes * 8;
+            continue;
+        }
+
+        // A FIG that changes the ensemble may change the meaning of
+        // other FIGs, e.g. labels of services that were unknown before.
+        const bool changedBefore = ensembleChanged;
+        ensembleChanged = false;
+
         switch (FIGtype) {
             case 0:
                 process_FIG0(d);
@@ -65,18 +113,150 @@ void FIBProcessor::processFIB(uint8_t *p, uint16_t fib)
                 break;
 
             case 7:
+                ensembleChanged |= changedBefore;
                 return;
 
             default:
                 //std::clog << "FIG%d present" << FIGtype << std::endl;
                 break;
         }
+
+        if (ensembleChanged) {
+            invalidateFigCache();
+        }
+        ensembleChanged |= changedBefore;
+
         //  Thanks to Ronny Kunze, who discovered that I used
         //  a p rather than a d
         processedBytes += getBits_5 (d, 3) + 1;
         d = p + processedBytes * 8;
     }
 }
+
+// Same as getBits_8(d, 0)
+static inline uint64_t pack_bits(const uint8_t *d)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // Moves bit i of the eight bytes to bit 63 - i, all at once
+    uint64_t x;
+    std::memcpy(&x, d, sizeof(x));
+    return (x * 0x8040201008040201ULL) >> 56;
+#else
+    return getBits_8(d, 0);
+#endif
+}
+
+bool FIBProcessor::isRepeatedFig(uint8_t *d, int16_t processedBytes)
+{
+    const uint8_t type = getBits_3(d, 0);
+    const size_t length = getBits_5(d, 3) + 1;
+    if (type > 2 or length < 2 or processedBytes + length > 30) {
+        return false;
+    }
+
+    const uint8_t extension = type == 0 ? getBits_5(d, 8 + 3) : getBits_3(d, 8 + 5);
+
+    // The CIF counter in FIG 0/0 and the time in FIG 0/10 change all
+    // the time. The announcement state of FIG 0/18 and 0/19 is not part
+    // of the ensemble, and every FIG 0/19 refreshes it.
+    if (type == 0 and (extension == 0 or extension == 10 or
+                extension == 18 or extension == 19)) {
+        return false;
+    }
+
+    // The FIG bytes, eight per word, followed by zeros
+    std::array<uint64_t, 4> words{};
+    uint64_t hash = length;
+    for (size_t i = 0; i < length; i++) {
+        words[i / 8] |= pack_bits(d + 8 * i) << (56 - 8 * (i % 8));
+    }
+    for (const uint64_t w : words) {
+        hash = (hash ^ w) * 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 32;
+    }
+
+    // Look at FIG_CACHE_WAYS neighbouring entries, otherwise two FIGs
+    // of the carousel that collide would never be recognised.
+    FigCacheEntry *entry = nullptr;
+    bool hit = false;
+    for (size_t way = 0; way < FIG_CACHE_WAYS; way++) {
+        auto& e = figCache[(hash + way) % FIG_CACHE_SIZE];
+        if (e.generation != figCacheGeneration) {
+            if (entry == nullptr) {
+                entry = &e;
+            }
+        }
+        else if (e.length == length and e.words == words) {
+            entry = &e;
+            hit = true;
+            break;
+        }
+    }
+
+    if (entry == nullptr) {
+        // All ways are taken, replace one of them
+        entry = &figCache[(hash + (hash >> 48) % FIG_CACHE_WAYS) % FIG_CACHE_SIZE];
+    }
+
+    if (hit and type == 0 and extension == 2) {
+        // Keep the services alive
+        hit = countRepeatedFIG0Extension2(d);
+    }
+
+    if (not hit) {
+        entry->generation = figCacheGeneration;
+        entry->length = length;
+        entry->words = words;
+    }
+
+    countFig(type, extension, hit);
+    return hit;
+}
+
+void FIBProcessor::invalidateFigCache()
+{
+    figCacheGeneration++;
+}
+
+void FIBProcessor::countFig(uint8_t type, uint8_t extension, bool hit)
+{
+    auto& c = figCacheCounters[type * 32 + extension];
+    if (c.hitMetric == nullptr) {
+        const std::string labels = metrics::join_labels(metricsLabels,
+            metrics::label("fig", std::to_string(type) + "/" + std::to_string(extension)));
+        c.hitMetric = &metrics::registry().counter("welle_fig_cache_total",
+                "FIGs received, by whether they were repeated and not parsed",
+                labels + "," + metrics::label("result", "hit"));
+        c.missMetric = &metrics::registry().counter("welle_fig_cache_total",
+                "FIGs received, by whether they were repeated and not parsed",
+                labels + "," + metrics::label("result", "miss"));
+    }
+
+    if (hit) {
+        c.hits++;
+        c.hitMetric->inc();
+    }
+    else {
+        c.misses++;
+        c.missMetric->inc();
+    }
+}
+
+std::map<std::string, FIBProcessor::FigCacheStats> FIBProcessor::getFigCacheStats() const
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::map<std::string, FigCacheStats> stats;
+    for (size_t i = 0; i < figCacheCounters.size(); i++) {
+        FigCacheStats s;
+        s.hits = figCacheCounters[i].hits;
+        s.misses = figCacheCounters[i].misses;
+        if (s.hits or s.misses) {
+            stats[std::to_string(i / 32) + "/" + std::to_string(i % 32)] = s;
+        }
+    }
+    return stats;
+}
+
 //
 //  Handle ensemble is all through FIG0
 //
@@ -122,7 +302,12 @@ void FIBProcessor::FIG0Extension0 (uint8_t *d)
     uint16_t eId  = getBits(d, 16, 16);
 
     if (ensembleId != eId) {
+        if (not provisionalServices.empty()) {
+            // Another ensemble than last time on this channel
+            dropProvisionalEnsemble();
+        }
         ensembleId = eId;
+        ensembleChanged = true;
         myRadioInterface.onNewEnsemble(ensembleId);
     }
 
@@ -202,28 +387,29 @@ int16_t FIBProcessor::HandleFIG0Extension1(
     int16_t bitOffset = offset * 8;
     const int16_t subChId   = getBits_6 (d, bitOffset);
     const int16_t startAdr  = getBits(d, bitOffset + 6, 10);
-    subChannels[subChId].programmeNotData = pd;
-    subChannels[subChId].subChId = subChId;
-    subChannels[subChId].startAddr = startAdr;
+    auto& sub = subChannels[subChId];
+    bool changed = update<bool>(sub.programmeNotData, pd);
+    changed |= update<int32_t>(sub.subChId, subChId);
+    changed |= update<int32_t>(sub.startAddr, startAdr);
     if (getBits_1 (d, bitOffset + 16) == 0) {   // UEP, short form
         int16_t tableIx = getBits_6 (d, bitOffset + 18);
-        auto& ps = subChannels[subChId].protectionSettings;
-        ps.uepTableIndex = tableIx;
-        ps.shortForm = true;
-        ps.uepLevel = ProtLevel[tableIx][1];
+        auto& ps = sub.protectionSettings;
+        changed |= update<int16_t>(ps.uepTableIndex, tableIx);
+        changed |= update(ps.shortForm, true);
+        changed |= update<int16_t>(ps.uepLevel, ProtLevel[tableIx][1]);
 
-        subChannels[subChId].length = ProtLevel[tableIx][0];
+        changed |= update<int32_t>(sub.length, ProtLevel[tableIx][0]);
         bitOffset += 24;
     }
     else {  // EEP, long form
-        auto& ps = subChannels[subChId].protectionSettings;
-        ps.shortForm  = false;
+        auto& ps = sub.protectionSettings;
+        changed |= update(ps.shortForm, false);
         int16_t option = getBits_3(d, bitOffset + 17);
         if (option == 0) {
-            ps.eepProfile = EEPProtectionProfile::EEP_A;
+            changed |= update(ps.eepProfile, EEPProtectionProfile::EEP_A);
         }
         else if (option == 1) {
-            ps.eepProfile = EEPProtectionProfile::EEP_B;
+            changed |= update(ps.eepProfile, EEPProtectionProfile::EEP_B);
         }
 
         if (option == 0 or   // EEP-A protection
@@ -231,16 +417,16 @@ int16_t FIBProcessor::HandleFIG0Extension1(
             int16_t protLevel = getBits_2(d, bitOffset + 20);
             switch (protLevel) {
                 case 0:
-                    ps.eepLevel = EEPProtectionLevel::EEP_1;
+                    changed |= update(ps.eepLevel, EEPProtectionLevel::EEP_1);
                     break;
                 case 1:
-                    ps.eepLevel = EEPProtectionLevel::EEP_2;
+                    changed |= update(ps.eepLevel, EEPProtectionLevel::EEP_2);
                     break;
                 case 2:
-                    ps.eepLevel = EEPProtectionLevel::EEP_3;
+                    changed |= update(ps.eepLevel, EEPProtectionLevel::EEP_3);
                     break;
                 case 3:
-                    ps.eepLevel = EEPProtectionLevel::EEP_4;
+                    changed |= update(ps.eepLevel, EEPProtectionLevel::EEP_4);
                     break;
                 default:
                     std::clog << "Warning, FIG0/1 for " << subChId <<
@@ -250,7 +436,7 @@ int16_t FIBProcessor::HandleFIG0Extension1(
             }
 
             int16_t subChanSize = getBits(d, bitOffset + 22, 10);
-            subChannels[subChId].length = subChanSize;
+            changed |= update<int32_t>(sub.length, subChanSize);
         }
         else {
             std::clog << "Warning, FIG0/1 for " << subChId <<
@@ -260,6 +446,13 @@ int16_t FIBProcessor::HandleFIG0Extension1(
         bitOffset += 32;
     }
 
+    if (provisionalSubchannels[subChId]) {
+        // Received as it was cached, or the decoders need to be restarted
+        provisionalSubchannels.reset(subChId);
+        restartNeeded |= changed;
+    }
+
+    ensembleChanged |= changed;
     return bitOffset / 8;   // we return bytes
 }
 
@@ -270,40 +463,14 @@ void FIBProcessor::FIG0Extension2 (uint8_t *d)
     uint8_t PD_bit  = getBits_1 (d, 8 + 2);
     uint8_t CN      = getBits_1 (d, 8 + 0);
 
+    ageServices();
     while (used < Length) {
         used = HandleFIG0Extension2(d, used, CN, PD_bit);
     }
 }
 
-//  Note Offset is in bytes
-//  With FIG0/2 we bind the channels to Service Ids
-int16_t FIBProcessor::HandleFIG0Extension2(
-        uint8_t *d,
-        int16_t offset,
-        uint8_t cn,
-        uint8_t pd)
+void FIBProcessor::ageServices()
 {
-    (void)cn;
-    int16_t     lOffset = 8 * offset;
-    int16_t     i;
-    uint8_t     ecc;
-    uint8_t     cId;
-    uint32_t    SId;
-    int16_t     numberofComponents;
-
-    if (pd == 1) {      // long Sid
-        ecc = getBits_8(d, lOffset);   (void)ecc;
-        cId = getBits_4(d, lOffset + 1);
-        SId = getBits(d, lOffset, 32);
-        lOffset += 32;
-    }
-    else {
-        cId = getBits_4(d, lOffset);   (void)cId;
-        SId = getBits(d, lOffset + 4, 12);
-        SId = getBits(d, lOffset, 16);
-        lOffset += 16;
-    }
-
     // Keep track how often we see a service using a saturating counter.
     // Every time a service is signalled, we increment the counter.
     // If the counter is >= 2, we consider the service. Every second, we
@@ -320,7 +487,7 @@ int16_t FIBProcessor::HandleFIG0Extension2(
                 ++it;
             }
             else if (it->second == 0) {
-                dropService(it->second);
+                dropService(it->first);
                 it = serviceRepeatCount.erase(it);
             }
             else {
@@ -339,13 +506,91 @@ int16_t FIBProcessor::HandleFIG0Extension2(
         std::cerr << ss.str() << std::endl;
 #endif
     }
+}
+
+void FIBProcessor::countService(uint32_t SId)
+{
+    auto& count = serviceRepeatCount[SId];
+    if (count < 4) {
+        count++;
+    }
+}
+
+// Counts the services of a FIG 0/2 that was not parsed because it is a
+// repeat. Returns false if the FIG has to be parsed anyway, because it
+// would make a service appear.
+bool FIBProcessor::countRepeatedFIG0Extension2(uint8_t *d)
+{
+    const int16_t Length = getBits_5(d, 3);
+    const uint8_t PD_bit = getBits_1(d, 8 + 2);
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            ageServices();
+        }
+
+        int16_t used = 2;
+        while (used < Length) {
+            const int16_t lOffset = 8 * used;
+            const uint32_t SId = PD_bit ?
+                getBits(d, lOffset, 32) : getBits(d, lOffset, 16);
+            const int16_t sidLength = PD_bit ? 4 : 2;
+            const int16_t numberofComponents =
+                getBits_4(d, lOffset + 8 * sidLength + 4);
+
+            if (pass == 0) {
+                if (findServiceId(SId) == nullptr) {
+                    const auto it = serviceRepeatCount.find(SId);
+                    if (it != serviceRepeatCount.end() and it->second >= 1) {
+                        return false;
+                    }
+                }
+            }
+            else {
+                countService(SId);
+            }
+
+            used += sidLength + 1 + 2 * numberofComponents;
+        }
+    }
+    return true;
+}
+
+//  Note Offset is in bytes
+//  With FIG0/2 we bind the channels to Service Ids
+int16_t FIBProcessor::HandleFIG0Extension2(
+        uint8_t *d,
+        int16_t offset,
+        uint8_t cn,
+        uint8_t pd)
+{
+    (void)cn;
+    int16_t     lOffset = 8 * offset;
+    int16_t     i;
+    uint8_t     ecc;
+    uint8_t     cId;
+    uint32_t    SId;
+    int16_t     numberofComponents;
 
-    if (serviceRepeatCount[SId] < 4) {
-        serviceRepeatCount[SId]++;
+    if (pd == 1) {      // long Sid
+        ecc = getBits_8(d, lOffset);   (void)ecc;
+        cId = getBits_4(d, lOffset + 1);
+        SId = getBits(d, lOffset, 32);
+        lOffset += 32;
+    }
+    else {
+        cId = getBits_4(d, lOffset);   (void)cId;
+        SId = getBits(d, lOffset + 4, 12);
+        SId = getBits(d, lOffset, 16);
+        lOffset += 16;
     }
 
+    countService(SId);
+
     if (findServiceId(SId) == nullptr and serviceRepeatCount[SId] >= 2) {
+        serviceIndex[SId] = services.size();
         services.emplace_back(SId);
+        ensembleChanged = true;
         myRadioInterface.onServiceDetected(SId);
     }
 
@@ -377,6 +622,21 @@ int16_t FIBProcessor::HandleFIG0Extension2(
         }
         lOffset += 16;
     }
+
+    if (provisionalServices.count(SId)) {
+        const auto n = components.size();
+        components.erase(std::remove_if(components.begin(), components.end(),
+                    [&](const ServiceComponent& c) {
+                        return c.SId == SId and c.componentNr >= numberofComponents;
+                    }
+                    ), components.end());
+        if (components.size() != n) {
+            rebuildIndices();
+            ensembleChanged = true;
+            restartNeeded = true;
+        }
+        settleProvisionalService(SId);
+    }
     return lOffset / 8;     // in Bytes
 }
 
@@ -409,10 +669,11 @@ int16_t FIBProcessor::HandleFIG0Extension3(uint8_t *d, int16_t used)
 
     used += 56 / 8;
     if (packetComp) {
-        packetComp->subchannelId = SubChId;
-        packetComp->DSCTy = DSCTy;
-        packetComp->DGflag = DGflag;
-        packetComp->packetAddress = packetAddress;
+        bool changed = update(packetComp->subchannelId, SubChId);
+        changed |= update(packetComp->DSCTy, DSCTy);
+        changed |= update<uint8_t>(packetComp->DGflag, DGflag);
+        changed |= update(packetComp->packetAddress, packetAddress);
+        ensembleChanged |= changed;
     }
     return used;
 }
@@ -437,7 +698,7 @@ int16_t FIBProcessor::HandleFIG0Extension5(uint8_t* d, int16_t offset)
         if (getBits_1 (d, loffset + 1) == 0) {
             subChId = getBits_6 (d, loffset + 2);
             language = getBits_8 (d, loffset + 8);
-            subChannels[subChId].language = language;
+            ensembleChanged |= update(subChannels[subChId].language, language);
         }
         loffset += 16;
     }
@@ -510,7 +771,7 @@ void FIBProcessor::FIG0Extension9(uint8_t *d)
     dateTime.minuteOffset = (getBits_1 (d, offset + 7) == 1) ? 30 : 0;
     timeOffsetReceived = true;
 
-    ensembleEcc = getBits(d, offset + 8, 8);
+    ensembleChanged |= update<uint8_t>(ensembleEcc, getBits(d, offset + 8, 8));
 }
 
 void FIBProcessor::FIG0Extension10(uint8_t *fig)
@@ -640,10 +901,9 @@ void FIBProcessor::FIG0Extension14 (uint8_t *d)
         uint8_t fecScheme = getBits_2 (d, used * 8 + 6);
         used = used + 1;
 
-        for (int i = 0; i < 64; i++) {
-            if (subChannels[i].subChId == subChId) {
-                subChannels[i].fecScheme = fecScheme;
-            }
+        auto& sub = subChannels[subChId];
+        if (sub.subChId == subChId) {
+            ensembleChanged |= update<int16_t>(sub.fecScheme, fecScheme);
         }
 
     }
@@ -665,14 +925,14 @@ void FIBProcessor::FIG0Extension17(uint8_t *d)
         if (L_flag) {       // language field present
             Language = getBits_8 (d, offset + 24);
             if (s) {
-                s->language = Language;
+                ensembleChanged |= update(s->language, Language);
             }
             offset += 8;
         }
 
         type = getBits_5 (d, offset + 27);
         if (s) {
-            s->programType = type;
+            ensembleChanged |= update(s->programType, type);
         }
         if (CC_flag) {          // cc flag
             offset += 40;
@@ -958,9 +1218,8 @@ void FIBProcessor::process_FIG1(uint8_t *d)
                 }
                 // std::clog << "fib-processor:" << "Ensemblename: " << label << std::endl;
                 if (!oe and EId == ensembleId) {
-                    ensembleLabel.fig1_flag = getBits(d, offset, 16);
-                    ensembleLabel.fig1_label = label;
-                    ensembleLabel.setCharset(charSet);
+                    ensembleChanged |= update_fig1_label(ensembleLabel, label,
+                            getBits(d, offset, 16), charSet);
                     myRadioInterface.onSetEnsembleLabel(ensembleLabel);
                 }
                 break;
@@ -975,9 +1234,8 @@ void FIBProcessor::process_FIG1(uint8_t *d)
                     label[i] = getBits_8(d, offset);
                     offset += 8;
                 }
-                service->serviceLabel.fig1_flag = getBits(d, offset, 16);
-                service->serviceLabel.fig1_label = label;
-                service->serviceLabel.setCharset(charSet);
+                ensembleChanged |= update_fig1_label(service->serviceLabel,
+                        label, getBits(d, offset, 16), charSet);
                 // std::clog << "fib-processor:" << "FIG1/1: SId = %4x\t%s\n", SId, label) << std::endl;
             }
             break;
@@ -1013,9 +1271,8 @@ void FIBProcessor::process_FIG1(uint8_t *d)
 
             component = findComponent(SId, SCidS);
             if (component) {
-                component->componentLabel.fig1_flag = getBits(d, offset, 16);
-                component->componentLabel.setCharset(charSet);
-                component->componentLabel.fig1_label = label;
+                ensembleChanged |= update_fig1_label(component->componentLabel,
+                        label, getBits(d, offset, 16), charSet);
             }
             //        std::clog << "fib-processor:" << "FIG1/4: Sid = %8x\tp/d=%d\tSCidS=%1X\tflag=%8X\t%s\n",
             //                          SId, pd_flag, SCidS, flagfield, label) << std::endl;
@@ -1031,9 +1288,8 @@ void FIBProcessor::process_FIG1(uint8_t *d)
                     label[i] = getBits_8(d, offset);
                     offset += 8;
                 }
-                service->serviceLabel.fig1_flag = getBits(d, offset, 16);
-                service->serviceLabel.fig1_label = label;
-                service->serviceLabel.setCharset(charSet);
+                ensembleChanged |= update_fig1_label(service->serviceLabel,
+                        label, getBits(d, offset, 16), charSet);
 
 #ifdef  MSC_DATA__
                 myRadioInterface.onServiceDetected(SId);
@@ -1186,6 +1442,7 @@ void FIBProcessor::process_FIG2(uint8_t *d)
                 else if (eid == ensembleId) {
                     handle_ext_label_data_field(figdata, data_len_bytes,
                             toggle_flag, segment_index, rfu, ensembleLabel);
+                    ensembleChanged = true;
                 }
             }
             break;
@@ -1201,6 +1458,7 @@ void FIBProcessor::process_FIG2(uint8_t *d)
                     if (service) {
                         handle_ext_label_data_field(figdata, data_len_bytes,
                                 toggle_flag, segment_index, rfu, service->serviceLabel);
+                        ensembleChanged = true;
                     }
                 }
             }
@@ -1229,6 +1487,7 @@ void FIBProcessor::process_FIG2(uint8_t *d)
                     if (component) {
                         handle_ext_label_data_field(figdata, data_len_bytes,
                                 toggle_flag, segment_index, rfu, component->componentLabel);
+                        ensembleChanged = true;
                     }
                 }
             }
@@ -1250,6 +1509,7 @@ void FIBProcessor::process_FIG2(uint8_t *d)
                     if (service) {
                         handle_ext_label_data_field(figdata, data_len_bytes,
                                 toggle_flag, segment_index, rfu, service->serviceLabel);
+                        ensembleChanged = true;
                     }
                 }
             }
@@ -1260,45 +1520,94 @@ void FIBProcessor::process_FIG2(uint8_t *d)
 // locate a reference to the entry for the Service serviceId
 Service *FIBProcessor::findServiceId(uint32_t serviceId)
 {
-    for (size_t i = 0; i < services.size(); i++) {
-        if (services[i].serviceId == serviceId) {
-            return &services[i];
-        }
+    const auto it = serviceIndex.find(serviceId);
+    if (it == serviceIndex.end()) {
+        return nullptr;
     }
-
-    return nullptr;
+    return &services[it->second];
 }
 
 ServiceComponent *FIBProcessor::findComponent(uint32_t serviceId, int16_t SCIdS)
 {
-    auto comp = std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == serviceId && sc.componentNr == SCIdS;
-                });
+    const auto it = componentIndex.find(component_key(serviceId, SCIdS));
+    if (it == componentIndex.end()) {
+        return nullptr;
+    }
+    return &components[it->second];
+}
 
-    if (comp == components.end()) {
+ServiceComponent *FIBProcessor::findPacketComponent(int16_t SCId)
+{
+    const auto it = packetComponentIndex.find(SCId);
+    if (it == packetComponentIndex.end()) {
         return nullptr;
     }
-    else {
-        return &(*comp);
+    return &components[it->second];
+}
+
+void FIBProcessor::addComponent(const ServiceComponent& component)
+{
+    const size_t index = components.size();
+    components.push_back(component);
+    componentIndex[component_key(component.SId, component.componentNr)] = index;
+    if (component.TMid == 03) {
+        // The first component with a given SCId wins
+        packetComponentIndex.emplace(component.SCId, index);
     }
+    ensembleChanged = true;
 }
 
-ServiceComponent *FIBProcessor::findPacketComponent(int16_t SCId)
+void FIBProcessor::rebuildIndices()
 {
-    for (auto& component : components) {
-        if (component.TMid != 03) {
-            continue;
-        }
-        if (component.SCId == SCId) {
-            return &component;
+    serviceIndex.clear();
+    for (size_t i = 0; i < services.size(); i++) {
+        serviceIndex[services[i].serviceId] = i;
+    }
+
+    componentIndex.clear();
+    packetComponentIndex.clear();
+    for (size_t i = 0; i < components.size(); i++) {
+        const auto& c = components[i];
+        componentIndex[component_key(c.SId, c.componentNr)] = i;
+        if (c.TMid == 03) {
+            packetComponentIndex.emplace(c.SCId, i);
         }
     }
-    return nullptr;
 }
 
 //  bindAudioService is the main processor for - what the name suggests -
 //  connecting the description of audioservices to a SID
+// Adds the component, or reconciles it with a cached one
+void FIBProcessor::bindComponent(const ServiceComponent& newcomp)
+{
+    auto *c = findComponent(newcomp.SId, newcomp.componentNr);
+    if (c == nullptr) {
+        addComponent(newcomp);
+    }
+    else if (provisionalServices.count(newcomp.SId)) {
+        bool same = c->TMid == newcomp.TMid and c->PS_flag == newcomp.PS_flag;
+        if (newcomp.TMid == 0) {
+            same &= c->subchannelId == newcomp.subchannelId and c->ASCTy == newcomp.ASCTy;
+        }
+        else if (newcomp.TMid == 1) {
+            same &= c->subchannelId == newcomp.subchannelId and c->DSCTy == newcomp.DSCTy;
+        }
+        else if (newcomp.TMid == 3) {
+            // The subchannel comes with FIG 0/3
+            same &= c->SCId == newcomp.SCId and c->CAflag == newcomp.CAflag;
+        }
+
+        if (not same) {
+            const auto label = c->componentLabel;
+            *c = newcomp;
+            c->componentLabel = label;
+            rebuildIndices();
+            ensembleChanged = true;
+            restartNeeded = true;
+        }
+    }
+}
+
 void FIBProcessor::bindAudioService(
         int8_t TMid,
         uint32_t SId,
@@ -1307,24 +1616,18 @@ void FIBProcessor::bindAudioService(
         int16_t ps_flag,
         int16_t ASCTy)
 {
-    Service *s = findServiceId(SId);
-    if (!s) return;
-
-    if (std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == s->serviceId && sc.componentNr == compnr;
-                }) == components.end()) {
-        ServiceComponent newcomp;
-        newcomp.TMid         = TMid;
-        newcomp.componentNr  = compnr;
-        newcomp.SId          = SId;
-        newcomp.subchannelId = subChId;
-        newcomp.PS_flag      = ps_flag;
-        newcomp.ASCTy        = ASCTy;
-        components.push_back(newcomp);
-
-        //  std::clog << "fib-processor:" << "service %8x (comp %d) is audio\n", SId, compnr) << std::endl;
-    }
+    if (findServiceId(SId) == nullptr) return;
+
+    ServiceComponent newcomp;
+    newcomp.TMid         = TMid;
+    newcomp.componentNr  = compnr;
+    newcomp.SId          = SId;
+    newcomp.subchannelId = subChId;
+    newcomp.PS_flag      = ps_flag;
+    newcomp.ASCTy        = ASCTy;
+    bindComponent(newcomp);
+
+    //  std::clog << "fib-processor:" << "service %8x (comp %d) is audio\n", SId, compnr) << std::endl;
 }
 
 void FIBProcessor::bindDataStreamService(
@@ -1335,24 +1638,18 @@ void FIBProcessor::bindDataStreamService(
         int16_t ps_flag,
         int16_t DSCTy)
 {
-    Service *s = findServiceId(SId);
-    if (!s) return;
-
-    if (std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == s->serviceId && sc.componentNr == compnr;
-                }) == components.end()) {
-        ServiceComponent newcomp;
-        newcomp.TMid         = TMid;
-        newcomp.SId          = SId;
-        newcomp.subchannelId = subChId;
-        newcomp.componentNr  = compnr;
-        newcomp.PS_flag      = ps_flag;
-        newcomp.DSCTy        = DSCTy;
-        components.push_back(newcomp);
-
-        //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
-    }
+    if (findServiceId(SId) == nullptr) return;
+
+    ServiceComponent newcomp;
+    newcomp.TMid         = TMid;
+    newcomp.SId          = SId;
+    newcomp.subchannelId = subChId;
+    newcomp.componentNr  = compnr;
+    newcomp.PS_flag      = ps_flag;
+    newcomp.DSCTy        = DSCTy;
+    bindComponent(newcomp);
+
+    //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
 }
 
 //      bindPacketService is the main processor for - what the name suggests -
@@ -1366,24 +1663,18 @@ void FIBProcessor::bindPacketService(
         int16_t ps_flag,
         int16_t CAflag)
 {
-    Service *s = findServiceId(SId);
-    if (!s) return;
-
-    if (std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& sc) {
-                    return sc.SId == s->serviceId && sc.componentNr == compnr;
-                }) == components.end()) {
-        ServiceComponent newcomp;
-        newcomp.TMid        = TMid;
-        newcomp.SId         = SId;
-        newcomp.componentNr = compnr;
-        newcomp.SCId        = SCId;
-        newcomp.PS_flag     = ps_flag;
-        newcomp.CAflag      = CAflag;
-        components.push_back(newcomp);
-
-        //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
-    }
+    if (findServiceId(SId) == nullptr) return;
+
+    ServiceComponent newcomp;
+    newcomp.TMid        = TMid;
+    newcomp.SId         = SId;
+    newcomp.componentNr = compnr;
+    newcomp.SCId        = SCId;
+    newcomp.PS_flag     = ps_flag;
+    newcomp.CAflag      = CAflag;
+    bindComponent(newcomp);
+
+    //  std::clog << "fib-processor:" << "service %8x (comp %d) is packet\n", SId, compnr) << std::endl;
 }
 
 void FIBProcessor::dropService(uint32_t SId)
@@ -1408,23 +1699,23 @@ void FIBProcessor::dropService(uint32_t SId)
                 ), components.end());
 
     // Check for orphaned subchannels
-    for (auto& sub : subChannels) {
-        if (sub.subChId == -1) {
-            continue;
-        }
-
-        auto c_it = std::find_if(components.begin(), components.end(),
-                [&](const ServiceComponent& c) {
-                    return c.subchannelId == sub.subChId;
-                });
+    std::unordered_set<int16_t> used;
+    for (const auto& c : components) {
+        used.insert(c.subchannelId);
+    }
 
-        const bool drop = c_it == components.end();
-        if (drop) {
+    for (auto& sub : subChannels) {
+        if (sub.subChId != -1 and used.count(sub.subChId) == 0) {
             ss << ", subch " << sub.subChId;
             sub.subChId = -1;
         }
     }
 
+    rebuildIndices();
+    ensembleChanged = true;
+    invalidateFigCache();
+    settleProvisionalService(SId);
+
     std::clog << ss.str() << std::endl;
 }
 
@@ -1432,12 +1723,22 @@ void FIBProcessor::clearEnsemble()
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
     components.clear();
+    subChannels.clear();
     subChannels.resize(64);
     services.clear();
+    rebuildIndices();
     serviceRepeatCount.clear();
+    provisionalServices.clear();
+    provisionalSubchannels.reset();
+    restartNeeded = false;
+    invalidateFigCache();
     timeLastServiceDecrement = std::chrono::steady_clock::now();
     timeLastFCT0Frame = std::chrono::system_clock::now();
 
+    // Readers must not see the old ensemble any more
+    ensembleChanged = true;
+    publishEnsemble();
+
     // Clear active announcements
     std::lock_guard<std::recursive_mutex> ann_lock(activeAnnouncementsMutex_);
     activeAnnouncementsMap_.clear();
@@ -1447,69 +1748,165 @@ void FIBProcessor::clearEnsemble()
     announcementSupportMap_.clear();
 }
 
-std::vector<Service> FIBProcessor::getServiceList() const
+void FIBProcessor::publishEnsemble()
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    return services;
+    if (not ensembleChanged) {
+        return;
+    }
+    ensembleChanged = false;
+
+    auto e = std::make_shared<EnsembleSnapshot>();
+    e->version = ++ensembleVersion;
+    e->provisional = not provisionalServices.empty();
+    e->ensembleId = ensembleId;
+    e->ensembleEcc = ensembleEcc;
+    e->ensembleLabel = ensembleLabel;
+    e->services = services;
+    e->components = components;
+    e->subChannels = subChannels;
+    e->serviceIndex = serviceIndex;
+    for (size_t i = 0; i < components.size(); i++) {
+        e->serviceComponents[components[i].SId].push_back(i);
+    }
+
+    std::atomic_store(&ensemble, std::shared_ptr<const EnsembleSnapshot>(std::move(e)));
+
+    if (restartNeeded) {
+        // The snapshot is already there for the decoders to be set up again
+        restartNeeded = false;
+        myRadioInterface.onRestartService();
+    }
 }
 
-Service FIBProcessor::getService(uint32_t sId) const
+void FIBProcessor::setProvisionalEnsemble(const EnsembleSnapshot& cached)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
+    clearEnsemble();
 
-    auto srv = std::find_if(services.begin(), services.end(),
-                [&](const Service& s) {
-                    return s.serviceId == sId;
-                });
+    ensembleId = cached.ensembleId;
+    ensembleEcc = cached.ensembleEcc;
+    ensembleLabel = cached.ensembleLabel;
+    services = cached.services;
+    components = cached.components;
+    for (const auto& sub : cached.subChannels) {
+        if (sub.valid() and sub.subChId < 64) {
+            subChannels[sub.subChId] = sub;
+            provisionalSubchannels.set(sub.subChId);
+        }
+    }
+    rebuildIndices();
 
-    if (srv != services.end()) {
-        return *srv;
+    // Like a service that was signalled twice
+    for (const auto& s : services) {
+        serviceRepeatCount[s.serviceId] = 2;
+        provisionalServices.insert(s.serviceId);
     }
-    else {
-        return Service(0);
+    timeLastServiceDecrement = std::chrono::steady_clock::now();
+
+    ensembleChanged = true;
+    publishEnsemble();
+
+    myRadioInterface.onNewEnsemble(ensembleId);
+    myRadioInterface.onSetEnsembleLabel(ensembleLabel);
+    for (const auto& s : services) {
+        myRadioInterface.onServiceDetected(s.serviceId);
     }
 }
 
-std::list<ServiceComponent> FIBProcessor::getComponents(const Service& s) const
+void FIBProcessor::settleProvisionalService(uint32_t SId)
+{
+    if (provisionalServices.erase(SId) and provisionalServices.empty()) {
+        // The snapshot is no longer provisional
+        ensembleChanged = true;
+    }
+}
+
+void FIBProcessor::dropProvisionalEnsemble()
+{
+    std::clog << "fib-processor: the cached ensemble " << std::hex <<
+        ensembleId << std::dec << " is not on the air" << std::endl;
+
+    ensembleEcc = 0;
+    ensembleLabel = DabLabel();
+    services.clear();
+    components.clear();
+    subChannels.assign(64, Subchannel());
+    serviceRepeatCount.clear();
+    provisionalServices.clear();
+    provisionalSubchannels.reset();
+    rebuildIndices();
+    ensembleChanged = true;
+    restartNeeded = true;
+}
+
+std::shared_ptr<const EnsembleSnapshot> FIBProcessor::getEnsemble() const
+{
+    return std::atomic_load(&ensemble);
+}
+
+const Service *EnsembleSnapshot::findService(uint32_t sId) const
+{
+    const auto it = serviceIndex.find(sId);
+    return it == serviceIndex.end() ? nullptr : &services[it->second];
+}
+
+std::list<ServiceComponent> EnsembleSnapshot::getComponents(uint32_t sId) const
 {
     std::list<ServiceComponent> c;
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    for (const auto& component : components) {
-        if (component.SId == s.serviceId) {
-            c.push_back(component);
+    const auto it = serviceComponents.find(sId);
+    if (it != serviceComponents.end()) {
+        for (size_t i : it->second) {
+            c.push_back(components[i]);
         }
     }
-
     return c;
 }
 
+const Subchannel& EnsembleSnapshot::getSubchannel(int16_t subChId) const
+{
+    return subChannels.at(subChId);
+}
+
+std::vector<Service> FIBProcessor::getServiceList() const
+{
+    return getEnsemble()->services;
+}
+
+Service FIBProcessor::getService(uint32_t sId) const
+{
+    const auto e = getEnsemble();
+    const auto *s = e->findService(sId);
+    return s ? *s : Service(0);
+}
+
+std::list<ServiceComponent> FIBProcessor::getComponents(const Service& s) const
+{
+    return getEnsemble()->getComponents(s.serviceId);
+}
+
 Subchannel FIBProcessor::getSubchannel(const ServiceComponent& sc) const
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    return subChannels.at(sc.subchannelId);
+    return getEnsemble()->getSubchannel(sc.subchannelId);
 }
 
 uint16_t FIBProcessor::getEnsembleId() const
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    return ensembleId;
+    return getEnsemble()->ensembleId;
 }
 
 uint8_t FIBProcessor::getEnsembleEcc() const
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    return ensembleEcc;
+    return getEnsemble()->ensembleEcc;
 }
 
 DabLabel FIBProcessor::getEnsembleLabel() const
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    return ensembleLabel;
+    return getEnsemble()->ensembleLabel;
 }
 
 std::chrono::system_clock::time_point FIBProcessor::getTimeLastFCT0Frame() const
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
     return timeLastFCT0Frame;
 }
 
@@ -28,24 +28,77 @@
 #include <vector>
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 #include <chrono>
 #include <array>
+#include <bitset>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <cstdint>
 #include <cstdio>
 #include "msc-handler.h"
 #include "radio-controller.h"
 #include "announcement-types.h"
+#include "various/metrics.h"
+
+// Immutable view of the ensemble database. The FIBProcessor publishes a
+// new one after every batch of FIBs that changed the ensemble, readers
+// keep theirs as long as they like without holding up the FIG processing.
+struct EnsembleSnapshot {
+    // Incremented with every published snapshot
+    uint64_t version = 0;
+
+    // True while the ensemble comes from the EnsembleCache and some
+    // of its services were not yet confirmed by the received FIGs
+    bool provisional = false;
+
+    uint16_t ensembleId = 0;
+    uint8_t ensembleEcc = 0;
+    DabLabel ensembleLabel;
+
+    // In the order they were detected
+    std::vector<Service> services;
+    std::vector<ServiceComponent> components;
+    // Indexed by SubChId, invalid entries for the unused ones
+    std::vector<Subchannel> subChannels;
+
+    // Position of each SId in services
+    std::unordered_map<uint32_t, size_t> serviceIndex;
+    // Positions in components, per SId
+    std::unordered_map<uint32_t, std::vector<size_t> > serviceComponents;
+
+    // Returns nullptr if the service is unknown
+    const Service *findService(uint32_t sId) const;
+    std::list<ServiceComponent> getComponents(uint32_t sId) const;
+    // Throws std::out_of_range for invalid subchannel ids
+    const Subchannel& getSubchannel(int16_t subChId) const;
+};
 
 class FIBProcessor {
     public:
-        FIBProcessor(RadioControllerInterface& mr);
+        // The FIG cache metrics are labelled with metricsLabels
+        FIBProcessor(RadioControllerInterface& mr,
+                const std::string& metricsLabels = "");
 
         // called from the demodulator
         void processFIB(uint8_t *p, uint16_t fib);
+        // called after each batch of FIBs, makes the changes visible
+        void publishEnsemble();
         void clearEnsemble();
 
-        // Called from the frontend
+        // Start with the ensemble last received on the channel, before any
+        // FIG arrived. onServiceDetected is called for its services, which
+        // stay provisional until they are signalled in FIG 0/2. The ones that
+        // are not disappear after a few seconds, all of them if the EId is
+        // different. Differences to the subchannels and components of the
+        // cached ensemble are reported with onRestartService.
+        void setProvisionalEnsemble(const EnsembleSnapshot& cached);
+
+        // Called from the frontend, never block processFIB
+        std::shared_ptr<const EnsembleSnapshot> getEnsemble() const;
         uint16_t getEnsembleId() const;
         uint8_t getEnsembleEcc() const;
         DabLabel getEnsembleLabel() const;
@@ -55,6 +108,15 @@ class FIBProcessor {
         Subchannel getSubchannel(const ServiceComponent& sc) const;
         std::chrono::system_clock::time_point getTimeLastFCT0Frame() const;
 
+        // Byte-identical repetitions of a FIG are recognised and not
+        // parsed again, unless the ensemble changed in the meantime.
+        struct FigCacheStats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+        };
+        // Keyed by FIG type and extension, e.g. "0/2"
+        std::map<std::string, FigCacheStats> getFigCacheStats() const;
+
         // Announcement support methods (FIG 0/18)
         // Store announcement support info from FIG 0/18
         void storeAnnouncementSupport(const ServiceAnnouncementSupport& support);
@@ -79,7 +141,23 @@ class FIBProcessor {
         Service *findServiceId(uint32_t serviceId);
         ServiceComponent *findComponent(uint32_t serviceId, int16_t SCIdS);
         ServiceComponent *findPacketComponent(int16_t SCId);
+        void addComponent(const ServiceComponent& component);
+        void rebuildIndices();
+        void settleProvisionalService(uint32_t SId);
+        void dropProvisionalEnsemble();
+
+        // Returns true if the FIG at d was seen before and needs no parsing
+        bool isRepeatedFig(uint8_t *d, int16_t processedBytes);
+        void invalidateFigCache();
+        void countFig(uint8_t type, uint8_t extension, bool hit);
+        // The repeat counters of the services of a FIG 0/2. Returns false
+        // if a service becomes known, which needs the whole FIG parsed.
+        bool countRepeatedFIG0Extension2(uint8_t *d);
+        // Signalling of the services in FIG 0/2
+        void ageServices();
+        void countService(uint32_t SId);
 
+        void bindComponent(const ServiceComponent& newcomp);
         void bindAudioService(
                 int8_t TMid,
                 uint32_t SId,
@@ -152,7 +230,46 @@ class FIBProcessor {
         std::vector<Service> services;
         std::unordered_map<uint32_t, uint8_t> serviceRepeatCount;
         std::chrono::steady_clock::time_point timeLastServiceDecrement;
-        std::chrono::system_clock::time_point timeLastFCT0Frame;
+        std::atomic<std::chrono::system_clock::time_point> timeLastFCT0Frame;
+
+        // Hash indices into services and components, keyed by SId,
+        // by SId and SCIdS, and by SCId for the packet mode components
+        std::unordered_map<uint32_t, size_t> serviceIndex;
+        std::unordered_map<uint64_t, size_t> componentIndex;
+        std::unordered_map<uint16_t, size_t> packetComponentIndex;
+
+        // Indexed by the hash of the FIG bytes. Entries from before the
+        // last change of the ensemble are not valid.
+        struct FigCacheEntry {
+            uint32_t generation = 0;
+            uint8_t length = 0;
+            std::array<uint64_t, 4> words;
+        };
+        static constexpr size_t FIG_CACHE_SIZE = 4096;
+        static constexpr size_t FIG_CACHE_WAYS = 4;
+        std::vector<FigCacheEntry> figCache;
+        uint32_t figCacheGeneration = 1;
+
+        // Per FIG type 0 to 2 and extension
+        struct FigCacheCounters {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            metrics::Counter *hitMetric = nullptr;
+            metrics::Counter *missMetric = nullptr;
+        };
+        std::array<FigCacheCounters, 3 * 32> figCacheCounters;
+        const std::string metricsLabels;
+
+        // From the cache and not yet seen in FIG 0/2 or FIG 0/1
+        std::unordered_set<uint32_t> provisionalServices;
+        std::bitset<64> provisionalSubchannels;
+        // Set when the received FIGs contradict the cache
+        bool restartNeeded = false;
+
+        // Set by every FIG that modifies the ensemble
+        bool ensembleChanged = false;
+        uint64_t ensembleVersion = 0;
+        std::shared_ptr<const EnsembleSnapshot> ensemble;
 
         // Announcement support storage (FIG 0/18)
         // Maps Service ID to announcement support information
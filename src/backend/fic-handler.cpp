@@ -49,13 +49,20 @@ uint8_t PI_X [24] = {
   *     puncturing.
   *     The data is sent through to the fic processor
   */
-FicHandler::FicHandler(RadioControllerInterface& mr) :
+FicHandler::FicHandler(RadioControllerInterface& mr,
+        const std::string& metricsLabels) :
     Viterbi(768),
-    fibProcessor(mr),
+    fibProcessor(mr, metricsLabels),
     myRadioInterface(mr),
     bitBuffer_out(768),
     ofdm_input(2304),
-    viterbiBlock(3072 + 24)
+    viterbiBlock(3072 + 24),
+    fibsCrcOk(metrics::registry().counter(
+                "welle_fic_fibs_total", "FIBs decoded from the FIC",
+                metrics::join_labels(metricsLabels, metrics::label("crc", "ok")))),
+    fibsCrcError(metrics::registry().counter(
+                "welle_fic_fibs_total", "FIBs decoded from the FIC",
+                metrics::join_labels(metricsLabels, metrics::label("crc", "error"))))
 {
     PI_15 = getPCodes(15 - 1);
     PI_16 = getPCodes(16 - 1);
@@ -217,16 +224,22 @@ void FicHandler::processFicInput(const softbit_t *ficblock, int16_t ficno)
         const bool crcvalid = check_CRC_bits(p, 256);
         myRadioInterface.onFIBDecodeSuccess(crcvalid, p);
         if (crcvalid) {
+            fibsCrcOk.inc();
             fibProcessor.processFIB(p, ficno);
 
             if (fic_decode_success_ratio < 10) {
                 fic_decode_success_ratio++;
             }
         }
-        else if (fic_decode_success_ratio > 0) {
-            fic_decode_success_ratio--;
+        else {
+            fibsCrcError.inc();
+            if (fic_decode_success_ratio > 0) {
+                fic_decode_success_ratio--;
+            }
         }
     }
+
+    fibProcessor.publishEnsemble();
 }
 
 void FicHandler::clearEnsemble()
@@ -34,11 +34,13 @@
 #include "viterbi.h"
 #include "fib-processor.h"
 #include "radio-controller.h"
+#include "various/metrics.h"
 
 class FicHandler: public Viterbi
 {
     public:
-        FicHandler(RadioControllerInterface& mr);
+        FicHandler(RadioControllerInterface& mr,
+                const std::string& metricsLabels = "");
         void    processFicBlock(const softbit_t *data, int16_t blkno);
         void    setBitsperBlock(int16_t b);
         void    clearEnsemble();
@@ -62,6 +64,9 @@ class FicHandler: public Viterbi
         // Saturating up/down-counter in range [0, 10] corresponding
         // to the number of FICs with correct CRC
         int         fic_decode_success_ratio = 0;
+
+        metrics::Counter& fibsCrcOk;
+        metrics::Counter& fibsCrcError;
 };
 
 #endif
@@ -16,47 +16,74 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include "mot_manager.h"
 
 
 // --- MOTEntity -----------------------------------------------------------------
-void MOTEntity::AddSeg(int seg_number, bool last_seg, const uint8_t* data, size_t len) {
+void MOTEntity::AddSeg(int seg_number, bool last_seg, const uint8_t* seg_data, size_t len) {
 	if(last_seg)
 		last_seg_number = seg_number;
 
-	if(segs.find(seg_number) != segs.end())
+	if((size_t) seg_number < received.size() && received[seg_number])
 		return;
+	if(last_seg_number != -1 && seg_number > last_seg_number)
+		return;
+
+	// all segments but the last one have the same size
+	if(!last_seg) {
+		if(seg_len == 0)
+			seg_len = len;
+		else if(len != seg_len)
+			return;
+	}
 
-	// copy data
-	segs[seg_number] = seg_t(len);
-	memcpy(&segs[seg_number][0], data, len);
+	if((size_t) seg_number >= received.size())
+		received.resize(seg_number + 1);
+	received[seg_number] = true;
 	size += len;
+
+	if(last_seg && seg_number > 0 && seg_len == 0) {
+		// the position of the last segment is not known yet
+		pending_last_seg.assign(seg_data, seg_data + len);
+		last_seg_pending = true;
+		return;
+	}
+	Place(seg_number, seg_data, len);
+
+	if(last_seg_pending && seg_len != 0) {
+		Place(last_seg_number, pending_last_seg.data(), pending_last_seg.size());
+		pending_last_seg.clear();
+		pending_last_seg.shrink_to_fit();
+		last_seg_pending = false;
+	}
+}
+
+void MOTEntity::Place(int seg_number, const uint8_t* seg_data, size_t len) {
+	size_t offset = seg_number * seg_len;
+	if(data.size() < offset + len)
+		data.resize(offset + len);
+	memcpy(data.data() + offset, seg_data, len);
 }
 
 bool MOTEntity::IsFinished() {
-	if(last_seg_number == -1)
+	if(last_seg_number == -1 || last_seg_pending)
+		return false;
+	if(received.size() <= (size_t) last_seg_number)
 		return false;
 
 	// check if all segments are available
 	for(int i = 0; i <= last_seg_number; i++)
-		if(segs.find(i) == segs.end())
+		if(!received[i])
 			return false;
 	return true;
 }
 
-std::vector<uint8_t> MOTEntity::GetData() {
-	std::vector<uint8_t> result(size);
-	size_t offset = 0;
-
-	// concatenate all segments
-	for(int i = 0; i <= last_seg_number; i++) {
-		seg_t& seg = segs[i];
-		memcpy(&result[offset], &seg[0], seg.size());
-		offset += seg.size();
-	}
-
+std::vector<uint8_t> MOTEntity::TakeData() {
+	std::vector<uint8_t> result = std::move(data);
+	Reset();
 	return result;
 }
 
@@ -66,9 +93,19 @@ void MOTObject::AddSeg(bool dg_type_header, int seg_number, bool last_seg, const
 	(dg_type_header ? header : body).AddSeg(seg_number, last_seg, data, len);
 }
 
-bool MOTObject::ParseCheckHeader(MOT_FILE& target_file) {
+bool MOTObject::SetHeader(const std::vector<uint8_t>& data) {
+	if(header_received)
+		return true;
+	if(!ParseCheckHeader(data, result_file))
+		return false;
+
+	// objects of a directory have no trigger time
+	result_file.trigger_time_now = true;
+	return true;
+}
+
+bool MOTObject::ParseCheckHeader(const std::vector<uint8_t>& data, MOT_FILE& target_file) {
 	MOT_FILE file = target_file;
-	std::vector<uint8_t> data = header.GetData();
 
 	// parse/check header core
 	if(data.size() < 7)
@@ -82,7 +119,7 @@ bool MOTObject::ParseCheckHeader(MOT_FILE& target_file) {
 //	fprintf(stderr, "body_size: %5zu, header_size: %3zu, content_type: 0x%02X, content_sub_type: 0x%03X\n",
 //			body_size, header_size, content_type, content_sub_type);
 
-	if(header_size != header.GetSize())
+	if(header_size != data.size())
 		return false;
 
 	bool header_update =
@@ -178,6 +215,9 @@ bool MOTObject::ParseCheckHeader(MOT_FILE& target_file) {
 	if(!header_update) {
 		// ensure actual header is processed only once
 		header_received = true;
+
+		// reassemble the body in place
+		body.Reserve(std::min(file.body_size, MOTManager::MAX_MEMORY));
 	} else {
 		// ensure matching content name
 		if(new_content_name != old_content_name)
@@ -196,7 +236,7 @@ bool MOTObject::IsToBeShown() {
 	// try to process finished header
 	if(header.IsFinished()) {
 		// parse/check MOT header
-		bool result = ParseCheckHeader(result_file);
+		bool result = ParseCheckHeader(header.GetData(), result_file);
 		header.Reset();	// allow for header updates
 		if(!result)
 			return false;
@@ -211,7 +251,7 @@ bool MOTObject::IsToBeShown() {
 		return false;
 
 	// add body data
-	result_file.data = body.GetData();
+	result_file.data = body.TakeData();
 
 	shown = true;
 	return true;
@@ -219,13 +259,26 @@ bool MOTObject::IsToBeShown() {
 
 
 // --- MOTManager -----------------------------------------------------------------
+const size_t MOTManager::MAX_OBJECTS;
+const size_t MOTManager::MAX_MEMORY;
+const size_t MOTManager::MAX_COMPLETED;
+
 MOTManager::MOTManager() {
 	Reset();
 }
 
 void MOTManager::Reset() {
-	object = MOTObject();
-	current_transport_id = -1;
+	objects.clear();
+	completed.clear();
+	header_crcs.clear();
+	use_counter = 0;
+	repetitions = 0;
+	files.clear();
+
+	directory.Reset();
+	directory_transport_id = -1;
+	directory_parsed = false;
+	directory_headers.clear();
 }
 
 bool MOTManager::ParseCheckDataGroupHeader(const std::vector<uint8_t>& dg, size_t& offset, int& dg_type) {
@@ -246,7 +299,7 @@ bool MOTManager::ParseCheckDataGroupHeader(const std::vector<uint8_t>& dg, size_
 		return false;
 	if(!user_access_flag)
 		return false;
-	if(dg_type != 3 && dg_type != 4)	// only accept MOT header/body
+	if(dg_type != 3 && dg_type != 4 && dg_type != 6)	// only accept MOT header/body/directory
 		return false;
 
 	return true;
@@ -311,18 +364,198 @@ bool MOTManager::HandleMOTDataGroup(const std::vector<uint8_t>& dg) {
 		return false;
 
 
-	// add segment to MOT object (reset if necessary)
-	if(current_transport_id != transport_id) {
-		current_transport_id = transport_id;
-		object = MOTObject();
+	const uint8_t* seg_data = &dg[offset];
+	const size_t num_files = files.size();
+
+	if(dg_type == 6) {
+		HandleDirectorySeg(transport_id, seg_number, last_seg, seg_data, seg_size);
+		return files.size() > num_files;
+	}
+
+	bool dg_type_header = dg_type == 3;
+	uint16_t header_crc = 0;
+	if(dg_type_header && seg_number == 0)
+		header_crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(seg_data, seg_size);
+
+	// skip repetitions of completed objects by the carousel, unless the
+	// transport ID was reused for another object
+	auto c = completed.find(transport_id);
+	if(c != completed.end()) {
+		if(dg_type_header && seg_number == 0 && header_crc != c->second.header_crc) {
+			completed.erase(c);
+		} else {
+			c->second.last_used = ++use_counter;
+			repetitions++;
+			return false;
+		}
+	}
+
+	// add segment to MOT object (create if necessary)
+	auto it = objects.find(transport_id);
+	if(it == objects.end()) {
+		it = objects.emplace(transport_id, ObjectEntry()).first;
+
+		auto d = directory_headers.find(transport_id);
+		if(d != directory_headers.end()) {
+			it->second.object.SetHeader(d->second);
+			header_crcs[transport_id] = CalcCRC::CalcCRC_CRC16_CCITT.Calc(d->second.data(), d->second.size());
+		}
 	}
-	object.AddSeg(dg_type == 3, seg_number, last_seg, &dg[offset], seg_size);
+	it->second.last_used = ++use_counter;
+	if(dg_type_header && seg_number == 0)
+		header_crcs[transport_id] = header_crc;
+	it->second.object.AddSeg(dg_type_header, seg_number, last_seg, seg_data, seg_size);
 
 	// check if object shall be shown
-	bool display = object.IsToBeShown();
-//	fprintf(stderr, "dg_type: %d, seg_number: %2d%s, transport_id: %5d, size: %4zu; display: %s\n",
-//			dg_type, seg_number, last_seg ? " (LAST)" : "", transport_id, seg_size, display ? "true" : "false");
+	CheckObject(transport_id);
+	Evict(transport_id);
+//	fprintf(stderr, "dg_type: %d, seg_number: %2d%s, transport_id: %5d, size: %4zu; files: %zu\n",
+//			dg_type, seg_number, last_seg ? " (LAST)" : "", transport_id, seg_size, files.size());
+
+	return files.size() > num_files;
+}
+
+MOT_FILE MOTManager::GetFile() {
+	if(files.empty())
+		return MOT_FILE();
 
-	// if object shall be shown, update it
-	return display;
+	MOT_FILE file = std::move(files.front());
+	files.pop_front();
+	return file;
+}
+
+size_t MOTManager::GetMemoryUsage() {
+	size_t memory = directory.GetMemoryUsage();
+	for(auto& o : objects)
+		memory += o.second.object.GetMemoryUsage();
+	return memory;
+}
+
+void MOTManager::CheckObject(int transport_id) {
+	auto it = objects.find(transport_id);
+	if(it == objects.end() || !it->second.object.IsToBeShown())
+		return;
+
+	MOT_FILE file = it->second.object.TakeFile();
+	file.transport_id = transport_id;
+	files.push_back(std::move(file));
+	if(files.size() > MAX_OBJECTS)
+		files.pop_front();
+
+	// remember the object, the reassembly buffers are no longer needed
+	auto crc = header_crcs.find(transport_id);
+	CompletedEntry& entry = completed[transport_id];
+	entry.header_crc = crc != header_crcs.end() ? crc->second : 0;
+	entry.last_used = ++use_counter;
+	objects.erase(it);
+	header_crcs.erase(transport_id);
+
+	if(completed.size() > MAX_COMPLETED) {
+		auto lru = std::min_element(completed.begin(), completed.end(),
+				[](const std::pair<const int, CompletedEntry>& a, const std::pair<const int, CompletedEntry>& b) {
+					return a.second.last_used < b.second.last_used;
+				});
+		completed.erase(lru);
+	}
+}
+
+void MOTManager::Evict(int keep_transport_id) {
+	// drop the least recently used objects, but never the one just updated
+	while(objects.size() > MAX_OBJECTS || GetMemoryUsage() > MAX_MEMORY) {
+		auto lru = objects.end();
+		for(auto it = objects.begin(); it != objects.end(); it++) {
+			if(it->first == keep_transport_id)
+				continue;
+			if(lru == objects.end() || it->second.last_used < lru->second.last_used)
+				lru = it;
+		}
+		if(lru == objects.end())
+			break;
+
+		header_crcs.erase(lru->first);
+		objects.erase(lru);
+	}
+}
+
+void MOTManager::HandleDirectorySeg(int transport_id, int seg_number, bool last_seg, const uint8_t* data, size_t len) {
+	// a new directory has a new transport ID
+	if(transport_id != directory_transport_id) {
+		directory.Reset();
+		directory_transport_id = transport_id;
+		directory_parsed = false;
+	}
+
+	if(directory_parsed) {
+		repetitions++;
+		return;
+	}
+
+	directory.AddSeg(seg_number, last_seg, data, len);
+	if(!directory.IsFinished())
+		return;
+
+	directory_parsed = ParseDirectory(directory.GetData());
+	directory.Reset();
+	if(!directory_parsed)
+		directory_transport_id = -1;	// retry with the next repetition
+}
+
+bool MOTManager::ParseDirectory(const std::vector<uint8_t>& data) {
+	// parse/check directory header
+	if(data.size() < 13)
+		return false;
+
+	bool compression_flag = data[0] & 0x80;
+	size_t directory_size = ((data[0] & 0x3F) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+	size_t num_objects = (data[4] << 8) | data[5];
+	size_t extension_len = (data[11] << 8) | data[12];
+
+	if(compression_flag)	// compressed directories are not supported
+		return false;
+	if(directory_size != data.size())
+		return false;
+
+	// skip directory extension, then read the entries
+	std::map<int, std::vector<uint8_t>> headers;
+	size_t offset = 13 + extension_len;
+	for(size_t i = 0; i < num_objects; i++) {
+		if(offset + 2 + 7 > data.size())
+			return false;
+
+		int transport_id = (data[offset] << 8) | data[offset + 1];
+		offset += 2;
+
+		size_t header_size = ((data[offset + 3] & 0x0F) << 9) | (data[offset + 4] << 1) | (data[offset + 5] >> 7);
+		if(header_size < 7 || offset + header_size > data.size())
+			return false;
+
+		headers[transport_id].assign(data.begin() + offset, data.begin() + offset + header_size);
+		offset += header_size;
+	}
+
+	// forget the completed objects that were removed from the directory or changed
+	for(auto c = completed.begin(); c != completed.end();) {
+		auto h = headers.find(c->first);
+		if(h == headers.end() || CalcCRC::CalcCRC_CRC16_CCITT.Calc(h->second.data(), h->second.size()) != c->second.header_crc)
+			c = completed.erase(c);
+		else
+			c++;
+	}
+
+	directory_headers = std::move(headers);
+
+	// bodies may have arrived before the directory
+	std::vector<int> transport_ids;
+	for(auto& o : objects) {
+		auto h = directory_headers.find(o.first);
+		if(h != directory_headers.end() && !o.second.object.HasHeader()) {
+			o.second.object.SetHeader(h->second);
+			header_crcs[o.first] = CalcCRC::CalcCRC_CRC16_CCITT.Calc(h->second.data(), h->second.size());
+			transport_ids.push_back(o.first);
+		}
+	}
+	for(int transport_id : transport_ids)
+		CheckObject(transport_id);
+
+	return true;
 }
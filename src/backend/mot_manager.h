@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <string>
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -49,6 +50,9 @@ struct MOT_FILE {
     uint8_t slide_id = 0;
     std::string category_title;
 
+	// from the session header
+	int transport_id = -1;
+
 	static const int CONTENT_TYPE_IMAGE			= 0x02;
 	static const int CONTENT_TYPE_MOT_TRANSPORT	= 0x05;
 	static const int CONTENT_SUB_TYPE_JFIF			= 0x001;
@@ -64,27 +68,43 @@ struct MOT_FILE {
 };
 
 
-typedef std::vector<uint8_t> seg_t;
-typedef std::map<int,seg_t> segs_t;
-
 // --- MOTEntity -----------------------------------------------------------------
+// Reassembles the segments of a header, body or directory into one contiguous
+// buffer. All segments but the last have the same size, so each segment is
+// copied straight to its final place, whatever the order of arrival.
 class MOTEntity {
 private:
-	segs_t segs;
+	std::vector<uint8_t> data;
+	std::vector<bool> received;
+	size_t seg_len;		// size of all but the last segment, 0 while unknown
 	int last_seg_number;
+	std::vector<uint8_t> pending_last_seg;	// kept aside until seg_len is known
+	bool last_seg_pending;
 	size_t size;
+
+	void Place(int seg_number, const uint8_t* seg_data, size_t len);
 public:
 	MOTEntity() {Reset();}
 	void Reset() {
-		segs.clear();
+		data.clear();
+		data.shrink_to_fit();
+		received.clear();
+		seg_len = 0;
 		last_seg_number = -1;
+		pending_last_seg.clear();
+		last_seg_pending = false;
 		size = 0;
 	}
 
+	// Preallocate the buffer when the total size is known from a header
+	void Reserve(size_t total_size) {data.reserve(total_size);}
+
 	void AddSeg(int seg_number, bool last_seg, const uint8_t* data, size_t len);
 	bool IsFinished();
 	size_t GetSize() {return size;}
-	std::vector<uint8_t> GetData();
+	size_t GetMemoryUsage() {return data.capacity() + pending_last_seg.capacity();}
+	const std::vector<uint8_t>& GetData() {return data;}
+	std::vector<uint8_t> TakeData();
 };
 
 
@@ -98,31 +118,83 @@ private:
 
 	MOT_FILE result_file;
 
-	bool ParseCheckHeader(MOT_FILE& target_file);
+	bool ParseCheckHeader(const std::vector<uint8_t>& data, MOT_FILE& target_file);
 public:
 	MOTObject(): header_received(false), shown(false) {}
 
 	void AddSeg(bool dg_type_header, int seg_number, bool last_seg, const uint8_t* data, size_t len);
+	// Directory mode: the header comes from the MOT directory instead of a header data group
+	bool SetHeader(const std::vector<uint8_t>& data);
+	bool HasHeader() {return header_received;}
 	bool IsToBeShown();
-	MOT_FILE GetFile() {return result_file;}
+	size_t GetMemoryUsage() {return header.GetMemoryUsage() + body.GetMemoryUsage() + result_file.data.capacity();}
+	MOT_FILE TakeFile() {return std::move(result_file);}
 };
 
 
 // --- MOTManager -----------------------------------------------------------------
+// Reassembles the MOT objects of several transport IDs concurrently, as an
+// interleaved carousel sends them, both in header mode and in directory mode.
+//
+// The memory of the objects being reassembled is capped, the least recently
+// used object is dropped first. The transport IDs of the completed objects are
+// remembered, so that further transmissions of the same object by the carousel
+// are recognised and skipped instead of being reassembled and decoded again.
 class MOTManager {
+public:
+	static const size_t MAX_OBJECTS = 16;
+	static const size_t MAX_MEMORY = 4 * 1024 * 1024;
+	static const size_t MAX_COMPLETED = 64;
 private:
-	MOTObject object;
-	int current_transport_id;
+	struct ObjectEntry {
+		MOTObject object;
+		uint64_t last_used;
+	};
+	std::map<int, ObjectEntry> objects;
+
+	// CRC of the header of every completed object, to tell a repetition
+	// from a new object that reuses the transport ID.
+	struct CompletedEntry {
+		uint16_t header_crc;
+		uint64_t last_used;
+	};
+	std::map<int, CompletedEntry> completed;
+	// Header CRCs of the objects being reassembled
+	std::map<int, uint16_t> header_crcs;
+
+	uint64_t use_counter;
+	size_t repetitions;
+	std::deque<MOT_FILE> files;
+
+	// Directory mode
+	MOTEntity directory;
+	int directory_transport_id;
+	bool directory_parsed;
+	std::map<int, std::vector<uint8_t>> directory_headers;
 
 	bool ParseCheckDataGroupHeader(const std::vector<uint8_t>& dg, size_t& offset, int& dg_type);
 	bool ParseCheckSessionHeader(const std::vector<uint8_t>& dg, size_t& offset, bool& last_seg, int& seg_number, int& transport_id);
 	bool ParseCheckSegmentationHeader(const std::vector<uint8_t>& dg, size_t& offset, size_t& seg_size);
+
+	void HandleDirectorySeg(int transport_id, int seg_number, bool last_seg, const uint8_t* data, size_t len);
+	bool ParseDirectory(const std::vector<uint8_t>& data);
+	void CheckObject(int transport_id);
+	void Evict(int keep_transport_id);
 public:
 	MOTManager();
 
 	void Reset();
+	// Returns true if new files are available
 	bool HandleMOTDataGroup(const std::vector<uint8_t>& dg);
-	MOT_FILE GetFile() {return object.GetFile();}
+	bool HasFile() {return !files.empty();}
+	// Takes the oldest available file
+	MOT_FILE GetFile();
+
+	bool IsCompleted(int transport_id) {return completed.count(transport_id);}
+	size_t GetNumObjects() {return objects.size();}
+	size_t GetMemoryUsage();
+	// Number of segments skipped because their object was already complete
+	size_t GetRepetitions() {return repetitions;}
 };
 
 #endif /* MOT_MANAGER_H_ */
@@ -37,9 +37,11 @@
 //  Note CIF counts from 0 .. 3
 MscHandler::MscHandler(
         const DABParams& p,
-        bool show_crcErrors) :
+        bool show_crcErrors,
+        const std::string& metricsLabels) :
     bitsperBlock(2 * p.K),
     show_crcErrors(show_crcErrors),
+    metricsLabels(metricsLabels),
     cifVector(864 * CUSize)
 {
     if (p.dabMode == 4) {  // 2 CIFS per 76 blocks
@@ -77,24 +79,13 @@ bool MscHandler::addSubchannel(
 
     s.dabHandler = std::make_shared<DabAudio>(
                 ascty,
+                sub.subChId,
                 sub.length * CUSize,
                 sub.bitrate(),
                 sub.protectionSettings,
                 handler,
-                dumpFileName);
-
-     /* TODO dealing with data
-      s.dabHandler = std::make_shared<DabData>(radioInterface,
-                                  new_DSCTy,
-                                  new_packetAddress,
-                                  subChannel.length * CUSize,
-                                  subChannel.bitrate(),
-                                  subChannel.shortForm,
-                                  subChannel.protLevel,
-                                  new_DGflag,
-                                  new_FEC_scheme,
-                                  show_crcErrors);
-      */
+                dumpFileName,
+                metricsLabels);
 
     streams.push_back(std::move(s));
 
@@ -119,6 +110,58 @@ bool MscHandler::removeSubchannel(const Subchannel& sub)
     return false;
 }
 
+bool MscHandler::addPacketComponent(
+        PacketDataHandlerInterface& handler,
+        const Subchannel& sub,
+        uint16_t packetAddress,
+        bool dataGroups)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = std::find_if(dataStreams.begin(), dataStreams.end(),
+            [&](const DataStream& stream) {
+                return stream.subCh.subChId == sub.subChId;
+            } );
+
+    if (it == dataStreams.end()) {
+        DataStream s;
+        s.subCh = sub;
+        s.dabData = std::make_shared<DabData>(
+                sub.subChId,
+                sub.length * CUSize,
+                sub.bitrate(),
+                sub.protectionSettings,
+                sub.fecScheme == 1);
+        dataWorker.add(s.dabData);
+        it = dataStreams.insert(dataStreams.end(), std::move(s));
+    }
+
+    it->dabData->subscribe(packetAddress, dataGroups, handler);
+
+    work_to_be_done = true;
+    return true;
+}
+
+bool MscHandler::removePacketComponent(const Subchannel& sub, uint16_t packetAddress)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = std::find_if(dataStreams.begin(), dataStreams.end(),
+            [&](const DataStream& stream) {
+                return stream.subCh.subChId == sub.subChId;
+            } );
+
+    if (it == dataStreams.end()) {
+        return false;
+    }
+
+    if (not it->dabData->unsubscribe(packetAddress)) {
+        dataWorker.remove(it->dabData);
+        dataStreams.erase(it);
+    }
+    return true;
+}
+
 //  add blocks. First is (should be) block 5, last is (should be) 76
 //  Note that this method is called from within the ofdm-processor thread
 //  while the set_xxx methods are called from within the
@@ -155,6 +198,15 @@ void MscHandler::processMscBlock(const softbit_t *fbits, int16_t blkno)
             throw std::logic_error("No dabHandler!");
         }
     }
+
+    for (auto& stream : dataStreams) {
+        softbit_t *myBegin = &cifVector[stream.subCh.startAddr * CUSize];
+        (void)stream.dabData->process(myBegin, stream.subCh.length * CUSize);
+    }
+
+    if (not dataStreams.empty()) {
+        dataWorker.notify();
+    }
 }
 
 void MscHandler::stopProcessing()
@@ -162,5 +214,10 @@ void MscHandler::stopProcessing()
     std::lock_guard<std::mutex> lock(mutex);
     work_to_be_done = false;
     streams.clear();
+
+    for (const auto& stream : dataStreams) {
+        dataWorker.remove(stream.dabData);
+    }
+    dataStreams.clear();
 }
 
@@ -40,13 +40,16 @@
 #include "dab-constants.h"
 #include "ringbuffer.h"
 #include "radio-controller.h"
+#include "dab-data.h"
 
 class DabVirtual;
 
 class MscHandler
 {
     public:
-        MscHandler(const DABParams& p, bool show_crcErrors);
+        // The metrics of the audio subchannels are labelled with metricsLabels
+        MscHandler(const DABParams& p, bool show_crcErrors,
+                const std::string& metricsLabels = "");
 
         // Stop processing and remove all subchannels
         void stopProcessing(void);
@@ -59,6 +62,18 @@ class MscHandler
 
         bool removeSubchannel(const Subchannel& sub);
 
+        // Decode the packet mode subchannel sub, and give the data of
+        // packetAddress to the handler. All packet mode subchannels are
+        // decoded by one thread.
+        bool addPacketComponent(
+                PacketDataHandlerInterface& handler,
+                const Subchannel& sub,
+                uint16_t packetAddress,
+                bool dataGroups);
+
+        // The subchannel is removed with its last packet address
+        bool removePacketComponent(const Subchannel& sub, uint16_t packetAddress);
+
     private:
         friend class OfdmDecoder;
         void processMscBlock(const softbit_t *fbits, int16_t blkno);
@@ -83,12 +98,20 @@ class MscHandler
             std::shared_ptr<DabVirtual> dabHandler;
         };
 
+        struct DataStream {
+            Subchannel subCh;
+            std::shared_ptr<DabData> dabData;
+        };
+
         std::mutex mutex;
         std::list<SelectedStream> streams;
+        std::list<DataStream> dataStreams;
+        DabDataWorker dataWorker;
 
         const int16_t bitsperBlock;
         int16_t numberofblocksperCIF;
         bool show_crcErrors;
+        const std::string metricsLabels;
 
         std::vector<softbit_t> cifVector;
         int16_t cifCount = 0; // msc blocks in CIF
@@ -30,6 +30,7 @@
 #include <cstddef>
 #include "ofdm-decoder.h"
 #include "various/profiling.h"
+#include "various/metrics.h"
 #include <iostream>
 
 /**
@@ -43,7 +44,8 @@ OfdmDecoder::OfdmDecoder(
         const DABParams& p,
         RadioControllerInterface& mr,
         FicHandler& ficHandler,
-        MscHandler& mscHandler) :
+        MscHandler& mscHandler,
+        const std::string& metricsLabels) :
     params(p),
     radioInterface(mr),
     ficHandler(ficHandler),
@@ -52,7 +54,11 @@ OfdmDecoder::OfdmDecoder(
     phaseReference(params.T_u),
     fft_handler(p.T_u),
     interleaver(p),
-    ibits(2 * params.K)
+    ibits(2 * params.K),
+    frameTime(metrics::registry().histogram(
+                "welle_ofdm_decoder_frame_seconds",
+                "CPU time spent by the OFDM decoder per transmission frame",
+                metrics::frame_time_buckets(), metricsLabels))
 {
     T_g = params.T_s - params.T_u;
     fft_buffer = fft_handler.getVector();
@@ -93,6 +99,8 @@ void OfdmDecoder::reset()
 void OfdmDecoder::workerthread()
 {
     int currentSym = 0;
+    // Symbols of one frame can arrive over several wakeups
+    double frameCpuTime = 0;
 
     running = true;
 
@@ -107,16 +115,22 @@ void OfdmDecoder::workerthread()
         }
 
         while (num_pending_symbols > 0 && running) {
+            const double symbolStartTime = metrics::thread_cpu_seconds();
 
             if (currentSym == 0)
                 processPRS();
             else
                 decodeDataSymbol(currentSym);
 
+            frameCpuTime += metrics::thread_cpu_seconds() - symbolStartTime;
+
             currentSym = (currentSym + 1) % (params.L);
             num_pending_symbols -= 1;
 
             if (currentSym == 0) {
+                frameTime.observe(frameCpuTime);
+                frameCpuTime = 0;
+
                 radioInterface.onConstellationPoints(
                         std::move(constellationPoints));
                 constellationPoints.clear();
@@ -174,6 +188,11 @@ void OfdmDecoder::processPRS()
  */
 void OfdmDecoder::decodeDataSymbol(int32_t sym_ix)
 {
+    // The OFDMProcessor leaves out the MSC symbols while scanning
+    if (pending_symbols[sym_ix].empty()) {
+        return;
+    }
+
     PROFILE(ProcessSymbol);
     memcpy (fft_buffer,
             pending_symbols[sym_ix].data() + T_g,
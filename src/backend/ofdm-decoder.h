@@ -37,6 +37,7 @@
 #include "radio-controller.h"
 #include "fic-handler.h"
 #include "msc-handler.h"
+#include "various/metrics.h"
 
 class OfdmDecoder
 {
@@ -45,7 +46,8 @@ class OfdmDecoder
                 const DABParams& p,
                 RadioControllerInterface& mr,
                 FicHandler& ficHandler,
-                MscHandler& mscHandler);
+                MscHandler& mscHandler,
+                const std::string& metricsLabels = "");
         ~OfdmDecoder();
         void    pushAllSymbols(std::vector<std::vector<DSPCOMPLEX> >&& sym);
         void    reset();
@@ -81,6 +83,8 @@ class OfdmDecoder
         const double mer_alpha = 1e-7;
         std::atomic<double> mer = ATOMIC_VAR_INIT(0.0);
 
+        metrics::Histogram& frameTime;
+
     public:
         // Plotting all points is too costly, we decimate the number of points.
         // The decimation factor should divide K for all transmission modes.
@@ -33,6 +33,7 @@
 #include <cstddef>
 #include "ofdm-processor.h"
 #include "various/profiling.h"
+#include "various/metrics.h"
 #include <iostream>
 //
 #define SEARCH_RANGE        (2 * 36)
@@ -57,10 +58,12 @@ OFDMProcessor::OFDMProcessor(
         RadioControllerInterface& ri,
         MscHandler& msc,
         FicHandler& fic,
-        RadioReceiverOptions rro) :
+        RadioReceiverOptions rro,
+        const std::string& metricsLabels) :
     receiver_options(rro),
     radioInterface(ri),
-    input(inputInterface),
+    resampledInput(inputInterface),
+    input(resampledInput),
     params(params),
     ficHandler(fic),
     tiiDecoder(params, ri),
@@ -70,7 +73,24 @@ OFDMProcessor::OFDMProcessor(
     T_F(params.T_F),
     oscillatorTable(INPUT_RATE),
     phaseRef(params, rro.fftPlacementMethod),
-    ofdmDecoder(params, ri, fic, msc),
+    ofdmDecoder(params, ri, fic, msc, metricsLabels),
+    scanPrecheck(params),
+    syncLosses(metrics::registry().counter(
+                "welle_ofdm_sync_losses_total",
+                "Number of times the OFDM processor lost synchronisation",
+                metricsLabels)),
+    scanRejections(metrics::registry().counter(
+                "welle_ofdm_scan_rejections_total",
+                "Number of channels found empty by the scan precheck",
+                metricsLabels)),
+    inputDiscontinuities(metrics::registry().counter(
+                "welle_ofdm_input_discontinuities_total",
+                "Number of times the OFDM processor resynchronised because the input lost samples",
+                metricsLabels)),
+    frameTime(metrics::registry().histogram(
+                "welle_ofdm_processor_frame_seconds",
+                "CPU time spent by the OFDM processor per transmission frame",
+                metrics::frame_time_buckets(), metricsLabels)),
     fft_handler(params.T_u),
     fft_buffer(fft_handler.getVector())
 {
@@ -149,6 +169,7 @@ DSPCOMPLEX OFDMProcessor::getSample(int32_t phase)
         throw NotRunningAnymore();
     /// bufferContent is an indicator for the value of ...->Samples ()
     if (bufferContent == 0) {
+        checkDiscontinuity();
         bufferContent = input.getSamplesToRead ();
         while ((bufferContent == 0) && running) {
             if (not input.is_ok()) {
@@ -165,6 +186,7 @@ DSPCOMPLEX OFDMProcessor::getSample(int32_t phase)
     //  so here, bufferContent > 0
     input.getSamples (&temp, 1);
     bufferContent --;
+    advanceReadPosition(1);
 
     //
     //  OK, we have a sample!!
@@ -190,6 +212,7 @@ void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
     if (!running)
         throw NotRunningAnymore();
     if (n > bufferContent) {
+        checkDiscontinuity();
         bufferContent = input.getSamplesToRead ();
         while ((bufferContent < n) && running) {
             if (not input.is_ok()) {
@@ -205,6 +228,7 @@ void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
     //  so here, bufferContent >= n
     n = input.getSamples (v, n);
     bufferContent -= n;
+    advanceReadPosition(n);
 
     //  OK, we have samples!!
     //  first: adjust frequency. We need Hz accuracy
@@ -224,6 +248,35 @@ void OFDMProcessor::getSamples(DSPCOMPLEX *v, int16_t n, int32_t phase)
 }
 
 
+/*
+ * Called before fetching new samples from the input: if samples were
+ * lost since the last call, note where the samples that are not
+ * contiguous with the ones before begin. The samples buffered up to
+ * there are still good.
+ */
+void OFDMProcessor::checkDiscontinuity()
+{
+    const uint64_t count = input.getDiscontinuityCount();
+    if (count != discontinuityCount and discontinuityAt < 0) {
+        discontinuityCount = count;
+        discontinuityAt = samplesRead + input.getSamplesBeforeDiscontinuity();
+    }
+}
+
+/*
+ * Called with the number of samples just read: the frame being decoded
+ * is abandoned once they reach past the discontinuity.
+ */
+void OFDMProcessor::advanceReadPosition(int32_t n)
+{
+    if (discontinuityAt >= 0 and samplesRead + n > discontinuityAt) {
+        discontinuityAt = -1;
+        discontinuity = true;
+        inputDiscontinuities.inc();
+    }
+    samplesRead += n;
+}
+
 /***
  *    \brief run
  *    The main thread, reading samples,
@@ -244,8 +297,19 @@ void OFDMProcessor::run()
 
     std::vector<DSPCOMPLEX> ofdmBuffer(params.L * params.T_s);
     std::vector<std::vector<DSPCOMPLEX> > allSymbols;
+    std::vector<DSPCOMPLEX> mscScratch;
+    bool synced = false;
+    double frameStartTime = 0;
+
+    discontinuityCount = input.getDiscontinuityCount();
+    discontinuityAt = -1;
 
     try {
+        if (scanMode and not precheckChannel()) {
+            radioInterface.onSignalPresence(false);
+            scanMode  = false;
+            attempts  = 0;
+        }
 
         //Initing:
         /// first, we need samples to get a reasonable sLevel
@@ -255,6 +319,14 @@ void OFDMProcessor::run()
         }
 notSynced:
         PROFILE(NotSynced);
+        if (discontinuity) {
+            std::clog << "ofdm-processor: " << "Input lost samples, resynchronising" << std::endl;
+        }
+        discontinuity = false;
+        if (synced) {
+            syncLosses.inc();
+            synced = false;
+        }
         if (scanMode && ++attempts > 5) {
             radioInterface.onSignalPresence(false);
             scanMode  = false;
@@ -319,10 +391,12 @@ notSynced:
         }
         /**
          * The end of the null period is identified, probably about 40
-         * samples earlier.
+         * samples earlier. Lost samples before that do not matter.
          */
+        discontinuity = false;
 SyncOnPhase:
         PROFILE(SyncOnPhase);
+        frameStartTime = metrics::thread_cpu_seconds();
         /**
          * We now have to find the exact first sample of the non-null period.
          * We use a correlation that will find the first sample after the
@@ -335,6 +409,9 @@ SyncOnPhase:
          * is part of the samples read.
          */
         getSamples(ofdmBuffer.data(), T_u, coarseCorrector + fineCorrector);
+        if (discontinuity) {
+            goto notSynced;
+        }
         //
         /// and then, call upon the phase synchronizer to verify/compute
         /// the real "first" sample
@@ -369,9 +446,13 @@ SyncOnPhase:
          * We read the missing samples in the ofdm buffer
          */
         radioInterface.onSyncChange(true);
+        synced = true;
         getSamples(&ofdmBuffer[ofdmBufferIndex],
                 T_u - ofdmBufferIndex,
                 coarseCorrector + fineCorrector);
+        if (discontinuity) {
+            goto notSynced;
+        }
 
         RadioReceiverOptions rro;
         {
@@ -380,7 +461,7 @@ SyncOnPhase:
         }
 
         std::vector<complexf> prs;
-        if (rro.decodeTII) {
+        if (rro.decodeTII and tiiFrameCount + 1 >= rro.tiiFrameInterval) {
             prs.resize(T_u);
             std::copy(ofdmBuffer.begin(), ofdmBuffer.begin() + T_u, prs.begin());
         }
@@ -434,9 +515,15 @@ SyncOnPhase:
          */
         DSPCOMPLEX FreqCorr = DSPCOMPLEX(0, 0);
         for (int sym = 1; sym < params.L; sym ++) {
-            auto& buf = allSymbols[sym];
+            // While scanning, the MSC symbols are only read to follow the
+            // frequency, the decoder gets the FIC symbols 1 to 3.
+            auto& buf = (ficOnly and sym >= 4) ? mscScratch : allSymbols[sym];
             buf.resize(T_s);
             getSamples(buf.data(), T_s, coarseCorrector + fineCorrector);
+            if (discontinuity) {
+                // Do not decode a frame with a gap in it
+                goto notSynced;
+            }
             for (int i = T_u; i < T_s; i ++)
                 FreqCorr += buf[i] * conj(buf[i - T_u]);
         }
@@ -461,7 +548,11 @@ SyncOnPhase:
         // The NULL is interesting to save because it carries the TII.
         std::vector<DSPCOMPLEX> nullSymbol(T_null);
         getSamples(nullSymbol.data(), T_null, coarseCorrector + fineCorrector);
-        if (rro.decodeTII) {
+        if (discontinuity) {
+            goto notSynced;
+        }
+        if (rro.decodeTII and ++tiiFrameCount >= rro.tiiFrameInterval) {
+            tiiFrameCount = 0;
             tiiDecoder.pushSymbols(nullSymbol, prs);
         }
 
@@ -487,6 +578,7 @@ SyncOnPhase:
         //ReadyForNewFrame:
         /// and off we go, up to the next frame
         PROFILE_FRAME_DECODED();
+        frameTime.observe(metrics::thread_cpu_seconds() - frameStartTime);
         goto SyncOnPhase;
     }
     catch (const NotRunningAnymore&) {
@@ -531,6 +623,37 @@ void OFDMProcessor::setReceiverOptions(const RadioReceiverOptions rro)
 void OFDMProcessor::set_scanMode(bool b)
 {
     scanMode = b;
+    ficOnly = b;
+}
+
+bool OFDMProcessor::precheckChannel()
+{
+    std::vector<DSPCOMPLEX> capture(scanPrecheck.totalSamples());
+
+    // getSamples() takes at most 32767 samples at once
+    auto read = [&](size_t from, size_t to) {
+        while (from < to) {
+            const int16_t n = std::min<size_t>(to - from, 16384);
+            getSamples(&capture[from], n, 0);
+            from += n;
+        }
+    };
+
+    // Most empty channels are already recognised by their spectrum
+    read(0, scanPrecheck.energySamples());
+    auto result = scanPrecheck.checkEnergy(capture.data());
+
+    if (result.energyFound) {
+        read(scanPrecheck.energySamples(), capture.size());
+        result = scanPrecheck.check(capture.data());
+    }
+
+    if (not result.signalPresent()) {
+        std::clog << "ofdm-processor: " << "Scan precheck found no ensemble (band ratio " <<
+            result.bandRatio << ", PRS ratio " << result.prsRatio << ")" << std::endl;
+        scanRejections.inc();
+    }
+    return result.signalPresent();
 }
 
 #define RANGE 36
@@ -39,14 +39,17 @@
 #include <mutex>
 #include <vector>
 #include "phasereference.h"
+#include "scan-precheck.h"
 #include "ofdm-decoder.h"
 #include "tii-decoder.h"
 #include "virtual_input.h"
+#include "resampler.h"
 #include "fft.h"
 #include "radio-controller.h"
 #include "radio-receiver-options.h"
 #include "fic-handler.h"
 #include "msc-handler.h"
+#include "various/metrics.h"
 
 class OFDMProcessor
 {
@@ -57,7 +60,8 @@ class OFDMProcessor
                 RadioControllerInterface& ri,
                 MscHandler& msc,
                 FicHandler& fic,
-                RadioReceiverOptions rro);
+                RadioReceiverOptions rro,
+                const std::string& metricsLabels = "");
         ~OFDMProcessor();
 
         /* Start or restart the OFDMProcessor */
@@ -66,6 +70,8 @@ class OFDMProcessor
         void stop();
         void resetCoarseCorrector();
         void setReceiverOptions(const RadioReceiverOptions rro);
+        /* In scan mode, signal the presence of an ensemble with
+         * onSignalPresence(), and decode only the FIC */
         void set_scanMode(bool);
 
     private:
@@ -75,6 +81,8 @@ class OFDMProcessor
         std::thread threadHandle;
         int32_t syncBufferIndex = 0;
         RadioControllerInterface& radioInterface;
+        // Brings inputs at other rates to INPUT_RATE
+        ResamplingInput resampledInput;
         InputInterface& input;
         const DABParams& params;
         FicHandler& ficHandler;
@@ -108,10 +116,32 @@ class OFDMProcessor
         std::vector<float> refArg;
 
         bool scanMode = false;
+        bool ficOnly = false;
         int attempts = 0;
+        int tiiFrameCount = 0;
+        ScanPrecheck scanPrecheck;
+        // Returns false if the channel is certainly empty
+        bool precheckChannel();
+
+        // Labelled with the metricsLabels given to the constructor
+        metrics::Counter& syncLosses;
+        metrics::Counter& scanRejections;
+        metrics::Counter& inputDiscontinuities;
+        metrics::Histogram& frameTime;
 
         int32_t bufferContent = 0;
 
+        // Set when the samples read reach those the input lost, the frame
+        // being decoded is then abandoned and the processor resynchronises.
+        // discontinuityAt is the position of the gap in the samples read
+        // so far, -1 if there is none ahead.
+        uint64_t discontinuityCount = 0;
+        int64_t samplesRead = 0;
+        int64_t discontinuityAt = -1;
+        bool discontinuity = false;
+        void checkDiscontinuity(void);
+        void advanceReadPosition(int32_t n);
+
         fft::Forward fft_handler;
         DSPCOMPLEX *fft_buffer; // of size T_u
 
@@ -0,0 +1,300 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "packet-decoder.h"
+#include "tools.h"
+#include <algorithm>
+#include <stdexcept>
+
+extern "C" {
+#include <fec.h>
+}
+
+using namespace std;
+
+constexpr uint16_t PacketDecoder::PADDING_ADDRESS;
+constexpr uint16_t PacketDecoder::FEC_ADDRESS;
+constexpr size_t PacketDecoder::UNIT_LENGTH;
+constexpr size_t PacketDecoder::FEC_ROWS;
+constexpr size_t PacketDecoder::ADT_COLUMNS;
+constexpr size_t PacketDecoder::RS_COLUMNS;
+constexpr size_t PacketDecoder::ADT_LENGTH;
+constexpr size_t PacketDecoder::RS_LENGTH;
+constexpr size_t PacketDecoder::FEC_PACKETS;
+constexpr size_t PacketDecoder::FEC_PACKET_HEADER;
+constexpr size_t PacketDecoder::MAX_DATA_GROUP;
+
+static uint16_t packet_address(const uint8_t *packet)
+{
+    return ((packet[0] & 0x03) << 8) | packet[1];
+}
+
+PacketDecoder::PacketDecoder(bool fec) :
+    fec(fec)
+{
+    if (fec) {
+        // RS(204, 188) is shortened from RS(255, 239)
+        rs_handle = init_rs_char(8, 0x11D, 0, 1,
+                RS_COLUMNS, 255 - ADT_COLUMNS - RS_COLUMNS);
+        if (not rs_handle) {
+            throw runtime_error("PacketDecoder: error while init_rs_char");
+        }
+        adt.reserve(ADT_LENGTH + UNIT_LENGTH);
+        rsData.reserve(FEC_PACKETS * (UNIT_LENGTH - FEC_PACKET_HEADER));
+    }
+}
+
+PacketDecoder::~PacketDecoder()
+{
+    if (rs_handle) {
+        free_rs_char(rs_handle);
+    }
+}
+
+void PacketDecoder::subscribe(uint16_t packetAddress, bool dataGroups,
+        PacketDataHandlerInterface& handler)
+{
+    auto& sub = subscriptions[packetAddress];
+    sub.handler = &handler;
+    sub.dataGroups = dataGroups;
+}
+
+void PacketDecoder::unsubscribe(uint16_t packetAddress)
+{
+    subscriptions.erase(packetAddress);
+}
+
+void PacketDecoder::process(const uint8_t *data, size_t len)
+{
+    if (not fec) {
+        parse(data, len);
+        return;
+    }
+
+    for (size_t pos = 0; pos + UNIT_LENGTH <= len; pos += UNIT_LENGTH) {
+        const uint8_t *unit = data + pos;
+
+        // Only the first unit of a packet carries a header
+        const bool packetStart = (unitsLeft == 0);
+        if (packetStart and packet_address(unit) == FEC_ADDRESS) {
+            rsData.insert(rsData.end(),
+                    unit + FEC_PACKET_HEADER, unit + UNIT_LENGTH);
+            if (++numFecPackets == FEC_PACKETS) {
+                decodeFecFrame();
+            }
+            continue;
+        }
+
+        if (packetStart) {
+            unitsLeft = (unit[0] >> 6) + 1;
+        }
+        unitsLeft--;
+
+        if (numFecPackets > 0) {
+            // The FEC packets of a frame are consecutive, some got lost
+            numFecPackets = 0;
+            rsData.clear();
+        }
+
+        // Until the FEC frames are found, the packets that cannot be
+        // part of the next application data table go out uncorrected.
+        adt.insert(adt.end(), unit, unit + UNIT_LENGTH);
+        if (adt.size() > ADT_LENGTH) {
+            parse(adt.data(), UNIT_LENGTH);
+            adt.erase(adt.begin(), adt.begin() + UNIT_LENGTH);
+        }
+    }
+}
+
+void PacketDecoder::decodeFecFrame()
+{
+    if (adt.size() == ADT_LENGTH) {
+        stats.fec_frames++;
+
+        // The tables are filled column by column, every row is
+        // one RS codeword.
+        uint8_t codeword[ADT_COLUMNS + RS_COLUMNS];
+        for (size_t row = 0; row < FEC_ROWS; row++) {
+            for (size_t col = 0; col < ADT_COLUMNS; col++) {
+                codeword[col] = adt[col * FEC_ROWS + row];
+            }
+            for (size_t col = 0; col < RS_COLUMNS; col++) {
+                codeword[ADT_COLUMNS + col] = rsData[col * FEC_ROWS + row];
+            }
+
+            const int corrected = decode_rs_char(rs_handle, codeword, nullptr, 0);
+            if (corrected < 0) {
+                stats.fec_uncorrectable_rows++;
+                continue;
+            }
+
+            stats.fec_corrected_bytes += corrected;
+            if (corrected > 0) {
+                for (size_t col = 0; col < ADT_COLUMNS; col++) {
+                    adt[col * FEC_ROWS + row] = codeword[col];
+                }
+            }
+        }
+    }
+
+    // An incomplete table at the start of the reception goes out as it is
+    parse(adt.data(), adt.size());
+    adt.clear();
+    rsData.clear();
+    numFecPackets = 0;
+    unitsLeft = 0;
+}
+
+void PacketDecoder::parse(const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+
+    if (pendingLength > 0) {
+        const size_t n = min(pendingLength - pending.size(), len);
+        pending.insert(pending.end(), data, data + n);
+        pos = n;
+
+        if (pending.size() < pendingLength) {
+            return;
+        }
+
+        handlePacket(pending.data(), pendingLength);
+        pending.clear();
+        pendingLength = 0;
+    }
+
+    while (pos + UNIT_LENGTH <= len) {
+        const size_t packetLength = ((data[pos] >> 6) + 1) * UNIT_LENGTH;
+
+        if (pos + packetLength > len) {
+            pending.assign(data + pos, data + len);
+            pendingLength = packetLength;
+            return;
+        }
+
+        handlePacket(data + pos, packetLength);
+        pos += packetLength;
+    }
+}
+
+void PacketDecoder::handlePacket(const uint8_t *packet, size_t len)
+{
+    const uint16_t address = packet_address(packet);
+    if (address == PADDING_ADDRESS) {
+        return;
+    }
+
+    auto it = subscriptions.find(address);
+    if (it == subscriptions.end()) {
+        return;
+    }
+    auto& sub = it->second;
+
+    stats.packets++;
+
+    const size_t crcPos = len - CalcCRC::CRCLen;
+    const uint16_t crcStored = (packet[crcPos] << 8) | packet[crcPos + 1];
+    const uint16_t crcCalced = CalcCRC::CalcCRC_CRC16_CCITT.Calc(packet, crcPos);
+
+    const size_t usefulLength = packet[2] & 0x7F;
+    if (crcStored != crcCalced or usefulLength > crcPos - 3) {
+        stats.crc_errors++;
+        if (sub.assembling) {
+            stats.data_group_errors++;
+            sub.assembling = false;
+        }
+        sub.expectedContinuity = -1;
+        return;
+    }
+
+    const int continuity = (packet[0] >> 4) & 0x03;
+    if (sub.expectedContinuity != -1 and continuity != sub.expectedContinuity) {
+        stats.continuity_errors++;
+        if (sub.assembling) {
+            stats.data_group_errors++;
+            sub.assembling = false;
+        }
+    }
+    sub.expectedContinuity = (continuity + 1) & 0x03;
+
+    const bool first = packet[0] & 0x08;
+    const bool last = packet[0] & 0x04;
+    const uint8_t *payload = packet + 3;
+
+    if (first) {
+        if (sub.assembling) {
+            stats.data_group_errors++;
+        }
+        sub.buffer.assign(payload, payload + usefulLength);
+        sub.assembling = true;
+    }
+    else if (sub.assembling) {
+        if (sub.buffer.size() + usefulLength > MAX_DATA_GROUP) {
+            stats.data_group_errors++;
+            sub.assembling = false;
+            return;
+        }
+        sub.buffer.insert(sub.buffer.end(), payload, payload + usefulLength);
+    }
+    else {
+        // Continuation of a data group whose start was missed
+        return;
+    }
+
+    if (last) {
+        sub.assembling = false;
+        deliver(address, sub);
+    }
+}
+
+void PacketDecoder::deliver(uint16_t packetAddress, Subscription& sub)
+{
+    vector<uint8_t> data;
+    data.swap(sub.buffer);
+
+    if (sub.dataGroups) {
+        if (data.size() < 2) {
+            stats.data_group_errors++;
+            return;
+        }
+
+        const bool hasCrc = data[0] & 0x40;
+        if (hasCrc) {
+            if (data.size() < 2 + CalcCRC::CRCLen) {
+                stats.data_group_errors++;
+                return;
+            }
+            const size_t crcPos = data.size() - CalcCRC::CRCLen;
+            const uint16_t crcStored = (data[crcPos] << 8) | data[crcPos + 1];
+            if (crcStored != CalcCRC::CalcCRC_CRC16_CCITT.Calc(data.data(), crcPos)) {
+                stats.data_group_errors++;
+                return;
+            }
+        }
+    }
+
+    stats.data_groups++;
+    sub.handler->onDataGroup(packetAddress, move(data));
+}
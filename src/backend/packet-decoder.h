@@ -0,0 +1,127 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "radio-controller.h"
+
+/* Demultiplexes the packets of a packet mode subchannel, see
+ * ETSI EN 300 401 clause 5.3.2, and reassembles the data groups of
+ * the subscribed packet addresses. Packets of other addresses are
+ * skipped without even checking their CRC.
+ *
+ * With the outer FEC of clause 5.3.5, the packets are collected into
+ * the 12 x 188 bytes application data table, which is corrected with
+ * the RS(204, 188) parity carried in the nine FEC packets following it.
+ * As long as the decoder is not synchronised to the FEC frames, the
+ * packets are passed on uncorrected.
+ *
+ * Not thread-safe, the caller serialises subscriptions and process(). */
+class PacketDecoder {
+    public:
+        static constexpr uint16_t PADDING_ADDRESS = 0;
+        static constexpr uint16_t FEC_ADDRESS = 1022;
+
+        // Packet lengths are multiples of 24 bytes
+        static constexpr size_t UNIT_LENGTH = 24;
+
+        static constexpr size_t FEC_ROWS = 12;
+        static constexpr size_t ADT_COLUMNS = 188;
+        static constexpr size_t RS_COLUMNS = 16;
+        static constexpr size_t ADT_LENGTH = FEC_ROWS * ADT_COLUMNS;
+        static constexpr size_t RS_LENGTH = FEC_ROWS * RS_COLUMNS;
+        static constexpr size_t FEC_PACKETS = 9;
+        static constexpr size_t FEC_PACKET_HEADER = 2;
+
+        // Longest data group, header and CRC included
+        static constexpr size_t MAX_DATA_GROUP = 8192 + 16;
+
+        struct Stats {
+            // Packets of subscribed addresses
+            size_t packets = 0;
+            size_t crc_errors = 0;
+            size_t continuity_errors = 0;
+
+            size_t data_groups = 0;
+            // Data groups with a wrong CRC or missing packets
+            size_t data_group_errors = 0;
+
+            size_t fec_frames = 0;
+            size_t fec_corrected_bytes = 0;
+            size_t fec_uncorrectable_rows = 0;
+        };
+
+        explicit PacketDecoder(bool fec);
+        ~PacketDecoder();
+        PacketDecoder(const PacketDecoder&) = delete;
+        PacketDecoder& operator=(const PacketDecoder&) = delete;
+
+        // dataGroups is false for components whose DG flag is set,
+        // for them the packet data are not checked any further.
+        void subscribe(uint16_t packetAddress, bool dataGroups,
+                PacketDataHandlerInterface& handler);
+        void unsubscribe(uint16_t packetAddress);
+        bool hasSubscriptions() const { return not subscriptions.empty(); }
+
+        // Feed the bytes of the subchannel, len must be a multiple of
+        // UNIT_LENGTH.
+        void process(const uint8_t *data, size_t len);
+
+        const Stats& getStats() const { return stats; }
+
+    private:
+        struct Subscription {
+            PacketDataHandlerInterface *handler = nullptr;
+            bool dataGroups = true;
+            int expectedContinuity = -1;
+            bool assembling = false;
+            std::vector<uint8_t> buffer;
+        };
+
+        void decodeFecFrame();
+        void parse(const uint8_t *data, size_t len);
+        void handlePacket(const uint8_t *packet, size_t len);
+        void deliver(uint16_t packetAddress, Subscription& sub);
+
+        const bool fec;
+        void *rs_handle = nullptr;
+
+        std::map<uint16_t, Subscription> subscriptions;
+
+        // Start of a packet that continues in the next call of parse()
+        std::vector<uint8_t> pending;
+        size_t pendingLength = 0;
+
+        std::vector<uint8_t> adt;
+        std::vector<uint8_t> rsData;
+        size_t numFecPackets = 0;
+        // Units of the current packet still to come
+        size_t unitsLeft = 0;
+
+        Stats stats;
+};
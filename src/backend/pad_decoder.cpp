@@ -164,8 +164,9 @@ void PADDecoder::Process(const uint8_t *xpad_data, size_t xpad_len, bool exact_x
 
 				// if new Data Group available, append it
 				if(mot_decoder.ProcessDataSubfield(start, xpad + xpad_offset, xpad_ci.len)) {
-					// if new slide available, show it
-					if(mot_manager.HandleMOTDataGroup(mot_decoder.GetMOTDataGroup())) {
+					// if new slides available, show them
+					mot_manager.HandleMOTDataGroup(mot_decoder.GetMOTDataGroup());
+					while(mot_manager.HasFile()) {
 						const MOT_FILE new_slide = mot_manager.GetFile();
 
 						// check file type
@@ -62,6 +62,8 @@ struct tii_measurement_t {
     int pattern = 0;
     float error = 0;
     int delay_samples = 0;
+    // Power of the TII carriers relative to the PRS carriers, in dB
+    float level_db = 0;
 
     float getDelayKm(void) const;
 };
@@ -212,6 +214,20 @@ class ProgrammeHandlerInterface {
         virtual void onPADLengthError(size_t announced_xpad_len, size_t xpad_len) = 0;
 };
 
+/* Definition of the interface the consumers of a packet mode service
+ * component must implement, see RadioReceiver::addPacketDataToDecode. */
+class PacketDataHandlerInterface {
+    public:
+        virtual ~PacketDataHandlerInterface() { }
+
+        /* An MSC data group was received on the packet address. data
+         * contains the data group header and the CRC, if present, which
+         * was checked. For components without data groups, the data of
+         * the reassembled packets are given instead.
+         * Called from the data decoder thread. */
+        virtual void onDataGroup(uint16_t packetAddress, std::vector<uint8_t>&& data) = 0;
+};
+
 enum class DeviceParam {
     BiasTee,
     SoapySDRAntenna,
@@ -238,6 +254,22 @@ public:
     virtual void setAgc(bool agc) = 0;
     virtual std::string getDescription(void) = 0;
 
+    // The rate of the samples given by getSamples(). The OFDM processor
+    // resamples inputs that are not at INPUT_RATE. Devices able to
+    // capture several ensembles at once for a CChannelizer accept other
+    // rates, to be set before restart().
+    virtual int getSampleRate(void) const { return INPUT_RATE; }
+    virtual bool setSampleRate(int rate) { return rate == INPUT_RATE; }
+
+    // Incremented every time samples were lost between the device and
+    // getSamples(), i.e. the sample stream is not contiguous any more
+    virtual uint64_t getDiscontinuityCount(void) const { return 0; }
+
+    // The number of samples getSamples() still gives before the ones that
+    // follow the last discontinuity: the samples buffered when samples
+    // were lost are contiguous. 0 if the input cannot tell.
+    virtual int64_t getSamplesBeforeDiscontinuity(void) { return 0; }
+
     virtual bool setDeviceParam(DeviceParam param, int value) {
         (void)param; (void)value;
         return false;
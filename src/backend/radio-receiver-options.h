@@ -74,6 +74,10 @@ struct RadioReceiverOptions {
     // consumes CPU resources.
     bool decodeTII = false;
 
+    // Give only every Nth frame to the TII decoder. The TII of a transmitter
+    // does not change, and the decoder averages over several frames anyway.
+    int tiiFrameInterval = 1;
+
     // Good receivers with accurate clocks do not need the coarse corrector.
     // Disabling it can accelerate lock.
     bool disableCoarseCorrector = false;
@@ -33,7 +33,10 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include "radio-receiver.h"
+#include "various/channels.h"
+#include "various/metrics.h"
 
 using namespace std;
 
@@ -63,27 +66,50 @@ const char* freqSyncMethodToString(FreqsyncMethod method)
     throw std::logic_error("Unhandled freqsyncMethod placement");
 }
 
+static string channel_labels(const InputInterface& input)
+{
+    const int frequency = input.getFrequency();
+    if (frequency <= 0) {
+        return "";
+    }
+
+    string channel;
+    try {
+        channel = Channels().getChannelForFrequency(frequency);
+    }
+    catch (const out_of_range&) {
+        channel = to_string(frequency);
+    }
+    return metrics::label("channel", channel);
+}
+
 RadioReceiver::RadioReceiver(
                 RadioControllerInterface& rci,
                 InputInterface& input,
                 RadioReceiverOptions rro,
                 int transmission_mode) :
     params(transmission_mode),
-    mscHandler(params, false),
-    ficHandler(rci),
+    metricsLabels(channel_labels(input)),
+    mscHandler(params, false, metricsLabels),
+    ficHandler(rci, metricsLabels),
     ofdmProcessor(input,
         params,
         rci,
         mscHandler,
         ficHandler,
-        rro)
+        rro,
+        metricsLabels)
 { }
 
-void RadioReceiver::restart(bool doScan)
+void RadioReceiver::restart(bool doScan,
+        shared_ptr<const EnsembleSnapshot> cached)
 {
     ofdmProcessor.set_scanMode(doScan);
     mscHandler.stopProcessing();
     ficHandler.clearEnsemble();
+    if (cached) {
+        ficHandler.fibProcessor.setProvisionalEnsemble(*cached);
+    }
     ofdmProcessor.restart();
 }
 
@@ -111,6 +137,7 @@ void RadioReceiver::setReceiverOptions(const RadioReceiverOptions rro)
 
     clog << "New Receiver Options: " <<
         "TII: " << rro.decodeTII <<
+        " TII interval: " << rro.tiiFrameInterval <<
         " disable coarse corr: " << rro.disableCoarseCorrector <<
         " freqsync: " << fsm <<
         " fft placement: " << fftPlacementMethodToString(rro.fftPlacementMethod) << endl;
@@ -131,10 +158,10 @@ bool RadioReceiver::addServiceToDecode(ProgrammeHandlerInterface& handler,
 
 bool RadioReceiver::removeServiceToDecode(const Service& s)
 {
-    const auto comps = ficHandler.fibProcessor.getComponents(s);
-    for (const auto& sc : comps) {
+    const auto ensemble = getEnsemble();
+    for (const auto& sc : ensemble->getComponents(s.serviceId)) {
         if (sc.transportMode() == TransportMode::Audio) {
-            const auto& subch = ficHandler.fibProcessor.getSubchannel(sc);
+            const auto& subch = ensemble->getSubchannel(sc.subchannelId);
             if (subch.valid()) {
                 return mscHandler.removeSubchannel(subch);
             }
@@ -143,13 +170,39 @@ bool RadioReceiver::removeServiceToDecode(const Service& s)
     return false;
 }
 
+bool RadioReceiver::addPacketDataToDecode(PacketDataHandlerInterface& handler,
+        const ServiceComponent& sc)
+{
+    if (sc.transportMode() != TransportMode::PacketData) {
+        return false;
+    }
+
+    const auto subch = getSubchannel(sc);
+    if (not subch.valid()) {
+        return false;
+    }
+
+    // The DG flag is set for components without data groups
+    return mscHandler.addPacketComponent(
+            handler, subch, sc.packetAddress, sc.DGflag == 0);
+}
+
+bool RadioReceiver::removePacketDataToDecode(const ServiceComponent& sc)
+{
+    const auto subch = getSubchannel(sc);
+    if (not subch.valid()) {
+        return false;
+    }
+    return mscHandler.removePacketComponent(subch, sc.packetAddress);
+}
+
 bool RadioReceiver::playProgramme(ProgrammeHandlerInterface& handler,
         const Service& s, const std::string& dumpFileName, bool unique)
 {
-    const auto comps = ficHandler.fibProcessor.getComponents(s);
-    for (const auto& sc : comps) {
+    const auto ensemble = getEnsemble();
+    for (const auto& sc : ensemble->getComponents(s.serviceId)) {
         if (sc.transportMode() == TransportMode::Audio) {
-            const auto& subch = ficHandler.fibProcessor.getSubchannel(sc);
+            const auto& subch = ensemble->getSubchannel(sc.subchannelId);
 
             if (subch.valid()) {
                 if (unique) {
@@ -169,6 +222,11 @@ bool RadioReceiver::playProgramme(ProgrammeHandlerInterface& handler,
     return false;
 }
 
+std::shared_ptr<const EnsembleSnapshot> RadioReceiver::getEnsemble(void) const
+{
+    return ficHandler.fibProcessor.getEnsemble();
+}
+
 uint16_t RadioReceiver::getEnsembleId(void) const
 {
     return ficHandler.fibProcessor.getEnsembleId();
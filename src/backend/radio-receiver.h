@@ -58,8 +58,10 @@ class RadioReceiver {
                 int transmission_mode = 1);
 
         /* Restart the receiver, and specify if we want
-         * to scan or receive. */
-        void restart(bool doScan);
+         * to scan or receive. The ensemble database starts with
+         * the cached ensemble if one is given, see EnsembleCache. */
+        void restart(bool doScan,
+                std::shared_ptr<const EnsembleSnapshot> cached = nullptr);
 
         /* Keep the demodulator running, but clear the data
          * decoders (both FIC and MSC) */
@@ -80,6 +82,18 @@ class RadioReceiver {
 
         bool removeServiceToDecode(const Service& s);
 
+        /* Decode the packet mode service component sc, and give its
+         * data groups to the handler. Returns false if the component
+         * is not in packet mode or its subchannel is not known yet. */
+        bool addPacketDataToDecode(PacketDataHandlerInterface& handler,
+                const ServiceComponent& sc);
+
+        bool removePacketDataToDecode(const ServiceComponent& sc);
+
+        /* Consistent view of the whole ensemble, which does not change
+         * while it is held. Cheap to get, never nullptr. */
+        std::shared_ptr<const EnsembleSnapshot> getEnsemble(void) const;
+
         uint16_t getEnsembleId(void) const;
         uint8_t getEnsembleEcc(void) const;
         DabLabel getEnsembleLabel(void) const;
@@ -110,6 +124,10 @@ class RadioReceiver {
 
         DABParams params; // Defaults to TM1 parameters
 
+        // Several receivers can run in one process, their metrics are
+        // labelled with the channel the input is tuned to
+        const std::string metricsLabels;
+
         MscHandler mscHandler;
         FicHandler ficHandler;
         OFDMProcessor ofdmProcessor;
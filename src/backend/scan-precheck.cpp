@@ -0,0 +1,210 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "scan-precheck.h"
+#include "phasetable.h"
+#include "MathHelper.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+constexpr float ScanPrecheck::MIN_BAND_RATIO;
+constexpr float ScanPrecheck::MIN_PRS_RATIO;
+
+// Periodograms averaged by the energy test
+static const int ENERGY_SEGMENTS = 4;
+
+// Bin of the FFT of size fft_size at a frequency
+static int frequencyToBin(int frequency, int fft_size)
+{
+    return (int)((int64_t)frequency * fft_size / INPUT_RATE);
+}
+
+static float median(vector<float>& v)
+{
+    if (v.empty()) {
+        return 0;
+    }
+    auto middle = v.begin() + v.size() / 2;
+    nth_element(v.begin(), middle, v.end());
+    return *middle;
+}
+
+ScanPrecheck::ScanPrecheck(const DABParams& params) :
+    T_u(params.T_u),
+    T_g(params.guardLength),
+    T_null(params.T_null),
+    T_F(params.T_F),
+    K(params.K),
+    refTable(params.T_u),
+    power(params.T_u),
+    fft_handler(params.T_u),
+    fft_buffer(fft_handler.getVector()),
+    ifft_handler(params.T_u),
+    ifft_buffer(ifft_handler.getVector())
+{
+    // The guard band ends before the carriers of the next channel,
+    // 1712 kHz away
+    bandEnd = K / 2;
+    guardStart = bandEnd + frequencyToBin(12000, T_u);
+    guardEnd = frequencyToBin(930000, T_u);
+    maxOffset = frequencyToBin(35000, T_u);
+
+    PhaseTable phaseTable(params.dabMode);
+    for (int k = 1; k <= K / 2; k++) {
+        const float phi_pos = phaseTable.get_Phi(k);
+        refTable[k] = DSPCOMPLEX(cos(phi_pos), sin(phi_pos));
+
+        const float phi_neg = phaseTable.get_Phi(-k);
+        refTable[T_u - k] = DSPCOMPLEX(cos(phi_neg), sin(phi_neg));
+    }
+}
+
+size_t ScanPrecheck::energySamples() const
+{
+    return ENERGY_SEGMENTS * T_u;
+}
+
+size_t ScanPrecheck::totalSamples() const
+{
+    // The NULL symbol may start anywhere in the first frame
+    return max<size_t>(energySamples(), T_F + T_null + T_g + T_u);
+}
+
+ScanPrecheck::Result ScanPrecheck::checkEnergy(const DSPCOMPLEX *samples)
+{
+    Result r;
+    r.bandRatio = bandRatio(samples);
+    r.energyFound = r.bandRatio >= MIN_BAND_RATIO;
+    return r;
+}
+
+ScanPrecheck::Result ScanPrecheck::check(const DSPCOMPLEX *samples)
+{
+    Result r = checkEnergy(samples);
+    if (r.energyFound) {
+        r.prsRatio = prsRatio(samples);
+        r.prsFound = r.prsRatio >= MIN_PRS_RATIO;
+    }
+    return r;
+}
+
+float ScanPrecheck::bandRatio(const DSPCOMPLEX *samples)
+{
+    fill(power.begin(), power.end(), 0.0f);
+    for (int seg = 0; seg < ENERGY_SEGMENTS; seg++) {
+        memcpy(fft_buffer, samples + seg * T_u, T_u * sizeof(DSPCOMPLEX));
+        fft_handler.do_FFT();
+        for (int i = 0; i < T_u; i++) {
+            power[i] += norm(fft_buffer[i]);
+        }
+    }
+
+    // Medians, so that a spur or a carrier of a neighbour does not
+    // decide. Leave out the bins next to DC, where the local
+    // oscillator leaks.
+    scratch.clear();
+    for (int k = 3; k <= bandEnd; k++) {
+        scratch.push_back(power[k]);
+        scratch.push_back(power[T_u - k]);
+    }
+    const float band = median(scratch);
+
+    scratch.assign(power.begin() + guardStart, power.begin() + guardEnd + 1);
+    const float guard_high = median(scratch);
+    scratch.assign(power.begin() + T_u - guardEnd, power.begin() + T_u - guardStart + 1);
+    const float guard_low = median(scratch);
+
+    // One clean guard band is enough, the other one may be
+    // covered by a strong neighbour
+    const float guard = min(guard_low, guard_high);
+    if (guard <= 0) {
+        return band > 0 ? MIN_BAND_RATIO * 1000 : 0;
+    }
+    return band / guard;
+}
+
+float ScanPrecheck::prsRatio(const DSPCOMPLEX *samples)
+{
+    // Find the NULL symbol, the weakest T_null samples of the frame
+    float sum = 0;
+    for (int i = 0; i < T_null; i++) {
+        sum += l1_norm(samples[i]);
+    }
+
+    float total = sum;
+    float min_sum = sum;
+    int null_start = 0;
+    for (int i = 1; i < T_F; i++) {
+        const float next = l1_norm(samples[i + T_null - 1]);
+        sum += next - l1_norm(samples[i - 1]);
+        total += next;
+        if (sum < min_sum) {
+            min_sum = sum;
+            null_start = i;
+        }
+    }
+
+    // No dip at all. Tolerate more noise in the NULL symbol than the
+    // OFDMProcessor, the correlation decides.
+    const float mean = total / (T_F + T_null - 1);
+    if (min_sum / T_null > 0.75f * mean) {
+        return 0;
+    }
+
+    // Take the useful part of the phase reference symbol, starting in
+    // the middle of its guard interval to tolerate an imprecise start
+    const int prs_start = null_start + T_null + T_g / 2;
+    memcpy(fft_buffer, samples + prs_start, T_u * sizeof(DSPCOMPLEX));
+    fft_handler.do_FFT();
+
+    // Correlate with the phase reference at every coarse offset the
+    // OFDMProcessor can correct, the peak stands out only at the right one.
+    float best = 0;
+    for (int offset = -maxOffset; offset <= maxOffset; offset++) {
+        fill(ifft_buffer, ifft_buffer + T_u, DSPCOMPLEX(0, 0));
+        for (int k = 1; k <= K / 2; k++) {
+            const int pos = k;
+            const int neg = T_u - k;
+            ifft_buffer[pos] = fft_buffer[(pos + offset + T_u) % T_u] * conj(refTable[pos]);
+            ifft_buffer[neg] = fft_buffer[(neg + offset + T_u) % T_u] * conj(refTable[neg]);
+        }
+        ifft_handler.do_IFFT();
+
+        float peak = 0;
+        float level = 0;
+        for (int i = 0; i < T_u; i++) {
+            const float value = abs(ifft_buffer[i]);
+            level += value;
+            peak = max(peak, value);
+        }
+
+        if (level > 0) {
+            best = max(best, peak * T_u / level);
+        }
+    }
+    return best;
+}
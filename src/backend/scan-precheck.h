@@ -0,0 +1,101 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "dab-constants.h"
+#include "fft.h"
+
+/* Decides from a short capture whether a channel can carry an ensemble,
+ * long before the synchronisation of the OFDMProcessor gives up. Used
+ * when scanning, to reject the empty channels quickly.
+ *
+ * Two tests, the cheap one first:
+ *  - Energy: the power in the band of the carriers must exceed the
+ *    power just outside of it. Needs a few milliseconds of samples.
+ *  - Correlation: the capture must contain a NULL symbol followed by a
+ *    phase reference symbol, within the range of the coarse frequency
+ *    corrector. Needs a bit more than a transmission frame. */
+class ScanPrecheck {
+    public:
+        struct Result {
+            // Median power in the band of the carriers over the one
+            // between the band edge and the next channel
+            float bandRatio = 0;
+            // Peak of the correlation with the phase reference symbol
+            // over its mean, 0 if the test was not run
+            float prsRatio = 0;
+
+            bool energyFound = false;
+            bool prsFound = false;
+
+            bool signalPresent() const { return energyFound and prsFound; }
+        };
+
+        explicit ScanPrecheck(const DABParams& params);
+        ScanPrecheck(const ScanPrecheck&) = delete;
+        ScanPrecheck& operator=(const ScanPrecheck&) = delete;
+
+        // Samples needed by checkEnergy(), and by check()
+        size_t energySamples() const;
+        size_t totalSamples() const;
+
+        // Only the energy test, on energySamples() samples
+        Result checkEnergy(const DSPCOMPLEX *samples);
+
+        // Both tests on totalSamples() samples, the correlation only
+        // if the energy test passed
+        Result check(const DSPCOMPLEX *samples);
+
+        static constexpr float MIN_BAND_RATIO = 1.5f;
+        static constexpr float MIN_PRS_RATIO = 6.0f;
+
+    private:
+        float bandRatio(const DSPCOMPLEX *samples);
+        float prsRatio(const DSPCOMPLEX *samples);
+
+        const int T_u;
+        const int T_g;
+        const int T_null;
+        const int T_F;
+        const int K;
+
+        // Bins of the carriers, and of the guard bands on either side
+        int bandEnd;
+        int guardStart;
+        int guardEnd;
+        // Coarse frequency offsets tried by the correlation, in carriers
+        int maxOffset;
+
+        std::vector<DSPCOMPLEX> refTable;
+        std::vector<float> power;
+        std::vector<float> scratch;
+
+        fft::Forward fft_handler;
+        DSPCOMPLEX *fft_buffer;
+        fft::Backward ifft_handler;
+        DSPCOMPLEX *ifft_buffer;
+};
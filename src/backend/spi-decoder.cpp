@@ -0,0 +1,543 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "spi-decoder.h"
+
+using namespace std;
+
+constexpr int SpiDecoder::CONTENT_TYPE;
+constexpr int SpiDecoder::CONTENT_SUB_TYPE_SI;
+constexpr int SpiDecoder::CONTENT_SUB_TYPE_PI;
+constexpr int SpiDecoder::CONTENT_SUB_TYPE_GI;
+constexpr size_t SpiDecoder::NUM_TOKENS;
+
+// Element tags, TS 102 371 clause 4.6
+static const uint8_t TAG_CDATA = 0x01;
+static const uint8_t TAG_EPG = 0x02;
+static const uint8_t TAG_SERVICE_INFORMATION = 0x03;
+static const uint8_t TAG_TOKEN_TABLE = 0x04;
+static const uint8_t TAG_SHORT_NAME = 0x10;
+static const uint8_t TAG_MEDIUM_NAME = 0x11;
+static const uint8_t TAG_LONG_NAME = 0x12;
+static const uint8_t TAG_MEDIA_DESCRIPTION = 0x13;
+static const uint8_t TAG_GENRE = 0x14;
+static const uint8_t TAG_LOCATION = 0x19;
+static const uint8_t TAG_SHORT_DESCRIPTION = 0x1A;
+static const uint8_t TAG_LONG_DESCRIPTION = 0x1B;
+static const uint8_t TAG_PROGRAMME = 0x1C;
+static const uint8_t TAG_SCHEDULE = 0x21;
+static const uint8_t TAG_SCOPE = 0x24;
+static const uint8_t TAG_SERVICE_SCOPE = 0x25;
+static const uint8_t TAG_SERVICE = 0x28;
+static const uint8_t TAG_SERVICE_ID = 0x29;
+static const uint8_t TAG_TIME = 0x2C;
+static const uint8_t TAG_BEARER = 0x2D;
+
+// Attribute tags, their meaning depends on the element
+static const uint8_t ATTR_PROGRAMME_ID = 0x80;
+static const uint8_t ATTR_PROGRAMME_SHORT_ID = 0x81;
+static const uint8_t ATTR_SCOPE_START_TIME = 0x80;
+static const uint8_t ATTR_SCOPE_STOP_TIME = 0x81;
+static const uint8_t ATTR_TIME_TIME = 0x80;
+static const uint8_t ATTR_TIME_DURATION = 0x81;
+static const uint8_t ATTR_TIME_ACTUAL_TIME = 0x82;
+static const uint8_t ATTR_TIME_ACTUAL_DURATION = 0x83;
+static const uint8_t ATTR_ID = 0x80;
+static const uint8_t ATTR_GENRE_HREF = 0x80;
+
+// Modified Julian Date of 1970-01-01
+static const uint32_t MJD_UNIX_EPOCH = 40587;
+
+static uint32_t read_uint(const uint8_t *data, size_t len)
+{
+    uint32_t v = 0;
+    for (size_t i = 0; i < len and i < 4; i++) {
+        v = (v << 8) | data[i];
+    }
+    return v;
+}
+
+void SpiDescription::clear()
+{
+    short_name.clear();
+    medium_name.clear();
+    long_name.clear();
+    short_description.clear();
+    long_description.clear();
+    genres.clear();
+}
+
+const string& SpiDescription::name() const
+{
+    if (not long_name.empty()) {
+        return long_name;
+    }
+    if (not medium_name.empty()) {
+        return medium_name;
+    }
+    return short_name;
+}
+
+bool SpiDecoder::Reader::next(Element& e)
+{
+    if (p == end) {
+        return false;
+    }
+
+    const size_t available = end - p;
+    size_t header_len = 2;
+    size_t len = available >= 2 ? p[1] : 0;
+    if (len == 0xFE) {
+        header_len = 4;
+        len = available >= 4 ? read_uint(p + 2, 2) : 0;
+    }
+    else if (len == 0xFF) {
+        header_len = 5;
+        len = available >= 5 ? read_uint(p + 2, 3) : 0;
+    }
+
+    if (available < header_len or available - header_len < len) {
+        is_damaged = true;
+        p = end;
+        return false;
+    }
+
+    e.tag = p[0];
+    e.data = p + header_len;
+    e.len = len;
+    p += header_len + len;
+    return true;
+}
+
+bool SpiDecoder::decodeTime(const uint8_t *data, size_t len, time_t& t)
+{
+    if (len < 4) {
+        return false;
+    }
+
+    // rfu (1), MJD (17), rfu (1), LTO flag (1), UTC flag (1),
+    // hours (5), minutes (6), [seconds (6), milliseconds (10)], [LTO (8)]
+    const uint32_t v = read_uint(data, 4);
+    const uint32_t mjd = (v >> 14) & 0x1FFFF;
+    const bool long_form = (v >> 11) & 0x01;
+    const uint32_t hours = (v >> 6) & 0x1F;
+    const uint32_t minutes = v & 0x3F;
+    uint32_t seconds = 0;
+    if (long_form) {
+        if (len < 6) {
+            return false;
+        }
+        seconds = data[4] >> 2;
+    }
+
+    if (mjd < MJD_UNIX_EPOCH or hours > 23 or minutes > 59 or seconds > 60) {
+        return false;
+    }
+
+    // The local time offset only matters for display, the time is UTC
+    t = (time_t)(mjd - MJD_UNIX_EPOCH) * 86400 +
+        hours * 3600 + minutes * 60 + seconds;
+    return true;
+}
+
+bool SpiDecoder::decodeContentId(const uint8_t *data, size_t len,
+        uint32_t& service_id)
+{
+    if (len < 1) {
+        return false;
+    }
+
+    // rfu (1), ensemble flag (1), X-PAD flag (1), SId flag (1), SCIdS (4)
+    const bool ensemble_flag = data[0] & 0x40;
+    const bool long_sid = data[0] & 0x10;
+    size_t offset = 1;
+    if (ensemble_flag) {
+        offset += 3;    // ECC and EId
+    }
+
+    const size_t sid_len = long_sid ? 4 : 2;
+    if (len < offset + sid_len) {
+        return false;
+    }
+    service_id = read_uint(data + offset, sid_len);
+    return service_id != 0;
+}
+
+string SpiDecoder::decodeGenre(const uint8_t *data, size_t len)
+{
+    // rfu (4), classification scheme (4), then one byte per term level
+    if (len < 2 or (data[0] & 0x0F) == 0) {
+        return "";
+    }
+
+    string genre = to_string(data[0] & 0x0F);
+    for (size_t i = 1; i < len; i++) {
+        genre += '.';
+        genre += to_string(data[i]);
+    }
+    return genre;
+}
+
+void SpiDecoder::readTokenTable(const Element& e)
+{
+    // Token ID (8), length (8), string
+    for (size_t offset = 0; offset + 2 <= e.len;) {
+        const uint8_t id = e.data[offset];
+        const size_t len = e.data[offset + 1];
+        offset += 2;
+        if (offset + len > e.len) {
+            break;
+        }
+
+        if (id < NUM_TOKENS) {
+            tokens[id].assign((const char*)e.data + offset, len);
+        }
+        offset += len;
+    }
+}
+
+void SpiDecoder::readString(const Element& e, string& s)
+{
+    s.clear();
+    for (size_t i = 0; i < e.len; i++) {
+        const uint8_t c = e.data[i];
+        if (c < NUM_TOKENS) {
+            s += tokens[c];
+        }
+        else {
+            s += (char)c;
+        }
+    }
+}
+
+void SpiDecoder::readText(const Element& e, string& s)
+{
+    // Only the first of the names in several languages is kept
+    if (not s.empty()) {
+        return;
+    }
+
+    Reader r(e);
+    Element c;
+    while (r.next(c)) {
+        if (c.tag == TAG_CDATA) {
+            readString(c, s);
+            return;
+        }
+    }
+}
+
+bool SpiDecoder::readDescription(const Element& child, SpiDescription& d)
+{
+    switch (child.tag) {
+        case TAG_SHORT_NAME:
+            readText(child, d.short_name);
+            return true;
+        case TAG_MEDIUM_NAME:
+            readText(child, d.medium_name);
+            return true;
+        case TAG_LONG_NAME:
+            readText(child, d.long_name);
+            return true;
+        case TAG_MEDIA_DESCRIPTION:
+        {
+            Reader r(child);
+            Element c;
+            while (r.next(c)) {
+                if (c.tag == TAG_SHORT_DESCRIPTION) {
+                    readText(c, d.short_description);
+                }
+                else if (c.tag == TAG_LONG_DESCRIPTION) {
+                    readText(c, d.long_description);
+                }
+            }
+            return true;
+        }
+        case TAG_GENRE:
+        {
+            Reader r(child);
+            Element c;
+            while (r.next(c)) {
+                if (c.tag == ATTR_GENRE_HREF) {
+                    auto genre = decodeGenre(c.data, c.len);
+                    if (not genre.empty()) {
+                        d.genres.push_back(move(genre));
+                    }
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void SpiDecoder::readLocation(const Element& e, SpiProgramme& p, bool& has_time)
+{
+    // A programme broadcast several times has several
+    // locations, the first time is kept.
+    Reader r(e);
+    Element c;
+    while (r.next(c)) {
+        if (c.tag == TAG_TIME and not has_time) {
+            bool has_actual_time = false;
+            bool has_actual_duration = false;
+
+            Reader tr(c);
+            Element a;
+            while (tr.next(a)) {
+                time_t t = 0;
+                switch (a.tag) {
+                    case ATTR_TIME_TIME:
+                        if (not has_actual_time and decodeTime(a.data, a.len, t)) {
+                            p.start = t;
+                            has_time = true;
+                        }
+                        break;
+                    case ATTR_TIME_ACTUAL_TIME:
+                        if (decodeTime(a.data, a.len, t)) {
+                            p.start = t;
+                            has_time = true;
+                            has_actual_time = true;
+                        }
+                        break;
+                    case ATTR_TIME_DURATION:
+                        if (not has_actual_duration) {
+                            p.duration = read_uint(a.data, a.len);
+                        }
+                        break;
+                    case ATTR_TIME_ACTUAL_DURATION:
+                        p.duration = read_uint(a.data, a.len);
+                        has_actual_duration = true;
+                        break;
+                }
+            }
+        }
+        else if (c.tag == TAG_BEARER and p.service_id == 0) {
+            Reader br(c);
+            Element a;
+            while (br.next(a)) {
+                if (a.tag == ATTR_ID) {
+                    decodeContentId(a.data, a.len, p.service_id);
+                }
+            }
+        }
+    }
+}
+
+bool SpiDecoder::readProgramme(const Element& e, SpiProgramme& p)
+{
+    p.clear();
+    p.service_id = 0;
+    p.start = 0;
+    p.duration = 0;
+    p.id.clear();
+    p.short_id = 0;
+
+    bool has_time = false;
+
+    Reader r(e);
+    Element c;
+    while (r.next(c)) {
+        if (readDescription(c, p)) {
+            continue;
+        }
+
+        switch (c.tag) {
+            case ATTR_PROGRAMME_ID:
+                readString(c, p.id);
+                break;
+            case ATTR_PROGRAMME_SHORT_ID:
+                p.short_id = read_uint(c.data, c.len);
+                break;
+            case TAG_LOCATION:
+                readLocation(c, p, has_time);
+                break;
+        }
+    }
+
+    return has_time and not r.damaged();
+}
+
+bool SpiDecoder::readSchedule(const Element& e, Schedule& schedule,
+        size_t& num_programmes)
+{
+    Reader r(e);
+    Element c;
+    while (r.next(c)) {
+        if (c.tag == TAG_SCOPE) {
+            Reader sr(c);
+            Element a;
+            while (sr.next(a)) {
+                switch (a.tag) {
+                    case ATTR_SCOPE_START_TIME:
+                        decodeTime(a.data, a.len, schedule.start);
+                        break;
+                    case ATTR_SCOPE_STOP_TIME:
+                        decodeTime(a.data, a.len, schedule.stop);
+                        break;
+                    case TAG_SERVICE_SCOPE:
+                    {
+                        Reader ar(a);
+                        Element id;
+                        while (ar.next(id)) {
+                            if (id.tag == ATTR_ID and schedule.service_id == 0) {
+                                decodeContentId(id.data, id.len, schedule.service_id);
+                            }
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        else if (c.tag == TAG_PROGRAMME) {
+            // Reuse the programmes of the previous object
+            if (num_programmes == schedule.programmes.size()) {
+                schedule.programmes.emplace_back();
+            }
+            if (readProgramme(c, schedule.programmes[num_programmes])) {
+                num_programmes++;
+            }
+        }
+    }
+    return not r.damaged();
+}
+
+bool SpiDecoder::decodeProgrammeInformation(const uint8_t *data, size_t len,
+        Schedule& schedule)
+{
+    schedule.service_id = 0;
+    schedule.start = 0;
+    schedule.stop = 0;
+    size_t num_programmes = 0;
+
+    for (auto& t : tokens) {
+        t.clear();
+    }
+
+    Reader top(data, len);
+    Element epg;
+    if (not top.next(epg) or epg.tag != TAG_EPG) {
+        schedule.programmes.clear();
+        return false;
+    }
+
+    bool ok = true;
+    Reader r(epg);
+    Element c;
+    while (r.next(c)) {
+        if (c.tag == TAG_TOKEN_TABLE) {
+            readTokenTable(c);
+        }
+        else if (c.tag == TAG_SCHEDULE) {
+            ok &= readSchedule(c, schedule, num_programmes);
+        }
+    }
+    ok &= not r.damaged();
+
+    schedule.programmes.resize(num_programmes);
+    for (auto& p : schedule.programmes) {
+        if (p.service_id == 0) {
+            p.service_id = schedule.service_id;
+        }
+    }
+    return ok;
+}
+
+bool SpiDecoder::readService(const Element& e, SpiService& s)
+{
+    s.clear();
+    s.service_id = 0;
+
+    Reader r(e);
+    Element c;
+    while (r.next(c)) {
+        if (readDescription(c, s)) {
+            continue;
+        }
+
+        if ((c.tag == TAG_SERVICE_ID or c.tag == TAG_BEARER) and s.service_id == 0) {
+            Reader ar(c);
+            Element a;
+            while (ar.next(a)) {
+                if (a.tag == ATTR_ID) {
+                    decodeContentId(a.data, a.len, s.service_id);
+                }
+            }
+        }
+    }
+    return s.service_id != 0 and not r.damaged();
+}
+
+// Elements that may contain services, e.g. the ensemble. The names,
+// descriptions and programmes are not searched.
+static bool may_contain_services(uint8_t tag)
+{
+    return tag > TAG_TOKEN_TABLE and tag < 0x80 and
+        (tag < TAG_SHORT_NAME or tag > TAG_PROGRAMME);
+}
+
+bool SpiDecoder::readServices(const Element& e, vector<SpiService>& services,
+        size_t& num_services, int depth)
+{
+    Reader r(e);
+    Element c;
+    while (r.next(c)) {
+        if (c.tag == TAG_TOKEN_TABLE and depth == 0) {
+            readTokenTable(c);
+        }
+        else if (c.tag == TAG_SERVICE) {
+            if (num_services == services.size()) {
+                services.emplace_back();
+            }
+            if (readService(c, services[num_services])) {
+                num_services++;
+            }
+        }
+        else if (may_contain_services(c.tag) and depth < 3) {
+            // A damaged container does not spoil the services found so far
+            readServices(c, services, num_services, depth + 1);
+        }
+    }
+    return not r.damaged();
+}
+
+bool SpiDecoder::decodeServiceInformation(const uint8_t *data, size_t len,
+        vector<SpiService>& services)
+{
+    size_t num_services = 0;
+
+    for (auto& t : tokens) {
+        t.clear();
+    }
+
+    Reader top(data, len);
+    Element si;
+    bool ok = top.next(si) and si.tag == TAG_SERVICE_INFORMATION and
+        readServices(si, services, num_services, 0);
+
+    services.resize(num_services);
+    return ok;
+}
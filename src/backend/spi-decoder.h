@@ -0,0 +1,164 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+/* What a programme guide shows of a service or a programme */
+struct SpiDescription {
+    std::string short_name;
+    std::string medium_name;
+    std::string long_name;
+    std::string short_description;
+    std::string long_description;
+
+    // TV-Anytime classification terms without the URN prefix,
+    // e.g. "3.6.8" for urn:tva:metadata:cs:ContentCS:2002:3.6.8
+    std::vector<std::string> genres;
+
+    // Keeps the capacity of the strings
+    void clear();
+
+    // The longest name given
+    const std::string& name() const;
+};
+
+struct SpiService : SpiDescription {
+    uint32_t service_id = 0;
+};
+
+struct SpiProgramme : SpiDescription {
+    uint32_t service_id = 0;
+    // UTC
+    std::time_t start = 0;
+    // In seconds
+    uint32_t duration = 0;
+
+    // The CRID, and its short form
+    std::string id;
+    uint32_t short_id = 0;
+
+    std::time_t stop() const { return start + duration; }
+};
+
+/* Decoder of the binary encoded Service and Programme Information objects
+ * of ETSI TS 102 371, which are carried in MOT directory mode. See
+ * ETSI TS 102 818 for the meaning of the elements.
+ *
+ * The objects are walked in place, no element tree is built. The token
+ * table, the strings and the programmes of a schedule are reused from
+ * object to object, since the carousel sends the same objects again and
+ * again. Unknown elements and attributes are skipped.
+ *
+ * Not thread-safe. */
+class SpiDecoder {
+    public:
+        // MOT content type and subtypes of the SPI objects
+        static constexpr int CONTENT_TYPE = 7;
+        static constexpr int CONTENT_SUB_TYPE_SI = 0;
+        static constexpr int CONTENT_SUB_TYPE_PI = 1;
+        static constexpr int CONTENT_SUB_TYPE_GI = 2;
+
+        struct Schedule {
+            // From the scope, 0 if not given
+            uint32_t service_id = 0;
+            std::time_t start = 0;
+            std::time_t stop = 0;
+
+            // Programmes without a bearer of their own belong to the
+            // service of the scope.
+            std::vector<SpiProgramme> programmes;
+        };
+
+        // Returns false if the data is not a programme information
+        // object or is damaged. The schedule is overwritten.
+        bool decodeProgrammeInformation(const uint8_t *data, size_t len,
+                Schedule& schedule);
+
+        // Returns false if the data is not a service information
+        // object or is damaged. The services are overwritten.
+        bool decodeServiceInformation(const uint8_t *data, size_t len,
+                std::vector<SpiService>& services);
+
+        // Time point of TS 102 371 clause 4.7.3, returns false if damaged
+        static bool decodeTime(const uint8_t *data, size_t len, std::time_t& t);
+
+        // Service identifier of a content ID, clause 4.7.4. Returns false
+        // if damaged.
+        static bool decodeContentId(const uint8_t *data, size_t len,
+                uint32_t& service_id);
+
+        // Classification term of a genre href, clause 4.7.6, empty if
+        // damaged
+        static std::string decodeGenre(const uint8_t *data, size_t len);
+
+    private:
+        struct Element {
+            uint8_t tag = 0;
+            const uint8_t *data = nullptr;
+            size_t len = 0;
+        };
+
+        // Iterates over the attributes and children of an element
+        class Reader {
+            public:
+                Reader(const uint8_t *data, size_t len) :
+                    p(data), end(data + len) {}
+                explicit Reader(const Element& e) : Reader(e.data, e.len) {}
+
+                // Returns false at the end, or if the data is damaged
+                bool next(Element& e);
+                bool damaged() const { return is_damaged; }
+
+            private:
+                const uint8_t *p;
+                const uint8_t *end;
+                bool is_damaged = false;
+        };
+
+        void readTokenTable(const Element& e);
+        // Character data, with the tokens expanded
+        void readString(const Element& e, std::string& s);
+        // The character data child of a name or description
+        void readText(const Element& e, std::string& s);
+        // Names, descriptions and genres, returns false for other children
+        bool readDescription(const Element& child, SpiDescription& d);
+        bool readSchedule(const Element& e, Schedule& schedule,
+                size_t& num_programmes);
+        bool readProgramme(const Element& e, SpiProgramme& p);
+        void readLocation(const Element& e, SpiProgramme& p, bool& has_time);
+        bool readServices(const Element& e, std::vector<SpiService>& services,
+                size_t& num_services, int depth);
+        bool readService(const Element& e, SpiService& s);
+
+        // Strings substituted for the bytes 0x01 to 0x13
+        static constexpr size_t NUM_TOKENS = 0x14;
+        std::string tokens[NUM_TOKENS];
+};
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <stdexcept>
 #include <iostream>
+#include <cmath>
 #include "tii-decoder.h"
 
 using namespace std;
@@ -134,6 +135,13 @@ float tii_measurement_t::getDelayKm(void) const
     return delay_samples * km_per_sample;
 }
 
+constexpr int TIIDecoder::MIN_DELAY;
+constexpr int TIIDecoder::MAX_DELAY;
+constexpr int TIIDecoder::NUM_DELAYS;
+constexpr int TIIDecoder::NUM_COMBS;
+constexpr int TIIDecoder::NUM_PATTERNS;
+constexpr int TIIDecoder::NUM_CPS;
+
 TIIDecoder::TIIDecoder(const DABParams& params, RadioControllerInterface& ri) :
     m_radioInterface(ri),
     m_params(params),
@@ -145,13 +153,18 @@ TIIDecoder::TIIDecoder(const DABParams& params, RadioControllerInterface& ri) :
         return;
     }
 
-    for (int c = 0; c < 24; c++) {
-        for (int p = 0; p < 70; p++) {
-            for (carrier_t k = 0; k < 384; k++) {
-                for (int b = 0; b < 8; b++) {
-                    if (k == 1 + 2*c + 48*b and tii_pattern[p][b]) {
-                        m_cp_per_carrier[k].emplace(c, p);
-                    }
+    m_carriers_per_cp.resize(NUM_CPS);
+    m_cp_per_carrier.resize(384);
+    m_error_per_delay.resize(NUM_CPS);
+
+    for (int c = 0; c < NUM_COMBS; c++) {
+        for (int p = 0; p < NUM_PATTERNS; p++) {
+            const int cp_ix = c * NUM_PATTERNS + p;
+            m_carriers_per_cp[cp_ix] = CombPattern(c, p).generateCarriers();
+
+            for (int b = 0; b < 8; b++) {
+                if (tii_pattern[p][b]) {
+                    m_cp_per_carrier[1 + 2*c + 48*b].push_back(cp_ix);
                 }
             }
         }
@@ -285,28 +298,25 @@ void TIIDecoder::run()
             }
         }
 
-        unordered_map<CombPattern, int> cp_count;
+        array<int, NUM_CPS> cp_count;
+        cp_count.fill(0);
         for (const carrier_t k : carriers) {
-            if (m_cp_per_carrier.count(k)) {
-                for (const auto& cps : m_cp_per_carrier[k]) {
-                    cp_count[cps]++;
+            if (k >= 0 and k < (carrier_t)m_cp_per_carrier.size()) {
+                for (const int cp_ix : m_cp_per_carrier[k]) {
+                    cp_count[cp_ix]++;
                 }
             }
         }
 
-        size_t num_likely_cps = 0;
-        for (const auto& cp : cp_count) {
-            if (cp.second >= 4) {
-                num_likely_cps++;
-            }
-        }
+        const size_t num_likely_cps = count_if(cp_count.begin(), cp_count.end(),
+                [](int count) { return count >= 4; });
 
         // Sometimes the number of likely CPs is huge because
         // the threshold is wrong. Skip these cases.
         if (num_likely_cps < 10) {
-            for (const auto& cp : cp_count) {
-                if (cp.second >= 4) {
-                    analyse_phase(cp.first);
+            for (int cp_ix = 0; cp_ix < NUM_CPS; cp_ix++) {
+                if (cp_count[cp_ix] >= 4) {
+                    analyse_phase(cp_ix);
                 }
             }
         }
@@ -317,9 +327,10 @@ void TIIDecoder::run()
     }
 }
 
-void TIIDecoder::analyse_phase(const CombPattern& cp)
+void TIIDecoder::analyse_phase(int cp_ix)
 {
-    const auto carriers = cp.generateCarriers();
+    const auto& carriers = m_carriers_per_cp[cp_ix];
+    const size_t num_carriers = carriers.size();
 
     const complexf *n = m_fft_null.getVector();
     const complexf *p = m_fft_prs.getVector();
@@ -332,53 +343,70 @@ void TIIDecoder::analyse_phase(const CombPattern& cp)
 
     // Both TII carriers take the phase from the first PRS frequency of the pair.
     // This assumes carriers is sorted.
-    vector<float> phases_prs(carriers.size());
-
-    for (size_t i = 0; i < carriers.size(); i += 2) {
-        const int ix = k_to_ix(carriers[i]);
-
-        phases_prs[i] = arg(p[ix]);
-        phases_prs[i+1] = arg(p[ix]);
+    m_phases_null.resize(num_carriers);
+    m_phases_prs.resize(num_carriers);
+    for (size_t i = 0; i < num_carriers; i += 2) {
+        const float phase_prs = arg(p[k_to_ix(carriers[i])]);
+        m_phases_prs[i] = phase_prs;
+        m_phases_prs[i+1] = phase_prs;
+        m_phases_null[i] = arg(n[k_to_ix(carriers[i])]);
+        m_phases_null[i+1] = arg(n[k_to_ix(carriers[i+1])]);
     }
 
-    auto& meas = m_error_per_correction[cp];
-
-    for (int err = -4; err < 500; err++) {
-        float abs_err = 0;
+    auto& meas = m_error_per_delay[cp_ix];
+    for (const carrier_t k : carriers) {
+        meas.power_null += norm(n[k_to_ix(k)]);
+        meas.power_prs += norm(p[k_to_ix(k)]);
+    }
 
-        for (size_t j = 0; j < carriers.size(); j++) {
-            const int ix = k_to_ix(carriers[j]);
-            constexpr float pi = M_PI;
-            complexf rotator = polar(1.0f, 2.0f * pi * err * carriers[j] / 2048.0f);
-            float delta = arg(n[ix] * rotator) - phases_prs[j];
-            abs_err += abs(delta);
+    if (meas.error_per_delay.empty()) {
+        meas.error_per_delay.resize(NUM_DELAYS);
+    }
+    float *error_per_delay = meas.error_per_delay.data();
+
+    /* A delay of d samples rotates carrier k by 2*pi*d*k/2048. Instead of
+     * calling polar() and arg() for every carrier and delay, the rotation
+     * is taken as the integer phase index d*k modulo 2048, which is exact,
+     * and added to the phase of the NULL carrier. The inner loop over the
+     * delays has no data-dependent branch and gets vectorised. */
+    constexpr float pi = M_PI;
+    constexpr float rad_per_index = 2.0f * pi / 2048.0f;
+    for (size_t j = 0; j < num_carriers; j++) {
+        const int k = carriers[j];
+        const float phase_null = m_phases_null[j];
+        const float phase_prs = m_phases_prs[j];
+
+        for (int d = 0; d < NUM_DELAYS; d++) {
+            const int rot_ix = ((MIN_DELAY + d) * k) & 2047;
+            float phase = phase_null + rot_ix * rad_per_index;
+
+            // Wrap into ]-pi, pi] like arg() does
+            phase = (phase > pi) ? phase - 2.0f * pi : phase;
+            error_per_delay[d] += fabs(phase - phase_prs);
         }
-        meas.error_per_correction[err] += abs_err;
     }
 
     meas.num_measurements++;
 
     if (meas.num_measurements >= 5) {
-        auto best = min_element(
-                meas.error_per_correction.begin(),
-                meas.error_per_correction.end(),
-                [](const pair<float, int>& lhs,
-                    const pair<float, int>& rhs) {
-                return lhs.second < rhs.second;
-                });
-
-        if (best != meas.error_per_correction.end()) {
-            tii_measurement_t m;
-            m.error = best->second;
-            m.delay_samples = best->first;
-            m.comb = cp.comb;
-            m.pattern = cp.pattern;
-
-            m_radioInterface.onTIIMeasurement(move(m));
+        const auto best = min_element(
+                meas.error_per_delay.begin(),
+                meas.error_per_delay.end());
+
+        tii_measurement_t m;
+        m.error = *best;
+        m.delay_samples = MIN_DELAY + (int)distance(meas.error_per_delay.begin(), best);
+        m.comb = cp_ix / NUM_PATTERNS;
+        m.pattern = cp_ix % NUM_PATTERNS;
+        if (meas.power_null > 0 and meas.power_prs > 0) {
+            m.level_db = 10.0f * log10(meas.power_null / meas.power_prs);
         }
 
-        meas.error_per_correction.clear();
+        m_radioInterface.onTIIMeasurement(move(m));
+
+        fill(meas.error_per_delay.begin(), meas.error_per_delay.end(), 0.0f);
         meas.num_measurements = 0;
+        meas.power_null = 0;
+        meas.power_prs = 0;
     }
 }
-
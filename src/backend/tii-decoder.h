@@ -21,7 +21,6 @@
 #include <cstddef>
 #include "dab-constants.h"
 #include <unordered_map>
-#include <unordered_set>
 #include <list>
 #include <vector>
 #include <mutex>
@@ -72,9 +71,18 @@ class TIIDecoder {
                 const std::vector<complexf>& null,
                 const std::vector<complexf>& prs);
 
+        // Delays in samples tried by the phase analysis
+        static constexpr int MIN_DELAY = -4;
+        static constexpr int MAX_DELAY = 500;
+        static constexpr int NUM_DELAYS = MAX_DELAY - MIN_DELAY;
+
+        static constexpr int NUM_COMBS = 24;
+        static constexpr int NUM_PATTERNS = 70;
+        static constexpr int NUM_CPS = NUM_COMBS * NUM_PATTERNS;
+
     private:
         void run(void);
-        void analyse_phase(const CombPattern& cp);
+        void analyse_phase(int cp_ix);
 
         RadioControllerInterface& m_radioInterface;
         const DABParams& m_params;
@@ -82,8 +90,12 @@ class TIIDecoder {
         std::vector<complexf> m_null;
         std::vector<complexf> m_prs;
 
-        std::unordered_map<carrier_t, std::unordered_set<CombPattern> >
-            m_cp_per_carrier;
+        // Indexed by comb * NUM_PATTERNS + pattern
+        std::vector<std::vector<carrier_t> > m_carriers_per_cp;
+
+        // Indexed by the carrier k from 0 to 383, lists the comb/patterns
+        // that use it.
+        std::vector<std::vector<int> > m_cp_per_carrier;
 
         enum class State { Idle, NullPrsReady, Abort };
 
@@ -96,11 +108,17 @@ class TIIDecoder {
         fft::Forward m_fft_prs;
 
         struct cp_error_measurement_t {
-            std::unordered_map<float, uint64_t> error_per_correction;
+            // Sum of the phase errors for each delay from MIN_DELAY,
+            // allocated on the first measurement
+            std::vector<float> error_per_delay;
             size_t num_measurements = 0;
+            float power_null = 0;
+            float power_prs = 0;
         };
 
-        std::unordered_map<CombPattern,
-            cp_error_measurement_t> m_error_per_correction;
-};
+        std::vector<cp_error_measurement_t> m_error_per_delay;
 
+        // Scratch buffers of analyse_phase
+        std::vector<float> m_phases_null;
+        std::vector<float> m_phases_prs;
+};
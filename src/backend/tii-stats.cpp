@@ -0,0 +1,177 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tii-stats.h"
+#include <algorithm>
+
+using namespace std;
+
+constexpr int TiiStats::NUM_COMBS;
+constexpr int TiiStats::NUM_PATTERNS;
+constexpr size_t TiiStats::WINDOW;
+constexpr size_t TiiStats::MIN_MEASUREMENTS;
+
+TiiStats::TiiStats(chrono::seconds maxAge,
+        chrono::seconds historyInterval,
+        size_t historyLength) :
+    maxAge(maxAge),
+    historyInterval(historyInterval),
+    historyLength(historyLength),
+    slots(NUM_COMBS * NUM_PATTERNS)
+{
+}
+
+void TiiStats::add(const tii_measurement_t& m, clock::time_point now)
+{
+    if (m.comb < 0 or m.comb >= NUM_COMBS or
+            m.pattern < 0 or m.pattern >= NUM_PATTERNS) {
+        return;
+    }
+
+    const int cp_ix = m.comb * NUM_PATTERNS + m.pattern;
+    auto& slot = slots[cp_ix];
+
+    const auto used = lower_bound(used_slots.begin(), used_slots.end(), cp_ix);
+    if (used == used_slots.end() or *used != cp_ix) {
+        used_slots.insert(used, cp_ix);
+    }
+
+    expire(slot, now);
+
+    if (slot.count == WINDOW) {
+        // Overwrite the oldest entry
+        const auto& oldest = slot.entries[slot.first];
+        slot.error_sum -= oldest.error;
+        slot.level_sum -= oldest.level_db;
+        slot.first = (slot.first + 1) % WINDOW;
+        slot.count--;
+    }
+
+    auto& e = slot.entries[(slot.first + slot.count) % WINDOW];
+    e.time = now;
+    e.delay_samples = m.delay_samples;
+    e.error = m.error;
+    e.level_db = m.level_db;
+    slot.error_sum += e.error;
+    slot.level_sum += e.level_db;
+    slot.count++;
+
+    if (slot.count >= MIN_MEASUREMENTS and
+            (slot.history.empty() or now - slot.last_history >= historyInterval)) {
+        const auto agg = aggregate(cp_ix, slot);
+
+        HistoryPoint p;
+        p.time = chrono::system_clock::now();
+        p.delay_samples = agg.delay_samples;
+        p.error = agg.error;
+        p.level_db = agg.level_db;
+        slot.history.push_back(p);
+        if (slot.history.size() > historyLength) {
+            slot.history.pop_front();
+        }
+        slot.last_history = now;
+    }
+}
+
+list<tii_measurement_t> TiiStats::getAggregates(clock::time_point now)
+{
+    list<tii_measurement_t> l;
+    for (const int cp_ix : used_slots) {
+        auto& slot = slots[cp_ix];
+        expire(slot, now);
+        if (slot.count >= MIN_MEASUREMENTS) {
+            l.push_back(aggregate(cp_ix, slot));
+        }
+    }
+    return l;
+}
+
+vector<TiiStats::History> TiiStats::getHistory() const
+{
+    vector<History> histories;
+    for (const int cp_ix : used_slots) {
+        const auto& slot = slots[cp_ix];
+        if (slot.history.empty()) {
+            continue;
+        }
+
+        History h;
+        h.comb = cp_ix / NUM_PATTERNS;
+        h.pattern = cp_ix % NUM_PATTERNS;
+        h.points.assign(slot.history.begin(), slot.history.end());
+        histories.push_back(move(h));
+    }
+    return histories;
+}
+
+void TiiStats::clear()
+{
+    for (const int cp_ix : used_slots) {
+        slots[cp_ix] = Slot();
+    }
+    used_slots.clear();
+}
+
+void TiiStats::expire(Slot& slot, clock::time_point now) const
+{
+    while (slot.count > 0 and now - slot.entries[slot.first].time > maxAge) {
+        const auto& oldest = slot.entries[slot.first];
+        slot.error_sum -= oldest.error;
+        slot.level_sum -= oldest.level_db;
+        slot.first = (slot.first + 1) % WINDOW;
+        slot.count--;
+    }
+
+    if (slot.count == 0) {
+        // Do not let rounding errors accumulate
+        slot.error_sum = 0;
+        slot.level_sum = 0;
+    }
+}
+
+tii_measurement_t TiiStats::aggregate(int cp_ix, const Slot& slot) const
+{
+    tii_measurement_t agg;
+    agg.comb = cp_ix / NUM_PATTERNS;
+    agg.pattern = cp_ix % NUM_PATTERNS;
+
+    if (slot.count == 0) {
+        return agg;
+    }
+
+    agg.error = slot.error_sum / slot.count;
+    agg.level_db = slot.level_sum / slot.count;
+
+    // The median is robust against the occasional wrong delay. The window
+    // is small and of fixed size, so this is constant time too.
+    array<int, WINDOW> delays;
+    for (size_t i = 0; i < slot.count; i++) {
+        delays[i] = slot.entries[(slot.first + i) % WINDOW].delay_samples;
+    }
+    const auto median = delays.begin() + slot.count / 2;
+    nth_element(delays.begin(), median, delays.begin() + slot.count);
+    agg.delay_samples = *median;
+    return agg;
+}
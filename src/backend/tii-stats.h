@@ -0,0 +1,127 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <vector>
+#include "radio-controller.h"
+
+/* Sliding-window statistics of the TII measurements of every transmitter,
+ * for the monitoring of single frequency networks over long periods.
+ *
+ * The transmitters are kept in a fixed array indexed by comb and pattern.
+ * Each slot holds its last WINDOW measurements in a ring buffer together
+ * with running sums, so that adding a measurement and computing the
+ * aggregate of a transmitter take constant time. Measurements older than
+ * maxAge leave the window, which makes transmitters that are no longer
+ * received disappear.
+ *
+ * Every historyInterval, the aggregate of each transmitter is also appended
+ * to its history, which holds at most historyLength points.
+ *
+ * Not thread-safe, the owner has to serialise the calls. */
+class TiiStats {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        static constexpr int NUM_COMBS = 24;
+        static constexpr int NUM_PATTERNS = 70;
+
+        // Number of measurements in the sliding window of each transmitter
+        static constexpr size_t WINDOW = 20;
+
+        // A transmitter is reported when its window holds at least
+        // this many measurements
+        static constexpr size_t MIN_MEASUREMENTS = 5;
+
+        struct HistoryPoint {
+            std::chrono::system_clock::time_point time;
+            int delay_samples = 0;
+            float error = 0;
+            float level_db = 0;
+        };
+
+        struct History {
+            int comb = 0;
+            int pattern = 0;
+            std::vector<HistoryPoint> points;
+        };
+
+        TiiStats(std::chrono::seconds maxAge = std::chrono::seconds(30),
+                std::chrono::seconds historyInterval = std::chrono::seconds(10),
+                size_t historyLength = 8640);
+
+        // Measurements with an invalid comb or pattern are ignored
+        void add(const tii_measurement_t& m, clock::time_point now = clock::now());
+
+        // Median delay, mean error and mean level of every transmitter with
+        // enough recent measurements, ordered by comb and pattern.
+        std::list<tii_measurement_t> getAggregates(clock::time_point now = clock::now());
+
+        // The histories of all transmitters that were ever reported,
+        // ordered by comb and pattern.
+        std::vector<History> getHistory() const;
+
+        // Forget everything, e.g. after a retune
+        void clear();
+
+    private:
+        struct Entry {
+            clock::time_point time;
+            int delay_samples = 0;
+            float error = 0;
+            float level_db = 0;
+        };
+
+        struct Slot {
+            // Ring buffer, the oldest entry is at index first
+            std::array<Entry, WINDOW> entries;
+            size_t first = 0;
+            size_t count = 0;
+            double error_sum = 0;
+            double level_sum = 0;
+
+            clock::time_point last_history;
+            std::deque<HistoryPoint> history;
+        };
+
+        // Drop the entries older than maxAge from the window
+        void expire(Slot& slot, clock::time_point now) const;
+        tii_measurement_t aggregate(int cp_ix, const Slot& slot) const;
+
+        const std::chrono::seconds maxAge;
+        const std::chrono::seconds historyInterval;
+        const size_t historyLength;
+
+        // Indexed by comb * NUM_PATTERNS + pattern
+        std::vector<Slot> slots;
+
+        // Sorted indices of the slots that received measurements
+        std::vector<int> used_slots;
+};
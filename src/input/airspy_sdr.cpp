@@ -32,8 +32,10 @@
  *
 */
 
+#include <algorithm>
 #include <iostream>
 #include "airspy_sdr.h"
+#include "iq_convert.h"
 
 // For Qt translation if Qt is existing
 #ifdef QT_CORE_LIB
@@ -47,8 +49,8 @@ static const int EXTIO_BASE_TYPE_SIZE = sizeof(float);
 
 CAirspy::CAirspy(RadioControllerInterface &radioController) :
     radioController(radioController),
-    SampleBuffer(256 * 1024),
-    SpectrumSampleBuffer(8192)
+    SampleBuffer(256 * 1024, true),
+    SpectrumSampleBuffer(8192, true)
 {
     std::clog << "Airspy: " << "Open airspy" << std::endl;
 
@@ -119,14 +121,39 @@ int CAirspy::getFrequency() const
     return freq;
 }
 
+int CAirspy::getSampleRate() const
+{
+    return sampleRate;
+}
+
+bool CAirspy::setSampleRate(int rate)
+{
+    if (running or rate <= 0) {
+        return rate == sampleRate;
+    }
+
+    // INPUT_RATE is obtained by decimating AIRSPY_SAMPLERATE, other
+    // rates are given out as the device delivers them
+    const int deviceRate = rate == INPUT_RATE ? AIRSPY_SAMPLERATE : rate;
+    const int result = airspy_set_samplerate(device, deviceRate);
+    if (result != AIRSPY_SUCCESS) {
+        std::clog  << "Airspy: " <<"airspy_set_samplerate() failed: " << airspy_error_name((airspy_error)result) << "(" << result << ")" << std::endl;
+        return false;
+    }
+
+    sampleRate = rate;
+    return true;
+}
+
 bool CAirspy::restart(void)
 {
     int result;
     if (running)
         return true;
 
-    SampleBuffer.FlushRingBuffer();
-    SpectrumSampleBuffer.FlushRingBuffer();
+    SampleBuffer.flush();
+    SpectrumSampleBuffer.flush();
+    resetStallTimer();
     result = airspy_set_sample_type(device, AIRSPY_SAMPLE_FLOAT32_IQ);
     if (result != AIRSPY_SUCCESS) {
         std::clog  << "Airspy: airspy_set_sample_type () failed: " << airspy_error_name((airspy_error)result) << "(" << result << ")" << std::endl;
@@ -184,31 +211,53 @@ int CAirspy::callback(airspy_transfer* transfer)
 
 // Called from AirSpy data callback which gives us interleaved float32
 // I and Q according to setting given to airspy_set_sample_type() above.
-// The AirSpy runs at 4096ksps, we need to decimate by two.
+// The AirSpy runs at 4096ksps, we need to decimate by two, unless the
+// samples go to a channelizer.
 int CAirspy::data_available(const DSPCOMPLEX* buf, size_t num_samples)
 {
-    if (num_samples % 2 != 0) {
-        throw std::runtime_error("CAirspy::data_available() needs an even number of IQ samples to be able to decimate");
-    }
-
-    const DSPCOMPLEX* sbuf = reinterpret_cast<const DSPCOMPLEX*>(buf);
-
-    std::vector<DSPCOMPLEX> temp(num_samples/2);
-
+    const bool measure = sw_agc and (num_frames % 10) == 0;
     float maxnorm = 0;
 
-    for (size_t i = 0; i < num_samples/2; i++) {
-        const auto z = 0.5f * (sbuf[2*i] + sbuf[2*i+1]);
-        temp[i] = z;
+    if (sampleRate != INPUT_RATE) {
+        const size_t written = SampleBuffer.push(buf, num_samples);
+        countSamples(num_samples, written);
+        SpectrumSampleBuffer.push(buf, num_samples);
+        putIntoRecordBuffer(*reinterpret_cast<const uint8_t*>(buf),
+                num_samples * sizeof(DSPCOMPLEX));
 
-        if (sw_agc and (num_frames % 10) == 0) {
-            if (norm(z) > maxnorm) {
-                maxnorm = norm(z);
+        if (measure) {
+            for (size_t i = 0; i < num_samples; i++) {
+                maxnorm = std::max(maxnorm, std::norm(buf[i]));
             }
         }
     }
+    else {
+        if (num_samples % 2 != 0) {
+            throw std::runtime_error("CAirspy::data_available() needs an even number of IQ samples to be able to decimate");
+        }
+
+        size_t i = 0;
+
+        // Decimate directly into the ring
+        const size_t written = SampleBuffer.writeInPlace(num_samples/2,
+                [&](DSPCOMPLEX *dst, size_t count) {
+                    iqconvert::decimate2(buf + 2*i, dst, count,
+                            measure ? &maxnorm : nullptr);
+                    i += count;
+                    SpectrumSampleBuffer.push(dst, count);
+                    putIntoRecordBuffer(*reinterpret_cast<const uint8_t*>(dst),
+                            count * sizeof(DSPCOMPLEX));
+                });
+        countSamples(num_samples/2, written);
+
+        // The samples that did not fit still count for the AGC
+        if (measure and i < num_samples/2) {
+            std::vector<DSPCOMPLEX> rest(num_samples/2 - i);
+            iqconvert::decimate2(buf + 2*i, rest.data(), rest.size(), &maxnorm);
+        }
+    }
 
-    if (sw_agc and (num_frames % 10) == 0) {
+    if (measure) {
         const float maxampl = sqrt(maxnorm);
         //  std::clog  << "Airspy: maxampl: " << maxampl << std::endl;
 
@@ -228,27 +277,24 @@ int CAirspy::data_available(const DSPCOMPLEX* buf, size_t num_samples)
 
     num_frames++;
 
-    SampleBuffer.putDataIntoBuffer(temp.data(), num_samples/2);
-    SpectrumSampleBuffer.putDataIntoBuffer(temp.data(), num_samples/2);
-
     return 0;
 }
 
 void CAirspy::reset(void)
 {
-    SampleBuffer.FlushRingBuffer();
-    SpectrumSampleBuffer.FlushRingBuffer();
+    SampleBuffer.flush();
+    SpectrumSampleBuffer.flush();
 }
 
 int32_t CAirspy::getSamples(DSPCOMPLEX* Buffer, int32_t Size)
 {
-    return SampleBuffer.getDataFromBuffer(Buffer, Size);
+    return SampleBuffer.pop(Buffer, Size);
 }
 
 std::vector<DSPCOMPLEX> CAirspy::getSpectrumSamples(int size)
 {
     std::vector<DSPCOMPLEX> buf(size);
-    int sizeRead = SpectrumSampleBuffer.getDataFromBuffer(buf.data(), size);
+    int sizeRead = SpectrumSampleBuffer.pop(buf.data(), size);
     if (sizeRead < size) {
         buf.resize(sizeRead);
     }
@@ -257,7 +303,7 @@ std::vector<DSPCOMPLEX> CAirspy::getSpectrumSamples(int size)
 
 int32_t CAirspy::getSamplesToRead(void)
 {
-    return SampleBuffer.GetRingBufferReadAvailable();
+    return SampleBuffer.readAvailable();
 }
 
 int CAirspy::getGainCount()
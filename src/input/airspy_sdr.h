@@ -37,7 +37,7 @@
 #include "virtual_input.h"
 #include "dab-constants.h"
 #include "MathHelper.h"
-#include "ringbuffer.h"
+#include "spsc_ring.h"
 
 #include <vector>
 
@@ -60,6 +60,8 @@ public:
 
     void setFrequency(int nf);
     int getFrequency(void) const;
+    int getSampleRate(void) const override;
+    bool setSampleRate(int rate) override;
     bool restart(void);
     bool is_ok(void);
     void stop(void);
@@ -76,6 +78,12 @@ public:
 
     CDeviceID getID(void);
 
+protected:
+    // Recorded after the conversion to DSPCOMPLEX
+    IQRecorder::Format getRecordFormat() const override {
+        return IQRecorder::Format::CF32;
+    }
+
 private:
     RadioControllerInterface& radioController;
 
@@ -85,13 +93,14 @@ private:
 
     bool running = false;
     int freq = 0;
+    int sampleRate = INPUT_RATE;
 
     size_t num_frames = 0;
 
     bool sw_agc = false;
     int currentLinearityGain = 10;
-    RingBuffer<DSPCOMPLEX> SampleBuffer;
-    RingBuffer<DSPCOMPLEX> SpectrumSampleBuffer;
+    SpscRing<DSPCOMPLEX> SampleBuffer;
+    SpscRing<DSPCOMPLEX> SpectrumSampleBuffer;
     struct airspy_device *device;
 
     static int callback(airspy_transfer_t*);
@@ -0,0 +1,529 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "channelizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+// Partial sums computed side by side, so that the dot product maps to
+// SIMD registers without needing -ffast-math. The taps are padded to
+// a multiple of this.
+static const size_t DOT_LANES = 8;
+
+// Modified Bessel function of the first kind, order 0
+static double bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static inline void dot(const float *tr, const float *ti,
+        const float *xr, const float *xi, size_t n, float& re, float& im)
+{
+    float accRe[DOT_LANES] = {};
+    float accIm[DOT_LANES] = {};
+    for (size_t k = 0; k < n; k += DOT_LANES) {
+        for (size_t j = 0; j < DOT_LANES; j++) {
+            accRe[j] += tr[k+j] * xr[k+j] - ti[k+j] * xi[k+j];
+            accIm[j] += tr[k+j] * xi[k+j] + ti[k+j] * xr[k+j];
+        }
+    }
+
+    re = 0;
+    im = 0;
+    for (size_t j = 0; j < DOT_LANES; j++) {
+        re += accRe[j];
+        im += accIm[j];
+    }
+}
+
+PolyphaseChannelizer::PolyphaseChannelizer(int inputRate, int decimation, int tapsPerPhase) :
+    inputRate(inputRate),
+    decimation(decimation)
+{
+    if (inputRate <= 0 or decimation < 1 or tapsPerPhase < 1) {
+        throw invalid_argument("Invalid channelizer decimation or length");
+    }
+
+    // Kaiser windowed sinc, cut off at the output Nyquist frequency.
+    // The DAB block spans +-768kHz, so at 2.048 MS/s everything that
+    // aliases onto it after decimation lies above 1.28MHz and is in the
+    // stop band. With 16 taps per phase the stop band attenuation is
+    // about 60dB.
+    const size_t length = (size_t)tapsPerPhase * decimation;
+    const double beta = 6.0;
+    const double cutoff = 0.5 / decimation;
+    const double centre = (length - 1) / 2.0;
+
+    prototype.resize(length);
+    double sum = 0;
+    for (size_t n = 0; n < length; n++) {
+        const double t = n - centre;
+        const double sinc = t == 0 ? 1.0 : sin(2 * M_PI * cutoff * t) / (2 * M_PI * cutoff * t);
+        const double r = length > 1 ? t / centre : 0;
+        const double window = bessel_i0(beta * sqrt(max(0.0, 1 - r * r))) / bessel_i0(beta);
+        prototype[n] = sinc * window;
+        sum += prototype[n];
+    }
+
+    // Unity gain in the pass band
+    for (auto& h : prototype) {
+        h /= sum;
+    }
+
+    // Zero taps at the oldest end do not change the response
+    const size_t padding = (DOT_LANES - length % DOT_LANES) % DOT_LANES;
+    prototype.insert(prototype.end(), padding, 0.0f);
+
+    reset();
+}
+
+int PolyphaseChannelizer::getMaxOffset() const
+{
+    return (inputRate - getOutputRate()) / 2;
+}
+
+size_t PolyphaseChannelizer::addChannel(int offset)
+{
+    channels.emplace_back();
+    setOffset(channels.size() - 1, offset);
+    return channels.size() - 1;
+}
+
+void PolyphaseChannelizer::setOffset(size_t channel, int offset)
+{
+    auto& c = channels.at(channel);
+    c.offset = offset;
+    makeTaps(c);
+}
+
+void PolyphaseChannelizer::makeTaps(Channel& c) const
+{
+    const size_t length = prototype.size();
+    const double omega = 2 * M_PI * c.offset / inputRate;
+
+    // y[m] = exp(-j w n) * sum_k h[k] exp(j w k) x[n - k], with n the
+    // newest input sample of output m: the same as mixing the input
+    // down first, but without touching every input sample per channel.
+    c.tapsRe.resize(length);
+    c.tapsIm.resize(length);
+    for (size_t k = 0; k < length; k++) {
+        c.tapsRe[length - 1 - k] = prototype[k] * cos(omega * k);
+        c.tapsIm[length - 1 - k] = prototype[k] * sin(omega * k);
+    }
+    c.phaseStep = -omega * decimation;
+}
+
+void PolyphaseChannelizer::reset()
+{
+    // Start with as much history as makes the number of outputs equal
+    // to the number of inputs divided by the decimation
+    const size_t history = prototype.size() - decimation;
+    bufferRe.assign(history, 0.0f);
+    bufferIm.assign(history, 0.0f);
+    for (auto& c : channels) {
+        c.phase = 0;
+    }
+}
+
+void PolyphaseChannelizer::process(const DSPCOMPLEX *in, size_t num_samples,
+        vector<vector<DSPCOMPLEX> >& out)
+{
+    const size_t length = prototype.size();
+
+    const size_t old_size = bufferRe.size();
+    bufferRe.resize(old_size + num_samples);
+    bufferIm.resize(old_size + num_samples);
+    for (size_t i = 0; i < num_samples; i++) {
+        bufferRe[old_size + i] = real(in[i]);
+        bufferIm[old_size + i] = imag(in[i]);
+    }
+
+    const size_t num_out = bufferRe.size() >= length ?
+        (bufferRe.size() - length) / decimation + 1 : 0;
+
+    out.resize(channels.size());
+    for (size_t ch = 0; ch < channels.size(); ch++) {
+        auto& c = channels[ch];
+        auto& o = out[ch];
+        o.resize(num_out);
+
+        for (size_t m = 0; m < num_out; m++) {
+            const size_t pos = m * decimation;
+            float re, im;
+            dot(c.tapsRe.data(), c.tapsIm.data(),
+                    bufferRe.data() + pos, bufferIm.data() + pos, length, re, im);
+
+            const float rot_re = cos(c.phase);
+            const float rot_im = sin(c.phase);
+            o[m] = DSPCOMPLEX(re * rot_re - im * rot_im, re * rot_im + im * rot_re);
+
+            c.phase = remainder(c.phase + c.phaseStep, 2 * M_PI);
+        }
+    }
+
+    const size_t consumed = num_out * decimation;
+    bufferRe.erase(bufferRe.begin(), bufferRe.begin() + consumed);
+    bufferIm.erase(bufferIm.begin(), bufferIm.begin() + consumed);
+}
+
+CChannelizer::CChannelizer(unique_ptr<CVirtualInput> wideband) :
+    wideband(move(wideband))
+{
+    if (not this->wideband) {
+        throw invalid_argument("The channelizer needs an input");
+    }
+
+    if (not configure()) {
+        throw invalid_argument("The channelizer input rate " +
+                to_string(this->wideband->getSampleRate()) +
+                " is below " + to_string(INPUT_RATE));
+    }
+    centerFrequency = this->wideband->getFrequency();
+}
+
+CChannelizer::~CChannelizer()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    wideband->stop();
+}
+
+int CChannelizer::decimationFor(const vector<int>& frequencies, int maxDecimation)
+{
+    if (frequencies.empty()) {
+        return 1;
+    }
+
+    const auto minmax = minmax_element(frequencies.begin(), frequencies.end());
+    const int64_t span = (int64_t)*minmax.second - *minmax.first;
+
+    // With the centre in the middle, the outermost channels are span/2
+    // away from it, see PolyphaseChannelizer::getMaxOffset()
+    const int decimation = 1 + (int)((span + INPUT_RATE - 1) / INPUT_RATE);
+    return decimation <= maxDecimation ? decimation : 0;
+}
+
+int CChannelizer::decimationOf(int rate)
+{
+    int decimation = max(rate / INPUT_RATE, 1);
+    while (rate % decimation != 0) {
+        decimation--;
+    }
+    return decimation;
+}
+
+int CChannelizer::getOutputRate() const
+{
+    lock_guard<mutex> lock(mut);
+    return dsp->getOutputRate();
+}
+
+bool CChannelizer::configure()
+{
+    const int rate = wideband->getSampleRate();
+    if (rate < INPUT_RATE) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(mut);
+    if (dsp and dsp->getInputRate() == rate) {
+        return true;
+    }
+
+    dsp.reset(new PolyphaseChannelizer(rate, decimationOf(rate)));
+    for (auto& output : outputs) {
+        dsp->addChannel(output->frequency - centerFrequency);
+    }
+    return true;
+}
+
+void CChannelizer::setCenterFrequency(int frequency)
+{
+    wideband->setFrequency(frequency);
+
+    lock_guard<mutex> lock(mut);
+    // Files cannot be tuned, but know where they were recorded
+    const int actual = wideband->getFrequency();
+    centerFrequency = actual > 0 ? actual : frequency;
+
+    for (auto& output : outputs) {
+        dsp->setOffset(output->index, output->frequency - centerFrequency);
+    }
+}
+
+int CChannelizer::getCenterFrequency() const
+{
+    lock_guard<mutex> lock(mut);
+    return centerFrequency;
+}
+
+bool CChannelizer::canReceive(int frequency) const
+{
+    lock_guard<mutex> lock(mut);
+    return abs(frequency - centerFrequency) <= dsp->getMaxOffset();
+}
+
+CChannelizerOutput& CChannelizer::addChannel(int frequency)
+{
+    {
+        lock_guard<mutex> lock(mut);
+        outputs.emplace_back(new CChannelizerOutput(*this, outputs.size()));
+        dsp->addChannel(0);
+    }
+
+    auto& output = *outputs.back();
+    output.setFrequency(frequency);
+    return output;
+}
+
+void CChannelizer::tune(CChannelizerOutput& output, int frequency)
+{
+    lock_guard<mutex> lock(mut);
+    output.frequency = frequency;
+    const int offset = frequency - centerFrequency;
+    if (abs(offset) > dsp->getMaxOffset()) {
+        clog << "Channelizer: " << frequency / 1000 << " kHz is outside of the captured band " <<
+            (centerFrequency - dsp->getMaxOffset()) / 1000 << " to " <<
+            (centerFrequency + dsp->getMaxOffset()) / 1000 << " kHz" << endl;
+    }
+    dsp->setOffset(output.index, offset);
+}
+
+bool CChannelizer::startChannel(CChannelizerOutput& output)
+{
+    lock_guard<mutex> control_lock(control_mut);
+    {
+        lock_guard<mutex> lock(mut);
+        if (output.running) {
+            return wideband->is_ok();
+        }
+        output.running = true;
+        numRunning++;
+    }
+
+    if (not running) {
+        // Some devices only know their rate once they run
+        if (not wideband->restart() or not configure()) {
+            wideband->stop();
+            lock_guard<mutex> lock(mut);
+            output.running = false;
+            numRunning--;
+            return false;
+        }
+        dsp->reset();
+        running = true;
+        thread = std::thread(&CChannelizer::run, this);
+    }
+    return true;
+}
+
+void CChannelizer::stopChannel(CChannelizerOutput& output)
+{
+    lock_guard<mutex> control_lock(control_mut);
+    {
+        lock_guard<mutex> lock(mut);
+        if (not output.running) {
+            return;
+        }
+        output.running = false;
+        if (--numRunning > 0) {
+            return;
+        }
+    }
+
+    // The last receiver went away
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    wideband->stop();
+}
+
+void CChannelizer::run()
+{
+    const int32_t block = dsp->getDecimation() * 32768;
+    // About a millisecond, to keep the overhead per call low
+    const int32_t minRead = dsp->getDecimation() * 2048;
+
+    vector<DSPCOMPLEX> buffer(block);
+    vector<vector<DSPCOMPLEX> > channelSamples;
+
+    while (running) {
+        const int32_t available = wideband->getSamplesToRead();
+        if (available < minRead) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+
+        const int32_t num = wideband->getSamples(buffer.data(), min(available, block));
+        if (num <= 0) {
+            continue;
+        }
+
+        lock_guard<mutex> lock(mut);
+        dsp->process(buffer.data(), num, channelSamples);
+
+        for (auto& output : outputs) {
+            auto& samples = channelSamples[output->index];
+            if (abs(output->frequency - centerFrequency) > dsp->getMaxOffset()) {
+                fill(samples.begin(), samples.end(), DSPCOMPLEX(0, 0));
+            }
+            if (output->running) {
+                output->deliver(samples);
+            }
+        }
+    }
+}
+
+CChannelizerOutput::CChannelizerOutput(CChannelizer& parent, size_t index) :
+    parent(parent),
+    index(index),
+    SampleBuffer(1024 * 1024, true),
+    SpectrumSampleBuffer(8192, true)
+{
+}
+
+void CChannelizerOutput::setFrequency(int Frequency)
+{
+    parent.tune(*this, Frequency);
+}
+
+int CChannelizerOutput::getFrequency() const
+{
+    return frequency;
+}
+
+bool CChannelizerOutput::restart()
+{
+    if (not running) {
+        SampleBuffer.flush();
+        SpectrumSampleBuffer.flush();
+        resetStallTimer();
+    }
+    return parent.startChannel(*this);
+}
+
+bool CChannelizerOutput::is_ok()
+{
+    return running and parent.wideband->is_ok();
+}
+
+void CChannelizerOutput::stop()
+{
+    parent.stopChannel(*this);
+}
+
+void CChannelizerOutput::reset()
+{
+    SampleBuffer.flush();
+}
+
+int32_t CChannelizerOutput::getSamples(DSPCOMPLEX *Buffer, int32_t Size)
+{
+    return SampleBuffer.pop(Buffer, Size);
+}
+
+vector<DSPCOMPLEX> CChannelizerOutput::getSpectrumSamples(int size)
+{
+    vector<DSPCOMPLEX> buffer(size);
+    const int32_t amount = SpectrumSampleBuffer.pop(buffer.data(), size);
+    if (amount < size) {
+        buffer.resize(amount);
+    }
+    return buffer;
+}
+
+int32_t CChannelizerOutput::getSamplesToRead()
+{
+    return SampleBuffer.readAvailable();
+}
+
+float CChannelizerOutput::getGain() const
+{
+    return parent.wideband->getGain();
+}
+
+float CChannelizerOutput::setGain(int Gain)
+{
+    return parent.wideband->setGain(Gain);
+}
+
+int CChannelizerOutput::getGainCount()
+{
+    return parent.wideband->getGainCount();
+}
+
+void CChannelizerOutput::setAgc(bool AGC)
+{
+    parent.wideband->setAgc(AGC);
+}
+
+string CChannelizerOutput::getDescription()
+{
+    return "Channel " + to_string(frequency / 1000) + " kHz of " +
+        parent.wideband->getDescription();
+}
+
+CDeviceID CChannelizerOutput::getID()
+{
+    return CDeviceID::CHANNELIZER;
+}
+
+int CChannelizerOutput::getSampleRate() const
+{
+    return parent.getOutputRate();
+}
+
+uint64_t CChannelizerOutput::getDiscontinuityCount() const
+{
+    return CVirtualInput::getDiscontinuityCount() +
+        parent.wideband->getDiscontinuityCount();
+}
+
+void CChannelizerOutput::deliver(const vector<DSPCOMPLEX>& samples)
+{
+    const size_t written = SampleBuffer.push(samples.data(), samples.size());
+    countSamples(samples.size(), written);
+
+    SpectrumSampleBuffer.push(samples.data(), samples.size());
+    putIntoRecordBuffer(*reinterpret_cast<const uint8_t*>(samples.data()),
+            samples.size() * sizeof(DSPCOMPLEX));
+}
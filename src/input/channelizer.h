@@ -0,0 +1,212 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef CHANNELIZER_H
+#define CHANNELIZER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "virtual_input.h"
+#include "spsc_ring.h"
+
+// Extracts several DAB channels from a wideband capture, decimating it
+// by an integer factor.
+//
+// DAB blocks are not on a regular grid, so instead of an FFT filter bank
+// every channel has its own polyphase decimator: the prototype low-pass
+// is shifted to the channel offset, only every decimation-th output is
+// computed, and the output is rotated back to baseband. The input is
+// split into I and Q once and shared by all channels.
+class PolyphaseChannelizer {
+    public:
+        PolyphaseChannelizer(int inputRate, int decimation, int tapsPerPhase = 16);
+
+        int getInputRate() const { return inputRate; }
+        int getOutputRate() const { return inputRate / decimation; }
+        int getDecimation() const { return decimation; }
+
+        // Largest offset of a channel from the centre of the capture
+        // that does not wrap around the edge of the spectrum
+        int getMaxOffset() const;
+
+        // Returns the index of the new channel
+        size_t addChannel(int offset);
+        void setOffset(size_t channel, int offset);
+        int getOffset(size_t channel) const { return channels.at(channel).offset; }
+        size_t getNumChannels() const { return channels.size(); }
+
+        // Filter num_samples input samples. out[i] is replaced by the
+        // output of channel i; input not filling a whole output is kept
+        // for the next call.
+        void process(const DSPCOMPLEX *in, size_t num_samples,
+                std::vector<std::vector<DSPCOMPLEX> >& out);
+
+        void reset();
+
+    private:
+        struct Channel {
+            int offset = 0;
+            // Prototype shifted to the offset, reversed, split in I and Q
+            std::vector<float> tapsRe;
+            std::vector<float> tapsIm;
+            // Per output rotation back to baseband
+            double phase = 0;
+            double phaseStep = 0;
+        };
+
+        void makeTaps(Channel& channel) const;
+
+        const int inputRate;
+        const int decimation;
+        std::vector<float> prototype;
+        std::vector<Channel> channels;
+
+        // Input history followed by the new samples
+        std::vector<float> bufferRe;
+        std::vector<float> bufferIm;
+};
+
+class CChannelizerOutput;
+
+// Shares one wideband input between several receivers. A thread reads
+// the wideband samples and gives every CChannelizerOutput its channel.
+// The gain and the tuning of the device are common to all channels.
+//
+// The channels are at the input rate divided by the largest integer
+// that keeps them at or above INPUT_RATE. The OFDM processor resamples
+// channels that end up above it, e.g. 2.5 MS/s out of 10 MS/s.
+class CChannelizer {
+    public:
+        // Throws std::invalid_argument if the input rate is below
+        // INPUT_RATE.
+        explicit CChannelizer(std::unique_ptr<CVirtualInput> wideband);
+        ~CChannelizer();
+        CChannelizer(const CChannelizer&) = delete;
+        CChannelizer& operator=(const CChannelizer&) = delete;
+
+        // The decimation needed to receive all the frequencies, or 0
+        // if they span more than the usable band at maxDecimation.
+        // Capturing at this multiple of INPUT_RATE, or faster, is enough.
+        static int decimationFor(const std::vector<int>& frequencies,
+                int maxDecimation = 16);
+
+        // The decimation applied to an input at the given rate
+        static int decimationOf(int rate);
+
+        int getOutputRate() const;
+
+        // Tune the device. Channels outside of the captured band give
+        // zeros until they are retuned.
+        void setCenterFrequency(int frequency);
+        int getCenterFrequency() const;
+
+        bool canReceive(int frequency) const;
+
+        // Channels are created before the receivers start
+        CChannelizerOutput& addChannel(int frequency);
+        size_t getNumChannels() const { return outputs.size(); }
+        CChannelizerOutput& getChannel(size_t index) { return *outputs.at(index); }
+
+        CVirtualInput& getWideband() { return *wideband; }
+
+    private:
+        friend class CChannelizerOutput;
+
+        // Set up the DSP for the rate of the input
+        bool configure();
+        void tune(CChannelizerOutput& output, int frequency);
+        bool startChannel(CChannelizerOutput& output);
+        void stopChannel(CChannelizerOutput& output);
+        void run();
+
+        std::unique_ptr<CVirtualInput> wideband;
+        std::vector<std::unique_ptr<CChannelizerOutput> > outputs;
+
+        // Serialises starting and stopping the thread
+        std::mutex control_mut;
+
+        // Protects the DSP and the channel frequencies
+        mutable std::mutex mut;
+        std::unique_ptr<PolyphaseChannelizer> dsp;
+        int centerFrequency = 0;
+        size_t numRunning = 0;
+
+        std::atomic<bool> running = ATOMIC_VAR_INIT(false);
+        std::thread thread;
+};
+
+// The input of one receiver, giving the samples of one channel
+class CChannelizerOutput : public CVirtualInput {
+    public:
+        CChannelizerOutput(CChannelizer& parent, size_t index);
+
+        // Interface methods
+        void setFrequency(int Frequency);
+        int getFrequency(void) const;
+        bool restart(void);
+        bool is_ok(void);
+        void stop(void);
+        void reset(void);
+        int32_t getSamples(DSPCOMPLEX* Buffer, int32_t Size);
+        std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
+        int32_t getSamplesToRead(void);
+        float getGain(void) const;
+        float setGain(int Gain);
+        int getGainCount(void);
+        void setAgc(bool AGC);
+        std::string getDescription(void);
+        CDeviceID getID(void);
+        int getSampleRate(void) const override;
+
+        // Samples lost by the wideband input are lost for every channel
+        uint64_t getDiscontinuityCount(void) const override;
+
+        size_t getIndex() const { return index; }
+
+    protected:
+        IQRecorder::Format getRecordFormat() const override {
+            return IQRecorder::Format::CF32;
+        }
+
+    private:
+        friend class CChannelizer;
+
+        // Called by the channelizer thread
+        void deliver(const std::vector<DSPCOMPLEX>& samples);
+
+        CChannelizer& parent;
+        const size_t index;
+        std::atomic<int> frequency = ATOMIC_VAR_INIT(0);
+        std::atomic<bool> running = ATOMIC_VAR_INIT(false);
+
+        SpscRing<DSPCOMPLEX> SampleBuffer;
+        SpscRing<DSPCOMPLEX> SpectrumSampleBuffer;
+};
+
+#endif // CHANNELIZER_H
@@ -0,0 +1,605 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ensemble_generator.h"
+#include "phasetable.h"
+#include "protTables.h"
+#include "protection.h"
+#include "tools.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+
+extern "C" {
+#include <fec.h>
+}
+
+using namespace std;
+
+static constexpr size_t CU_BITS = 64;
+static constexpr int MSC_CUS = 864;
+static constexpr size_t FIB_LENGTH = 32;
+static constexpr size_t FIB_DATA_LENGTH = 30;
+static constexpr size_t FIC_BLOCK_BITS = 2304;
+static constexpr size_t FIBS_PER_FIC_BLOCK = 3;
+static constexpr size_t FIC_BLOCKS_PER_FRAME = 4;
+static constexpr size_t CIFS_PER_FRAME = 4;
+static constexpr size_t SYMBOLS_PER_CIF = 18;
+static constexpr size_t FIC_SYMBOLS = 3;
+
+// Time interleaving delays in CIFs, the same map DabAudio uses to undo it
+static const int16_t interleaveDelay[16] = {
+    0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15};
+
+// Capacity units used per 8 kbps by EEP-A protection levels 1 to 4
+static const int cusPer8kbps[4] = {12, 8, 6, 4};
+
+static inline uint8_t parity(uint8_t x)
+{
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+// Keep the bits of blocks of 128 bits of mother code selected by the
+// puncturing vector pi, like the decoders insert them back
+static void puncture(const uint8_t *&in, int blocks, const int8_t *pi,
+        vector<uint8_t>& out)
+{
+    for (int b = 0; b < blocks; b++) {
+        for (int j = 0; j < 128; j++) {
+            if (pi[j % 32] != 0) {
+                out.push_back(in[j]);
+            }
+        }
+        in += 128;
+    }
+}
+
+// The 24 bits of the tail are punctured according to PI_X
+static void punctureTail(const uint8_t *in, vector<uint8_t>& out)
+{
+    for (int j = 0; j < 24; j++) {
+        if (PI_X[j] != 0) {
+            out.push_back(in[j]);
+        }
+    }
+}
+
+static void unpackBits(const uint8_t *bytes, size_t numBits, uint8_t *bits)
+{
+    for (size_t i = 0; i < numBits; i++) {
+        bits[i] = (bytes[i / 8] >> (7 - (i % 8))) & 1;
+    }
+}
+
+static bool checkFirecode(const uint8_t *sf)
+{
+    const uint16_t stored = sf[0] << 8 | sf[1];
+    return stored == CalcCRC::CalcCRC_FIRE_CODE.Calc(sf + 2, 9);
+}
+
+static vector<uint8_t> fig1Label(uint8_t extension, uint16_t id, const string& label)
+{
+    // EBU Latin charset, the label is padded to 16 characters
+    vector<uint8_t> fig = { (1 << 5) | 21, extension, (uint8_t)(id >> 8), (uint8_t)(id & 0xFF) };
+    for (size_t i = 0; i < 16; i++) {
+        fig.push_back(i < label.size() ? label[i] : ' ');
+    }
+
+    // The short label are the first characters, up to eight
+    const size_t shortLength = min<size_t>(8, label.size());
+    uint16_t flag = 0;
+    for (size_t i = 0; i < shortLength; i++) {
+        flag |= 0x8000 >> i;
+    }
+    fig.push_back(flag >> 8);
+    fig.push_back(flag & 0xFF);
+    return fig;
+}
+
+EnsembleGenerator::Config EnsembleGenerator::makeConfig(
+        int numServices, int bitrate, int protectionLevel)
+{
+    Config config;
+    for (int i = 0; i < numServices; i++) {
+        ServiceConfig s;
+        s.serviceId = 0xE001 + i;
+        s.label = string(i < 9 ? "Synthetic 0" : "Synthetic ") + to_string(i + 1);
+        s.bitrate = bitrate;
+        s.protectionLevel = protectionLevel;
+        config.services.push_back(s);
+    }
+    return config;
+}
+
+void EnsembleGenerator::convolve(const uint8_t *bits, size_t size,
+        vector<uint8_t>& out)
+{
+    // The polynomials with the newest bit as LSB, like the Viterbi decoder
+    static const uint8_t polys[4] = { 0155, 0117, 0123, 0155 };
+
+    uint8_t reg = 0;
+    for (size_t i = 0; i < size + 6; i++) {
+        const uint8_t bit = i < size ? (bits[i] & 1) : 0;
+        reg = ((reg << 1) | bit) & 0x7F;
+        for (const uint8_t poly : polys) {
+            out.push_back(parity(reg & poly));
+        }
+    }
+}
+
+vector<uint8_t> EnsembleGenerator::silentSuperframe(int bitrate)
+{
+    const size_t s = bitrate / 8;
+    const size_t dataLength = 110 * s;
+    vector<uint8_t> sf(120 * s, 0);
+
+    // 48 kHz without SBR gives six AUs of 20 ms, after 11 header bytes
+    const int numAUs = 6;
+    const size_t headerLength = 11;
+    size_t auStart[numAUs + 1];
+    for (int i = 0; i < numAUs; i++) {
+        auStart[i] = headerLength + i * ((dataLength - headerLength) / numAUs);
+    }
+    auStart[numAUs] = dataLength;
+
+    sf[2] = 0x40; // dac_rate, mono AAC-LC
+    sf[3] = auStart[1] >> 4;
+    sf[4] = (auStart[1] & 0x0F) << 4 | auStart[2] >> 8;
+    sf[5] = auStart[2] & 0xFF;
+    sf[6] = auStart[3] >> 4;
+    sf[7] = (auStart[3] & 0x0F) << 4 | auStart[4] >> 8;
+    sf[8] = auStart[4] & 0xFF;
+    sf[9] = auStart[5] >> 4;
+    sf[10] = (auStart[5] & 0x0F) << 4;
+
+    const uint16_t firecode = CalcCRC::CalcCRC_FIRE_CODE.Calc(sf.data() + 2, 9);
+    sf[0] = firecode >> 8;
+    sf[1] = firecode & 0xFF;
+
+    // A raw_data_block with a single channel element of ONLY_LONG
+    // windows, max_sfb 0 and no tools, followed by ID_END. The rest
+    // of the AU is padding.
+    static const uint8_t silence[4] = { 0x00, 0x00, 0x00, 0x07 };
+    for (int i = 0; i < numAUs; i++) {
+        uint8_t *au = sf.data() + auStart[i];
+        const size_t auLength = auStart[i + 1] - auStart[i];
+        copy(begin(silence), end(silence), au);
+        const uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(au, auLength - 2);
+        au[auLength - 2] = crc >> 8;
+        au[auLength - 1] = crc & 0xFF;
+    }
+
+    // RS(120, 110) over the columns of the superframe, like the
+    // RSDecoder in dabplus_decoder.cpp reads them
+    void *rs = init_rs_char(8, 0x11D, 0, 1, 10, 135);
+    if (!rs) {
+        throw runtime_error("EnsembleGenerator: error while init_rs_char");
+    }
+
+    uint8_t packet[120];
+    for (size_t i = 0; i < s; i++) {
+        for (size_t pos = 0; pos < 110; pos++) {
+            packet[pos] = sf[pos * s + i];
+        }
+        encode_rs_char(rs, packet, packet + 110);
+        for (size_t pos = 110; pos < 120; pos++) {
+            sf[pos * s + i] = packet[pos];
+        }
+    }
+    free_rs_char(rs);
+
+    return sf;
+}
+
+EnsembleGenerator::EnsembleGenerator(const Config& config) :
+    params(1),
+    config(config),
+    frameBits((params.L - 1) * 2 * params.K),
+    padding(MSC_CUS * CU_BITS, 0),
+    carriers(params.T_u),
+    ifft(params.T_u),
+    frame(params.T_F),
+    framePos(params.T_F),
+    rng(config.seed),
+    gaussian(0.0f, 1.0f)
+{
+    if (config.services.size() > 64) {
+        throw invalid_argument("At most 64 subchannels can be signalled");
+    }
+
+    int totalCUs = 0;
+    for (const auto& s : config.services) {
+        if (s.bitrate <= 0 or s.bitrate % 8 != 0 or s.bitrate > 192) {
+            throw invalid_argument("Unsupported bitrate " +
+                    to_string(s.bitrate) + " kbps");
+        }
+        if (s.protectionLevel < 1 or s.protectionLevel > 4) {
+            throw invalid_argument("Invalid EEP-A protection level " +
+                    to_string(s.protectionLevel));
+        }
+        totalCUs += cusPer8kbps[s.protectionLevel - 1] * s.bitrate / 8;
+    }
+
+    if (totalCUs > MSC_CUS) {
+        throw invalid_argument("The subchannels need " + to_string(totalCUs) +
+                " CUs, the MSC has " + to_string(MSC_CUS));
+    }
+
+    // Every file and every silent superframe is loaded only once
+    map<pair<string, int>, shared_ptr<const vector<uint8_t>>> superframes;
+
+    int startAddr = 0;
+    streams.resize(config.services.size());
+    for (size_t i = 0; i < config.services.size(); i++) {
+        const auto& sc = config.services[i];
+
+        Subchannel sub;
+        sub.subChId = i;
+        sub.startAddr = startAddr;
+        sub.length = cusPer8kbps[sc.protectionLevel - 1] * sc.bitrate / 8;
+        sub.programmeNotData = true;
+        sub.protectionSettings.shortForm = false;
+        sub.protectionSettings.eepProfile = EEPProtectionProfile::EEP_A;
+        sub.protectionSettings.eepLevel = (EEPProtectionLevel)sc.protectionLevel;
+        startAddr += sub.length;
+        subchannels.push_back(sub);
+
+        auto& stream = streams[i];
+        stream.subchannel = sub;
+        stream.bitrate = sc.bitrate;
+        stream.puncturing = EEPProtection::puncturing(
+                sc.bitrate, true, sc.protectionLevel);
+        stream.history.assign(16, vector<uint8_t>(sub.length * CU_BITS, 0));
+
+        auto& data = superframes[make_pair(sc.audioFile, sc.bitrate)];
+        if (not data) {
+            if (sc.audioFile.empty()) {
+                data = make_shared<const vector<uint8_t>>(silentSuperframe(sc.bitrate));
+            }
+            else {
+                ifstream file(sc.audioFile, ios::binary);
+                if (not file) {
+                    throw invalid_argument("Cannot open " + sc.audioFile);
+                }
+                auto content = make_shared<vector<uint8_t>>(
+                        istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+
+                const size_t sfLength = 120 * (sc.bitrate / 8);
+                if (content->empty() or content->size() % sfLength != 0 or
+                        not checkFirecode(content->data())) {
+                    throw invalid_argument(sc.audioFile +
+                            " does not contain DAB+ superframes of " +
+                            to_string(sc.bitrate) + " kbps");
+                }
+                data = content;
+            }
+        }
+        stream.superframes = data;
+    }
+
+    buildFigs(config);
+
+    FrequencyInterleaver interleaver(params);
+    carrierBins.resize(params.K);
+    for (int i = 0; i < params.K; i++) {
+        int16_t bin = interleaver.mapIn(i);
+        if (bin < 0) {
+            bin += params.T_u;
+        }
+        carrierBins[i] = bin;
+    }
+
+    // The phase reference symbol, as PhaseReference expects it
+    PhaseTable phaseTable(params.dabMode);
+    prs.assign(params.T_u, 0);
+    for (int i = 1; i <= params.K / 2; i++) {
+        prs[i] = polar(1.0f, phaseTable.get_Phi(i));
+        prs[params.T_u - i] = polar(1.0f, phaseTable.get_Phi(-i));
+    }
+
+    // The IFFT divides by T_u, and K carriers of unit
+    // magnitude add up to an RMS amplitude of sqrt(K)
+    scale = config.level * params.T_u / sqrt((float)params.K);
+
+    // The unused capacity of the MSC carries a PRBS, so that the data
+    // symbols do not look like the phase reference symbol
+    EnergyDispersal prbs;
+    prbs.dedisperse(padding);
+
+    int maxDelay = 0;
+    for (const auto& e : config.echoes) {
+        if (e.delay < 0 or e.delay > params.T_F) {
+            throw invalid_argument("Invalid echo delay " + to_string(e.delay));
+        }
+        maxDelay = max(maxDelay, e.delay);
+    }
+    echoHistory.assign(maxDelay, 0);
+
+    rotationStep = polar(1.0, 2 * M_PI * config.frequencyOffset / INPUT_RATE);
+}
+
+EnsembleGenerator::~EnsembleGenerator() = default;
+
+void EnsembleGenerator::buildFigs(const Config& config)
+{
+    figs.push_back(fig1Label(0, config.ensembleId, config.ensembleLabel));
+
+    // FIG 0/1, long form of seven subchannels at most
+    for (size_t i = 0; i < subchannels.size(); i += 7) {
+        vector<uint8_t> fig = { 0, 1 };
+        for (size_t j = i; j < min(i + 7, subchannels.size()); j++) {
+            const auto& sub = subchannels[j];
+            const int level = (int)sub.protectionSettings.eepLevel;
+            fig.push_back(sub.subChId << 2 | sub.startAddr >> 8);
+            fig.push_back(sub.startAddr & 0xFF);
+            fig.push_back(0x80 | (level - 1) << 2 | sub.length >> 8);
+            fig.push_back(sub.length & 0xFF);
+        }
+        fig[0] = fig.size() - 1;
+        figs.push_back(fig);
+    }
+
+    // FIG 0/2, five services with one DAB+ component each
+    for (size_t i = 0; i < config.services.size(); i += 5) {
+        vector<uint8_t> fig = { 0, 2 };
+        for (size_t j = i; j < min(i + 5, config.services.size()); j++) {
+            const uint16_t sid = config.services[j].serviceId;
+            fig.push_back(sid >> 8);
+            fig.push_back(sid & 0xFF);
+            fig.push_back(1); // one component
+            fig.push_back(63); // TMid 0, ASCTy DAB+
+            fig.push_back(subchannels[j].subChId << 2 | 0x02); // primary
+        }
+        fig[0] = fig.size() - 1;
+        figs.push_back(fig);
+    }
+
+    for (const auto& s : config.services) {
+        figs.push_back(fig1Label(1, s.serviceId, s.label));
+    }
+
+    for (const auto& fig : config.extraFigs) {
+        if (fig.size() < 2 or fig.size() > FIB_DATA_LENGTH or
+                (size_t)(fig[0] & 0x1F) != fig.size() - 1) {
+            throw invalid_argument("Invalid FIG of " + to_string(fig.size()) + " bytes");
+        }
+        figs.push_back(fig);
+    }
+}
+
+void EnsembleGenerator::getSamples(DSPCOMPLEX *buffer, size_t size)
+{
+    while (size > 0) {
+        if (framePos == frame.size()) {
+            generateFrame();
+        }
+
+        const size_t n = min(size, frame.size() - framePos);
+        copy(frame.begin() + framePos, frame.begin() + framePos + n, buffer);
+        framePos += n;
+        buffer += n;
+        size -= n;
+    }
+}
+
+void EnsembleGenerator::generateFrame()
+{
+    const size_t symbolBits = 2 * params.K;
+
+    encodeFic();
+    for (size_t cif = 0; cif < CIFS_PER_FRAME; cif++) {
+        encodeCif(&frameBits[(FIC_SYMBOLS + cif * SYMBOLS_PER_CIF) * symbolBits]);
+    }
+
+    fill(frame.begin(), frame.begin() + params.T_null, 0);
+
+    copy(prs.begin(), prs.end(), carriers.begin());
+    modulate(nullptr, &frame[params.T_null]);
+    for (int sym = 1; sym < params.L; sym++) {
+        modulate(&frameBits[(sym - 1) * symbolBits],
+                &frame[params.T_null + sym * params.T_s]);
+    }
+
+    applyChannel();
+
+    framePos = 0;
+    frameCount++;
+}
+
+void EnsembleGenerator::fillFib(int fib, uint8_t *out)
+{
+    size_t used = 0;
+
+    if (fib == 0) {
+        // FIG 0/0 with the count of the first CIF of the frame
+        const uint8_t cifHigh = (cifCount / 250) % 20;
+        const uint8_t cifLow = cifCount % 250;
+        const uint8_t fig[6] = { 5, 0,
+            (uint8_t)(config.ensembleId >> 8), (uint8_t)(config.ensembleId & 0xFF),
+            cifHigh, cifLow };
+        copy(begin(fig), end(fig), out);
+        used += sizeof(fig);
+    }
+
+    if (not figs.empty()) {
+        const size_t first = nextFig;
+        while (used + figs[nextFig].size() <= FIB_DATA_LENGTH) {
+            copy(figs[nextFig].begin(), figs[nextFig].end(), out + used);
+            used += figs[nextFig].size();
+            nextFig = (nextFig + 1) % figs.size();
+            if (nextFig == first) {
+                break;
+            }
+        }
+    }
+
+    // End marker and padding
+    if (used < FIB_DATA_LENGTH) {
+        out[used++] = 0xFF;
+        fill(out + used, out + FIB_DATA_LENGTH, 0);
+    }
+
+    const uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(out, FIB_DATA_LENGTH);
+    out[FIB_DATA_LENGTH] = crc >> 8;
+    out[FIB_DATA_LENGTH + 1] = crc & 0xFF;
+}
+
+void EnsembleGenerator::encodeFic()
+{
+    const int8_t *PI_15 = getPCodes(15 - 1);
+    const int8_t *PI_16 = getPCodes(16 - 1);
+
+    uint8_t fib[FIB_LENGTH];
+    const size_t blockBits = FIBS_PER_FIC_BLOCK * FIB_LENGTH * 8;
+    logicalFrame.resize(blockBits);
+
+    for (size_t block = 0; block < FIC_BLOCKS_PER_FRAME; block++) {
+        for (size_t i = 0; i < FIBS_PER_FIC_BLOCK; i++) {
+            fillFib(block * FIBS_PER_FIC_BLOCK + i, fib);
+            unpackBits(fib, FIB_LENGTH * 8, &logicalFrame[i * FIB_LENGTH * 8]);
+        }
+        ficDispersal.dedisperse(logicalFrame);
+
+        motherCode.clear();
+        convolve(logicalFrame.data(), blockBits, motherCode);
+
+        // The same puncturing as FicHandler::processFicInput()
+        vector<uint8_t> punctured;
+        punctured.reserve(FIC_BLOCK_BITS);
+        const uint8_t *m = motherCode.data();
+        puncture(m, 21, PI_16, punctured);
+        puncture(m, 3, PI_15, punctured);
+        punctureTail(m, punctured);
+
+        copy(punctured.begin(), punctured.end(), &frameBits[block * FIC_BLOCK_BITS]);
+    }
+
+    cifCount = (cifCount + CIFS_PER_FRAME) % 5000;
+}
+
+void EnsembleGenerator::encodeCif(uint8_t *cif)
+{
+    copy(padding.begin(), padding.end(), cif);
+
+    const size_t slot = cifsEncoded % 16;
+    for (auto& s : streams) {
+        // A logical frame is a fifth of a superframe
+        const size_t frameLength = 3 * s.bitrate;
+        const uint8_t *data = s.superframes->data() + s.position;
+        s.position = (s.position + frameLength) % s.superframes->size();
+
+        logicalFrame.resize(frameLength * 8);
+        unpackBits(data, frameLength * 8, logicalFrame.data());
+        s.dispersal.dedisperse(logicalFrame);
+
+        motherCode.clear();
+        convolve(logicalFrame.data(), logicalFrame.size(), motherCode);
+
+        auto& encoded = s.history[slot];
+        encoded.clear();
+        const uint8_t *m = motherCode.data();
+        puncture(m, s.puncturing.L1, s.puncturing.PI1, encoded);
+        puncture(m, s.puncturing.L2, s.puncturing.PI2, encoded);
+        punctureTail(m, encoded);
+
+        // Time interleaving, the inverse of what DabAudio::run() does
+        uint8_t *dst = cif + s.subchannel.startAddr * CU_BITS;
+        for (size_t i = 0; i < encoded.size(); i++) {
+            dst[i] = s.history[(cifsEncoded - interleaveDelay[i % 16]) % 16][i];
+        }
+    }
+
+    cifsEncoded++;
+}
+
+void EnsembleGenerator::modulate(const uint8_t *bits, DSPCOMPLEX *out)
+{
+    // Differential QPSK, the inverse of the demodulation in OfdmDecoder
+    static const float h = (float)M_SQRT1_2;
+    static const DSPCOMPLEX qpsk[4] = {
+        DSPCOMPLEX(h, h), DSPCOMPLEX(-h, h), DSPCOMPLEX(h, -h), DSPCOMPLEX(-h, -h) };
+
+    if (bits) {
+        for (int i = 0; i < params.K; i++) {
+            const int bin = carrierBins[i];
+            carriers[bin] *= qpsk[bits[i] | bits[params.K + i] << 1];
+        }
+    }
+
+    DSPCOMPLEX *v = ifft.getVector();
+    copy(carriers.begin(), carriers.end(), v);
+    ifft.do_IFFT();
+
+    // Cyclic prefix
+    const int T_g = params.T_s - params.T_u;
+    for (int i = 0; i < T_g; i++) {
+        out[i] = v[params.T_u - T_g + i] * scale;
+    }
+    for (int i = 0; i < params.T_u; i++) {
+        out[T_g + i] = v[i] * scale;
+    }
+}
+
+void EnsembleGenerator::applyChannel()
+{
+    if (not config.echoes.empty()) {
+        const size_t h = echoHistory.size();
+        echoBuffer.resize(h + frame.size());
+        copy(echoHistory.begin(), echoHistory.end(), echoBuffer.begin());
+        copy(frame.begin(), frame.end(), echoBuffer.begin() + h);
+
+        for (const auto& e : config.echoes) {
+            const DSPCOMPLEX g = polar(e.gain, e.phase);
+            const DSPCOMPLEX *src = echoBuffer.data() + h - e.delay;
+            for (size_t i = 0; i < frame.size(); i++) {
+                frame[i] += g * src[i];
+            }
+        }
+
+        copy(echoBuffer.end() - h, echoBuffer.end(), echoHistory.begin());
+    }
+
+    if (config.frequencyOffset != 0) {
+        for (auto& s : frame) {
+            s *= DSPCOMPLEX(rotation.real(), rotation.imag());
+            rotation *= rotationStep;
+        }
+        rotation /= abs(rotation);
+    }
+
+    if (config.noise) {
+        const float sigma = config.level /
+            sqrt(2.0f * pow(10.0f, config.snr / 10.0f));
+        for (auto& s : frame) {
+            s += DSPCOMPLEX(gaussian(rng), gaussian(rng)) * sigma;
+        }
+    }
+}
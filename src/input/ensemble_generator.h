@@ -0,0 +1,178 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "dab-constants.h"
+#include "eep-protection.h"
+#include "energy_dispersal.h"
+#include "fft.h"
+#include "freq-interleaver.h"
+
+/* Generates a complete transmission mode I DAB signal in software: the
+ * NULL symbol, the phase reference symbol, a FIC carrying the FIGs that
+ * describe the ensemble, and one DAB+ audio subchannel per service in
+ * the MSC. Echoes, a frequency offset and white noise can be added to
+ * simulate the channel.
+ *
+ * For a given configuration, the samples are always the same. This makes
+ * the generator suitable for repeatable tests and for load tests of the
+ * receiver with more services than any real ensemble carries. */
+class EnsembleGenerator {
+    public:
+        struct ServiceConfig {
+            uint16_t serviceId = 0;
+            std::string label;
+
+            // Subchannel bitrate in kbps, a multiple of 8
+            int bitrate = 48;
+            // EEP-A protection level, 1 to 4
+            int protectionLevel = 3;
+
+            // File containing DAB+ superframes with their RS parity, like
+            // the file output of ODR-AudioEnc, repeated endlessly. When
+            // empty, superframes of silent AAC frames are sent.
+            std::string audioFile;
+        };
+
+        struct Echo {
+            int delay = 0; // in samples
+            float gain = 0;
+            float phase = 0; // in radians
+        };
+
+        struct Config {
+            uint16_t ensembleId = 0xEFFF;
+            std::string ensembleLabel = "welle.io synth";
+            std::vector<ServiceConfig> services;
+
+            // Complete FIGs, header included, that are transmitted
+            // in addition to the ones describing the ensemble
+            std::vector<std::vector<uint8_t>> extraFigs;
+
+            // RMS amplitude of the signal, without noise
+            float level = 0.25f;
+
+            std::vector<Echo> echoes;
+            float frequencyOffset = 0; // in Hz
+            bool noise = false;
+            float snr = 30; // in dB, when noise is enabled
+            uint32_t seed = 1;
+        };
+
+        // An ensemble of numServices services of equal bitrate
+        static Config makeConfig(int numServices, int bitrate,
+                int protectionLevel = 3);
+
+        // Throws std::invalid_argument if the configuration cannot be
+        // transmitted, e.g. if the subchannels do not fit into the MSC.
+        explicit EnsembleGenerator(const Config& config);
+        ~EnsembleGenerator();
+        EnsembleGenerator(const EnsembleGenerator&) = delete;
+        EnsembleGenerator& operator=(const EnsembleGenerator&) = delete;
+
+        // Fill buffer with the next size samples of the signal
+        void getSamples(DSPCOMPLEX *buffer, size_t size);
+
+        // The subchannels, as signalled in FIG 0/1, in service order
+        const std::vector<Subchannel>& getSubchannels() const { return subchannels; }
+
+        // Transmission frames generated so far
+        uint64_t getFrameCount() const { return frameCount; }
+
+        // Convolutional encoder of the DAB standard, section 11.1. Appends
+        // the 4 * (size + 6) bits of the mother code, tail included.
+        static void convolve(const uint8_t *bits, size_t size,
+                std::vector<uint8_t>& out);
+
+        // Superframe of silent mono AAC-LC frames at 48 kHz, with
+        // firecode, AU CRCs and RS parity
+        static std::vector<uint8_t> silentSuperframe(int bitrate);
+
+    private:
+        struct Stream {
+            Subchannel subchannel;
+            int bitrate = 0;
+            EEPProtection::Puncturing puncturing;
+            EnergyDispersal dispersal;
+
+            std::shared_ptr<const std::vector<uint8_t>> superframes;
+            size_t position = 0;
+
+            // The last 16 logical frames after convolutional coding
+            std::vector<std::vector<uint8_t>> history;
+        };
+
+        void buildFigs(const Config& config);
+        void generateFrame();
+        void fillFib(int fib, uint8_t *out);
+        void encodeFic();
+        void encodeCif(uint8_t *cif);
+        void modulate(const uint8_t *bits, DSPCOMPLEX *out);
+        void applyChannel();
+
+        const DABParams params;
+        const Config config;
+
+        std::vector<Subchannel> subchannels;
+        std::vector<Stream> streams;
+
+        // FIC carousel, FIG 0/0 excluded
+        std::vector<std::vector<uint8_t>> figs;
+        size_t nextFig = 0;
+        EnergyDispersal ficDispersal;
+
+        uint64_t frameCount = 0;
+        uint16_t cifCount = 0;
+        uint64_t cifsEncoded = 0;
+
+        // Bits of the symbols 1 to L-1 of the frame being generated
+        std::vector<uint8_t> frameBits;
+        std::vector<uint8_t> logicalFrame;
+        std::vector<uint8_t> motherCode;
+        // Padding for the unused capacity of the MSC
+        std::vector<uint8_t> padding;
+
+        std::vector<int16_t> carrierBins;
+        std::vector<DSPCOMPLEX> prs;
+        std::vector<DSPCOMPLEX> carriers;
+        fft::Backward ifft;
+        float scale = 1.0f;
+
+        std::vector<DSPCOMPLEX> frame;
+        size_t framePos = 0;
+
+        std::vector<DSPCOMPLEX> echoHistory;
+        std::vector<DSPCOMPLEX> echoBuffer;
+        std::complex<double> rotation = 1.0;
+        std::complex<double> rotationStep = 1.0;
+        std::mt19937 rng;
+        std::normal_distribution<float> gaussian;
+};
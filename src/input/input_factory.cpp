@@ -39,6 +39,7 @@
 #include "null_device.h"
 #include "rtl_tcp.h"
 #include "raw_file.h"
+#include "synthetic_input.h"
 
 #ifdef HAVE_RTLSDR
 #include "rtl_sdr.h"
@@ -111,6 +112,11 @@ CVirtualInput *CInputFactory::GetDevice(RadioControllerInterface &radioControlle
         case CDeviceID::ANDROID_RTL_SDR: InputDevice = new CAndroid_RTL_SDR(radioController); break;
 #endif
         case CDeviceID::NULLDEVICE: InputDevice = new CNullDevice(); break;
+        case CDeviceID::SYNTHETIC: {
+            bool throttle = true;
+            InputDevice = new CSyntheticInput(CSyntheticInput::parseArgs("", throttle), throttle);
+            break;
+        }
         default: throw std::runtime_error("unknown device ID " + std::string(__FILE__) +":"+ std::to_string(__LINE__));
         }
     }
@@ -200,6 +206,11 @@ CVirtualInput* CInputFactory::GetManualDevice(RadioControllerInterface& radioCon
 #endif
         if (device == "rawfile")
             InputDevice = new CRAWFile(radioController);
+        else
+        if (device == "synthetic") {
+            bool throttle = true;
+            InputDevice = new CSyntheticInput(CSyntheticInput::parseArgs("", throttle), throttle);
+        }
         else
             std::clog << "InputFactory:"
                 "Unknown device \"" << device << "\"." << std::endl;
@@ -0,0 +1,415 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "iq_convert.h"
+#include <algorithm>
+#include <array>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define IQCONVERT_AVX2 1
+#  include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__BYTE_ORDER__) && \
+        __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#  define IQCONVERT_NEON 1
+#  include <arm_neon.h>
+#endif
+
+namespace iqconvert {
+
+// Dividing by a power of two is exact in single precision, which makes
+// the multiplication give the same result as the division the inputs used
+// to do in double precision.
+static const float SCALE_8BIT = 1.0f / 128.0f;
+
+/********************************* Portable **********************************/
+
+using Table = std::array<float, 256>;
+
+static Table make_u8_table()
+{
+    Table t;
+    for (int i = 0; i < 256; i++) {
+        t[i] = (i - 128) * SCALE_8BIT;
+    }
+    return t;
+}
+
+static Table make_s8_table()
+{
+    Table t;
+    for (int i = 0; i < 256; i++) {
+        t[i] = (int8_t)i * SCALE_8BIT;
+    }
+    return t;
+}
+
+static const Table u8_table = make_u8_table();
+static const Table s8_table = make_s8_table();
+
+static void lookup(const Table& table, const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    float *o = reinterpret_cast<float*>(out);
+    for (size_t i = 0; i < 2 * num_samples; i++) {
+        o[i] = table[in[i]];
+    }
+}
+
+static void u8_portable(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    lookup(u8_table, in, out, num_samples);
+}
+
+static void s8_portable(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    lookup(s8_table, in, out, num_samples);
+}
+
+static void s16le_portable(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    float *o = reinterpret_cast<float*>(out);
+    for (size_t i = 0; i < 2 * num_samples; i++) {
+        const int16_t v = (int16_t)(in[2 * i] | (in[2 * i + 1] << 8));
+        o[i] = v * scale;
+    }
+}
+
+static void s16be_portable(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    float *o = reinterpret_cast<float*>(out);
+    for (size_t i = 0; i < 2 * num_samples; i++) {
+        const int16_t v = (int16_t)((in[2 * i] << 8) | in[2 * i + 1]);
+        o[i] = v * scale;
+    }
+}
+
+static void decimate2_portable(const DSPCOMPLEX *in, DSPCOMPLEX *out, size_t num_out, float *maxnorm)
+{
+    const float *f = reinterpret_cast<const float*>(in);
+    float *o = reinterpret_cast<float*>(out);
+    float m = 0.0f;
+    for (size_t k = 0; k < num_out; k++) {
+        const float re = 0.5f * (f[4 * k] + f[4 * k + 2]);
+        const float im = 0.5f * (f[4 * k + 1] + f[4 * k + 3]);
+        o[2 * k] = re;
+        o[2 * k + 1] = im;
+        m = std::max(m, re * re + im * im);
+    }
+    if (maxnorm) {
+        *maxnorm = std::max(*maxnorm, m);
+    }
+}
+
+static const Kernels portable_kernels = {
+    "portable",
+    u8_portable,
+    s8_portable,
+    s16le_portable,
+    s16be_portable,
+    decimate2_portable,
+};
+
+/*********************************** AVX2 ************************************/
+
+#ifdef IQCONVERT_AVX2
+
+// Every kernel converts eight 8-bit or 16-bit values, i.e. four complex
+// samples, per step. The interleaving is kept as it is, so no shuffling
+// is needed. The tail is left to the portable kernels.
+
+__attribute__((target("avx2")))
+static void u8_avx2(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const __m256i offset = _mm256_set1_epi32(128);
+    const __m256 scale = _mm256_set1_ps(SCALE_8BIT);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+        const __m256i v = _mm256_sub_epi32(_mm256_cvtepu8_epi32(b), offset);
+        _mm256_storeu_ps(o + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    u8_portable(in + i, out + i / 2, num_samples - i / 2);
+}
+
+__attribute__((target("avx2")))
+static void s8_avx2(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const __m256 scale = _mm256_set1_ps(SCALE_8BIT);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+        const __m256i v = _mm256_cvtepi8_epi32(b);
+        _mm256_storeu_ps(o + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    s8_portable(in + i, out + i / 2, num_samples - i / 2);
+}
+
+__attribute__((target("avx2")))
+static void s16_avx2(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples,
+        float scale, bool big_endian)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                       9, 8, 11, 10, 13, 12, 15, 14);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+        if (big_endian) {
+            w = _mm_shuffle_epi8(w, swap);
+        }
+        const __m256i v = _mm256_cvtepi16_epi32(w);
+        _mm256_storeu_ps(o + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), s));
+    }
+
+    if (big_endian) {
+        s16be_portable(in + 2 * i, out + i / 2, num_samples - i / 2, scale);
+    }
+    else {
+        s16le_portable(in + 2 * i, out + i / 2, num_samples - i / 2, scale);
+    }
+}
+
+static void s16le_avx2(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    s16_avx2(in, out, num_samples, scale, false);
+}
+
+static void s16be_avx2(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    s16_avx2(in, out, num_samples, scale, true);
+}
+
+__attribute__((target("avx2")))
+static void decimate2_avx2(const DSPCOMPLEX *in, DSPCOMPLEX *out, size_t num_out, float *maxnorm)
+{
+    const float *f = reinterpret_cast<const float*>(in);
+    float *o = reinterpret_cast<float*>(out);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    __m256 m = _mm256_setzero_ps();
+
+    size_t k = 0;
+    for (; k + 4 <= num_out; k += 4) {
+        // Handle each complex sample as one 64-bit element
+        const __m256d a = _mm256_castps_pd(_mm256_loadu_ps(f + 4 * k));
+        const __m256d b = _mm256_castps_pd(_mm256_loadu_ps(f + 4 * k + 8));
+        const __m256 even = _mm256_castpd_ps(_mm256_shuffle_pd(a, b, 0x0));
+        const __m256 odd = _mm256_castpd_ps(_mm256_shuffle_pd(a, b, 0xF));
+
+        // The shuffles leave the sums in the order 0, 2, 1, 3
+        __m256 z = _mm256_mul_ps(half, _mm256_add_ps(even, odd));
+        z = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(z), 0xD8));
+        _mm256_storeu_ps(o + 2 * k, z);
+
+        const __m256 sq = _mm256_mul_ps(z, z);
+        m = _mm256_max_ps(m, _mm256_add_ps(sq, _mm256_permute_ps(sq, 0xB1)));
+    }
+
+    float norms[8];
+    _mm256_storeu_ps(norms, m);
+    float mn = *std::max_element(norms, norms + 8);
+
+    decimate2_portable(in + 2 * k, out + k, num_out - k, &mn);
+    if (maxnorm) {
+        *maxnorm = std::max(*maxnorm, mn);
+    }
+}
+
+static const Kernels avx2_kernels = {
+    "avx2",
+    u8_avx2,
+    s8_avx2,
+    s16le_avx2,
+    s16be_avx2,
+    decimate2_avx2,
+};
+
+static bool cpu_has_avx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+/*********************************** NEON ************************************/
+
+#ifdef IQCONVERT_NEON
+
+static inline void store_s16x8(float *o, int16x8_t v, float32x4_t scale)
+{
+    const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+    vst1q_f32(o, vmulq_f32(lo, scale));
+    vst1q_f32(o + 4, vmulq_f32(hi, scale));
+}
+
+static void u8_neon(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const int16x8_t offset = vdupq_n_s16(128);
+    const float32x4_t scale = vdupq_n_f32(SCALE_8BIT);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        const int16x8_t w = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(in + i)));
+        store_s16x8(o + i, vsubq_s16(w, offset), scale);
+    }
+    u8_portable(in + i, out + i / 2, num_samples - i / 2);
+}
+
+static void s8_neon(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const float32x4_t scale = vdupq_n_f32(SCALE_8BIT);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        const int8x8_t b = vreinterpret_s8_u8(vld1_u8(in + i));
+        store_s16x8(o + i, vmovl_s8(b), scale);
+    }
+    s8_portable(in + i, out + i / 2, num_samples - i / 2);
+}
+
+static void s16le_neon(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        store_s16x8(o + i, vreinterpretq_s16_u8(vld1q_u8(in + 2 * i)), s);
+    }
+    s16le_portable(in + 2 * i, out + i / 2, num_samples - i / 2, scale);
+}
+
+static void s16be_neon(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    float *o = reinterpret_cast<float*>(out);
+    const float32x4_t s = vdupq_n_f32(scale);
+
+    size_t i = 0;
+    for (; i + 8 <= 2 * num_samples; i += 8) {
+        const uint8x16_t b = vrev16q_u8(vld1q_u8(in + 2 * i));
+        store_s16x8(o + i, vreinterpretq_s16_u8(b), s);
+    }
+    s16be_portable(in + 2 * i, out + i / 2, num_samples - i / 2, scale);
+}
+
+static void decimate2_neon(const DSPCOMPLEX *in, DSPCOMPLEX *out, size_t num_out, float *maxnorm)
+{
+    const float *f = reinterpret_cast<const float*>(in);
+    float *o = reinterpret_cast<float*>(out);
+    float32x4_t m = vdupq_n_f32(0.0f);
+
+    size_t k = 0;
+    for (; k + 4 <= num_out; k += 4) {
+        // val[0] and val[1] hold the even samples, val[2] and val[3] the odd ones
+        const float32x4x4_t v = vld4q_f32(f + 4 * k);
+        float32x4x2_t z;
+        z.val[0] = vmulq_n_f32(vaddq_f32(v.val[0], v.val[2]), 0.5f);
+        z.val[1] = vmulq_n_f32(vaddq_f32(v.val[1], v.val[3]), 0.5f);
+        vst2q_f32(o + 2 * k, z);
+
+        const float32x4_t n = vaddq_f32(vmulq_f32(z.val[0], z.val[0]),
+                                        vmulq_f32(z.val[1], z.val[1]));
+        m = vmaxq_f32(m, n);
+    }
+
+    float32x2_t m2 = vpmax_f32(vget_low_f32(m), vget_high_f32(m));
+    m2 = vpmax_f32(m2, m2);
+    float mn = vget_lane_f32(m2, 0);
+
+    decimate2_portable(in + 2 * k, out + k, num_out - k, &mn);
+    if (maxnorm) {
+        *maxnorm = std::max(*maxnorm, mn);
+    }
+}
+
+static const Kernels neon_kernels = {
+    "neon",
+    u8_neon,
+    s8_neon,
+    s16le_neon,
+    s16be_neon,
+    decimate2_neon,
+};
+
+#endif
+
+/********************************* Dispatch **********************************/
+
+std::vector<const Kernels*> availableKernels()
+{
+    std::vector<const Kernels*> k = { &portable_kernels };
+#ifdef IQCONVERT_AVX2
+    if (cpu_has_avx2()) {
+        k.push_back(&avx2_kernels);
+    }
+#endif
+#ifdef IQCONVERT_NEON
+    k.push_back(&neon_kernels);
+#endif
+    return k;
+}
+
+const Kernels& kernels()
+{
+    static const Kernels& best = *availableKernels().back();
+    return best;
+}
+
+void u8(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    kernels().u8(in, out, num_samples);
+}
+
+void s8(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples)
+{
+    kernels().s8(in, out, num_samples);
+}
+
+void s16le(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    kernels().s16le(in, out, num_samples, scale);
+}
+
+void s16be(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale)
+{
+    kernels().s16be(in, out, num_samples, scale);
+}
+
+void decimate2(const DSPCOMPLEX *in, DSPCOMPLEX *out, size_t num_out, float *maxnorm)
+{
+    kernels().decimate2(in, out, num_out, maxnorm);
+}
+
+}
@@ -0,0 +1,89 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef __IQ_CONVERT
+#define __IQ_CONVERT
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "dab-constants.h"
+
+/* Conversion of interleaved integer IQ samples, as delivered by the
+ * devices and found in recordings, into DSPCOMPLEX. All functions write
+ * directly into the caller's buffer, so that the inputs can convert from
+ * their ring buffer into the buffer of the OFDM processor in one pass.
+ *
+ * The best kernel for the CPU is selected at first use: AVX2 on x86 if
+ * the CPU supports it, NEON on ARM, otherwise a portable version using
+ * lookup tables for the 8-bit formats. All kernels give bit-identical
+ * results, because the scale factors used by the inputs are powers of two.
+ *
+ * num_samples always counts complex samples, and the input need not be
+ * aligned. */
+namespace iqconvert {
+
+// Unsigned 8-bit with an offset of 128 (RTL-SDR), scaled to [-1, 1)
+void u8(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples);
+
+// Signed 8-bit, scaled to [-1, 1)
+void s8(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples);
+
+// Signed 16-bit of the given byte order, multiplied by scale
+void s16le(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale = 1.0f);
+void s16be(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples, float scale = 1.0f);
+
+// Signed 16-bit in host byte order
+inline void s16(const int16_t *in, DSPCOMPLEX *out, size_t num_samples, float scale = 1.0f)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    s16be(reinterpret_cast<const uint8_t*>(in), out, num_samples, scale);
+#else
+    s16le(reinterpret_cast<const uint8_t*>(in), out, num_samples, scale);
+#endif
+}
+
+// Decimate by two by averaging pairs of samples: out[k] = 0.5 * (in[2k] + in[2k+1]).
+// If maxnorm is not nullptr, it is raised to the largest |out[k]|^2.
+void decimate2(const DSPCOMPLEX *in, DSPCOMPLEX *out, size_t num_out, float *maxnorm = nullptr);
+
+struct Kernels {
+    const char *name;
+    void (*u8)(const uint8_t*, DSPCOMPLEX*, size_t);
+    void (*s8)(const uint8_t*, DSPCOMPLEX*, size_t);
+    void (*s16le)(const uint8_t*, DSPCOMPLEX*, size_t, float);
+    void (*s16be)(const uint8_t*, DSPCOMPLEX*, size_t, float);
+    void (*decimate2)(const DSPCOMPLEX*, DSPCOMPLEX*, size_t, float*);
+};
+
+// The kernels used by the functions above
+const Kernels& kernels();
+
+// All kernels this CPU can run, the portable one first. For tests and benchmarks.
+std::vector<const Kernels*> availableKernels();
+
+}
+
+#endif
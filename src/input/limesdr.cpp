@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include "limesdr.h"
+#include "iq_convert.h"
 
 // For Qt translation if Qt is existing
 #ifdef QT_CORE_LIB
@@ -45,8 +46,8 @@ lms_info_str_t limedevices [10];
 
 CLimeSDR::CLimeSDR(RadioControllerInterface &radioController) :
     radioController(radioController),
-    SampleBuffer(256 * 1024),
-    SpectrumSampleBuffer(8192)
+    SampleBuffer(256 * 1024, true),
+    SpectrumSampleBuffer(8192, true)
 {
     std::clog << "LimeSDR: " << "Open LimeSDR" << std::endl;
 
@@ -171,6 +172,7 @@ bool CLimeSDR::restart(void)
 {
     if (running)
         return true;
+    resetStallTimer();
     LMS_SetLOFrequency (theDevice, LMS_CH_RX, 0, freq);
     stream. isTx            = false;
     stream. channel         = 0;
@@ -205,12 +207,17 @@ void CLimeSDR::limesdr_thread_run()
         res = LMS_RecvStream (&stream, localBuffer,
                               FIFO_SIZE,  &meta, 1000);
         if (res > 0) {
-            std::vector<DSPCOMPLEX> temp(res);
-            for (int i = 0; i < res; i ++) {
-                temp[i] = DSPCOMPLEX(localBuffer[2*i] / 2048.0, localBuffer[2*i+1] / 2048.0);
-            }
-            SampleBuffer.putDataIntoBuffer (temp.data(), res);
-            SpectrumSampleBuffer.putDataIntoBuffer (temp.data(), res);
+            // Convert directly into the ring
+            const int16_t *iq = localBuffer;
+            const size_t written = SampleBuffer.writeInPlace (res,
+                    [&](DSPCOMPLEX *dst, size_t count) {
+                        iqconvert::s16 (iq, dst, count, 1.0f / 2048.0f);
+                        SpectrumSampleBuffer.push (dst, count);
+                        putIntoRecordBuffer (*reinterpret_cast<const uint8_t*>(dst),
+                                count * sizeof(DSPCOMPLEX));
+                        iq += 2 * count;
+                    });
+            countSamples(res, written);
             amountRead += res;
             res = LMS_GetStreamStatus (&stream, &streamStatus);
             underruns += streamStatus. underrun;
@@ -245,18 +252,18 @@ void CLimeSDR::stop(void)
 
 void CLimeSDR::reset(void)
 {
-    SampleBuffer.FlushRingBuffer();
+    SampleBuffer.flush();
 }
 
 int32_t CLimeSDR::getSamples(DSPCOMPLEX* Buffer, int32_t Size)
 {
-    return SampleBuffer.getDataFromBuffer(Buffer, Size);
+    return SampleBuffer.pop(Buffer, Size);
 }
 
 std::vector<DSPCOMPLEX> CLimeSDR::getSpectrumSamples(int size)
 {
     std::vector<DSPCOMPLEX> buf(size);
-    int sizeRead = SpectrumSampleBuffer.getDataFromBuffer(buf.data(), size);
+    int sizeRead = SpectrumSampleBuffer.pop(buf.data(), size);
     if (sizeRead < size) {
         buf.resize(sizeRead);
     }
@@ -265,7 +272,7 @@ std::vector<DSPCOMPLEX> CLimeSDR::getSpectrumSamples(int size)
 
 int32_t CLimeSDR::getSamplesToRead(void)
 {
-    return SampleBuffer.GetRingBufferReadAvailable();
+    return SampleBuffer.readAvailable();
 }
 
 int CLimeSDR::getGainCount()
@@ -37,7 +37,7 @@
 #include "virtual_input.h"
 #include "dab-constants.h"
 #include "MathHelper.h"
-#include "ringbuffer.h"
+#include "spsc_ring.h"
 
 
 class CLimeSDR : public CVirtualInput {
@@ -67,6 +67,12 @@ public:
     void setVFOFrequency(int32_t);
     int32_t	getVFOFrequency();
 
+protected:
+    // Recorded after the conversion to DSPCOMPLEX
+    IQRecorder::Format getRecordFormat() const override {
+        return IQRecorder::Format::CF32;
+    }
+
 private:
     void limesdr_thread_run(void);
 
@@ -82,8 +88,8 @@ private:
     int currentLinearityGain = 10;
 
     bool sw_agc = false;
-    RingBuffer<DSPCOMPLEX> SampleBuffer;
-    RingBuffer<DSPCOMPLEX> SpectrumSampleBuffer;
+    SpscRing<DSPCOMPLEX> SampleBuffer;
+    SpscRing<DSPCOMPLEX> SpectrumSampleBuffer;
 };
 
 #endif // __LIMESDR__
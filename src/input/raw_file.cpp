@@ -30,6 +30,9 @@
  *
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <iostream>
 #include <fcntl.h>
@@ -38,8 +41,13 @@
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include "raw_file.h"
+#include "iq_convert.h"
 
 // For Qt translation if Qt is existing
 #ifdef QT_CORE_LIB
@@ -66,8 +74,8 @@ CRAWFile::CRAWFile(RadioControllerInterface& radioController,
     fileName(""),
     fileFormat(CRAWFileFormat::Unknown),
     IQByteSize(1),
-    SampleBuffer(INPUT_FRAMEBUFFERSIZE),
-    SpectrumSampleBuffer(8*2048)
+    SampleBuffer(INPUT_FRAMEBUFFERSIZE, true),
+    SpectrumSampleBuffer(8*2048, true)
 {
 }
 
@@ -83,6 +91,12 @@ CRAWFile::~CRAWFile(void)
             fclose(filePointer);
         }
     }
+
+#if !defined(_WIN32)
+    if (mappedData) {
+        munmap(const_cast<uint8_t*>(mappedData), mappedLength);
+    }
+#endif
 }
 
 void CRAWFile::setFrequency(int Frequency)
@@ -92,13 +106,18 @@ void CRAWFile::setFrequency(int Frequency)
 
 int CRAWFile::getFrequency() const
 {
+    if (hasMetadata and not metadata.captures.empty()) {
+        return (int)metadata.captures.front().frequency;
+    }
     return 0;
 }
 
 bool CRAWFile::restart(void)
 {
-    if (readerOK)
+    if (readerOK) {
         readerPausing = false;
+        resetStallTimer();
+    }
     return readerOK;
 }
 
@@ -119,7 +138,12 @@ void CRAWFile::reset()
 
 void CRAWFile::rewind()
 {
-    if (filePointer) {
+    if (mappedData) {
+        mappedPos = 0;
+        decodedSamples = 0;
+        endReached = false;
+    }
+    else if (filePointer) {
         fseek(filePointer, 0, SEEK_SET);
         endReached = false;
     }
@@ -157,6 +181,34 @@ CDeviceID CRAWFile::getID()
     return CDeviceID::RAWFILE;
 }
 
+int CRAWFile::getSampleRate() const
+{
+    return sampleRate;
+}
+
+bool CRAWFile::setSampleRate(int rate)
+{
+    // The rate of a SigMF recording is known
+    if (rate <= 0 or (hasMetadata and metadata.sampleRate > 0)) {
+        return rate == sampleRate;
+    }
+
+    sampleRate = rate;
+    return true;
+}
+
+IQRecorder::Format CRAWFile::getRecordFormat() const
+{
+    // The file bytes are recorded unchanged
+    switch (fileFormat) {
+        case CRAWFileFormat::S8: return IQRecorder::Format::S8;
+        case CRAWFileFormat::S16LE: return IQRecorder::Format::S16LE;
+        case CRAWFileFormat::S16BE: return IQRecorder::Format::S16BE;
+        case CRAWFileFormat::COMPLEXF: return IQRecorder::Format::CF32;
+        default: return IQRecorder::Format::U8;
+    }
+}
+
 bool ends_with(const std::string& value, const std::string& ending)
 {
     if (ending.size() > value.size()) return false;
@@ -168,19 +220,40 @@ void CRAWFile::setFileName(const std::string& fileName,
 {
     this->fileName = fileName;
 
+    // Given the metadata of a SigMF recording, play its data file
+    if (ends_with(fileName, ".sigmf-meta")) {
+        sigmf::Metadata meta;
+        if (sigmf::read(fileName, meta) and not meta.dataset.empty()) {
+            const size_t dir = fileName.find_last_of('/');
+            this->fileName = (dir == std::string::npos ? "" : fileName.substr(0, dir + 1)) +
+                meta.dataset;
+        }
+        else {
+            this->fileName = fileName.substr(0, fileName.size() -
+                    strlen(".sigmf-meta")) + ".sigmf-data";
+        }
+    }
+
     setFileFormat(fileFormat);
 
-    filePointer = fopen(fileName.c_str(), "rb");
+    if (fileFormat == "auto" and this->fileFormat == CRAWFileFormat::Unknown) {
+        return;
+    }
+
+    filePointer = fopen(this->fileName.c_str(), "rb");
     if (filePointer == nullptr) {
-        std::clog << "RAWFile: Cannot open file: " << fileName << std::endl;
+        std::clog << "RAWFile: Cannot open file: " << this->fileName << std::endl;
         radioController.onMessage(message_level_t::Error,
-                QT_TRANSLATE_NOOP("CRadioController", "Cannot open file "), fileName);
+                QT_TRANSLATE_NOOP("CRadioController", "Cannot open file "), this->fileName);
         return;
     }
 
     readerOK = true;
     readerPausing = true;
     currPos = 0;
+    if (not throttle and mapFile(fileno(filePointer))) {
+        return;
+    }
     thread = std::thread(&CRAWFile::run, this);
 }
 
@@ -201,6 +274,9 @@ void CRAWFile::setFileHandle(int handle, const std::string& fileFormat)
     readerOK = true;
     readerPausing = true;
     currPos = 0;
+    if (not throttle and mapFile(fileno(filePointer))) {
+        return;
+    }
     thread = std::thread(&CRAWFile::run, this);
 }
 
@@ -215,7 +291,10 @@ int32_t CRAWFile::getSamples(DSPCOMPLEX* V, int32_t size)
     if (filePointer == nullptr)
         return 0;
 
-    while ((int32_t)(SampleBuffer.GetRingBufferReadAvailable()) < IQByteSize * size)
+    if (mappedData)
+        return getMappedSamples(V, size);
+
+    while ((int32_t)(SampleBuffer.readAvailable()) < IQByteSize * size)
         if (readerPausing)
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         else
@@ -226,6 +305,15 @@ int32_t CRAWFile::getSamples(DSPCOMPLEX* V, int32_t size)
 
 std::vector<DSPCOMPLEX> CRAWFile::getSpectrumSamples(int size)
 {
+    if (mappedData) {
+        // The samples the receiver got last, straight from the file
+        const size_t end = mappedPos;
+        const size_t num = std::min<size_t>(size, end);
+        std::vector<DSPCOMPLEX> buffer(num);
+        convert(mappedData + (end - num) * IQByteSize, buffer.data(), num);
+        return buffer;
+    }
+
     std::vector<DSPCOMPLEX> buffer(size);
 
     int sizeRead = convertSamples(SpectrumSampleBuffer, buffer.data(), size);
@@ -238,14 +326,19 @@ std::vector<DSPCOMPLEX> CRAWFile::getSpectrumSamples(int size)
 
 int32_t CRAWFile::getSamplesToRead(void)
 {
-    return SampleBuffer.GetRingBufferReadAvailable() / 2;
+    if (mappedData) {
+        // Like the reader thread, which gives zeros after the end,
+        // a mapped file never makes the receiver wait.
+        return readerPausing ? 0 : INT32_MAX;
+    }
+
+    return SampleBuffer.readAvailable() / 2;
 }
 
 void CRAWFile::run(void)
 {
     int32_t t;
     int32_t bufferSize = 32768;
-    int32_t period;
     int64_t nextStop;
 
     if (!readerOK)
@@ -253,10 +346,6 @@ void CRAWFile::run(void)
 
     ExitCondition = false;
 
-    period = (32768 * 1000) / (IQByteSize * 2048); // full IQs read
-
-    std::clog << "RAWFile" << "Period =" << period << std::endl;
-    std::vector<uint8_t> bi(bufferSize);
     nextStop = getMyTime();
     while (!ExitCondition) {
         if (readerPausing) {
@@ -265,22 +354,29 @@ void CRAWFile::run(void)
             continue;
         }
 
-        while (SampleBuffer.WriteSpace() < bufferSize + 10) {
+        while ((int32_t)SampleBuffer.writeAvailable() < bufferSize + 10) {
             if (ExitCondition)
                 break;
             std::this_thread::sleep_for(std::chrono::microseconds(100));
         }
 
-        nextStop += period;
-        t = readBuffer(bi.data(), bufferSize);
+        // Read the file directly into the ring
+        const auto bi = SampleBuffer.reserve(bufferSize);
+        t = readBuffer(bi.data, bi.size);
         if (t <= 0) {
-            for (int i = 0; i < bufferSize; i++)
-                bi[i] = 0;
-            t = bufferSize;
+            std::fill(bi.begin(), bi.end(), 0);
+            t = bi.size;
         }
-        SampleBuffer.putDataIntoBuffer(bi.data(), t);
-        SpectrumSampleBuffer.putDataIntoBuffer(bi.data(), t);
-        putIntoRecordBuffer(*bi.data(), t);
+        // Only whole samples, so that the ring never splits one
+        t -= t % IQByteSize;
+        SampleBuffer.commit(t);
+        countSamples(t / IQByteSize, t / IQByteSize);
+
+        // The consumer never modifies the data, it can still be read here
+        SpectrumSampleBuffer.push(bi.data, t);
+        putIntoRecordBuffer(*bi.data, t);
+
+        nextStop += (int64_t)t * 1000000 / ((int64_t)IQByteSize * sampleRate); // full IQs read
         int64_t t_to_wait = nextStop - getMyTime();
         if (throttle and t_to_wait > 0)
             std::this_thread::sleep_for(std::chrono::microseconds(t_to_wait));
@@ -308,8 +404,8 @@ int32_t CRAWFile::readBuffer(uint8_t* data, int32_t length)
             std::clog << "RAWFile:"  << "End of file, restarting" << std::endl;
             radioController.onMessage(message_level_t::Information,
                     QT_TRANSLATE_NOOP("CRadioController", "End of file, restarting"));
-            SampleBuffer.FlushRingBuffer();
-            SpectrumSampleBuffer.FlushRingBuffer();
+            SampleBuffer.flush();
+            SpectrumSampleBuffer.flush();
             radioController.onRestartService();
         }
         else {
@@ -321,52 +417,217 @@ int32_t CRAWFile::readBuffer(uint8_t* data, int32_t length)
     return n & ~01;
 }
 
-int32_t CRAWFile::convertSamples(RingBuffer<uint8_t>& Buffer, DSPCOMPLEX *V, int32_t size)
+int32_t CRAWFile::convertSamples(SpscRing<uint8_t>& Buffer, DSPCOMPLEX *V, int32_t size)
 {
-    // Native endianness complex<float> requires no conversion
-    if (fileFormat == CRAWFileFormat::COMPLEXF) {
-        int32_t amount = Buffer.getDataFromBuffer(V, IQByteSize * size);
-        return amount / IQByteSize;
-    }
+    // Convert in place from the ring buffer. The reader thread only
+    // writes whole samples, so no part ends in the middle of one.
+    const size_t amount = Buffer.readInPlace((size_t)IQByteSize * size,
+            [&](const uint8_t *temp, size_t len) {
+        const size_t num = len / IQByteSize;
+        convert(temp, V, num);
+        V += num;
+    });
 
-    std::vector<uint8_t> temp((size_t)IQByteSize * (size_t)size);
+    return amount / IQByteSize;
+}
 
-    int32_t amount = Buffer.getDataFromBuffer(temp.data(), IQByteSize * size);
+void CRAWFile::convert(const uint8_t *in, DSPCOMPLEX *out, size_t num_samples) const
+{
+    switch (fileFormat) {
+        // Native endianness complex<float> requires no conversion
+        case CRAWFileFormat::COMPLEXF:
+            memcpy(out, in, num_samples * sizeof(DSPCOMPLEX));
+            break;
+        case CRAWFileFormat::U8:
+            iqconvert::u8(in, out, num_samples);
+            break;
+        case CRAWFileFormat::S8:
+            iqconvert::s8(in, out, num_samples);
+            break;
+        case CRAWFileFormat::S16LE:
+            iqconvert::s16le(in, out, num_samples);
+            break;
+        case CRAWFileFormat::S16BE:
+            iqconvert::s16be(in, out, num_samples);
+            break;
+        case CRAWFileFormat::Unknown:
+            break;
+    }
+}
 
-    // Unsigned 8-bit
-    if (fileFormat == CRAWFileFormat::U8) {
-        for (int i = 0; i < amount / 2; i++)
-            V[i] = DSPCOMPLEX(float(temp[2 * i] - 128) / 128.0,
-                              float(temp[2 * i + 1] - 128) / 128.0);
+bool CRAWFile::mapFile(int fd)
+{
+#if !defined(_WIN32)
+    struct stat st;
+    if (fd < 0 or fstat(fd, &st) != 0 or not S_ISREG(st.st_mode) or
+            st.st_size < IQByteSize or
+            (uint64_t)st.st_size > SIZE_MAX) {
+        return false;
     }
-    // Signed 8-bit
-    else if (fileFormat == CRAWFileFormat::S8) {
-        for (int i = 0; i < amount / 2; i++)
-            V[i] = DSPCOMPLEX(float((int8_t)temp[2 * i]) / 128.0,
-                              float((int8_t)temp[2 * i + 1]) / 128.0);
+
+    const size_t length = st.st_size;
+    void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        // E.g. a file larger than the address space on 32-bit systems
+        perror("RAWFile: mmap");
+        return false;
     }
-    // Signed 16-bit little endian
-    else if (fileFormat == CRAWFileFormat::S16LE) {
-        for (int i = 0, j = 0; i < amount / 4; i++, j+= IQByteSize) {
-            int16_t IQ_I = (int16_t)(temp[j + 0] << 8) | temp[j + 1];
-            int16_t IQ_Q = (int16_t)(temp[j + 2] << 8) | temp[j + 3];
-            V[i] = DSPCOMPLEX((float)(IQ_I), (float)(IQ_Q));
-        }
+
+    // The file is read once from start to end, let the kernel read ahead
+    // aggressively and drop the pages behind us early.
+    madvise(p, length, MADV_SEQUENTIAL);
+
+    mappedData = static_cast<const uint8_t*>(p);
+    mappedLength = length;
+    mappedSamples = length / IQByteSize;
+    mappedPos = 0;
+    decodedSamples = 0;
+    std::clog << "RAWFile: " << "Mapped " << length << " bytes" << std::endl;
+    return true;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+int32_t CRAWFile::getMappedSamples(DSPCOMPLEX *V, int32_t size)
+{
+    if (decodedSamples == 0) {
+        decodeStart = std::chrono::steady_clock::now();
     }
-    // Signed 16-bit big endian
-    else if (fileFormat == CRAWFileFormat::S16BE) {
-        for (int i = 0, j = 0; i < amount / 4; i++, j += IQByteSize) {
-            int16_t IQ_I = (int16_t)(temp[j + 1] << 8) | temp[j + 0];
-            int16_t IQ_Q = (int16_t)(temp[j + 3] << 8) | temp[j + 2];
-            V[i] = DSPCOMPLEX((float)(IQ_I), (float)(IQ_Q));
+
+    size_t pos = mappedPos;
+    int32_t done = 0;
+    while (done < size) {
+        if (pos == mappedSamples) {
+            if (autoRewind) {
+                pos = 0;
+                std::clog << "RAWFile:"  << "End of file, restarting" << std::endl;
+                radioController.onMessage(message_level_t::Information,
+                        QT_TRANSLATE_NOOP("CRadioController", "End of file, restarting"));
+                radioController.onRestartService();
+            }
+            else {
+                if (not endReached) {
+                    radioController.onMessage(message_level_t::Information,
+                            QT_TRANSLATE_NOOP("CRadioController", "End of file"));
+                    reportRealTimeFactor();
+                    endReached = true;
+                }
+                // Zeros after the end, like the reader thread
+                std::fill(V + done, V + size, DSPCOMPLEX(0, 0));
+                done = size;
+                break;
+            }
         }
+
+        const size_t n = std::min<size_t>(size - done, mappedSamples - pos);
+        const uint8_t *in = mappedData + pos * IQByteSize;
+        convert(in, V + done, n);
+        putIntoRecordBuffer(*in, n * IQByteSize);
+        pos += n;
+        done += n;
+        decodedSamples += n;
     }
 
-    return amount / IQByteSize;
+    mappedPos = pos;
+    countSamples(done, done);
+    return done;
+}
+
+void CRAWFile::reportRealTimeFactor()
+{
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - decodeStart;
+    const double duration = (double)decodedSamples / sampleRate;
+    realTimeFactor = elapsed.count() > 0 ? duration / elapsed.count() : 0;
+
+    std::clog << "RAWFile: " << duration << " s of IQ decoded in " <<
+        elapsed.count() << " s, " << realTimeFactor << "x real time" << std::endl;
+}
+
+// Returns false if the SigMF datatype cannot be played
+static bool format_from_datatype(const std::string& datatype,
+        CRAWFileFormat& format, uint8_t& size)
+{
+    if (datatype == "cu8") {
+        format = CRAWFileFormat::U8;
+        size = 2;
+    }
+    else if (datatype == "ci8") {
+        format = CRAWFileFormat::S8;
+        size = 2;
+    }
+    else if (datatype == "ci16_le") {
+        format = CRAWFileFormat::S16LE;
+        size = 4;
+    }
+    else if (datatype == "ci16_be") {
+        format = CRAWFileFormat::S16BE;
+        size = 4;
+    }
+    else if (datatype == "cf32_le" or datatype == "cf32") {
+        format = CRAWFileFormat::COMPLEXF;
+        size = 8;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+bool CRAWFile::readMetadata()
+{
+    hasMetadata = sigmf::read(sigmf::metaPath(fileName), metadata);
+    if (not hasMetadata) {
+        return false;
+    }
+
+    std::clog << "RAWFile: SigMF " << metadata.datatype << " at " <<
+        metadata.sampleRate << " sps, " << getFrequency() << " Hz";
+    const uint64_t no_sync = sigmf::annotatedSamples(metadata, sigmf::SYNC_LOSS_LABEL);
+    if (no_sync > 0) {
+        std::clog << ", " << no_sync << " samples without sync";
+    }
+    std::clog << std::endl;
+
+    if (metadata.sampleRate > 0) {
+        sampleRate = (int)metadata.sampleRate;
+    }
+
+    if (sampleRate != INPUT_RATE) {
+        std::clog << "RAWFile: the sample rate is not " << INPUT_RATE << " sps" <<
+            (sampleRate % INPUT_RATE == 0 ? ", the file needs a channelizer" : "") << std::endl;
+    }
+
+    if (not metadata.encoding.empty() or
+            not format_from_datatype(metadata.datatype, fileFormat, IQByteSize)) {
+        std::clog << "RAWFile: cannot play SigMF datatype " << metadata.datatype <<
+            (metadata.encoding.empty() ? "" : " encoded as " + metadata.encoding) << std::endl;
+        fileFormat = CRAWFileFormat::Unknown;
+        radioController.onMessage(message_level_t::Error,
+                QT_TRANSLATE_NOOP("CRadioController", "Unknown RAW file format"));
+    }
+    return true;
+}
+
+bool CRAWFile::getMetadata(sigmf::Metadata& meta) const
+{
+    if (hasMetadata) {
+        meta = metadata;
+    }
+    return hasMetadata;
 }
 
 void CRAWFile::setFileFormat(const std::string &fileFormat)
 {
+    hasMetadata = false;
+
+    // The metadata of a SigMF recording has precedence over its name
+    if (fileFormat == "auto" and readMetadata()) {
+        return;
+    }
+
     if (fileFormat == "u8" or
             (fileFormat == "auto" and ends_with(fileName, ".u8.iq"))) {
         this->fileFormat = CRAWFileFormat::U8;
@@ -387,6 +648,16 @@ void CRAWFile::setFileFormat(const std::string &fileFormat)
         this->fileFormat = CRAWFileFormat::S16BE;
         IQByteSize = 4;
     }
+    // Older versions read s16le high byte first and s16be low byte
+    // first, files made for them play with the legacy formats
+    else if (fileFormat == "s16le-legacy") {
+        this->fileFormat = CRAWFileFormat::S16BE;
+        IQByteSize = 4;
+    }
+    else if (fileFormat == "s16be-legacy") {
+        this->fileFormat = CRAWFileFormat::S16LE;
+        IQByteSize = 4;
+    }
     else if(fileFormat == "cf32" or
             (fileFormat == "auto" and ends_with(fileName, ".cf32.iq"))) {
         this->fileFormat = CRAWFileFormat::COMPLEXF;
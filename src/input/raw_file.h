@@ -35,10 +35,12 @@
 
 #include <thread>
 #include <atomic>
+#include <chrono>
 
 #include "virtual_input.h"
 #include "dab-constants.h"
-#include "ringbuffer.h"
+#include "sigmf.h"
+#include "spsc_ring.h"
 #include "radio-controller.h"
 
 // Enum of available input device
@@ -69,6 +71,10 @@ public:
     std::string getDescription(void);
     CDeviceID getID(void);
 
+    // A file without SigMF metadata is taken to be at the given rate
+    int getSampleRate(void) const override;
+    bool setSampleRate(int rate) override;
+
     // Specific methods
     void setFileName(const std::string& FileName, const std::string& FileFormat);
     void setFileHandle(int handle, const std::string& fileFormat);
@@ -76,28 +82,62 @@ public:
 
     bool endWasReached() const { return endReached; }
 
+    // True if the file is read through a memory mapping. This is done when
+    // not throttled: the samples are then converted straight from the file
+    // into the receiver's buffer, as fast as the receiver asks for them.
+    bool isMapped() const { return mappedData != nullptr; }
+
+    // Duration of the decoded IQ divided by the time it took, available
+    // once the end of a mapped file was reached.
+    double getRealTimeFactor() const { return realTimeFactor; }
+
+    // The SigMF metadata found next to the file with the "auto" format.
+    // Batch jobs can use its annotations to skip unusable recordings.
+    bool getMetadata(sigmf::Metadata& meta) const;
+
+protected:
+    IQRecorder::Format getRecordFormat() const override;
+
 private:
     RadioControllerInterface& radioController;
     bool throttle;
     bool autoRewind;
     std::string fileName;
     CRAWFileFormat fileFormat;
+    sigmf::Metadata metadata;
+    bool hasMetadata = false;
+    int sampleRate = INPUT_RATE;
     uint8_t IQByteSize = 2;
 
     void run(void);
     int32_t readBuffer(uint8_t*, int32_t);
-    int32_t convertSamples(RingBuffer<uint8_t>& Buffer, DSPCOMPLEX* V, int32_t size);
+    int32_t convertSamples(SpscRing<uint8_t>& Buffer, DSPCOMPLEX* V, int32_t size);
+    void convert(const uint8_t* in, DSPCOMPLEX* out, size_t num_samples) const;
+    bool mapFile(int fd);
+    int32_t getMappedSamples(DSPCOMPLEX* V, int32_t size);
+    void reportRealTimeFactor(void);
     void setFileFormat(const std::string& fileFormat);
+    bool readMetadata(void);
 
-    RingBuffer<uint8_t> SampleBuffer;
-    RingBuffer<uint8_t> SpectrumSampleBuffer;
+    SpscRing<uint8_t> SampleBuffer;
+    SpscRing<uint8_t> SpectrumSampleBuffer;
     FILE* filePointer = nullptr;
     bool readerOK = false;
     bool readerPausing = false;
-    bool endReached = false;
+    // Set where the file is read, endWasReached() is called from other threads
+    std::atomic<bool> endReached = ATOMIC_VAR_INIT(false);
     std::atomic<bool> ExitCondition = ATOMIC_VAR_INIT(false);
     int64_t currPos = 0;
 
+    const uint8_t* mappedData = nullptr;
+    size_t mappedLength = 0;
+    size_t mappedSamples = 0;
+    // Only advanced by the thread calling getSamples()
+    std::atomic<size_t> mappedPos = ATOMIC_VAR_INIT(0);
+    size_t decodedSamples = 0;
+    std::chrono::steady_clock::time_point decodeStart;
+    double realTimeFactor = 0;
+
     std::thread thread;
 };
 
@@ -0,0 +1,124 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "radio-controller.h"
+
+// Converts complex samples between arbitrary rates. The low-pass filter
+// is stored as a bank of polyphase filters, and the filter for the exact
+// position of an output sample is interpolated linearly between the two
+// nearest phases. The cut-off is at half the lower rate; the input and
+// the interpolated taps are kept as separate I, Q and tap arrays so that
+// the dot product maps to SIMD registers.
+class Resampler {
+    public:
+        Resampler(int inputRate, int outputRate, int phases = 256);
+
+        int getInputRate() const { return inputRate; }
+        int getOutputRate() const { return outputRate; }
+
+        // Taps per output sample, a measure of the CPU cost
+        size_t getNumTaps() const { return numTaps; }
+
+        // Appends the outputs for num_samples input samples to out. The
+        // filter is centred, so output n is at the time of input
+        // n * inputRate / outputRate.
+        void process(const DSPCOMPLEX *in, size_t num_samples,
+                std::vector<DSPCOMPLEX>& out);
+
+        void reset();
+
+    private:
+        const int inputRate;
+        const int outputRate;
+        const int numPhases;
+        size_t numTaps = 0;
+
+        // numPhases + 1 filters of numTaps, and the differences between
+        // consecutive ones for the interpolation
+        std::vector<float> bank;
+        std::vector<float> slope;
+        std::vector<float> taps;
+
+        // Input history followed by the new samples
+        std::vector<float> bufferRe;
+        std::vector<float> bufferIm;
+
+        // Time of the next output in input samples, relative to the
+        // beginning of the buffer
+        double position = 0;
+        const double step;
+};
+
+// Gives the samples of an input at INPUT_RATE, whatever the rate of the
+// input. Inputs already at INPUT_RATE are passed through untouched. All
+// other calls are forwarded.
+class ResamplingInput : public InputInterface {
+    public:
+        explicit ResamplingInput(InputInterface& input);
+
+        void setFrequency(int frequency) override;
+        int getFrequency(void) const override;
+        bool is_ok(void) override;
+        bool restart(void) override;
+        void stop(void) override;
+        void reset(void) override;
+        int32_t getSamples(DSPCOMPLEX *buffer, int32_t size) override;
+        std::vector<DSPCOMPLEX> getSpectrumSamples(int size) override;
+        int32_t getSamplesToRead(void) override;
+        float setGain(int gain) override;
+        float getGain(void) const override;
+        int getGainCount(void) override;
+        void setAgc(bool agc) override;
+        std::string getDescription(void) override;
+        uint64_t getDiscontinuityCount(void) const override;
+        int64_t getSamplesBeforeDiscontinuity(void) override;
+        bool setDeviceParam(DeviceParam param, int value) override;
+        bool setDeviceParam(DeviceParam param, const std::string& value) override;
+
+        bool isResampling() const { return (bool)resampler; }
+
+    private:
+        // Set up the resampler for the rate of the input
+        void configure();
+
+        // Resample what the input has
+        void fill();
+
+        InputInterface& input;
+        std::unique_ptr<Resampler> resampler;
+
+        std::vector<DSPCOMPLEX> inputBuffer;
+        std::vector<DSPCOMPLEX> pending;
+        size_t pendingStart = 0;
+};
+
+#endif // RESAMPLER_H
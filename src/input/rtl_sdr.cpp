@@ -34,6 +34,7 @@
 #include <exception>
 
 #include "rtl_sdr.h"
+#include "iq_convert.h"
 
 // For Qt translation if Qt is existing
 #ifdef QT_CORE_LIB
@@ -55,8 +56,8 @@ int __attribute__((weak)) rtlsdr_set_bias_tee(rtlsdr_dev_t *dev, int on)
 
 CRTL_SDR::CRTL_SDR(RadioControllerInterface& radioController) :
     radioController(radioController),
-    sampleBuffer(1024 * 1024),
-    spectrumSampleBuffer(8192)
+    sampleBuffer(1024 * 1024, true),
+    spectrumSampleBuffer(8192, true)
 {
     open_device();
 }
@@ -154,8 +155,9 @@ bool CRTL_SDR::restart(void)
         return true;
     }
 
-    sampleBuffer.FlushRingBuffer();
-    spectrumSampleBuffer.FlushRingBuffer();
+    sampleBuffer.flush();
+    spectrumSampleBuffer.flush();
+    resetStallTimer();
     ret = rtlsdr_reset_buffer(device);
     if (ret < 0)
         return false;
@@ -312,50 +314,40 @@ void CRTL_SDR::agc_timer_thread(void)
     }
 }
 
-int32_t CRTL_SDR::getSamples(DSPCOMPLEX *buffer, int32_t size)
+// Normalise the samples straight out of the ring, without an
+// intermediate copy. Returns the number of complex samples.
+static int32_t convertSamples(SpscRing<uint8_t>& ring,
+        DSPCOMPLEX *buffer, int32_t size)
 {
-    std::vector<uint8_t> tempBuffer(2 * size);
-
-    int32_t amount = sampleBuffer.getDataFromBuffer(tempBuffer.data(), 2 * size);
-
-    // Normalise samples
-    for (int i = 0; i < amount / 2; i++) {
-        buffer[i] = DSPCOMPLEX(
-                (float(tempBuffer[2 * i] - 128)) / 128.0,
-                (float(tempBuffer[2 * i + 1] - 128)) / 128.0);
-    }
+    const size_t amount = ring.readInPlace(2 * size,
+            [&](const uint8_t *iq, size_t len) {
+                iqconvert::u8(iq, buffer, len / 2);
+                buffer += len / 2;
+            });
 
     return amount / 2;
 }
 
-std::vector<DSPCOMPLEX> CRTL_SDR::getSpectrumSamples(int size)
+int32_t CRTL_SDR::getSamples(DSPCOMPLEX *buffer, int32_t size)
 {
-    std::vector<uint8_t> tempBuffer(2 * size);
-
-    // Get samples
-    int32_t amount = spectrumSampleBuffer.getDataFromBuffer(
-            tempBuffer.data(), 2 * size);
-
-    std::vector<DSPCOMPLEX> buffer(amount / 2);
-
-    // Convert samples into generic format
-    for (int i = 0; i < amount / 2; i++) {
-        buffer[i] = DSPCOMPLEX(
-                (float(tempBuffer[2 * i] - 128)) / 128.0,
-                (float(tempBuffer[2 * i + 1] - 128)) / 128.0);
-    }
+    return convertSamples(sampleBuffer, buffer, size);
+}
 
+std::vector<DSPCOMPLEX> CRTL_SDR::getSpectrumSamples(int size)
+{
+    std::vector<DSPCOMPLEX> buffer(size);
+    buffer.resize(convertSamples(spectrumSampleBuffer, buffer.data(), size));
     return buffer;
 }
 
 int32_t CRTL_SDR::getSamplesToRead(void)
 {
-    return sampleBuffer.GetRingBufferReadAvailable() / 2;
+    return sampleBuffer.readAvailable() / 2;
 }
 
 void CRTL_SDR::reset(void)
 {
-    sampleBuffer.FlushRingBuffer();
+    sampleBuffer.flush();
 }
 
 void CRTL_SDR::rtlsdr_read_callback(uint8_t* buf, uint32_t len, void* ctx)
@@ -368,11 +360,12 @@ void CRTL_SDR::rtlsdr_read_callback(uint8_t* buf, uint32_t len, void* ctx)
             return;
         }
 
-        int32_t tmp = rtlsdr->sampleBuffer.putDataIntoBuffer(buf, len);
+        int32_t tmp = rtlsdr->sampleBuffer.push(buf, len);
         if ((len - tmp) > 0)
             rtlsdr->sampleCounter += len - tmp;
+        rtlsdr->countSamples(len / 2, tmp / 2);
 
-        rtlsdr->spectrumSampleBuffer.putDataIntoBuffer(buf, len);
+        rtlsdr->spectrumSampleBuffer.push(buf, len);
         rtlsdr->putIntoRecordBuffer(*buf, len);
 
         // Check if device is overloaded
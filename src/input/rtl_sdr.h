@@ -42,7 +42,7 @@
 #include "virtual_input.h"
 #include "dab-constants.h"
 #include "MathHelper.h"
-#include "ringbuffer.h"
+#include "spsc_ring.h"
 #include "radio-controller.h"
 
 // This class is a simple wrapper around the
@@ -94,8 +94,8 @@ private:
 
     void agc_timer_thread(void);
 
-    RingBuffer<uint8_t> sampleBuffer;
-    RingBuffer<uint8_t> spectrumSampleBuffer;
+    SpscRing<uint8_t> sampleBuffer;
+    SpscRing<uint8_t> spectrumSampleBuffer;
     struct rtlsdr_dev *device = nullptr;
     int32_t sampleCounter = 0;
 
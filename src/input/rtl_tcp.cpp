@@ -30,10 +30,12 @@
  *
  */
 
+#include <algorithm>
 #include <iostream>
 #include <sys/time.h>
 
 #include "rtl_tcp.h"
+#include "iq_convert.h"
 
 // For Qt translation if Qt is existing
 #ifdef QT_CORE_LIB
@@ -70,11 +72,14 @@ static inline int64_t getMyTime(void)
     return ((int64_t)tv.tv_sec * 1000000 + (int64_t)tv.tv_usec);
 }
 
+// Received in one recv() if available, 16 ms of samples
+#define RECEIVE_CHUNK_SIZE 65536
+
 CRTL_TCP_Client::CRTL_TCP_Client(RadioControllerInterface& radioController) :
     radioController(radioController),
-    sampleBuffer(32 * 32768),
-    sampleNetworkBuffer(256 * 32768),
-    spectrumSampleBuffer(8192)
+    sampleBuffer(256 * 32768, true),
+    spectrumSampleBuffer(8192, true),
+    discardBuffer(RECEIVE_CHUNK_SIZE)
 {
     memset(&dongleInfo, 0, sizeof(dongle_info_t));
     dongleInfo.tuner_type = RTLSDR_TUNER_UNKNOWN;
@@ -103,13 +108,18 @@ bool CRTL_TCP_Client::restart(void)
         return true;
     }
 
-    rtlsdrRunning = true;
+    // The threads of a previous run may have ended on their own
+    if (receiveThread.joinable()) {
+        receiveThread.join();
+    }
+    if (agcThread.joinable()) {
+        agcThread.join();
+    }
 
-    networkBufferThread = std::thread(&CRTL_TCP_Client::networkBufferCopy, this);
-    networkBufferThread.detach();
+    resetStallTimer();
+    rtlsdrRunning = true;
 
     receiveThread = std::thread(&CRTL_TCP_Client::receiveAndReconnect, this);
-    receiveThread.detach();
 
     // Wait so that the other thread has a chance to establish the connection
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
@@ -132,47 +142,47 @@ void CRTL_TCP_Client::stop(void)
 
     std::unique_lock<std::mutex> lock(mutex);
 
-    // Close connection
-    sock.close();
-
-    agcRunning = false;
     rtlsdrRunning = false;
 
-    lock.unlock();
+    // Wake up the receive thread. The socket is only closed once it
+    // has ended, so that it never uses a stale descriptor.
+    sock.shutdown();
 
-    if (agcThread.joinable()) {
-        agcThread.join();
-    }
+    lock.unlock();
 
     if (receiveThread.joinable()) {
         receiveThread.join();
     }
 
-    if (networkBufferThread.joinable()) {
-        networkBufferThread.join();
+    // Only now, the receive thread might have started it
+    agcRunning = false;
+    if (agcThread.joinable()) {
+        agcThread.join();
     }
 
+    lock.lock();
+    sock.close();
     connected = false;
 }
 
 static int32_t read_convert_from_buffer(
-        RingBuffer<uint8_t>& buffer,
+        SpscRing<uint8_t>& buffer,
         DSPCOMPLEX *v, int32_t size)
 {
-    int32_t amount, i;
-    std::vector<uint8_t> tempBuffer(2 * size);
-
-    // Get data from the ring buffer
-    amount = buffer.getDataFromBuffer(tempBuffer.data(), 2 * size);
-    for (i = 0; i < amount / 2; i ++)
-        v[i] = DSPCOMPLEX(((float)tempBuffer[2 * i] - 128.0f) / 128.0f,
-                          ((float)tempBuffer[2 * i + 1] - 128.0f) / 128.0f);
+    // Convert in place from the ring buffer
+    const size_t amount = buffer.readInPlace(2 * size,
+            [&](const uint8_t *iq, size_t len) {
+                iqconvert::u8(iq, v, len / 2);
+                v += len / 2;
+            });
     return amount / 2;
 }
 
 int32_t CRTL_TCP_Client::getSamples(DSPCOMPLEX *v, int32_t size)
 {
-    return read_convert_from_buffer(sampleBuffer, v, size);
+    const int32_t read = read_convert_from_buffer(sampleBuffer, v, size);
+    samplesReleased += read;
+    return read;
 }
 
 std::vector<DSPCOMPLEX> CRTL_TCP_Client::getSpectrumSamples(int size)
@@ -187,34 +197,60 @@ std::vector<DSPCOMPLEX> CRTL_TCP_Client::getSpectrumSamples(int size)
 
 int32_t CRTL_TCP_Client::getSamplesToRead(void)
 {
-    return sampleBuffer.GetRingBufferReadAvailable() / 2;
+    // The buffer is filled to 50% before the first samples are released,
+    // and from then on the samples are released at the nominal rate. This
+    // keeps a reserve against an unsteady data rate, e.g. over WIFI.
+    if (not firstFilledNetworkBuffer) {
+        paceStart_us = 0;
+        return 0;
+    }
+
+    const int64_t available = sampleBuffer.readAvailable() / 2;
+    const int64_t now_us = getMyTime();
+    if (paceStart_us == 0 or available == 0) {
+        // Start over after an underrun, to build up the reserve again
+        paceStart_us = now_us;
+        samplesReleased = 0;
+    }
+
+    const int64_t due = (now_us - paceStart_us) * INPUT_RATE / 1000000 -
+        samplesReleased;
+    return std::max<int64_t>(0, std::min(due, available));
+}
+
+int64_t CRTL_TCP_Client::getSamplesBuffered(void)
+{
+    return sampleBuffer.readAvailable() / 2;
 }
 
 void CRTL_TCP_Client::reset(void)
 {
-    sampleBuffer.FlushRingBuffer();
-    sampleNetworkBuffer.FlushRingBuffer();
-    spectrumSampleBuffer.FlushRingBuffer();
+    sampleBuffer.flush();
+    spectrumSampleBuffer.flush();
     firstFilledNetworkBuffer = false;
 }
 
-void CRTL_TCP_Client::receiveData(void)
+ssize_t CRTL_TCP_Client::receive(uint8_t *data, size_t length)
 {
-    std::vector<uint8_t> buffer(8192);
-
-    size_t read = 0;
-
-    while (sock.valid() && read < buffer.size()) {
-        const size_t remain = buffer.size() - read;
-
-        ssize_t ret = sock.recv(buffer.data() + read, remain, 0);
+    // MSG_WAITALL returns once length bytes arrived, or with less at the
+    // receive timeout, which lets stop() be noticed.
+    while (rtlsdrRunning && sock.valid()) {
+        const ssize_t ret = sock.recv(data, length, MSG_WAITALL);
 
-        if (ret == 0) {
+        if (ret > 0) {
+            return ret;
+        }
+        else if (not rtlsdrRunning) {
+            // Woken up by stop()
+            break;
+        }
+        else if (ret == 0) {
             handleDisconnect();
         }
-        else if (ret == -1) {
+        else {
 #if defined(_WIN32)
             if (WSAGetLastError() == WSAEINTR ||
+                    WSAGetLastError() == WSAETIMEDOUT ||
                     WSAGetLastError() == WSAECONNABORTED ||
                     WSAGetLastError() == WSAENOTSOCK) {
                 continue;
@@ -223,12 +259,11 @@ void CRTL_TCP_Client::receiveData(void)
                 handleDisconnect();
             }
             else {
-                std::wstring s;
                 int error = WSAGetLastError();
                 throw std::runtime_error("RTL_TCP_CLIENT recv error: " +  std::to_string(error));
             }
 #else
-            if (errno == EAGAIN) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
                 continue;
             }
             else if (errno == EINTR) {
@@ -243,93 +278,114 @@ void CRTL_TCP_Client::receiveData(void)
             }
 #endif
         }
-        else {
-            read += ret;
-        }
+    }
 
-        if (not rtlsdrRunning) {
-            break;
+    return -1;
+}
+
+bool CRTL_TCP_Client::receiveDongleInfo(void)
+{
+    uint8_t *data = reinterpret_cast<uint8_t*>(&dongleInfo);
+    size_t read = 0;
+    while (read < sizeof(dongle_info_t)) {
+        const ssize_t ret = receive(data + read, sizeof(dongle_info_t) - read);
+        if (ret < 0) {
+            return false;
         }
+        read += ret;
     }
 
-    if (firstData) {
-        firstData = false;
-
-        // Get dongle information
-        ::memcpy(&dongleInfo, buffer.data(), sizeof(dongle_info_t));
-
-        // Convert the byte order
-        dongleInfo.tuner_type = ntohl(dongleInfo.tuner_type);
-        dongleInfo.tuner_gain_count = ntohl(dongleInfo.tuner_gain_count);
-
-        if(dongleInfo.magic[0] == 'R' &&
-                dongleInfo.magic[1] == 'T' &&
-                dongleInfo.magic[2] == 'L' &&
-                dongleInfo.magic[3] == '0') {
-            std::string TunerType;
-            switch(dongleInfo.tuner_type)
-            {
-                case RTLSDR_TUNER_UNKNOWN: TunerType = "Unknown"; break;
-                case RTLSDR_TUNER_E4000: TunerType = "E4000"; break;
-                case RTLSDR_TUNER_FC0012: TunerType = "FC0012"; break;
-                case RTLSDR_TUNER_FC0013: TunerType = "FC0013"; break;
-                case RTLSDR_TUNER_FC2580: TunerType = "FC2580"; break;
-                case RTLSDR_TUNER_R820T: TunerType = "R820T"; break;
-                case RTLSDR_TUNER_R828D: TunerType = "R828D"; break;
-                default: TunerType = "Unknown";
-            }
-            std::clog << "RTL_TCP_CLIENT: Tuner type: " <<
-                dongleInfo.tuner_type << " " << TunerType << std::endl;
-            std::clog << "RTL_TCP_CLIENT: Tuner gain count: " <<
-                dongleInfo.tuner_gain_count << std::endl;
-            
-            // Always use manual gain, the AGC is implemented in software
-            setGainMode(1);
-            setGain(currentGainCount);
-            sendRate(INPUT_RATE);
-            sendVFO(frequency);  
-        }
-        else {
-            std::clog << "RTL_TCP_CLIENT: Didn't find the \"RTL0\" magic key." <<
-                std::endl;
+    // Convert the byte order
+    dongleInfo.tuner_type = ntohl(dongleInfo.tuner_type);
+    dongleInfo.tuner_gain_count = ntohl(dongleInfo.tuner_gain_count);
+
+    if(dongleInfo.magic[0] == 'R' &&
+            dongleInfo.magic[1] == 'T' &&
+            dongleInfo.magic[2] == 'L' &&
+            dongleInfo.magic[3] == '0') {
+        std::string TunerType;
+        switch(dongleInfo.tuner_type)
+        {
+            case RTLSDR_TUNER_UNKNOWN: TunerType = "Unknown"; break;
+            case RTLSDR_TUNER_E4000: TunerType = "E4000"; break;
+            case RTLSDR_TUNER_FC0012: TunerType = "FC0012"; break;
+            case RTLSDR_TUNER_FC0013: TunerType = "FC0013"; break;
+            case RTLSDR_TUNER_FC2580: TunerType = "FC2580"; break;
+            case RTLSDR_TUNER_R820T: TunerType = "R820T"; break;
+            case RTLSDR_TUNER_R828D: TunerType = "R828D"; break;
+            default: TunerType = "Unknown";
         }
+        std::clog << "RTL_TCP_CLIENT: Tuner type: " <<
+            dongleInfo.tuner_type << " " << TunerType << std::endl;
+        std::clog << "RTL_TCP_CLIENT: Tuner gain count: " <<
+            dongleInfo.tuner_gain_count << std::endl;
+
+        // Always use manual gain, the AGC is implemented in software
+        setGainMode(1);
+        setGain(currentGainCount);
+        sendRate(INPUT_RATE);
+        sendVFO(frequency);
     }
+    else {
+        std::clog << "RTL_TCP_CLIENT: Didn't find the \"RTL0\" magic key." <<
+            std::endl;
+    }
+    return true;
+}
 
-    sampleNetworkBuffer.putDataIntoBuffer(buffer.data(), buffer.size());
-
-    // First fill the complete buffer to avoid sound outtages if the stream data rate is not stable e.g. over WIFI
-    if(!firstFilledNetworkBuffer) {
-        float bufferFill = (float) sampleNetworkBuffer.GetRingBufferReadAvailable() / sampleNetworkBuffer.GetBufferSize() * 100;
+void CRTL_TCP_Client::receiveData(void)
+{
+    // Receive straight into the sample buffer, the samples are only
+    // converted when the receiver reads them.
+    const auto span = sampleBuffer.reserve(RECEIVE_CHUNK_SIZE);
+    const bool fits = span.size >= 2;
+    uint8_t *data = fits ? span.data : discardBuffer.data();
+    const size_t length = fits ? (span.size & ~(size_t)1) : discardBuffer.size();
 
-        // Wait for 50% filled buffer
-        if(bufferFill >= 50)
-            firstFilledNetworkBuffer = true;
+    ssize_t read = receive(data, length);
+    if (read <= 0) {
+        return;
+    }
 
-        if((getMyTime() - oldTime_us > 100e3) || firstFilledNetworkBuffer) {
-            //std::clog << "RTL_TCP_CLIENT: Fill network buffer " << bufferFill << "%" << std::endl;
-            oldTime_us = getMyTime();
+    // Only whole samples go to the buffer. The rest of the last one is
+    // already on its way.
+    if (read % 2) {
+        if (receive(data + read, 1) != 1) {
+            return;
         }
+        read++;
+    }
+
+    if (fits) {
+        sampleBuffer.commit(read);
     }
+    countSamples(read / 2, fits ? read / 2 : 0);
+    spectrumSampleBuffer.push(data, read);
 
+    // First fill the buffer to 50%
+    if (not firstFilledNetworkBuffer and
+            sampleBuffer.readAvailable() >= sampleBuffer.capacity() / 2) {
+        firstFilledNetworkBuffer = true;
+    }
 
     // Check if device is overloaded
     minAmplitude = 255;
     maxAmplitude = 0;
 
-    for (const auto b : buffer) {
-        if (minAmplitude > b)
-            minAmplitude = b;
-        if (maxAmplitude < b)
-            maxAmplitude = b;
+    for (ssize_t i = 0; i < read; i++) {
+        if (minAmplitude > data[i])
+            minAmplitude = data[i];
+        if (maxAmplitude < data[i])
+            maxAmplitude = data[i];
     }
 }
 
 void CRTL_TCP_Client::handleDisconnect()
 {
     connected = false;
-    firstData = true;
     radioController.onMessage(message_level_t::Error,
             QT_TRANSLATE_NOOP("CRadioController", "RTL-TCP connection closed."));
+    std::lock_guard<std::mutex> lock(mutex);
     sock.close();
 }
 
@@ -434,6 +490,10 @@ void CRTL_TCP_Client::receiveAndReconnect()
 {
     while (rtlsdrRunning) {
         std::unique_lock<std::mutex> lock(mutex);
+        if (not rtlsdrRunning) {
+            // stop() ran while we waited for the lock
+            break;
+        }
 
         if (!connected) {
             std::clog << "RTL_TCP_CLIENT: Try to connect to server " <<
@@ -450,12 +510,23 @@ void CRTL_TCP_Client::receiveAndReconnect()
                 std::clog << "RTL_TCP_CLIENT: Successful connected to server " <<
                     std::endl;
 
+                sock.setReceiveBufferSize(4 * 1024 * 1024);
+                sock.setReceiveTimeout(100);
+                reset(); // Clear buffers
+
+                lock.unlock();
+                if (not receiveDongleInfo()) {
+                    continue;
+                }
+
+                // The AGC needs to know the tuner
                 if (!agcRunning) {
+                    if (agcThread.joinable()) {
+                        agcThread.join();
+                    }
                     agcRunning = true;
                     agcThread = std::thread(&CRTL_TCP_Client::agcTimer, this);
                 }
-                firstData = true;
-                reset(); // Clear buffers
             }
             else {
                 std::clog << "RTL_TCP_CLIENT: Could not connect to server" <<
@@ -481,56 +552,6 @@ void CRTL_TCP_Client::receiveAndReconnect()
     }
 }
 
-#define NETWORK_BUFFER_READ_SAMPLES 32768
-void CRTL_TCP_Client::networkBufferCopy()
-{
-    std::vector<uint8_t> tempBuffer(NETWORK_BUFFER_READ_SAMPLES * 2);
-
-    while (rtlsdrRunning) {
-        if(!firstFilledNetworkBuffer) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            nextStop_us = getMyTime();
-            continue;
-        }
-
-        int32_t samples = NETWORK_BUFFER_READ_SAMPLES;
-
-        // Figure out the max samples to read from network buffer
-        int32_t samplesInBuffer = sampleNetworkBuffer.GetRingBufferReadAvailable() / 2;
-        if(samplesInBuffer < samples)
-            samples = samplesInBuffer;
-
-        if(samples == 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            nextStop_us = getMyTime();
-            continue;
-        }
-
-        // Read data
-        int32_t amount = sampleNetworkBuffer.getDataFromBuffer(tempBuffer.data(), 2 * samples);
-
-        // Write data to standard buffers
-        sampleBuffer.putDataIntoBuffer(tempBuffer.data(), amount);
-        spectrumSampleBuffer.putDataIntoBuffer(tempBuffer.data(), amount);
-
-        if(getMyTime() - oldTime_us > 500e3) { // 500 ms
-
-            // float bufferFill = (float) sampleNetworkBuffer.GetRingBufferReadAvailable() / sampleNetworkBuffer.GetBufferSize() * 100;
-            //std::clog << "RTL_TCP_CLIENT: Network buffer fill level " << bufferFill << "%" << std::endl;
-
-            oldTime_us = getMyTime();
-        }
-
-
-        uint32_t period_us = samples / ((float) INPUT_RATE / 1e6);
-        nextStop_us += period_us;
-        int64_t timeToWait_us = nextStop_us - getMyTime();
-
-        // Send thread to sleep
-        std::this_thread::sleep_for(std::chrono::microseconds(timeToWait_us));
-    }
-}
-
 void CRTL_TCP_Client::agcTimer(void)
 {
     while (agcRunning) {
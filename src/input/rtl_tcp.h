@@ -34,14 +34,16 @@
 #define __RTL_TCP_CLIENT
 
 #include <array>
+#include <atomic>
 #include <string>
+#include <vector>
 #include <thread>
 #include <mutex>
 #include "Socket.h"
 #include "virtual_input.h"
 #include "dab-constants.h"
 #include "MathHelper.h"
-#include "ringbuffer.h"
+#include "spsc_ring.h"
 #include "radio-controller.h"
 
 struct dongle_info_t { /* structure size must be multiple of 2 bytes */
@@ -77,20 +79,24 @@ public:
 
     RadioControllerInterface& radioController;
 
+protected:
+    // getSamplesToRead() holds back the reserve
+    int64_t getSamplesBuffered(void) override;
+
 private:
     void stop(void);
     void agcTimer(void);
     void receiveData(void);
+    bool receiveDongleInfo(void);
+    ssize_t receive(uint8_t* data, size_t length);
     void receiveAndReconnect(void);
-    void networkBufferCopy(void);
     void handleDisconnect(void);
 
     std::mutex mutex;
     Socket sock;
     std::thread receiveThread;
-    bool agcRunning = false;
+    std::atomic<bool> agcRunning = ATOMIC_VAR_INIT(false);
     std::thread agcThread;
-    std::thread networkBufferThread;
 
     float currentGain = 0;
     uint16_t currentGainCount = 0;
@@ -99,18 +105,20 @@ private:
     bool isAGC = true;
     bool isHwAGC = false;
     int frequency = kHz(220000);
-    RingBuffer<uint8_t> sampleBuffer;
-    RingBuffer<uint8_t> sampleNetworkBuffer;
-    RingBuffer<uint8_t> spectrumSampleBuffer;
+    // recv() writes directly into sampleBuffer
+    SpscRing<uint8_t> sampleBuffer;
+    SpscRing<uint8_t> spectrumSampleBuffer;
+    // Receives the data that does not fit into sampleBuffer
+    std::vector<uint8_t> discardBuffer;
     bool connected = false;
-    bool rtlsdrRunning = false;
+    std::atomic<bool> rtlsdrRunning = ATOMIC_VAR_INIT(false);
     std::string serverAddress = "127.0.0.1";
     uint16_t serverPort = 1234;
 
-    bool firstData = true;
-    bool firstFilledNetworkBuffer = false;
-    int64_t oldTime_us = 0;
-    int64_t nextStop_us = 0;
+    std::atomic<bool> firstFilledNetworkBuffer = ATOMIC_VAR_INIT(false);
+    // Owned by the consumer, see getSamplesToRead()
+    int64_t paceStart_us = 0;
+    int64_t samplesReleased = 0;
     dongle_info_t dongleInfo;
 
     // Gain values for the different tuners
@@ -24,6 +24,7 @@
  *
  */
 
+#include <cmath>
 #include <vector>
 #include <sstream>
 #include <iostream>
@@ -44,8 +45,8 @@ using namespace std;
 
 CSoapySdr::CSoapySdr(RadioControllerInterface& radioController) :
     radioController(radioController),
-    m_sampleBuffer(1024 * 1024),
-    m_spectrumSampleBuffer(8192)
+    m_sampleBuffer(1024 * 1024, true),
+    m_spectrumSampleBuffer(8192, true)
 {
     //enumerate devices
     const std::string args ="";
@@ -89,14 +90,55 @@ int CSoapySdr::getFrequency() const
     return m_freq;
 }
 
+int CSoapySdr::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+bool CSoapySdr::setSampleRate(int rate)
+{
+    // Applied by restart(), which falls back to a rate the device supports
+    if (m_running or rate <= 0) {
+        return rate == m_sampleRate;
+    }
+
+    m_sampleRate = rate;
+    return true;
+}
+
+double CSoapySdr::supportedSampleRate(int rate) const
+{
+    double best = 0;
+    double widest = 0;
+    for (const auto& range : m_device->getSampleRateRange(SOAPY_SDR_RX, 0)) {
+        widest = max(widest, range.maximum());
+
+        double candidate = max<double>(rate, range.minimum());
+        if (range.step() > 0) {
+            candidate = range.minimum() +
+                ceil((candidate - range.minimum()) / range.step()) * range.step();
+        }
+        if (candidate <= range.maximum() and (best == 0 or candidate < best)) {
+            best = candidate;
+        }
+    }
+
+    if (best > 0) {
+        return best;
+    }
+    // Nothing is wide enough, or the driver does not tell
+    return widest > 0 ? widest : rate;
+}
+
 bool CSoapySdr::restart()
 {
     if (m_running) {
         return true;
     }
 
-    m_sampleBuffer.FlushRingBuffer();
-    m_spectrumSampleBuffer.FlushRingBuffer();
+    m_sampleBuffer.flush();
+    m_spectrumSampleBuffer.flush();
+    resetStallTimer();
 
     try {
         m_device = SoapySDR::Device::make(m_driver_args);
@@ -119,16 +161,25 @@ bool CSoapySdr::restart()
     }
     std::clog << ss.str().c_str() << std::endl;
 
-    m_device->setMasterClockRate(INPUT_RATE*16);
-    std::clog << "SoapySDR master clock rate set to " <<
-        m_device->getMasterClockRate()/1000.0 << " kHz" << std::endl;
+    // The master clock only suits rates that divide it
+    if ((INPUT_RATE*16) % m_sampleRate == 0) {
+        m_device->setMasterClockRate(INPUT_RATE*16);
+        std::clog << "SoapySDR master clock rate set to " <<
+            m_device->getMasterClockRate()/1000.0 << " kHz" << std::endl;
+    }
 
-    m_device->setSampleRate(SOAPY_SDR_RX, 0, INPUT_RATE);
-    std::clog << "SoapySDR:Actual RX rate: " <<
-        m_device->getSampleRate(SOAPY_SDR_RX, 0) / 1000.0 <<
+    // Devices that cannot capture at the requested rate run at the nearest
+    // rate above it, the OFDM processor resamples to the DAB rate.
+    const double rate = supportedSampleRate(m_sampleRate);
+    if (rate != m_sampleRate) {
+        std::clog << "SoapySDR: cannot capture at " << m_sampleRate <<
+            " sps, using " << rate << " sps" << std::endl;
+    }
+    m_device->setSampleRate(SOAPY_SDR_RX, 0, rate);
+    m_sampleRate = lround(m_device->getSampleRate(SOAPY_SDR_RX, 0));
+    std::clog << "SoapySDR:Actual RX rate: " << m_sampleRate / 1000.0 <<
         " ksps." << std::endl;
 
-
     clog << "Supported antenna: ";
     for (const auto& ant : m_device->listAntennas(SOAPY_SDR_RX, 0)) {
         clog << " " << ant;
@@ -198,19 +249,19 @@ void CSoapySdr::stop()
 
 void CSoapySdr::reset()
 {
-    m_sampleBuffer.FlushRingBuffer();
+    m_sampleBuffer.flush();
 }
 
 int32_t CSoapySdr::getSamples(DSPCOMPLEX *Buffer, int32_t Size)
 {
-    int32_t amount = m_sampleBuffer.getDataFromBuffer(Buffer, Size);
+    int32_t amount = m_sampleBuffer.pop(Buffer, Size);
     return amount;
 }
 
 std::vector<DSPCOMPLEX> CSoapySdr::getSpectrumSamples(int size)
 {
     std::vector<DSPCOMPLEX> sampleBuffer(size);
-    int32_t amount = m_spectrumSampleBuffer.getDataFromBuffer(sampleBuffer.data(), size);
+    int32_t amount = m_spectrumSampleBuffer.pop(sampleBuffer.data(), size);
     if (amount < size) {
         sampleBuffer.resize(amount);
     }
@@ -219,7 +270,7 @@ std::vector<DSPCOMPLEX> CSoapySdr::getSpectrumSamples(int size)
 
 int32_t CSoapySdr::getSamplesToRead()
 {
-    return m_sampleBuffer.GetRingBufferReadAvailable();
+    return m_sampleBuffer.readAvailable();
 }
 
 float CSoapySdr::getGain() const
@@ -388,10 +439,19 @@ void CSoapySdr::process(SoapySDR::Stream *stream)
         const size_t mtu = m_device->getStreamMTU(stream);
 
         const size_t samps_to_read = mtu; // Always read MTU samples
-        std::vector<DSPCOMPLEX> buf(samps_to_read);
+
+        // Read straight into the ring if there is room, otherwise into
+        // a scratch buffer so that the device is still drained.
+        const auto span = m_sampleBuffer.reserve(samps_to_read);
+        std::vector<DSPCOMPLEX> scratch;
+        DSPCOMPLEX *buf = span.data;
+        if (span.size < samps_to_read) {
+            scratch.resize(samps_to_read);
+            buf = scratch.data();
+        }
 
         void *buffs[1];
-        buffs[0] = buf.data();
+        buffs[0] = buf;
 
         int flags = 0;
         long long timeNs = 0;
@@ -415,11 +475,10 @@ void CSoapySdr::process(SoapySDR::Stream *stream)
             m_running = false;
         }
         else {
-            buf.resize(ret);
-
             if (m_sw_agc and (frames % 200) == 0) {
                 float maxnorm = 0;
-                for (const DSPCOMPLEX& z : buf) {
+                for (int i = 0; i < ret; i++) {
+                    const DSPCOMPLEX z = buf[i];
                     if (norm(z) > maxnorm) {
                         maxnorm = norm(z);
                     }
@@ -435,8 +494,18 @@ void CSoapySdr::process(SoapySDR::Stream *stream)
                 }
             }
 
-            m_sampleBuffer.putDataIntoBuffer(buf.data(), ret);
-            m_spectrumSampleBuffer.putDataIntoBuffer(buf.data(), ret);
+            size_t written = 0;
+            if (buf == span.data) {
+                m_sampleBuffer.commit(ret);
+                written = ret;
+            }
+            else {
+                written = m_sampleBuffer.push(buf, ret);
+            }
+            countSamples(ret, written);
+            m_spectrumSampleBuffer.push(buf, ret);
+            putIntoRecordBuffer(*reinterpret_cast<const uint8_t*>(buf),
+                    ret * sizeof(DSPCOMPLEX));
         }
     }
 }
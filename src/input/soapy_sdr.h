@@ -29,7 +29,7 @@
 #include <atomic>
 #include <thread>
 #include "virtual_input.h"
-#include "ringbuffer.h"
+#include "spsc_ring.h"
 #include <SoapySDR/Version.hpp>
 #include <SoapySDR/Modules.hpp>
 #include <SoapySDR/Registry.hpp>
@@ -47,6 +47,8 @@ public:
 
     virtual void setFrequency(int Frequency);
     virtual int getFrequency(void) const;
+    virtual int getSampleRate(void) const override;
+    virtual bool setSampleRate(int rate) override;
     virtual bool restart(void);
     virtual bool is_ok(void);
     virtual void stop(void);
@@ -62,6 +64,12 @@ public:
     virtual CDeviceID getID(void);
     virtual bool setDeviceParam(DeviceParam param, const std::string& value);
 
+protected:
+    // Recorded after the conversion to DSPCOMPLEX
+    IQRecorder::Format getRecordFormat() const override {
+        return IQRecorder::Format::CF32;
+    }
+
 private:
     void setDriverArgs(const std::string& args);
     void setAntenna(const std::string& antenna);
@@ -69,8 +77,12 @@ private:
     void decreaseGain();
     void increaseGain();
 
+    // The lowest rate of at least rate the device can capture at
+    double supportedSampleRate(int rate) const;
+
     RadioControllerInterface& radioController;
     int m_freq = 0;
+    int m_sampleRate = INPUT_RATE;
     std::string m_driver_args;
     std::string m_antenna;
     std::string m_clock_source;
@@ -78,8 +90,8 @@ private:
     std::atomic<bool> m_running = ATOMIC_VAR_INIT(false);
     bool m_sw_agc = false;
 
-    RingBuffer<DSPCOMPLEX> m_sampleBuffer;
-    RingBuffer<DSPCOMPLEX> m_spectrumSampleBuffer;
+    SpscRing<DSPCOMPLEX> m_sampleBuffer;
+    SpscRing<DSPCOMPLEX> m_spectrumSampleBuffer;
 
     std::vector<double> m_gains;
 
@@ -0,0 +1,274 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include "synthetic_input.h"
+#include "tools.h"
+
+// Like the buffer of a real device, the receiver may lag behind by
+// half a second before samples are lost
+static const int64_t MAX_BACKLOG = INPUT_RATE / 2;
+
+static int64_t steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int parseInt(const std::string& key, const std::string& value)
+{
+    try {
+        size_t pos = 0;
+        const int v = std::stoi(value, &pos);
+        if (pos == value.size())
+            return v;
+    }
+    catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value '" + value + "' for " + key);
+}
+
+static float parseFloat(const std::string& key, const std::string& value)
+{
+    try {
+        size_t pos = 0;
+        const float v = std::stof(value, &pos);
+        if (pos == value.size())
+            return v;
+    }
+    catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value '" + value + "' for " + key);
+}
+
+CSyntheticInput::CSyntheticInput(const EnsembleGenerator::Config& config, bool throttle) :
+    generator(config),
+    throttle(throttle),
+    SpectrumSampleBuffer(8 * 2048)
+{
+}
+
+EnsembleGenerator::Config CSyntheticInput::parseArgs(const std::string& args, bool& throttle)
+{
+    int services = 8;
+    int bitrate = 48;
+    int protection = 3;
+    std::string audioFile;
+    EnsembleGenerator::Config channel;
+    throttle = true;
+
+    for (const auto& item : MiscTools::SplitString(args, ',')) {
+        if (item.empty())
+            continue;
+
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos)
+            throw std::invalid_argument("Expected key=value instead of '" + item + "'");
+
+        const std::string key = item.substr(0, eq);
+        const std::string value = item.substr(eq + 1);
+
+        if (key == "services")
+            services = parseInt(key, value);
+        else if (key == "bitrate")
+            bitrate = parseInt(key, value);
+        else if (key == "protection")
+            protection = parseInt(key, value);
+        else if (key == "audio")
+            audioFile = value;
+        else if (key == "snr") {
+            channel.noise = true;
+            channel.snr = parseFloat(key, value);
+        }
+        else if (key == "offset")
+            channel.frequencyOffset = parseFloat(key, value);
+        else if (key == "echo") {
+            // delay:gain[:phase]
+            const auto parts = MiscTools::SplitString(value, ':');
+            if (parts.size() < 2 or parts.size() > 3)
+                throw std::invalid_argument("Expected delay:gain[:phase] for echo");
+
+            EnsembleGenerator::Echo e;
+            e.delay = parseInt(key, parts[0]);
+            e.gain = parseFloat(key, parts[1]);
+            if (parts.size() == 3)
+                e.phase = parseFloat(key, parts[2]);
+            channel.echoes.push_back(e);
+        }
+        else if (key == "seed")
+            channel.seed = parseInt(key, value);
+        else if (key == "throttle")
+            throttle = parseInt(key, value) != 0;
+        else
+            throw std::invalid_argument("Unknown option '" + key + "'");
+    }
+
+    if (services < 0)
+        throw std::invalid_argument("Invalid number of services");
+
+    auto config = EnsembleGenerator::makeConfig(services, bitrate, protection);
+    for (auto& s : config.services)
+        s.audioFile = audioFile;
+
+    config.echoes = channel.echoes;
+    config.frequencyOffset = channel.frequencyOffset;
+    config.noise = channel.noise;
+    config.snr = channel.snr;
+    config.seed = channel.seed;
+    return config;
+}
+
+void CSyntheticInput::setFrequency(int Frequency)
+{
+    frequency = Frequency;
+}
+
+int CSyntheticInput::getFrequency(void) const
+{
+    return frequency;
+}
+
+bool CSyntheticInput::restart(void)
+{
+    samplesGiven = 0;
+    startTime = steadyNanoseconds();
+    resetStallTimer();
+    running = true;
+    return true;
+}
+
+bool CSyntheticInput::is_ok(void)
+{
+    return true;
+}
+
+void CSyntheticInput::stop(void)
+{
+    running = false;
+}
+
+void CSyntheticInput::reset(void)
+{
+    SpectrumSampleBuffer.flush();
+}
+
+int64_t CSyntheticInput::samplesDue(void) const
+{
+    const int64_t elapsed = steadyNanoseconds() - startTime;
+    return elapsed * (INPUT_RATE / 1000) / 1000000;
+}
+
+int32_t CSyntheticInput::getSamples(DSPCOMPLEX* Buffer, int32_t Size)
+{
+    size_t dropped = 0;
+    if (throttle) {
+        // The transmitter goes on while the receiver lags behind
+        const int64_t backlog = samplesDue() - samplesGiven;
+        if (backlog > MAX_BACKLOG) {
+            dropped = backlog - MAX_BACKLOG;
+            discardBuffer.resize(std::min<size_t>(dropped, 65536));
+            for (size_t done = 0; done < dropped; ) {
+                const size_t n = std::min(dropped - done, discardBuffer.size());
+                generator.getSamples(discardBuffer.data(), n);
+                done += n;
+            }
+            samplesGiven += dropped;
+        }
+    }
+
+    generator.getSamples(Buffer, Size);
+    samplesGiven += Size;
+    countSamples(dropped + Size, Size);
+
+    SpectrumSampleBuffer.push(Buffer, Size);
+    putIntoRecordBuffer(*reinterpret_cast<const uint8_t*>(Buffer),
+            Size * sizeof(DSPCOMPLEX));
+
+    return Size;
+}
+
+std::vector<DSPCOMPLEX> CSyntheticInput::getSpectrumSamples(int size)
+{
+    std::vector<DSPCOMPLEX> buffer(size);
+    const size_t sizeRead = SpectrumSampleBuffer.pop(buffer.data(), size);
+    buffer.resize(sizeRead);
+    return buffer;
+}
+
+int32_t CSyntheticInput::getSamplesToRead(void)
+{
+    if (not running)
+        return 0;
+
+    if (not throttle)
+        return INT32_MAX;
+
+    const int64_t available = samplesDue() - samplesGiven;
+    return (int32_t)std::max<int64_t>(0, std::min(available, MAX_BACKLOG));
+}
+
+int64_t CSyntheticInput::getSamplesBeforeDiscontinuity(void)
+{
+    return 0;
+}
+
+float CSyntheticInput::getGain(void) const
+{
+    return 0;
+}
+
+float CSyntheticInput::setGain(int Gain)
+{
+    (void) Gain;
+    return 0;
+}
+
+int CSyntheticInput::getGainCount(void)
+{
+    return 0;
+}
+
+void CSyntheticInput::setAgc(bool AGC)
+{
+    (void) AGC;
+}
+
+std::string CSyntheticInput::getDescription(void)
+{
+    return "Synthetic ensemble of " +
+        std::to_string(generator.getSubchannels().size()) + " services";
+}
+
+CDeviceID CSyntheticInput::getID(void)
+{
+    return CDeviceID::SYNTHETIC;
+}
+
+IQRecorder::Format CSyntheticInput::getRecordFormat() const
+{
+    return IQRecorder::Format::CF32;
+}
@@ -0,0 +1,93 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef SYNTHETIC_INPUT_H
+#define SYNTHETIC_INPUT_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "virtual_input.h"
+#include "ensemble_generator.h"
+#include "spsc_ring.h"
+
+// Input giving out the signal of an EnsembleGenerator, e.g. to test
+// the receiver with a large ensemble without any hardware.
+class CSyntheticInput : public CVirtualInput
+{
+public:
+    // Throttled, the samples become available at the DAB sample rate like
+    // with a real device, and a receiver that is too slow loses samples.
+    // Otherwise they are generated as fast as the receiver asks for them.
+    CSyntheticInput(const EnsembleGenerator::Config& config, bool throttle = true);
+
+    // Parse comma separated key=value pairs, e.g.
+    // "services=64,bitrate=16,snr=20,offset=500,echo=20:0.3,throttle=0".
+    // Throws std::invalid_argument on unknown keys or invalid values.
+    static EnsembleGenerator::Config parseArgs(const std::string& args, bool& throttle);
+
+    // Interface methods
+    void setFrequency(int Frequency);
+    int getFrequency(void) const;
+    bool restart(void);
+    bool is_ok(void);
+    void stop(void);
+    void reset(void);
+    int32_t getSamples(DSPCOMPLEX* Buffer, int32_t Size);
+    std::vector<DSPCOMPLEX> getSpectrumSamples(int size);
+    int32_t getSamplesToRead(void);
+    float getGain(void) const;
+    float setGain(int Gain);
+    int getGainCount(void);
+    void setAgc(bool AGC);
+    std::string getDescription(void);
+    CDeviceID getID(void);
+    // Samples are lost right before the ones getSamples() gives
+    int64_t getSamplesBeforeDiscontinuity(void) override;
+
+    const EnsembleGenerator& getGenerator() const { return generator; }
+
+protected:
+    IQRecorder::Format getRecordFormat() const override;
+
+private:
+    // Samples the receiver is allowed to take at this time
+    int64_t samplesDue(void) const;
+
+    EnsembleGenerator generator;
+    const bool throttle;
+    std::atomic<int> frequency = ATOMIC_VAR_INIT(0);
+    std::atomic<bool> running = ATOMIC_VAR_INIT(false);
+
+    // Time of restart() in ns of the steady clock, and the samples
+    // handed out since then
+    std::atomic<int64_t> startTime = ATOMIC_VAR_INIT(0);
+    std::atomic<int64_t> samplesGiven = ATOMIC_VAR_INIT(0);
+    std::vector<DSPCOMPLEX> discardBuffer;
+
+    SpscRing<DSPCOMPLEX> SpectrumSampleBuffer;
+};
+
+#endif // SYNTHETIC_INPUT_H
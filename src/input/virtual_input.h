@@ -30,69 +30,267 @@
 #ifndef __VIRTUAL_INPUT
 #define __VIRTUAL_INPUT
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
-#include <fstream>
 #include <iostream>
 
 #include "dab-constants.h"
 #include "radio-controller.h"
-#include "ringbuffer.h"
+#include "iq_recorder.h"
+#include "various/metrics.h"
 
 enum class CDeviceID {
-    UNKNOWN, NULLDEVICE, AIRSPY, RAWFILE, RTL_SDR, RTL_TCP, SOAPYSDR, ANDROID_RTL_SDR, LIMESDR};
+    UNKNOWN, NULLDEVICE, AIRSPY, RAWFILE, RTL_SDR, RTL_TCP, SOAPYSDR, ANDROID_RTL_SDR, LIMESDR,
+    SYNTHETIC, CHANNELIZER};
+
+inline const char* deviceIDToString(CDeviceID id) {
+    switch (id) {
+        case CDeviceID::UNKNOWN: return "unknown";
+        case CDeviceID::NULLDEVICE: return "null";
+        case CDeviceID::AIRSPY: return "airspy";
+        case CDeviceID::RAWFILE: return "rawfile";
+        case CDeviceID::RTL_SDR: return "rtl_sdr";
+        case CDeviceID::RTL_TCP: return "rtl_tcp";
+        case CDeviceID::SOAPYSDR: return "soapysdr";
+        case CDeviceID::ANDROID_RTL_SDR: return "android_rtl_sdr";
+        case CDeviceID::LIMESDR: return "limesdr";
+        case CDeviceID::SYNTHETIC: return "synthetic";
+        case CDeviceID::CHANNELIZER: return "channelizer";
+    }
+    return "unknown";
+}
 
 class CVirtualInput : public InputInterface {
 public:
     virtual ~CVirtualInput() {}
     virtual CDeviceID getID(void) = 0;
 
-    void writeRecordBufferToFile(std::string &fileanme) {
-        if(!recordBuffer)
-            return;
+    // Start recording the IQ samples to disk. The sample format is the
+    // one the input receives, see getRecordFormat().
+    void startRecorder(IQRecorder::Config config) {
+        config.format = getRecordFormat();
+        config.sampleRate = getSampleRate();
+        config.frequency = getFrequency();
+        config.hardware = getDescription();
+        stopRecorder();
+        syncLostAt = -1;
+        try {
+            std::atomic_store(&recorder, std::make_shared<IQRecorder>(config));
+        }
+        catch (const std::exception& e) {
+            std::clog << "CVirtualInput: cannot start recorder: " << e.what() << std::endl;
+        }
+    }
+
+    // Keep the pre-trigger window on disk and end the recording
+    void triggerRecorder() {
+        auto r = std::atomic_exchange(&recorder, std::shared_ptr<IQRecorder>());
+        if (r) {
+            closeSyncLoss(*r);
+            r->trigger();
+        }
+    }
 
-        std::ofstream rawStream(fileanme, std::ios::binary);
+    void stopRecorder() {
+        auto r = std::atomic_exchange(&recorder, std::shared_ptr<IQRecorder>());
+        if (r) {
+            closeSyncLoss(*r);
+            r->stop();
+        }
+    }
 
-        while (1) {
-            uint8_t data_tmp[1024];
-            const auto available = recordBuffer->GetRingBufferReadAvailable();
+    // Tell the recorder about a retune, to be called after setFrequency()
+    void updateRecorderFrequency() {
+        auto r = std::atomic_load(&recorder);
+        if (r)
+            r->addCapture(r->position(), getFrequency());
+    }
 
-            if (available <= 0) {
-                break;
-            }
+    // Annotate the times without sync in the recording. The positions are
+    // those of the input, which is ahead of the receiver by the samples
+    // waiting in the sample buffer.
+    void updateRecorderSync(bool sync) {
+        auto r = std::atomic_load(&recorder);
+        if (!r)
+            return;
 
-            const size_t data_tmpSize = std::min(sizeof(data_tmp), (size_t)available);
-            recordBuffer->getDataFromBuffer(data_tmp, data_tmpSize);
-            rawStream.write((char*)data_tmp, data_tmpSize);
+        if (!sync) {
+            int64_t none = -1;
+            syncLostAt.compare_exchange_strong(none, r->position());
+        }
+        else {
+            closeSyncLoss(*r);
         }
+    }
+
+    struct InputStats {
+        uint64_t samplesReceived = 0;
+        uint64_t samplesDropped = 0;
+        // Times the sample buffer overflowed
+        uint64_t overflows = 0;
+        // Longest time between two deliveries of samples by the device
+        double longestStall = 0;
+        // samplesReceived as of lastDelivery, to relate sample numbers
+        // to the time they arrived
+        uint64_t lastSampleCount = 0;
+        std::chrono::steady_clock::time_point lastDelivery;
+    };
+
+    InputStats getInputStats() const {
+        InputStats stats;
+        stats.samplesReceived = totalReceived;
+        stats.samplesDropped = totalDropped;
+        stats.overflows = overflows;
+        stats.longestStall = longestStall / 1e9;
+        stats.lastSampleCount = lastSampleCount;
+        stats.lastDelivery = std::chrono::steady_clock::time_point(
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::nanoseconds(lastDelivery.load())));
+        return stats;
+    }
 
-        rawStream.close();
+    // Every overflow is a discontinuity in the sample stream
+    uint64_t getDiscontinuityCount(void) const override {
+        return overflows;
     }
 
-    void initRecordBuffer(uint32_t size) {
-        // The ring buffer size has to be power of 2
-        uint32_t bitCount = ceil(log2(size));
-        uint32_t bufferSize = pow(2, bitCount);
+    // The reader is as many samples behind the writer as the sample buffer
+    // holds. Samples stored but not counted yet only make it wait longer.
+    int64_t getSamplesBeforeDiscontinuity(void) override {
+        const int64_t written = totalWritten;
+        const int64_t readPosition = written - getSamplesBuffered();
+        return std::max<int64_t>(0, (int64_t)discontinuityPosition - readPosition);
+    }
 
-        try {
-            recordBuffer.reset(new RingBuffer<uint8_t>(bufferSize));
-        }
+    bool getRecorderStats(IQRecorder::Stats& stats) const {
+        auto r = std::atomic_load(&recorder);
+        if (!r)
+            return false;
 
-        catch (const std::bad_alloc& e) {
-                std::clog << "CVirtualInput: recordBuffer allocation failed (size " << bufferSize * sizeof(uint8_t) << " bytes) : " << e.what() << std::endl;
-        }
+        stats = r->getStats();
+        return true;
     }
 
 protected:
-    void putIntoRecordBuffer(uint8_t &data, uint32_t size) {
-        if(!recordBuffer)
+    // The samples in the sample buffer. Inputs that release fewer samples
+    // than they hold from getSamplesToRead() must override it.
+    virtual int64_t getSamplesBuffered(void) {
+        return getSamplesToRead();
+    }
+
+    // The format of the bytes given to putIntoRecordBuffer()
+    virtual IQRecorder::Format getRecordFormat() const {
+        return IQRecorder::Format::U8;
+    }
+
+    // Called from the thread receiving the samples, never blocks
+    void putIntoRecordBuffer(const uint8_t &data, uint32_t size) {
+        auto r = std::atomic_load(&recorder);
+        if (!r)
+            return;
+
+        r->push(&data, size);
+    }
+
+    // Account for complex samples received from the device, of which
+    // only written could be stored in the sample buffer. Must always be
+    // called from the same thread.
+    void countSamples(size_t received, size_t written) {
+        initSampleCounters();
+
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        const int64_t last = lastDelivery.exchange(now);
+        if (last != 0 && now - last > longestStall) {
+            longestStall = now - last;
+            longestStallGauge->set(longestStall / 1e9);
+        }
+
+        samplesReceived->inc(received);
+        lastSampleCount = totalReceived.fetch_add(received) + received;
+        totalWritten += written;
+        countDroppedSamples(received - written);
+    }
+
+    // Samples lost before they could be written to the sample buffer.
+    // A run of calls that drop samples counts as one overflow, which
+    // starts after the samples written so far.
+    void countDroppedSamples(size_t dropped) {
+        initSampleCounters();
+        if (dropped == 0) {
+            overflowing = false;
             return;
+        }
+
+        samplesDropped->inc(dropped);
+        totalDropped += dropped;
+        if (!overflowing) {
+            overflowing = true;
+            discontinuityPosition = totalWritten.load();
+            overflowsCounter->inc();
+            overflows++;
+            std::clog << "CVirtualInput: " << deviceIDToString(getID()) <<
+                " sample buffer overflow, " << dropped << " samples dropped" << std::endl;
+        }
+    }
 
-        recordBuffer->putDataIntoBuffer(&data, static_cast<int>(size));
-        //std::clog << "CVirtualInput: GetRingBufferReadAvailable() " << recordBuffer->GetRingBufferReadAvailable() << std::endl;
+    // To be called by restart(), so that the time the input was stopped
+    // does not count as a stall
+    void resetStallTimer() {
+        lastDelivery = 0;
     }
 
 private:
-    std::unique_ptr<RingBuffer<uint8_t>> recordBuffer;
+    // Annotate the sync loss going on, if any, up to now
+    void closeSyncLoss(IQRecorder& r) {
+        const int64_t lost = syncLostAt.exchange(-1);
+        const int64_t now = r.position();
+        if (lost >= 0 && now > lost)
+            r.annotate(lost, now - lost, sigmf::SYNC_LOSS_LABEL);
+    }
+
+    void initSampleCounters() {
+        if (samplesReceived)
+            return;
+
+        const auto l = metrics::label("input", deviceIDToString(getID()));
+        samplesReceived = &metrics::registry().counter(
+                "welle_input_samples_received_total",
+                "Complex samples received from the input device", l);
+        samplesDropped = &metrics::registry().counter(
+                "welle_input_samples_dropped_total",
+                "Complex samples dropped because the sample buffer was full", l);
+        overflowsCounter = &metrics::registry().counter(
+                "welle_input_overflows_total",
+                "Number of times the sample buffer overflowed", l);
+        longestStallGauge = &metrics::registry().gauge(
+                "welle_input_longest_stall_seconds",
+                "Longest time between two deliveries of samples by the input device", l);
+    }
+
+    std::shared_ptr<IQRecorder> recorder;
+    std::atomic<int64_t> syncLostAt = ATOMIC_VAR_INIT(-1);
+
+    metrics::Counter *samplesReceived = nullptr;
+    metrics::Counter *samplesDropped = nullptr;
+    metrics::Counter *overflowsCounter = nullptr;
+    metrics::Gauge *longestStallGauge = nullptr;
+
+    // Updated by the thread receiving the samples
+    std::atomic<uint64_t> totalReceived = ATOMIC_VAR_INIT(0);
+    std::atomic<uint64_t> totalDropped = ATOMIC_VAR_INIT(0);
+    // Samples stored in the sample buffer, and their number when the
+    // last overflow began
+    std::atomic<uint64_t> totalWritten = ATOMIC_VAR_INIT(0);
+    std::atomic<uint64_t> discontinuityPosition = ATOMIC_VAR_INIT(0);
+    std::atomic<uint64_t> overflows = ATOMIC_VAR_INIT(0);
+    std::atomic<uint64_t> lastSampleCount = ATOMIC_VAR_INIT(0);
+    // steady_clock nanoseconds, 0 before the first delivery
+    std::atomic<int64_t> lastDelivery = ATOMIC_VAR_INIT(0);
+    std::atomic<int64_t> longestStall = ATOMIC_VAR_INIT(0);
+    bool overflowing = false;
 };
 
 #endif
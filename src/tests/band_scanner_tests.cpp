@@ -0,0 +1,109 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file band_scanner_tests.cpp
+ * @brief Tests for the band scanner on synthetic ensembles
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/band-scanner.h"
+#include "../input/synthetic_input.h"
+#include "../various/metrics.h"
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <vector>
+
+using namespace std::chrono;
+
+static BandScanner::Options scan_options()
+{
+    BandScanner::Options options;
+    options.settleTime = milliseconds(500);
+    return options;
+}
+
+TEST_CASE("Ensembles are found on all tuners", "[bandscanner]") {
+    CSyntheticInput tuner_a(EnsembleGenerator::makeConfig(3, 48));
+    CSyntheticInput tuner_b(EnsembleGenerator::makeConfig(5, 48));
+    BandScanner scanner({ &tuner_a, &tuner_b }, scan_options());
+
+    const std::vector<std::string> channels = { "5A", "5B", "5C", "5D" };
+    std::mutex mut;
+    std::set<size_t> tuners;
+    const auto results = scanner.scan(channels,
+            [&](const ChannelScanResult& r) {
+                std::lock_guard<std::mutex> lock(mut);
+                tuners.insert(r.tuner);
+            });
+
+    REQUIRE(results.size() == channels.size());
+    REQUIRE(tuners.size() == 2);
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        REQUIRE(r.channel == channels[i]);
+        REQUIRE(r.outcome == ChannelScanResult::Outcome::Ensemble);
+        REQUIRE(BandScanner::isComplete(*r.ensemble));
+        REQUIRE(r.ensemble->services.size() == (r.tuner == 0 ? 3u : 5u));
+    }
+}
+
+TEST_CASE("The scanning thread sleeps while the ensemble settles", "[bandscanner]") {
+    CSyntheticInput tuner(EnsembleGenerator::makeConfig(2, 48));
+    auto options = scan_options();
+    // Never settles, the scan waits for the whole timeout
+    options.ensembleTimeout = milliseconds(2000);
+    options.settleTime = milliseconds(5000);
+    BandScanner scanner({ &tuner }, options);
+
+    // The callback runs on the scanning thread, right after the channel
+    double cpuSeconds = -1;
+    const auto results = scanner.scan({ "5A" },
+            [&](const ChannelScanResult&) {
+                cpuSeconds = metrics::thread_cpu_seconds();
+            });
+
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].outcome == ChannelScanResult::Outcome::Ensemble);
+    REQUIRE(results[0].duration >= options.ensembleTimeout);
+    REQUIRE(cpuSeconds >= 0);
+    REQUIRE(cpuSeconds < 0.1 * duration<double>(results[0].duration).count());
+}
+
+TEST_CASE("Unknown channels are not tuned", "[bandscanner]") {
+    CSyntheticInput tuner(EnsembleGenerator::makeConfig(2, 48));
+    BandScanner scanner({ &tuner }, scan_options());
+
+    const auto results = scanner.scan({ "99Z" });
+    REQUIRE(results.size() == 1);
+    REQUIRE(results[0].outcome == ChannelScanResult::Outcome::NoSignal);
+    REQUIRE(results[0].frequency == 0);
+    REQUIRE(tuner.getFrequency() == 0);
+}
@@ -0,0 +1,347 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file channelizer_tests.cpp
+ * @brief Tests for the polyphase channelizer receiving several ensembles
+ *        from one wideband capture
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../input/channelizer.h"
+#include "../input/ensemble_generator.h"
+#include "../backend/fic-handler.h"
+#include "../various/MathHelper.h"
+#include "../various/channels.h"
+#include "test_buffer_input.h"
+#include "test_radio_interface.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+// RMS level of the samples after the filter settled, and how well they
+// match a tone at the given frequency
+static double level(const std::vector<DSPCOMPLEX>& samples, size_t skip)
+{
+    double power = 0;
+    for (size_t i = skip; i < samples.size(); i++) {
+        power += norm(samples[i]);
+    }
+    return sqrt(power / (samples.size() - skip));
+}
+
+static void check_tone(const std::vector<DSPCOMPLEX>& samples, size_t skip, double frequency)
+{
+    const DSPCOMPLEX step = std::polar(1.0f, (float)(2 * M_PI * frequency / INPUT_RATE));
+    for (size_t i = skip + 1; i < samples.size(); i++) {
+        REQUIRE(abs(samples[i] - samples[i - 1] * step) < 1e-3f);
+    }
+}
+
+// Soft bits of the FIC symbols of a frame that starts with the NULL
+// symbol at frame[0], demodulated the same way as OfdmDecoder does.
+static std::vector<softbit_t> demodulate_fic(const DSPCOMPLEX *frame)
+{
+    const DABParams p(1);
+    fft::Forward fft(p.T_u);
+    FrequencyInterleaver interleaver(p);
+    std::vector<DSPCOMPLEX> previous(p.T_u);
+    std::vector<softbit_t> bits(3 * 2 * p.K);
+
+    for (int sym = 0; sym <= 3; sym++) {
+        const DSPCOMPLEX *s = frame + p.T_null + sym * p.T_s + (p.T_s - p.T_u);
+        DSPCOMPLEX *v = fft.getVector();
+        std::copy(s, s + p.T_u, v);
+        fft.do_FFT();
+
+        if (sym > 0) {
+            softbit_t *out = &bits[(sym - 1) * 2 * p.K];
+            for (int i = 0; i < p.K; i++) {
+                int16_t index = interleaver.mapIn(i);
+                if (index < 0) {
+                    index += p.T_u;
+                }
+                const DSPCOMPLEX r1 = v[index] * conj(previous[index]);
+                const float ab1 = l1_norm(r1);
+                out[i] = -real(r1) * 127.0f / ab1;
+                out[p.K + i] = -imag(r1) * 127.0f / ab1;
+            }
+        }
+        std::copy(v, v + p.T_u, previous.begin());
+    }
+    return bits;
+}
+
+// Interpolate by two and shift to the offset, adding to out
+static void upconvert(const std::vector<DSPCOMPLEX>& in, int offset,
+        std::vector<DSPCOMPLEX>& out)
+{
+    const int taps = 64;
+    std::vector<float> h(taps);
+    for (int k = 0; k < taps; k++) {
+        const double t = k - (taps - 1) / 2.0;
+        const double w = 0.42 - 0.5 * cos(2 * M_PI * k / (taps - 1)) +
+            0.08 * cos(4 * M_PI * k / (taps - 1));
+        h[k] = w * sin(M_PI * t / 2) / (M_PI * t / 2);
+    }
+
+    out.resize(2 * in.size());
+    const double rate = 2.0 * INPUT_RATE;
+    for (size_t n = 0; n < out.size(); n++) {
+        DSPCOMPLEX acc = 0;
+        // Only the even samples of the zero stuffed input are not zero
+        for (int k = n % 2; k < taps; k += 2) {
+            if (n >= (size_t)k) {
+                acc += h[k] * in[(n - k) / 2];
+            }
+        }
+        const double phase = 2 * M_PI * fmod((double)offset * n / rate, 1.0);
+        out[n] += acc * DSPCOMPLEX(cos(phase), sin(phase));
+    }
+}
+
+TEST_CASE("Tones in the channel pass, the rest is rejected", "[channelizer]") {
+    const int decimation = 4;
+    const double rate = decimation * INPUT_RATE;
+    const int offset = 1712000;
+    const size_t num = 40000;
+    const size_t skip = 100;
+
+    PolyphaseChannelizer dsp(decimation * INPUT_RATE, decimation);
+    REQUIRE(dsp.getMaxOffset() == 3 * INPUT_RATE / 2);
+
+    for (int f = -700000; f <= 700000; f += 100000) {
+        PolyphaseChannelizer channel(decimation * INPUT_RATE, decimation);
+        channel.addChannel(offset);
+        std::vector<std::vector<DSPCOMPLEX> > out;
+        channel.process(tone(offset + f, rate, num).data(), num, out);
+        REQUIRE(out.size() == 1);
+        REQUIRE(out[0].size() == num / decimation);
+
+        // Flat within 0.1dB, and at the right frequency
+        REQUIRE(std::abs(20 * log10(level(out[0], skip))) < 0.1);
+        check_tone(out[0], skip, f);
+    }
+
+    // What would alias onto the DAB block after decimation
+    for (int f : {-3000000, -2000000, -1300000, 1300000, 2000000, 2300000}) {
+        PolyphaseChannelizer channel(decimation * INPUT_RATE, decimation);
+        channel.addChannel(offset);
+        std::vector<std::vector<DSPCOMPLEX> > out;
+        channel.process(tone(offset + f, rate, num).data(), num, out);
+        REQUIRE(20 * log10(level(out[0], skip)) < -55);
+    }
+}
+
+TEST_CASE("The output does not depend on how the input is cut", "[channelizer]") {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0, 1);
+    std::vector<DSPCOMPLEX> in(30011);
+    for (auto& s : in) {
+        s = DSPCOMPLEX(noise(rng), noise(rng));
+    }
+
+    PolyphaseChannelizer whole(3 * INPUT_RATE, 3);
+    whole.addChannel(-1000000);
+    whole.addChannel(800000);
+    std::vector<std::vector<DSPCOMPLEX> > expected;
+    whole.process(in.data(), in.size(), expected);
+    REQUIRE(expected[0].size() == in.size() / 3);
+
+    PolyphaseChannelizer pieces(3 * INPUT_RATE, 3);
+    pieces.addChannel(-1000000);
+    pieces.addChannel(800000);
+    std::vector<std::vector<DSPCOMPLEX> > got(2);
+    std::vector<std::vector<DSPCOMPLEX> > out;
+    std::uniform_int_distribution<size_t> length(0, 1000);
+    size_t pos = 0;
+    while (pos < in.size()) {
+        const size_t n = std::min(length(rng), in.size() - pos);
+        pieces.process(in.data() + pos, n, out);
+        for (size_t ch = 0; ch < 2; ch++) {
+            got[ch].insert(got[ch].end(), out[ch].begin(), out[ch].end());
+        }
+        pos += n;
+    }
+
+    for (size_t ch = 0; ch < 2; ch++) {
+        REQUIRE(got[ch].size() == expected[ch].size());
+        for (size_t i = 0; i < got[ch].size(); i++) {
+            REQUIRE(abs(got[ch][i] - expected[ch][i]) < 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("The decimation covers all channels", "[channelizer]") {
+    Channels channels;
+    auto f = [&](const char *name) { return channels.getFrequency(name); };
+
+    REQUIRE(CChannelizer::decimationFor({}) == 1);
+    REQUIRE(CChannelizer::decimationFor({f("5A")}) == 1);
+    REQUIRE(CChannelizer::decimationFor({f("5A"), f("5B")}) == 2);
+    REQUIRE(CChannelizer::decimationFor({f("5A"), f("5B"), f("5C"), f("5D")}) == 4);
+    REQUIRE(CChannelizer::decimationFor({f("12A"), f("12D")}) == 4);
+    REQUIRE(CChannelizer::decimationFor({f("5A"), f("13F")}) == 0);
+
+    // Every channel is within reach of the centre
+    const std::vector<int> block = {f("5A"), f("5B"), f("5C"), f("5D")};
+    const int decimation = CChannelizer::decimationFor(block);
+    PolyphaseChannelizer dsp(decimation * INPUT_RATE, decimation);
+    const int centre = (block.front() + block.back()) / 2;
+    for (int freq : block) {
+        REQUIRE(std::abs(freq - centre) <= dsp.getMaxOffset());
+    }
+}
+
+TEST_CASE("The input rate must reach the DAB rate", "[channelizer]") {
+    REQUIRE_THROWS_AS(CChannelizer(std::unique_ptr<CVirtualInput>()), std::invalid_argument);
+    REQUIRE_THROWS_AS(CChannelizer(std::unique_ptr<CVirtualInput>(
+                    new BufferInput({}, 1024000))), std::invalid_argument);
+    REQUIRE_NOTHROW(CChannelizer(std::unique_ptr<CVirtualInput>(
+                    new BufferInput({}, 3 * INPUT_RATE))));
+
+    // Rates that are no multiple of the DAB rate are decimated as far as
+    // possible, the OFDM processor resamples the rest.
+    CChannelizer ch(std::unique_ptr<CVirtualInput>(new BufferInput({}, 10000000)));
+    REQUIRE(ch.getOutputRate() == 2500000);
+    REQUIRE(CChannelizer::decimationOf(3 * INPUT_RATE) == 3);
+    REQUIRE(CChannelizer::decimationOf(2500000) == 1);
+    REQUIRE(CChannelizer::decimationOf(6000000) == 2);
+
+    auto& output = ch.addChannel(ch.getCenterFrequency());
+    REQUIRE(output.getSampleRate() == 2500000);
+}
+
+TEST_CASE("Two ensembles are received from one capture", "[channelizer]") {
+    const DABParams p(1);
+    const int frames = 3;
+    Channels channels;
+    const int freqA = channels.getFrequency("5A");
+    const int freqB = channels.getFrequency("5B");
+    const int centre = (freqA + freqB) / 2;
+
+    // Two different ensembles, side by side in a 4.096 MS/s capture
+    std::vector<DSPCOMPLEX> wideband;
+    for (int i = 0; i < 2; i++) {
+        auto config = EnsembleGenerator::makeConfig(4 + 4 * i, 48);
+        config.ensembleId = 0x4001 + i;
+        config.ensembleLabel = i == 0 ? "Block 5A" : "Block 5B";
+        EnsembleGenerator generator(config);
+        std::vector<DSPCOMPLEX> baseband(frames * p.T_F);
+        generator.getSamples(baseband.data(), baseband.size());
+        upconvert(baseband, (i == 0 ? freqA : freqB) - centre, wideband);
+    }
+
+    auto *device = new BufferInput(wideband, 2 * INPUT_RATE);
+    CChannelizer channelizer{std::unique_ptr<CVirtualInput>(device)};
+    channelizer.setCenterFrequency(centre);
+    REQUIRE(device->getFrequency() == centre);
+    REQUIRE(channelizer.canReceive(freqA));
+    REQUIRE(channelizer.canReceive(freqB));
+    REQUIRE_FALSE(channelizer.canReceive(channels.getFrequency("5D")));
+
+    auto& a = channelizer.addChannel(freqA);
+    auto& b = channelizer.addChannel(freqB);
+    REQUIRE(a.getID() == CDeviceID::CHANNELIZER);
+    REQUIRE(a.getFrequency() == freqA);
+    REQUIRE(b.setGain(3) == 3);
+    REQUIRE(a.getGain() == 3);
+
+    REQUIRE(a.restart());
+    REQUIRE(b.restart());
+    REQUIRE(device->restarts == 1);
+
+    const size_t expected = frames * p.T_F;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while ((size_t)a.getSamplesToRead() < expected or (size_t)b.getSamplesToRead() < expected) {
+        REQUIRE(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    CChannelizerOutput *outputs[] = {&a, &b};
+    for (int i = 0; i < 2; i++) {
+        std::vector<DSPCOMPLEX> samples(expected);
+        REQUIRE(outputs[i]->getSamples(samples.data(), samples.size()) == (int32_t)expected);
+
+        TestRadioInterface radio;
+        FicHandler fic(radio);
+        for (int f = 0; f < frames; f++) {
+            const auto bits = demodulate_fic(samples.data() + f * p.T_F);
+            for (int sym = 1; sym <= 3; sym++) {
+                fic.processFicBlock(&bits[(sym - 1) * 2 * p.K], sym);
+            }
+        }
+
+        REQUIRE(radio.fibsFailed == 0);
+        REQUIRE(radio.fibsOk == frames * 12);
+        REQUIRE(fic.fibProcessor.getEnsembleId() == 0x4001 + i);
+        REQUIRE(fic.fibProcessor.getServiceList().size() == (size_t)(4 + 4 * i));
+    }
+
+    // Both receivers see what the device lost
+    device->drop(100);
+    REQUIRE(a.getDiscontinuityCount() == 1);
+    REQUIRE(b.getDiscontinuityCount() == 1);
+
+    // The device runs as long as one receiver does
+    a.stop();
+    REQUIRE(device->stops == 0);
+    b.stop();
+    REQUIRE(device->stops == 1);
+}
+
+TEST_CASE("A channel outside of the capture gives zeros", "[channelizer]") {
+    const int rate = 2 * INPUT_RATE;
+    const size_t num = 200000;
+    auto *device = new BufferInput(tone(500000, rate, num), rate);
+    CChannelizer channelizer{std::unique_ptr<CVirtualInput>(device)};
+    channelizer.setCenterFrequency(200000000);
+
+    auto& inside = channelizer.addChannel(200500000);
+    auto& outside = channelizer.addChannel(203000000);
+    REQUIRE(inside.restart());
+    REQUIRE(outside.restart());
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((size_t)outside.getSamplesToRead() < num / 4) {
+        REQUIRE(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::vector<DSPCOMPLEX> samples(num / 4);
+    REQUIRE(outside.getSamples(samples.data(), samples.size()) == (int32_t)samples.size());
+    for (const auto& s : samples) {
+        REQUIRE(s == DSPCOMPLEX(0, 0));
+    }
+
+    REQUIRE(inside.getSamples(samples.data(), samples.size()) == (int32_t)samples.size());
+    REQUIRE(level(samples, 100) == Approx(1.0).epsilon(0.01));
+}
@@ -0,0 +1,237 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file ensemble_cache_tests.cpp
+ * @brief Tests for the on-disk cache of the received ensembles
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/ensemble-cache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static DabLabel make_label(const std::string& text)
+{
+    DabLabel label;
+    label.fig1_label = text;
+    label.fig1_flag = 0xFF00;
+    return label;
+}
+
+static EnsembleSnapshot make_ensemble()
+{
+    EnsembleSnapshot e;
+    e.ensembleId = 0x4FFF;
+    e.ensembleEcc = 0xE0;
+    e.ensembleLabel = make_label("Test ensemble");
+    e.subChannels.resize(64);
+
+    Service radio(0xC001);
+    radio.serviceLabel = make_label("Radio");
+    radio.programType = 10;
+    e.services.push_back(radio);
+
+    ServiceComponent audio;
+    audio.SId = 0xC001;
+    audio.TMid = 0;
+    audio.componentNr = 0;
+    audio.ASCTy = 63;
+    audio.PS_flag = 1;
+    audio.subchannelId = 5;
+    e.components.push_back(audio);
+
+    ServiceComponent data;
+    data.SId = 0xC001;
+    data.TMid = 3;
+    data.componentNr = 1;
+    data.componentLabel = make_label("Slides");
+    data.SCId = 0x123;
+    data.DSCTy = 60;
+    data.subchannelId = 6;
+    data.packetAddress = 1000;
+    e.components.push_back(data);
+
+    auto& sub = e.subChannels[5];
+    sub.subChId = 5;
+    sub.startAddr = 175;
+    sub.length = 35;
+    sub.programmeNotData = true;
+    sub.protectionSettings.shortForm = true;
+    sub.protectionSettings.uepTableIndex = 8;
+
+    auto& sub_data = e.subChannels[6];
+    sub_data.subChId = 6;
+    sub_data.startAddr = 210;
+    sub_data.length = 12;
+    sub_data.protectionSettings.shortForm = false;
+    sub_data.protectionSettings.eepProfile = EEPProtectionProfile::EEP_B;
+    sub_data.protectionSettings.eepLevel = EEPProtectionLevel::EEP_3;
+    return e;
+}
+
+static std::string make_temp_directory()
+{
+    char dir[] = "/tmp/ensemble_cache_XXXXXX";
+    REQUIRE(mkdtemp(dir) != nullptr);
+    return dir;
+}
+
+static void remove_directory(const std::string& dir, const std::string& channel)
+{
+    std::remove((dir + "/" + channel + ".last").c_str());
+    std::remove((dir + "/" + channel + "_4FFF.json").c_str());
+    std::remove((dir + "/" + channel + "_4FFE.json").c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("Ensembles survive the JSON roundtrip", "[ensemblecache]") {
+    const auto original = make_ensemble();
+    const auto e = EnsembleCache::fromJson(EnsembleCache::toJson(original));
+    REQUIRE(e);
+    REQUIRE(e->provisional);
+    REQUIRE(e->ensembleId == 0x4FFF);
+    REQUIRE(e->ensembleEcc == 0xE0);
+    REQUIRE(e->ensembleLabel.fig1_label == "Test ensemble");
+
+    const auto *s = e->findService(0xC001);
+    REQUIRE(s);
+    REQUIRE(s->serviceLabel.fig1_label == "Radio");
+    REQUIRE(s->serviceLabel.fig1_flag == 0xFF00);
+    REQUIRE(s->programType == 10);
+
+    const auto components = e->getComponents(0xC001);
+    REQUIRE(components.size() == 2);
+    REQUIRE(components.front().audioType() == AudioServiceComponentType::DABPlus);
+    REQUIRE(components.back().transportMode() == TransportMode::PacketData);
+    REQUIRE(components.back().SCId == 0x123);
+    REQUIRE(components.back().packetAddress == 1000);
+    REQUIRE(components.back().componentLabel.fig1_label == "Slides");
+
+    REQUIRE(e->subChannels.size() == 64);
+    REQUIRE(e->getSubchannel(5).startAddr == 175);
+    REQUIRE(e->getSubchannel(5).bitrate() == 48);
+    REQUIRE(e->getSubchannel(6).protectionSettings.eepProfile == EEPProtectionProfile::EEP_B);
+    REQUIRE(e->getSubchannel(6).bitrate() == original.subChannels[6].bitrate());
+    REQUIRE_FALSE(e->getSubchannel(7).valid());
+}
+
+TEST_CASE("Labels in other character sets are kept as they are", "[ensemblecache]") {
+    auto original = make_ensemble();
+    original.services[0].serviceLabel.charset = CharacterSet::UnicodeUcs2;
+    original.services[0].serviceLabel.fig1_label = std::string("\x00R\x00\xE9\x00\"", 6);
+
+    const auto e = EnsembleCache::fromJson(EnsembleCache::toJson(original));
+    REQUIRE(e);
+    REQUIRE(e->services[0].serviceLabel.charset == CharacterSet::UnicodeUcs2);
+    REQUIRE(e->services[0].serviceLabel.fig1_label == original.services[0].serviceLabel.fig1_label);
+}
+
+TEST_CASE("Damaged cache entries are ignored", "[ensemblecache]") {
+    REQUIRE_FALSE(EnsembleCache::fromJson(""));
+    REQUIRE_FALSE(EnsembleCache::fromJson("{\"version\": 1"));
+    REQUIRE_FALSE(EnsembleCache::fromJson("[]"));
+
+    auto text = EnsembleCache::toJson(make_ensemble());
+    const auto version = text.find("\"version\": 1");
+    REQUIRE(version != std::string::npos);
+    REQUIRE_FALSE(EnsembleCache::fromJson(
+                std::string(text).replace(version, 12, "\"version\": 99")));
+
+    // A component of an unknown service
+    auto orphan = make_ensemble();
+    orphan.components[1].SId = 0xC002;
+    REQUIRE_FALSE(EnsembleCache::fromJson(EnsembleCache::toJson(orphan)));
+
+    auto bad_subchannel = make_ensemble();
+    bad_subchannel.subChannels[5].protectionSettings.uepTableIndex = 64;
+    REQUIRE_FALSE(EnsembleCache::fromJson(EnsembleCache::toJson(bad_subchannel)));
+}
+
+TEST_CASE("The last ensemble of a channel is loaded", "[ensemblecache]") {
+    const auto dir = make_temp_directory();
+    EnsembleCache cache(dir);
+    REQUIRE_FALSE(cache.load("5A"));
+
+    auto e = make_ensemble();
+    REQUIRE(cache.save("5A", e));
+    REQUIRE_FALSE(cache.load("5B"));
+
+    auto loaded = cache.load("5A");
+    REQUIRE(loaded);
+    REQUIRE(loaded->ensembleId == 0x4FFF);
+    REQUIRE(loaded->services.size() == 1);
+
+    // Another ensemble on the same channel, both stay available
+    e.ensembleId = 0x4FFE;
+    REQUIRE(cache.save("5A", e));
+    loaded = cache.load("5A");
+    REQUIRE(loaded);
+    REQUIRE(loaded->ensembleId == 0x4FFE);
+    REQUIRE(cache.load("5A", 0x4FFF));
+    REQUIRE_FALSE(cache.load("5A", 0x1234));
+
+    // A damaged file is not used
+    {
+        std::ofstream f(dir + "/5A_4FFE.json");
+        f << "{\"version\": 1, \"eid\": ";
+    }
+    REQUIRE_FALSE(cache.load("5A"));
+
+    remove_directory(dir, "5A");
+}
+
+TEST_CASE("Incomplete ensembles are not saved", "[ensemblecache]") {
+    const auto dir = make_temp_directory();
+    EnsembleCache cache(dir);
+
+    auto e = make_ensemble();
+    e.provisional = true;
+    REQUIRE_FALSE(cache.save("5A", e));
+
+    e = make_ensemble();
+    e.ensembleId = 0;
+    REQUIRE_FALSE(cache.save("5A", e));
+
+    e = make_ensemble();
+    e.services.clear();
+    e.components.clear();
+    REQUIRE_FALSE(cache.save("5A", e));
+
+    REQUIRE_FALSE(cache.load("5A"));
+
+    // Into a directory that does not exist
+    EnsembleCache missing(dir + "/missing");
+    REQUIRE_FALSE(missing.save("5A", make_ensemble()));
+
+    remove_directory(dir, "5A");
+}
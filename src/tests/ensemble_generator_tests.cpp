@@ -0,0 +1,448 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file ensemble_generator_tests.cpp
+ * @brief Tests for the synthetic DAB ensemble generator and its input
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../input/ensemble_generator.h"
+#include "../input/synthetic_input.h"
+#include "../backend/eep-protection.h"
+#include "../backend/energy_dispersal.h"
+#include "../backend/fic-handler.h"
+#include "../backend/tools.h"
+#include "../various/MathHelper.h"
+#include "test_radio_interface.h"
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <fec.h>
+}
+
+// Soft bits of the symbols 1 to L-1 of a frame that starts with the NULL
+// symbol at frame[0], demodulated the same way as OfdmDecoder does.
+static std::vector<softbit_t> demodulate(const DSPCOMPLEX *frame)
+{
+    const DABParams p(1);
+    fft::Forward fft(p.T_u);
+    FrequencyInterleaver interleaver(p);
+    std::vector<DSPCOMPLEX> previous(p.T_u);
+    std::vector<softbit_t> bits((p.L - 1) * 2 * p.K);
+
+    for (int sym = 0; sym < p.L; sym++) {
+        const DSPCOMPLEX *s = frame + p.T_null + sym * p.T_s + (p.T_s - p.T_u);
+        DSPCOMPLEX *v = fft.getVector();
+        std::copy(s, s + p.T_u, v);
+        fft.do_FFT();
+
+        if (sym > 0) {
+            softbit_t *out = &bits[(sym - 1) * 2 * p.K];
+            for (int i = 0; i < p.K; i++) {
+                int16_t index = interleaver.mapIn(i);
+                if (index < 0) {
+                    index += p.T_u;
+                }
+                const DSPCOMPLEX r1 = v[index] * conj(previous[index]);
+                const float ab1 = l1_norm(r1);
+                out[i] = -real(r1) * 127.0f / ab1;
+                out[p.K + i] = -imag(r1) * 127.0f / ab1;
+            }
+        }
+        std::copy(v, v + p.T_u, previous.begin());
+    }
+    return bits;
+}
+
+// Undo the time interleaving, protection and energy dispersal of one
+// subchannel, like DabAudio does
+class SubchannelDecoder {
+    public:
+        SubchannelDecoder(const Subchannel& sub) :
+            sub(sub),
+            eep(sub.bitrate(), true, (int)sub.protectionSettings.eepLevel),
+            history(16, std::vector<softbit_t>(sub.length * 64)),
+            deinterleaved(sub.length * 64),
+            bits(sub.bitrate() * 24) {}
+
+        // Returns false while the deinterleaver fills up
+        bool process(const softbit_t *cif, std::vector<uint8_t>& frame) {
+            static const int16_t interleaveMap[] = {0,8,4,12,2,10,6,14,1,9,5,13,3,11,7,15};
+            const softbit_t *in = cif + sub.startAddr * 64;
+            for (size_t i = 0; i < deinterleaved.size(); i++) {
+                deinterleaved[i] = history[(index + interleaveMap[i & 15]) & 15][i];
+                history[index][i] = in[i];
+            }
+            index = (index + 1) & 15;
+            if (count++ < 16) {
+                return false;
+            }
+
+            eep.deconvolve(deinterleaved.data(), deinterleaved.size(), bits.data());
+            dispersal.dedisperse(bits);
+            frame.assign(bits.size() / 8, 0);
+            for (size_t i = 0; i < bits.size(); i++) {
+                frame[i / 8] |= bits[i] << (7 - (i % 8));
+            }
+            return true;
+        }
+
+    private:
+        Subchannel sub;
+        EEPProtection eep;
+        EnergyDispersal dispersal;
+        std::vector<std::vector<softbit_t>> history;
+        std::vector<softbit_t> deinterleaved;
+        std::vector<uint8_t> bits;
+        int index = 0;
+        int count = 0;
+};
+
+TEST_CASE("Convolutional code is decoded by the Viterbi decoder", "[generator]") {
+    const int16_t size = 768;
+    std::mt19937 rng(42);
+    std::vector<uint8_t> bits(size);
+    for (auto& b : bits) {
+        b = rng() & 1;
+    }
+
+    std::vector<uint8_t> code;
+    EnsembleGenerator::convolve(bits.data(), size, code);
+    REQUIRE(code.size() == 4 * (size + 6));
+
+    std::vector<softbit_t> soft(code.size());
+    for (size_t i = 0; i < code.size(); i++) {
+        soft[i] = code[i] ? 127 : -127;
+    }
+
+    Viterbi viterbi(size);
+    std::vector<uint8_t> decoded(size);
+    viterbi.deconvolve(soft.data(), decoded.data());
+    REQUIRE(decoded == bits);
+}
+
+TEST_CASE("Silent superframes are valid DAB+ superframes", "[generator]") {
+    for (int bitrate : {8, 48, 192}) {
+        const size_t s = bitrate / 8;
+        auto sf = EnsembleGenerator::silentSuperframe(bitrate);
+        REQUIRE(sf.size() == 120 * s);
+
+        const uint16_t firecode = sf[0] << 8 | sf[1];
+        REQUIRE(firecode == CalcCRC::CalcCRC_FIRE_CODE.Calc(sf.data() + 2, 9));
+
+        // 48 kHz, six AUs
+        REQUIRE(sf[2] == 0x40);
+        int auStart[7];
+        auStart[0] = 11;
+        auStart[1] = sf[3] << 4 | sf[4] >> 4;
+        auStart[2] = (sf[4] & 0x0F) << 8 | sf[5];
+        auStart[3] = sf[6] << 4 | sf[7] >> 4;
+        auStart[4] = (sf[7] & 0x0F) << 8 | sf[8];
+        auStart[5] = sf[9] << 4 | sf[10] >> 4;
+        auStart[6] = 110 * s;
+        for (int i = 0; i < 6; i++) {
+            REQUIRE(auStart[i] < auStart[i + 1]);
+            const uint8_t *au = sf.data() + auStart[i];
+            const size_t len = auStart[i + 1] - auStart[i];
+            REQUIRE(check_crc_bytes(au, len - 2));
+        }
+
+        // An error in every RS packet gets corrected
+        void *rs = init_rs_char(8, 0x11D, 0, 1, 10, 135);
+        uint8_t packet[120];
+        int corrPos[10];
+        for (size_t i = 0; i < s; i++) {
+            for (int pos = 0; pos < 120; pos++) {
+                packet[pos] = sf[pos * s + i];
+            }
+            REQUIRE(decode_rs_char(rs, packet, corrPos, 0) == 0);
+            packet[17] ^= 0x5A;
+            REQUIRE(decode_rs_char(rs, packet, corrPos, 0) == 1);
+            REQUIRE(packet[17] == sf[17 * s + i]);
+        }
+        free_rs_char(rs);
+    }
+}
+
+TEST_CASE("FIC of 64 services is decoded", "[generator]") {
+    auto config = EnsembleGenerator::makeConfig(64, 16);
+    config.ensembleLabel = "Load test";
+    EnsembleGenerator generator(config);
+    REQUIRE(generator.getSubchannels().size() == 64);
+    REQUIRE(generator.getSubchannels().back().startAddr +
+            generator.getSubchannels().back().length == 64 * 12);
+
+    TestRadioInterface radio;
+    FicHandler fic(radio);
+
+    const DABParams p(1);
+    std::vector<DSPCOMPLEX> frame(p.T_F);
+    for (int f = 0; f < 30; f++) {
+        generator.getSamples(frame.data(), frame.size());
+        const auto bits = demodulate(frame.data());
+        for (int sym = 1; sym <= 3; sym++) {
+            fic.processFicBlock(&bits[(sym - 1) * 2 * p.K], sym);
+        }
+    }
+    REQUIRE(generator.getFrameCount() == 30);
+
+    REQUIRE(radio.fibsFailed == 0);
+    REQUIRE(radio.fibsOk == 30 * 12);
+
+    auto& fib = fic.fibProcessor;
+    REQUIRE(fib.getEnsembleId() == config.ensembleId);
+    REQUIRE(fib.getEnsembleLabel().utf8_label() == "Load test       ");
+
+    const auto services = fib.getServiceList();
+    REQUIRE(services.size() == 64);
+    for (const auto& s : services) {
+        const int i = s.serviceId - 0xE001;
+        REQUIRE(i >= 0);
+        REQUIRE(i < 64);
+        REQUIRE(s.serviceLabel.fig1_label == config.services[i].label + "    ");
+
+        const auto components = fib.getComponents(s);
+        REQUIRE(components.size() == 1);
+        REQUIRE(components.front().audioType() == AudioServiceComponentType::DABPlus);
+
+        const auto sub = fib.getSubchannel(components.front());
+        REQUIRE(sub.subChId == i);
+        REQUIRE(sub.startAddr == generator.getSubchannels()[i].startAddr);
+        REQUIRE(sub.length == 12);
+        REQUIRE(sub.bitrate() == 16);
+    }
+}
+
+TEST_CASE("MSC carries the superframes through a noisy channel with echoes", "[generator]") {
+    auto config = EnsembleGenerator::makeConfig(4, 48, 3);
+    config.services[2].bitrate = 64;
+    config.services[2].protectionLevel = 2;
+    config.noise = true;
+    config.snr = 12;
+    EnsembleGenerator::Echo echo;
+    echo.delay = 40;
+    echo.gain = 0.4f;
+    echo.phase = 1.0f;
+    config.echoes.push_back(echo);
+    EnsembleGenerator generator(config);
+
+    const int checked = 2;
+    const auto sub = generator.getSubchannels()[checked];
+    REQUIRE(sub.bitrate() == 64);
+    SubchannelDecoder decoder(sub);
+    const auto superframe = EnsembleGenerator::silentSuperframe(64);
+    const size_t frameLength = 3 * 64;
+
+    const DABParams p(1);
+    std::vector<DSPCOMPLEX> frame(p.T_F);
+    int cifs = 0;
+    int decoded = 0;
+    std::vector<uint8_t> logicalFrame;
+    for (int f = 0; f < 8; f++) {
+        generator.getSamples(frame.data(), frame.size());
+        const auto bits = demodulate(frame.data());
+        for (int c = 0; c < 4; c++) {
+            const softbit_t *cif = &bits[(3 + c * 18) * 2 * p.K];
+            if (decoder.process(cif, logicalFrame)) {
+                // The time interleaving delays by 16 CIFs
+                const size_t n = cifs - 16;
+                const size_t offset = (n * frameLength) % superframe.size();
+                REQUIRE(logicalFrame.size() == frameLength);
+                REQUIRE(std::equal(logicalFrame.begin(), logicalFrame.end(),
+                            superframe.begin() + offset));
+                decoded++;
+            }
+            cifs++;
+        }
+    }
+    REQUIRE(decoded == 16);
+}
+
+TEST_CASE("Generated signal has the configured level and is repeatable", "[generator]") {
+    auto config = EnsembleGenerator::makeConfig(2, 32);
+    config.frequencyOffset = 1234.5f;
+    const DABParams p(1);
+
+    std::vector<DSPCOMPLEX> a(p.T_F);
+    std::vector<DSPCOMPLEX> b(p.T_F);
+    {
+        EnsembleGenerator generator(config);
+        generator.getSamples(a.data(), 1000);
+        generator.getSamples(a.data() + 1000, a.size() - 1000);
+    }
+    {
+        EnsembleGenerator generator(config);
+        generator.getSamples(b.data(), b.size());
+    }
+    REQUIRE(a == b);
+
+    // The NULL symbol is silent
+    for (int i = 0; i < p.T_null; i++) {
+        REQUIRE(a[i] == DSPCOMPLEX(0, 0));
+    }
+
+    double power = 0;
+    for (size_t i = p.T_null; i < a.size(); i++) {
+        power += std::norm(a[i]);
+    }
+    const double rms = std::sqrt(power / (a.size() - p.T_null));
+    REQUIRE(rms == Approx(config.level).epsilon(0.01));
+}
+
+TEST_CASE("Invalid ensembles are rejected", "[generator]") {
+    REQUIRE_THROWS_AS(EnsembleGenerator(EnsembleGenerator::makeConfig(65, 8)),
+            std::invalid_argument);
+    REQUIRE_THROWS_AS(EnsembleGenerator(EnsembleGenerator::makeConfig(1, 12)),
+            std::invalid_argument);
+    REQUIRE_THROWS_AS(EnsembleGenerator(EnsembleGenerator::makeConfig(1, 48, 5)),
+            std::invalid_argument);
+    // 20 services of 64 kbps with EEP-3A need 960 CUs
+    REQUIRE_THROWS_AS(EnsembleGenerator(EnsembleGenerator::makeConfig(20, 64)),
+            std::invalid_argument);
+
+    auto config = EnsembleGenerator::makeConfig(1, 48);
+    config.services[0].audioFile = "does-not-exist.dabp";
+    REQUIRE_THROWS_AS(EnsembleGenerator(config), std::invalid_argument);
+
+    config = EnsembleGenerator::makeConfig(1, 48);
+    config.extraFigs.push_back({ 0x05, 0x00, 0x01 });
+    REQUIRE_THROWS_AS(EnsembleGenerator(config), std::invalid_argument);
+}
+
+TEST_CASE("Superframes are read from an audio file", "[generator]") {
+    // Two different superframes
+    auto sf1 = EnsembleGenerator::silentSuperframe(32);
+    auto sf2 = sf1;
+    sf2[20] ^= 0xFF;
+    const std::string name = "ensemble_generator_test.dabp";
+    FILE *fd = fopen(name.c_str(), "wb");
+    fwrite(sf1.data(), 1, sf1.size(), fd);
+    fwrite(sf2.data(), 1, sf2.size(), fd);
+    fclose(fd);
+
+    auto config = EnsembleGenerator::makeConfig(1, 32);
+    config.services[0].audioFile = name;
+    EnsembleGenerator generator(config);
+
+    config.services[0].bitrate = 48;
+    REQUIRE_THROWS_AS(EnsembleGenerator(config), std::invalid_argument);
+    remove(name.c_str());
+
+    SubchannelDecoder decoder(generator.getSubchannels()[0]);
+    const DABParams p(1);
+    std::vector<DSPCOMPLEX> frame(p.T_F);
+    std::vector<uint8_t> logicalFrame;
+    std::vector<uint8_t> received;
+    for (int f = 0; f < 9; f++) {
+        generator.getSamples(frame.data(), frame.size());
+        const auto bits = demodulate(frame.data());
+        for (int c = 0; c < 4; c++) {
+            if (decoder.process(&bits[(3 + c * 18) * 2 * p.K], logicalFrame)) {
+                received.insert(received.end(), logicalFrame.begin(), logicalFrame.end());
+            }
+        }
+    }
+
+    // 20 logical frames are two superframes each
+    REQUIRE(received.size() == 2 * (sf1.size() + sf2.size()));
+    REQUIRE(std::equal(sf1.begin(), sf1.end(), received.begin()));
+    REQUIRE(std::equal(sf2.begin(), sf2.end(), received.begin() + sf1.size()));
+    REQUIRE(std::equal(sf1.begin(), sf1.end(), received.begin() + 2 * sf1.size()));
+}
+
+TEST_CASE("Synthetic input options are parsed", "[generator]") {
+    bool throttle = true;
+    auto config = CSyntheticInput::parseArgs(
+            "services=64,bitrate=16,protection=4,snr=20,offset=-500,echo=20:0.3,echo=40:0.1:1.5,seed=7,throttle=0",
+            throttle);
+    REQUIRE_FALSE(throttle);
+    REQUIRE(config.services.size() == 64);
+    REQUIRE(config.services[0].bitrate == 16);
+    REQUIRE(config.services[0].protectionLevel == 4);
+    REQUIRE(config.noise);
+    REQUIRE(config.snr == 20);
+    REQUIRE(config.frequencyOffset == -500);
+    REQUIRE(config.echoes.size() == 2);
+    REQUIRE(config.echoes[1].delay == 40);
+    REQUIRE(config.echoes[1].phase == Approx(1.5f));
+    REQUIRE(config.seed == 7);
+
+    config = CSyntheticInput::parseArgs("", throttle);
+    REQUIRE(throttle);
+    REQUIRE(config.services.size() == 8);
+    REQUIRE_FALSE(config.noise);
+
+    REQUIRE_THROWS_AS(CSyntheticInput::parseArgs("services", throttle), std::invalid_argument);
+    REQUIRE_THROWS_AS(CSyntheticInput::parseArgs("bitrate=abc", throttle), std::invalid_argument);
+    REQUIRE_THROWS_AS(CSyntheticInput::parseArgs("echo=10", throttle), std::invalid_argument);
+    REQUIRE_THROWS_AS(CSyntheticInput::parseArgs("colour=blue", throttle), std::invalid_argument);
+}
+
+TEST_CASE("Throttled synthetic input gives samples at the sample rate", "[generator]") {
+    CSyntheticInput input(EnsembleGenerator::makeConfig(1, 48), true);
+    REQUIRE(input.getID() == CDeviceID::SYNTHETIC);
+    REQUIRE(input.getSamplesToRead() == 0);
+
+    input.restart();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const int32_t available = input.getSamplesToRead();
+    REQUIRE(available >= INPUT_RATE / 20);
+    REQUIRE(available < INPUT_RATE / 2);
+
+    std::vector<DSPCOMPLEX> buffer(available);
+    REQUIRE(input.getSamples(buffer.data(), available) == available);
+    REQUIRE(input.getSpectrumSamples(1024).size() == 1024);
+
+    // A receiver lagging by more than half a second loses samples
+    std::this_thread::sleep_for(std::chrono::milliseconds(700));
+    REQUIRE(input.getSamplesToRead() == INPUT_RATE / 2);
+    input.getSamples(buffer.data(), 1);
+    const auto stats = input.getInputStats();
+    REQUIRE(stats.samplesDropped > 0);
+    REQUIRE(input.getDiscontinuityCount() == 1);
+
+    input.stop();
+    REQUIRE(input.getSamplesToRead() == 0);
+}
+
+TEST_CASE("Unthrottled synthetic input never makes the receiver wait", "[generator]") {
+    CSyntheticInput input(EnsembleGenerator::makeConfig(1, 48), false);
+    input.restart();
+    REQUIRE(input.getSamplesToRead() == INT32_MAX);
+
+    const DABParams p(1);
+    std::vector<DSPCOMPLEX> buffer(3 * p.T_F);
+    REQUIRE(input.getSamples(buffer.data(), buffer.size()) == (int32_t)buffer.size());
+    REQUIRE(input.getGenerator().getFrameCount() == 3);
+    REQUIRE(input.getInputStats().samplesDropped == 0);
+}
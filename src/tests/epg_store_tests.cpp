@@ -0,0 +1,514 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file epg_store_tests.cpp
+ * @brief Tests for the decoder of the binary encoded SPI objects and for
+ *        the programme guide welle-cli builds from them
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/spi-decoder.h"
+#include "../backend/tools.h"
+#include "../welle-cli/epgstore.h"
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using bytes_t = std::vector<uint8_t>;
+
+// 2025-03-01 00:00:00 UTC
+static const std::time_t DAY = 1740787200;
+static const uint32_t MJD_DAY = 60735;
+
+static bytes_t element(uint8_t tag, const std::vector<bytes_t>& children)
+{
+    bytes_t data;
+    for (const auto& c : children) {
+        data.insert(data.end(), c.begin(), c.end());
+    }
+
+    bytes_t e = {tag};
+    if (data.size() < 0xFE) {
+        e.push_back(data.size());
+    }
+    else {
+        e.push_back(0xFE);
+        e.push_back(data.size() >> 8);
+        e.push_back(data.size() & 0xFF);
+    }
+    e.insert(e.end(), data.begin(), data.end());
+    return e;
+}
+
+static bytes_t attribute(uint8_t tag, const bytes_t& value)
+{
+    return element(tag, {value});
+}
+
+static bytes_t text(uint8_t tag, const std::string& s)
+{
+    return element(tag, {element(0x01, {bytes_t(s.begin(), s.end())})});
+}
+
+// Short form without seconds, or long form
+static bytes_t time_point(std::time_t t, bool long_form = false)
+{
+    const uint32_t secs = t - DAY;
+    const uint32_t mjd = MJD_DAY + secs / 86400;
+    const uint32_t hours = (secs % 86400) / 3600;
+    const uint32_t minutes = (secs % 3600) / 60;
+    const uint32_t v = (mjd << 14) | (long_form << 11) | (hours << 6) | minutes;
+
+    bytes_t b = {(uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v};
+    if (long_form) {
+        b.push_back((secs % 60) << 2);
+        b.push_back(0);
+    }
+    return b;
+}
+
+static bytes_t content_id(uint32_t sid)
+{
+    return {0x00, (uint8_t)(sid >> 8), (uint8_t)sid};
+}
+
+static bytes_t genre(const bytes_t& href)
+{
+    return element(0x14, {attribute(0x80, href)});
+}
+
+static bytes_t programme(const std::string& name, std::time_t start,
+        uint16_t duration, const std::vector<bytes_t>& extra = {})
+{
+    std::vector<bytes_t> children = {
+        attribute(0x80, bytes_t{'c', 'r', 'i', 'd'}),
+        attribute(0x81, {0x00, 0x01, 0x02}),
+        text(0x10, name),
+        element(0x19, {element(0x2C, {
+                    attribute(0x80, time_point(start)),
+                    attribute(0x81, {(uint8_t)(duration >> 8), (uint8_t)duration})})}),
+    };
+    children.insert(children.end(), extra.begin(), extra.end());
+    return element(0x1C, children);
+}
+
+static bytes_t programme_information(uint32_t sid, const std::vector<bytes_t>& programmes)
+{
+    std::vector<bytes_t> schedule = {
+        element(0x24, {
+                attribute(0x80, time_point(DAY)),
+                attribute(0x81, time_point(DAY + 86400)),
+                element(0x25, {attribute(0x80, content_id(sid))})}),
+    };
+    schedule.insert(schedule.end(), programmes.begin(), programmes.end());
+    return element(0x02, {element(0x21, schedule)});
+}
+
+TEST_CASE("Time points", "[spi]") {
+    std::time_t t = 0;
+    const auto short_form = time_point(DAY + 3600 * 13 + 60 * 45);
+    REQUIRE(SpiDecoder::decodeTime(short_form.data(), short_form.size(), t));
+    REQUIRE(t == DAY + 3600 * 13 + 60 * 45);
+
+    const auto long_form = time_point(DAY + 86400 + 59, true);
+    REQUIRE(SpiDecoder::decodeTime(long_form.data(), long_form.size(), t));
+    REQUIRE(t == DAY + 86400 + 59);
+
+    // The long form needs six bytes
+    REQUIRE_FALSE(SpiDecoder::decodeTime(long_form.data(), 4, t));
+    REQUIRE_FALSE(SpiDecoder::decodeTime(short_form.data(), 3, t));
+}
+
+TEST_CASE("Content IDs and genres", "[spi]") {
+    uint32_t sid = 0;
+    const bytes_t short_sid = {0x00, 0xC2, 0x21};
+    REQUIRE(SpiDecoder::decodeContentId(short_sid.data(), short_sid.size(), sid));
+    REQUIRE(sid == 0xC221);
+
+    // Ensemble ECC and EId, then a 32-bit SId
+    const bytes_t long_sid = {0x50, 0xE1, 0xC1, 0x81, 0xE1, 0x23, 0x45, 0x67};
+    REQUIRE(SpiDecoder::decodeContentId(long_sid.data(), long_sid.size(), sid));
+    REQUIRE(sid == 0xE1234567);
+    REQUIRE_FALSE(SpiDecoder::decodeContentId(long_sid.data(), 6, sid));
+
+    const bytes_t href = {0x03, 6, 8};
+    REQUIRE(SpiDecoder::decodeGenre(href.data(), href.size()) == "3.6.8");
+    const bytes_t no_scheme = {0x00, 6};
+    REQUIRE(SpiDecoder::decodeGenre(no_scheme.data(), no_scheme.size()).empty());
+}
+
+TEST_CASE("Programme information", "[spi]") {
+    const std::string long_description(300, 'x');
+    const bytes_t token_table = {0x01, 5, 'N', 'e', 'w', 's', ' '};
+
+    const auto pi = element(0x02, {
+            element(0x04, {token_table}),
+            element(0x21, {
+                element(0x24, {element(0x25, {attribute(0x80, content_id(0xC221))})}),
+                programme("\x01" "at noon", DAY + 12 * 3600, 1800, {
+                    text(0x12, "The news at noon"),
+                    element(0x13, {text(0x1A, "Short"), text(0x1B, long_description)}),
+                    genre({0x03, 1, 1}),
+                    genre({0x02, 1}),
+                }),
+                // On a bearer of its own, started late
+                element(0x1C, {
+                    text(0x10, "Jazz"),
+                    element(0x19, {
+                        element(0x2C, {
+                            attribute(0x82, time_point(DAY + 13 * 3600 + 120, true)),
+                            attribute(0x80, time_point(DAY + 13 * 3600)),
+                            attribute(0x81, {0x0E, 0x10})}),
+                        element(0x2D, {attribute(0x80, content_id(0xC222))})}),
+                    // Repeated later, only the first time is kept
+                    element(0x19, {element(0x2C, {
+                            attribute(0x80, time_point(DAY + 20 * 3600))})}),
+                }),
+                // Without a time, not kept
+                element(0x1C, {text(0x10, "Timeless")}),
+            })});
+
+    SpiDecoder decoder;
+    SpiDecoder::Schedule schedule;
+    REQUIRE(decoder.decodeProgrammeInformation(pi.data(), pi.size(), schedule));
+    REQUIRE(schedule.service_id == 0xC221);
+    REQUIRE(schedule.programmes.size() == 2);
+
+    const auto& news = schedule.programmes[0];
+    REQUIRE(news.service_id == 0xC221);
+    REQUIRE(news.start == DAY + 12 * 3600);
+    REQUIRE(news.duration == 1800);
+    REQUIRE(news.short_name == "News at noon");
+    REQUIRE(news.name() == "The news at noon");
+    REQUIRE(news.short_description == "Short");
+    REQUIRE(news.long_description == long_description);
+    REQUIRE(news.genres == std::vector<std::string>{"3.1.1", "2.1"});
+    REQUIRE(news.id == "crid");
+    REQUIRE(news.short_id == 0x000102);
+
+    const auto& jazz = schedule.programmes[1];
+    REQUIRE(jazz.service_id == 0xC222);
+    REQUIRE(jazz.start == DAY + 13 * 3600 + 120);
+    REQUIRE(jazz.duration == 3600);
+
+    // The same decoder and schedule for the next object
+    const auto other = programme_information(0xC223,
+            {programme("Sport", DAY + 15 * 3600, 600)});
+    REQUIRE(decoder.decodeProgrammeInformation(other.data(), other.size(), schedule));
+    REQUIRE(schedule.service_id == 0xC223);
+    REQUIRE(schedule.start == DAY);
+    REQUIRE(schedule.stop == DAY + 86400);
+    REQUIRE(schedule.programmes.size() == 1);
+    REQUIRE(schedule.programmes[0].short_name == "Sport");
+    REQUIRE(schedule.programmes[0].genres.empty());
+}
+
+TEST_CASE("Damaged objects are rejected", "[spi]") {
+    const auto pi = programme_information(0xC221,
+            {programme("News", DAY, 600)});
+
+    SpiDecoder decoder;
+    SpiDecoder::Schedule schedule;
+    REQUIRE_FALSE(decoder.decodeProgrammeInformation(pi.data(), pi.size() - 3, schedule));
+
+    std::vector<SpiService> services;
+    REQUIRE_FALSE(decoder.decodeServiceInformation(pi.data(), pi.size(), services));
+}
+
+TEST_CASE("Service information", "[spi]") {
+    const auto service = [](uint16_t sid, const std::string& name) {
+        return element(0x28, {
+                text(0x11, name),
+                element(0x13, {text(0x1A, name + " radio")}),
+                genre({0x03, 3}),
+                element(0x29, {attribute(0x80, content_id(sid))})});
+    };
+
+    const auto si = element(0x03, {
+            service(0xC221, "One"),
+            // Services inside an ensemble
+            element(0x26, {text(0x10, "Mux"), service(0xC222, "Two")}),
+            // No service ID
+            element(0x28, {text(0x11, "Nobody")}),
+        });
+
+    SpiDecoder decoder;
+    std::vector<SpiService> services;
+    REQUIRE(decoder.decodeServiceInformation(si.data(), si.size(), services));
+    REQUIRE(services.size() == 2);
+    REQUIRE(services[0].service_id == 0xC221);
+    REQUIRE(services[0].name() == "One");
+    REQUIRE(services[0].short_description == "One radio");
+    REQUIRE(services[0].genres == std::vector<std::string>{"3.3"});
+    REQUIRE(services[1].service_id == 0xC222);
+    REQUIRE(services[1].medium_name == "Two");
+}
+
+static std::vector<std::string> names(const std::vector<SpiProgramme>& programmes)
+{
+    std::vector<std::string> n;
+    for (const auto& p : programmes) {
+        n.push_back(p.short_name);
+    }
+    return n;
+}
+
+static EpgStore::Query window(std::time_t from, std::time_t to,
+        uint32_t sid = 0, const std::string& genre = "")
+{
+    EpgStore::Query q;
+    q.service_id = sid;
+    q.from = from;
+    q.to = to;
+    q.genre = genre;
+    return q;
+}
+
+TEST_CASE("Programme guide queries", "[epg]") {
+    EpgStore store;
+    const auto pi = SpiDecoder::CONTENT_SUB_TYPE_PI;
+
+    REQUIRE(store.update("a_PI", pi, programme_information(0xC221, {
+                    programme("Morning", DAY + 6 * 3600, 3 * 3600, {genre({0x03, 6, 8})}),
+                    programme("Noon", DAY + 12 * 3600, 3600, {genre({0x03, 60})}),
+                    programme("Evening", DAY + 18 * 3600, 3600, {genre({0x03, 6})}),
+                }), DAY));
+    REQUIRE(store.update("b_PI", pi, programme_information(0xC222, {
+                    programme("Other", DAY + 7 * 3600, 3600),
+                }), DAY));
+    REQUIRE(store.getNumProgrammes() == 4);
+
+    // The morning show started before the window
+    REQUIRE(names(store.query(window(DAY + 8 * 3600, DAY + 13 * 3600))) ==
+            std::vector<std::string>{"Morning", "Noon"});
+    REQUIRE(names(store.query(window(DAY + 6 * 3600, DAY + 8 * 3600))) ==
+            std::vector<std::string>{"Morning", "Other"});
+    REQUIRE(names(store.query(window(DAY, 0, 0xC222))) ==
+            std::vector<std::string>{"Other"});
+    REQUIRE(store.query(window(DAY, 0, 0xC223)).empty());
+
+    // "3.6" gives "3.6" and "3.6.8", not "3.60"
+    REQUIRE(names(store.query(window(DAY, 0, 0, "3.6"))) ==
+            std::vector<std::string>{"Morning", "Evening"});
+    REQUIRE(names(store.query(window(DAY + 10 * 3600, 0, 0, "3.6"))) ==
+            std::vector<std::string>{"Evening"});
+    REQUIRE(names(store.query(window(DAY, 0, 0xC222, "3.6"))).empty());
+}
+
+TEST_CASE("Objects are updated incrementally", "[epg]") {
+    EpgStore store;
+    const auto pi = SpiDecoder::CONTENT_SUB_TYPE_PI;
+    const auto v1 = programme_information(0xC221, {
+            programme("First", DAY + 3600, 600, {genre({0x03, 1})}),
+            programme("Second", DAY + 7200, 600),
+        });
+
+    REQUIRE(store.update("a_PI", pi, v1, DAY));
+    const auto generation = store.getGeneration();
+
+    // The carousel repeats the object
+    REQUIRE_FALSE(store.update("a_PI", pi, v1, DAY));
+    REQUIRE(store.getRepetitions() == 1);
+    REQUIRE(store.getGeneration() == generation);
+
+    // The next version drops a programme and renames the other
+    REQUIRE(store.update("a_PI", pi, programme_information(0xC221, {
+                    programme("Second, renamed", DAY + 7200, 600),
+                }), DAY));
+    REQUIRE(names(store.query(window(DAY, 0))) ==
+            std::vector<std::string>{"Second, renamed"});
+    REQUIRE(store.query(window(DAY, 0, 0, "3.1")).empty());
+
+    // Damaged objects and other subtypes change nothing
+    REQUIRE_FALSE(store.update("b_PI", pi, bytes_t{0x02, 0x10}, DAY));
+    REQUIRE_FALSE(store.update("c_GI", SpiDecoder::CONTENT_SUB_TYPE_GI, v1, DAY));
+    REQUIRE(store.getNumProgrammes() == 1);
+
+    // Past programmes are forgotten
+    const auto later = DAY + 7200 + 600 + EpgStore::KEEP_PAST + 1;
+    REQUIRE(store.update("d_PI", pi, programme_information(0xC222, {
+                    programme("Tomorrow", DAY + 86400, 600),
+                }), later));
+    REQUIRE(names(store.query(window(DAY, 0))) ==
+            std::vector<std::string>{"Tomorrow"});
+}
+
+TEST_CASE("Programme guide is saved and loaded", "[epg]") {
+    char dir_template[] = "/tmp/epg_store_tests_XXXXXX";
+    REQUIRE(mkdtemp(dir_template) != nullptr);
+    const std::string dir = dir_template;
+
+    const auto v1 = programme_information(0xC221, {
+            programme("News", DAY + 3600, 600, {
+                genre({0x03, 1, 1}),
+                element(0x13, {text(0x1B, "Long \"quoted\" text")})}),
+        });
+    const auto si = element(0x03, {element(0x28, {
+                text(0x12, "Radio One"),
+                element(0x29, {attribute(0x80, content_id(0xC221))})})});
+
+    {
+        EpgStore store(dir);
+        REQUIRE_FALSE(store.load(DAY));
+        REQUIRE_FALSE(store.save());
+
+        REQUIRE(store.update("a_PI", SpiDecoder::CONTENT_SUB_TYPE_PI, v1, DAY));
+        REQUIRE(store.update("a_SI", SpiDecoder::CONTENT_SUB_TYPE_SI, si, DAY));
+        REQUIRE(store.save());
+        // Nothing changed since
+        REQUIRE_FALSE(store.save());
+    }
+
+    EpgStore store(dir);
+    REQUIRE(store.load(DAY));
+    const auto programmes = store.query(window(DAY, 0, 0, "3.1"));
+    REQUIRE(programmes.size() == 1);
+    REQUIRE(programmes[0].short_name == "News");
+    REQUIRE(programmes[0].long_description == "Long \"quoted\" text");
+    REQUIRE(programmes[0].start == DAY + 3600);
+    REQUIRE(programmes[0].duration == 600);
+    REQUIRE(programmes[0].short_id == 0x000102);
+
+    const auto services = store.getServices();
+    REQUIRE(services.size() == 1);
+    REQUIRE(services[0].long_name == "Radio One");
+
+    // The objects are known after the restart
+    REQUIRE_FALSE(store.update("a_PI", SpiDecoder::CONTENT_SUB_TYPE_PI, v1, DAY));
+    REQUIRE(store.getRepetitions() == 1);
+
+    unlink((dir + "/epg.json").c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("Receivers of several channels share the guide", "[epg]") {
+    char dir_template[] = "/tmp/epg_store_tests_XXXXXX";
+    REQUIRE(mkdtemp(dir_template) != nullptr);
+    const std::string dir = dir_template;
+
+    {
+        EpgStore store(dir);
+        // Each receiver adds the guide of its ensemble and saves
+        std::vector<std::thread> receivers;
+        for (uint32_t sid : {0xC221u, 0xD321u, 0xE421u}) {
+            receivers.emplace_back([&store, sid]() {
+                    for (int i = 0; i < 20; i++) {
+                        store.update(std::to_string(sid) + "_PI",
+                                SpiDecoder::CONTENT_SUB_TYPE_PI,
+                                programme_information(sid, {
+                                    programme("News", DAY + 3600 * i, 600)}),
+                                DAY);
+                        store.save();
+                    }
+                });
+        }
+        for (auto& r : receivers) {
+            r.join();
+        }
+        store.save();
+    }
+
+    EpgStore store(dir);
+    REQUIRE(store.load(DAY));
+    REQUIRE(store.getNumProgrammes() == 3);
+    for (uint32_t sid : {0xC221u, 0xD321u, 0xE421u}) {
+        const auto programmes = store.query(window(DAY, 0, sid));
+        REQUIRE(programmes.size() == 1);
+        REQUIRE(programmes[0].start == DAY + 3600 * 19);
+    }
+
+    unlink((dir + "/epg.json").c_str());
+    rmdir(dir.c_str());
+}
+
+// One MOT object in header mode, as data groups of one segment each
+static std::vector<bytes_t> mot_object(int transport_id, const bytes_t& body,
+        const std::string& name, int content_type, int content_sub_type)
+{
+    bytes_t ext = {0x85, 0, 0, 0, 0};   // TriggerTime Now
+    ext.push_back(0xCC);                // ContentName
+    ext.push_back(1 + name.size());
+    ext.push_back(0xF0);
+    ext.insert(ext.end(), name.begin(), name.end());
+
+    BitWriter hw;
+    hw.AddBits(body.size(), 28);
+    hw.AddBits(7 + ext.size(), 13);
+    hw.AddBits(content_type, 6);
+    hw.AddBits(content_sub_type, 9);
+    bytes_t header = hw.GetData();
+    header.insert(header.end(), ext.begin(), ext.end());
+
+    std::vector<bytes_t> dgs;
+    for (const auto& part : {std::make_pair(3, header), std::make_pair(4, body)}) {
+        BitWriter w;
+        w.AddBits(0x70 | part.first, 8);
+        w.AddBits(0, 8);
+        w.AddBits(1, 1);                // last segment
+        w.AddBits(0, 15);
+        w.AddBits(0x12, 8);
+        w.AddBits(transport_id, 16);
+        w.AddBits(0, 3);
+        w.AddBits(part.second.size(), 13);
+        bytes_t dg = w.GetData();
+        dg.insert(dg.end(), part.second.begin(), part.second.end());
+
+        const uint16_t crc = ~CalcCRC::CalcCRC_CRC16_CCITT.Calc(dg.data(), dg.size());
+        dg.push_back(crc >> 8);
+        dg.push_back(crc & 0xFF);
+        dgs.push_back(dg);
+    }
+    return dgs;
+}
+
+TEST_CASE("SPI objects reach the store through the data handler", "[epg]") {
+    EpgStore store;
+    EpgDataHandler handler(store);
+
+    const auto now = std::time(nullptr);
+    const auto pi = programme_information(0xC221,
+            {programme("Now", now - now % 60, 3600)});
+
+    // A slide on the same component is ignored
+    for (auto dg : mot_object(1, bytes_t(100, 0xFF), "slide.jpg",
+                MOT_FILE::CONTENT_TYPE_IMAGE, MOT_FILE::CONTENT_SUB_TYPE_JFIF)) {
+        handler.onDataGroup(100, std::move(dg));
+    }
+    for (auto dg : mot_object(2, pi, "20250301_c221_PI", SpiDecoder::CONTENT_TYPE,
+                SpiDecoder::CONTENT_SUB_TYPE_PI)) {
+        handler.onDataGroup(100, std::move(dg));
+    }
+
+    REQUIRE(store.getNumProgrammes() == 1);
+    REQUIRE(names(store.query(window(now, 0, 0xC221))) ==
+            std::vector<std::string>{"Now"});
+}
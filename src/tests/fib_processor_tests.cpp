@@ -0,0 +1,655 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file fib_processor_tests.cpp
+ * @brief Tests for the ensemble database of the FIB processor and the
+ *        snapshots it publishes
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ *
+ * The benchmark is hidden, run it with: fib_processor_tests "[benchmark]"
+ * It replays the FIBs of the file named by WELLE_FIC_FILE, in the format
+ * of the /fic stream of welle-cli, or a synthetic ensemble otherwise.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/fib-processor.h"
+#include "../backend/tools.h"
+#include "../various/metrics.h"
+#include "test_radio_interface.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+static const size_t FIB_LENGTH = 32;
+static const size_t FIB_DATA_LENGTH = 30;
+
+static void add_label(BitWriter& w, const std::string& label)
+{
+    for (size_t i = 0; i < 16; i++) {
+        w.AddBits(i < label.size() ? (uint8_t)label[i] : ' ', 8);
+    }
+}
+
+// Prepends the FIG header to the data field
+static std::vector<uint8_t> fig(int type, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> f;
+    f.push_back((type << 5) | data.size());
+    f.insert(f.end(), data.begin(), data.end());
+    return f;
+}
+
+static std::vector<uint8_t> fig0_0(uint16_t eid)
+{
+    BitWriter w;
+    w.AddBits(0, 8);    // CN, OE, P/D, extension 0
+    w.AddBits(eid, 16);
+    w.AddBits(0, 16);   // change flags, Al flag, CIF count
+    return fig(0, w.GetData());
+}
+
+// Short form subchannels with UEP table index 8, i.e. 48 kbps
+static std::vector<uint8_t> fig0_1(int first, int count)
+{
+    BitWriter w;
+    w.AddBits(1, 8);
+    for (int i = first; i < first + count; i++) {
+        w.AddBits(i, 6);
+        w.AddBits(i * 35, 10);
+        w.AddBits(0, 2);
+        w.AddBits(8, 6);
+    }
+    return fig(0, w.GetData());
+}
+
+// Programme services with one DAB+ component each
+static std::vector<uint8_t> fig0_2(const std::vector<uint16_t>& sids)
+{
+    BitWriter w;
+    w.AddBits(2, 8);
+    for (uint16_t sid : sids) {
+        w.AddBits(sid, 16);
+        w.AddBits(1, 8);    // one component
+        w.AddBits(0, 2);    // audio
+        w.AddBits(63, 6);   // DAB+
+        w.AddBits(sid % 64, 6);
+        w.AddBits(1, 1);    // primary
+        w.AddBits(0, 1);
+    }
+    return fig(0, w.GetData());
+}
+
+// PTy of a programme service
+static std::vector<uint8_t> fig0_17(uint16_t sid, int pty)
+{
+    BitWriter w;
+    w.AddBits(17, 8);
+    w.AddBits(sid, 16);
+    w.AddBits(0, 8);    // no language, no CC
+    w.AddBits(pty, 8);
+    return fig(0, w.GetData());
+}
+
+static std::vector<uint8_t> fig1_1(uint16_t sid, const std::string& label)
+{
+    BitWriter w;
+    w.AddBits(1, 8);    // EBU Latin, extension 1
+    w.AddBits(sid, 16);
+    add_label(w, label);
+    w.AddBits(0xFF00, 16);
+    return fig(1, w.GetData());
+}
+
+// Packs FIGs into FIBs, unpacked to one bit per byte like the FIC
+// handler gives them to the FIB processor
+class FibWriter {
+    public:
+        void add(const std::vector<uint8_t>& f) {
+            if (current.size() + f.size() > FIB_DATA_LENGTH) {
+                flush();
+            }
+            current.insert(current.end(), f.begin(), f.end());
+        }
+
+        void flush() {
+            if (current.empty()) {
+                return;
+            }
+            current.resize(FIB_DATA_LENGTH, 0xFF);
+            uint16_t crc = ~CalcCRC::CalcCRC_CRC16_CCITT.Calc(current.data(), FIB_DATA_LENGTH);
+            current.push_back(crc >> 8);
+            current.push_back(crc & 0xFF);
+            fibs.push_back(current);
+            current.clear();
+        }
+
+        std::vector<std::vector<uint8_t> > fibs;
+
+    private:
+        std::vector<uint8_t> current;
+};
+
+static std::vector<uint8_t> unpack(const std::vector<uint8_t>& fib)
+{
+    std::vector<uint8_t> bits(fib.size() * 8);
+    for (size_t i = 0; i < bits.size(); i++) {
+        bits[i] = (fib[i / 8] >> (7 - i % 8)) & 1;
+    }
+    return bits;
+}
+
+static void process(FIBProcessor& fib, const std::vector<std::vector<uint8_t> >& fibs)
+{
+    for (const auto& f : fibs) {
+        auto bits = unpack(f);
+        fib.processFIB(bits.data(), 0);
+    }
+}
+
+static std::vector<std::vector<uint8_t> > make_ensemble(
+        uint16_t eid, const std::vector<uint16_t>& sids, const std::string& prefix)
+{
+    FibWriter w;
+    w.add(fig0_0(eid));
+    for (int first = 0; first < 64; first += 8) {
+        w.add(fig0_1(first, 8));
+    }
+    for (size_t i = 0; i < sids.size(); i += 4) {
+        w.add(fig0_2(std::vector<uint16_t>(sids.begin() + i,
+                        sids.begin() + std::min(sids.size(), i + 4))));
+    }
+    for (uint16_t sid : sids) {
+        w.add(fig1_1(sid, prefix + std::to_string(sid)));
+    }
+    w.flush();
+    return w.fibs;
+}
+
+static std::vector<uint16_t> make_sids(size_t num)
+{
+    std::vector<uint16_t> sids;
+    for (size_t i = 0; i < num; i++) {
+        sids.push_back(0xC001 + i);
+    }
+    return sids;
+}
+
+TEST_CASE("Changes become visible when the batch is published", "[fibprocessor]") {
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    const auto empty = fib.getEnsemble();
+    REQUIRE(empty);
+    REQUIRE(empty->services.empty());
+
+    const auto sids = make_sids(10);
+    const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+
+    // Services are only taken after being signalled twice
+    process(fib, fibs);
+    process(fib, fibs);
+    REQUIRE(radio.servicesDetected == 10);
+    REQUIRE(fib.getEnsemble() == empty);
+
+    fib.publishEnsemble();
+    const auto e = fib.getEnsemble();
+    REQUIRE(e->version > empty->version);
+    REQUIRE(e->ensembleId == 0x4FFF);
+    REQUIRE(e->services.size() == 10);
+
+    for (uint16_t sid : sids) {
+        const auto *s = e->findService(sid);
+        REQUIRE(s);
+        REQUIRE(s->serviceId == sid);
+        REQUIRE(s->serviceLabel.fig1_label == "Radio " + std::to_string(sid) + "     ");
+
+        const auto components = e->getComponents(sid);
+        REQUIRE(components.size() == 1);
+        REQUIRE(components.front().audioType() == AudioServiceComponentType::DABPlus);
+
+        const auto& sub = e->getSubchannel(components.front().subchannelId);
+        REQUIRE(sub.subChId == sid % 64);
+        REQUIRE(sub.startAddr == (sid % 64) * 35);
+        REQUIRE(sub.bitrate() == 48);
+    }
+    REQUIRE(e->findService(0xC0FF) == nullptr);
+    REQUIRE(e->getComponents(0xC0FF).empty());
+
+    // The getters of the FIBProcessor use the snapshot
+    REQUIRE(fib.getServiceList().size() == 10);
+    REQUIRE(fib.getService(sids[3]).serviceId == sids[3]);
+    REQUIRE(fib.getService(0xC0FF).serviceId == 0);
+    REQUIRE(fib.getComponents(Service(sids[3])).size() == 1);
+}
+
+TEST_CASE("Repetitions do not publish new snapshots", "[fibprocessor]") {
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    const auto sids = make_sids(4);
+    const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+    process(fib, fibs);
+    process(fib, fibs);
+    fib.publishEnsemble();
+    const auto before = fib.getEnsemble();
+
+    for (int i = 0; i < 5; i++) {
+        process(fib, fibs);
+        fib.publishEnsemble();
+    }
+    REQUIRE(fib.getEnsemble() == before);
+
+    // A new PTy and label change the ensemble, the old snapshot stays as it was
+    FibWriter w;
+    w.add(fig0_17(sids[1], 10));
+    w.add(fig1_1(sids[2], "Renamed"));
+    w.flush();
+    process(fib, w.fibs);
+    fib.publishEnsemble();
+
+    const auto after = fib.getEnsemble();
+    REQUIRE(after->version == before->version + 1);
+    REQUIRE(after->findService(sids[1])->programType == 10);
+    REQUIRE(after->findService(sids[2])->serviceLabel.fig1_label == "Renamed         ");
+    REQUIRE(before->findService(sids[1])->programType == 0);
+    REQUIRE(before->findService(sids[2])->serviceLabel.fig1_label == "Radio 49155     ");
+}
+
+TEST_CASE("Repeated FIGs are not parsed again", "[fibprocessor]") {
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    const auto sids = make_sids(8);
+    const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+
+    // The second FIG 0/2 makes the services appear, it must be parsed.
+    // The FIGs are parsed once more after the changes to the ensemble.
+    process(fib, fibs);
+    process(fib, fibs);
+    REQUIRE(radio.servicesDetected == 8);
+    process(fib, fibs);
+    fib.publishEnsemble();
+    const auto before = fib.getEnsemble();
+    const auto stats_before = fib.getFigCacheStats();
+    REQUIRE(stats_before.count("0/0") == 0);
+
+    process(fib, fibs);
+    process(fib, fibs);
+    auto stats = fib.getFigCacheStats();
+    REQUIRE(stats["1/1"].hits == stats_before.at("1/1").hits + 2 * sids.size());
+    REQUIRE(stats["1/1"].misses == stats_before.at("1/1").misses);
+    REQUIRE(stats["0/2"].hits == stats_before.at("0/2").hits + 2 * sids.size() / 4);
+    REQUIRE(stats["0/2"].misses == stats_before.at("0/2").misses);
+    REQUIRE(stats["0/1"].hits > stats_before.at("0/1").hits);
+
+    fib.publishEnsemble();
+    REQUIRE(fib.getEnsemble() == before);
+
+    // A new label is not a repetition
+    FibWriter w;
+    w.add(fig1_1(sids[2], "Renamed"));
+    w.flush();
+    process(fib, w.fibs);
+    stats = fib.getFigCacheStats();
+    REQUIRE(stats["1/1"].misses == stats_before.at("1/1").misses + 1);
+    fib.publishEnsemble();
+    REQUIRE(fib.getEnsemble()->findService(sids[2])->serviceLabel.fig1_label == "Renamed         ");
+
+    // Back to the old one
+    process(fib, fibs);
+    fib.publishEnsemble();
+    REQUIRE(fib.getEnsemble()->findService(sids[2])->serviceLabel.fig1_label == "Radio 49155     ");
+}
+
+TEST_CASE("FIG cache metrics are counted per channel", "[fibprocessor]") {
+    const auto fibs = make_ensemble(0x4FFF, make_sids(8), "Radio ");
+    const auto label_5a = metrics::label("channel", "5A");
+    const auto label_5b = metrics::label("channel", "5B");
+
+    TestRadioInterface radio_5a;
+    TestRadioInterface radio_5b;
+    FIBProcessor fib_5a(radio_5a, label_5a);
+    FIBProcessor fib_5b(radio_5b, label_5b);
+    for (int i = 0; i < 4; i++) {
+        process(fib_5a, fibs);
+    }
+    process(fib_5b, fibs);
+
+    auto hits = [](const std::string& channel) -> uint64_t {
+        return metrics::registry().counter("welle_fig_cache_total",
+                "FIGs received, by whether they were repeated and not parsed",
+                metrics::join_labels(channel, metrics::label("fig", "1/1") + "," +
+                    metrics::label("result", "hit"))).get();
+    };
+    REQUIRE(hits(label_5a) == fib_5a.getFigCacheStats()["1/1"].hits);
+    REQUIRE(hits(label_5b) == fib_5b.getFigCacheStats()["1/1"].hits);
+    REQUIRE(hits(label_5a) > hits(label_5b));
+}
+
+TEST_CASE("Repeated FIGs keep the services alive", "[fibprocessor]") {
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    const auto sids = make_sids(4);
+    const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+    process(fib, fibs);
+    process(fib, fibs);
+
+    // The counters age once a second, a service that is no longer
+    // signalled disappears after a few seconds.
+    FibWriter w;
+    w.add(fig0_2(std::vector<uint16_t>(sids.begin(), sids.begin() + 2)));
+    w.flush();
+    for (int i = 0; i < 4; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1010));
+        process(fib, w.fibs);
+    }
+    fib.publishEnsemble();
+    const auto e = fib.getEnsemble();
+    REQUIRE(fib.getFigCacheStats()["0/2"].hits >= 2);
+    REQUIRE(e->services.size() == 2);
+    REQUIRE(e->findService(sids[0]));
+    REQUIRE(e->findService(sids[1]));
+    REQUIRE(e->findService(sids[2]) == nullptr);
+}
+
+TEST_CASE("Clearing the ensemble publishes an empty one", "[fibprocessor]") {
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    const auto fibs = make_ensemble(0x4FFF, make_sids(4), "Radio ");
+    process(fib, fibs);
+    process(fib, fibs);
+    fib.publishEnsemble();
+    REQUIRE(fib.getEnsemble()->services.size() == 4);
+
+    fib.clearEnsemble();
+    const auto e = fib.getEnsemble();
+    REQUIRE(e->services.empty());
+    REQUIRE(e->components.empty());
+    REQUIRE(e->subChannels.size() == 64);
+    REQUIRE_FALSE(e->getSubchannel(5).valid());
+    REQUIRE_THROWS_AS(e->getSubchannel(64), std::out_of_range);
+
+    // The same ensemble comes back
+    process(fib, fibs);
+    process(fib, fibs);
+    fib.publishEnsemble();
+    REQUIRE(fib.getEnsemble()->services.size() == 4);
+}
+
+TEST_CASE("A cached ensemble is shown until the FIGs confirm it", "[fibprocessor]") {
+    const auto sids = make_sids(4);
+    const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+    std::shared_ptr<const EnsembleSnapshot> cached;
+    {
+        TestRadioInterface radio;
+        FIBProcessor fib(radio);
+        process(fib, fibs);
+        process(fib, fibs);
+        fib.publishEnsemble();
+        cached = fib.getEnsemble();
+    }
+
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    fib.setProvisionalEnsemble(*cached);
+    REQUIRE(radio.servicesDetected == 4);
+
+    auto e = fib.getEnsemble();
+    REQUIRE(e->provisional);
+    REQUIRE(e->ensembleId == 0x4FFF);
+    REQUIRE(e->services.size() == 4);
+    REQUIRE(e->getComponents(sids[2]).size() == 1);
+    REQUIRE(e->getSubchannel(sids[2] % 64).bitrate() == 48);
+
+    // One repetition confirms all services, nothing has to be restarted
+    process(fib, fibs);
+    fib.publishEnsemble();
+    e = fib.getEnsemble();
+    REQUIRE_FALSE(e->provisional);
+    REQUIRE(e->services.size() == 4);
+    REQUIRE(e->findService(sids[1])->serviceLabel.fig1_label == "Radio 49154     ");
+    REQUIRE(radio.servicesDetected == 4);
+    REQUIRE(radio.restarts == 0);
+}
+
+TEST_CASE("A cached ensemble that differs from the FIGs is corrected", "[fibprocessor]") {
+    const auto sids = make_sids(4);
+    const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+    EnsembleSnapshot cached;
+    {
+        TestRadioInterface radio;
+        FIBProcessor fib(radio);
+        process(fib, fibs);
+        process(fib, fibs);
+        fib.publishEnsemble();
+        cached = *fib.getEnsemble();
+    }
+
+    SECTION("Subchannel moved") {
+        cached.subChannels[sids[1] % 64].startAddr = 500;
+
+        TestRadioInterface radio;
+        FIBProcessor fib(radio);
+        fib.setProvisionalEnsemble(cached);
+        process(fib, fibs);
+        fib.publishEnsemble();
+
+        const auto e = fib.getEnsemble();
+        REQUIRE(e->getSubchannel(sids[1] % 64).startAddr == (sids[1] % 64) * 35);
+        REQUIRE(e->services.size() == 4);
+        REQUIRE(radio.restarts == 1);
+    }
+
+    SECTION("Other ensemble on the channel") {
+        TestRadioInterface radio;
+        FIBProcessor fib(radio);
+        fib.setProvisionalEnsemble(cached);
+
+        const auto other_sids = make_sids(6);
+        const auto other = make_ensemble(0x4FFE, other_sids, "Other ");
+        process(fib, other);
+        fib.publishEnsemble();
+        auto e = fib.getEnsemble();
+        REQUIRE(e->ensembleId == 0x4FFE);
+        REQUIRE_FALSE(e->provisional);
+        REQUIRE(e->services.empty());
+        REQUIRE(radio.restarts == 1);
+
+        process(fib, other);
+        fib.publishEnsemble();
+        e = fib.getEnsemble();
+        REQUIRE(e->services.size() == 6);
+        REQUIRE(e->findService(sids[0])->serviceLabel.fig1_label == "Other 49153     ");
+    }
+}
+
+TEST_CASE("Cached services that are not on the air disappear", "[fibprocessor]") {
+    const auto sids = make_sids(4);
+    std::shared_ptr<const EnsembleSnapshot> cached;
+    {
+        TestRadioInterface radio;
+        FIBProcessor fib(radio);
+        const auto fibs = make_ensemble(0x4FFF, sids, "Radio ");
+        process(fib, fibs);
+        process(fib, fibs);
+        fib.publishEnsemble();
+        cached = fib.getEnsemble();
+    }
+
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    fib.setProvisionalEnsemble(*cached);
+
+    FibWriter w;
+    w.add(fig0_2(std::vector<uint16_t>(sids.begin(), sids.begin() + 2)));
+    w.flush();
+    for (int i = 0; i < 4; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1010));
+        process(fib, w.fibs);
+    }
+    fib.publishEnsemble();
+    const auto e = fib.getEnsemble();
+    REQUIRE_FALSE(e->provisional);
+    REQUIRE(e->services.size() == 2);
+    REQUIRE(e->findService(sids[3]) == nullptr);
+}
+
+TEST_CASE("Readers get consistent snapshots during the FIG processing", "[fibprocessor]") {
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+    const auto sids = make_sids(32);
+    const auto fibs_a = make_ensemble(0x4FFF, sids, "A ");
+    const auto fibs_b = make_ensemble(0x4FFF, sids, "B ");
+
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+            for (int i = 0; i < 200; i++) {
+                process(fib, i % 2 ? fibs_b : fibs_a);
+                fib.publishEnsemble();
+            }
+            done = true;
+        });
+
+    uint64_t version = 0;
+    size_t checked = 0;
+    while (not done) {
+        const auto e = fib.getEnsemble();
+        REQUIRE(e->version >= version);
+        version = e->version;
+
+        // All labels come from the same batch
+        char prefix = 0;
+        for (const auto& s : e->services) {
+            REQUIRE(e->findService(s.serviceId) == &s);
+            const char p = s.serviceLabel.fig1_label[0];
+            REQUIRE((prefix == 0 or p == prefix));
+            prefix = p;
+        }
+        checked++;
+    }
+    writer.join();
+
+    REQUIRE(checked > 0);
+    REQUIRE(fib.getEnsemble()->services.size() == 32);
+}
+
+// The FIBs of a capture of the /fic stream, or of a large synthetic
+// ensemble repeated like the FIG carousel of a multiplexer
+static std::vector<std::vector<uint8_t> > benchmark_fibs()
+{
+    std::vector<std::vector<uint8_t> > fibs;
+    const char *filename = std::getenv("WELLE_FIC_FILE");
+    if (filename) {
+        std::ifstream in(filename, std::ios::binary);
+        std::vector<uint8_t> f(FIB_LENGTH);
+        while (in.read(reinterpret_cast<char*>(f.data()), f.size())) {
+            // Skip the gap markers and damaged FIBs
+            const uint16_t crc = ~CalcCRC::CalcCRC_CRC16_CCITT.Calc(f.data(), FIB_DATA_LENGTH);
+            if (f[30] == (crc >> 8) and f[31] == (crc & 0xFF)) {
+                fibs.push_back(f);
+            }
+        }
+        std::cout << "Replaying " << fibs.size() << " FIBs from " << filename << std::endl;
+        return fibs;
+    }
+
+    const auto sids = make_sids(1000);
+    const auto e = make_ensemble(0x4FFF, sids, "Radio ");
+    for (int rep = 0; rep < 20; rep++) {
+        fibs.insert(fibs.end(), e.begin(), e.end());
+    }
+    std::cout << "Replaying " << fibs.size() << " synthetic FIBs, 1000 services" << std::endl;
+    return fibs;
+}
+
+TEST_CASE("FIB processing and snapshot reads", "[.][benchmark]") {
+    using namespace std::chrono;
+
+    const auto fibs = benchmark_fibs();
+    REQUIRE_FALSE(fibs.empty());
+    std::vector<std::vector<uint8_t> > bits;
+    for (const auto& f : fibs) {
+        bits.push_back(unpack(f));
+    }
+
+    TestRadioInterface radio;
+    FIBProcessor fib(radio);
+
+    // Like the FIC handler: three FIBs per batch. The first half of the
+    // stream includes the acquisition of the ensemble, the second half
+    // shows the steady state of an ensemble that is known.
+    const size_t half = bits.size() / 2;
+    auto replay = [&](size_t from, size_t to) {
+        const auto start = steady_clock::now();
+        for (size_t i = from; i < to; i++) {
+            fib.processFIB(bits[i].data(), 0);
+            if (i % 3 == 2) {
+                fib.publishEnsemble();
+            }
+        }
+        fib.publishEnsemble();
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+        return seconds * 1e9 / (to - from);
+    };
+    const double acquisition = replay(0, half);
+    const uint64_t snapshots = fib.getEnsemble()->version;
+    auto fig_stats = fib.getFigCacheStats();
+    const double steady = replay(half, bits.size());
+
+    const auto e = fib.getEnsemble();
+    std::cout << "FIBProcessor: " << acquisition << " ns per FIB during acquisition, " <<
+        steady << " ns per FIB later, " << e->version << " snapshots (" <<
+        e->version - snapshots << " later), " << e->services.size() << " services" << std::endl;
+
+    // What a web client asking for the mux.json does
+    const int reads = 1000;
+    const auto read_start = steady_clock::now();
+    size_t found = 0;
+    for (int r = 0; r < reads; r++) {
+        const auto snapshot = fib.getEnsemble();
+        for (const auto& s : snapshot->services) {
+            for (const auto& sc : snapshot->getComponents(s.serviceId)) {
+                found += snapshot->getSubchannel(sc.subchannelId).valid();
+            }
+        }
+    }
+    const double read_seconds = duration<double>(steady_clock::now() - read_start).count();
+    std::cout << "FIBProcessor: " << read_seconds * 1e6 / reads <<
+        " us to walk all services of a snapshot" << std::endl;
+    REQUIRE(found > 0);
+
+    for (const auto& stats : fib.getFigCacheStats()) {
+        const auto& before = fig_stats[stats.first];
+        std::cout << "FIG " << stats.first << ": " << stats.second.hits <<
+            " repetitions skipped, " << stats.second.misses << " parsed (" <<
+            stats.second.hits - before.hits << " and " <<
+            stats.second.misses - before.misses << " later)" << std::endl;
+    }
+}
@@ -0,0 +1,191 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file fic_ring_tests.cpp
+ * @brief Tests for the FIB ring that feeds the /fic clients of welle-cli
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../welle-cli/ficring.h"
+#include "../backend/dab-constants.h"
+#include "../backend/tools.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// Build the unpacked bit representation of a FIB whose bytes are all
+// equal to value, like the FIC handler gives it to onFIBDecodeSuccess.
+static std::vector<uint8_t> make_fib_bits(uint8_t value)
+{
+    std::vector<uint8_t> bits(FicRing::FIB_LENGTH * 8);
+    for (size_t i = 0; i < bits.size(); i++) {
+        bits[i] = (value >> (7 - (i % 8))) & 1;
+    }
+    return bits;
+}
+
+static void write_cif(FicRing& ring, uint8_t first_value)
+{
+    for (uint8_t i = 0; i < 3; i++) {
+        const auto bits = make_fib_bits(first_value + i);
+        ring.stage(bits.data());
+    }
+    ring.commit();
+}
+
+TEST_CASE("FIB bits are packed MSB first", "[ficring]") {
+    FicRing ring;
+    const auto bits = make_fib_bits(0xA5);
+    ring.stage(bits.data());
+    ring.commit();
+
+    std::vector<uint8_t> out(FicRing::FIB_LENGTH);
+    uint64_t cursor = ring.oldest();
+    uint64_t lost = 0;
+    REQUIRE(ring.read(cursor, out.data(), 1, lost, milliseconds(0)) == 1);
+    REQUIRE(lost == 0);
+    REQUIRE(cursor == 1);
+    for (auto b : out) {
+        REQUIRE(b == 0xA5);
+    }
+}
+
+TEST_CASE("Staged FIBs are invisible until commit", "[ficring]") {
+    FicRing ring;
+    const auto bits = make_fib_bits(1);
+    ring.stage(bits.data());
+    ring.stage(bits.data());
+    REQUIRE(ring.head() == 0);
+
+    ring.commit();
+    REQUIRE(ring.head() == 2);
+
+    ring.stage(bits.data());
+    ring.discardStaged();
+    ring.commit();
+    REQUIRE(ring.head() == 2);
+}
+
+TEST_CASE("The FIBs of a CIF are committed together in every mode", "[ficring]") {
+    for (int mode = 1; mode <= 4; mode++) {
+        const DABParams p(mode);
+        REQUIRE(p.fibsPerCIF == (mode == 3 ? 4 : 3));
+
+        FicRing ring;
+        const auto bits = make_fib_bits(1);
+        for (int i = 0; i < p.fibsPerCIF; i++) {
+            ring.stage(bits.data());
+        }
+        // Nothing committed early
+        REQUIRE(ring.head() == 0);
+        ring.commit();
+        REQUIRE(ring.head() == (uint64_t)p.fibsPerCIF);
+    }
+}
+
+TEST_CASE("Every reader sees every FIB", "[ficring]") {
+    FicRing ring;
+    uint64_t cursor_a = ring.oldest();
+    uint64_t cursor_b = ring.oldest();
+
+    for (int cif = 0; cif < 4; cif++) {
+        write_cif(ring, 3 * cif);
+    }
+
+    std::vector<uint8_t> out_a(12 * FicRing::FIB_LENGTH);
+    std::vector<uint8_t> out_b(12 * FicRing::FIB_LENGTH);
+    uint64_t lost = 0;
+
+    REQUIRE(ring.read(cursor_a, out_a.data(), 12, lost, milliseconds(0)) == 12);
+    REQUIRE(lost == 0);
+    REQUIRE(ring.read(cursor_b, out_b.data(), 12, lost, milliseconds(0)) == 12);
+    REQUIRE(lost == 0);
+    REQUIRE(out_a == out_b);
+
+    for (size_t fib = 0; fib < 12; fib++) {
+        REQUIRE(out_a[fib * FicRing::FIB_LENGTH] == fib);
+    }
+
+    // Nothing new: the read times out empty-handed
+    REQUIRE(ring.read(cursor_a, out_a.data(), 12, lost, milliseconds(1)) == 0);
+}
+
+TEST_CASE("Lagging reader is told how many FIBs it lost", "[ficring]") {
+    FicRing ring;
+    uint64_t cursor = ring.oldest();
+
+    const size_t num_cifs = FicRing::CAPACITY / 3 + 10;
+    for (size_t cif = 0; cif < num_cifs; cif++) {
+        write_cif(ring, 0);
+    }
+
+    const uint64_t written = num_cifs * 3;
+    REQUIRE(ring.head() == written);
+    REQUIRE(ring.oldest() == written - FicRing::CAPACITY);
+
+    std::vector<uint8_t> out(FicRing::CAPACITY * FicRing::FIB_LENGTH);
+    uint64_t lost = 0;
+    const size_t n = ring.read(cursor, out.data(), FicRing::CAPACITY,
+            lost, milliseconds(0));
+    REQUIRE(lost == written - FicRing::CAPACITY);
+    REQUIRE(n == FicRing::CAPACITY);
+    REQUIRE(cursor == written);
+}
+
+TEST_CASE("Reader wakes up on commit", "[ficring]") {
+    FicRing ring;
+    uint64_t cursor = ring.head();
+
+    std::thread producer([&]() {
+            std::this_thread::sleep_for(milliseconds(20));
+            write_cif(ring, 7);
+        });
+
+    std::vector<uint8_t> out(3 * FicRing::FIB_LENGTH);
+    uint64_t lost = 0;
+    const size_t n = ring.read(cursor, out.data(), 3, lost, seconds(5));
+    producer.join();
+
+    REQUIRE(n == 3);
+    REQUIRE(out[0] == 7);
+    REQUIRE(out[2 * FicRing::FIB_LENGTH] == 9);
+}
+
+TEST_CASE("Gap marker has an invalid CRC", "[ficring]") {
+    const auto& marker = FicRing::gapMarker();
+    REQUIRE(marker[0] == 0xFF);
+
+    const size_t data_len = FicRing::FIB_LENGTH - CalcCRC::CRCLen;
+    const uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(marker.data(), data_len);
+    const uint16_t marker_crc = (marker[data_len] << 8) | marker[data_len + 1];
+    REQUIRE(crc != marker_crc);
+}
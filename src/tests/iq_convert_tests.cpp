@@ -0,0 +1,229 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file iq_convert_tests.cpp
+ * @brief Tests that every IQ conversion kernel gives exactly the result of
+ *        the scalar conversions the inputs used before
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../input/iq_convert.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using iqconvert::Kernels;
+
+// The conversions as the inputs did them before the kernels existed
+static DSPCOMPLEX reference_u8(const uint8_t *iq)
+{
+    return DSPCOMPLEX(float(iq[0] - 128) / 128.0, float(iq[1] - 128) / 128.0);
+}
+
+static DSPCOMPLEX reference_s8(const uint8_t *iq)
+{
+    return DSPCOMPLEX(float((int8_t)iq[0]) / 128.0, float((int8_t)iq[1]) / 128.0);
+}
+
+static DSPCOMPLEX reference_s16le(const uint8_t *iq, double divisor)
+{
+    const int16_t i = (int16_t)((iq[1] << 8) | iq[0]);
+    const int16_t q = (int16_t)((iq[3] << 8) | iq[2]);
+    return DSPCOMPLEX(i / divisor, q / divisor);
+}
+
+static DSPCOMPLEX reference_s16be(const uint8_t *iq, double divisor)
+{
+    const int16_t i = (int16_t)((iq[0] << 8) | iq[1]);
+    const int16_t q = (int16_t)((iq[2] << 8) | iq[3]);
+    return DSPCOMPLEX(i / divisor, q / divisor);
+}
+
+static std::vector<uint8_t> random_bytes(size_t n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> v(n);
+    for (auto& b : v) {
+        b = dist(gen);
+    }
+    return v;
+}
+
+static bool bit_identical(const std::vector<DSPCOMPLEX>& a, const std::vector<DSPCOMPLEX>& b)
+{
+    return a.size() == b.size() and
+        memcmp(a.data(), b.data(), a.size() * sizeof(DSPCOMPLEX)) == 0;
+}
+
+// Convert with every kernel, at every misalignment of the input and with
+// lengths that exercise the scalar tails.
+template<typename Convert, typename Reference>
+static void check_all_kernels(size_t bytes_per_sample, Convert convert, Reference reference)
+{
+    const auto input = random_bytes(bytes_per_sample * 1000 + 16, 42);
+
+    for (const Kernels *k : iqconvert::availableKernels()) {
+        INFO("kernel " << k->name);
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t num : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 1000}) {
+                const uint8_t *in = input.data() + offset;
+
+                std::vector<DSPCOMPLEX> expected(num);
+                for (size_t i = 0; i < num; i++) {
+                    expected[i] = reference(in + bytes_per_sample * i);
+                }
+
+                std::vector<DSPCOMPLEX> out(num);
+                convert(*k, in, out.data(), num);
+                REQUIRE(bit_identical(out, expected));
+            }
+        }
+    }
+}
+
+TEST_CASE("U8 conversion is bit-exact", "[iqconvert]") {
+    check_all_kernels(2,
+            [](const Kernels& k, const uint8_t *in, DSPCOMPLEX *out, size_t n) {
+                k.u8(in, out, n); },
+            reference_u8);
+
+    // Every possible byte value, in both I and Q
+    std::vector<uint8_t> all(512);
+    for (size_t i = 0; i < all.size(); i++) {
+        all[i] = i / 2;
+    }
+    std::vector<DSPCOMPLEX> expected(256), out(256);
+    for (size_t i = 0; i < 256; i++) {
+        expected[i] = reference_u8(&all[2 * i]);
+    }
+    iqconvert::u8(all.data(), out.data(), 256);
+    REQUIRE(bit_identical(out, expected));
+    REQUIRE(out[0] == DSPCOMPLEX(-1.0f, -1.0f));
+    REQUIRE(out[128] == DSPCOMPLEX(0.0f, 0.0f));
+}
+
+TEST_CASE("S8 conversion is bit-exact", "[iqconvert]") {
+    check_all_kernels(2,
+            [](const Kernels& k, const uint8_t *in, DSPCOMPLEX *out, size_t n) {
+                k.s8(in, out, n); },
+            reference_s8);
+}
+
+TEST_CASE("S16 conversion is bit-exact", "[iqconvert]") {
+    // Unscaled like the raw file input, and scaled like the LimeSDR
+    for (double divisor : {1.0, 2048.0}) {
+        const float scale = 1.0f / divisor;
+        INFO("divisor " << divisor);
+
+        check_all_kernels(4,
+                [&](const Kernels& k, const uint8_t *in, DSPCOMPLEX *out, size_t n) {
+                    k.s16le(in, out, n, scale); },
+                [&](const uint8_t *iq) { return reference_s16le(iq, divisor); });
+
+        check_all_kernels(4,
+                [&](const Kernels& k, const uint8_t *in, DSPCOMPLEX *out, size_t n) {
+                    k.s16be(in, out, n, scale); },
+                [&](const uint8_t *iq) { return reference_s16be(iq, divisor); });
+    }
+}
+
+TEST_CASE("S16 in host byte order", "[iqconvert]") {
+    const std::vector<int16_t> in = { 0, -1, 32767, -32768, 1234, -4321, 2048, -2048 };
+    std::vector<DSPCOMPLEX> out(in.size() / 2);
+    iqconvert::s16(in.data(), out.data(), out.size(), 1.0f / 2048.0f);
+
+    for (size_t i = 0; i < out.size(); i++) {
+        REQUIRE(out[i].real() == in[2 * i] / 2048.0f);
+        REQUIRE(out[i].imag() == in[2 * i + 1] / 2048.0f);
+    }
+}
+
+TEST_CASE("Decimation by two is bit-exact", "[iqconvert]") {
+    std::mt19937 gen(7);
+    std::normal_distribution<float> dist(0.0f, 0.1f);
+
+    std::vector<DSPCOMPLEX> in(2 * 1003);
+    for (auto& z : in) {
+        z = DSPCOMPLEX(dist(gen), dist(gen));
+    }
+
+    for (const Kernels *k : iqconvert::availableKernels()) {
+        INFO("kernel " << k->name);
+        for (size_t num : {0, 1, 3, 4, 5, 8, 1003}) {
+            std::vector<DSPCOMPLEX> expected(num);
+            float expected_maxnorm = 0.0f;
+            for (size_t i = 0; i < num; i++) {
+                expected[i] = 0.5f * (in[2 * i] + in[2 * i + 1]);
+                expected_maxnorm = std::max(expected_maxnorm, std::norm(expected[i]));
+            }
+
+            std::vector<DSPCOMPLEX> out(num);
+            float maxnorm = 0.0f;
+            k->decimate2(in.data(), out.data(), num, &maxnorm);
+            REQUIRE(bit_identical(out, expected));
+            REQUIRE(maxnorm == Approx(expected_maxnorm));
+
+            // The maximum is only ever raised
+            maxnorm = 1e6f;
+            k->decimate2(in.data(), out.data(), num, &maxnorm);
+            REQUIRE(maxnorm == 1e6f);
+            k->decimate2(in.data(), out.data(), num, nullptr);
+        }
+    }
+}
+
+TEST_CASE("Conversion speed per kernel", "[iqconvert][performance]") {
+    // One second of RTL-SDR samples at 2.048 MS/s
+    constexpr size_t num = 2048000;
+    const auto input = random_bytes(2 * num, 1);
+    std::vector<DSPCOMPLEX> out(num);
+
+    // The loop that the RTL-SDR and rtl_tcp inputs used before
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num; i++) {
+        out[i] = DSPCOMPLEX((float(input[2 * i] - 128)) / 128.0,
+                            (float(input[2 * i + 1] - 128)) / 128.0);
+    }
+    std::chrono::duration<double> scalar = std::chrono::steady_clock::now() - start;
+    std::cout << "U8 scalar division: " << num / scalar.count() / 1e6 << " MS/s" << std::endl;
+
+    for (const Kernels *k : iqconvert::availableKernels()) {
+        start = std::chrono::steady_clock::now();
+        k->u8(input.data(), out.data(), num);
+        std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+        std::cout << "U8 " << k->name << ": " << num / t.count() / 1e6 << " MS/s" << std::endl;
+        REQUIRE(t.count() > 0);
+    }
+
+    std::cout << "Selected kernels: " << iqconvert::kernels().name << std::endl;
+}
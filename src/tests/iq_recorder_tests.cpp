@@ -0,0 +1,470 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file iq_recorder_tests.cpp
+ * @brief Tests for the streaming IQ recorder
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "various/iq_recorder.h"
+#include "various/sigmf.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+static int test_counter = 0;
+
+// A fresh prefix for every recording, in the temporary directory
+static IQRecorder::Config make_config(IQRecorder::Format format)
+{
+    IQRecorder::Config config;
+    config.directory = "/tmp";
+    config.prefix = "iq_recorder_test_" + std::to_string(getpid()) + "_" +
+        std::to_string(test_counter++);
+    config.format = format;
+    return config;
+}
+
+static std::vector<uint8_t> read_file(const std::string& path)
+{
+    std::ifstream f(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(f),
+            std::istreambuf_iterator<char>());
+}
+
+static void remove_all(const std::vector<std::string>& files)
+{
+    for (const auto& f : files) {
+        std::remove(f.c_str());
+        std::remove(sigmf::metaPath(f).c_str());
+    }
+}
+
+static std::vector<uint8_t> make_u8(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++) {
+        data[i] = (i * 7 + i / 3) & 0xFF;
+    }
+    return data;
+}
+
+TEST_CASE("Raw recording is the pushed bytes", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::U8);
+    config.blockBytes = 4096;
+
+    const auto data = make_u8(100000);
+    std::vector<std::string> files;
+    {
+        IQRecorder recorder(config);
+        // Odd chunk sizes spanning several blocks
+        for (size_t pos = 0; pos < data.size(); pos += 3000) {
+            recorder.push(data.data() + pos, std::min<size_t>(3000, data.size() - pos));
+        }
+        recorder.stop();
+
+        const auto stats = recorder.getStats();
+        REQUIRE(stats.bytesIn == data.size());
+        REQUIRE(stats.bytesRecorded == data.size());
+        REQUIRE(stats.bytesWritten == data.size());
+        REQUIRE(stats.blocksDropped == 0);
+        files = recorder.segmentFiles();
+    }
+
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].find(".sigmf-data") != std::string::npos);
+    REQUIRE(read_file(files[0]) == data);
+    remove_all(files);
+}
+
+TEST_CASE("BFP8 packing round-trips 16-bit samples", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::S16LE);
+    config.packing = IQRecorder::Packing::BFP8;
+
+    // A signal whose amplitude changes a lot from block to block
+    const size_t num = 20000;
+    std::vector<int16_t> samples(2 * num);
+    for (size_t i = 0; i < samples.size(); i++) {
+        const float ampl = (i / 256) % 2 ? 20000.0f : 100.0f;
+        samples[i] = (int16_t)lrintf(ampl * sinf(0.01f * i));
+    }
+    std::vector<uint8_t> bytes(samples.size() * 2);
+    for (size_t i = 0; i < samples.size(); i++) {
+        bytes[2*i] = samples[i] & 0xFF;
+        bytes[2*i+1] = (samples[i] >> 8) & 0xFF;
+    }
+
+    std::vector<std::string> files;
+    IQRecorder::Stats stats;
+    {
+        IQRecorder recorder(config);
+        recorder.push(bytes.data(), bytes.size());
+        recorder.stop();
+        stats = recorder.getStats();
+        files = recorder.segmentFiles();
+    }
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].find(".wiq") != std::string::npos);
+    REQUIRE(stats.compressionRatio > 1.9);
+
+    std::vector<uint8_t> decoded;
+    IQRecorder::Format format;
+    REQUIRE(IQRecorder::readSegment(files[0], decoded, format));
+    REQUIRE(format == IQRecorder::Format::S16LE);
+    REQUIRE(decoded.size() == bytes.size());
+
+    // The error is at most half a step of the block exponent
+    for (size_t i = 0; i < samples.size(); i++) {
+        const int16_t v = (int16_t)(decoded[2*i] | (decoded[2*i+1] << 8));
+        const float step = (i / 256) % 2 ? 256.0f : 1.0f;
+        REQUIRE(std::fabs(v - samples[i]) <= step / 2);
+    }
+    remove_all(files);
+}
+
+TEST_CASE("BFP8 packing round-trips float samples", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::CF32);
+    config.packing = IQRecorder::Packing::BFP8;
+
+    std::vector<float> samples(2 * 5000);
+    for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = 0.3f * cosf(0.05f * i);
+    }
+
+    std::vector<std::string> files;
+    {
+        IQRecorder recorder(config);
+        recorder.push(reinterpret_cast<const uint8_t*>(samples.data()),
+                samples.size() * sizeof(float));
+        recorder.stop();
+        files = recorder.segmentFiles();
+    }
+
+    std::vector<uint8_t> decoded;
+    IQRecorder::Format format;
+    REQUIRE(IQRecorder::readSegment(files[0], decoded, format));
+    REQUIRE(format == IQRecorder::Format::CF32);
+    REQUIRE(decoded.size() == samples.size() * sizeof(float));
+
+    const float *out = reinterpret_cast<const float*>(decoded.data());
+    for (size_t i = 0; i < samples.size(); i++) {
+        // Mantissas of 7 bits below a peak of at most 0.3
+        REQUIRE(std::fabs(out[i] - samples[i]) <= 0.5f / 256);
+    }
+    remove_all(files);
+}
+
+TEST_CASE("Pre-trigger recording keeps the last segments", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::U8);
+    config.mode = IQRecorder::Mode::PreTrigger;
+    config.blockBytes = 1024;
+    config.segmentBytes = 4096;
+    config.maxSegments = 3;
+
+    const auto data = make_u8(10 * 4096);
+    std::vector<std::string> files;
+    {
+        IQRecorder recorder(config);
+        // Give the writer time to keep up, so that nothing is dropped
+        for (size_t pos = 0; pos < data.size(); pos += 1024) {
+            recorder.push(data.data() + pos, 1024);
+            if (pos % (16 * 1024) == 0) {
+                usleep(10000);
+            }
+        }
+        recorder.trigger();
+        REQUIRE(recorder.getStats().blocksDropped == 0);
+        files = recorder.segmentFiles();
+    }
+
+    REQUIRE(files.size() == 3);
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto content = read_file(files[i]);
+        const size_t offset = (7 + i) * 4096;
+        REQUIRE(content == std::vector<uint8_t>(data.begin() + offset,
+                    data.begin() + offset + 4096));
+    }
+
+    // The older segments were deleted
+    const std::string first = config.directory + "/" + config.prefix;
+    REQUIRE(files[0].compare(0, first.size(), first) == 0);
+    REQUIRE(files[0].substr(files[0].size() - 16) == "-0007.sigmf-data");
+    remove_all(files);
+}
+
+TEST_CASE("Pre-trigger recording without a trigger leaves no files", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::U8);
+    config.mode = IQRecorder::Mode::PreTrigger;
+    config.blockBytes = 1024;
+    config.segmentBytes = 4096;
+    config.maxSegments = 2;
+
+    const auto data = make_u8(3 * 4096);
+    std::vector<std::string> files;
+    {
+        IQRecorder recorder(config);
+        recorder.push(data.data(), data.size());
+        // Wait for the writer to create the segments
+        for (int i = 0; i < 200 and recorder.getStats().bytesRecorded < data.size(); i++) {
+            usleep(5000);
+        }
+        files = recorder.segmentFiles();
+        const auto meta = recorder.metaFiles();
+        files.insert(files.end(), meta.begin(), meta.end());
+        REQUIRE(files.size() == 4);
+
+        SECTION("stop") {
+            recorder.stop();
+            REQUIRE(recorder.segmentFiles().empty());
+        }
+        SECTION("destructor") {
+        }
+    }
+
+    for (const auto& f : files) {
+        REQUIRE(std::ifstream(f).good() == false);
+    }
+}
+
+TEST_CASE("Full queue drops blocks instead of blocking", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::U8);
+    // The writer cannot open a file here, and only two blocks are queued
+    config.directory = "/nonexistent-directory";
+    config.blockBytes = 128;
+    config.numBlocks = 2;
+
+    const auto data = make_u8(128 * 100);
+    IQRecorder recorder(config);
+    recorder.push(data.data(), data.size());
+    recorder.stop();
+
+    const auto stats = recorder.getStats();
+    REQUIRE(stats.bytesIn == data.size());
+    REQUIRE(stats.bytesRecorded == 0);
+    REQUIRE(stats.blocksWritten == 0);
+    REQUIRE(stats.blocksDropped == 100);
+
+    // Pushing after the end is ignored
+    recorder.push(data.data(), data.size());
+    REQUIRE(recorder.getStats().bytesIn == data.size());
+}
+
+TEST_CASE("Compression is only used when available", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::S16LE);
+    config.compress = true;
+
+    // Highly compressible: silence
+    std::vector<uint8_t> data(65536 * 4, 0);
+    std::vector<std::string> files;
+    IQRecorder::Stats stats;
+    {
+        IQRecorder recorder(config);
+        recorder.push(data.data(), data.size());
+        recorder.stop();
+        stats = recorder.getStats();
+        files = recorder.segmentFiles();
+    }
+    REQUIRE(files.size() == 1);
+
+    if (IQRecorder::isCompressionAvailable()) {
+        REQUIRE(files[0].find(".wiq") != std::string::npos);
+        REQUIRE(stats.compressionRatio > 10);
+
+        std::vector<uint8_t> decoded;
+        IQRecorder::Format format;
+        REQUIRE(IQRecorder::readSegment(files[0], decoded, format));
+        REQUIRE(decoded == data);
+    }
+    else {
+        REQUIRE(files[0].find(".sigmf-data") != std::string::npos);
+        REQUIRE(read_file(files[0]) == data);
+    }
+    remove_all(files);
+}
+
+TEST_CASE("Without SigMF raw segments are named after their format", "[iqrecorder]") {
+    auto config = make_config(IQRecorder::Format::CF32);
+    config.sigmf = false;
+
+    const auto data = make_u8(8 * 1000);
+    IQRecorder recorder(config);
+    recorder.push(data.data(), data.size());
+    recorder.stop();
+
+    const auto files = recorder.segmentFiles();
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].find(".cf32.iq") != std::string::npos);
+    REQUIRE(recorder.metaFiles().empty());
+    REQUIRE(read_file(files[0]) == data);
+    remove_all(files);
+}
+
+TEST_CASE("SigMF metadata round-trips", "[iqrecorder][sigmf]") {
+    sigmf::Metadata meta;
+    meta.datatype = "ci16_le";
+    meta.sampleRate = 2048000;
+    meta.hardware = "test";
+    sigmf::Capture capture;
+    capture.sampleStart = 10;
+    capture.frequency = 227360000;
+    capture.datetime = sigmf::datetime(std::chrono::system_clock::time_point());
+    meta.captures.push_back(capture);
+    sigmf::Annotation annotation;
+    annotation.sampleStart = 100;
+    annotation.sampleCount = 50;
+    annotation.label = sigmf::SYNC_LOSS_LABEL;
+    meta.annotations.push_back(annotation);
+    annotation.sampleStart = 120;
+    annotation.sampleCount = 100;
+    meta.annotations.push_back(annotation);
+
+    REQUIRE(capture.datetime == "1970-01-01T00:00:00.000Z");
+
+    sigmf::Metadata parsed;
+    REQUIRE(sigmf::fromJson(sigmf::toJson(meta), parsed));
+    REQUIRE(parsed.datatype == "ci16_le");
+    REQUIRE(parsed.sampleRate == 2048000);
+    REQUIRE(parsed.hardware == "test");
+    REQUIRE(parsed.captures.size() == 1);
+    REQUIRE(parsed.captures[0].sampleStart == 10);
+    REQUIRE(parsed.captures[0].frequency == 227360000);
+    REQUIRE(parsed.captures[0].datetime == capture.datetime);
+    REQUIRE(parsed.annotations.size() == 2);
+
+    // Overlapping annotations count once
+    REQUIRE(sigmf::annotatedSamples(parsed, sigmf::SYNC_LOSS_LABEL) == 120);
+    REQUIRE(sigmf::annotatedSamples(parsed, "other") == 0);
+
+    REQUIRE_FALSE(sigmf::fromJson("not json", parsed));
+    REQUIRE_FALSE(sigmf::fromJson("{\"global\": {}}", parsed));
+
+    REQUIRE(sigmf::metaPath("/a/b.sigmf-data") == "/a/b.sigmf-meta");
+    REQUIRE(sigmf::metaPath("/a/b.u8.iq") == "/a/b.sigmf-meta");
+    REQUIRE(sigmf::metaPath("/a/b.wiq") == "/a/b.sigmf-meta");
+}
+
+TEST_CASE("Segments carry captures and annotations", "[iqrecorder][sigmf]") {
+    auto config = make_config(IQRecorder::Format::U8);
+    config.blockBytes = 1024;
+    config.segmentBytes = 4096;
+    config.frequency = 227360000;
+
+    // 2048 samples per segment
+    const auto data = make_u8(3 * 4096);
+    std::vector<std::string> files;
+    std::vector<std::string> metas;
+    {
+        IQRecorder recorder(config);
+        recorder.push(data.data(), 4096 + 1024);
+        REQUIRE(recorder.position() == 2560);
+        recorder.addCapture(recorder.position(), 178352000);
+        recorder.push(data.data() + 4096 + 1024, data.size() - 4096 - 1024);
+
+        // Sync lost from the middle of the first to the middle of the third
+        recorder.annotate(1000, 4000, sigmf::SYNC_LOSS_LABEL);
+        recorder.stop();
+        files = recorder.segmentFiles();
+        metas = recorder.metaFiles();
+    }
+    REQUIRE(files.size() == 3);
+    REQUIRE(metas.size() == 3);
+
+    std::vector<sigmf::Metadata> meta(3);
+    for (size_t i = 0; i < 3; i++) {
+        REQUIRE(sigmf::read(metas[i], meta[i]));
+        REQUIRE(meta[i].datatype == "cu8");
+        REQUIRE(meta[i].sampleRate == 2048000);
+        REQUIRE(meta[i].recorder == "welle.io");
+        REQUIRE_FALSE(meta[i].captures.empty());
+        REQUIRE(meta[i].captures[0].sampleStart == 0);
+        REQUIRE(meta[i].annotations.size() == 1);
+    }
+
+    REQUIRE(meta[0].captures.size() == 1);
+    REQUIRE(meta[0].captures[0].frequency == 227360000);
+    REQUIRE(meta[1].captures.size() == 2);
+    REQUIRE(meta[1].captures[0].frequency == 227360000);
+    REQUIRE(meta[1].captures[1].sampleStart == 512);
+    REQUIRE(meta[1].captures[1].frequency == 178352000);
+    REQUIRE(meta[2].captures.size() == 1);
+    REQUIRE(meta[2].captures[0].frequency == 178352000);
+
+    // Times follow the sample rate
+    REQUIRE(meta[0].captures[0].datetime < meta[1].captures[0].datetime);
+
+    REQUIRE(meta[0].annotations[0].sampleStart == 1000);
+    REQUIRE(meta[0].annotations[0].sampleCount == 1048);
+    REQUIRE(meta[1].annotations[0].sampleStart == 0);
+    REQUIRE(meta[1].annotations[0].sampleCount == 2048);
+    REQUIRE(meta[2].annotations[0].sampleStart == 0);
+    REQUIRE(meta[2].annotations[0].sampleCount == 904);
+    remove_all(files);
+}
+
+TEST_CASE("Dropped samples are annotated", "[iqrecorder][sigmf]") {
+    auto config = make_config(IQRecorder::Format::U8);
+    config.blockBytes = 128;
+    config.numBlocks = 2;
+
+    // More than the queue holds at once: some blocks are dropped
+    const auto data = make_u8(128 * 1000);
+    std::vector<std::string> files;
+    std::vector<std::string> metas;
+    uint64_t dropped_blocks = 0;
+    {
+        IQRecorder recorder(config);
+        recorder.push(data.data(), data.size());
+        recorder.stop();
+        dropped_blocks = recorder.getStats().blocksDropped;
+        files = recorder.segmentFiles();
+        metas = recorder.metaFiles();
+    }
+    REQUIRE(dropped_blocks > 0);
+    REQUIRE(metas.size() == 1);
+
+    sigmf::Metadata meta;
+    REQUIRE(sigmf::read(metas[0], meta));
+
+    // The file and the drops add up to the input
+    uint64_t dropped = 0;
+    for (const auto& a : meta.annotations) {
+        REQUIRE(a.label == sigmf::DROPPED_LABEL);
+        REQUIRE(a.sampleCount == 0);
+        dropped += std::stoull(a.comment);
+    }
+    REQUIRE(dropped == dropped_blocks * 64);
+    REQUIRE(read_file(files[0]).size() / 2 + dropped == 128 * 1000 / 2);
+    remove_all(files);
+}
@@ -0,0 +1,95 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file json_writer_tests.cpp
+ * @brief Tests for the streaming JSON writer used for the mux.json
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../welle-cli/jsonwriter.h"
+#include "../libs/json.hpp"
+#include <cmath>
+#include <limits>
+
+TEST_CASE("Nested objects and arrays are separated correctly", "[jsonwriter]") {
+    JsonWriter w;
+    w.beginObject()
+        .member("a", 1)
+        .key("b").beginArray()
+            .value(true)
+            .beginObject().member("c", "d").endObject()
+            .beginArray().endArray()
+            .null()
+        .endArray()
+        .key("e").beginObject().endObject()
+        .endObject();
+
+    REQUIRE(w.str() == R"({"a":1,"b":[true,{"c":"d"},[],null],"e":{}})");
+}
+
+TEST_CASE("Strings are escaped", "[jsonwriter]") {
+    const std::string s = "quote\" backslash\\ newline\n tab\t bell\x07 Zürich";
+
+    JsonWriter w;
+    w.beginObject().member("s", s).endObject();
+
+    const auto j = nlohmann::json::parse(w.str());
+    REQUIRE(j["s"].get<std::string>() == s);
+    REQUIRE(w.str().find("\\u0007") != std::string::npos);
+}
+
+TEST_CASE("Numbers round-trip", "[jsonwriter]") {
+    const double d = 0.1;
+    const float f = -12.345f;
+    const uint64_t big = std::numeric_limits<uint64_t>::max();
+    const int16_t neg = -1234;
+
+    JsonWriter w;
+    w.beginArray().value(d).value(f).value(big).value(neg).value(1e300).endArray();
+
+    REQUIRE(w.str().substr(0, 5) == "[0.1,");
+
+    const auto j = nlohmann::json::parse(w.str());
+    REQUIRE(j[0].get<double>() == d);
+    REQUIRE(j[1].get<float>() == f);
+    REQUIRE(j[2].get<uint64_t>() == big);
+    REQUIRE(j[3].get<int>() == neg);
+    REQUIRE(j[4].get<double>() == 1e300);
+}
+
+TEST_CASE("Non-finite numbers become null", "[jsonwriter]") {
+    JsonWriter w;
+    w.beginArray()
+        .value(std::log10(0.0))
+        .value(std::numeric_limits<double>::quiet_NaN())
+        .endArray();
+
+    REQUIRE(w.str() == "[null,null]");
+}
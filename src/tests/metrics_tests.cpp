@@ -0,0 +1,135 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file metrics_tests.cpp
+ * @brief Tests for the metrics registry behind the /metrics endpoint
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../various/metrics.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool contains(const std::string& haystack, const std::string& needle)
+{
+    return haystack.find(needle) != std::string::npos;
+}
+
+TEST_CASE("Counters and gauges are rendered with HELP and TYPE", "[metrics]") {
+    metrics::Registry r;
+    r.counter("test_events_total", "Some events").inc(3);
+    r.gauge("test_level", "Some level", metrics::label("input", "rtl_tcp")).set(0.5);
+
+    const auto text = r.render();
+    REQUIRE(contains(text, "# HELP test_events_total Some events\n"));
+    REQUIRE(contains(text, "# TYPE test_events_total counter\n"));
+    REQUIRE(contains(text, "test_events_total 3\n"));
+    REQUIRE(contains(text, "# TYPE test_level gauge\n"));
+    REQUIRE(contains(text, "test_level{input=\"rtl_tcp\"} 0.5\n"));
+}
+
+TEST_CASE("Same name and labels give the same metric", "[metrics]") {
+    metrics::Registry r;
+    auto& a = r.counter("test_total", "help", metrics::label("crc", "ok"));
+    auto& b = r.counter("test_total", "help", metrics::label("crc", "ok"));
+    auto& c = r.counter("test_total", "help", metrics::label("crc", "error"));
+    REQUIRE(&a == &b);
+    REQUIRE(&a != &c);
+
+    REQUIRE_THROWS(r.gauge("test_total", "help"));
+}
+
+TEST_CASE("Histogram buckets are cumulative", "[metrics]") {
+    metrics::Registry r;
+    auto& h = r.histogram("test_seconds", "Durations", {0.1, 1.0},
+            metrics::label("stage", "ofdm"));
+    h.observe(0.05);
+    h.observe(0.5);
+    h.observe(0.5);
+    h.observe(5.0);
+
+    const auto v = h.get();
+    REQUIRE(v.count == 4);
+    REQUIRE(v.buckets == std::vector<uint64_t>({1, 3, 4}));
+    REQUIRE(v.sum == Approx(6.05));
+
+    const auto text = r.render();
+    REQUIRE(contains(text, "test_seconds_bucket{stage=\"ofdm\",le=\"0.1\"} 1\n"));
+    REQUIRE(contains(text, "test_seconds_bucket{stage=\"ofdm\",le=\"1\"} 3\n"));
+    REQUIRE(contains(text, "test_seconds_bucket{stage=\"ofdm\",le=\"+Inf\"} 4\n"));
+    REQUIRE(contains(text, "test_seconds_count{stage=\"ofdm\"} 4\n"));
+}
+
+TEST_CASE("Label values are escaped", "[metrics]") {
+    REQUIRE(metrics::label("name", "a\"b\\c\nd") == "name=\"a\\\"b\\\\c\\nd\"");
+}
+
+TEST_CASE("Label lists are joined", "[metrics]") {
+    const auto a = metrics::label("channel", "5A");
+    const auto b = metrics::label("crc", "ok");
+    REQUIRE(metrics::join_labels(a, b) == "channel=\"5A\",crc=\"ok\"");
+    REQUIRE(metrics::join_labels("", b) == b);
+    REQUIRE(metrics::join_labels(a, "") == a);
+    REQUIRE(metrics::join_labels("", "").empty());
+}
+
+TEST_CASE("Removed metrics are not rendered", "[metrics]") {
+    metrics::Registry r;
+    const auto l = metrics::label("client", "1");
+    r.counter("test_bytes_total", "Bytes", l).inc(10);
+    REQUIRE(contains(r.render(), "test_bytes_total{client=\"1\"} 10\n"));
+
+    r.remove("test_bytes_total", l);
+    REQUIRE_FALSE(contains(r.render(), "test_bytes_total"));
+}
+
+TEST_CASE("Concurrent increments are not lost", "[metrics]") {
+    metrics::Registry r;
+    auto& c = r.counter("test_concurrent_total", "help");
+    auto& h = r.histogram("test_concurrent_seconds", "help", {1.0});
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+                for (int i = 0; i < 10000; i++) {
+                    c.inc();
+                    h.observe(0.5);
+                }
+            });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    REQUIRE(c.get() == 40000);
+    REQUIRE(h.get().count == 40000);
+    REQUIRE(h.get().sum == Approx(20000.0));
+}
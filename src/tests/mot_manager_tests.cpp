@@ -0,0 +1,304 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file mot_manager_tests.cpp
+ * @brief Tests for the reassembly of MOT objects from data groups, in
+ *        header mode and directory mode
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/mot_manager.h"
+#include "../backend/tools.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using dg_list_t = std::vector<std::vector<uint8_t>>;
+
+static const int DG_TYPE_HEADER = 3;
+static const int DG_TYPE_BODY = 4;
+static const int DG_TYPE_DIRECTORY = 6;
+
+// MOT header core and extension with TriggerTime Now and ContentName
+static std::vector<uint8_t> mot_header(size_t body_size, const std::string& name,
+        int content_type = MOT_FILE::CONTENT_TYPE_IMAGE,
+        int content_sub_type = MOT_FILE::CONTENT_SUB_TYPE_JFIF)
+{
+    std::vector<uint8_t> ext;
+    ext.push_back(0x85);    // PLI 2, TriggerTime
+    ext.insert(ext.end(), {0, 0, 0, 0});
+    ext.push_back(0xCC);    // PLI 3, ContentName
+    ext.push_back(1 + name.size());
+    ext.push_back(0xF0);    // UTF-8
+    ext.insert(ext.end(), name.begin(), name.end());
+
+    const size_t header_size = 7 + ext.size();
+    BitWriter w;
+    w.AddBits(body_size, 28);
+    w.AddBits(header_size, 13);
+    w.AddBits(content_type, 6);
+    w.AddBits(content_sub_type, 9);
+    std::vector<uint8_t> header = w.GetData();
+    header.insert(header.end(), ext.begin(), ext.end());
+    return header;
+}
+
+static std::vector<uint8_t> make_body(size_t len, uint8_t seed)
+{
+    std::vector<uint8_t> body(len);
+    for (size_t i = 0; i < len; i++) {
+        body[i] = seed + i * 7;
+    }
+    return body;
+}
+
+// Cuts data into segments of seg_len bytes, each in its own data group
+static dg_list_t data_groups(int dg_type, int transport_id,
+        const std::vector<uint8_t>& data, size_t seg_len)
+{
+    dg_list_t dgs;
+    const size_t num_segs = std::max<size_t>(1, (data.size() + seg_len - 1) / seg_len);
+    for (size_t seg = 0; seg < num_segs; seg++) {
+        const size_t start = seg * seg_len;
+        const size_t len = std::min(seg_len, data.size() - start);
+        const bool last = seg + 1 == num_segs;
+
+        BitWriter w;
+        w.AddBits(0x70 | dg_type, 8);   // CRC, segment and user access flags
+        w.AddBits(0, 8);                // continuity and repetition index
+        w.AddBits(last, 1);
+        w.AddBits(seg, 15);
+        w.AddBits(0x12, 8);             // transport ID flag, length 2
+        w.AddBits(transport_id, 16);
+        w.AddBits(0, 3);                // repetition count
+        w.AddBits(len, 13);
+        std::vector<uint8_t> dg = w.GetData();
+        dg.insert(dg.end(), data.begin() + start, data.begin() + start + len);
+
+        const uint16_t crc = ~CalcCRC::CalcCRC_CRC16_CCITT.Calc(dg.data(), dg.size());
+        dg.push_back(crc >> 8);
+        dg.push_back(crc & 0xFF);
+        dgs.push_back(dg);
+    }
+    return dgs;
+}
+
+static dg_list_t slide(int transport_id, const std::vector<uint8_t>& body,
+        const std::string& name, size_t seg_len = 100)
+{
+    dg_list_t dgs = data_groups(DG_TYPE_HEADER, transport_id,
+            mot_header(body.size(), name), seg_len);
+    const auto body_dgs = data_groups(DG_TYPE_BODY, transport_id, body, seg_len);
+    dgs.insert(dgs.end(), body_dgs.begin(), body_dgs.end());
+    return dgs;
+}
+
+// Feeds the data groups, returns the files that were completed
+static std::vector<MOT_FILE> feed(MOTManager& mgr, const dg_list_t& dgs)
+{
+    std::vector<MOT_FILE> files;
+    for (const auto& dg : dgs) {
+        const bool new_files = mgr.HandleMOTDataGroup(dg);
+        REQUIRE(new_files == mgr.HasFile());
+        while (mgr.HasFile()) {
+            files.push_back(mgr.GetFile());
+        }
+    }
+    return files;
+}
+
+TEST_CASE("Slide in order", "[mot]") {
+    MOTManager mgr;
+    const auto body = make_body(1000, 1);
+    const auto files = feed(mgr, slide(42, body, "slide1.jpg"));
+
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].data == body);
+    REQUIRE(files[0].content_name == "slide1.jpg");
+    REQUIRE(files[0].transport_id == 42);
+    REQUIRE(files[0].content_type == (int)MOT_FILE::CONTENT_TYPE_IMAGE);
+    REQUIRE(mgr.IsCompleted(42));
+    REQUIRE(mgr.GetNumObjects() == 0);
+}
+
+TEST_CASE("Body before header and segments out of order", "[mot]") {
+    MOTManager mgr;
+    const auto body = make_body(1234, 2);
+    auto dgs = slide(7, body, "a.png", 64);
+
+    std::mt19937 rng(1);
+    std::shuffle(dgs.begin(), dgs.end(), rng);
+    // Make sure the last body segment comes before all others
+    std::stable_partition(dgs.begin(), dgs.end(), [](const std::vector<uint8_t>& dg) {
+            return (dg[0] & 0x0F) == DG_TYPE_BODY and (dg[2] & 0x80); });
+
+    const auto files = feed(mgr, dgs);
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].data == body);
+}
+
+TEST_CASE("Interleaved carousel of two objects", "[mot]") {
+    MOTManager mgr;
+    const auto body_a = make_body(900, 3);
+    const auto body_b = make_body(700, 4);
+    const auto dgs_a = slide(100, body_a, "a.jpg");
+    const auto dgs_b = slide(101, body_b, "b.jpg");
+
+    dg_list_t dgs;
+    for (size_t i = 0; i < std::max(dgs_a.size(), dgs_b.size()); i++) {
+        if (i < dgs_a.size()) dgs.push_back(dgs_a[i]);
+        if (i < dgs_b.size()) dgs.push_back(dgs_b[i]);
+    }
+
+    const auto files = feed(mgr, dgs);
+    REQUIRE(files.size() == 2);
+    REQUIRE(files[0].transport_id == 101);
+    REQUIRE(files[0].data == body_b);
+    REQUIRE(files[1].transport_id == 100);
+    REQUIRE(files[1].data == body_a);
+}
+
+TEST_CASE("Repetitions of a completed object are skipped", "[mot]") {
+    MOTManager mgr;
+    const auto dgs_a = slide(1, make_body(500, 5), "a.jpg");
+    const auto dgs_b = slide(2, make_body(500, 6), "b.jpg");
+
+    REQUIRE(feed(mgr, dgs_a).size() == 1);
+    REQUIRE(feed(mgr, dgs_b).size() == 1);
+
+    // The carousel sends both again
+    REQUIRE(feed(mgr, dgs_a).empty());
+    REQUIRE(feed(mgr, dgs_b).empty());
+    REQUIRE(mgr.GetRepetitions() == dgs_a.size() + dgs_b.size());
+    REQUIRE(mgr.GetNumObjects() == 0);
+
+    // A new object with a reused transport ID is not a repetition
+    const auto body = make_body(300, 7);
+    const auto files = feed(mgr, slide(1, body, "c.jpg"));
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].content_name == "c.jpg");
+    REQUIRE(files[0].data == body);
+}
+
+TEST_CASE("Least recently used objects are dropped", "[mot]") {
+    MOTManager mgr;
+
+    // Only the header of many objects
+    for (int tid = 0; tid < (int)MOTManager::MAX_OBJECTS + 4; tid++) {
+        feed(mgr, data_groups(DG_TYPE_HEADER, tid, mot_header(200, "x"), 100));
+    }
+    REQUIRE(mgr.GetNumObjects() == MOTManager::MAX_OBJECTS);
+
+    // The first objects were dropped, their bodies are not enough
+    const auto body = make_body(200, 8);
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_BODY, 0, body, 100)).empty());
+
+    const int last = MOTManager::MAX_OBJECTS + 3;
+    const auto files = feed(mgr, data_groups(DG_TYPE_BODY, last, body, 100));
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].transport_id == last);
+}
+
+TEST_CASE("Memory of incomplete objects is capped", "[mot]") {
+    MOTManager mgr;
+    const size_t big = MOTManager::MAX_MEMORY * 3 / 4;
+
+    feed(mgr, data_groups(DG_TYPE_HEADER, 1, mot_header(big, "big1"), 100));
+    REQUIRE(mgr.GetMemoryUsage() >= big);
+
+    feed(mgr, data_groups(DG_TYPE_HEADER, 2, mot_header(big, "big2"), 100));
+    REQUIRE(mgr.GetNumObjects() == 1);
+    REQUIRE(mgr.GetMemoryUsage() <= MOTManager::MAX_MEMORY);
+}
+
+// Directory without extension, followed by the transport ID and header of
+// every object
+static std::vector<uint8_t> mot_directory(
+        const std::vector<std::pair<int, std::vector<uint8_t>>>& entries)
+{
+    std::vector<uint8_t> entry_data;
+    for (const auto& e : entries) {
+        entry_data.push_back(e.first >> 8);
+        entry_data.push_back(e.first & 0xFF);
+        entry_data.insert(entry_data.end(), e.second.begin(), e.second.end());
+    }
+
+    BitWriter w;
+    w.AddBits(0, 2);    // compression flag, RFU
+    w.AddBits(13 + entry_data.size(), 30);
+    w.AddBits(entries.size(), 16);
+    w.AddBits(0, 24);   // carousel period
+    w.AddBits(0, 3);
+    w.AddBits(100, 13); // segment size
+    w.AddBits(0, 16);   // extension length
+    std::vector<uint8_t> dir = w.GetData();
+    dir.insert(dir.end(), entry_data.begin(), entry_data.end());
+    return dir;
+}
+
+TEST_CASE("Directory mode", "[mot]") {
+    MOTManager mgr;
+    const auto body_a = make_body(450, 9);
+    const auto body_b = make_body(1500, 10);
+    const auto dir = mot_directory({
+            {10, mot_header(body_a.size(), "epg/a.xml", 0x07, 0)},
+            {11, mot_header(body_b.size(), "epg/b.xml", 0x07, 0)} });
+
+    // The body of the first object is complete before the directory
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_BODY, 10, body_a, 100)).empty());
+
+    auto files = feed(mgr, data_groups(DG_TYPE_DIRECTORY, 500, dir, 100));
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].content_name == "epg/a.xml");
+    REQUIRE(files[0].transport_id == 10);
+    REQUIRE(files[0].data == body_a);
+
+    files = feed(mgr, data_groups(DG_TYPE_BODY, 11, body_b, 100));
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].content_name == "epg/b.xml");
+    REQUIRE(files[0].data == body_b);
+
+    // Next turn of the carousel
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_DIRECTORY, 500, dir, 100)).empty());
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_BODY, 10, body_a, 100)).empty());
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_BODY, 11, body_b, 100)).empty());
+
+    // A new directory in which the second object changed
+    const auto body_b2 = make_body(800, 11);
+    const auto dir2 = mot_directory({
+            {10, mot_header(body_a.size(), "epg/a.xml", 0x07, 0)},
+            {11, mot_header(body_b2.size(), "epg/b.xml", 0x07, 0)} });
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_DIRECTORY, 501, dir2, 100)).empty());
+    REQUIRE(feed(mgr, data_groups(DG_TYPE_BODY, 10, body_a, 100)).empty());
+    files = feed(mgr, data_groups(DG_TYPE_BODY, 11, body_b2, 100));
+    REQUIRE(files.size() == 1);
+    REQUIRE(files[0].data == body_b2);
+}
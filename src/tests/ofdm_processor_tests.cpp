@@ -0,0 +1,200 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file ofdm_processor_tests.cpp
+ * @brief Tests for the synchronisation of the OFDM processor on the samples of an input
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/ofdm-processor.h"
+#include "../input/ensemble_generator.h"
+#include "test_radio_interface.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A device whose sample buffer the test fills
+class FeedInput : public CVirtualInput {
+    public:
+        // Store samples, after which dropped samples were lost
+        void deliver(const DSPCOMPLEX *data, size_t num, size_t dropped = 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                samples.insert(samples.end(), data, data + num);
+            }
+            countSamples(num + dropped, num);
+        }
+
+        // Make getSamples() wait before reading past a position, like a
+        // receiver falling behind
+        void hold(size_t at) { limit = at; }
+        void release() { limit = SIZE_MAX; }
+        bool isHeld() const { return held; }
+
+        size_t getPosition() const { return position; }
+        size_t getDelivered() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return samples.size();
+        }
+
+        CDeviceID getID(void) override { return CDeviceID::NULLDEVICE; }
+        void setFrequency(int) override {}
+        int getFrequency(void) const override { return 0; }
+        bool is_ok(void) override { return true; }
+        bool restart(void) override { return true; }
+        void stop(void) override {}
+        void reset(void) override {}
+        int32_t getSamples(DSPCOMPLEX *buf, int32_t size) override {
+            while (position + size > limit) {
+                held = true;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            held = false;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            const size_t num = std::min<size_t>(size, samples.size() - position);
+            std::copy(samples.begin() + position, samples.begin() + position + num, buf);
+            position += num;
+            return num;
+        }
+        std::vector<DSPCOMPLEX> getSpectrumSamples(int) override { return {}; }
+        int32_t getSamplesToRead(void) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            return samples.size() - position;
+        }
+        float setGain(int) override { return 0; }
+        float getGain(void) const override { return 0; }
+        int getGainCount(void) override { return 0; }
+        void setAgc(bool) override {}
+        std::string getDescription(void) override { return "feed"; }
+
+    private:
+        std::mutex mutex;
+        std::vector<DSPCOMPLEX> samples;
+        std::atomic<size_t> position = ATOMIC_VAR_INIT(0);
+        std::atomic<size_t> limit = ATOMIC_VAR_INIT(SIZE_MAX);
+        std::atomic<bool> held = ATOMIC_VAR_INIT(false);
+};
+
+// Records where in the input the processor lost sync
+class SyncRadioInterface : public TestRadioInterface {
+    public:
+        explicit SyncRadioInterface(const FeedInput& input) : input(input) {}
+
+        void onSyncChange(char isSync) override {
+            if (isSync) {
+                synced = true;
+                framesSynced++;
+            }
+            else if (synced) {
+                synced = false;
+                syncLosses.push_back(input.getPosition());
+            }
+        }
+
+        const FeedInput& input;
+        std::atomic<bool> synced = ATOMIC_VAR_INIT(false);
+        std::atomic<int> framesSynced = ATOMIC_VAR_INIT(0);
+        std::vector<size_t> syncLosses;
+};
+
+// Wait until the processor read what was delivered, but for less than
+// the symbol it waits for
+static void wait_consumed(FeedInput& input, const DABParams& params)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (input.getPosition() + params.T_s < input.getDelivered()) {
+        REQUIRE(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+TEST_CASE("Lost samples make the processor resynchronise at the gap", "[ofdm]") {
+    const DABParams params(1);
+    const size_t T_F = params.T_F;
+
+    EnsembleGenerator generator(EnsembleGenerator::makeConfig(2, 48));
+    std::vector<DSPCOMPLEX> signal(14 * T_F);
+    generator.getSamples(signal.data(), signal.size());
+
+    // The processor lags behind while the buffer fills, it overflows with
+    // two and a half frames the processor did not see yet
+    const size_t lag = 4 * T_F;
+    const size_t gap = 6 * T_F + T_F / 2;
+    const size_t dropped = T_F / 3;
+
+    FeedInput input;
+    SyncRadioInterface radio(input);
+    FicHandler fic(radio);
+    MscHandler msc(params, false);
+    {
+        OFDMProcessor processor(input, params, radio, msc, fic, RadioReceiverOptions());
+        processor.restart();
+
+        input.hold(lag - T_F / 2);
+        input.deliver(signal.data(), lag);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (not input.isHeld()) {
+            REQUIRE(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(radio.synced);
+
+        input.deliver(signal.data() + lag, gap - lag, dropped);
+        input.deliver(signal.data() + gap + dropped, signal.size() - gap - dropped);
+        input.release();
+        wait_consumed(input, params);
+
+        // Let the decoder finish the last frames
+        int fibs = -1;
+        while (fibs != radio.fibsOk) {
+            fibs = radio.fibsOk;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        REQUIRE(input.getDiscontinuityCount() == 1);
+    }
+
+    // Once, in the frame the gap is in, not before using the samples
+    // buffered before it
+    REQUIRE(radio.syncLosses.size() == 1);
+    REQUIRE(radio.syncLosses[0] > gap);
+    REQUIRE(radio.syncLosses[0] < gap + T_F);
+
+    // No frame across the gap was decoded, and the processor found the
+    // frames after it: of the 14 frames, the first may be missed while
+    // looking for the null symbol, and the one of the gap and the last
+    // one are incomplete
+    REQUIRE(radio.fibsFailed == 0);
+    REQUIRE(radio.synced);
+    REQUIRE(radio.fibsOk >= 11 * 12);
+}
@@ -0,0 +1,315 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file packet_decoder_tests.cpp
+ * @brief Tests for the demultiplexing and reassembly of packet mode data
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/packet-decoder.h"
+#include "../backend/tools.h"
+#include <vector>
+
+extern "C" {
+#include <fec.h>
+}
+
+struct Received {
+    uint16_t address;
+    std::vector<uint8_t> data;
+};
+
+class TestHandler : public PacketDataHandlerInterface {
+    public:
+        std::vector<Received> received;
+
+        void onDataGroup(uint16_t packetAddress, std::vector<uint8_t>&& data) override {
+            received.push_back({packetAddress, std::move(data)});
+        }
+};
+
+static void append_crc(std::vector<uint8_t>& v)
+{
+    const uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(v.data(), v.size());
+    v.push_back(crc >> 8);
+    v.push_back(crc & 0xFF);
+}
+
+// MSC data group with CRC, without extension and session header
+static std::vector<uint8_t> make_data_group(size_t len, uint8_t value)
+{
+    std::vector<uint8_t> dg = {0x40, 0x00};
+    for (size_t i = 0; i < len; i++) {
+        dg.push_back(value + i);
+    }
+    append_crc(dg);
+    return dg;
+}
+
+// first_last: 0 intermediate, 1 last, 2 first, 3 single
+static std::vector<uint8_t> make_packet(size_t units, int continuity,
+        int first_last, uint16_t address, const uint8_t *data, size_t len)
+{
+    std::vector<uint8_t> p(units * PacketDecoder::UNIT_LENGTH - 2, 0);
+    p[0] = ((units - 1) << 6) | (continuity << 4) | (first_last << 2) |
+        (address >> 8);
+    p[1] = address & 0xFF;
+    p[2] = len;
+    std::copy(data, data + len, p.begin() + 3);
+    append_crc(p);
+    return p;
+}
+
+// Cut data into packets of the given size
+static std::vector<uint8_t> packetise(const std::vector<uint8_t>& data,
+        uint16_t address, size_t units, int& continuity)
+{
+    const size_t payload = units * PacketDecoder::UNIT_LENGTH - 5;
+    std::vector<uint8_t> out;
+    for (size_t pos = 0; pos < data.size(); pos += payload) {
+        const size_t len = std::min(payload, data.size() - pos);
+        const bool first = pos == 0;
+        const bool last = pos + len == data.size();
+        const auto p = make_packet(units, continuity,
+                (first ? 2 : 0) | (last ? 1 : 0), address, &data[pos], len);
+        continuity = (continuity + 1) & 3;
+        out.insert(out.end(), p.begin(), p.end());
+    }
+    return out;
+}
+
+TEST_CASE("Only subscribed addresses are delivered", "[packet]") {
+    PacketDecoder decoder(false);
+    TestHandler handler;
+    decoder.subscribe(17, true, handler);
+
+    int ci_a = 0;
+    int ci_b = 0;
+    const auto dg_a = make_data_group(10, 1);
+    const auto dg_b = make_data_group(10, 2);
+    auto stream = packetise(dg_b, 18, 1, ci_b);
+    const auto a = packetise(dg_a, 17, 1, ci_a);
+    stream.insert(stream.end(), a.begin(), a.end());
+
+    decoder.process(stream.data(), stream.size());
+
+    REQUIRE(handler.received.size() == 1);
+    REQUIRE(handler.received[0].address == 17);
+    REQUIRE(handler.received[0].data == dg_a);
+    REQUIRE(decoder.getStats().packets == 1);
+    REQUIRE(decoder.getStats().data_groups == 1);
+}
+
+TEST_CASE("Data groups spanning several packets and calls are reassembled", "[packet]") {
+    PacketDecoder decoder(false);
+    TestHandler handler;
+    decoder.subscribe(5, true, handler);
+
+    int ci = 0;
+    const auto dg = make_data_group(1000, 7);
+    const auto stream = packetise(dg, 5, 4, ci);
+    REQUIRE(stream.size() > 10 * 96);
+
+    // Feed it in logical frames of a 16 kbps subchannel
+    const size_t frame = 48;
+    for (size_t pos = 0; pos < stream.size(); pos += frame) {
+        decoder.process(&stream[pos], std::min(frame, stream.size() - pos));
+    }
+
+    REQUIRE(handler.received.size() == 1);
+    REQUIRE(handler.received[0].data == dg);
+    REQUIRE(decoder.getStats().continuity_errors == 0);
+}
+
+TEST_CASE("Corrupted and missing packets drop the data group", "[packet]") {
+    PacketDecoder decoder(false);
+    TestHandler handler;
+    decoder.subscribe(5, true, handler);
+
+    int ci = 0;
+    const auto dg1 = make_data_group(100, 1);
+    const auto dg2 = make_data_group(100, 2);
+    const auto dg3 = make_data_group(100, 3);
+
+    auto s1 = packetise(dg1, 5, 1, ci);
+    s1[30] ^= 0x01;
+    decoder.process(s1.data(), s1.size());
+
+    // Leave out the second packet
+    auto s2 = packetise(dg2, 5, 1, ci);
+    s2.erase(s2.begin() + 24, s2.begin() + 48);
+    decoder.process(s2.data(), s2.size());
+
+    const auto s3 = packetise(dg3, 5, 1, ci);
+    decoder.process(s3.data(), s3.size());
+
+    REQUIRE(handler.received.size() == 1);
+    REQUIRE(handler.received[0].data == dg3);
+
+    const auto& stats = decoder.getStats();
+    REQUIRE(stats.crc_errors == 1);
+    REQUIRE(stats.continuity_errors == 1);
+    REQUIRE(stats.data_group_errors == 2);
+}
+
+TEST_CASE("Data group CRC is checked unless the DG flag is set", "[packet]") {
+    auto dg = make_data_group(30, 9);
+    dg[10] ^= 0x80;
+
+    SECTION("Data groups") {
+        PacketDecoder decoder(false);
+        TestHandler handler;
+        decoder.subscribe(5, true, handler);
+        int ci = 0;
+        const auto s = packetise(dg, 5, 2, ci);
+        decoder.process(s.data(), s.size());
+        REQUIRE(handler.received.empty());
+        REQUIRE(decoder.getStats().data_group_errors == 1);
+    }
+
+    SECTION("No data groups") {
+        PacketDecoder decoder(false);
+        TestHandler handler;
+        decoder.subscribe(5, false, handler);
+        int ci = 0;
+        const auto s = packetise(dg, 5, 2, ci);
+        decoder.process(s.data(), s.size());
+        REQUIRE(handler.received.size() == 1);
+        REQUIRE(handler.received[0].data == dg);
+    }
+}
+
+// One FEC frame: the application data table followed by nine FEC packets
+static std::vector<uint8_t> make_fec_frame(const std::vector<uint8_t>& adt)
+{
+    REQUIRE(adt.size() == PacketDecoder::ADT_LENGTH);
+
+    void *rs = init_rs_char(8, 0x11D, 0, 1, 16, 255 - 204);
+    REQUIRE(rs != nullptr);
+
+    std::vector<uint8_t> rs_table(PacketDecoder::RS_LENGTH);
+    uint8_t row_data[188];
+    uint8_t parity[16];
+    for (size_t row = 0; row < 12; row++) {
+        for (size_t col = 0; col < 188; col++) {
+            row_data[col] = adt[col * 12 + row];
+        }
+        encode_rs_char(rs, row_data, parity);
+        for (size_t col = 0; col < 16; col++) {
+            rs_table[col * 12 + row] = parity[col];
+        }
+    }
+    free_rs_char(rs);
+
+    std::vector<uint8_t> frame = adt;
+    rs_table.resize(9 * 22, 0);
+    for (size_t i = 0; i < 9; i++) {
+        frame.push_back(0x0F);
+        frame.push_back(0xFE);
+        frame.insert(frame.end(), rs_table.begin() + 22 * i,
+                rs_table.begin() + 22 * (i + 1));
+    }
+    return frame;
+}
+
+static std::vector<uint8_t> make_adt(int& ci, std::vector<uint8_t>& dg)
+{
+    dg = make_data_group(1500, 3);
+    auto adt = packetise(dg, 100, 4, ci);
+
+    // Fill up with padding packets
+    while (adt.size() < PacketDecoder::ADT_LENGTH) {
+        const auto p = make_packet(1, 0, 3, PacketDecoder::PADDING_ADDRESS, nullptr, 0);
+        adt.insert(adt.end(), p.begin(), p.end());
+    }
+    REQUIRE(adt.size() == PacketDecoder::ADT_LENGTH);
+    return adt;
+}
+
+TEST_CASE("Outer FEC corrects the application data table", "[packet][fec]") {
+    int ci = 0;
+    std::vector<uint8_t> dg;
+    const auto frame = make_fec_frame(make_adt(ci, dg));
+
+    // Eight byte errors per row are correctable
+    auto corrupted = frame;
+    for (size_t i = 0; i < 8 * 12; i++) {
+        corrupted[24 + 23 * i] ^= 0x5A;
+    }
+
+    SECTION("With FEC") {
+        PacketDecoder decoder(true);
+        TestHandler handler;
+        decoder.subscribe(100, true, handler);
+        decoder.process(corrupted.data(), corrupted.size());
+
+        REQUIRE(handler.received.size() == 1);
+        REQUIRE(handler.received[0].data == dg);
+
+        const auto& stats = decoder.getStats();
+        REQUIRE(stats.fec_frames == 1);
+        REQUIRE(stats.fec_corrected_bytes == 8 * 12);
+        REQUIRE(stats.fec_uncorrectable_rows == 0);
+        REQUIRE(stats.crc_errors == 0);
+    }
+
+    SECTION("Without FEC") {
+        PacketDecoder decoder(false);
+        TestHandler handler;
+        decoder.subscribe(100, true, handler);
+        decoder.process(corrupted.data(), corrupted.size());
+        REQUIRE(handler.received.empty());
+        REQUIRE(decoder.getStats().crc_errors > 0);
+    }
+}
+
+TEST_CASE("FEC decoder synchronises to the FEC frames", "[packet][fec]") {
+    PacketDecoder decoder(true);
+    TestHandler handler;
+    decoder.subscribe(100, true, handler);
+
+    int ci = 0;
+    std::vector<uint8_t> dg;
+    const auto frame1 = make_fec_frame(make_adt(ci, dg));
+    const auto frame2 = make_fec_frame(make_adt(ci, dg));
+
+    // Start in the middle of the first frame, its data groups are lost
+    // but the packets before the FEC packets go out uncorrected.
+    std::vector<uint8_t> stream(frame1.begin() + 480, frame1.end());
+    stream.insert(stream.end(), frame2.begin(), frame2.end());
+
+    for (size_t pos = 0; pos < stream.size(); pos += 72) {
+        decoder.process(&stream[pos], std::min<size_t>(72, stream.size() - pos));
+    }
+
+    REQUIRE(handler.received.size() == 1);
+    REQUIRE(handler.received[0].data == dg);
+    REQUIRE(decoder.getStats().fec_frames == 1);
+}
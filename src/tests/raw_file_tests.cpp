@@ -0,0 +1,395 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file raw_file_tests.cpp
+ * @brief Tests for the memory mapped, unthrottled mode of the raw file input
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../input/raw_file.h"
+#include "../input/iq_convert.h"
+#include "test_radio_interface.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// A temporary u8 recording whose sample i has I = i % 256 and Q = 255 - I
+class TempRecording {
+    public:
+        TempRecording(size_t num_samples) {
+            static int counter = 0;
+            name = "raw_file_test_" + std::to_string(counter++) + ".u8.iq";
+            FILE *fd = fopen(name.c_str(), "wb");
+            for (size_t i = 0; i < num_samples; i++) {
+                const uint8_t iq[2] = { (uint8_t)(i % 256), (uint8_t)(255 - i % 256) };
+                fwrite(iq, 1, 2, fd);
+            }
+            fclose(fd);
+        }
+        ~TempRecording() { remove(name.c_str()); }
+
+        std::string name;
+};
+
+static DSPCOMPLEX expected_sample(size_t i)
+{
+    return DSPCOMPLEX(float(int(i % 256) - 128) / 128.0f,
+                      float(int(255 - i % 256) - 128) / 128.0f);
+}
+
+TEST_CASE("Unthrottled input maps the file and reads it to the end", "[rawfile]") {
+    TempRecording recording(10000);
+    TestRadioInterface ri;
+    CRAWFile input(ri, false, false);
+    input.setFileName(recording.name, "auto");
+    REQUIRE(input.is_ok());
+    REQUIRE(input.isMapped());
+
+    // Nothing to read until started
+    REQUIRE(input.getSamplesToRead() == 0);
+    input.restart();
+    REQUIRE(input.getSamplesToRead() > 0);
+
+    std::vector<DSPCOMPLEX> buf(3000);
+    size_t pos = 0;
+    while (pos < 10000) {
+        REQUIRE_FALSE(input.endWasReached());
+        REQUIRE(input.getSamples(buf.data(), buf.size()) == (int32_t)buf.size());
+        for (size_t i = 0; i < buf.size(); i++, pos++) {
+            if (pos < 10000) {
+                REQUIRE(buf[i] == expected_sample(pos));
+            }
+            else {
+                // Zeros after the end
+                REQUIRE(buf[i] == DSPCOMPLEX(0, 0));
+            }
+        }
+    }
+
+    REQUIRE(input.endWasReached());
+    REQUIRE(input.getRealTimeFactor() > 0);
+    REQUIRE(ri.restarts == 0);
+
+    // The spectrum shows the last samples of the file
+    const auto spectrum = input.getSpectrumSamples(16);
+    REQUIRE(spectrum.size() == 16);
+    REQUIRE(spectrum.back() == expected_sample(9999));
+
+    input.rewind();
+    REQUIRE_FALSE(input.endWasReached());
+    REQUIRE(input.getSamples(buf.data(), 1) == 1);
+    REQUIRE(buf[0] == expected_sample(0));
+}
+
+TEST_CASE("Mapped input rewinds at the end", "[rawfile]") {
+    TempRecording recording(1000);
+    TestRadioInterface ri;
+    CRAWFile input(ri, false, true);
+    input.setFileName(recording.name, "u8");
+    REQUIRE(input.isMapped());
+    input.restart();
+
+    std::vector<DSPCOMPLEX> buf(1500);
+    REQUIRE(input.getSamples(buf.data(), buf.size()) == 1500);
+    REQUIRE(buf[999] == expected_sample(999));
+    REQUIRE(buf[1000] == expected_sample(0));
+    REQUIRE(buf[1499] == expected_sample(499));
+    REQUIRE(ri.restarts == 1);
+    REQUIRE_FALSE(input.endWasReached());
+}
+
+TEST_CASE("Throttled input keeps the reader thread", "[rawfile]") {
+    TempRecording recording(100000);
+    TestRadioInterface ri;
+    CRAWFile input(ri, true, false);
+    input.setFileName(recording.name, "auto");
+    REQUIRE(input.is_ok());
+    REQUIRE_FALSE(input.isMapped());
+
+    input.restart();
+    std::vector<DSPCOMPLEX> buf(1000);
+    REQUIRE(input.getSamples(buf.data(), buf.size()) == 1000);
+    for (size_t i = 0; i < buf.size(); i++) {
+        REQUIRE(buf[i] == expected_sample(i));
+    }
+}
+
+TEST_CASE("SigMF metadata selects the format", "[rawfile][sigmf]") {
+    const std::string base = "raw_file_test_sigmf";
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < 1000; i++) {
+        const int16_t iq[2] = { (int16_t)(i * 30), (int16_t)(-i * 30) };
+        for (int16_t v : iq) {
+            bytes.push_back(v & 0xFF);
+            bytes.push_back((v >> 8) & 0xFF);
+        }
+    }
+    FILE *fd = fopen((base + ".sigmf-data").c_str(), "wb");
+    fwrite(bytes.data(), 1, bytes.size(), fd);
+    fclose(fd);
+
+    sigmf::Metadata meta;
+    meta.datatype = "ci16_le";
+    meta.sampleRate = 2048000;
+    sigmf::Capture capture;
+    capture.frequency = 227360000;
+    meta.captures.push_back(capture);
+    REQUIRE(sigmf::write(base + ".sigmf-meta", meta));
+
+    TestRadioInterface ri;
+    CRAWFile input(ri, false, false);
+    // Opening the metadata plays the data file
+    input.setFileName(base + ".sigmf-meta", "auto");
+    REQUIRE(input.is_ok());
+    REQUIRE(input.getFrequency() == 227360000);
+
+    sigmf::Metadata read_back;
+    REQUIRE(input.getMetadata(read_back));
+    REQUIRE(read_back.datatype == "ci16_le");
+
+    std::vector<DSPCOMPLEX> expected(1000);
+    iqconvert::s16le(bytes.data(), expected.data(), expected.size());
+
+    input.restart();
+    std::vector<DSPCOMPLEX> buf(1000);
+    REQUIRE(input.getSamples(buf.data(), buf.size()) == 1000);
+    REQUIRE(buf == expected);
+
+    remove((base + ".sigmf-data").c_str());
+    remove((base + ".sigmf-meta").c_str());
+}
+
+TEST_CASE("Compressed SigMF recordings are refused", "[rawfile][sigmf]") {
+    const std::string base = "raw_file_test_wiq";
+    sigmf::Metadata meta;
+    meta.datatype = "cf32_le";
+    meta.dataset = base + ".wiq";
+    meta.encoding = "wiq";
+    REQUIRE(sigmf::write(base + ".sigmf-meta", meta));
+    FILE *fd = fopen((base + ".wiq").c_str(), "wb");
+    fclose(fd);
+
+    TestRadioInterface ri;
+    CRAWFile input(ri, false, false);
+    input.setFileName(base + ".sigmf-meta", "auto");
+    REQUIRE_FALSE(input.is_ok());
+
+    remove((base + ".wiq").c_str());
+    remove((base + ".sigmf-meta").c_str());
+}
+
+TEST_CASE("Recordings play back with the auto format", "[rawfile][sigmf]") {
+    IQRecorder::Config config;
+    config.prefix = "raw_file_test_recorder";
+    config.frequency = 178352000;
+
+    std::vector<uint8_t> bytes(2 * 5000);
+    for (size_t i = 0; i < 5000; i++) {
+        bytes[2*i] = i % 256;
+        bytes[2*i+1] = 255 - i % 256;
+    }
+
+    std::vector<std::string> files;
+    {
+        IQRecorder recorder(config);
+        recorder.push(bytes.data(), bytes.size());
+        recorder.stop();
+        files = recorder.segmentFiles();
+        const auto metas = recorder.metaFiles();
+        REQUIRE(files.size() == 1);
+        REQUIRE(metas.size() == 1);
+        files.push_back(metas[0]);
+    }
+
+    TestRadioInterface ri;
+    CRAWFile input(ri, false, false);
+    input.setFileName(files[0], "auto");
+    REQUIRE(input.is_ok());
+    REQUIRE(input.getFrequency() == 178352000);
+
+    // The recorded rate cannot be overridden
+    REQUIRE(input.getSampleRate() == INPUT_RATE);
+    REQUIRE_FALSE(input.setSampleRate(2 * INPUT_RATE));
+
+    input.restart();
+    std::vector<DSPCOMPLEX> buf(5000);
+    REQUIRE(input.getSamples(buf.data(), buf.size()) == 5000);
+    for (size_t i = 0; i < buf.size(); i++) {
+        REQUIRE(buf[i] == expected_sample(i));
+    }
+
+    for (const auto& f : files) {
+        remove(f.c_str());
+    }
+}
+
+TEST_CASE("16-bit recordings without metadata play back with the auto format", "[rawfile]") {
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < 2000; i++) {
+        const int16_t iq[2] = { (int16_t)(i * 17), (int16_t)(300 - i * 11) };
+        for (int16_t v : iq) {
+            bytes.push_back(v & 0xFF);
+            bytes.push_back((v >> 8) & 0xFF);
+        }
+    }
+
+    for (auto format : { IQRecorder::Format::S16LE, IQRecorder::Format::S16BE }) {
+        IQRecorder::Config config;
+        config.prefix = "raw_file_test_s16";
+        config.format = format;
+        config.sigmf = false;
+
+        std::vector<std::string> files;
+        {
+            IQRecorder recorder(config);
+            recorder.push(bytes.data(), bytes.size());
+            recorder.stop();
+            files = recorder.segmentFiles();
+            REQUIRE(files.size() == 1);
+            REQUIRE(recorder.metaFiles().empty());
+        }
+        const std::string suffix =
+            format == IQRecorder::Format::S16LE ? ".s16le.iq" : ".s16be.iq";
+        REQUIRE(files[0].size() > suffix.size());
+        REQUIRE(files[0].compare(files[0].size() - suffix.size(), suffix.size(), suffix) == 0);
+
+        TestRadioInterface ri;
+        CRAWFile input(ri, false, false);
+        input.setFileName(files[0], "auto");
+        REQUIRE(input.is_ok());
+
+        std::vector<DSPCOMPLEX> expected(2000);
+        if (format == IQRecorder::Format::S16LE) {
+            iqconvert::s16le(bytes.data(), expected.data(), expected.size());
+        }
+        else {
+            iqconvert::s16be(bytes.data(), expected.data(), expected.size());
+        }
+
+        input.restart();
+        std::vector<DSPCOMPLEX> buf(2000);
+        REQUIRE(input.getSamples(buf.data(), buf.size()) == 2000);
+        REQUIRE(buf == expected);
+
+        remove(files[0].c_str());
+    }
+}
+
+TEST_CASE("The legacy 16-bit formats swap the byte order", "[rawfile]") {
+    const std::string name = "raw_file_test_legacy.s16le.iq";
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < 1000; i++) {
+        bytes.push_back(i & 0xFF);
+        bytes.push_back((i * 7) & 0xFF);
+    }
+    FILE *fd = fopen(name.c_str(), "wb");
+    fwrite(bytes.data(), 1, bytes.size(), fd);
+    fclose(fd);
+
+    std::vector<DSPCOMPLEX> little(500), big(500);
+    iqconvert::s16le(bytes.data(), little.data(), little.size());
+    iqconvert::s16be(bytes.data(), big.data(), big.size());
+
+    for (const auto& f : { std::make_pair("auto", &little),
+                std::make_pair("s16le-legacy", &big),
+                std::make_pair("s16be-legacy", &little) }) {
+        TestRadioInterface ri;
+        CRAWFile input(ri, false, false);
+        input.setFileName(name, f.first);
+        REQUIRE(input.is_ok());
+
+        input.restart();
+        std::vector<DSPCOMPLEX> buf(500);
+        REQUIRE(input.getSamples(buf.data(), buf.size()) == 500);
+        REQUIRE(buf == *f.second);
+    }
+
+    remove(name.c_str());
+}
+
+// Drives the sample accounting of CVirtualInput like a device callback
+class CountingInput : public CVirtualInput {
+    public:
+        void deliver(size_t received, size_t written) { countSamples(received, written); }
+        void restartInput() { resetStallTimer(); }
+
+        CDeviceID getID(void) override { return CDeviceID::NULLDEVICE; }
+        void setFrequency(int) override {}
+        int getFrequency(void) const override { return 0; }
+        bool is_ok(void) override { return true; }
+        bool restart(void) override { return true; }
+        void stop(void) override {}
+        void reset(void) override {}
+        int32_t getSamples(DSPCOMPLEX*, int32_t) override { return 0; }
+        std::vector<DSPCOMPLEX> getSpectrumSamples(int) override { return {}; }
+        int32_t getSamplesToRead(void) override { return 0; }
+        float setGain(int) override { return 0; }
+        float getGain(void) const override { return 0; }
+        int getGainCount(void) override { return 0; }
+        void setAgc(bool) override {}
+        std::string getDescription(void) override { return "counting"; }
+};
+
+TEST_CASE("Inputs account for dropped samples and overflows", "[input]") {
+    CountingInput input;
+    REQUIRE(input.getDiscontinuityCount() == 0);
+
+    input.deliver(1000, 1000);
+    input.deliver(1000, 400);
+    // Still the same overflow
+    input.deliver(1000, 0);
+    REQUIRE(input.getDiscontinuityCount() == 1);
+    input.deliver(1000, 1000);
+    input.deliver(1000, 999);
+    REQUIRE(input.getDiscontinuityCount() == 2);
+
+    auto stats = input.getInputStats();
+    REQUIRE(stats.samplesReceived == 5000);
+    REQUIRE(stats.samplesDropped == 1601);
+    REQUIRE(stats.overflows == 2);
+    REQUIRE(stats.lastSampleCount == 5000);
+    REQUIRE(stats.lastDelivery <= std::chrono::steady_clock::now());
+    REQUIRE(stats.longestStall < 1.0);
+
+    // A pause between deliveries is a stall, unless the input was restarted
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    input.deliver(10, 10);
+    stats = input.getInputStats();
+    REQUIRE(stats.longestStall >= 0.05);
+
+    const double longest = stats.longestStall;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    input.restartInput();
+    input.deliver(10, 10);
+    REQUIRE(input.getInputStats().longestStall == longest);
+}
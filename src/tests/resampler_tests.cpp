@@ -0,0 +1,220 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file resampler_tests.cpp
+ * @brief Tests for the fractional resampler feeding the OFDM processor
+ *        from devices that do not capture at 2.048 MS/s
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ *
+ * The benchmark is hidden, run it with: resampler_tests "[benchmark]"
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../input/resampler.h"
+#include "test_buffer_input.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Rates of common devices that cannot capture at INPUT_RATE
+static const std::vector<int> device_rates = {2500000, 3000000, 8000000, 10000000};
+
+// Largest deviation from the ideal tone at the output rate, skipping
+// the start-up of the filter
+static float tone_error(const std::vector<DSPCOMPLEX>& out,
+        double frequency, double rate, size_t skip)
+{
+    const auto expected = tone(frequency, rate, out.size());
+    float error = 0;
+    for (size_t n = skip; n < out.size(); n++) {
+        error = std::max(error, abs(out[n] - expected[n]));
+    }
+    return error;
+}
+
+static float peak(const std::vector<DSPCOMPLEX>& out, size_t skip)
+{
+    float level = 0;
+    for (size_t n = skip; n < out.size(); n++) {
+        level = std::max(level, abs(out[n]));
+    }
+    return level;
+}
+
+TEST_CASE("The DAB block passes at every device rate", "[resampler]") {
+    for (int rate : device_rates) {
+        for (double f : {0.0, -300000.0, 500000.0, -768000.0}) {
+            Resampler resampler(rate, INPUT_RATE);
+            std::vector<DSPCOMPLEX> out;
+            resampler.process(tone(f, rate, 50000).data(), 50000, out);
+
+            INFO("rate " << rate << " tone " << f);
+            REQUIRE(tone_error(out, f, INPUT_RATE, 100) < 0.01f);
+        }
+    }
+}
+
+TEST_CASE("What would alias onto the DAB block is rejected", "[resampler]") {
+    for (int rate : {3000000, 8000000, 10000000}) {
+        // Folds onto the DAB block at 2.048 MS/s
+        for (double f : {1400000.0, -1400000.0}) {
+            Resampler resampler(rate, INPUT_RATE);
+            std::vector<DSPCOMPLEX> out;
+            resampler.process(tone(f, rate, 50000).data(), 50000, out);
+
+            INFO("rate " << rate << " tone " << f);
+            REQUIRE(peak(out, 100) < 0.002f);
+        }
+    }
+}
+
+TEST_CASE("Up-sampling keeps the band", "[resampler]") {
+    Resampler resampler(1536000, INPUT_RATE);
+    std::vector<DSPCOMPLEX> out;
+    resampler.process(tone(500000, 1536000, 30000).data(), 30000, out);
+    REQUIRE(tone_error(out, 500000, INPUT_RATE, 100) < 0.01f);
+}
+
+TEST_CASE("The number of outputs follows the rate ratio", "[resampler]") {
+    for (int rate : device_rates) {
+        Resampler resampler(rate, INPUT_RATE);
+        std::vector<DSPCOMPLEX> out;
+        const size_t num = 1000000;
+        const std::vector<DSPCOMPLEX> in(10000);
+        for (size_t i = 0; i < num / in.size(); i++) {
+            resampler.process(in.data(), in.size(), out);
+        }
+
+        const double expected = (double)num * INPUT_RATE / rate;
+        INFO("rate " << rate);
+        REQUIRE(std::abs((double)out.size() - expected) <= resampler.getNumTaps());
+    }
+}
+
+TEST_CASE("The output does not depend on the chunking", "[resampler]") {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise;
+    std::vector<DSPCOMPLEX> in(40009);
+    for (auto& s : in) {
+        s = DSPCOMPLEX(noise(rng), noise(rng));
+    }
+
+    Resampler whole(2500000, INPUT_RATE);
+    std::vector<DSPCOMPLEX> expected;
+    whole.process(in.data(), in.size(), expected);
+
+    Resampler pieces(2500000, INPUT_RATE);
+    std::vector<DSPCOMPLEX> got;
+    std::uniform_int_distribution<size_t> length(0, 1000);
+    size_t pos = 0;
+    while (pos < in.size()) {
+        const size_t n = std::min(length(rng), in.size() - pos);
+        pieces.process(in.data() + pos, n, got);
+        pos += n;
+    }
+
+    REQUIRE(got.size() == expected.size());
+    for (size_t i = 0; i < got.size(); i++) {
+        REQUIRE(abs(got[i] - expected[i]) < 1e-5f);
+    }
+
+    // Starts over after a reset
+    pieces.reset();
+    std::vector<DSPCOMPLEX> again;
+    pieces.process(in.data(), in.size(), again);
+    REQUIRE(again == expected);
+}
+
+TEST_CASE("Inputs at the DAB rate are passed through", "[resampler]") {
+    const auto samples = tone(100000, INPUT_RATE, 5000);
+    BufferInput device(samples, INPUT_RATE);
+    ResamplingInput input(device);
+    REQUIRE_FALSE(input.isResampling());
+    REQUIRE(input.getSamplesToRead() == 5000);
+
+    std::vector<DSPCOMPLEX> out(5000);
+    REQUIRE(input.getSamples(out.data(), 5000) == 5000);
+    REQUIRE(out == samples);
+}
+
+TEST_CASE("Inputs at other rates are resampled", "[resampler]") {
+    const int rate = 2500000;
+    BufferInput device(tone(200000, rate, 100000), INPUT_RATE);
+    ResamplingInput input(device);
+    REQUIRE_FALSE(input.isResampling());
+
+    // The rate of a device is only certain once it runs
+    device.rate = rate;
+    REQUIRE(input.restart());
+    REQUIRE(input.isResampling());
+
+    std::vector<DSPCOMPLEX> out;
+    std::vector<DSPCOMPLEX> buffer(3000);
+    while (input.getSamplesToRead() > 0) {
+        const int32_t n = input.getSamples(buffer.data(), buffer.size());
+        out.insert(out.end(), buffer.begin(), buffer.begin() + n);
+    }
+
+    REQUIRE(std::abs((double)out.size() - 100000.0 * INPUT_RATE / rate) < 50);
+    REQUIRE(tone_error(out, 200000, INPUT_RATE, 100) < 0.01f);
+}
+
+TEST_CASE("Resampler CPU cost", "[.][benchmark]") {
+    using namespace std::chrono;
+
+    std::mt19937 rng(1);
+    std::normal_distribution<float> noise;
+    std::vector<DSPCOMPLEX> in(1 << 16);
+    for (auto& s : in) {
+        s = DSPCOMPLEX(noise(rng), noise(rng));
+    }
+
+    for (int rate : device_rates) {
+        Resampler resampler(rate, INPUT_RATE);
+        std::vector<DSPCOMPLEX> out;
+        out.reserve(in.size());
+
+        // One second of input
+        const size_t num = rate;
+        const auto start = steady_clock::now();
+        for (size_t done = 0; done < num; done += in.size()) {
+            out.clear();
+            resampler.process(in.data(), in.size(), out);
+        }
+        const double seconds = duration<double>(steady_clock::now() - start).count();
+
+        std::cout << "Resampler " << rate << " -> " << INPUT_RATE << " sps, " <<
+            resampler.getNumTaps() << " taps: " <<
+            seconds * 1e9 / num << " ns per input sample, " <<
+            1 / seconds << "x real time" << std::endl;
+        REQUIRE(seconds > 0);
+    }
+}
@@ -0,0 +1,279 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file rtl_tcp_tests.cpp
+ * @brief Tests for the rtl_tcp client against a loopback stand-in server
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../input/rtl_tcp.h"
+#include "test_radio_interface.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// The bytes of sample k
+static uint8_t sample_i(size_t k) { return k % 251; }
+static uint8_t sample_q(size_t k) { return (k * 7) % 256; }
+
+// Behaves like rtl_tcp: sends the dongle info, then streams samples in
+// chunks of an odd number of bytes, and records the commands it receives.
+class RtlTcpServer {
+    public:
+        struct Command {
+            uint8_t cmd;
+            uint32_t param;
+        };
+
+        RtlTcpServer(size_t num_samples) : num_samples(num_samples) {
+            REQUIRE(listener.bind(0));
+            REQUIRE(listener.listen());
+            port = listener.localPort();
+            thread = std::thread(&RtlTcpServer::run, this);
+        }
+
+        ~RtlTcpServer() {
+            running = false;
+            listener.shutdown();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                conn.shutdown();
+            }
+            thread.join();
+            if (command_thread.joinable()) {
+                command_thread.join();
+            }
+        }
+
+        std::vector<Command> commands() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return received;
+        }
+
+        int port = 0;
+
+    private:
+        void run() {
+            Socket s = listener.accept();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                conn = std::move(s);
+            }
+            if (not conn.valid()) {
+                return;
+            }
+
+            command_thread = std::thread(&RtlTcpServer::readCommands, this);
+
+            uint8_t info[12] = { 'R', 'T', 'L', '0' };
+            const uint32_t tuner = htonl(5); // R820T
+            const uint32_t gains = htonl(29);
+            memcpy(info + 4, &tuner, 4);
+            memcpy(info + 8, &gains, 4);
+            conn.send(info, sizeof(info), MSG_NOSIGNAL);
+
+            std::vector<uint8_t> stream(2 * num_samples);
+            for (size_t k = 0; k < num_samples; k++) {
+                stream[2 * k] = sample_i(k);
+                stream[2 * k + 1] = sample_q(k);
+            }
+
+            size_t sent = 0;
+            while (running and sent < stream.size()) {
+                const size_t n = std::min<size_t>(1001, stream.size() - sent);
+                const ssize_t ret = conn.send(stream.data() + sent, n, MSG_NOSIGNAL);
+                if (ret <= 0) {
+                    break;
+                }
+                sent += ret;
+            }
+        }
+
+        void readCommands() {
+            uint8_t c[5];
+            while (running) {
+                if (conn.recv(c, sizeof(c), MSG_WAITALL) != sizeof(c)) {
+                    break;
+                }
+                const uint32_t param = (c[1] << 24) | (c[2] << 16) | (c[3] << 8) | c[4];
+                std::lock_guard<std::mutex> lock(mutex);
+                received.push_back({c[0], param});
+            }
+        }
+
+        const size_t num_samples;
+        std::atomic<bool> running = ATOMIC_VAR_INIT(true);
+        Socket listener;
+        Socket conn;
+        std::mutex mutex;
+        std::vector<Command> received;
+        std::thread thread;
+        std::thread command_thread;
+};
+
+TEST_CASE("Samples arrive complete and in order", "[rtltcp]") {
+    // More than the half of the buffer that is filled before the release
+    RtlTcpServer server(3000000);
+    TestRadioInterface ri;
+    CRTL_TCP_Client client(ri);
+    client.setServerAddress("127.0.0.1");
+    client.setPort(server.port);
+    REQUIRE(client.restart());
+
+    std::vector<DSPCOMPLEX> buf(2048);
+    size_t k = 0;
+    const auto deadline = steady_clock::now() + seconds(10);
+    while (k < 200000 and steady_clock::now() < deadline) {
+        const int32_t available = client.getSamplesToRead();
+        if (available == 0) {
+            std::this_thread::sleep_for(milliseconds(1));
+            continue;
+        }
+
+        const int32_t n = client.getSamples(buf.data(), std::min<int32_t>(available, buf.size()));
+        for (int32_t i = 0; i < n; i++, k++) {
+            const DSPCOMPLEX expected((sample_i(k) - 128) / 128.0f, (sample_q(k) - 128) / 128.0f);
+            REQUIRE(buf[i] == expected);
+        }
+    }
+    REQUIRE(k >= 200000);
+}
+
+TEST_CASE("Samples are released at the nominal rate", "[rtltcp]") {
+    RtlTcpServer server(3000000);
+    TestRadioInterface ri;
+    CRTL_TCP_Client client(ri);
+    client.setServerAddress("127.0.0.1");
+    client.setPort(server.port);
+    REQUIRE(client.restart());
+
+    // Wait for the release, then read as fast as possible for 200 ms
+    const auto deadline = steady_clock::now() + seconds(10);
+    while (client.getSamplesToRead() == 0 and steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+
+    std::vector<DSPCOMPLEX> buf(INPUT_RATE);
+    size_t read = 0;
+    const auto start = steady_clock::now();
+    while (steady_clock::now() - start < milliseconds(200)) {
+        const int32_t available = client.getSamplesToRead();
+        read += client.getSamples(buf.data(), std::min<int32_t>(available, buf.size()));
+    }
+    const duration<double> elapsed = steady_clock::now() - start;
+
+    const double expected = elapsed.count() * INPUT_RATE;
+    REQUIRE(read > 0.8 * expected);
+    REQUIRE(read < 1.2 * expected + 2048);
+}
+
+TEST_CASE("Overflows are located behind the buffered samples", "[rtltcp]") {
+    // Twice the buffer, which is not read until it overflowed
+    RtlTcpServer server(8000000);
+    TestRadioInterface ri;
+    CRTL_TCP_Client client(ri);
+    client.setServerAddress("127.0.0.1");
+    client.setPort(server.port);
+    REQUIRE(client.restart());
+
+    const auto deadline = steady_clock::now() + seconds(10);
+    while (client.getInputStats().samplesReceived < 8000000 and
+            steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    const auto stats = client.getInputStats();
+    REQUIRE(stats.samplesReceived == 8000000);
+    REQUIRE(stats.overflows == 1);
+
+    // The reserve is held back, but the gap is only after all of it
+    const int64_t before = client.getSamplesBeforeDiscontinuity();
+    REQUIRE(before > client.getSamplesToRead());
+    REQUIRE(before == (int64_t)(stats.samplesReceived - stats.samplesDropped));
+
+    // Up to there the samples are continuous
+    std::vector<DSPCOMPLEX> buf(65536);
+    int64_t k = 0;
+    size_t wrong = 0;
+    while (k < before) {
+        const int32_t n = client.getSamples(buf.data(),
+                std::min<int64_t>(before - k, buf.size()));
+        REQUIRE(n > 0);
+        for (int32_t i = 0; i < n; i++, k++) {
+            const DSPCOMPLEX expected((sample_i(k) - 128) / 128.0f, (sample_q(k) - 128) / 128.0f);
+            wrong += buf[i] != expected;
+        }
+        REQUIRE(client.getSamplesBeforeDiscontinuity() == before - k);
+    }
+    REQUIRE(wrong == 0);
+}
+
+TEST_CASE("Client configures the dongle", "[rtltcp]") {
+    RtlTcpServer server(100000);
+    TestRadioInterface ri;
+    CRTL_TCP_Client client(ri);
+    client.setServerAddress("127.0.0.1");
+    client.setPort(server.port);
+    client.setFrequency(227360000);
+    REQUIRE(client.restart());
+    REQUIRE(client.getGainCount() == 29);
+
+    bool have_rate = false;
+    bool have_frequency = false;
+    for (const auto& c : server.commands()) {
+        if (c.cmd == 0x02 and c.param == INPUT_RATE) {
+            have_rate = true;
+        }
+        if (c.cmd == 0x01 and c.param == 227360000) {
+            have_frequency = true;
+        }
+    }
+    REQUIRE(have_rate);
+    REQUIRE(have_frequency);
+}
+
+TEST_CASE("Destruction joins the threads promptly", "[rtltcp]") {
+    RtlTcpServer server(20000000);
+    TestRadioInterface ri;
+    auto client = std::make_unique<CRTL_TCP_Client>(ri);
+    client->setServerAddress("127.0.0.1");
+    client->setPort(server.port);
+    REQUIRE(client->restart());
+    REQUIRE(client->is_ok());
+
+    const auto start = steady_clock::now();
+    client.reset();
+    REQUIRE(steady_clock::now() - start < seconds(1));
+}
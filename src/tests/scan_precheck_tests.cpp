@@ -0,0 +1,177 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file scan_precheck_tests.cpp
+ * @brief Tests for the precheck that rejects empty channels while scanning
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ *
+ * The benchmark is hidden, run it with: scan_precheck_tests "[benchmark]"
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/scan-precheck.h"
+#include "../input/ensemble_generator.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static std::vector<DSPCOMPLEX> white_noise(size_t num, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> dist(0, 0.1f);
+    std::vector<DSPCOMPLEX> out(num);
+    for (auto& s : out) {
+        s = DSPCOMPLEX(dist(rng), dist(rng));
+    }
+    return out;
+}
+
+// Noise with the spectrum of an ensemble, but without its structure
+static std::vector<DSPCOMPLEX> band_noise(const DABParams& params, size_t num, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> dist(0, 1);
+    fft::Backward ifft(params.T_u);
+    std::vector<DSPCOMPLEX> out;
+    while (out.size() < num) {
+        DSPCOMPLEX *v = ifft.getVector();
+        for (int i = 0; i < params.T_u; i++) {
+            const int k = i < params.T_u / 2 ? i : i - params.T_u;
+            const bool carrier = k != 0 and std::abs(k) <= params.K / 2;
+            v[i] = carrier ? DSPCOMPLEX(dist(rng), dist(rng)) : DSPCOMPLEX(0, 0);
+        }
+        ifft.do_IFFT();
+        out.insert(out.end(), v, v + params.T_u);
+    }
+    out.resize(num);
+    return out;
+}
+
+static std::vector<DSPCOMPLEX> ensemble(size_t num, float snr, float offset, size_t skip)
+{
+    auto config = EnsembleGenerator::makeConfig(2, 48);
+    config.noise = true;
+    config.snr = snr;
+    config.frequencyOffset = offset;
+    EnsembleGenerator generator(config);
+
+    // Start somewhere in a frame
+    std::vector<DSPCOMPLEX> out(skip);
+    generator.getSamples(out.data(), out.size());
+    out.resize(num);
+    generator.getSamples(out.data(), out.size());
+    return out;
+}
+
+TEST_CASE("Empty channels fail the energy test", "[scanprecheck]") {
+    DABParams params(1);
+    ScanPrecheck precheck(params);
+
+    const auto noise = white_noise(precheck.totalSamples(), 1);
+    const auto r = precheck.checkEnergy(noise.data());
+    REQUIRE_FALSE(r.energyFound);
+    REQUIRE(r.bandRatio < ScanPrecheck::MIN_BAND_RATIO);
+    REQUIRE_FALSE(precheck.check(noise.data()).signalPresent());
+
+    // Nothing at all
+    const std::vector<DSPCOMPLEX> zeros(precheck.totalSamples());
+    REQUIRE_FALSE(precheck.check(zeros.data()).signalPresent());
+}
+
+TEST_CASE("Energy in the band is not enough", "[scanprecheck]") {
+    DABParams params(1);
+    ScanPrecheck precheck(params);
+
+    auto noise = band_noise(params, precheck.totalSamples(), 2);
+    auto r = precheck.check(noise.data());
+    REQUIRE(r.energyFound);
+    REQUIRE_FALSE(r.prsFound);
+
+    // With a gap like a NULL symbol, the correlation runs and finds nothing
+    std::fill(noise.begin() + 70000, noise.begin() + 70000 + params.T_null, DSPCOMPLEX(0, 0));
+    r = precheck.check(noise.data());
+    REQUIRE(r.energyFound);
+    REQUIRE(r.prsRatio > 0);
+    REQUIRE(r.prsRatio < ScanPrecheck::MIN_PRS_RATIO);
+}
+
+TEST_CASE("Ensembles pass the precheck", "[scanprecheck]") {
+    DABParams params(1);
+    ScanPrecheck precheck(params);
+
+    struct Case { float snr; float offset; size_t skip; };
+    const std::vector<Case> cases = {
+        {30, 0, 0},
+        {10, 0, 50000},
+        // Up to the range of the coarse corrector
+        {10, 12500, 120000},
+        {10, -30000, 190000},
+        {3, 2000, 7000},
+    };
+
+    for (const auto& c : cases) {
+        const auto samples = ensemble(precheck.totalSamples(), c.snr, c.offset, c.skip);
+        const auto r = precheck.check(samples.data());
+        INFO("SNR " << c.snr << " offset " << c.offset << " skip " << c.skip <<
+                ": band ratio " << r.bandRatio << ", PRS ratio " << r.prsRatio);
+        REQUIRE(r.energyFound);
+        REQUIRE(r.prsFound);
+        REQUIRE(r.signalPresent());
+    }
+}
+
+TEST_CASE("Scan precheck duration", "[.][benchmark]") {
+    using namespace std::chrono;
+    DABParams params(1);
+    ScanPrecheck precheck(params);
+
+    const auto noise = white_noise(precheck.totalSamples(), 3);
+    const auto signal = ensemble(precheck.totalSamples(), 10, 1000, 0);
+
+    const int runs = 20;
+    auto start = steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        precheck.check(noise.data());
+    }
+    const auto noise_time = duration<double, std::micro>(steady_clock::now() - start) / runs;
+
+    start = steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        precheck.check(signal.data());
+    }
+    const auto signal_time = duration<double, std::micro>(steady_clock::now() - start) / runs;
+
+    const double sample_ms = 1000.0 / INPUT_RATE;
+    std::cout << "Empty channel: " << precheck.energySamples() * sample_ms <<
+        " ms of samples, " << noise_time.count() << " us CPU" << std::endl;
+    std::cout << "Ensemble: " << precheck.totalSamples() * sample_ms <<
+        " ms of samples, " << signal_time.count() << " us CPU" << std::endl;
+}
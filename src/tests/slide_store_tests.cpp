@@ -0,0 +1,227 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file slide_store_tests.cpp
+ * @brief Tests for the content-addressed slide store of welle-cli
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../welle-cli/slidestore.h"
+#include <cstdlib>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+static const int JPEG = 0x01;
+static const int PNG = 0x03;
+
+static std::vector<uint8_t> make_slide(uint8_t value, size_t size = 1000)
+{
+    return std::vector<uint8_t>(size, value);
+}
+
+// Paths of the files in dir
+static std::vector<std::string> list_files(const std::string& dir)
+{
+    std::vector<std::string> files;
+    DIR *d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return files;
+    }
+    while (const struct dirent *e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (name != "." and name != "..") {
+            files.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    return files;
+}
+
+TEST_CASE("Hash depends on content and length", "[slidestore]") {
+    const auto a = SlideStore::hash(make_slide(1));
+    REQUIRE(a == SlideStore::hash(make_slide(1)));
+    REQUIRE(a != SlideStore::hash(make_slide(2)));
+    REQUIRE(a != SlideStore::hash(make_slide(1, 1001)));
+
+    // FNV-1a of the empty input is the offset basis
+    REQUIRE(SlideStore::hash({}) == "cbf29ce484222325-0");
+}
+
+TEST_CASE("Repeated and shared slides are stored once", "[slidestore]") {
+    SlideStore store;
+    const auto t0 = system_clock::now();
+
+    auto a = store.add(0x1234, make_slide(1), JPEG, "a.jpg", t0);
+    REQUIRE(a->info.content_type == "image/jpeg");
+    REQUIRE(a->etag() == "\"" + a->info.hash + "\"");
+
+    // Carousel repetition
+    auto b = store.add(0x1234, make_slide(1), JPEG, "a.jpg", t0 + seconds(10));
+    REQUIRE(a == b);
+
+    // Same slide on another service
+    auto c = store.add(0x5678, make_slide(1), JPEG, "a.jpg", t0 + seconds(20));
+    REQUIRE(a == c);
+
+    REQUIRE(store.getNumSlides() == 1);
+    REQUIRE(store.getMemoryUsage() == 1000);
+
+    const auto history = store.getHistory();
+    REQUIRE(history.size() == 2);
+    REQUIRE(history.at(0x1234).size() == 1);
+    REQUIRE(history.at(0x1234)[0].time == t0);
+    REQUIRE(history.at(0x5678)[0].available);
+}
+
+TEST_CASE("History is newest first and bounded", "[slidestore]") {
+    SlideStore store;
+    const auto t0 = system_clock::now();
+
+    const size_t n = SlideStore::HISTORY_LENGTH + 4;
+    for (size_t i = 0; i < n; i++) {
+        store.add(1, make_slide(i), PNG, "", t0 + seconds(i));
+    }
+
+    const auto history = store.getHistory().at(1);
+    REQUIRE(history.size() == SlideStore::HISTORY_LENGTH);
+    REQUIRE(history.front().info.hash == SlideStore::hash(make_slide(n - 1)));
+    REQUIRE(history.back().info.hash == SlideStore::hash(make_slide(4)));
+
+    // Slides that fell out of every history are forgotten
+    REQUIRE(store.getNumSlides() == SlideStore::HISTORY_LENGTH);
+    REQUIRE(store.get(SlideStore::hash(make_slide(0))) == nullptr);
+    REQUIRE(store.get(SlideStore::hash(make_slide(4))) != nullptr);
+
+    store.clear();
+    REQUIRE(store.getNumSlides() == 0);
+    REQUIRE(store.getMemoryUsage() == 0);
+    REQUIRE(store.getHistory().empty());
+}
+
+TEST_CASE("Memory limit drops old slides but keeps current ones", "[slidestore]") {
+    SlideStore store(2500);
+    const auto t0 = system_clock::now();
+
+    store.add(1, make_slide(1), JPEG, "", t0);
+    store.add(1, make_slide(2), JPEG, "", t0 + seconds(1));
+    store.add(2, make_slide(3), JPEG, "", t0 + seconds(2));
+    REQUIRE(store.getMemoryUsage() == 2000);
+
+    // Slide 1 is the least recently used one that is not current
+    store.add(2, make_slide(4), JPEG, "", t0 + seconds(3));
+    REQUIRE(store.getMemoryUsage() == 2000);
+    REQUIRE(store.get(SlideStore::hash(make_slide(1))) == nullptr);
+    REQUIRE(store.get(SlideStore::hash(make_slide(2))) != nullptr);
+
+    const auto history = store.getHistory().at(1);
+    REQUIRE(history.size() == 2);
+    REQUIRE(history[0].available);
+    REQUIRE_FALSE(history[1].available);
+
+    // Current slides are kept even above the limit
+    store.add(3, make_slide(5), JPEG, "", t0 + seconds(4));
+    store.add(4, make_slide(6), JPEG, "", t0 + seconds(5));
+    REQUIRE(store.get(SlideStore::hash(make_slide(2))) != nullptr);
+    REQUIRE(store.get(SlideStore::hash(make_slide(4))) != nullptr);
+    REQUIRE(store.get(SlideStore::hash(make_slide(5))) != nullptr);
+    REQUIRE(store.get(SlideStore::hash(make_slide(6))) != nullptr);
+    REQUIRE(store.getMemoryUsage() == 4000);
+}
+
+TEST_CASE("Evicted slides are spilled to disk", "[slidestore]") {
+    char dir_template[] = "/tmp/slide_store_testXXXXXX";
+    const char *dir = mkdtemp(dir_template);
+    REQUIRE(dir != nullptr);
+
+    {
+        SlideStore store(1500, dir);
+        const auto t0 = system_clock::now();
+
+        store.add(1, make_slide(1), PNG, "one.png", t0);
+        store.add(1, make_slide(2), PNG, "two.png", t0 + seconds(1));
+        REQUIRE(store.getMemoryUsage() == 1000);
+
+        const auto hash = SlideStore::hash(make_slide(1));
+        const auto files = list_files(dir);
+        REQUIRE(files.size() == 1);
+        const std::string& path = files[0];
+        const std::string suffix = hash + ".png";
+        REQUIRE(path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0);
+
+        const auto slide = store.get(hash);
+        REQUIRE(slide != nullptr);
+        REQUIRE(slide->data == make_slide(1));
+        REQUIRE(slide->info.content_name == "one.png");
+        REQUIRE(store.getHistory().at(1)[1].available);
+
+        // Reading a spilled slide does not take it back into memory
+        REQUIRE(store.getMemoryUsage() == 1000);
+
+        // The file goes away with the last reference to the slide
+        store.clear();
+        REQUIRE(access(path.c_str(), F_OK) != 0);
+    }
+
+    REQUIRE(rmdir(dir) == 0);
+}
+
+TEST_CASE("Stores sharing the spill directory keep their own files", "[slidestore]") {
+    char dir_template[] = "/tmp/slide_store_testXXXXXX";
+    const char *dir = mkdtemp(dir_template);
+    REQUIRE(dir != nullptr);
+
+    {
+        SlideStore store_a(1500, dir);
+        SlideStore store_b(1500, dir);
+        const auto t0 = system_clock::now();
+
+        // Both spill the same slide
+        for (auto *store : { &store_a, &store_b }) {
+            store->add(1, make_slide(1), PNG, "one.png", t0);
+            store->add(1, make_slide(2), PNG, "two.png", t0 + seconds(1));
+        }
+        REQUIRE(list_files(dir).size() == 2);
+
+        const auto hash = SlideStore::hash(make_slide(1));
+        store_a.clear();
+        REQUIRE(store_a.get(hash) == nullptr);
+
+        const auto slide = store_b.get(hash);
+        REQUIRE(slide != nullptr);
+        REQUIRE(slide->data == make_slide(1));
+    }
+
+    REQUIRE(list_files(dir).empty());
+    REQUIRE(rmdir(dir) == 0);
+}
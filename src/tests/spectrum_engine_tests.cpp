@@ -0,0 +1,181 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file spectrum_engine_tests.cpp
+ * @brief Tests for the Welch spectrum estimate behind /spectrum and the
+ *        dB approximation it uses
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../various/spectrum_engine.h"
+#include "../various/MathHelper.h"
+#include "test_buffer_input.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+static const int N = 256;
+
+// A tone in the middle of bin k, scaled by amplitude
+static SpectrumEngine::SampleSource tone_source(int k, const float& amplitude)
+{
+    return [k, &amplitude](int num_samples) {
+        auto samples = tone(k, N, num_samples);
+        for (auto& s : samples) {
+            s *= amplitude;
+        }
+        return samples;
+    };
+}
+
+// Power of a tone of amplitude 1 in the middle of a bin: the Hann window
+// halves the magnitude N of the unwindowed FFT, and the window scale
+// N / sum(w^2) = 8/3 restores the noise power
+static const double TONE_POWER = (N / 2.0) * (N / 2.0) * 8.0 / 3.0;
+
+TEST_CASE("A tone gives one peak of the expected power", "[spectrum]") {
+    const float amplitude = 1.0f;
+    SpectrumEngine engine(N, tone_source(20, amplitude));
+    engine.update();
+
+    const auto snapshot = engine.getSnapshot();
+    REQUIRE(snapshot->generation == 1);
+    REQUIRE(snapshot->power.size() == (size_t)N);
+    REQUIRE(snapshot->power_db.size() == (size_t)N);
+    REQUIRE(snapshot->null_power.empty());
+
+    // DC is in the middle
+    const int peak = N / 2 + 20;
+    REQUIRE(snapshot->power[peak] == Approx(TONE_POWER).epsilon(0.001));
+    REQUIRE(snapshot->power_db[peak] == Approx(10 * log10(TONE_POWER)).margin(0.01));
+
+    // The Hann window leaks half the magnitude of the peak into the
+    // neighbours, and nothing into the other bins
+    REQUIRE(snapshot->power[peak - 1] == Approx(TONE_POWER / 4).epsilon(0.001));
+    REQUIRE(snapshot->power[peak + 1] == Approx(TONE_POWER / 4).epsilon(0.001));
+    for (int i = 0; i < N; i++) {
+        if (abs(i - peak) > 1) {
+            REQUIRE(snapshot->power_db[i] < snapshot->power_db[peak] - 80);
+        }
+    }
+}
+
+TEST_CASE("Successive estimates are averaged", "[spectrum]") {
+    float amplitude = 1.0f;
+    SpectrumEngine engine(N, tone_source(-30, amplitude), milliseconds(100), 4, 0.2f);
+    const int peak = N / 2 - 30;
+
+    engine.update();
+    REQUIRE(engine.getSnapshot()->power[peak] == Approx(TONE_POWER).epsilon(0.001));
+
+    // Four times the power moves the average by a fifth of the step
+    amplitude = 2.0f;
+    engine.update();
+    REQUIRE(engine.getSnapshot()->power[peak] == Approx(1.6 * TONE_POWER).epsilon(0.001));
+
+    engine.reset();
+    REQUIRE(engine.getSnapshot()->power.empty());
+    engine.update();
+    REQUIRE(engine.getSnapshot()->power[peak] == Approx(4 * TONE_POWER).epsilon(0.001));
+}
+
+TEST_CASE("NULL symbols are transformed once", "[spectrum]") {
+    SpectrumEngine engine(N, [](int) { return std::vector<DSPCOMPLEX>(); });
+
+    engine.setNullSymbol(tone(10, N, N));
+    engine.update();
+    const auto snapshot = engine.getSnapshot();
+    REQUIRE(snapshot->power.empty());
+    REQUIRE(snapshot->null_power.size() == (size_t)N);
+    REQUIRE(snapshot->null_power[N / 2 + 10] == Approx(TONE_POWER).epsilon(0.001));
+
+    // Nothing new, no new snapshot
+    engine.update();
+    REQUIRE(engine.getSnapshot()->generation == snapshot->generation);
+}
+
+TEST_CASE("The thread started on demand stops when nobody looks", "[spectrum]") {
+    std::atomic<int> updates(0);
+    SpectrumEngine engine(N, [&](int num_samples) {
+                updates++;
+                return tone(10, N, num_samples);
+            }, milliseconds(10));
+    engine.startOnDemand(milliseconds(200));
+
+    std::this_thread::sleep_for(milliseconds(100));
+    REQUIRE(updates == 0);
+
+    // The first request starts the thread and gets an empty snapshot
+    REQUIRE(engine.getSnapshot()->power.empty());
+    const auto deadline = steady_clock::now() + seconds(5);
+    while (engine.getSnapshot()->power.empty() and steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    REQUIRE_FALSE(engine.getSnapshot()->power.empty());
+
+    // Idle, the averages are forgotten
+    std::this_thread::sleep_for(milliseconds(500));
+    const int idle_updates = updates;
+    std::this_thread::sleep_for(milliseconds(300));
+    REQUIRE(updates == idle_updates);
+    REQUIRE(engine.getSnapshot()->power.empty());
+
+    // And the next request starts it again
+    while (updates == idle_updates and steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+    REQUIRE(updates > idle_updates);
+}
+
+TEST_CASE("fast_10log10 is within 0.001 dB", "[spectrum]") {
+    float max_error = 0;
+    // All exponents of normal floats, several mantissas each
+    for (int e = -126; e <= 127; e++) {
+        for (int m = 0; m < 64; m++) {
+            const float x = std::ldexp(1.0f + m / 64.0f, e);
+            if (std::isinf(x)) {
+                continue;
+            }
+            const double exact = 10 * std::log10((double)x);
+            max_error = std::max(max_error, (float)std::abs(fast_10log10(x) - exact));
+        }
+    }
+    REQUIRE(max_error < 0.001f);
+
+    REQUIRE(fast_10log10(1.0f) == Approx(0.0f).margin(0.001));
+    REQUIRE(fast_10log10(0.0f) == -200.0f);
+    REQUIRE(fast_10log10(-1.0f) == -200.0f);
+    REQUIRE(fast_10log10(std::numeric_limits<float>::quiet_NaN()) == -200.0f);
+}
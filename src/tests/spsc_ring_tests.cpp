@@ -0,0 +1,226 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file spsc_ring_tests.cpp
+ * @brief Tests for the SPSC ring used by the input drivers and DabAudio,
+ *        with a throughput comparison against the older RingBuffer
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../various/spsc_ring.h"
+#include "../various/ringbuffer.h"
+#include <chrono>
+#include <complex>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Capacity is rounded up to a power of two", "[spscring]") {
+    SpscRing<uint8_t> ring(1000);
+    REQUIRE(ring.capacity() == 1024);
+    REQUIRE(ring.writeAvailable() == 1024);
+    REQUIRE(ring.readAvailable() == 0);
+}
+
+TEST_CASE("Push drops what does not fit", "[spscring]") {
+    SpscRing<int> ring(8);
+    std::vector<int> in(10);
+    for (int i = 0; i < 10; i++) in[i] = i;
+
+    REQUIRE(ring.push(in.data(), in.size()) == 8);
+    REQUIRE(ring.readAvailable() == 8);
+    REQUIRE(ring.writeAvailable() == 0);
+
+    std::vector<int> out(10);
+    REQUIRE(ring.pop(out.data(), out.size()) == 8);
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(out[i] == i);
+    }
+}
+
+TEST_CASE("Data wraps around the end of the storage", "[spscring]") {
+    for (const bool mirrored : {false, true}) {
+        // Large enough for the mirror to be possible with 4k pages
+        SpscRing<uint32_t> ring(4096, mirrored);
+        std::vector<uint32_t> in(3000), out(3000);
+        uint32_t next = 0;
+        uint32_t expected = 0;
+
+        for (int round = 0; round < 10; round++) {
+            for (auto& v : in) v = next++;
+            REQUIRE(ring.push(in.data(), in.size()) == in.size());
+            REQUIRE(ring.pop(out.data(), out.size()) == out.size());
+            for (auto v : out) {
+                REQUIRE(v == expected++);
+            }
+        }
+    }
+}
+
+TEST_CASE("Mirrored spans are contiguous across the wrap", "[spscring]") {
+    SpscRing<uint8_t> ring(4096, true);
+    if (not ring.isMirrored()) {
+        WARN("Mirrored ring not supported on this system");
+        return;
+    }
+
+    std::vector<uint8_t> data(3000, 1);
+    ring.push(data.data(), data.size());
+    ring.skip(data.size());
+
+    // Starts at offset 3000, ends after the wrap
+    auto w = ring.reserve(2000);
+    REQUIRE(w.size == 2000);
+    for (size_t i = 0; i < w.size; i++) {
+        w[i] = i & 0xFF;
+    }
+    ring.commit(w.size);
+
+    auto r = ring.peek(2000);
+    REQUIRE(r.size == 2000);
+    for (size_t i = 0; i < r.size; i++) {
+        REQUIRE(r[i] == (i & 0xFF));
+    }
+    ring.consume(r.size);
+    REQUIRE(ring.readAvailable() == 0);
+}
+
+TEST_CASE("Plain spans stop at the end of the storage", "[spscring]") {
+    SpscRing<uint8_t> ring(16, false);
+    std::vector<uint8_t> data(12);
+    ring.push(data.data(), data.size());
+    ring.skip(data.size());
+
+    auto w = ring.reserve(8);
+    REQUIRE(w.size == 4);
+    ring.commit(w.size);
+    w = ring.reserve(4);
+    REQUIRE(w.size == 4);
+    ring.commit(w.size);
+    REQUIRE(ring.readAvailable() == 8);
+}
+
+TEST_CASE("Flush discards everything written so far", "[spscring]") {
+    SpscRing<int> ring(16);
+    std::vector<int> in = {1, 2, 3, 4};
+    ring.push(in.data(), in.size());
+    ring.flush();
+    REQUIRE(ring.readAvailable() == 0);
+
+    in = {5, 6};
+    ring.push(in.data(), in.size());
+    std::vector<int> out(4);
+    REQUIRE(ring.pop(out.data(), out.size()) == 2);
+    REQUIRE(out[0] == 5);
+    REQUIRE(ring.writeAvailable() == 16);
+}
+
+TEST_CASE("Producer and consumer threads see every element in order", "[spscring]") {
+    SpscRing<uint64_t> ring(1024, true);
+    constexpr uint64_t total = 2000000;
+
+    std::thread producer([&]() {
+            uint64_t next = 0;
+            while (next < total) {
+                auto s = ring.reserve(std::min<uint64_t>(256, total - next));
+                for (auto& v : s) {
+                    v = next++;
+                }
+                ring.commit(s.size);
+            }
+        });
+
+    uint64_t expected = 0;
+    bool in_order = true;
+    while (expected < total) {
+        auto s = ring.peek(256);
+        for (auto v : s) {
+            in_order &= (v == expected++);
+        }
+        ring.consume(s.size);
+    }
+    producer.join();
+    REQUIRE(in_order);
+}
+
+// Push blocks of IQ samples through the ring from one thread to another,
+// the way the input drivers do, and return the throughput in MS/s.
+template <class Push, class Pop>
+static double measure_throughput(Push push, Pop pop, size_t block)
+{
+    using DSPCOMPLEX = std::complex<float>;
+    constexpr size_t total = 1 << 24;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+            std::vector<DSPCOMPLEX> in(block, DSPCOMPLEX(1, -1));
+            size_t sent = 0;
+            while (sent < total) {
+                sent += push(in.data(), block);
+            }
+        });
+
+    std::vector<DSPCOMPLEX> out(block);
+    size_t received = 0;
+    while (received < total) {
+        received += pop(out.data(), block);
+    }
+    producer.join();
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return total / elapsed.count() / 1e6;
+}
+
+TEST_CASE("Throughput compared to RingBuffer", "[spscring][performance]") {
+    using DSPCOMPLEX = std::complex<float>;
+    constexpr size_t capacity = 16 * 32768;
+    constexpr size_t block = 2048;
+
+    RingBuffer<DSPCOMPLEX> old_ring(capacity);
+    const double old_msps = measure_throughput(
+            [&](const DSPCOMPLEX *d, size_t n) {
+                return (size_t)old_ring.putDataIntoBuffer(d, n); },
+            [&](DSPCOMPLEX *d, size_t n) {
+                return (size_t)old_ring.getDataFromBuffer(d, n); },
+            block);
+
+    SpscRing<DSPCOMPLEX> new_ring(capacity, true);
+    const double new_msps = measure_throughput(
+            [&](const DSPCOMPLEX *d, size_t n) { return new_ring.push(d, n); },
+            [&](DSPCOMPLEX *d, size_t n) { return new_ring.pop(d, n); },
+            block);
+
+    std::cout << "RingBuffer: " << old_msps << " MS/s, SpscRing: " <<
+        new_msps << " MS/s (mirrored: " << new_ring.isMirrored() << ")" << std::endl;
+
+    REQUIRE(old_msps > 0);
+    REQUIRE(new_msps > 0);
+}
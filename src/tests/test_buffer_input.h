@@ -0,0 +1,93 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TEST_BUFFER_INPUT_H
+#define TEST_BUFFER_INPUT_H
+
+#include "../input/virtual_input.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Complex tone of the given frequency, at the given sample rate
+inline std::vector<DSPCOMPLEX> tone(double frequency, double rate, size_t num)
+{
+    std::vector<DSPCOMPLEX> out(num);
+    for (size_t n = 0; n < num; n++) {
+        const double phase = 2 * M_PI * fmod(frequency * n / rate, 1.0);
+        out[n] = DSPCOMPLEX(cos(phase), sin(phase));
+    }
+    return out;
+}
+
+/* Device playing a buffer once, at any rate. It counts the restarts and
+ * stops, and can lose samples like an overflowing device. */
+class BufferInput : public CVirtualInput {
+    public:
+        BufferInput(std::vector<DSPCOMPLEX> samples, int rate) :
+            rate(rate), samples(std::move(samples)) {}
+
+        // Lose samples like an overflowing device
+        void drop(size_t num) { countSamples(num, 0); }
+
+        CDeviceID getID(void) override { return CDeviceID::NULLDEVICE; }
+        int getSampleRate(void) const override { return rate; }
+        void setFrequency(int f) override { frequency = f; }
+        int getFrequency(void) const override { return frequency; }
+        bool is_ok(void) override { return true; }
+        bool restart(void) override { restarts++; return true; }
+        void stop(void) override { stops++; }
+        void reset(void) override {}
+        int32_t getSamples(DSPCOMPLEX *buf, int32_t size) override {
+            const size_t num = std::min<size_t>(size, samples.size() - position);
+            std::copy(samples.begin() + position, samples.begin() + position + num, buf);
+            position += num;
+            return num;
+        }
+        std::vector<DSPCOMPLEX> getSpectrumSamples(int) override { return {}; }
+        int32_t getSamplesToRead(void) override { return samples.size() - position; }
+        float setGain(int g) override { gain = g; return g; }
+        float getGain(void) const override { return gain; }
+        int getGainCount(void) override { return 10; }
+        void setAgc(bool) override {}
+        std::string getDescription(void) override { return "buffer"; }
+
+        // Like a device that is only certain of its rate once it runs,
+        // to be changed before restart()
+        int rate;
+
+        std::atomic<int> restarts = ATOMIC_VAR_INIT(0);
+        std::atomic<int> stops = ATOMIC_VAR_INIT(0);
+
+    private:
+        std::vector<DSPCOMPLEX> samples;
+        std::atomic<size_t> position = ATOMIC_VAR_INIT(0);
+        int frequency = 0;
+        int gain = 0;
+};
+
+#endif
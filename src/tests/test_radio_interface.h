@@ -0,0 +1,65 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TEST_RADIO_INTERFACE_H
+#define TEST_RADIO_INTERFACE_H
+
+#include "../backend/radio-controller.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+/* The RadioControllerInterface of the backend tests. It ignores the
+ * events, except for counting the FIBs, the detected services and the
+ * service restarts. The counters can be read while the backend threads
+ * call it. Tests that look at other events derive from it and override
+ * them. */
+class TestRadioInterface : public RadioControllerInterface {
+    public:
+        void onSNR(float) override {}
+        void onFrequencyCorrectorChange(int, int) override {}
+        void onSyncChange(char) override {}
+        void onSignalPresence(bool) override {}
+        void onServiceDetected(uint32_t) override { servicesDetected++; }
+        void onNewEnsemble(uint16_t) override {}
+        void onSetEnsembleLabel(DabLabel&) override {}
+        void onDateTimeUpdate(const dab_date_time_t&) override {}
+        void onFIBDecodeSuccess(bool crcCheckOk, const uint8_t*) override {
+            (crcCheckOk ? fibsOk : fibsFailed)++;
+        }
+        void onNewImpulseResponse(std::vector<float>&&) override {}
+        void onConstellationPoints(std::vector<DSPCOMPLEX>&&) override {}
+        void onNewNullSymbol(std::vector<DSPCOMPLEX>&&) override {}
+        void onTIIMeasurement(tii_measurement_t&&) override {}
+        void onMessage(message_level_t, const std::string&, const std::string&) override {}
+        void onRestartService(void) override { restarts++; }
+
+        std::atomic<int> fibsOk = ATOMIC_VAR_INIT(0);
+        std::atomic<int> fibsFailed = ATOMIC_VAR_INIT(0);
+        std::atomic<int> servicesDetected = ATOMIC_VAR_INIT(0);
+        std::atomic<int> restarts = ATOMIC_VAR_INIT(0);
+};
+
+#endif
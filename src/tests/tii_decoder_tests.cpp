@@ -0,0 +1,190 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file tii_decoder_tests.cpp
+ * @brief Tests for the delay estimation of the TII decoder
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/tii-decoder.h"
+#include "../various/fft.h"
+#include "test_radio_interface.h"
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+class TiiRadioInterface : public TestRadioInterface {
+    public:
+        void onTIIMeasurement(tii_measurement_t&& m) override {
+            std::lock_guard<std::mutex> lock(mut);
+            measurements.push_back(m);
+        }
+
+        std::vector<tii_measurement_t> getMeasurements() {
+            std::lock_guard<std::mutex> lock(mut);
+            return measurements;
+        }
+
+    private:
+        std::mutex mut;
+        std::vector<tii_measurement_t> measurements;
+};
+
+struct Transmitter {
+    int comb;
+    int pattern;
+    int delay;
+    float amplitude;
+};
+
+static int k_to_ix(int k)
+{
+    return k < 0 ? 2048 + k : k;
+}
+
+/* Builds a PRS with random carrier phases, and the NULL symbol in which the
+ * given transmitters send their TII carriers. Each pair of TII carriers has
+ * the phase of the PRS carrier at the first frequency of the pair, rotated
+ * by the delay of the transmitter. */
+static void make_symbols(const DABParams& params,
+        const std::vector<Transmitter>& transmitters, float noise,
+        std::mt19937& rng,
+        std::vector<complexf>& null, std::vector<complexf>& prs)
+{
+    const int T_u = params.T_u;
+    std::uniform_int_distribution<int> quadrant(0, 3);
+    std::normal_distribution<float> gauss(0.0f, noise);
+
+    std::vector<complexf> prs_freq(T_u);
+    for (int k = -params.K/2; k <= params.K/2; k++) {
+        if (k != 0) {
+            prs_freq[k_to_ix(k)] = std::polar(1.0f, (float)M_PI_2 * quadrant(rng) + (float)M_PI_4);
+        }
+    }
+
+    std::vector<complexf> null_freq(T_u);
+    for (auto& c : null_freq) {
+        c = complexf(gauss(rng), gauss(rng));
+    }
+
+    for (const auto& tx : transmitters) {
+        const auto carriers = CombPattern(tx.comb, tx.pattern).generateCarriers();
+        for (size_t i = 0; i < carriers.size(); i += 2) {
+            const complexf phase = prs_freq[k_to_ix(carriers[i])];
+            for (size_t j = i; j < i + 2; j++) {
+                const float rot = -2.0f * (float)M_PI * tx.delay * carriers[j] / T_u;
+                null_freq[k_to_ix(carriers[j])] += tx.amplitude * phase * std::polar(1.0f, rot);
+            }
+        }
+    }
+
+    fft::Backward ifft(T_u);
+    std::copy(prs_freq.begin(), prs_freq.end(), ifft.getVector());
+    ifft.do_IFFT();
+    prs.assign(ifft.getVector(), ifft.getVector() + T_u);
+
+    std::copy(null_freq.begin(), null_freq.end(), ifft.getVector());
+    ifft.do_IFFT();
+    const int prefix = params.T_null - T_u;
+    null.resize(params.T_null);
+    std::copy(ifft.getVector() + T_u - prefix, ifft.getVector() + T_u, null.begin());
+    std::copy(ifft.getVector(), ifft.getVector() + T_u, null.begin() + prefix);
+}
+
+// Pushes new frames until the decoder has given num_expected measurements
+static std::vector<tii_measurement_t> decode(
+        const std::vector<Transmitter>& transmitters, float noise,
+        size_t num_expected)
+{
+    DABParams params(1);
+    TiiRadioInterface ri;
+    TIIDecoder decoder(params, ri);
+    std::mt19937 rng(42);
+
+    std::vector<complexf> null, prs;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (ri.getMeasurements().size() < num_expected and
+            std::chrono::steady_clock::now() < deadline) {
+        make_symbols(params, transmitters, noise, rng, null, prs);
+        decoder.pushSymbols(null, prs);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return ri.getMeasurements();
+}
+
+TEST_CASE("Carriers of a comb/pattern", "[tii]") {
+    const auto carriers = CombPattern(3, 0).generateCarriers();
+    // Pattern 0 has four bits set, each gives a pair in each of the four blocks
+    REQUIRE(carriers.size() == 32);
+    REQUIRE(std::is_sorted(carriers.begin(), carriers.end()));
+    for (size_t i = 0; i < carriers.size(); i += 2) {
+        REQUIRE(carriers[i+1] == carriers[i] + 1);
+    }
+    // First bit set in pattern 0 is b=4: k = 1 + 2*3 + 48*4
+    REQUIRE(std::find(carriers.begin(), carriers.end(), 199) != carriers.end());
+}
+
+TEST_CASE("Delay of a single transmitter", "[tii]") {
+    for (int delay : {-2, 0, 17, 150, 499}) {
+        const auto m = decode({{5, 12, delay, 1.0f}}, 0.1f, 1);
+        REQUIRE(m.size() >= 1);
+        CHECK(m[0].comb == 5);
+        CHECK(m[0].pattern == 12);
+        CHECK(m[0].delay_samples == delay);
+        // TII carriers as strong as the PRS carriers
+        CHECK(std::abs(m[0].level_db) < 1.0f);
+    }
+}
+
+TEST_CASE("Delays of two transmitters in a SFN", "[tii]") {
+    const auto m = decode({{2, 7, 30, 1.0f}, {11, 40, 210, 0.7f}}, 0.2f, 2);
+    REQUIRE(m.size() >= 2);
+
+    bool found_first = false, found_second = false;
+    for (const auto& meas : m) {
+        if (meas.comb == 2 and meas.pattern == 7) {
+            found_first = true;
+            CHECK(meas.delay_samples == 30);
+        }
+        else if (meas.comb == 11 and meas.pattern == 40) {
+            found_second = true;
+            CHECK(meas.delay_samples == 210);
+            CHECK(meas.level_db == Approx(20 * std::log10(0.7f)).margin(1.0));
+        }
+        else {
+            FAIL("Unexpected comb " << meas.comb << " pattern " << meas.pattern);
+        }
+    }
+    REQUIRE(found_first);
+    REQUIRE(found_second);
+}
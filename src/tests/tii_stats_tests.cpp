@@ -0,0 +1,194 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/**
+ * @file tii_stats_tests.cpp
+ * @brief Tests for the sliding-window TII statistics of the transmitters
+ *
+ * Test Framework: Catch2 (header-only, lightweight)
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "../backend/tii-stats.h"
+#include <chrono>
+
+using namespace std::chrono;
+
+static tii_measurement_t meas(int comb, int pattern, int delay,
+        float error = 1.0f, float level_db = -10.0f)
+{
+    tii_measurement_t m;
+    m.comb = comb;
+    m.pattern = pattern;
+    m.delay_samples = delay;
+    m.error = error;
+    m.level_db = level_db;
+    return m;
+}
+
+TEST_CASE("Transmitter is reported after enough measurements", "[tiistats]") {
+    TiiStats stats;
+    const auto t0 = TiiStats::clock::now();
+
+    for (size_t i = 0; i + 1 < TiiStats::MIN_MEASUREMENTS; i++) {
+        stats.add(meas(3, 5, 100), t0);
+    }
+    REQUIRE(stats.getAggregates(t0).empty());
+
+    stats.add(meas(3, 5, 100), t0);
+    const auto aggs = stats.getAggregates(t0);
+    REQUIRE(aggs.size() == 1);
+    REQUIRE(aggs.front().comb == 3);
+    REQUIRE(aggs.front().pattern == 5);
+    REQUIRE(aggs.front().delay_samples == 100);
+}
+
+TEST_CASE("Median delay ignores flukes, error and level are averaged", "[tiistats]") {
+    TiiStats stats;
+    const auto t0 = TiiStats::clock::now();
+
+    stats.add(meas(1, 2, 40, 1.0f, -12.0f), t0);
+    stats.add(meas(1, 2, 480, 3.0f, -8.0f), t0);
+    stats.add(meas(1, 2, 41, 1.0f, -12.0f), t0);
+    stats.add(meas(1, 2, 40, 3.0f, -8.0f), t0);
+    stats.add(meas(1, 2, 2, 2.0f, -10.0f), t0);
+
+    const auto aggs = stats.getAggregates(t0);
+    REQUIRE(aggs.size() == 1);
+    REQUIRE(aggs.front().delay_samples == 40);
+    REQUIRE(aggs.front().error == Approx(2.0f));
+    REQUIRE(aggs.front().level_db == Approx(-10.0f));
+}
+
+TEST_CASE("Window keeps the most recent measurements", "[tiistats]") {
+    TiiStats stats;
+    const auto t0 = TiiStats::clock::now();
+
+    for (size_t i = 0; i < TiiStats::WINDOW; i++) {
+        stats.add(meas(0, 0, 10, 100.0f), t0);
+    }
+    for (size_t i = 0; i < TiiStats::WINDOW; i++) {
+        stats.add(meas(0, 0, 20, 1.0f), t0);
+    }
+
+    const auto aggs = stats.getAggregates(t0);
+    REQUIRE(aggs.size() == 1);
+    REQUIRE(aggs.front().delay_samples == 20);
+    REQUIRE(aggs.front().error == Approx(1.0f));
+}
+
+TEST_CASE("Transmitters that are no longer received disappear", "[tiistats]") {
+    TiiStats stats(seconds(30));
+    const auto t0 = TiiStats::clock::now();
+
+    for (int i = 0; i < 10; i++) {
+        stats.add(meas(7, 8, 30), t0 + seconds(i));
+        stats.add(meas(9, 1, 50), t0 + seconds(i));
+    }
+    for (int i = 10; i < 40; i++) {
+        stats.add(meas(9, 1, 50), t0 + seconds(i));
+    }
+
+    // The first measurements of 7/8 are older than 30 seconds, too few are left
+    const auto aggs = stats.getAggregates(t0 + seconds(36));
+    REQUIRE(aggs.size() == 1);
+    REQUIRE(aggs.front().comb == 9);
+
+    REQUIRE(stats.getAggregates(t0 + seconds(100)).empty());
+}
+
+TEST_CASE("Aggregates are ordered by comb and pattern", "[tiistats]") {
+    TiiStats stats;
+    const auto t0 = TiiStats::clock::now();
+
+    const int cps[][2] = { {20, 3}, {2, 69}, {2, 4}, {0, 1} };
+    for (const auto& cp : cps) {
+        for (size_t i = 0; i < TiiStats::MIN_MEASUREMENTS; i++) {
+            stats.add(meas(cp[0], cp[1], 1), t0);
+        }
+    }
+
+    // Invalid measurements are ignored
+    stats.add(meas(24, 0, 1), t0);
+    stats.add(meas(0, 70, 1), t0);
+    stats.add(meas(-1, 0, 1), t0);
+
+    const auto aggs = stats.getAggregates(t0);
+    REQUIRE(aggs.size() == 4);
+    auto it = aggs.begin();
+    REQUIRE((it->comb == 0 and it->pattern == 1));
+    ++it;
+    REQUIRE((it->comb == 2 and it->pattern == 4));
+    ++it;
+    REQUIRE((it->comb == 2 and it->pattern == 69));
+    ++it;
+    REQUIRE((it->comb == 20 and it->pattern == 3));
+}
+
+TEST_CASE("History is sampled at the history interval and bounded", "[tiistats]") {
+    TiiStats stats(seconds(30), seconds(10), 4);
+    const auto t0 = TiiStats::clock::now();
+
+    // One measurement per second over 60 seconds, with a delay that drifts
+    for (int i = 0; i < 60; i++) {
+        stats.add(meas(4, 4, i), t0 + seconds(i));
+    }
+
+    const auto histories = stats.getHistory();
+    REQUIRE(histories.size() == 1);
+    REQUIRE(histories[0].comb == 4);
+    REQUIRE(histories[0].pattern == 4);
+
+    // Points at 4, 14, 24, 34, 44, 54 s, only the last four are kept.
+    // At 24 s and later, the window holds the last 20 delays.
+    const auto& points = histories[0].points;
+    REQUIRE(points.size() == 4);
+    REQUIRE(points.front().delay_samples == 24 - 9);
+    REQUIRE(points.back().delay_samples == 54 - 9);
+    for (size_t i = 1; i < points.size(); i++) {
+        REQUIRE(points[i].delay_samples - points[i-1].delay_samples == 10);
+        REQUIRE(points[i].time >= points[i-1].time);
+    }
+}
+
+TEST_CASE("Clear forgets everything", "[tiistats]") {
+    TiiStats stats;
+    const auto t0 = TiiStats::clock::now();
+    for (size_t i = 0; i < TiiStats::WINDOW; i++) {
+        stats.add(meas(5, 5, 5), t0);
+    }
+    REQUIRE(stats.getAggregates(t0).size() == 1);
+    REQUIRE(stats.getHistory().size() == 1);
+
+    stats.clear();
+    REQUIRE(stats.getAggregates(t0).empty());
+    REQUIRE(stats.getHistory().empty());
+
+    // A single new measurement is not enough after the clear
+    stats.add(meas(5, 5, 5), t0);
+    REQUIRE(stats.getAggregates(t0).empty());
+}
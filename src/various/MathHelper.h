@@ -34,6 +34,7 @@
 #define MATHHELPER_H
 
 #include <complex>
+#include <cstdint>
 #include <cstring>
 
 #define Hz(x) (x)
@@ -45,6 +46,31 @@ static inline float get_db_over_256(float x)
     return 20 * log10((x + 1.0f) / 256.0f);
 }
 
+// Approximation of 10*log10(x) that avoids the libm call, for use in
+// loops over whole spectra. Maximum error is below 0.001 dB for normal
+// positive x; x <= 0 gives -200 dB.
+static inline float fast_10log10(float x)
+{
+    if (not (x > 0.0f)) {
+        return -200.0f;
+    }
+
+    uint32_t i;
+    memcpy(&i, &x, sizeof(i));
+    const float exponent = (float)((int)((i >> 23) & 0xFF) - 127);
+
+    // Mantissa m in [1, 2), log2(m) = 2/ln(2) * atanh((m-1)/(m+1))
+    i = (i & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &i, sizeof(m));
+    const float t = (m - 1.0f) / (m + 1.0f);
+    const float t2 = t * t;
+    const float log2_m = t * (2.8853901f + t2 * (0.9617967f + t2 * 0.5770780f));
+
+    // 10*log10(2)
+    return 3.0103000f * (exponent + log2_m);
+}
+
 static inline float l1_norm(const std::complex<float>& z)
 {
     return std::abs(z.real()) + std::abs(z.imag());
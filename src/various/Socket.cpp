@@ -94,6 +94,46 @@ void Socket::close()
     sock = INVALID_SOCKET;
 }
 
+void Socket::shutdown()
+{
+    if (valid()) {
+#if defined(_WIN32)
+        ::shutdown(sock, SD_BOTH);
+#else
+        ::shutdown(sock, SHUT_RDWR);
+#endif
+    }
+}
+
+int Socket::localPort() const
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getsockname(sock, (sockaddr*)&addr, &len) == -1) {
+        return -1;
+    }
+    return ntohs(addr.sin_port);
+}
+
+bool Socket::setReceiveBufferSize(int bytes)
+{
+    return setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+            (const char*)&bytes, sizeof(bytes)) == 0;
+}
+
+bool Socket::setReceiveTimeout(int timeout_ms)
+{
+#if defined(_WIN32)
+    DWORD timeout = timeout_ms;
+#else
+    struct timeval timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+    return setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO,
+            (const char*)&timeout, sizeof(timeout)) == 0;
+}
+
 bool Socket::valid() const
 {
     return sock != (int) INVALID_SOCKET;
@@ -67,8 +67,18 @@ class Socket {
         Socket& operator=(Socket&& other);
 
         void close();
+        // Wake up a thread blocked in recv() on this socket, without
+        // releasing the descriptor it uses
+        void shutdown();
         bool valid() const;
 
+        // The port the socket is bound to, e.g. after bind(0)
+        int localPort() const;
+
+        bool setReceiveBufferSize(int bytes);
+        // recv() fails with EAGAIN after timeout_ms without any data
+        bool setReceiveTimeout(int timeout_ms);
+
         // Binds to any address
         bool bind(int port);
         bool listen();
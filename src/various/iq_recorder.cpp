@@ -0,0 +1,776 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "iq_recorder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+constexpr size_t IQRecorder::BFP_BLOCK_SAMPLES;
+
+static const char CONTAINER_MAGIC[4] = { 'W', 'I', 'Q', '1' };
+static const size_t CONTAINER_HEADER_SIZE = 16;
+static const size_t RECORD_HEADER_SIZE = 12;
+static const int ZSTD_LEVEL = 1;
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t IQRecorder::sampleSize(Format format)
+{
+    switch (format) {
+        case Format::U8:
+        case Format::S8: return 2;
+        case Format::S16LE:
+        case Format::S16BE: return 4;
+        case Format::CF32: return 8;
+    }
+    return 2;
+}
+
+static const char *format_name(IQRecorder::Format format)
+{
+    switch (format) {
+        case IQRecorder::Format::U8: return "u8";
+        case IQRecorder::Format::S8: return "s8";
+        case IQRecorder::Format::S16LE: return "s16le";
+        case IQRecorder::Format::S16BE: return "s16be";
+        case IQRecorder::Format::CF32: return "cf32";
+    }
+    return "u8";
+}
+
+static const char *sigmf_datatype(IQRecorder::Format format)
+{
+    switch (format) {
+        case IQRecorder::Format::U8: return "cu8";
+        case IQRecorder::Format::S8: return "ci8";
+        case IQRecorder::Format::S16LE: return "ci16_le";
+        case IQRecorder::Format::S16BE: return "ci16_be";
+        case IQRecorder::Format::CF32: return "cf32_le";
+    }
+    return "cu8";
+}
+
+bool IQRecorder::isCompressionAvailable()
+{
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+/********************** Block floating point packing *************************/
+
+// Every component as a number, in the units of the format
+static float get_component(IQRecorder::Format format, const uint8_t *p)
+{
+    switch (format) {
+        case IQRecorder::Format::S16LE: return (int16_t)(p[0] | (p[1] << 8));
+        case IQRecorder::Format::S16BE: return (int16_t)((p[0] << 8) | p[1]);
+        case IQRecorder::Format::CF32: {
+            float f;
+            memcpy(&f, p, sizeof(f));
+            return f;
+        }
+        default: return 0;
+    }
+}
+
+static void put_component(IQRecorder::Format format, uint8_t *p, float v)
+{
+    switch (format) {
+        case IQRecorder::Format::S16LE: {
+            const int16_t s = (int16_t)max(-32768.0f, min(32767.0f, v));
+            p[0] = s & 0xFF;
+            p[1] = (s >> 8) & 0xFF;
+            break;
+        }
+        case IQRecorder::Format::S16BE: {
+            const int16_t s = (int16_t)max(-32768.0f, min(32767.0f, v));
+            p[0] = (s >> 8) & 0xFF;
+            p[1] = s & 0xFF;
+            break;
+        }
+        case IQRecorder::Format::CF32:
+            memcpy(p, &v, sizeof(v));
+            break;
+        default:
+            break;
+    }
+}
+
+// Per block: one signed exponent byte e, then one signed mantissa byte m
+// per component, with value = m * 2^e.
+static void pack_bfp8(IQRecorder::Format format, const uint8_t *in, size_t len,
+        vector<uint8_t>& out)
+{
+    const size_t csize = IQRecorder::sampleSize(format) / 2;
+    const size_t num = len / csize;
+    const size_t per_block = 2 * IQRecorder::BFP_BLOCK_SAMPLES;
+
+    out.clear();
+    out.reserve(num + num / per_block + 1);
+
+    float comp[2 * IQRecorder::BFP_BLOCK_SAMPLES];
+    for (size_t start = 0; start < num; start += per_block) {
+        const size_t n = min(per_block, num - start);
+
+        float peak = 0;
+        for (size_t i = 0; i < n; i++) {
+            comp[i] = get_component(format, in + (start + i) * csize);
+            peak = max(peak, fabs(comp[i]));
+        }
+
+        // The smallest exponent with peak / 2^e < 128
+        int e = -128;
+        if (peak > 0) {
+            int k;
+            frexp(peak, &k);
+            e = max(-128, min(127, k - 7));
+        }
+        if (format != IQRecorder::Format::CF32) {
+            e = max(e, 0);
+        }
+
+        out.push_back((uint8_t)(int8_t)e);
+        for (size_t i = 0; i < n; i++) {
+            const long m = lrintf(ldexpf(comp[i], -e));
+            out.push_back((uint8_t)(int8_t)max(-127L, min(127L, m)));
+        }
+    }
+}
+
+static bool unpack_bfp8(IQRecorder::Format format, const uint8_t *in, size_t len,
+        size_t raw_len, vector<uint8_t>& out)
+{
+    const size_t csize = IQRecorder::sampleSize(format) / 2;
+    const size_t num = raw_len / csize;
+    const size_t per_block = 2 * IQRecorder::BFP_BLOCK_SAMPLES;
+    if (len != num + (num + per_block - 1) / per_block) {
+        return false;
+    }
+
+    const size_t offset = out.size();
+    out.resize(offset + raw_len);
+    uint8_t *dst = out.data() + offset;
+
+    for (size_t start = 0; start < num; start += per_block) {
+        const size_t n = min(per_block, num - start);
+        const int e = (int8_t)*in++;
+        for (size_t i = 0; i < n; i++) {
+            put_component(format, dst + (start + i) * csize, ldexpf((int8_t)*in++, e));
+        }
+    }
+    return true;
+}
+
+/******************************** Recorder ***********************************/
+
+static IQRecorder::Config sanitize(IQRecorder::Config c)
+{
+    if (c.packing == IQRecorder::Packing::BFP8 and
+            (c.format == IQRecorder::Format::U8 or c.format == IQRecorder::Format::S8)) {
+        // Already 8 bits
+        c.packing = IQRecorder::Packing::None;
+    }
+
+    if (c.compress and not IQRecorder::isCompressionAvailable()) {
+        clog << "IQRecorder: compiled without zstd, recording uncompressed" << endl;
+        c.compress = false;
+    }
+
+    // Blocks hold whole BFP blocks, and so whole samples
+    const size_t unit = IQRecorder::sampleSize(c.format) * IQRecorder::BFP_BLOCK_SAMPLES;
+    c.blockBytes = max(unit, c.blockBytes - c.blockBytes % unit);
+    c.numBlocks = max<size_t>(c.numBlocks, 2);
+    c.maxSegments = max<size_t>(c.maxSegments, 1);
+    return c;
+}
+
+static string make_extension(const IQRecorder::Config& c)
+{
+    if (c.packing == IQRecorder::Packing::None and not c.compress) {
+        // Playable by the raw file input with the "auto" format, which
+        // reads the metadata of SigMF recordings
+        if (c.sigmf) {
+            return ".sigmf-data";
+        }
+        return string(".") + format_name(c.format) + ".iq";
+    }
+    return ".wiq";
+}
+
+IQRecorder::IQRecorder(const Config& conf) :
+    config(sanitize(conf)),
+    extension(make_extension(config)),
+    blocks(config.numBlocks),
+    freeBlocks(config.numBlocks),
+    fullBlocks(config.numBlocks),
+    startWallTime(chrono::system_clock::now()),
+    startTime(chrono::steady_clock::now()),
+    bytesWrittenCounter(metrics::registry().counter(
+            "welle_recorder_bytes_written_total",
+            "Bytes the IQ recorder wrote to disk")),
+    blocksDroppedCounter(metrics::registry().counter(
+            "welle_recorder_blocks_dropped_total",
+            "IQ blocks dropped because the recorder did not keep up"))
+{
+    for (auto& b : blocks) {
+        b.data.resize(config.blockBytes);
+        Block *p = &b;
+        freeBlocks.push(&p, 1);
+    }
+
+    char buf[32];
+    const time_t now = time(nullptr);
+    strftime(buf, sizeof(buf), "%Y%m%d-%H%M%S", localtime(&now));
+    stamp = buf;
+
+    sigmf::Capture capture;
+    capture.frequency = config.frequency;
+    captures.push_back(capture);
+
+    thread = std::thread(&IQRecorder::run, this);
+}
+
+IQRecorder::~IQRecorder()
+{
+    stop();
+}
+
+void IQRecorder::push(const uint8_t *data, size_t len)
+{
+    if (not running) {
+        return;
+    }
+
+    uint64_t offset = bytesIn.fetch_add(len);
+    while (len > 0) {
+        Block *b = nullptr;
+        if (freeBlocks.pop(&b, 1) != 1) {
+            const uint64_t dropped = (len + config.blockBytes - 1) / config.blockBytes;
+            blocksDropped += dropped;
+            blocksDroppedCounter.inc(dropped);
+            return;
+        }
+
+        const size_t n = min(len, config.blockBytes);
+        memcpy(b->data.data(), data, n);
+        b->size = n;
+        b->offset = offset;
+        fullBlocks.push(&b, 1);
+
+        offset += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void IQRecorder::trigger()
+{
+    triggered = true;
+    stop();
+}
+
+void IQRecorder::stop()
+{
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+
+        if (config.mode == Mode::PreTrigger and not triggered) {
+            // Nobody asked to keep the window
+            lock_guard<mutex> lock(segmentsMutex);
+            for (const auto& seg : segments) {
+                remove(seg.path.c_str());
+                if (not seg.metaPath.empty()) {
+                    remove(seg.metaPath.c_str());
+                }
+            }
+            segments.clear();
+        }
+        // Annotations may have arrived after a segment was closed
+        else if (config.sigmf) {
+            lock_guard<mutex> lock(segmentsMutex);
+            size_t num_events = 0;
+            {
+                lock_guard<mutex> events_lock(eventsMutex);
+                num_events = captures.size() + annotations.size();
+            }
+            for (auto& seg : segments) {
+                if (seg.eventsWritten < num_events) {
+                    writeMeta(seg);
+                }
+            }
+        }
+
+        const auto s = getStats();
+        clog << "IQRecorder: recorded " << s.bytesRecorded << " bytes in " <<
+            s.segments << " segments at " << s.writeRate / 1e6 << " MB/s, " <<
+            s.blocksDropped << " blocks dropped" << endl;
+    }
+}
+
+void IQRecorder::run()
+{
+    while (true) {
+        Block *b = nullptr;
+        if (fullBlocks.pop(&b, 1) == 1) {
+            writeBlock(*b);
+            freeBlocks.push(&b, 1);
+        }
+        else if (not running) {
+            // Everything pushed before stop() was written
+            break;
+        }
+        else {
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+    }
+
+    // Blocks dropped after the last one written
+    const uint64_t end = bytesIn;
+    if (segment and end > expectedOffset) {
+        const size_t ss = sampleSize(config.format);
+        addDrop(expectedOffset / ss, (end - expectedOffset) / ss);
+        expectedOffset = end;
+    }
+
+    closeSegment();
+}
+
+void IQRecorder::writeBlock(const Block& block)
+{
+    const size_t ss = sampleSize(config.format);
+
+    // After a failed open the recording is over, not retried per block
+    if (segment == nullptr and not writeFailed) {
+        openSegment(expectedOffset / ss);
+    }
+
+    // A gap in the input are blocks push() had to drop
+    if (segment and block.offset > expectedOffset) {
+        addDrop(expectedOffset / ss, (block.offset - expectedOffset) / ss);
+    }
+    expectedOffset = block.offset + block.size;
+
+    if (segment == nullptr or writeFailed) {
+        blocksDropped++;
+        blocksDroppedCounter.inc();
+        if (segment) {
+            addDrop(block.offset / ss, block.size / ss);
+        }
+        return;
+    }
+
+    size_t written = 0;
+    if (extension != ".wiq") {
+        written = fwrite(block.data.data(), 1, block.size, segment);
+        if (written != block.size) {
+            writeFailed = true;
+        }
+    }
+    else {
+        const uint8_t *payload = block.data.data();
+        size_t packed_len = block.size;
+        if (config.packing == Packing::BFP8) {
+            pack_bfp8(config.format, block.data.data(), block.size, packed);
+            payload = packed.data();
+            packed_len = packed.size();
+        }
+
+        size_t stored_len = packed_len;
+#ifdef HAVE_ZSTD
+        if (config.compress) {
+            compressed.resize(ZSTD_compressBound(packed_len));
+            const size_t r = ZSTD_compress(compressed.data(), compressed.size(),
+                    payload, packed_len, ZSTD_LEVEL);
+            // Incompressible blocks are stored as they are
+            if (not ZSTD_isError(r) and r < packed_len) {
+                payload = compressed.data();
+                stored_len = r;
+            }
+        }
+#else
+        (void)ZSTD_LEVEL;
+#endif
+
+        uint8_t header[RECORD_HEADER_SIZE];
+        put_u32(header, block.size);
+        put_u32(header + 4, packed_len);
+        put_u32(header + 8, stored_len);
+        written = fwrite(header, 1, sizeof(header), segment);
+        written += fwrite(payload, 1, stored_len, segment);
+        if (written != sizeof(header) + stored_len) {
+            writeFailed = true;
+        }
+    }
+
+    if (writeFailed) {
+        perror("IQRecorder: write failed");
+        blocksDropped++;
+        blocksDroppedCounter.inc();
+        addDrop(block.offset / ss, block.size / ss);
+        return;
+    }
+
+    blocksWritten++;
+    bytesRecorded += block.size;
+    bytesWritten += written;
+    bytesWrittenCounter.inc(written);
+
+    {
+        lock_guard<mutex> lock(segmentsMutex);
+        segments.back().inputEnd = expectedOffset / ss;
+    }
+
+    segmentInputBytes += block.size;
+    if (segmentInputBytes >= config.segmentBytes) {
+        closeSegment();
+    }
+}
+
+void IQRecorder::addDrop(uint64_t sample, uint64_t count)
+{
+    lock_guard<mutex> lock(segmentsMutex);
+    auto& seg = segments.back();
+    seg.drops.emplace_back(sample, count);
+    seg.inputEnd = max(seg.inputEnd, sample + count);
+}
+
+void IQRecorder::openSegment(uint64_t inputStart)
+{
+    char number[16];
+    snprintf(number, sizeof(number), "%04u", segmentNumber++);
+    const string base = config.directory + "/" + config.prefix + "-" +
+        stamp + "-" + number;
+    const string name = base + extension;
+
+    segment = fopen(name.c_str(), "wb");
+    if (segment == nullptr) {
+        if (not writeFailed) {
+            perror(("IQRecorder: cannot open " + name).c_str());
+        }
+        writeFailed = true;
+        return;
+    }
+    segmentInputBytes = 0;
+
+    if (extension == ".wiq") {
+        uint8_t header[CONTAINER_HEADER_SIZE] = {};
+        memcpy(header, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+        header[4] = (uint8_t)config.format;
+        header[5] = (uint8_t)config.packing;
+        header[6] = config.compress ? 1 : 0;
+        put_u32(header + 8, BFP_BLOCK_SAMPLES);
+        fwrite(header, 1, sizeof(header), segment);
+        bytesWritten += sizeof(header);
+    }
+
+    Segment seg;
+    seg.path = name;
+    if (config.sigmf) {
+        seg.metaPath = base + ".sigmf-meta";
+    }
+    seg.inputStart = inputStart;
+    seg.inputEnd = inputStart;
+
+    lock_guard<mutex> lock(segmentsMutex);
+    segments.push_back(seg);
+
+    // Keep only the pre-trigger window on disk
+    if (config.mode == Mode::PreTrigger) {
+        while (segments.size() > config.maxSegments) {
+            remove(segments.front().path.c_str());
+            if (not segments.front().metaPath.empty()) {
+                remove(segments.front().metaPath.c_str());
+            }
+            segments.pop_front();
+        }
+    }
+}
+
+void IQRecorder::closeSegment()
+{
+    if (segment) {
+        fclose(segment);
+        segment = nullptr;
+
+        if (config.sigmf) {
+            lock_guard<mutex> lock(segmentsMutex);
+            writeMeta(segments.back());
+        }
+    }
+}
+
+// Called with segmentsMutex held
+void IQRecorder::writeMeta(Segment& seg)
+{
+    sigmf::Metadata meta;
+    meta.datatype = sigmf_datatype(config.format);
+    meta.sampleRate = config.sampleRate;
+    meta.description = config.description;
+    meta.hardware = config.hardware;
+    meta.recorder = "welle.io";
+    if (extension == ".wiq") {
+        meta.dataset = seg.path.substr(seg.path.find_last_of('/') + 1);
+        meta.encoding = "wiq";
+    }
+
+    // Input sample to sample in the segment file
+    auto to_file = [&](uint64_t sample) {
+        sample = min(max(sample, seg.inputStart), seg.inputEnd);
+        uint64_t dropped = 0;
+        for (const auto& d : seg.drops) {
+            if (d.first >= sample) {
+                break;
+            }
+            dropped += min(d.second, sample - d.first);
+        }
+        return sample - seg.inputStart - dropped;
+    };
+
+    auto time_of = [&](uint64_t sample) {
+        const chrono::duration<double> t(sample / config.sampleRate);
+        return sigmf::datetime(startWallTime +
+                chrono::duration_cast<chrono::system_clock::duration>(t));
+    };
+
+    lock_guard<mutex> lock(eventsMutex);
+
+    // The capture in effect at the start of the segment, and the retunes
+    // during the segment
+    sigmf::Capture first = captures.front();
+    for (const auto& c : captures) {
+        if (c.sampleStart <= seg.inputStart) {
+            first = c;
+        }
+    }
+    first.sampleStart = 0;
+    first.datetime = time_of(seg.inputStart);
+    meta.captures.push_back(first);
+
+    for (const auto& c : captures) {
+        if (c.sampleStart > seg.inputStart and c.sampleStart < seg.inputEnd) {
+            sigmf::Capture capture = c;
+            capture.sampleStart = to_file(c.sampleStart);
+            capture.datetime = time_of(c.sampleStart);
+            meta.captures.push_back(capture);
+        }
+    }
+
+    for (const auto& a : annotations) {
+        const uint64_t end = a.sampleStart + a.sampleCount;
+        const bool overlaps = a.sampleCount == 0 ?
+            (a.sampleStart >= seg.inputStart and a.sampleStart < seg.inputEnd) :
+            (a.sampleStart < seg.inputEnd and end > seg.inputStart);
+        if (overlaps) {
+            sigmf::Annotation annotation = a;
+            annotation.sampleStart = to_file(a.sampleStart);
+            annotation.sampleCount = to_file(end) - annotation.sampleStart;
+            meta.annotations.push_back(annotation);
+        }
+    }
+
+    for (const auto& d : seg.drops) {
+        sigmf::Annotation annotation;
+        annotation.sampleStart = to_file(d.first);
+        annotation.label = sigmf::DROPPED_LABEL;
+        annotation.comment = to_string(d.second) + " samples dropped";
+        meta.annotations.push_back(annotation);
+    }
+    sort(meta.annotations.begin(), meta.annotations.end(),
+            [](const sigmf::Annotation& a, const sigmf::Annotation& b) {
+                return a.sampleStart < b.sampleStart;
+            });
+
+    seg.eventsWritten = captures.size() + annotations.size();
+
+    if (not sigmf::write(seg.metaPath, meta)) {
+        clog << "IQRecorder: cannot write " << seg.metaPath << endl;
+    }
+}
+
+uint64_t IQRecorder::position() const
+{
+    return bytesIn / sampleSize(config.format);
+}
+
+void IQRecorder::addCapture(uint64_t sampleStart, double frequency)
+{
+    sigmf::Capture capture;
+    capture.sampleStart = sampleStart;
+    capture.frequency = frequency;
+
+    lock_guard<mutex> lock(eventsMutex);
+    captures.push_back(capture);
+    sort(captures.begin(), captures.end(),
+            [](const sigmf::Capture& a, const sigmf::Capture& b) {
+                return a.sampleStart < b.sampleStart;
+            });
+}
+
+void IQRecorder::annotate(uint64_t sampleStart, uint64_t sampleCount,
+        const string& label, const string& comment)
+{
+    sigmf::Annotation annotation;
+    annotation.sampleStart = sampleStart;
+    annotation.sampleCount = sampleCount;
+    annotation.label = label;
+    annotation.comment = comment;
+
+    lock_guard<mutex> lock(eventsMutex);
+    annotations.push_back(annotation);
+}
+
+IQRecorder::Stats IQRecorder::getStats() const
+{
+    Stats s;
+    s.bytesIn = bytesIn;
+    s.bytesRecorded = bytesRecorded;
+    s.bytesWritten = bytesWritten;
+    s.blocksWritten = blocksWritten;
+    s.blocksDropped = blocksDropped;
+    {
+        lock_guard<mutex> lock(segmentsMutex);
+        s.segments = segments.size();
+    }
+
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - startTime;
+    s.writeRate = elapsed.count() > 0 ? s.bytesRecorded / elapsed.count() : 0;
+    s.compressionRatio = s.bytesWritten > 0 ? (double)s.bytesRecorded / s.bytesWritten : 0;
+    return s;
+}
+
+vector<string> IQRecorder::segmentFiles() const
+{
+    lock_guard<mutex> lock(segmentsMutex);
+    vector<string> files;
+    for (const auto& seg : segments) {
+        files.push_back(seg.path);
+    }
+    return files;
+}
+
+vector<string> IQRecorder::metaFiles() const
+{
+    lock_guard<mutex> lock(segmentsMutex);
+    vector<string> files;
+    for (const auto& seg : segments) {
+        if (not seg.metaPath.empty()) {
+            files.push_back(seg.metaPath);
+        }
+    }
+    return files;
+}
+
+bool IQRecorder::readSegment(const string& path, vector<uint8_t>& data, Format& format)
+{
+    FILE *fd = fopen(path.c_str(), "rb");
+    if (fd == nullptr) {
+        return false;
+    }
+    unique_ptr<FILE, int(*)(FILE*)> closer(fd, fclose);
+
+    uint8_t header[CONTAINER_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), fd) != sizeof(header) or
+            memcmp(header, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0 or
+            header[4] > (uint8_t)Format::CF32 or
+            header[5] > (uint8_t)Packing::BFP8 or
+            get_u32(header + 8) != BFP_BLOCK_SAMPLES) {
+        return false;
+    }
+
+    format = (Format)header[4];
+    const auto packing = (Packing)header[5];
+    const bool compressed = header[6] != 0;
+#ifndef HAVE_ZSTD
+    if (compressed) {
+        clog << "IQRecorder: cannot read " << path << ", compiled without zstd" << endl;
+        return false;
+    }
+#endif
+
+    data.clear();
+    vector<uint8_t> stored;
+    vector<uint8_t> unpacked;
+    uint8_t record[RECORD_HEADER_SIZE];
+    while (fread(record, 1, sizeof(record), fd) == sizeof(record)) {
+        const size_t raw_len = get_u32(record);
+        const size_t packed_len = get_u32(record + 4);
+        const size_t stored_len = get_u32(record + 8);
+        if (stored_len > packed_len or (packing == Packing::None and packed_len != raw_len)) {
+            return false;
+        }
+
+        stored.resize(stored_len);
+        if (fread(stored.data(), 1, stored_len, fd) != stored_len) {
+            return false;
+        }
+
+        const uint8_t *payload = stored.data();
+        if (compressed and stored_len < packed_len) {
+#ifdef HAVE_ZSTD
+            unpacked.resize(packed_len);
+            const size_t r = ZSTD_decompress(unpacked.data(), packed_len,
+                    stored.data(), stored_len);
+            if (ZSTD_isError(r) or r != packed_len) {
+                return false;
+            }
+            payload = unpacked.data();
+#endif
+        }
+
+        if (packing == Packing::BFP8) {
+            if (not unpack_bfp8(format, payload, packed_len, raw_len, data)) {
+                return false;
+            }
+        }
+        else {
+            data.insert(data.end(), payload, payload + packed_len);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,226 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sigmf.h"
+#include "spsc_ring.h"
+#include "various/metrics.h"
+
+/* Records the IQ samples of an input to disk in a background thread.
+ *
+ * The input thread hands over its samples with push(), which copies them
+ * into preallocated blocks passed to the writer thread through lock-free
+ * queues. It never blocks, never allocates and never touches the disk:
+ * if the writer falls behind, blocks are dropped and counted.
+ *
+ * The recording is cut into segments of about segmentBytes input bytes
+ * each. Without packing and compression the segments are plain raw files
+ * that the raw file input plays back directly. Otherwise they use a
+ * simple block container (extension .wiq), see readSegment().
+ *
+ * Every segment gets a SigMF metadata file with the sample format, the
+ * center frequencies and their times, and annotations for sync losses
+ * and dropped blocks. Sample positions given to addCapture() and
+ * annotate() count all samples pushed, they are converted to positions
+ * in the segment files, which lack the dropped samples.
+ *
+ * In PreTrigger mode only the last maxSegments segments are kept on disk,
+ * which replaces the ring buffer in RAM: trigger() keeps the window that
+ * was recorded up to now and ends the recording. Stopping without a
+ * trigger deletes the window. */
+class IQRecorder {
+    public:
+        enum class Format { U8, S8, S16LE, S16BE, CF32 };
+
+        enum class Packing {
+            None,
+            // Block floating point: 64 complex samples share one exponent
+            // byte, every component is stored as an 8-bit mantissa.
+            // Only applies to S16LE, S16BE and CF32.
+            BFP8,
+        };
+
+        enum class Mode { Continuous, PreTrigger };
+
+        struct Config {
+            std::string directory = ".";
+            std::string prefix = "welle-io-record";
+            Format format = Format::U8;
+            Packing packing = Packing::None;
+            // Compress every block with zstd, if welle.io was built with it
+            bool compress = false;
+            Mode mode = Mode::Continuous;
+            size_t segmentBytes = 256 * 1024 * 1024;
+            // PreTrigger mode only
+            size_t maxSegments = 4;
+            size_t blockBytes = 65536;
+            size_t numBlocks = 64;
+
+            // Write SigMF metadata, and name raw segments .sigmf-data
+            // instead of after their format
+            bool sigmf = true;
+            double sampleRate = 2048000;
+            double frequency = 0;
+            std::string description;
+            std::string hardware;
+        };
+
+        struct Stats {
+            // Input bytes pushed, including the dropped ones
+            uint64_t bytesIn = 0;
+            // Input bytes that made it to disk, and the file bytes they took
+            uint64_t bytesRecorded = 0;
+            uint64_t bytesWritten = 0;
+            uint64_t blocksWritten = 0;
+            uint64_t blocksDropped = 0;
+            size_t segments = 0;
+            // bytesRecorded per second since the start
+            double writeRate = 0;
+            // bytesRecorded / bytesWritten
+            double compressionRatio = 0;
+        };
+
+        static constexpr size_t BFP_BLOCK_SAMPLES = 64;
+
+        explicit IQRecorder(const Config& config);
+        ~IQRecorder();
+        IQRecorder(const IQRecorder&) = delete;
+        IQRecorder& operator=(const IQRecorder&) = delete;
+
+        // Called from the input thread. len must be a multiple of the
+        // sample size of the format. The data is queued in blocks of at
+        // most blockBytes, nothing stays behind until the next call.
+        void push(const uint8_t *data, size_t len);
+
+        // PreTrigger mode: keep the segments on disk and stop recording
+        void trigger();
+
+        // Write out what was pushed so far and end the recording. In
+        // PreTrigger mode the segments are deleted unless triggered.
+        void stop();
+
+        // Number of samples pushed so far, including the dropped ones
+        uint64_t position() const;
+
+        // The input was retuned at the given sample
+        void addCapture(uint64_t sampleStart, double frequency);
+
+        void annotate(uint64_t sampleStart, uint64_t sampleCount,
+                const std::string& label, const std::string& comment = "");
+
+        Stats getStats() const;
+
+        // The segments on disk, oldest first
+        std::vector<std::string> segmentFiles() const;
+
+        // Their SigMF metadata files, empty without Config::sigmf
+        std::vector<std::string> metaFiles() const;
+
+        static bool isCompressionAvailable();
+        static size_t sampleSize(Format format);
+
+        // Read a .wiq segment back into bytes of its original format.
+        // BFP8 packing is lossy. Returns false if the file is not valid.
+        static bool readSegment(const std::string& path,
+                std::vector<uint8_t>& data, Format& format);
+
+    private:
+        struct Block {
+            std::vector<uint8_t> data;
+            size_t size = 0;
+            // Byte position in the input
+            uint64_t offset = 0;
+        };
+
+        struct Segment {
+            std::string path;
+            std::string metaPath;
+            // Input samples [inputStart, inputEnd) went into this segment,
+            // except for the dropped ones
+            uint64_t inputStart = 0;
+            uint64_t inputEnd = 0;
+            // (input sample, count) of every drop
+            std::vector<std::pair<uint64_t, uint64_t> > drops;
+            // Number of events known when the metadata was written
+            size_t eventsWritten = 0;
+        };
+
+        void run();
+        void writeBlock(const Block& block);
+        void addDrop(uint64_t sample, uint64_t count);
+        void openSegment(uint64_t inputStart);
+        void closeSegment();
+        void writeMeta(Segment& segment);
+
+        Config config;
+        const std::string extension;
+
+        std::vector<Block> blocks;
+        SpscRing<Block*> freeBlocks;
+        SpscRing<Block*> fullBlocks;
+
+        std::string stamp;
+
+        // Owned by the writer thread
+        FILE *segment = nullptr;
+        bool writeFailed = false;
+        size_t segmentInputBytes = 0;
+        uint64_t expectedOffset = 0;
+        unsigned segmentNumber = 0;
+        std::vector<uint8_t> packed;
+        std::vector<uint8_t> compressed;
+
+        mutable std::mutex segmentsMutex;
+        std::deque<Segment> segments;
+
+        mutable std::mutex eventsMutex;
+        std::vector<sigmf::Capture> captures;
+        std::vector<sigmf::Annotation> annotations;
+        std::chrono::system_clock::time_point startWallTime;
+
+        std::atomic<uint64_t> bytesIn = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> bytesRecorded = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> bytesWritten = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> blocksWritten = ATOMIC_VAR_INIT(0);
+        std::atomic<uint64_t> blocksDropped = ATOMIC_VAR_INIT(0);
+        std::chrono::steady_clock::time_point startTime;
+
+        metrics::Counter& bytesWrittenCounter;
+        metrics::Counter& blocksDroppedCounter;
+
+        std::atomic<bool> running = ATOMIC_VAR_INIT(true);
+        std::atomic<bool> triggered = ATOMIC_VAR_INIT(false);
+        std::thread thread;
+};
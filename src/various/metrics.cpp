@@ -0,0 +1,272 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "various/metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace metrics {
+
+constexpr size_t Histogram::MAX_BUCKETS;
+
+static void atomic_add(atomic<double>& a, double v)
+{
+    double expected = a.load(memory_order_relaxed);
+    while (not a.compare_exchange_weak(expected, expected + v,
+                memory_order_relaxed)) {
+    }
+}
+
+void Gauge::add(double v)
+{
+    atomic_add(value, v);
+}
+
+Histogram::Histogram(const vector<double>& bounds) :
+    bounds(bounds)
+{
+    if (this->bounds.size() > MAX_BUCKETS) {
+        this->bounds.resize(MAX_BUCKETS);
+    }
+    for (auto& b : buckets) {
+        b.store(0, memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double v)
+{
+    // Buckets are stored non-cumulative, so that an observation
+    // is a single increment. get() accumulates them.
+    size_t i = 0;
+    while (i < bounds.size() and v > bounds[i]) {
+        i++;
+    }
+    buckets[i].fetch_add(1, memory_order_relaxed);
+    atomic_add(sum, v);
+    count.fetch_add(1, memory_order_relaxed);
+}
+
+Histogram::Values Histogram::get() const
+{
+    Values v;
+    v.bounds = bounds;
+    v.buckets.resize(bounds.size() + 1);
+    uint64_t acc = 0;
+    for (size_t i = 0; i <= bounds.size(); i++) {
+        acc += buckets[i].load(memory_order_relaxed);
+        v.buckets[i] = acc;
+    }
+    v.sum = sum.load(memory_order_relaxed);
+    // The fields are not updated together, make sure the result is consistent
+    v.count = acc;
+    return v;
+}
+
+vector<double> frame_time_buckets()
+{
+    return {0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5};
+}
+
+string label(const string& key, const string& value)
+{
+    string s = key + "=\"";
+    for (const char c : value) {
+        switch (c) {
+            case '\\': s += "\\\\"; break;
+            case '"': s += "\\\""; break;
+            case '\n': s += "\\n"; break;
+            default: s += c;
+        }
+    }
+    s += "\"";
+    return s;
+}
+
+string join_labels(const string& a, const string& b)
+{
+    if (a.empty() or b.empty()) {
+        return a + b;
+    }
+    return a + "," + b;
+}
+
+static Registry the_registry;
+
+Registry& registry()
+{
+    return the_registry;
+}
+
+Registry::Family& Registry::family(const string& name, const string& help, Type type)
+{
+    auto it = families.find(name);
+    if (it == families.end()) {
+        Family f;
+        f.type = type;
+        f.help = help;
+        it = families.emplace(name, move(f)).first;
+    }
+    else if (it->second.type != type) {
+        throw logic_error("Metric " + name + " registered with two types");
+    }
+    return it->second;
+}
+
+Counter& Registry::counter(const string& name, const string& help,
+        const string& labels)
+{
+    lock_guard<mutex> lock(mut);
+    auto& m = family(name, help, Type::Counter).counters[labels];
+    if (not m) {
+        m = make_unique<Counter>();
+    }
+    return *m;
+}
+
+Gauge& Registry::gauge(const string& name, const string& help,
+        const string& labels)
+{
+    lock_guard<mutex> lock(mut);
+    auto& m = family(name, help, Type::Gauge).gauges[labels];
+    if (not m) {
+        m = make_unique<Gauge>();
+    }
+    return *m;
+}
+
+Histogram& Registry::histogram(const string& name, const string& help,
+        const vector<double>& bounds, const string& labels)
+{
+    lock_guard<mutex> lock(mut);
+    auto& m = family(name, help, Type::Histogram).histograms[labels];
+    if (not m) {
+        m = make_unique<Histogram>(bounds);
+    }
+    return *m;
+}
+
+void Registry::remove(const string& name, const string& labels)
+{
+    lock_guard<mutex> lock(mut);
+    auto it = families.find(name);
+    if (it == families.end()) {
+        return;
+    }
+
+    auto& f = it->second;
+    f.counters.erase(labels);
+    f.gauges.erase(labels);
+    f.histograms.erase(labels);
+    if (f.counters.empty() and f.gauges.empty() and f.histograms.empty()) {
+        families.erase(it);
+    }
+}
+
+static string format_value(double v)
+{
+    if (std::isnan(v)) return "NaN";
+    if (std::isinf(v)) return v > 0 ? "+Inf" : "-Inf";
+    // Shortest representation that reads back as the same value
+    char buf[32];
+    for (int precision = 1; precision <= 17; precision++) {
+        snprintf(buf, sizeof(buf), "%.*g", precision, v);
+        if (strtod(buf, nullptr) == v) {
+            break;
+        }
+    }
+    return buf;
+}
+
+static string braces(const string& labels)
+{
+    return labels.empty() ? string() : "{" + labels + "}";
+}
+
+string Registry::render() const
+{
+    stringstream ss;
+
+    lock_guard<mutex> lock(mut);
+    for (const auto& nf : families) {
+        const auto& name = nf.first;
+        const auto& f = nf.second;
+
+        ss << "# HELP " << name << " " << f.help << "\n";
+        switch (f.type) {
+            case Type::Counter:
+                ss << "# TYPE " << name << " counter\n";
+                for (const auto& m : f.counters) {
+                    ss << name << braces(m.first) << " " << m.second->get() << "\n";
+                }
+                break;
+            case Type::Gauge:
+                ss << "# TYPE " << name << " gauge\n";
+                for (const auto& m : f.gauges) {
+                    ss << name << braces(m.first) << " " <<
+                        format_value(m.second->get()) << "\n";
+                }
+                break;
+            case Type::Histogram:
+                ss << "# TYPE " << name << " histogram\n";
+                for (const auto& m : f.histograms) {
+                    const auto v = m.second->get();
+                    const string sep = m.first.empty() ? "" : ",";
+                    for (size_t i = 0; i < v.buckets.size(); i++) {
+                        const string le = i < v.bounds.size() ?
+                            format_value(v.bounds[i]) : "+Inf";
+                        ss << name << "_bucket{" << m.first << sep <<
+                            label("le", le) << "} " << v.buckets[i] << "\n";
+                    }
+                    ss << name << "_sum" << braces(m.first) << " " <<
+                        format_value(v.sum) << "\n";
+                    ss << name << "_count" << braces(m.first) << " " <<
+                        v.count << "\n";
+                }
+                break;
+        }
+    }
+
+    return ss.str();
+}
+
+double thread_cpu_seconds()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+#endif
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace metrics
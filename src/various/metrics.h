@@ -0,0 +1,153 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Process-wide metrics in the Prometheus text exposition format.
+ *
+ * Registering a metric takes a lock and is meant to be done once, outside
+ * of the signal processing loops. The returned reference stays valid until
+ * the metric is removed, and updating it is a single relaxed atomic
+ * operation, so the decoder threads never block on the HTTP server
+ * rendering the metrics. */
+namespace metrics {
+
+class Counter {
+    public:
+        void inc(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value = ATOMIC_VAR_INIT(0);
+};
+
+class Gauge {
+    public:
+        void set(double v) { value.store(v, std::memory_order_relaxed); }
+        void add(double v);
+        double get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value = ATOMIC_VAR_INIT(0.0);
+};
+
+class Histogram {
+    public:
+        // Upper bounds of the buckets in increasing order, the +Inf
+        // bucket is implicit. At most MAX_BUCKETS bounds are used.
+        static constexpr size_t MAX_BUCKETS = 16;
+        explicit Histogram(const std::vector<double>& bounds);
+
+        void observe(double v);
+
+        struct Values {
+            std::vector<double> bounds;
+            // Cumulative, one more than bounds for +Inf
+            std::vector<uint64_t> buckets;
+            double sum = 0.0;
+            uint64_t count = 0;
+        };
+        Values get() const;
+
+    private:
+        std::vector<double> bounds;
+        std::array<std::atomic<uint64_t>, MAX_BUCKETS + 1> buckets;
+        std::atomic<double> sum = ATOMIC_VAR_INIT(0.0);
+        std::atomic<uint64_t> count = ATOMIC_VAR_INIT(0);
+};
+
+// Bucket bounds in seconds suitable for per-frame processing times
+std::vector<double> frame_time_buckets();
+
+// Format one label as key="value", escaping the value
+std::string label(const std::string& key, const std::string& value);
+
+// Join two comma separated lists of labels, either of which may be empty
+std::string join_labels(const std::string& a, const std::string& b);
+
+class Registry {
+    public:
+        // labels is a comma separated list of label() results, or empty.
+        // Asking twice for the same name and labels gives the same metric.
+        Counter& counter(const std::string& name, const std::string& help,
+                const std::string& labels = "");
+        Gauge& gauge(const std::string& name, const std::string& help,
+                const std::string& labels = "");
+        Histogram& histogram(const std::string& name, const std::string& help,
+                const std::vector<double>& bounds,
+                const std::string& labels = "");
+
+        // Forget a metric, e.g. one that is labelled with a client that
+        // disconnected. References to it must not be used afterwards.
+        void remove(const std::string& name, const std::string& labels);
+
+        std::string render() const;
+
+    private:
+        enum class Type { Counter, Gauge, Histogram };
+
+        struct Family {
+            Type type;
+            std::string help;
+            std::map<std::string, std::unique_ptr<Counter> > counters;
+            std::map<std::string, std::unique_ptr<Gauge> > gauges;
+            std::map<std::string, std::unique_ptr<Histogram> > histograms;
+        };
+
+        Family& family(const std::string& name, const std::string& help, Type type);
+
+        mutable std::mutex mut;
+        std::map<std::string, Family> families;
+};
+
+Registry& registry(void);
+
+// Thread CPU time, which excludes the time a thread spends waiting for
+// input. Falls back to the monotonic clock where not available.
+double thread_cpu_seconds(void);
+
+// Observes the thread CPU time spent between construction and destruction.
+class ScopedTimer {
+    public:
+        explicit ScopedTimer(Histogram& h) : h(h), start(thread_cpu_seconds()) {}
+        ~ScopedTimer() { h.observe(thread_cpu_seconds() - start); }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram& h;
+        double start;
+};
+
+} // namespace metrics
@@ -0,0 +1,249 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "sigmf.h"
+#include "libs/json.hpp"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using json = nlohmann::json;
+
+namespace sigmf {
+
+const char *const SYNC_LOSS_LABEL = "welle:sync_loss";
+const char *const DROPPED_LABEL = "welle:dropped";
+
+static const char *SIGMF_VERSION = "1.0.0";
+
+string toJson(const Metadata& meta)
+{
+    json global = {
+        {"core:datatype", meta.datatype},
+        {"core:sample_rate", meta.sampleRate},
+        {"core:version", SIGMF_VERSION},
+    };
+    if (not meta.description.empty()) {
+        global["core:description"] = meta.description;
+    }
+    if (not meta.hardware.empty()) {
+        global["core:hw"] = meta.hardware;
+    }
+    if (not meta.recorder.empty()) {
+        global["core:recorder"] = meta.recorder;
+    }
+    if (not meta.dataset.empty()) {
+        global["core:dataset"] = meta.dataset;
+    }
+    if (not meta.encoding.empty()) {
+        global["welle:encoding"] = meta.encoding;
+    }
+
+    json captures = json::array();
+    for (const auto& c : meta.captures) {
+        json capture = {{"core:sample_start", c.sampleStart}};
+        if (c.frequency > 0) {
+            capture["core:frequency"] = c.frequency;
+        }
+        if (not c.datetime.empty()) {
+            capture["core:datetime"] = c.datetime;
+        }
+        captures.push_back(capture);
+    }
+
+    json annotations = json::array();
+    for (const auto& a : meta.annotations) {
+        json annotation = {
+            {"core:sample_start", a.sampleStart},
+            {"core:sample_count", a.sampleCount},
+        };
+        if (not a.label.empty()) {
+            annotation["core:label"] = a.label;
+        }
+        if (not a.comment.empty()) {
+            annotation["core:comment"] = a.comment;
+        }
+        annotations.push_back(annotation);
+    }
+
+    const json j = {
+        {"global", global},
+        {"captures", captures},
+        {"annotations", annotations},
+    };
+    return j.dump(2);
+}
+
+template<typename T>
+static T get_or(const json& j, const char *key, T def)
+{
+    const auto it = j.find(key);
+    if (it == j.end() or it->is_null()) {
+        return def;
+    }
+    return it->get<T>();
+}
+
+bool fromJson(const string& text, Metadata& meta)
+{
+    try {
+        const json j = json::parse(text);
+        const auto global = j.find("global");
+        if (global == j.end() or not global->is_object() or
+                global->find("core:datatype") == global->end()) {
+            return false;
+        }
+
+        meta = Metadata();
+        meta.datatype = global->at("core:datatype").get<string>();
+        meta.sampleRate = get_or<double>(*global, "core:sample_rate", 0);
+        meta.description = get_or<string>(*global, "core:description", "");
+        meta.hardware = get_or<string>(*global, "core:hw", "");
+        meta.recorder = get_or<string>(*global, "core:recorder", "");
+        meta.dataset = get_or<string>(*global, "core:dataset", "");
+        meta.encoding = get_or<string>(*global, "welle:encoding", "");
+
+        const auto captures = j.find("captures");
+        if (captures != j.end() and captures->is_array()) {
+            for (const auto& c : *captures) {
+                Capture capture;
+                capture.sampleStart = get_or<uint64_t>(c, "core:sample_start", 0);
+                capture.frequency = get_or<double>(c, "core:frequency", 0);
+                capture.datetime = get_or<string>(c, "core:datetime", "");
+                meta.captures.push_back(capture);
+            }
+        }
+
+        const auto annotations = j.find("annotations");
+        if (annotations != j.end() and annotations->is_array()) {
+            for (const auto& a : *annotations) {
+                Annotation annotation;
+                annotation.sampleStart = get_or<uint64_t>(a, "core:sample_start", 0);
+                annotation.sampleCount = get_or<uint64_t>(a, "core:sample_count", 0);
+                annotation.label = get_or<string>(a, "core:label", "");
+                annotation.comment = get_or<string>(a, "core:comment", "");
+                meta.annotations.push_back(annotation);
+            }
+        }
+    }
+    catch (const exception&) {
+        // Not JSON, or a field of the wrong type
+        return false;
+    }
+    return true;
+}
+
+bool read(const string& path, Metadata& meta)
+{
+    ifstream f(path);
+    if (not f) {
+        return false;
+    }
+
+    stringstream ss;
+    ss << f.rdbuf();
+    return fromJson(ss.str(), meta);
+}
+
+bool write(const string& path, const Metadata& meta)
+{
+    // Write to a temporary file first, so that readers never see a
+    // partial file when the metadata is rewritten
+    const string tmp = path + ".tmp";
+    {
+        ofstream f(tmp);
+        f << toJson(meta) << '\n';
+        if (not f) {
+            return false;
+        }
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static bool ends_with(const string& value, const string& ending)
+{
+    return value.size() >= ending.size() and
+        equal(ending.rbegin(), ending.rend(), value.rbegin());
+}
+
+string metaPath(const string& dataPath)
+{
+    static const char *extensions[] = {
+        ".sigmf-data", ".sigmf-meta", ".wiq",
+        ".u8.iq", ".s8.iq", ".s16le.iq", ".s16be.iq", ".cf32.iq", ".iq" };
+
+    for (const char *ext : extensions) {
+        if (ends_with(dataPath, ext)) {
+            return dataPath.substr(0, dataPath.size() - strlen(ext)) + ".sigmf-meta";
+        }
+    }
+    return dataPath + ".sigmf-meta";
+}
+
+string datetime(chrono::system_clock::time_point time)
+{
+    const auto since_epoch = time.time_since_epoch();
+    const time_t t = chrono::duration_cast<chrono::seconds>(since_epoch).count();
+    const long ms = chrono::duration_cast<chrono::milliseconds>(since_epoch).count() % 1000;
+
+    struct tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &t);
+#else
+    gmtime_r(&t, &utc);
+#endif
+
+    char buf[40];
+    const size_t n = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(buf + n, sizeof(buf) - n, ".%03ldZ", ms);
+    return buf;
+}
+
+uint64_t annotatedSamples(const Metadata& meta, const string& label)
+{
+    vector<pair<uint64_t, uint64_t> > ranges;
+    for (const auto& a : meta.annotations) {
+        if (a.label == label and a.sampleCount > 0) {
+            ranges.emplace_back(a.sampleStart, a.sampleStart + a.sampleCount);
+        }
+    }
+    sort(ranges.begin(), ranges.end());
+
+    uint64_t total = 0;
+    uint64_t covered_until = 0;
+    for (const auto& r : ranges) {
+        const uint64_t start = max(r.first, covered_until);
+        if (r.second > start) {
+            total += r.second - start;
+            covered_until = r.second;
+        }
+    }
+    return total;
+}
+
+} // namespace sigmf
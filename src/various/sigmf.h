@@ -0,0 +1,96 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Reading and writing of SigMF metadata, the .sigmf-meta JSON file that
+ * describes an IQ recording in the .sigmf-data file next to it.
+ * See https://github.com/sigmf/SigMF for the specification.
+ *
+ * Only the fields welle.io writes or needs for replay are kept, unknown
+ * fields are ignored when reading. */
+namespace sigmf {
+
+// Annotation label for the samples during which the receiver had no sync
+extern const char *const SYNC_LOSS_LABEL;
+// Annotation label for the place where samples were dropped, the
+// annotation has no samples and the number dropped in its comment
+extern const char *const DROPPED_LABEL;
+
+struct Capture {
+    uint64_t sampleStart = 0;
+    // Center frequency in Hz, 0 if unknown
+    double frequency = 0;
+    // ISO 8601 UTC time of the first sample, empty if unknown
+    std::string datetime;
+};
+
+struct Annotation {
+    uint64_t sampleStart = 0;
+    uint64_t sampleCount = 0;
+    std::string label;
+    std::string comment;
+};
+
+struct Metadata {
+    // SigMF datatype, e.g. "cu8", "ci16_le", "cf32_le"
+    std::string datatype;
+    double sampleRate = 0;
+    std::string description;
+    std::string hardware;
+    std::string recorder;
+
+    // Name of the data file if it does not follow the SigMF naming, and
+    // the welle.io encoding of that file, e.g. "wiq"
+    std::string dataset;
+    std::string encoding;
+
+    std::vector<Capture> captures;
+    std::vector<Annotation> annotations;
+};
+
+std::string toJson(const Metadata& meta);
+
+// Returns false if the text is not valid SigMF metadata
+bool fromJson(const std::string& text, Metadata& meta);
+
+bool read(const std::string& path, Metadata& meta);
+bool write(const std::string& path, const Metadata& meta);
+
+// The metadata file for a data file: its name with the data extension
+// (.sigmf-data, .wiq, or a raw extension like .u8.iq) replaced.
+std::string metaPath(const std::string& dataPath);
+
+std::string datetime(std::chrono::system_clock::time_point time);
+
+// Number of samples covered by the annotations with the given label,
+// overlapping annotations are counted once.
+uint64_t annotatedSamples(const Metadata& meta, const std::string& label);
+
+} // namespace sigmf
@@ -0,0 +1,262 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "spectrum_engine.h"
+#include "MathHelper.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+SpectrumEngine::SpectrumEngine(int fft_size, SampleSource source,
+        chrono::milliseconds period, int num_segments, float smoothing) :
+    fft_size(fft_size),
+    source(source),
+    period(period),
+    num_segments(max(num_segments, 1)),
+    smoothing(smoothing),
+    window(fft_size),
+    fft_handler(fft_size),
+    psd(fft_size),
+    snapshot(make_shared<Snapshot>())
+{
+    // Hann window. The scale makes the windowed periodogram of white noise
+    // comparable to the unwindowed |FFT|^2 the plots used before.
+    float sum_sq = 0.0f;
+    for (int i = 0; i < fft_size; i++) {
+        window[i] = 0.5f - 0.5f * cos(2.0f * (float)M_PI * i / fft_size);
+        sum_sq += window[i] * window[i];
+    }
+    window_scale = fft_size / sum_sq;
+}
+
+SpectrumEngine::~SpectrumEngine()
+{
+    stop();
+}
+
+static int64_t steady_now_ns()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SpectrumEngine::start()
+{
+    lock_guard<mutex> lock(thread_mut);
+    if (running) {
+        return;
+    }
+
+    // The thread may have ended after an idle time
+    if (thread.joinable()) {
+        thread.join();
+    }
+    last_request = steady_now_ns();
+    running = true;
+    thread = std::thread(&SpectrumEngine::run, this);
+}
+
+void SpectrumEngine::startOnDemand(chrono::milliseconds timeout)
+{
+    lock_guard<mutex> lock(thread_mut);
+    idle_timeout = timeout;
+}
+
+void SpectrumEngine::stop()
+{
+    {
+        lock_guard<mutex> lock(thread_mut);
+        running = false;
+        idle_timeout = chrono::milliseconds(0);
+    }
+    thread_cv.notify_all();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SpectrumEngine::reset()
+{
+    {
+        lock_guard<mutex> lock(null_mut);
+        pending_null.clear();
+    }
+
+    lock_guard<mutex> lock(update_mut);
+    avg_power.clear();
+    avg_power_db.clear();
+    avg_null_power.clear();
+    avg_null_power_db.clear();
+
+    auto s = make_shared<Snapshot>();
+    s->generation = ++generation;
+    s->time = chrono::steady_clock::now();
+    atomic_store(&snapshot, shared_ptr<const Snapshot>(move(s)));
+}
+
+void SpectrumEngine::setNullSymbol(vector<DSPCOMPLEX> null_symbol)
+{
+    lock_guard<mutex> lock(null_mut);
+    pending_null = move(null_symbol);
+}
+
+shared_ptr<const SpectrumEngine::Snapshot> SpectrumEngine::getSnapshot()
+{
+    auto s = atomic_load(&snapshot);
+
+    last_request = steady_now_ns();
+    if (not running) {
+        bool on_demand = false;
+        {
+            lock_guard<mutex> lock(thread_mut);
+            on_demand = idle_timeout.count() > 0;
+        }
+        if (on_demand) {
+            start();
+        }
+    }
+    return s;
+}
+
+void SpectrumEngine::run()
+{
+    unique_lock<mutex> lock(thread_mut);
+    while (running) {
+        if (idle_timeout.count() > 0 and
+                steady_now_ns() - last_request > chrono::duration_cast<
+                    chrono::nanoseconds>(idle_timeout).count()) {
+            // Nobody looks, the next getSnapshot() starts a new thread
+            reset();
+            running = false;
+            return;
+        }
+
+        lock.unlock();
+        update();
+        lock.lock();
+        thread_cv.wait_for(lock, period, [&]{ return not running; });
+    }
+}
+
+void SpectrumEngine::update()
+{
+    lock_guard<mutex> lock(update_mut);
+
+    bool updated = false;
+
+    // Ask for as many samples as num_segments segments with 50% overlap need
+    const int num_samples = (num_segments + 1) * fft_size / 2;
+    const auto samples = source(num_samples);
+    if (welch(samples, psd)) {
+        smooth(psd, avg_power, avg_power_db);
+        updated = true;
+    }
+
+    vector<DSPCOMPLEX> null_symbol;
+    {
+        lock_guard<mutex> null_lock(null_mut);
+        null_symbol.swap(pending_null);
+    }
+
+    if (welch(null_symbol, psd)) {
+        smooth(psd, avg_null_power, avg_null_power_db);
+        updated = true;
+    }
+
+    if (updated) {
+        auto s = make_shared<Snapshot>();
+        s->generation = ++generation;
+        s->time = chrono::steady_clock::now();
+        s->power = avg_power;
+        s->power_db = avg_power_db;
+        s->null_power = avg_null_power;
+        s->null_power_db = avg_null_power_db;
+        atomic_store(&snapshot, shared_ptr<const Snapshot>(move(s)));
+    }
+}
+
+bool SpectrumEngine::welch(const vector<DSPCOMPLEX>& samples, vector<float>& out)
+{
+    if (samples.size() < (size_t)fft_size) {
+        return false;
+    }
+
+    const size_t hop = fft_size / 2;
+    const size_t segments = 1 + (samples.size() - fft_size) / hop;
+
+    fill(out.begin(), out.end(), 0.0f);
+
+    DSPCOMPLEX *buf = fft_handler.getVector();
+
+    // Use the most recent samples
+    const size_t start = samples.size() - ((segments - 1) * hop + fft_size);
+    for (size_t seg = 0; seg < segments; seg++) {
+        const DSPCOMPLEX *in = samples.data() + start + seg * hop;
+        for (int i = 0; i < fft_size; i++) {
+            buf[i] = in[i] * window[i];
+        }
+
+        fft_handler.do_FFT();
+
+        // Operate on the interleaved floats so that the compiler can
+        // vectorise the squared magnitude accumulation.
+        const float *iq = reinterpret_cast<const float*>(buf);
+        float *acc = out.data();
+        for (int i = 0; i < fft_size; i++) {
+            const float re = iq[2*i];
+            const float im = iq[2*i+1];
+            acc[i] += re * re + im * im;
+        }
+    }
+
+    const float scale = window_scale / segments;
+    for (int i = 0; i < fft_size; i++) {
+        out[i] *= scale;
+    }
+    return true;
+}
+
+void SpectrumEngine::smooth(const vector<float>& in,
+        vector<float>& power, vector<float>& power_db)
+{
+    const bool first = power.size() != (size_t)fft_size;
+    if (first) {
+        power.resize(fft_size);
+        power_db.resize(fft_size);
+    }
+
+    // Shift FFT samples so that DC is in the middle
+    const int half = fft_size / 2;
+    for (int i = 0; i < fft_size; i++) {
+        const float p = in[(i + half) % fft_size];
+        power[i] = first ? p : power[i] + smoothing * (p - power[i]);
+    }
+
+    for (int i = 0; i < fft_size; i++) {
+        power_db[i] = fast_10log10(power[i]);
+    }
+}
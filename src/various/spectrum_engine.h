@@ -0,0 +1,144 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dab-constants.h"
+#include "fft.h"
+
+/* Computes the signal spectrum and the NULL symbol spectrum in a
+ * background thread at a fixed rate, and publishes the result as an
+ * immutable snapshot. Any number of readers (HTTP clients, the GUI)
+ * can take the current snapshot without ever running an FFT themselves.
+ *
+ * The power spectral density is estimated with Welch's method: the input
+ * is cut into Hann-windowed segments with 50% overlap, whose periodograms
+ * are averaged. Successive estimates are additionally smoothed with an
+ * exponential moving average.
+ *
+ * Started with startOnDemand(), the thread only runs while snapshots are
+ * taken, and forgets the averages when it goes idle. */
+class SpectrumEngine {
+    public:
+        struct Snapshot {
+            // Incremented every time a new snapshot is published
+            uint64_t generation = 0;
+            std::chrono::steady_clock::time_point time;
+
+            // Averaged power per bin with DC in the middle, scaled so that
+            // sqrt(power) is comparable to the magnitude of an unwindowed FFT.
+            // Empty until enough samples were received.
+            std::vector<float> power;
+            std::vector<float> power_db;
+
+            std::vector<float> null_power;
+            std::vector<float> null_power_db;
+        };
+
+        // Returns the most recent num_samples samples of the input,
+        // or fewer if not available. Called from the engine thread.
+        using SampleSource = std::function<std::vector<DSPCOMPLEX>(int num_samples)>;
+
+        SpectrumEngine(int fft_size, SampleSource source,
+                std::chrono::milliseconds period = std::chrono::milliseconds(100),
+                int num_segments = 4,
+                float smoothing = 0.2f);
+        ~SpectrumEngine();
+        SpectrumEngine(const SpectrumEngine&) = delete;
+        SpectrumEngine& operator=(const SpectrumEngine&) = delete;
+
+        void start();
+        void stop();
+
+        // Start the thread at the next getSnapshot(), and stop it again
+        // when no snapshot was taken for idle_timeout
+        void startOnDemand(std::chrono::milliseconds idle_timeout);
+
+        // Forget the averaged spectra, e.g. after a retune
+        void reset();
+
+        // Hand a new NULL symbol to the engine, it will be
+        // transformed at the next update.
+        void setNullSymbol(std::vector<DSPCOMPLEX> null_symbol);
+
+        // Never returns nullptr. The first snapshots after an idle
+        // time are empty.
+        std::shared_ptr<const Snapshot> getSnapshot();
+
+        // Run one update synchronously, the thread calls this at every period.
+        void update();
+
+    private:
+        void run();
+
+        // Welch estimate of samples into the unshifted periodogram
+        // accumulator. Returns false if there are less than fft_size samples.
+        bool welch(const std::vector<DSPCOMPLEX>& samples, std::vector<float>& psd);
+
+        // fftshift, exponential smoothing and dB conversion
+        void smooth(const std::vector<float>& psd,
+                std::vector<float>& power, std::vector<float>& power_db);
+
+        const int fft_size;
+        const SampleSource source;
+        const std::chrono::milliseconds period;
+        const int num_segments;
+        const float smoothing;
+
+        std::vector<float> window;
+        float window_scale = 1.0f;
+
+        // Owned by the thread running update()
+        std::mutex update_mut;
+        fft::Forward fft_handler;
+        std::vector<float> psd;
+        std::vector<float> avg_power;
+        std::vector<float> avg_power_db;
+        std::vector<float> avg_null_power;
+        std::vector<float> avg_null_power_db;
+        uint64_t generation = 0;
+
+        std::mutex null_mut;
+        std::vector<DSPCOMPLEX> pending_null;
+
+        std::shared_ptr<const Snapshot> snapshot;
+
+        std::atomic<bool> running = ATOMIC_VAR_INIT(false);
+        // Zero unless started on demand
+        std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0);
+        // Of the last getSnapshot(), in steady_clock nanoseconds
+        std::atomic<int64_t> last_request = ATOMIC_VAR_INIT(0);
+        std::mutex thread_mut;
+        std::condition_variable thread_cv;
+        std::thread thread;
+};
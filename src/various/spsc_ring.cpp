@@ -0,0 +1,103 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "various/spsc_ring.h"
+#include <iostream>
+
+#if defined(__linux__)
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+RingMemory::RingMemory(size_t size, bool mirrored) :
+    bytes(size)
+{
+    if (mirrored and mapMirrored()) {
+        this->mirrored = true;
+        return;
+    }
+
+    heap.reset(new uint8_t[bytes]);
+    base = heap.get();
+}
+
+RingMemory::~RingMemory()
+{
+#if defined(__linux__)
+    if (mirrored) {
+        munmap(base, 2 * bytes);
+    }
+#endif
+}
+
+bool RingMemory::mapMirrored()
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+    const long page_size = sysconf(_SC_PAGESIZE);
+    if (page_size <= 0 or bytes == 0 or bytes % page_size != 0) {
+        return false;
+    }
+
+    const int fd = syscall(SYS_memfd_create, "welle-ring", 0);
+    if (fd == -1) {
+        return false;
+    }
+
+    if (ftruncate(fd, bytes) == -1) {
+        close(fd);
+        return false;
+    }
+
+    // Reserve the address range first, then map the file twice into it
+    void *addr = mmap(nullptr, 2 * bytes, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    uint8_t *first = static_cast<uint8_t*>(addr);
+    const bool ok =
+        mmap(first, bytes, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED and
+        mmap(first + bytes, bytes, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+
+    // The mappings keep the memory alive
+    close(fd);
+
+    if (not ok) {
+        std::clog << "RingMemory: mirrored mapping failed" << std::endl;
+        munmap(addr, 2 * bytes);
+        return false;
+    }
+
+    base = first;
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,281 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+/* Storage for a ring buffer. When mirrored, the pages are mapped twice
+ * back to back, so that any range of up to size() bytes that starts in
+ * the first mapping is contiguous in memory.
+ *
+ * Mirroring needs a size that is a multiple of the page size and support
+ * from the operating system (currently Linux). Otherwise the memory is
+ * plain, and isMirrored() returns false. */
+class RingMemory {
+    public:
+        RingMemory(size_t size, bool mirrored);
+        ~RingMemory();
+        RingMemory(const RingMemory&) = delete;
+        RingMemory& operator=(const RingMemory&) = delete;
+
+        uint8_t *data() const { return base; }
+        size_t size() const { return bytes; }
+        bool isMirrored() const { return mirrored; }
+
+    private:
+        bool mapMirrored();
+
+        uint8_t *base = nullptr;
+        size_t bytes = 0;
+        bool mirrored = false;
+        std::unique_ptr<uint8_t[]> heap;
+};
+
+// A contiguous range of elements inside a SpscRing
+template <class T>
+struct RingSpan {
+    T *data = nullptr;
+    size_t size = 0;
+
+    T *begin() const { return data; }
+    T *end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    T& operator[](size_t i) const { return data[i]; }
+};
+
+/* Lock-free ring buffer for exactly one producer and one consumer thread.
+ *
+ * The indices count elements since the creation of the ring and are only
+ * masked to access the storage, so full and empty need no special case.
+ * Each side publishes its index with a release store and reads the other
+ * one with an acquire load, and keeps a cached copy of the other index so
+ * that it only touches the shared cache line when its cached view says
+ * the ring is full or empty.
+ *
+ * Besides the copying push() and pop(), the producer can reserve() space,
+ * convert directly into it and commit() it, and the consumer can peek()
+ * at the data, process it in place and consume() it. With a mirrored ring
+ * the spans always cover everything requested that is available; without,
+ * they stop at the end of the storage and a second call returns the rest. */
+template <class T>
+class SpscRing
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+            "SpscRing elements are copied with memcpy");
+
+    public:
+        // elementCount is rounded up to a power of two
+        explicit SpscRing(size_t elementCount, bool mirrored = false) :
+            numElements(roundUpPowerOfTwo(elementCount)),
+            mask(numElements - 1),
+            memory(numElements * sizeof(T), mirrored),
+            buffer(reinterpret_cast<T*>(memory.data())) {}
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        size_t capacity() const { return numElements; }
+        bool isMirrored() const { return memory.isMirrored(); }
+
+        // Can be called from any thread, the result is a snapshot
+        size_t readAvailable() const {
+            const size_t w = writeIndex.load(std::memory_order_acquire);
+            const size_t r = std::max(readIndex.load(std::memory_order_acquire),
+                    discardIndex.load(std::memory_order_acquire));
+            return w > r ? w - r : 0;
+        }
+
+        size_t writeAvailable() const {
+            return numElements - (writeIndex.load(std::memory_order_acquire) -
+                    readIndex.load(std::memory_order_acquire));
+        }
+
+        /* Producer side */
+
+        // Up to n contiguous free elements, to be filled and then committed
+        RingSpan<T> reserve(size_t n) {
+            const size_t w = writeIndex.load(std::memory_order_relaxed);
+            size_t free = numElements - (w - cachedReadIndex);
+            if (free < n) {
+                cachedReadIndex = readIndex.load(std::memory_order_acquire);
+                free = numElements - (w - cachedReadIndex);
+            }
+            return span(w, std::min(n, free));
+        }
+
+        // Publish n elements of the last reserved span
+        void commit(size_t n) {
+            writeIndex.store(writeIndex.load(std::memory_order_relaxed) + n,
+                    std::memory_order_release);
+        }
+
+        // Fill up to n elements in place: f(T *data, size_t count) is called
+        // for each contiguous part, at most twice, and the parts are
+        // committed. Returns the number of elements written.
+        template <class F>
+        size_t writeInPlace(size_t n, F&& f) {
+            size_t written = 0;
+            while (written < n) {
+                const auto s = reserve(n - written);
+                if (s.empty()) {
+                    break;
+                }
+                f(s.data, s.size);
+                commit(s.size);
+                written += s.size;
+            }
+            return written;
+        }
+
+        // Copy up to n elements into the ring, returns the number written.
+        // What does not fit is dropped.
+        size_t push(const T *data, size_t n) {
+            return writeInPlace(n, [&](T *dst, size_t count) {
+                    memcpy(dst, data, count * sizeof(T));
+                    data += count;
+                });
+        }
+
+        /* Consumer side */
+
+        // Up to n contiguous readable elements, to be processed and then consumed
+        RingSpan<const T> peek(size_t n) {
+            const size_t r = consumerIndex();
+            // The cached index can be behind a flush()
+            size_t avail = cachedWriteIndex > r ? cachedWriteIndex - r : 0;
+            if (avail < n) {
+                cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+                avail = cachedWriteIndex - r;
+            }
+            const auto s = span(r, std::min(n, avail));
+            return RingSpan<const T>{s.data, s.size};
+        }
+
+        // Release n elements of the last peeked span back to the producer
+        void consume(size_t n) {
+            readIndex.store(readIndex.load(std::memory_order_relaxed) + n,
+                    std::memory_order_release);
+        }
+
+        // Process up to n elements in place: f(const T *data, size_t count)
+        // is called for each contiguous part, at most twice, and the parts
+        // are consumed. Returns the number of elements read.
+        template <class F>
+        size_t readInPlace(size_t n, F&& f) {
+            size_t read = 0;
+            while (read < n) {
+                const auto s = peek(n - read);
+                if (s.empty()) {
+                    break;
+                }
+                f(s.data, s.size);
+                consume(s.size);
+                read += s.size;
+            }
+            return read;
+        }
+
+        // Copy up to n elements out of the ring, returns the number read
+        size_t pop(T *data, size_t n) {
+            return readInPlace(n, [&](const T *src, size_t count) {
+                    memcpy(data, src, count * sizeof(T));
+                    data += count;
+                });
+        }
+
+        size_t skip(size_t n) {
+            const size_t r = consumerIndex();
+            cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+            n = std::min(n, cachedWriteIndex - r);
+            consume(n);
+            return n;
+        }
+
+        // Drop everything written so far. Unlike the other functions, this
+        // one can be called from any thread: the consumer skips the data
+        // the next time it reads.
+        void flush() {
+            const size_t w = writeIndex.load(std::memory_order_acquire);
+            size_t d = discardIndex.load(std::memory_order_relaxed);
+            while (d < w and not discardIndex.compare_exchange_weak(d, w,
+                        std::memory_order_acq_rel)) {
+            }
+        }
+
+    private:
+        static constexpr size_t CACHE_LINE = 64;
+
+        static size_t roundUpPowerOfTwo(size_t n) {
+            size_t p = 1;
+            while (p < n) {
+                p <<= 1;
+            }
+            return p;
+        }
+
+        RingSpan<T> span(size_t index, size_t n) const {
+            const size_t offset = index & mask;
+            if (not memory.isMirrored()) {
+                n = std::min(n, numElements - offset);
+            }
+            return RingSpan<T>{buffer + offset, n};
+        }
+
+        // Read index of the consumer, after applying a pending flush()
+        size_t consumerIndex() {
+            const size_t r = readIndex.load(std::memory_order_relaxed);
+            const size_t d = discardIndex.load(std::memory_order_acquire);
+            if (d > r) {
+                readIndex.store(d, std::memory_order_release);
+                return d;
+            }
+            return r;
+        }
+
+        const size_t numElements;
+        const size_t mask;
+        RingMemory memory;
+        T * const buffer;
+
+        // Keep the state of each side on its own cache line, away from
+        // the read-only members above.
+        char padding0[CACHE_LINE];
+
+        std::atomic<size_t> writeIndex = ATOMIC_VAR_INIT(0);
+        size_t cachedReadIndex = 0;
+        char padding1[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+        std::atomic<size_t> readIndex = ATOMIC_VAR_INIT(0);
+        size_t cachedWriteIndex = 0;
+        char padding2[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+        std::atomic<size_t> discardIndex = ATOMIC_VAR_INIT(0);
+};
@@ -0,0 +1,476 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "welle-cli/epgstore.h"
+#include "libs/json.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using json = nlohmann::json;
+
+constexpr time_t EpgStore::KEEP_PAST;
+constexpr uint32_t EpgStore::MAX_DURATION;
+
+// Increment when the meaning of the fields changes, older files are ignored
+static const int FILE_VERSION = 1;
+
+// 64-bit FNV-1a
+static uint64_t fnv1a(const vector<uint8_t>& data)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (const uint8_t b : data) {
+        h ^= b;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static json description_to_json(const SpiDescription& d)
+{
+    return {
+        {"shortname", d.short_name},
+        {"mediumname", d.medium_name},
+        {"longname", d.long_name},
+        {"shortdescription", d.short_description},
+        {"longdescription", d.long_description},
+        {"genres", d.genres},
+    };
+}
+
+static void description_from_json(const json& j, SpiDescription& d)
+{
+    d.short_name = j.at("shortname").get<string>();
+    d.medium_name = j.at("mediumname").get<string>();
+    d.long_name = j.at("longname").get<string>();
+    d.short_description = j.at("shortdescription").get<string>();
+    d.long_description = j.at("longdescription").get<string>();
+    d.genres = j.at("genres").get<vector<string> >();
+}
+
+EpgStore::EpgStore(const string& directory) :
+    directory(directory)
+{
+}
+
+bool EpgStore::update(const string& name, int content_sub_type,
+        const vector<uint8_t>& data, time_t now)
+{
+    if (content_sub_type != SpiDecoder::CONTENT_SUB_TYPE_PI and
+            content_sub_type != SpiDecoder::CONTENT_SUB_TYPE_SI) {
+        return false;
+    }
+
+    const uint64_t hash = fnv1a(data);
+
+    lock_guard<mutex> lock(mut);
+    auto o = objects.find(name);
+    if (o != objects.end() and o->second.hash == hash) {
+        repetitions++;
+        return false;
+    }
+
+    // A damaged object is tried again at its next repetition
+    if (content_sub_type == SpiDecoder::CONTENT_SUB_TYPE_PI) {
+        if (not decoder.decodeProgrammeInformation(data.data(), data.size(), schedule)) {
+            return false;
+        }
+
+        removeObject(name);
+        auto& record = objects[name];
+        record.hash = hash;
+        for (const auto& p : schedule.programmes) {
+            if (p.service_id == 0 or p.stop() + KEEP_PAST < now) {
+                continue;
+            }
+            record.programmes.emplace_back(p.service_id, p.start);
+            insert(p, name);
+        }
+    }
+    else {
+        if (not decoder.decodeServiceInformation(data.data(), data.size(), decoded_services)) {
+            return false;
+        }
+
+        removeObject(name);
+        auto& record = objects[name];
+        record.hash = hash;
+        for (const auto& s : decoded_services) {
+            record.services.push_back(s.service_id);
+            services[s.service_id] = s;
+        }
+    }
+
+    prune(now);
+    generation++;
+    return true;
+}
+
+void EpgStore::removeObject(const string& name)
+{
+    auto o = objects.find(name);
+    if (o == objects.end()) {
+        return;
+    }
+
+    // Another object may have replaced the programme since
+    for (const auto& key : o->second.programmes) {
+        auto it = programmes.find(key);
+        if (it != programmes.end() and it->second.object == name) {
+            erase(it);
+        }
+    }
+    for (const auto sid : o->second.services) {
+        services.erase(sid);
+    }
+    objects.erase(o);
+}
+
+void EpgStore::insert(SpiProgramme p, const string& object)
+{
+    p.duration = min(p.duration, MAX_DURATION);
+
+    const Key key(p.service_id, p.start);
+    auto it = programmes.find(key);
+    if (it != programmes.end()) {
+        erase(it);
+    }
+
+    for (const auto& genre : p.genres) {
+        genres[genre].insert(key);
+    }
+
+    Entry& e = programmes[key];
+    e.programme = move(p);
+    e.object = object;
+}
+
+void EpgStore::erase(map<Key, Entry>::iterator it)
+{
+    for (const auto& genre : it->second.programme.genres) {
+        auto g = genres.find(genre);
+        if (g != genres.end()) {
+            g->second.erase(it->first);
+            if (g->second.empty()) {
+                genres.erase(g);
+            }
+        }
+    }
+    programmes.erase(it);
+}
+
+void EpgStore::prune(time_t now)
+{
+    for (auto it = programmes.begin(); it != programmes.end();) {
+        auto next = std::next(it);
+        if (it->second.programme.stop() + KEEP_PAST < now) {
+            erase(it);
+        }
+        it = next;
+    }
+
+    // Forget the objects that have nothing left
+    for (auto o = objects.begin(); o != objects.end();) {
+        const auto& name = o->first;
+        const auto& record = o->second;
+        bool in_use = not record.services.empty();
+        for (const auto& key : record.programmes) {
+            auto it = programmes.find(key);
+            if (it != programmes.end() and it->second.object == name) {
+                in_use = true;
+                break;
+            }
+        }
+
+        if (in_use) {
+            ++o;
+        }
+        else {
+            o = objects.erase(o);
+        }
+    }
+}
+
+vector<SpiProgramme> EpgStore::query(const Query& q) const
+{
+    vector<SpiProgramme> result;
+
+    auto overlaps = [&](const SpiProgramme& p) {
+        const bool after_from = p.duration == 0 ?
+            p.start >= q.from : p.stop() > q.from;
+        return after_from and (q.to == 0 or p.start < q.to);
+    };
+
+    lock_guard<mutex> lock(mut);
+
+    if (not q.genre.empty()) {
+        set<Key> keys;
+        for (auto g = genres.lower_bound(q.genre); g != genres.end() and
+                g->first.compare(0, q.genre.size(), q.genre) == 0; ++g) {
+            // "3.6" must not give "3.60"
+            if (g->first.size() > q.genre.size() and g->first[q.genre.size()] != '.') {
+                continue;
+            }
+            for (const auto& key : g->second) {
+                if (q.service_id == 0 or key.first == q.service_id) {
+                    keys.insert(key);
+                }
+            }
+        }
+
+        for (const auto& key : keys) {
+            const auto& p = programmes.at(key).programme;
+            if (overlaps(p)) {
+                result.push_back(p);
+            }
+        }
+        return result;
+    }
+
+    // Jump from service to service, to the programmes that
+    // can overlap the window.
+    const time_t search_from = q.from - MAX_DURATION;
+    auto it = programmes.lower_bound(Key(q.service_id, search_from));
+    while (it != programmes.end()) {
+        const uint32_t sid = it->first.first;
+        if (q.service_id != 0 and sid != q.service_id) {
+            break;
+        }
+        if (it->first.second < search_from) {
+            it = programmes.lower_bound(Key(sid, search_from));
+            continue;
+        }
+
+        for (; it != programmes.end() and it->first.first == sid and
+                (q.to == 0 or it->first.second < q.to); ++it) {
+            if (overlaps(it->second.programme)) {
+                result.push_back(it->second.programme);
+            }
+        }
+
+        if (sid == UINT32_MAX) {
+            break;
+        }
+        it = programmes.lower_bound(Key(sid + 1, search_from));
+    }
+    return result;
+}
+
+vector<SpiService> EpgStore::getServices() const
+{
+    lock_guard<mutex> lock(mut);
+    vector<SpiService> result;
+    for (const auto& s : services) {
+        result.push_back(s.second);
+    }
+    return result;
+}
+
+size_t EpgStore::getNumProgrammes() const
+{
+    lock_guard<mutex> lock(mut);
+    return programmes.size();
+}
+
+size_t EpgStore::getRepetitions() const
+{
+    lock_guard<mutex> lock(mut);
+    return repetitions;
+}
+
+uint64_t EpgStore::getGeneration() const
+{
+    lock_guard<mutex> lock(mut);
+    return generation;
+}
+
+string EpgStore::path() const
+{
+    return directory + "/epg.json";
+}
+
+bool EpgStore::load(time_t now)
+{
+    if (directory.empty()) {
+        return false;
+    }
+
+    ifstream f(path());
+    if (not f) {
+        return false;
+    }
+    stringstream ss;
+    ss << f.rdbuf();
+
+    lock_guard<mutex> lock(mut);
+    return fromJson(ss.str(), now);
+}
+
+bool EpgStore::save()
+{
+    lock_guard<mutex> save_lock(save_mut);
+
+    string text;
+    uint64_t gen = 0;
+    {
+        lock_guard<mutex> lock(mut);
+        if (directory.empty() or generation == generation_saved) {
+            return false;
+        }
+        text = toJson();
+        gen = generation;
+    }
+
+    // Write to a temporary file first, so that a crash never leaves
+    // a partial file behind
+    const string tmp = path() + ".tmp";
+    {
+        ofstream f(tmp);
+        f << text;
+        if (not f) {
+            return false;
+        }
+    }
+    if (rename(tmp.c_str(), path().c_str()) != 0) {
+        return false;
+    }
+
+    lock_guard<mutex> lock(mut);
+    generation_saved = gen;
+    return true;
+}
+
+string EpgStore::toJson() const
+{
+    json jobjects = json::array();
+    for (const auto& o : objects) {
+        jobjects.push_back({
+                {"name", o.first},
+                {"hash", o.second.hash},
+                {"services", o.second.services},
+            });
+    }
+
+    json jservices = json::array();
+    for (const auto& s : services) {
+        json js = description_to_json(s.second);
+        js["sid"] = s.first;
+        jservices.push_back(js);
+    }
+
+    json jprogrammes = json::array();
+    for (const auto& e : programmes) {
+        const auto& p = e.second.programme;
+        json jp = description_to_json(p);
+        jp["sid"] = p.service_id;
+        jp["start"] = (int64_t)p.start;
+        jp["duration"] = p.duration;
+        jp["id"] = p.id;
+        jp["shortid"] = p.short_id;
+        jp["object"] = e.second.object;
+        jprogrammes.push_back(jp);
+    }
+
+    const json j = {
+        {"version", FILE_VERSION},
+        {"objects", jobjects},
+        {"services", jservices},
+        {"programmes", jprogrammes},
+    };
+    return j.dump();
+}
+
+bool EpgStore::fromJson(const string& text, time_t now)
+{
+    programmes.clear();
+    genres.clear();
+    services.clear();
+    objects.clear();
+
+    try {
+        const json j = json::parse(text);
+        if (j.at("version").get<int>() != FILE_VERSION) {
+            return false;
+        }
+
+        for (const auto& jo : j.at("objects")) {
+            auto& record = objects[jo.at("name").get<string>()];
+            record.hash = jo.at("hash").get<uint64_t>();
+            record.services = jo.at("services").get<vector<uint32_t> >();
+        }
+
+        for (const auto& js : j.at("services")) {
+            SpiService s;
+            description_from_json(js, s);
+            s.service_id = js.at("sid").get<uint32_t>();
+            services[s.service_id] = move(s);
+        }
+
+        for (const auto& jp : j.at("programmes")) {
+            SpiProgramme p;
+            description_from_json(jp, p);
+            p.service_id = jp.at("sid").get<uint32_t>();
+            p.start = jp.at("start").get<int64_t>();
+            p.duration = jp.at("duration").get<uint32_t>();
+            p.id = jp.at("id").get<string>();
+            p.short_id = jp.at("shortid").get<uint32_t>();
+
+            const string object = jp.at("object").get<string>();
+            objects[object].programmes.emplace_back(p.service_id, p.start);
+            insert(move(p), object);
+        }
+    }
+    catch (const exception&) {
+        programmes.clear();
+        genres.clear();
+        services.clear();
+        objects.clear();
+        return false;
+    }
+
+    prune(now);
+    generation_saved = generation;
+    return true;
+}
+
+void EpgDataHandler::onDataGroup(uint16_t /*packetAddress*/, vector<uint8_t>&& data)
+{
+    if (not mot_manager.HandleMOTDataGroup(data)) {
+        return;
+    }
+
+    while (mot_manager.HasFile()) {
+        const MOT_FILE file = mot_manager.GetFile();
+        if (file.content_type != SpiDecoder::CONTENT_TYPE) {
+            continue;
+        }
+
+        const string name = file.content_name.empty() ?
+            "tid-" + to_string(file.transport_id) : file.content_name;
+        store.update(name, file.content_sub_type, file.data, time(nullptr));
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "backend/mot_manager.h"
+#include "backend/radio-controller.h"
+#include "backend/spi-decoder.h"
+
+/* Programme guide of all services, built from the Service and Programme
+ * Information objects of the SPI data services.
+ *
+ * The programmes are indexed by service and start time, and by genre.
+ * Every object replaces the programmes it brought the previous time, so
+ * the guide follows the updates of the broadcaster. An object that the
+ * carousel repeats unchanged is recognised by its hash and not decoded
+ * again. Programmes that ended more than KEEP_PAST ago are forgotten.
+ *
+ * With a directory, the guide is saved there and loaded again at the
+ * next start. The receivers of several channels share one store, so
+ * that they do not overwrite each other's file. */
+class EpgStore {
+    public:
+        static constexpr std::time_t KEEP_PAST = 6 * 3600;
+
+        // Longer durations are cut, this bounds the search for the
+        // programmes that started before a time window.
+        static constexpr uint32_t MAX_DURATION = 24 * 3600;
+
+        struct Query {
+            // 0 for all services
+            uint32_t service_id = 0;
+            // Programmes that overlap [from, to)
+            std::time_t from = 0;
+            std::time_t to = 0;
+            // Classification term or one of its parents, e.g. "3.6"
+            // also gives "3.6.8". Empty for all genres.
+            std::string genre;
+        };
+
+        // The directory must exist, an empty string disables saving
+        explicit EpgStore(const std::string& directory = "");
+        EpgStore(const EpgStore&) = delete;
+        EpgStore& operator=(const EpgStore&) = delete;
+
+        // Add an SPI object, name is its MOT content name. Returns true
+        // if the guide changed.
+        bool update(const std::string& name, int content_sub_type,
+                const std::vector<uint8_t>& data, std::time_t now);
+
+        // Sorted by service and start time
+        std::vector<SpiProgramme> query(const Query& q) const;
+        std::vector<SpiService> getServices() const;
+
+        size_t getNumProgrammes() const;
+        // Objects skipped because they were known already
+        size_t getRepetitions() const;
+        // Incremented at every change
+        uint64_t getGeneration() const;
+
+        // Does nothing and returns false without a directory
+        bool load(std::time_t now);
+        // Only writes the file if the guide changed since the last save
+        bool save();
+
+    private:
+        // Service, start time
+        using Key = std::pair<uint32_t, std::time_t>;
+
+        struct Entry {
+            SpiProgramme programme;
+            // Name of the object that brought it
+            std::string object;
+        };
+
+        struct ObjectRecord {
+            uint64_t hash = 0;
+            std::vector<Key> programmes;
+            std::vector<uint32_t> services;
+        };
+
+        std::string path() const;
+        void removeObject(const std::string& name);
+        void insert(SpiProgramme p, const std::string& object);
+        void erase(std::map<Key, Entry>::iterator it);
+        void prune(std::time_t now);
+        std::string toJson() const;
+        bool fromJson(const std::string& text, std::time_t now);
+
+        const std::string directory;
+
+        mutable std::mutex mut;
+        std::map<Key, Entry> programmes;
+        std::map<std::string, std::set<Key> > genres;
+        std::map<uint32_t, SpiService> services;
+        std::map<std::string, ObjectRecord> objects;
+
+        // Reused from object to object
+        SpiDecoder decoder;
+        SpiDecoder::Schedule schedule;
+        std::vector<SpiService> decoded_services;
+
+        size_t repetitions = 0;
+        uint64_t generation = 0;
+        uint64_t generation_saved = 0;
+
+        // Held during save(), the receivers of all channels save
+        mutable std::mutex save_mut;
+};
+
+/* Reassembles the MOT objects of an SPI service component and hands them
+ * to the store. */
+class EpgDataHandler : public PacketDataHandlerInterface {
+    public:
+        explicit EpgDataHandler(EpgStore& store) : store(store) {}
+
+        virtual void onDataGroup(uint16_t packetAddress,
+                std::vector<uint8_t>&& data) override;
+
+    private:
+        EpgStore& store;
+        MOTManager mot_manager;
+};
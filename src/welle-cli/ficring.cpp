@@ -0,0 +1,150 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "welle-cli/ficring.h"
+#include "backend/tools.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+constexpr size_t FicRing::FIB_LENGTH;
+constexpr size_t FicRing::CAPACITY;
+constexpr size_t FicRing::MAX_STAGED;
+
+static_assert((FicRing::CAPACITY & (FicRing::CAPACITY - 1)) == 0,
+        "FicRing capacity must be a power of two");
+
+static array<uint8_t, FicRing::FIB_LENGTH> make_gap_marker()
+{
+    array<uint8_t, FicRing::FIB_LENGTH> marker;
+    marker.fill(0xFF);
+
+    const size_t data_len = FicRing::FIB_LENGTH - CalcCRC::CRCLen;
+    uint16_t crc = CalcCRC::CalcCRC_CRC16_CCITT.Calc(marker.data(), data_len);
+    crc = ~crc;
+    marker[data_len] = crc >> 8;
+    marker[data_len + 1] = crc & 0xFF;
+    return marker;
+}
+
+const array<uint8_t, FicRing::FIB_LENGTH>& FicRing::gapMarker()
+{
+    static const auto marker = make_gap_marker();
+    return marker;
+}
+
+void FicRing::stage(const uint8_t *fib_bits)
+{
+    if (num_staged == MAX_STAGED) {
+        commit();
+    }
+
+    // Convert the fib bitvector to bytes
+    uint8_t *dst = staging.data() + num_staged * FIB_LENGTH;
+    for (size_t i = 0; i < FIB_LENGTH; i++) {
+        uint8_t v = 0;
+        for (int j = 0; j < 8; j++) {
+            v = (v << 1) | (fib_bits[8*i+j] & 1);
+        }
+        dst[i] = v;
+    }
+    num_staged++;
+}
+
+void FicRing::commit()
+{
+    if (num_staged == 0) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(mut);
+        for (size_t i = 0; i < num_staged; i++) {
+            const size_t slot = (write_seq % CAPACITY) * FIB_LENGTH;
+            memcpy(fibs.data() + slot,
+                    staging.data() + i * FIB_LENGTH, FIB_LENGTH);
+            write_seq++;
+        }
+    }
+    num_staged = 0;
+
+    cv.notify_all();
+}
+
+void FicRing::discardStaged()
+{
+    num_staged = 0;
+}
+
+uint64_t FicRing::oldest() const
+{
+    lock_guard<mutex> lock(mut);
+    return write_seq > CAPACITY ? write_seq - CAPACITY : 0;
+}
+
+uint64_t FicRing::head() const
+{
+    lock_guard<mutex> lock(mut);
+    return write_seq;
+}
+
+size_t FicRing::read(uint64_t& cursor, uint8_t *dst, size_t max_fibs,
+        uint64_t& lost, chrono::milliseconds timeout)
+{
+    lost = 0;
+
+    unique_lock<mutex> lock(mut);
+    if (cursor >= write_seq) {
+        cv.wait_for(lock, timeout, [&]{ return cursor < write_seq; });
+    }
+
+    if (cursor > write_seq) {
+        // Cursor from before a reset of the producer, or bogus
+        cursor = write_seq;
+    }
+
+    const uint64_t oldest_available =
+        write_seq > CAPACITY ? write_seq - CAPACITY : 0;
+    if (cursor < oldest_available) {
+        lost = oldest_available - cursor;
+        cursor = oldest_available;
+    }
+
+    const size_t num_fibs = min<uint64_t>(write_seq - cursor, max_fibs);
+
+    // At most two contiguous parts because of the wrap-around
+    const size_t first_slot = cursor % CAPACITY;
+    const size_t first_len = min(num_fibs, CAPACITY - first_slot);
+    memcpy(dst, fibs.data() + first_slot * FIB_LENGTH,
+            first_len * FIB_LENGTH);
+    if (num_fibs > first_len) {
+        memcpy(dst + first_len * FIB_LENGTH, fibs.data(),
+                (num_fibs - first_len) * FIB_LENGTH);
+    }
+
+    cursor += num_fibs;
+    return num_fibs;
+}
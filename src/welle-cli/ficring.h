@@ -0,0 +1,98 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+
+/* Fixed-size ring of FIBs shared by all /fic clients.
+ *
+ * Every FIB written gets a monotonically increasing sequence number.
+ * Readers do not consume anything from the ring, they own a cursor
+ * (the sequence number of the next FIB they want) and copy out the FIBs
+ * between their cursor and the write position. A reader that falls
+ * behind by more than the ring capacity gets told how many FIBs it
+ * missed, and its cursor is moved to the oldest FIB still available.
+ *
+ * The producer stages the FIBs of one CIF and publishes them with
+ * a single commit(), so that readers get woken up once per CIF and
+ * not once per FIB. */
+class FicRing {
+    public:
+        static constexpr size_t FIB_LENGTH = 32;
+
+        // 1024 FIBs at 125 FIBs per second are about eight seconds
+        static constexpr size_t CAPACITY = 1024;
+
+        // Mode III carries four FIBs per CIF, the other modes three
+        static constexpr size_t MAX_STAGED = 4;
+
+        // The gap marker is a FIB containing only the end marker 0xFF
+        // followed by a deliberately wrong CRC. Analysers that check
+        // the CRC discard it, gap-aware analysers can detect it by
+        // comparing with this pattern.
+        static const std::array<uint8_t, FIB_LENGTH>& gapMarker();
+
+        FicRing() = default;
+        FicRing(const FicRing& other) = delete;
+        FicRing& operator=(const FicRing& other) = delete;
+
+        // Producer side. fib_bits is the FIB as 256 unpacked bits, as
+        // given to RadioControllerInterface::onFIBDecodeSuccess.
+        void stage(const uint8_t *fib_bits);
+        void commit();
+        void discardStaged();
+
+        // Sequence number of the oldest FIB still held in the ring,
+        // that's where a new reader starts.
+        uint64_t oldest() const;
+
+        // Sequence number the next committed FIB will get
+        uint64_t head() const;
+
+        // Wait up to timeout for FIBs after cursor, then copy at most
+        // max_fibs into dst and advance cursor. Returns the number of FIBs
+        // copied and sets lost to the number of FIBs that were overwritten
+        // before this reader could get them.
+        size_t read(uint64_t& cursor, uint8_t *dst, size_t max_fibs,
+                uint64_t& lost, std::chrono::milliseconds timeout);
+
+    private:
+        mutable std::mutex mut;
+        std::condition_variable cv;
+
+        // Number of FIBs ever committed, the sequence number of the
+        // next FIB. Protected by mut.
+        uint64_t write_seq = 0;
+        std::array<uint8_t, CAPACITY * FIB_LENGTH> fibs;
+
+        // Only accessed by the producer
+        size_t num_staged = 0;
+        std::array<uint8_t, MAX_STAGED * FIB_LENGTH> staging;
+};
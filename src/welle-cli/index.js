@@ -128,6 +128,8 @@ window.onload = function() {
             xhr.send(0);
         }
     }
+
+    startUpdates();
 };
 
 function refreshChannel() {
@@ -140,9 +142,67 @@ function refreshChannel() {
     r.send()
 };
 
-var channelRefreshTimer = setInterval(refreshChannel, 2000);
+// The state of the receiver, as in /mux.json. With /events, the server sends
+// it in full once and then pushes deltas that are merged into it.
+var mux = null;
+var renderPending = false;
+
+function scheduleRender() {
+    if (renderPending || mux == null) return;
+    renderPending = true;
+    setTimeout(function() {
+        renderPending = false;
+        renderEnsembleinfo(mux);
+    }, 0);
+}
+
+function mergeInto(target, delta) {
+    for (var key in delta) {
+        target[key] = delta[key];
+    }
+}
 
-var ensembleInfoTimer = setInterval(populateEnsembleinfo, 1000);
+function startEvents() {
+    var es = new EventSource("/events");
+
+    es.addEventListener("mux", function(e) {
+        mux = JSON.parse(e.data);
+        scheduleRender();
+    });
+
+    es.addEventListener("channel", function(e) {
+        document.getElementById("channelselector").value = JSON.parse(e.data).channel;
+    });
+
+    es.addEventListener("demod", function(e) {
+        if (mux == null) return;
+        mergeInto(mux.demodulator, JSON.parse(e.data));
+        scheduleRender();
+    });
+
+    es.addEventListener("service", function(e) {
+        if (mux == null) return;
+        var delta = JSON.parse(e.data);
+        for (var key in mux.services) {
+            if (mux.services[key].sid == delta.sid) {
+                mergeInto(mux.services[key], delta);
+                scheduleRender();
+                break;
+            }
+        }
+    });
+}
+
+// Called once the page is loaded. Browsers without EventSource poll.
+function startUpdates() {
+    if (window.EventSource) {
+        startEvents();
+    }
+    else {
+        channelRefreshTimer = setInterval(refreshChannel, 2000);
+        ensembleInfoTimer = setInterval(populateEnsembleinfo, 1000);
+    }
+}
 
 function ensembleInfoTemplate() {
     var html = '';
@@ -200,7 +260,7 @@ function serviceTemplate() {
 
 function tiiTemplate() {
     var html = '<li>MainId ${pattern} SubId ${comb} ${delay} samples = <b>${delay_km} km</b>';
-    html += ' error: ${error}</li>';
+    html += ' error: ${error} level: ${level} dB</li>';
     return html;
 }
 
@@ -298,152 +358,155 @@ function populateEnsembleinfo() {
     var r = new XMLHttpRequest();
     r.onreadystatechange = function () {
         if (r.readyState != 4 || r.status != 200) return;
-        var data = JSON.parse(r.responseText);
-
-        var start_addresses = [];
-        for (key in data.services) {
-            var service = data.services[key];
-            var sad_ix = {};
-            if (service.components) {
-                sad_ix["sad"] = service.components[0].subchannel.sad;
-            }
-            else {
-                // Place them at the end
-                sad_ix["sad"] = 864;
-            }
-            sad_ix["key"] = key;
-            start_addresses.push(sad_ix);
+        mux = JSON.parse(r.responseText);
+        renderEnsembleinfo(mux);
+    };
+    r.open("GET", "/mux.json", true);
+    r.send()
+};
+
+function renderEnsembleinfo(data) {
+    var start_addresses = [];
+    for (key in data.services) {
+        var service = data.services[key];
+        var sad_ix = {};
+        if (service.components) {
+            sad_ix["sad"] = service.components[0].subchannel.sad;
+        }
+        else {
+            // Place them at the end
+            sad_ix["sad"] = 864;
         }
+        sad_ix["key"] = key;
+        start_addresses.push(sad_ix);
+    }
 
-        start_addresses.sort(function(a, b) {
-            return a.sad - b.sad;
-        });
-
-        var servicehtml = "";
-        for (ix in start_addresses) {
-            var key = start_addresses[ix].key;
-            var service = data.services[key];
-            var s = {};
-            s["label"] = service.label.label;
-            s["fig2label"] = service.label.fig2label;
-            s["shortlabel"] = service.label.shortlabel;
-            s["SId"] = service.sid;
-            s["buttondisabled"] = "disabled";
-            s["buttonclass"] = "disabled";
-            if (service.components) {
-                var sc = service.components[0];
-                var sub = sc.subchannel;
-                s["bitrate"] = sub.bitrate;
-                s["sad_cu"] = sub.sad + ", " + sub.cu;
-                s["protection"] = sub.protection;
-                s["subchannel_language"] = sub.languagestring;
-
-                if (sc.transportmode == "audio") {
-                    s["techdetails"] = sc.ascty + ", " +
-                        service.samplerate + " Hz, " +
-                        service.mode + ", " +
-                        service.channels;
-                    s["buttondisabled"] = "";
-                    s["buttonclass"] = "";
-                }
-                else {
-                    s["techdetails"] = sc.transportmode + ", DSCTy=" + sc.dscty;
-                }
+    start_addresses.sort(function(a, b) {
+        return a.sad - b.sad;
+    });
+
+    var servicehtml = "";
+    for (ix in start_addresses) {
+        var key = start_addresses[ix].key;
+        var service = data.services[key];
+        var s = {};
+        s["label"] = service.label.label;
+        s["fig2label"] = service.label.fig2label;
+        s["shortlabel"] = service.label.shortlabel;
+        s["SId"] = service.sid;
+        s["buttondisabled"] = "disabled";
+        s["buttonclass"] = "disabled";
+        if (service.components) {
+            var sc = service.components[0];
+            var sub = sc.subchannel;
+            s["bitrate"] = sub.bitrate;
+            s["sad_cu"] = sub.sad + ", " + sub.cu;
+            s["protection"] = sub.protection;
+            s["subchannel_language"] = sub.languagestring;
+
+            if (sc.transportmode == "audio") {
+                s["techdetails"] = sc.ascty + ", " +
+                    service.samplerate + " Hz, " +
+                    service.mode + ", " +
+                    service.channels;
+                s["buttondisabled"] = "";
+                s["buttonclass"] = "";
             }
             else {
-                s["bitrate"] = 0;
-                s["sad"] = -1;
-                s["protection"] = "?";
-                s["techdetails"] = "";
+                s["techdetails"] = sc.transportmode + ", DSCTy=" + sc.dscty;
             }
+        }
+        else {
+            s["bitrate"] = 0;
+            s["sad"] = -1;
+            s["protection"] = "?";
+            s["techdetails"] = "";
+        }
 
-            s["dls"] = "";
+        s["dls"] = "";
 
-            if (service.mot && service.mot.time > 0) {
-                s["dls"] += '<button type=button onclick="showSlide(';
-                s["dls"] += service.sid + ', ' + service.mot.time;
-                s["dls"] += ')">SLS</button>';
-            }
+        if (service.mot && service.mot.time > 0) {
+            s["dls"] += '<button type=button onclick="showSlide(';
+            s["dls"] += service.sid + ', ' + service.mot.time;
+            s["dls"] += ')">SLS</button>';
+        }
 
-            if (service.dls) {
-                var last_update = new Date(service.dls.time * 1000);
-                s["dls"] += ' <span title="Updated ' + last_update + '">' + service.dls.label + '</span>';
-            }
+        if (service.dls) {
+            var last_update = new Date(service.dls.time * 1000);
+            s["dls"] += ' <span title="Updated ' + last_update + '">' + service.dls.label + '</span>';
+        }
 
-            if (service.xpaderror && service.xpaderror.haserror) {
-                var alerthtml = ' <img width=16 height=16 src="data:image/png;base64,' + png_alert + '" ';
-                var tooltip = "X-PAD Length error, expected " + service.xpaderror.announcedlen +
-                    " got " + service.xpaderror.len;
-                alerthtml += 'title="' + tooltip + '" ';
-                alerthtml += 'alt="' + tooltip + '">';
-                s["dls"] += alerthtml;
-            }
-            s["dls"] += "</td>";
+        if (service.xpaderror && service.xpaderror.haserror) {
+            var alerthtml = ' <img width=16 height=16 src="data:image/png;base64,' + png_alert + '" ';
+            var tooltip = "X-PAD Length error, expected " + service.xpaderror.announcedlen +
+                " got " + service.xpaderror.len;
+            alerthtml += 'title="' + tooltip + '" ';
+            alerthtml += 'alt="' + tooltip + '">';
+            s["dls"] += alerthtml;
+        }
+        s["dls"] += "</td>";
 
-            s["pty"] = service.ptystring;
-            s["language"] = service.languagestring;
-            s["canvasid"] = "canvas" + service.sid;
+        s["pty"] = service.ptystring;
+        s["language"] = service.languagestring;
+        s["canvasid"] = "canvas" + service.sid;
 
-            if (service.errorcounters) {
-                s["errorcounters"] = service.errorcounters.frameerrors + "," +
-                                     service.errorcounters.rserrors + "," +
-                                     service.errorcounters.aacerrors;
-            }
-            else {
-                s["errorcounters"] = "";
-            }
-
-            servicehtml += parseTemplate(serviceTemplate(), s)
+        if (service.errorcounters) {
+            s["errorcounters"] = service.errorcounters.frameerrors + "," +
+                                 service.errorcounters.rserrors + "," +
+                                 service.errorcounters.aacerrors;
         }
-
-        var ens = {};
-        ens["label"] = data.ensemble.label.label;
-        ens["fig2label"] = data.ensemble.label.fig2label;
-        ens["shortlabel"] = data.ensemble.label.shortlabel;
-        ens["EId"] = data.ensemble.id;
-        ens["ecc"] = data.ensemble.ecc;
-
-        ens["year"] = data.utctime.year;
-        ens["month"] = data.utctime.month;
-        ens["day"] = data.utctime.day;
-        ens["hour"] = data.utctime.hour;
-        ens["minutes"] = data.utctime.minutes;
-        ens["lto"] = data.utctime.lto;
-
-        ens["gain"] = data.receiver.hardware.gain.toFixed(1);
-        document.getElementById("fftwindowselector").value = data.receiver.software.fftwindowplacement;
-        document.getElementById("coarsecheckbox").checked = data.receiver.software.coarsecorrectorenabled;
-
-        ens["version"] = data.receiver.software.version;
-        ens["hw_name"] = data.receiver.hardware.name;
-        ens["sw_name"] = data.receiver.software.name;
-        ens["SNR"] = data.demodulator.snr.toFixed(1);
-        ens["FrequencyCorrection"] = data.demodulator.frequencycorrection;
-        ens["services"] = servicehtml;
-        ens["ficcrcerrors"] = data.demodulator.fic.numcrcerrors;
-        var lcc = new Date(data.receiver.software.lastchannelchange);
-        ens["lastchannelchange"] = lcc.toISOString();
-        var lfct0 = new Date(data.demodulator.time_last_fct0_frame);
-        ens["lastfct0frame"] = lfct0.toISOString();
-
-        var ei = document.getElementById('ensembleinfo');
-        ei.innerHTML = parseTemplate(ensembleInfoTemplate(), ens);
-
-        tiihtml = "<ul>";
-        for (key in data.tii) {
-            tiihtml += parseTemplate(tiiTemplate(), data.tii[key])
+        else {
+            s["errorcounters"] = "";
         }
-        tiihtml += "</ul>";
 
-        var tii_el = document.getElementById('tiiinfo');
-        tii_el.innerHTML = tiihtml;
+        servicehtml += parseTemplate(serviceTemplate(), s)
+    }
 
-        drawCIRPeaks(data.cir_peaks);
+    var ens = {};
+    ens["label"] = data.ensemble.label.label;
+    ens["fig2label"] = data.ensemble.label.fig2label;
+    ens["shortlabel"] = data.ensemble.label.shortlabel;
+    ens["EId"] = data.ensemble.id;
+    ens["ecc"] = data.ensemble.ecc;
+
+    ens["year"] = data.utctime.year;
+    ens["month"] = data.utctime.month;
+    ens["day"] = data.utctime.day;
+    ens["hour"] = data.utctime.hour;
+    ens["minutes"] = data.utctime.minutes;
+    ens["lto"] = data.utctime.lto;
+
+    ens["gain"] = data.receiver.hardware.gain.toFixed(1);
+    document.getElementById("fftwindowselector").value = data.receiver.software.fftwindowplacement;
+    document.getElementById("coarsecheckbox").checked = data.receiver.software.coarsecorrectorenabled;
+
+    ens["version"] = data.receiver.software.version;
+    ens["hw_name"] = data.receiver.hardware.name;
+    ens["sw_name"] = data.receiver.software.name;
+    ens["SNR"] = data.demodulator.snr.toFixed(1);
+    ens["FrequencyCorrection"] = data.demodulator.frequencycorrection;
+    ens["services"] = servicehtml;
+    ens["ficcrcerrors"] = data.demodulator.fic.numcrcerrors;
+    var lcc = new Date(data.receiver.software.lastchannelchange);
+    ens["lastchannelchange"] = lcc.toISOString();
+    var lfct0 = new Date(data.demodulator.time_last_fct0_frame);
+    ens["lastfct0frame"] = lfct0.toISOString();
+
+    var ei = document.getElementById('ensembleinfo');
+    ei.innerHTML = parseTemplate(ensembleInfoTemplate(), ens);
+
+    tiihtml = "<ul>";
+    for (key in data.tii) {
+        tiihtml += parseTemplate(tiiTemplate(), data.tii[key])
+    }
+    tiihtml += "</ul>";
 
-        drawAudiolevels(data.services);
-    };
-    r.open("GET", "/mux.json", true);
-    r.send()
+    var tii_el = document.getElementById('tiiinfo');
+    tii_el.innerHTML = tiihtml;
+
+    drawCIRPeaks(data.cir_peaks);
+
+    drawAudiolevels(data.services);
 };
 
 function plot(data, id, scalefactor, shiftfactor, plot_ix) {
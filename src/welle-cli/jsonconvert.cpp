@@ -24,16 +24,21 @@
  */
 
 #include "welle-cli/jsonconvert.h"
-#include "libs/json.hpp"
+#include "welle-cli/jsonwriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 
 using namespace std;
 
-static void to_json(nlohmann::json& j, const DabLabel& l)
+static uint64_t to_ms(const chrono::system_clock::time_point& t)
+{
+    return chrono::duration_cast<chrono::milliseconds>(
+            t.time_since_epoch()).count();
+}
+
+static void write_json(JsonWriter& w, const DabLabel& l)
 {
-    j["label"] = l.fig1_label_utf8();
-    j["shortlabel"] = l.fig1_shortlabel_utf8();
-    j["fig2label"] = l.fig2_label();
-    j["fig2rfu"] = l.fig2_rfu;
     string extended_label_charset = "Unknown";
     switch (l.extended_label_charset) {
         case CharacterSet::EbuLatin: extended_label_charset = "EBU Latin (not allowed in FIG 2)"; break;
@@ -42,196 +47,359 @@ static void to_json(nlohmann::json& j, const DabLabel& l)
         case CharacterSet::UnicodeUtf8: extended_label_charset = "UTF-8"; break;
         case CharacterSet::Undefined: extended_label_charset = "Undefined"; break;
     }
-    j["fig2charset"] = extended_label_charset;
-}
 
+    w.beginObject()
+        .member("label", l.fig1_label_utf8())
+        .member("shortlabel", l.fig1_shortlabel_utf8())
+        .member("fig2label", l.fig2_label())
+        .member("fig2rfu", l.fig2_rfu)
+        .member("fig2charset", extended_label_charset)
+        .endObject();
+}
 
-static void to_json(nlohmann::json& j, const SoftwareJson& s) {
-    uint64_t lastchannelchange_ms =
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-                s.lastchannelchange.time_since_epoch()).count();
+static void write_json(JsonWriter& w, const ReceiverJson& r)
+{
+    const auto& h = r.hardware;
+    const auto& s = r.software;
 
-    j = nlohmann::json{
-        {"name", s.name},
-        {"version", s.version},
-        {"fftwindowplacement", s.fftwindowplacement},
-        {"coarsecorrectorenabled", s.coarsecorrectorenabled},
-        {"freqsyncmethod", s.freqsyncmethod},
-        {"lastchannelchange", lastchannelchange_ms}
-    };
+    w.beginObject();
+    w.key("hardware").beginObject()
+        .member("name", h.name)
+        .member("gain", h.gain)
+        .endObject();
+    w.key("software").beginObject()
+        .member("name", s.name)
+        .member("version", s.version)
+        .member("fftwindowplacement", s.fftwindowplacement)
+        .member("coarsecorrectorenabled", s.coarsecorrectorenabled)
+        .member("freqsyncmethod", s.freqsyncmethod)
+        .member("lastchannelchange", to_ms(s.lastchannelchange))
+        .endObject();
+    w.endObject();
 }
 
-static void to_json(nlohmann::json& j, const HardwareJson& h) {
-    j = nlohmann::json{
-        {"name", h.name},
-        {"gain", h.gain}
-    };
+static void write_json(JsonWriter& w, const Subchannel& sub)
+{
+    w.beginObject()
+        .member("subchid", sub.subChId)
+        .member("bitrate", sub.bitrate())
+        .member("cu", sub.numCU())
+        .member("sad", sub.startAddr)
+        .member("protection", sub.protection())
+        .member("language", sub.language)
+        .member("languagestring", DABConstants::getLanguageName(sub.language))
+        .endObject();
 }
 
-static void to_json(nlohmann::json& j, const ReceiverJson& r) {
-    j = nlohmann::json{
-        {"hardware", r.hardware},
-        {"software", r.software}
-    };
+template<typename T>
+static void write_optional(JsonWriter& w, const string& key, const unique_ptr<T>& v)
+{
+    w.key(key);
+    if (v) {
+        w.value(*v);
+    }
+    else {
+        w.null();
+    }
 }
 
-static void to_json(nlohmann::json& j, const Subchannel& sub) {
-    j = nlohmann::json{
-        {"subchid", sub.subChId},
-        {"bitrate", sub.bitrate()},
-        {"cu", sub.numCU()},
-        {"sad", sub.startAddr},
-        {"protection", sub.protection()},
-        {"language", sub.language},
-        {"languagestring", DABConstants::getLanguageName(sub.language)}
-    };
+static void write_json(JsonWriter& w, const ComponentJson& c)
+{
+    w.beginObject()
+        .member("componentnr", c.componentnr)
+        .member("primary", c.primary)
+        .member("caflag", c.caflag)
+        .member("transportmode", c.transportmode);
+
+    w.key("label");
+    write_json(w, c.label);
+    w.key("subchannel");
+    write_json(w, c.subchannel);
+
+    write_optional(w, "scid", c.scid);
+    write_optional(w, "ascty", c.ascty);
+    write_optional(w, "dscty", c.dscty);
+    w.endObject();
 }
 
-static void to_json(nlohmann::json& j, const ComponentJson& c) {
-    j = nlohmann::json{
-        {"componentnr", c.componentnr},
-        {"primary", c.primary},
-        {"caflag", c.caflag},
-        {"transportmode", c.transportmode},
-        {"label", c.label},
-        {"subchannel", c.subchannel}
-    };
+static void write_json(JsonWriter& w, const ServiceJson& s)
+{
+    w.beginObject()
+        .member("sid", s.sid)
+        .member("programType", s.programType)
+        .member("ptystring", s.ptystring)
+        .member("language", s.language)
+        .member("languagestring", s.languagestring);
 
-    if (c.scid) {
-        j["scid"] = *c.scid;
-    }
-    else {
-        j["scid"] = nullptr;
-    }
+    w.key("label");
+    write_json(w, s.label);
 
-    if (c.ascty) {
-        j["ascty"] = *c.ascty;
-    }
-    else {
-        j["ascty"] = nullptr;
+    w.key("components").beginArray();
+    for (const auto& c : s.components) {
+        write_json(w, c);
     }
+    w.endArray();
 
-    if (c.dscty) {
-        j["dscty"] = *c.dscty;
-    }
-    else {
-        j["dscty"] = nullptr;
-    }
-}
-
-static void to_json(nlohmann::json& j, const ServiceJson& s) {
-    j = nlohmann::json{
-        {"sid", s.sid},
-        {"programType", s.programType},
-        {"ptystring", s.ptystring},
-        {"language", s.language},
-        {"languagestring", s.languagestring},
-        {"label", s.label},
-        {"components", s.components},
-        {"channels", s.channels},
-        {"samplerate", s.samplerate},
-        {"mode", s.mode},
-        {"mot", nlohmann::json{
-            {"time", s.mot_time},
-            {"lastchange", s.mot_lastchange}}},
-        {"dls", nlohmann::json{
-            {"label", s.dls_label},
-            {"time", s.dls_time},
-            {"lastchange", s.dls_lastchange}}},
-        {"errorcounters", nlohmann::json{
-            {"frameerrors", s.errorcounters_frameerrors},
-            {"rserrors", s.errorcounters_rserrors},
-            {"aacerrors", s.errorcounters_aacerrors},
-            {"time", s.errorcounters_time}}}};
+    w.member("channels", s.channels)
+        .member("samplerate", s.samplerate)
+        .member("mode", s.mode);
+
+    w.key("mot").beginObject()
+        .member("time", s.mot_time)
+        .member("lastchange", s.mot_lastchange)
+        .endObject();
+
+    w.key("dls").beginObject()
+        .member("label", s.dls_label)
+        .member("time", s.dls_time)
+        .member("lastchange", s.dls_lastchange)
+        .endObject();
 
+    w.key("errorcounters").beginObject()
+        .member("frameerrors", s.errorcounters_frameerrors)
+        .member("rserrors", s.errorcounters_rserrors)
+        .member("aacerrors", s.errorcounters_aacerrors)
+        .member("time", s.errorcounters_time)
+        .endObject();
+
+    w.key("xpaderror").beginObject()
+        .member("haserror", s.xpaderror_haserror);
     if (s.xpaderror_haserror) {
-        j["xpaderror"] = nlohmann::json{
-            {"haserror", s.xpaderror_haserror},
-            {"announcedlen", s.xpaderror_announcedlen},
-            {"len", s.xpaderror_len},
-            {"time", s.xpaderror_time}};
-    }
-    else {
-        j["xpaderror"]["haserror"] = false;
+        w.member("announcedlen", s.xpaderror_announcedlen)
+            .member("len", s.xpaderror_len)
+            .member("time", s.xpaderror_time);
     }
+    w.endObject();
 
+    w.key("url_mp3");
     if (s.url_mp3.empty()) {
-        j["url_mp3"] = nullptr;
+        w.null();
     }
     else {
-        j["url_mp3"] = s.url_mp3;
+        w.value(s.url_mp3);
     }
 
+    w.key("audiolevel");
     if (s.audiolevel_present) {
-        j["audiolevel"] = nlohmann::json{
-            {"time", s.audiolevel_time},
-            {"left", s.audiolevel_left},
-            {"right", s.audiolevel_right}};
+        w.beginObject()
+            .member("time", s.audiolevel_time)
+            .member("left", s.audiolevel_left)
+            .member("right", s.audiolevel_right)
+            .endObject();
     }
     else {
-        j["audiolevel"] = nullptr;
+        w.null();
     }
+
+    w.endObject();
 }
 
-static void to_json(nlohmann::json& j, const EnsembleJson& e) {
-    j = nlohmann::json{
-        {"label", e.label},
-        {"id", e.id},
-        {"ecc", e.ecc}
-    };
+static void write_json(JsonWriter& w, const EnsembleJson& e)
+{
+    w.beginObject();
+    w.key("label");
+    write_json(w, e.label);
+    w.member("id", e.id)
+        .member("ecc", e.ecc)
+        .member("provisional", e.provisional)
+        .endObject();
 }
 
-static void to_json(nlohmann::json& j, const UTCJson& u) {
-    j = nlohmann::json{
-        {"year", u.year},
-        {"month", u.month},
-        {"day", u.day},
-        {"hour", u.hour},
-        {"minutes", u.minutes},
-        {"lto", u.lto}
-    };
+static void write_json(JsonWriter& w, const UTCJson& u)
+{
+    w.beginObject()
+        .member("year", u.year)
+        .member("month", u.month)
+        .member("day", u.day)
+        .member("hour", u.hour)
+        .member("minutes", u.minutes)
+        .member("lto", u.lto)
+        .endObject();
 }
 
-static void to_json(nlohmann::json& j, const tii_measurement_t& tii) {
-    j = nlohmann::json{
-        {"comb", tii.comb},
-        {"pattern", tii.pattern},
-        {"delay", tii.delay_samples},
-        {"delay_km", tii.getDelayKm()},
-        {"error", tii.error}
-    };
+static void write_json(JsonWriter& w, const tii_measurement_t& tii)
+{
+    w.beginObject()
+        .member("comb", tii.comb)
+        .member("pattern", tii.pattern)
+        .member("delay", tii.delay_samples)
+        .member("delay_km", tii.getDelayKm())
+        .member("error", tii.error)
+        .member("level", tii.level_db)
+        .endObject();
 }
 
-static void to_json(nlohmann::json& j, const PeakJson& peak)
+static void write_json(JsonWriter& w, const PeakJson& peak)
 {
-    j = nlohmann::json{
-        {"index", peak.index},
-        {"value", 10.0f * log10(peak.value)}};
+    w.beginObject()
+        .member("index", peak.index)
+        .member("value", 10.0f * log10(peak.value))
+        .endObject();
 }
 
+std::string build_mux_json(const MuxJson& mux)
+{
+    JsonWriter w;
+    w.beginObject();
+
+    w.key("receiver");
+    write_json(w, mux.receiver);
+
+    w.key("ensemble");
+    write_json(w, mux.ensemble);
+
+    w.key("services").beginArray();
+    for (const auto& s : mux.services) {
+        write_json(w, s);
+    }
+    w.endArray();
+
+    w.key("utctime");
+    write_json(w, mux.utctime);
+
+    w.key("messages").beginArray();
+    for (const auto& m : mux.messages) {
+        w.value(m);
+    }
+    w.endArray();
 
-static void to_json(nlohmann::json& j, const MuxJson& mux) {
-    j = nlohmann::json{
-        {"receiver", mux.receiver},
-        {"ensemble", mux.ensemble},
-        {"services", mux.services},
-        {"utctime", mux.utctime},
-        {"messages", mux.messages},
-        {"tii", mux.tii},
-        {"cir_peaks", mux.cir_peaks}
-    };
+    w.key("tii").beginArray();
+    for (const auto& tii : mux.tii) {
+        write_json(w, tii);
+    }
+    w.endArray();
+
+    w.key("cir_peaks").beginArray();
+    for (const auto& peak : mux.cir_peaks) {
+        write_json(w, peak);
+    }
+    w.endArray();
+
+    w.key("demodulator").beginObject();
+    w.key("fic").beginObject()
+        .member("numcrcerrors", mux.demodulator_fic_numcrcerrors)
+        .endObject();
+    w.member("time_last_fct0_frame", to_ms(mux.demodulator_timelastfct0frame))
+        .member("snr", mux.demodulator_snr)
+        .member("frequencycorrection", mux.demodulator_frequencycorrection)
+        .endObject();
 
-    j["demodulator"]["fic"]["numcrcerrors"] = mux.demodulator_fic_numcrcerrors;
-    uint64_t timelastfct0_ms =
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-                mux.demodulator_timelastfct0frame.time_since_epoch()).count();
-    j["demodulator"]["time_last_fct0_frame"] = timelastfct0_ms;
-    j["demodulator"]["snr"] = mux.demodulator_snr;
-    j["demodulator"]["frequencycorrection"] = mux.demodulator_frequencycorrection;
+    w.endObject();
+    return w.str();
 }
 
-std::string build_mux_json(const MuxJson& mux)
+std::string build_tii_history_json(const vector<TiiStats::History>& histories)
 {
-    nlohmann::json j = mux;
-    return j.dump();
+    tii_measurement_t m;
+
+    JsonWriter w;
+    w.beginObject();
+    w.key("transmitters").beginArray();
+    for (const auto& h : histories) {
+        w.beginObject()
+            .member("comb", h.comb)
+            .member("pattern", h.pattern);
+        w.key("history").beginArray();
+        for (const auto& p : h.points) {
+            m.delay_samples = p.delay_samples;
+            w.beginObject()
+                .member("time", to_ms(p.time))
+                .member("delay", p.delay_samples)
+                .member("delay_km", m.getDelayKm())
+                .member("error", p.error)
+                .member("level", p.level_db)
+                .endObject();
+        }
+        w.endArray();
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+    return w.str();
+}
+
+std::string build_slide_history_json(
+        const map<uint32_t, vector<SlideStore::HistoryEntry> >& histories)
+{
+    JsonWriter w;
+    w.beginObject();
+    w.key("services").beginArray();
+    for (const auto& h : histories) {
+        char sid[16];
+        snprintf(sid, sizeof(sid), "0x%04x", h.first);
+
+        w.beginObject().member("sid", string(sid));
+        w.key("slides").beginArray();
+        for (const auto& e : h.second) {
+            w.beginObject()
+                .member("hash", e.info.hash)
+                .member("url", "/slide/" + string(sid) + "/" + e.info.hash)
+                .member("contenttype", e.info.content_type)
+                .member("name", e.info.content_name)
+                .member("size", e.info.size)
+                .member("time", to_ms(e.time))
+                .member("available", e.available)
+                .endObject();
+        }
+        w.endArray();
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+    return w.str();
+}
+
+static void write_json(JsonWriter& w, const SpiDescription& d)
+{
+    w.member("name", d.name())
+        .member("shortname", d.short_name)
+        .member("mediumname", d.medium_name)
+        .member("longname", d.long_name)
+        .member("shortdescription", d.short_description)
+        .member("longdescription", d.long_description);
+    w.key("genres").beginArray();
+    for (const auto& g : d.genres) {
+        w.value(g);
+    }
+    w.endArray();
+}
+
+std::string build_epg_json(const vector<SpiService>& services,
+        const vector<SpiProgramme>& programmes, time_t from, time_t to)
+{
+    JsonWriter w;
+    w.beginObject()
+        .member("from", (int64_t)from)
+        .member("to", (int64_t)to);
+
+    // The programmes are sorted by service
+    w.key("services").beginArray();
+    for (auto p = programmes.cbegin(); p != programmes.cend();) {
+        const uint32_t sid = p->service_id;
+        char sid_str[16];
+        snprintf(sid_str, sizeof(sid_str), "0x%04x", sid);
+
+        w.beginObject().member("sid", string(sid_str));
+        const auto s = find_if(services.cbegin(), services.cend(),
+                [&](const SpiService& srv) { return srv.service_id == sid; });
+        if (s != services.cend()) {
+            write_json(w, *s);
+        }
+
+        w.key("programmes").beginArray();
+        for (; p != programmes.cend() and p->service_id == sid; ++p) {
+            w.beginObject()
+                .member("start", (int64_t)p->start)
+                .member("duration", p->duration)
+                .member("id", p->id)
+                .member("shortid", p->short_id);
+            write_json(w, *p);
+            w.endObject();
+        }
+        w.endArray();
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+    return w.str();
 }
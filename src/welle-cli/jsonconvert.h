@@ -27,11 +27,15 @@
 #include <string>
 #include <chrono>
 #include <list>
+#include <map>
 #include <vector>
 #include <memory>
 #include <ctime>
 #include "dab-constants.h"
 #include "backend/radio-controller.h"
+#include "backend/tii-stats.h"
+#include "backend/spi-decoder.h"
+#include "welle-cli/slidestore.h"
 
 struct SoftwareJson {
     std::string name;
@@ -112,6 +116,8 @@ struct EnsembleJson {
     DabLabel label;
     std::string id;
     std::string ecc;
+    // Still the cached ensemble, not yet confirmed by the FIGs
+    bool provisional = false;
 };
 
 struct UTCJson {
@@ -145,3 +151,16 @@ struct MuxJson {
 };
 
 std::string build_mux_json(const MuxJson& mux);
+
+// The delay history of every transmitter, for /tii.json
+std::string build_tii_history_json(const std::vector<TiiStats::History>& histories);
+
+// The recent slides of every service, for /slides.json
+std::string build_slide_history_json(
+        const std::map<uint32_t, std::vector<SlideStore::HistoryEntry> >& histories);
+
+// The programmes of the guide in a time window, grouped by service,
+// for /epg.json
+std::string build_epg_json(const std::vector<SpiService>& services,
+        const std::vector<SpiProgramme>& programmes,
+        std::time_t from, std::time_t to);
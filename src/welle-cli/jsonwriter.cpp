@@ -0,0 +1,169 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "welle-cli/jsonwriter.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+JsonWriter& JsonWriter::beginObject()
+{
+    open('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    close('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    open('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    close(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const string& k)
+{
+    separator();
+    append_string(k);
+    out += ':';
+    after_key = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const string& v)
+{
+    separator();
+    append_string(v);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char *v)
+{
+    if (v == nullptr) {
+        return null();
+    }
+    return value(string(v));
+}
+
+JsonWriter& JsonWriter::value(bool v)
+{
+    separator();
+    out += v ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double v)
+{
+    if (not std::isfinite(v)) {
+        return null();
+    }
+
+    separator();
+
+    // Shortest representation that reads back to the same value
+    char buf[32];
+    for (int precision = 6; precision <= 17; precision++) {
+        snprintf(buf, sizeof(buf), "%.*g", precision, v);
+        if (strtod(buf, nullptr) == v) {
+            break;
+        }
+    }
+    out += buf;
+    return *this;
+}
+
+JsonWriter& JsonWriter::null()
+{
+    separator();
+    out += "null";
+    return *this;
+}
+
+void JsonWriter::separator()
+{
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+
+    if (not first.empty()) {
+        if (first.back()) {
+            first.back() = false;
+        }
+        else {
+            out += ',';
+        }
+    }
+}
+
+void JsonWriter::open(char c)
+{
+    separator();
+    out += c;
+    first.push_back(true);
+}
+
+void JsonWriter::close(char c)
+{
+    first.pop_back();
+    out += c;
+}
+
+void JsonWriter::append_string(const string& s)
+{
+    out += '"';
+    for (const char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+                    out += buf;
+                }
+                else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
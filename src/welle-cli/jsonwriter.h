@@ -0,0 +1,81 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/* Minimal streaming JSON serialiser. Values are appended directly to the
+ * output string, no document tree is built. The caller is responsible for
+ * balancing begin/end calls and for giving a key before every value
+ * inside an object.
+ *
+ * Non-finite floating point values are written as null. */
+class JsonWriter {
+    public:
+        JsonWriter& beginObject();
+        JsonWriter& endObject();
+        JsonWriter& beginArray();
+        JsonWriter& endArray();
+
+        JsonWriter& key(const std::string& k);
+
+        JsonWriter& value(const std::string& v);
+        JsonWriter& value(const char *v);
+        JsonWriter& value(bool v);
+        JsonWriter& value(double v);
+        JsonWriter& null();
+
+        template<typename T>
+        typename std::enable_if<std::is_integral<T>::value, JsonWriter&>::type
+        value(T v) {
+            separator();
+            out += std::to_string(v);
+            return *this;
+        }
+
+        // Shorthand for key(k).value(v)
+        template<typename T>
+        JsonWriter& member(const std::string& k, const T& v) {
+            key(k);
+            return value(v);
+        }
+
+        const std::string& str() const { return out; }
+
+    private:
+        void separator();
+        void open(char c);
+        void close(char c);
+        void append_string(const std::string& s);
+
+        std::string out;
+
+        // One entry per open object or array, true until
+        // its first element was written.
+        std::vector<bool> first;
+        bool after_key = false;
+};
@@ -0,0 +1,281 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "welle-cli/slidestore.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <unistd.h>
+
+using namespace std;
+
+constexpr size_t SlideStore::DEFAULT_MAX_MEMORY;
+constexpr size_t SlideStore::HISTORY_LENGTH;
+
+// Unique among the stores of all processes
+static string new_spill_prefix()
+{
+    static atomic<unsigned> num_stores(0);
+    return to_string(getpid()) + "-" + to_string(num_stores++) + "-";
+}
+
+SlideStore::SlideStore(size_t max_memory, const string& spill_directory) :
+    max_memory(max_memory),
+    spill_directory(spill_directory),
+    spill_prefix(new_spill_prefix())
+{
+}
+
+SlideStore::~SlideStore()
+{
+    clear();
+}
+
+string SlideStore::hash(const vector<uint8_t>& data)
+{
+    uint64_t h = 0xcbf29ce484222325;
+    for (const uint8_t b : data) {
+        h ^= b;
+        h *= 0x100000001b3;
+    }
+
+    char str[40];
+    snprintf(str, sizeof(str), "%016llx-%zx", (unsigned long long)h, data.size());
+    return str;
+}
+
+string SlideStore::contentType(int content_sub_type)
+{
+    switch (content_sub_type) {
+        case 0x01: return "image/jpeg";
+        case 0x03: return "image/png";
+        default: return "application/octet-stream";
+    }
+}
+
+static string extension(const string& content_type)
+{
+    if (content_type == "image/jpeg") return ".jpg";
+    if (content_type == "image/png") return ".png";
+    return ".bin";
+}
+
+string SlideStore::spillPath(const Info& info) const
+{
+    return spill_directory + "/" + spill_prefix + info.hash +
+        extension(info.content_type);
+}
+
+shared_ptr<const SlideStore::Slide> SlideStore::add(uint32_t serviceId,
+        const vector<uint8_t>& data, int content_sub_type,
+        const string& content_name, time_point now)
+{
+    const string h = hash(data);
+
+    lock_guard<mutex> lock(mut);
+
+    auto& history = histories[serviceId];
+    const bool is_current = not history.empty() and history.front().hash == h;
+
+    auto& record = records[h];
+    if (not record.slide) {
+        auto slide = make_shared<Slide>();
+        slide->info.hash = h;
+        slide->info.content_type = contentType(content_sub_type);
+        slide->info.content_name = content_name;
+        slide->info.size = data.size();
+        slide->data = data;
+
+        record.info = slide->info;
+        record.slide = move(slide);
+        memory_usage += data.size();
+    }
+    record.last_used = ++use_counter;
+    auto slide = record.slide;
+
+    if (not is_current) {
+        history.push_front({h, now});
+        record.refs++;
+
+        if (history.size() > HISTORY_LENGTH) {
+            const string oldest = history.back().hash;
+            history.pop_back();
+            release(oldest);
+        }
+    }
+
+    evict();
+    return slide;
+}
+
+shared_ptr<const SlideStore::Slide> SlideStore::get(const string& hash)
+{
+    lock_guard<mutex> lock(mut);
+
+    auto it = records.find(hash);
+    if (it == records.end()) {
+        return nullptr;
+    }
+
+    auto& record = it->second;
+    record.last_used = ++use_counter;
+    if (record.slide) {
+        return record.slide;
+    }
+
+    if (not record.on_disk) {
+        return nullptr;
+    }
+
+    // Spilled slides are not taken back into memory, the clients
+    // asking for old slides must not push out the current ones.
+    ifstream f(spillPath(record.info), ios::binary);
+    auto slide = make_shared<Slide>();
+    slide->info = record.info;
+    slide->data.assign(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+    if (not f or slide->data.size() != record.info.size) {
+        cerr << "SlideStore: cannot read " << spillPath(record.info) << endl;
+        record.on_disk = false;
+        return nullptr;
+    }
+    return slide;
+}
+
+map<uint32_t, vector<SlideStore::HistoryEntry> > SlideStore::getHistory() const
+{
+    map<uint32_t, vector<HistoryEntry> > result;
+
+    lock_guard<mutex> lock(mut);
+    for (const auto& h : histories) {
+        auto& entries = result[h.first];
+        for (const auto& e : h.second) {
+            const auto& record = records.at(e.hash);
+            HistoryEntry entry;
+            entry.info = record.info;
+            entry.time = e.time;
+            entry.available = record.slide or record.on_disk;
+            entries.push_back(move(entry));
+        }
+    }
+    return result;
+}
+
+void SlideStore::clear()
+{
+    lock_guard<mutex> lock(mut);
+    for (const auto& h : histories) {
+        for (const auto& e : h.second) {
+            release(e.hash);
+        }
+    }
+    histories.clear();
+}
+
+size_t SlideStore::getMemoryUsage() const
+{
+    lock_guard<mutex> lock(mut);
+    return memory_usage;
+}
+
+size_t SlideStore::getNumSlides() const
+{
+    lock_guard<mutex> lock(mut);
+    return records.size();
+}
+
+void SlideStore::release(const string& hash)
+{
+    auto it = records.find(hash);
+    if (it == records.end()) {
+        return;
+    }
+
+    auto& record = it->second;
+    if (--record.refs > 0) {
+        return;
+    }
+
+    if (record.slide) {
+        memory_usage -= record.info.size;
+    }
+    if (record.on_disk) {
+        remove(spillPath(record.info).c_str());
+    }
+    records.erase(it);
+}
+
+void SlideStore::evict()
+{
+    if (memory_usage <= max_memory) {
+        return;
+    }
+
+    set<string> current;
+    for (const auto& h : histories) {
+        if (not h.second.empty()) {
+            current.insert(h.second.front().hash);
+        }
+    }
+
+    while (memory_usage > max_memory) {
+        Record *lru = nullptr;
+        for (auto& r : records) {
+            if (r.second.slide and current.count(r.first) == 0 and
+                    (lru == nullptr or r.second.last_used < lru->last_used)) {
+                lru = &r.second;
+            }
+        }
+
+        if (lru == nullptr) {
+            // Only current slides left, they are needed anyway
+            break;
+        }
+
+        if (not spill_directory.empty() and not lru->on_disk) {
+            const string path = spillPath(lru->info);
+            const string tmp = path + ".tmp";
+            bool written = false;
+            {
+                ofstream f(tmp, ios::binary);
+                f.write(reinterpret_cast<const char*>(lru->slide->data.data()),
+                        lru->slide->data.size());
+                written = (bool)f;
+            }
+            if (written and rename(tmp.c_str(), path.c_str()) == 0) {
+                lru->on_disk = true;
+            }
+            else {
+                cerr << "SlideStore: cannot write " << path << endl;
+                remove(tmp.c_str());
+            }
+        }
+
+        lru->slide.reset();
+        memory_usage -= lru->info.size;
+    }
+}
@@ -0,0 +1,143 @@
+/*
+ *    Copyright (C) 2025
+ *    welle.io Team
+ *
+ *    This file is part of the welle.io.
+ *    Many of the ideas as implemented in welle.io are derived from
+ *    other work, made available through the GNU general Public License.
+ *    All copyrights of the original authors are recognized.
+ *
+ *    welle.io is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    welle.io is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with welle.io; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Slideshow images of all services, shared by the /slide clients.
+ *
+ * Slides are addressed by a hash of their content, so that a slide that
+ * is repeated by the carousel, or that several services broadcast, is
+ * kept only once, and so that the hash can be used as a strong ETag.
+ *
+ * Every service has a short history of the slides it showed. A slide is
+ * kept as long as one history refers to it. When the slides in memory
+ * take more than max_memory, the least recently used ones that are not
+ * the current slide of a service are moved to the spill directory, or
+ * dropped if there is none. Dropped slides stay in the history, marked
+ * unavailable. */
+class SlideStore {
+    public:
+        using time_point = std::chrono::system_clock::time_point;
+
+        static constexpr size_t DEFAULT_MAX_MEMORY = 16 * 1024 * 1024;
+
+        // Slides remembered per service
+        static constexpr size_t HISTORY_LENGTH = 16;
+
+        struct Info {
+            std::string hash;
+            std::string content_type;
+            std::string content_name;
+            size_t size = 0;
+        };
+
+        struct Slide {
+            Info info;
+            std::vector<uint8_t> data;
+
+            std::string etag() const { return "\"" + info.hash + "\""; }
+        };
+
+        struct HistoryEntry {
+            Info info;
+            // When the service started showing the slide
+            time_point time;
+            bool available = false;
+        };
+
+        // The spill directory must exist, an empty string disables spilling.
+        // The spill files are named after the store, so that several
+        // stores can share the directory.
+        explicit SlideStore(size_t max_memory = DEFAULT_MAX_MEMORY,
+                const std::string& spill_directory = "");
+        ~SlideStore();
+        SlideStore(const SlideStore&) = delete;
+        SlideStore& operator=(const SlideStore&) = delete;
+
+        // Add a slide received on a service and make it its current slide.
+        // Returns the stored slide, which is the one added before if the
+        // content is the same.
+        std::shared_ptr<const Slide> add(uint32_t serviceId,
+                const std::vector<uint8_t>& data, int content_sub_type,
+                const std::string& content_name, time_point now);
+
+        // Returns nullptr if the slide is not known or not available anymore
+        std::shared_ptr<const Slide> get(const std::string& hash);
+
+        // Newest first
+        std::map<uint32_t, std::vector<HistoryEntry> > getHistory() const;
+
+        // Forget the histories, e.g. after a retune. This also drops
+        // all slides.
+        void clear();
+
+        size_t getMemoryUsage() const;
+        size_t getNumSlides() const;
+
+        // 64-bit FNV-1a of the data followed by its length, in hex
+        static std::string hash(const std::vector<uint8_t>& data);
+
+        // MIME type of a MOT image content subtype
+        static std::string contentType(int content_sub_type);
+
+    private:
+        struct Record {
+            Info info;
+            // nullptr if the slide is not in memory
+            std::shared_ptr<const Slide> slide;
+            bool on_disk = false;
+            uint64_t last_used = 0;
+            // Number of history entries referring to the slide
+            size_t refs = 0;
+        };
+
+        struct ServiceEntry {
+            std::string hash;
+            time_point time;
+        };
+
+        std::string spillPath(const Info& info) const;
+        void release(const std::string& hash);
+        void evict();
+
+        const size_t max_memory;
+        const std::string spill_directory;
+        const std::string spill_prefix;
+
+        mutable std::mutex mut;
+        std::map<std::string, Record> records;
+        std::map<uint32_t, std::deque<ServiceEntry> > histories;
+        size_t memory_usage = 0;
+        uint64_t use_counter = 0;
+};
@@ -101,6 +101,9 @@ class ChannelSimulator : public CVirtualInput
         virtual int32_t getSamplesToRead(void)
             { return parentInput->getSamplesToRead(); }
 
+        virtual uint64_t getDiscontinuityCount(void) const
+            { return parentInput->getDiscontinuityCount(); }
+
         virtual float getGain() const
             { return parentInput->getGain(); }
 
@@ -154,19 +154,40 @@ class LameEncoder : public IEncoder {
 };
 
 
-ProgrammeSender::ProgrammeSender(Socket&& s) :
-    s(move(s))
+atomic<uint64_t> ClientMetrics::next_client_id = ATOMIC_VAR_INIT(0);
+
+ClientMetrics::ClientMetrics(const string& endpoint) :
+    labels(metrics::label("endpoint", endpoint) + "," +
+            metrics::label("client", to_string(next_client_id++))),
+    bytes_sent(metrics::registry().counter(name_bytes,
+                "Bytes sent to a streaming client", labels)),
+    lag(metrics::registry().gauge(name_lag,
+                "How far a streaming client is behind, in seconds", labels))
+{
+}
+
+ClientMetrics::~ClientMetrics()
+{
+    metrics::registry().remove(name_bytes, labels);
+    metrics::registry().remove(name_lag, labels);
+}
+
+ProgrammeSender::ProgrammeSender(Socket&& s, ClientMetrics *client_metrics) :
+    s(move(s)),
+    client_metrics(client_metrics)
 {
 }
 
 ProgrammeSender::ProgrammeSender(ProgrammeSender&& other) :
-    s(move(other.s))
+    s(move(other.s)),
+    client_metrics(other.client_metrics)
 {
 }
 
 ProgrammeSender& ProgrammeSender::operator=(ProgrammeSender&& other)
 {
     s = move(other.s);
+    client_metrics = other.client_metrics;
     other.running = false;
     return *this;
 }
@@ -179,15 +200,29 @@ bool ProgrammeSender::send_stream(const std::vector<uint8_t>& headerdata, const
 
     const int flags = MSG_NOSIGNAL;
     ssize_t ret = 0;
+    const auto start = chrono::steady_clock::now();
 
     if (!headerSent)
     {
         ret = s.send(headerdata.data(), headerdata.size(), flags);
         headerSent = true;
+        if (ret > 0 and client_metrics) {
+            client_metrics->bytes_sent.inc(ret);
+        }
     }
 
     ret = s.send(mp3Data.data(), mp3Data.size(), flags);
 
+    if (client_metrics) {
+        // A client that does not keep up makes the send block,
+        // which also holds back the decoder.
+        client_metrics->lag.set(chrono::duration<double>(
+                    chrono::steady_clock::now() - start).count());
+        if (ret > 0) {
+            client_metrics->bytes_sent.inc(ret);
+        }
+    }
+
     if (ret == -1) {
         s.close();
         std::unique_lock<std::mutex> lock(mutex);
@@ -214,8 +249,12 @@ void ProgrammeSender::cancel()
     running = false;
 }
 
-WebProgrammeHandler::WebProgrammeHandler(uint32_t serviceId, OutputCodec codecID) :
-    serviceId(serviceId), codec(codecID)
+WebProgrammeHandler::WebProgrammeHandler(uint32_t serviceId, OutputCodec codecID,
+        SlideStore& slide_store, ChangeCallback on_change,
+        ChangeCallback on_measurement) :
+    serviceId(serviceId), codec(codecID), slide_store(&slide_store),
+    on_change(move(on_change)),
+    on_measurement(move(on_measurement))
 {
     const auto now = chrono::system_clock::now();
     time_label = now;
@@ -227,6 +266,9 @@ WebProgrammeHandler::WebProgrammeHandler(uint32_t serviceId, OutputCodec codecID
 WebProgrammeHandler::WebProgrammeHandler(WebProgrammeHandler&& other) :
     serviceId(other.serviceId),
     codec(other.codec),
+    slide_store(other.slide_store),
+    on_change(move(other.on_change)),
+    on_measurement(move(other.on_measurement)),
     senders(move(other.senders))
 {
     other.senders.clear();
@@ -290,10 +332,9 @@ WebProgrammeHandler::mot_t WebProgrammeHandler::getMOT() const
 
     std::unique_lock<std::mutex> lock(stats_mutex);
     if (last_mot_valid) {
-        mot.data = last_mot;
+        mot.slide = last_slide;
         mot.time = time_mot;
         mot.last_changed = time_mot_change;
-        mot.subtype = last_subtype;
     }
     return mot;
 }
@@ -324,6 +365,9 @@ void WebProgrammeHandler::onFrameErrors(int frameErrors)
     std::unique_lock<std::mutex> lock(stats_mutex);
     errorcounters.num_frameErrors += frameErrors;
     errorcounters.time = chrono::system_clock::now();
+    if (on_measurement) {
+        on_measurement();
+    }
 }
 
 void WebProgrammeHandler::onNewAudio(std::vector<int16_t>&& audioData,
@@ -356,8 +400,18 @@ void WebProgrammeHandler::onNewAudio(std::vector<int16_t>&& audioData,
         audiolevels.last_audioLevel_R = last_audioLevel_R;
     }
 
+    if (on_measurement) {
+        on_measurement();
+    }
+
     if (encoder == nullptr)
     {
+        encoderTime = &metrics::registry().histogram(
+                "welle_encoder_seconds",
+                "CPU time spent encoding one decoded audio frame",
+                {0.0001, 0.0002, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05},
+                metrics::label("codec", codec == OutputCodec::MP3 ? "mp3" : "flac"));
+
         switch (codec)
         {
         case OutputCodec::MP3 :
@@ -374,6 +428,9 @@ void WebProgrammeHandler::onNewAudio(std::vector<int16_t>&& audioData,
         }
     }
 
+    // Thread CPU time does not include the time the encoder
+    // callback spends blocked in sending to the clients.
+    metrics::ScopedTimer timer(*encoderTime);
     encoder->process_interleaved(audioData);
 
 }
@@ -396,6 +453,9 @@ void WebProgrammeHandler::onRsErrors(bool uncorrectedErrors, int numCorrectedErr
     std::unique_lock<std::mutex> lock(stats_mutex);
     errorcounters.num_rsErrors += (uncorrectedErrors ? 1 : 0);
     errorcounters.time = chrono::system_clock::now();
+    if (on_measurement) {
+        on_measurement();
+    }
 }
 
 void WebProgrammeHandler::onAacErrors(int aacErrors)
@@ -403,6 +463,9 @@ void WebProgrammeHandler::onAacErrors(int aacErrors)
     std::unique_lock<std::mutex> lock(stats_mutex);
     errorcounters.num_aacErrors += aacErrors;
     errorcounters.time = chrono::system_clock::now();
+    if (on_measurement) {
+        on_measurement();
+    }
 }
 
 void WebProgrammeHandler::onNewDynamicLabel(const string& label)
@@ -411,30 +474,39 @@ void WebProgrammeHandler::onNewDynamicLabel(const string& label)
     last_label_valid = true;
     const auto now = chrono::system_clock::now();
     time_label = now;
-    if (last_label != label) {
+    const bool changed = (last_label != label);
+    if (changed) {
         time_label_change = now;
     }
     last_label = label;
+    lock.unlock();
+
+    if (changed and on_change) {
+        on_change();
+    }
 }
 
 void WebProgrammeHandler::onMOT(const mot_file_t& mot_file)
 {
+    const auto now = chrono::system_clock::now();
+
+    // Repetitions of the same slide are neither copied nor stored again
+    auto slide = slide_store->add(serviceId, mot_file.data,
+            mot_file.content_sub_type, mot_file.content_name, now);
+
     std::unique_lock<std::mutex> lock(stats_mutex);
     last_mot_valid = true;
-    const auto now = chrono::system_clock::now();
     time_mot = now;
-    if (last_mot != mot_file.data) {
+    const bool changed = (not last_slide or
+            last_slide->info.hash != slide->info.hash);
+    if (changed) {
         time_mot_change = now;
     }
-    last_mot = mot_file.data;
-    if (mot_file.content_sub_type == 0x01) {
-        last_subtype = MOTType::JPEG;
-    }
-    else if (mot_file.content_sub_type == 0x03) {
-        last_subtype = MOTType::PNG;
-    }
-    else {
-        last_subtype = MOTType::Unknown;
+    last_slide = move(slide);
+    lock.unlock();
+
+    if (changed and on_change) {
+        on_change();
     }
 }
 
@@ -445,5 +517,8 @@ void WebProgrammeHandler::onPADLengthError(size_t announced_xpad_len, size_t xpa
     xpad_error.time = chrono::system_clock::now();
     xpad_error.announced_xpad_len = announced_xpad_len;
     xpad_error.xpad_len = xpad_len;
+    if (on_measurement) {
+        on_measurement();
+    }
 }
 
@@ -26,8 +26,11 @@
 
 #include "radio-controller.h"
 #include "various/Socket.h"
+#include "various/metrics.h"
+#include "welle-cli/slidestore.h"
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -35,9 +38,33 @@
 #include <string>
 #include <atomic>
 
+// Metrics of one streaming HTTP client, labelled with the endpoint and a
+// client number. The numbers are unique in the process, as the registry is
+// shared by the interfaces of all channels. The metrics are removed from
+// the registry on destruction.
+class ClientMetrics {
+    private:
+        static std::atomic<uint64_t> next_client_id;
+
+        const std::string name_bytes = "welle_client_bytes_sent_total";
+        const std::string name_lag = "welle_client_lag_seconds";
+        const std::string labels;
+
+    public:
+        explicit ClientMetrics(const std::string& endpoint);
+        ~ClientMetrics();
+        ClientMetrics(const ClientMetrics&) = delete;
+        ClientMetrics& operator=(const ClientMetrics&) = delete;
+
+        metrics::Counter& bytes_sent;
+        // How far the client is behind the receiver
+        metrics::Gauge& lag;
+};
+
 class ProgrammeSender {
     private:
         Socket s;
+        ClientMetrics *client_metrics = nullptr;
 
         std::atomic<bool> running = ATOMIC_VAR_INIT(true);
         mutable std::condition_variable cv;
@@ -45,7 +72,7 @@ class ProgrammeSender {
         bool headerSent = false;
 
     public:
-        ProgrammeSender(Socket&& s);
+        ProgrammeSender(Socket&& s, ClientMetrics *client_metrics = nullptr);
         ProgrammeSender(ProgrammeSender&& other);
         ProgrammeSender& operator=(ProgrammeSender&& other);
         bool send_stream(const std::vector<uint8_t>& headerdata, const std::vector<uint8_t>& mp3data);
@@ -56,8 +83,6 @@ class ProgrammeSender {
 
 enum class OutputCodec {MP3, FLAC};
 
-enum class MOTType { JPEG, PNG, Unknown };
-
 class IEncoder;
 
 class WebProgrammeHandler : public ProgrammeHandlerInterface {
@@ -81,10 +106,17 @@ class WebProgrammeHandler : public ProgrammeHandlerInterface {
             size_t num_rsErrors = 0;
             size_t num_aacErrors = 0;
         };
+        // Called from the decoder thread when the DLS or the slide changed,
+        // or for on_measurement, the audio levels or error counters
+        using ChangeCallback = std::function<void()>;
     private:
         uint32_t serviceId;
         const OutputCodec codec;
+        SlideStore *slide_store;
+        ChangeCallback on_change;
+        ChangeCallback on_measurement;
         std::unique_ptr<IEncoder> encoder;
+        metrics::Histogram *encoderTime = nullptr;
 
         mutable std::mutex senders_mutex;
         std::list<ProgrammeSender*> senders;
@@ -101,8 +133,7 @@ class WebProgrammeHandler : public ProgrammeHandlerInterface {
         bool last_mot_valid = false;
         std::chrono::time_point<std::chrono::system_clock> time_mot;
         std::chrono::time_point<std::chrono::system_clock> time_mot_change;
-        std::vector<uint8_t> last_mot;
-        MOTType last_subtype = MOTType::Unknown;
+        std::shared_ptr<const SlideStore::Slide> last_slide;
 
         xpad_error_t xpad_error;
 
@@ -112,7 +143,11 @@ class WebProgrammeHandler : public ProgrammeHandlerInterface {
         int rate = 0;
         std::string mode;
 
-        WebProgrammeHandler(uint32_t serviceId, OutputCodec codec);
+        // The slides are kept in the slide_store, which must outlive
+        // the handler
+        WebProgrammeHandler(uint32_t serviceId, OutputCodec codec,
+                SlideStore& slide_store, ChangeCallback on_change = nullptr,
+                ChangeCallback on_measurement = nullptr);
         WebProgrammeHandler(WebProgrammeHandler&& other);
         virtual ~WebProgrammeHandler();
 
@@ -129,8 +164,8 @@ class WebProgrammeHandler : public ProgrammeHandlerInterface {
         dls_t getDLS() const;
 
         struct mot_t {
-            std::vector<uint8_t> data;
-            MOTType subtype = MOTType::Unknown;
+            // nullptr until a slide was received
+            std::shared_ptr<const SlideStore::Slide> slide;
             std::chrono::time_point<std::chrono::system_clock> time;
             std::chrono::time_point<std::chrono::system_clock> last_changed; };
         mot_t getMOT() const;
@@ -54,6 +54,8 @@
 #include "radio-receiver.h"
 #include "virtual_input.h"
 #include "welle-cli/jsonconvert.h"
+#include "welle-cli/jsonwriter.h"
+#include "various/metrics.h"
 #include "welle-cli/webprogrammehandler.h"
 
 #include "index.html.h"
@@ -84,9 +86,29 @@
 
 constexpr size_t MAX_PENDING_MESSAGES = 512;
 
+// Measurements like SNR, audio levels or error counters change all the time,
+// they cause a rebuild of the mux.json at most this often.
+constexpr auto MUX_JSON_MEASUREMENT_INTERVAL = std::chrono::milliseconds(500);
+
+// The /events stream resends the full mux.json this often, for the
+// parts that have no deltas (TII, CIR peaks, time, messages)
+constexpr auto EVENTS_MUX_REFRESH_INTERVAL = std::chrono::seconds(10);
+
+// The spectra are only computed while /spectrum or /nullspectrum is
+// polled, and for this long after the last request
+constexpr auto SPECTRUM_IDLE_TIMEOUT = std::chrono::seconds(10);
+
+// Comment sent on an idle /events stream to detect closed connections
+constexpr auto EVENTS_KEEPALIVE_INTERVAL = std::chrono::seconds(15);
+
+// One CIF every 24ms in all modes, used to convert the /fic client lag
+// to seconds
+constexpr double CIF_DURATION = 0.024;
+
 using namespace std;
 
 static const char* http_ok = "HTTP/1.0 200 OK\r\n";
+static const char* http_304 = "HTTP/1.0 304 Not Modified\r\n";
 static const char* http_400 = "HTTP/1.0 400 Bad Request\r\n";
 static const char* http_404 = "HTTP/1.0 404 Not Found\r\n";
 static const char* http_405 = "HTTP/1.0 405 Method Not Allowed\r\n";
@@ -111,8 +133,17 @@ static const char* http_contenttype_html =
 static const char* http_contenttype_ico =
         "Content-Type: image/x-icon\r\n";
 
+static const char* http_contenttype_events =
+        "Content-Type: text/event-stream; charset=utf-8\r\n";
+
+static const char* http_contenttype_metrics =
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n";
+
 static const char* http_nocache = "Cache-Control: no-cache\r\n";
 
+// Data service component type of MOT, see TS 101 756
+static const int16_t DSCTY_MOT = 60;
+
 static string to_hex(uint32_t value, int width)
 {
     stringstream sidstream;
@@ -142,10 +173,20 @@ WebRadioInterface::WebRadioInterface(CVirtualInput& in,
         RadioReceiverOptions rro) :
     dabparams(1),
     input(in),
-    spectrum_fft_handler(dabparams.T_u),
+    spectrum_engine(dabparams.T_u,
+            [&in](int num_samples) { return in.getSpectrumSamples(num_samples); }),
     rro(rro),
-    decode_settings(ds)
+    decode_settings(ds),
+    epg_store(ds.epgStore),
+    slide_store(SlideStore::DEFAULT_MAX_MEMORY, ds.slideDirectory)
 {
+    mux_json_epoch = chrono::duration_cast<chrono::seconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+
+    if (not ds.ensembleCacheDirectory.empty()) {
+        ensemble_cache = make_unique<EnsembleCache>(ds.ensembleCacheDirectory);
+    }
+
     {
         // Ensure that rx always exists when rx_mut is free!
         lock_guard<mutex> lock(rx_mut);
@@ -156,7 +197,7 @@ WebRadioInterface::WebRadioInterface(CVirtualInput& in,
         }
 
         if (success) {
-            rx = make_unique<RadioReceiver>(*this, in, rro);
+            rx = make_unique<RadioReceiver>(*this, in, rro, dabparams.dabMode);
         }
 
         if (not rx) {
@@ -164,22 +205,82 @@ WebRadioInterface::WebRadioInterface(CVirtualInput& in,
         }
 
         time_rx_created = chrono::system_clock::now();
-        rx->restart(false);
+        rx->restart(false, load_cached_ensemble());
     }
 
+    spectrum_engine.startOnDemand(SPECTRUM_IDLE_TIMEOUT);
     programme_handler_thread = thread(&WebRadioInterface::handle_phs, this);
 }
 
 WebRadioInterface::~WebRadioInterface()
 {
     running = false;
+    spectrum_engine.stop();
     if (programme_handler_thread.joinable()) {
         programme_handler_thread.join();
     }
 
     {
         lock_guard<mutex> lock(rx_mut);
+        save_cached_ensemble();
         rx.reset();
+        epg_components.clear();
+    }
+
+    if (epg_store) {
+        epg_store->save();
+    }
+}
+
+string WebRadioInterface::tuned_channel()
+{
+    try {
+        return channels.getChannelForFrequency(input.getFrequency());
+    }
+    catch (const out_of_range&) {
+        // e.g. an I/Q file
+        return "";
+    }
+}
+
+shared_ptr<const EnsembleSnapshot> WebRadioInterface::load_cached_ensemble()
+{
+    if (not ensemble_cache) {
+        return nullptr;
+    }
+
+    const auto channel = tuned_channel();
+    if (channel.empty()) {
+        return nullptr;
+    }
+
+    auto cached = ensemble_cache->load(channel);
+    if (cached) {
+        cerr << "Using the cached ensemble 0x" << to_hex(cached->ensembleId, 4) <<
+            " of channel " << channel << endl;
+    }
+    return cached;
+}
+
+void WebRadioInterface::save_cached_ensemble()
+{
+    if (not ensemble_cache or not rx) {
+        return;
+    }
+
+    const auto channel = tuned_channel();
+    if (channel.empty()) {
+        return;
+    }
+
+    const auto ensemble = rx->getEnsemble();
+    if (ensemble->provisional or ensemble->version == ensemble_version_cached) {
+        return;
+    }
+
+    if (ensemble_cache->save(channel, *ensemble)) {
+        ensemble_version_cached = ensemble->version;
+        time_ensemble_cached = chrono::steady_clock::now();
     }
 }
 
@@ -237,9 +338,14 @@ void WebRadioInterface::check_decoders_required()
                     " because no handler exists!" << endl;
             }
         }
+
+        check_epg_decoders_required();
     }
     catch (const TuneFailed&) {
         rx->restart_decoder();
+        for (auto& c : epg_components) {
+            c.second.decoded = false;
+        }
         phs.clear();
         programmes_being_decoded.clear();
         carousel_services_available.clear();
@@ -248,6 +354,41 @@ void WebRadioInterface::check_decoders_required()
     phs_changed.notify_all();
 }
 
+void WebRadioInterface::check_epg_decoders_required()
+{
+    if (not epg_store) {
+        return;
+    }
+
+    for (const auto& s : rx->getServiceList()) {
+        for (const auto& sc : rx->getComponents(s)) {
+            // The user applications of FIG 0/13 are not kept, so every MOT
+            // component is decoded, and its objects other than the SPI
+            // ones are ignored.
+            if (sc.transportMode() != TransportMode::PacketData or
+                    sc.DSCTy != DSCTY_MOT) {
+                continue;
+            }
+
+            auto& c = epg_components[make_pair(sc.subchannelId, sc.packetAddress)];
+            if (c.decoded) {
+                continue;
+            }
+
+            if (not c.handler) {
+                c.handler = make_unique<EpgDataHandler>(*epg_store);
+            }
+
+            // Retried later if the subchannel is not known yet
+            c.decoded = rx->addPacketDataToDecode(*c.handler, sc);
+            if (c.decoded) {
+                cerr << "Decoding the MOT data of service 0x" <<
+                    to_hex(s.serviceId, 4) << " for the programme guide" << endl;
+            }
+        }
+    }
+}
+
 void WebRadioInterface::retune(const string& channel)
 {
     // Ensure two closely occurring retune() calls don't get stuck
@@ -274,7 +415,10 @@ void WebRadioInterface::retune(const string& channel)
         ASSERT_RX;
 
         cerr << "RETUNE Destroy RX" << endl;
+        save_cached_ensemble();
         rx.reset();
+        ensemble_version_cached = 0;
+        epg_components.clear();
 
         {
             lock_guard<mutex> data_lock(data_mut);
@@ -282,6 +426,7 @@ void WebRadioInterface::retune(const string& channel)
             last_snr = 0;
             last_fine_correction = 0;
             last_coarse_correction = 0;
+            tii_stats.clear();
         }
 
         synced = false;
@@ -290,20 +435,25 @@ void WebRadioInterface::retune(const string& channel)
             lock_guard<mutex> fib_lock(fib_mut);
             num_fic_crc_errors = 0;
         }
-        tiis.clear();
+        // The decoder thread is gone, realign to the next CIF
+        num_fibs_in_cif = 0;
+        fic_ring.discardStaged();
+        spectrum_engine.reset();
+        slide_store.clear();
 
         cerr << "RETUNE Set frequency" << endl;
         input.setFrequency(freq);
         input.reset(); // Clear buffer
 
         cerr << "RETUNE Restart RX" << endl;
-        rx = make_unique<RadioReceiver>(*this, input, rro);
+        rx = make_unique<RadioReceiver>(*this, input, rro, dabparams.dabMode);
         if (not rx) {
             throw runtime_error("Could not initialise RadioReceiver");
         }
 
         time_rx_created = chrono::system_clock::now();
-        rx->restart(false);
+        rx->restart(false, load_cached_ensemble());
+        mux_structure_changed();
 
         cerr << "RETUNE Start programme handler" << endl;
         running = true;
@@ -451,6 +601,51 @@ static http_request_t parse_http_headers(Socket& s) {
     return r;
 }
 
+// Header names are case-insensitive, and the value still contains
+// the whitespace around it.
+static string get_header(const http_request_t& r, const string& name)
+{
+    for (const auto& h : r.headers) {
+        if (h.first.size() == name.size() and
+                equal(h.first.begin(), h.first.end(), name.begin(),
+                    [](char a, char b) { return tolower(a) == tolower(b); })) {
+            const auto begin = h.second.find_first_not_of(" \t\r\n");
+            if (begin == string::npos) {
+                return "";
+            }
+            const auto end = h.second.find_last_not_of(" \t\r\n");
+            return h.second.substr(begin, end - begin + 1);
+        }
+    }
+    return "";
+}
+
+// If-None-Match is a list of entity tags, which may be weak, or "*"
+static bool etag_matches(const string& if_none_match, const string& etag)
+{
+    size_t pos = 0;
+    while (pos < if_none_match.size()) {
+        size_t end = if_none_match.find(',', pos);
+        if (end == string::npos) {
+            end = if_none_match.size();
+        }
+
+        const auto begin = if_none_match.find_first_not_of(" \t", pos);
+        if (begin < end) {
+            const auto last = if_none_match.find_last_not_of(" \t", end - 1);
+            string tag = if_none_match.substr(begin, last - begin + 1);
+            if (tag.compare(0, 2, "W/") == 0) {
+                tag.erase(0, 2);
+            }
+            if (tag == "*" or tag == etag) {
+                return true;
+            }
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
 bool WebRadioInterface::dispatch_client(Socket&& client)
 {
     Socket s(move(client));
@@ -479,7 +674,10 @@ bool WebRadioInterface::dispatch_client(Socket&& client)
                 success = send_file(s, favicon_ico, favicon_ico_len, http_contenttype_ico);
             }
             else if (req.url == "/mux.json") {
-                success = send_mux_json(s);
+                success = send_mux_json(s, get_header(req, "If-None-Match"));
+            }
+            else if (req.url == "/events") {
+                success = send_events(s);
             }
             else if (req.url == "/mux.m3u") {
                 success = send_mux_playlist(s);
@@ -487,6 +685,9 @@ bool WebRadioInterface::dispatch_client(Socket&& client)
             else if (req.url == "/fic") {
                 success = send_fic(s);
             }
+            else if (req.url == "/metrics") {
+                success = send_metrics(s);
+            }
             else if (req.url == "/impulseresponse") {
                 success = send_impulseresponse(s);
             }
@@ -502,6 +703,15 @@ bool WebRadioInterface::dispatch_client(Socket&& client)
             else if (req.url == "/channel") {
                 success = send_channel(s);
             }
+            else if (req.url == "/tii.json") {
+                success = send_tii_history(s);
+            }
+            else if (req.url == "/slides.json") {
+                success = send_slide_history(s);
+            }
+            else if (req.url.substr(0, req.url.find('?')) == "/epg.json") {
+                success = send_epg(s, req.url);
+            }
             else if (req.url == "/fftwindowplacement" or req.url == "/enablecoarsecorrector") {
                 send_http_response(s, http_405,
                         "405 Method Not Allowed\r\n" + req.url + " is POST-only");
@@ -512,7 +722,8 @@ bool WebRadioInterface::dispatch_client(Socket&& client)
                 const regex regex_slide(R"(^[/]slide[/]([^ ]+))");
                 smatch match_slide;
                 if (regex_search(req.url, match_slide, regex_slide)) {
-                    success = send_slide(s, match_slide[1]);
+                    success = send_slide(s, match_slide[1],
+                            get_header(req, "If-None-Match"));
                     url_handled = true;
                 }
 
@@ -628,7 +839,64 @@ static vector<PeakJson> calculate_cir_peaks(const vector<float>& cir_linear)
     return peaks;
 }
 
-bool WebRadioInterface::send_mux_json(Socket& s)
+bool WebRadioInterface::send_mux_json(Socket& s, const string& if_none_match)
+{
+    const auto doc = get_mux_json();
+    const bool not_modified = etag_matches(if_none_match, doc->etag);
+
+    string headers = not_modified ? http_304 : http_ok;
+    if (not not_modified) {
+        headers += http_contenttype_json;
+    }
+    headers += http_nocache;
+    headers += "ETag: " + doc->etag + "\r\n";
+    headers += "\r\n";
+    ssize_t ret = s.send(headers.data(), headers.size(), MSG_NOSIGNAL);
+    if (ret == -1) {
+        cerr << "Failed to send mux.json headers" << endl;
+        return false;
+    }
+
+    if (not_modified) {
+        return true;
+    }
+
+    ret = s.send(doc->json.data(), doc->json.size(), MSG_NOSIGNAL);
+    if (ret == -1) {
+        cerr << "Failed to send mux.json data" << endl;
+        return false;
+    }
+    return true;
+}
+
+shared_ptr<const WebRadioInterface::mux_json_t> WebRadioInterface::get_mux_json()
+{
+    lock_guard<mutex> lock(mux_json_mut);
+
+    const auto now = chrono::steady_clock::now();
+    if (mux_json_measurements_changed and
+            now - mux_json_time_built >= MUX_JSON_MEASUREMENT_INTERVAL) {
+        invalidate_mux_json();
+    }
+
+    // Invalidations during the rebuild will cause another one at the next request
+    const uint64_t generation = mux_json_generation;
+    if (mux_json and mux_json->generation == generation) {
+        return mux_json;
+    }
+
+    mux_json_measurements_changed = false;
+    mux_json_time_built = now;
+
+    auto doc = make_shared<mux_json_t>();
+    doc->generation = generation;
+    doc->etag = "\"" + to_string(mux_json_epoch) + "-" + to_string(generation) + "\"";
+    doc->json = build_mux_json(collect_mux_json());
+    mux_json = doc;
+    return mux_json;
+}
+
+MuxJson WebRadioInterface::collect_mux_json()
 {
     MuxJson mux_json;
 
@@ -650,12 +918,15 @@ bool WebRadioInterface::send_mux_json(Socket& s)
         lock_guard<mutex> lock(rx_mut);
         ASSERT_RX;
 
-        mux_json.ensemble.label = rx->getEnsembleLabel();
+        // One snapshot, so that the services, components and subchannels match
+        const auto ensemble = rx->getEnsemble();
+        mux_json.ensemble.label = ensemble->ensembleLabel;
 
-        mux_json.ensemble.id = to_hex(rx->getEnsembleId(), 4);
-        mux_json.ensemble.ecc = to_hex(rx->getEnsembleEcc(), 2);
+        mux_json.ensemble.id = to_hex(ensemble->ensembleId, 4);
+        mux_json.ensemble.ecc = to_hex(ensemble->ensembleEcc, 2);
+        mux_json.ensemble.provisional = ensemble->provisional;
 
-        for (const auto& s : rx->getServiceList()) {
+        for (const auto& s : ensemble->services) {
             ServiceJson service;
             service.sid = to_hex(s.serviceId, 4);
             service.programType = s.programType;
@@ -665,14 +936,14 @@ bool WebRadioInterface::send_mux_json(Socket& s)
             service.label = s.serviceLabel;
             service.url_mp3 = "";
 
-            for (const auto& sc : rx->getComponents(s)) {
+            for (const auto& sc : ensemble->getComponents(s.serviceId)) {
                 ComponentJson component;
                 component.componentnr = sc.componentNr;
                 component.primary = (sc.PS_flag ? true : false);
                 component.caflag = (sc.CAflag ? true : false);
                 component.label = sc.componentLabel;
 
-                const auto sub = rx->getSubchannel(sc);
+                const auto sub = ensemble->getSubchannel(sc.subchannelId);
 
                 switch (sc.transportMode()) {
                     case TransportMode::Audio:
@@ -796,7 +1067,7 @@ bool WebRadioInterface::send_mux_json(Socket& s)
         mux_json.demodulator_frequencycorrection = last_fine_correction + last_coarse_correction;
         mux_json.demodulator_timelastfct0frame = rx->getReceiverStats().timeLastFCT0Frame;
 
-        mux_json.tii = getTiiStats();
+        mux_json.tii = tii_stats.getAggregates();
     }
 
     {
@@ -804,18 +1075,249 @@ bool WebRadioInterface::send_mux_json(Socket& s)
         mux_json.cir_peaks = calculate_cir_peaks(last_CIR);
     }
 
-    if (not send_http_response(s, http_ok, "", http_contenttype_json)) {
-        return false;
+    return mux_json;
+}
+
+shared_ptr<const WebRadioInterface::live_state_t> WebRadioInterface::get_live_state()
+{
+    const auto frame_duration = chrono::microseconds(
+            (int64_t)dabparams.T_F * 1000000 / INPUT_RATE);
+
+    lock_guard<mutex> lock(live_state_mut);
+
+    const auto now = chrono::steady_clock::now();
+    if (live_state and now - live_state->time < frame_duration) {
+        return live_state;
+    }
+
+    auto ls = make_shared<live_state_t>();
+    ls->time = now;
+    // Read before the data, a concurrent change will be seen at the next frame
+    ls->structure_generation = mux_structure_generation;
+
+    try {
+        ls->channel = channels.getChannelForFrequency(input.getFrequency());
+    }
+    catch (const out_of_range&) {
+        ls->channel = "";
+    }
+
+    ls->synced = synced;
+
+    {
+        lock_guard<mutex> data_lock(data_mut);
+        ls->snr = last_snr;
+        ls->frequencycorrection = last_fine_correction + last_coarse_correction;
+    }
+
+    {
+        lock_guard<mutex> fib_lock(fib_mut);
+        ls->fic_crc_errors = num_fic_crc_errors;
+    }
+
+    {
+        lock_guard<mutex> rx_lock(rx_mut);
+        ASSERT_RX;
+
+        for (const auto& srv : rx->getServiceList()) {
+            live_service_t service;
+            service.sid = srv.serviceId;
+            service.label = srv.serviceLabel.fig1_label_utf8();
+
+            const auto ph = phs.find(srv.serviceId);
+            if (ph != phs.end()) {
+                using chrono::system_clock;
+                const auto& wph = ph->second;
+
+                const auto dls = wph.getDLS();
+                service.dls_label = dls.label;
+                service.dls_time = system_clock::to_time_t(dls.time);
+                service.dls_lastchange = system_clock::to_time_t(dls.last_changed);
+
+                const auto mot = wph.getMOT();
+                service.mot_time = system_clock::to_time_t(mot.time);
+                service.mot_lastchange = system_clock::to_time_t(mot.last_changed);
+
+                const auto errorcounters = wph.getErrorCounters();
+                service.frameerrors = errorcounters.num_frameErrors;
+                service.rserrors = errorcounters.num_rsErrors;
+                service.aacerrors = errorcounters.num_aacErrors;
+
+                const auto al = wph.getAudioLevels();
+                service.audiolevel_present = true;
+                service.audiolevel_time = system_clock::to_time_t(al.time);
+                service.audiolevel_left = al.last_audioLevel_L;
+                service.audiolevel_right = al.last_audioLevel_R;
+            }
+
+            ls->services.push_back(move(service));
+        }
+    }
+
+    live_state = move(ls);
+    return live_state;
+}
+
+static void append_event(string& out, const char *event, const string& data)
+{
+    out += "event: ";
+    out += event;
+    out += "\ndata: ";
+    out += data;
+    out += "\n\n";
+}
+
+// Append the events that bring a client from state prev to state cur
+static void append_delta_events(string& out,
+        const WebRadioInterface::live_state_t& prev,
+        const WebRadioInterface::live_state_t& cur)
+{
+    if (prev.channel != cur.channel) {
+        JsonWriter w;
+        w.beginObject().member("channel", cur.channel).endObject();
+        append_event(out, "channel", w.str());
+    }
+
+    if (prev.synced != cur.synced or
+            prev.snr != cur.snr or
+            prev.frequencycorrection != cur.frequencycorrection or
+            prev.fic_crc_errors != cur.fic_crc_errors) {
+        JsonWriter w;
+        w.beginObject()
+            .member("synced", cur.synced)
+            .member("snr", cur.snr)
+            .member("frequencycorrection", cur.frequencycorrection);
+        w.key("fic").beginObject()
+            .member("numcrcerrors", cur.fic_crc_errors)
+            .endObject();
+        w.endObject();
+        append_event(out, "demod", w.str());
+    }
+
+    // Same service list, otherwise the caller sends a full mux.json
+    for (size_t i = 0; i < cur.services.size(); i++) {
+        const auto& p = prev.services[i];
+        const auto& c = cur.services[i];
+
+        const bool dls_changed = p.dls_label != c.dls_label;
+        const bool mot_changed = p.mot_lastchange != c.mot_lastchange;
+        const bool errors_changed =
+            p.frameerrors != c.frameerrors or
+            p.rserrors != c.rserrors or
+            p.aacerrors != c.aacerrors;
+        const bool levels_changed =
+            p.audiolevel_present != c.audiolevel_present or
+            p.audiolevel_left != c.audiolevel_left or
+            p.audiolevel_right != c.audiolevel_right;
+
+        if (not (dls_changed or mot_changed or errors_changed or levels_changed)) {
+            continue;
+        }
+
+        // Field names as in the mux.json, so that the client can merge them
+        JsonWriter w;
+        w.beginObject().member("sid", to_hex(c.sid, 4));
+        if (dls_changed) {
+            w.key("dls").beginObject()
+                .member("label", c.dls_label)
+                .member("time", c.dls_time)
+                .member("lastchange", c.dls_lastchange)
+                .endObject();
+        }
+        if (mot_changed) {
+            w.key("mot").beginObject()
+                .member("time", c.mot_time)
+                .member("lastchange", c.mot_lastchange)
+                .endObject();
+        }
+        if (errors_changed) {
+            w.key("errorcounters").beginObject()
+                .member("frameerrors", c.frameerrors)
+                .member("rserrors", c.rserrors)
+                .member("aacerrors", c.aacerrors)
+                .endObject();
+        }
+        if (levels_changed and c.audiolevel_present) {
+            w.key("audiolevel").beginObject()
+                .member("time", c.audiolevel_time)
+                .member("left", c.audiolevel_left)
+                .member("right", c.audiolevel_right)
+                .endObject();
+        }
+        w.endObject();
+        append_event(out, "service", w.str());
     }
+}
 
-    const auto json_str = build_mux_json(mux_json);
+static bool same_service_list(
+        const WebRadioInterface::live_state_t& a,
+        const WebRadioInterface::live_state_t& b)
+{
+    return equal(a.services.begin(), a.services.end(),
+            b.services.begin(), b.services.end(),
+            [](const WebRadioInterface::live_service_t& x,
+               const WebRadioInterface::live_service_t& y) {
+                return x.sid == y.sid and x.label == y.label;
+            });
+}
 
-    ssize_t ret = s.send(json_str.c_str(), json_str.size(), MSG_NOSIGNAL);
+bool WebRadioInterface::send_events(Socket& s)
+{
+    string headers = http_ok;
+    headers += http_contenttype_events;
+    headers += http_nocache;
+    headers += "\r\n";
+    ssize_t ret = s.send(headers.data(), headers.size(), MSG_NOSIGNAL);
     if (ret == -1) {
-        cerr << "Failed to send mux.json data" << endl;
+        cerr << "Failed to send events headers" << endl;
         return false;
     }
-    return true;
+
+    const auto frame_duration = chrono::microseconds(
+            (int64_t)dabparams.T_F * 1000000 / INPUT_RATE);
+
+    ClientMetrics client_metrics("events");
+
+    shared_ptr<const live_state_t> prev;
+    auto time_last_mux = chrono::steady_clock::now();
+    auto time_last_send = time_last_mux;
+
+    while (true) {
+        const auto cur = get_live_state();
+        const auto now = chrono::steady_clock::now();
+
+        string out;
+        if (not prev or
+                prev->structure_generation != cur->structure_generation or
+                not same_service_list(*prev, *cur) or
+                now - time_last_mux >= EVENTS_MUX_REFRESH_INTERVAL) {
+            append_event(out, "mux", get_mux_json()->json);
+            time_last_mux = now;
+        }
+        else if (prev != cur) {
+            append_delta_events(out, *prev, *cur);
+        }
+        prev = cur;
+
+        if (out.empty() and now - time_last_send >= EVENTS_KEEPALIVE_INTERVAL) {
+            out = ": keepalive\n\n";
+        }
+
+        if (not out.empty()) {
+            ret = s.send(out.data(), out.size(), MSG_NOSIGNAL);
+            if (ret == -1) {
+                // The client went away
+                return true;
+            }
+            client_metrics.bytes_sent.inc(ret);
+            time_last_send = now;
+            // The send blocks when the client does not keep up
+            client_metrics.lag.set(chrono::duration<double>(
+                        chrono::steady_clock::now() - now).count());
+        }
+
+        this_thread::sleep_for(frame_duration);
+    }
 }
 
 bool WebRadioInterface::send_mux_playlist(Socket& s)
@@ -898,7 +1400,8 @@ bool WebRadioInterface::send_stream(Socket& s, const string& stream)
                     return false;
                 }
 
-                ProgrammeSender sender(move(s));
+                ClientMetrics client_metrics("mp3/" + to_hex(srv.serviceId, 4));
+                ProgrammeSender sender(move(s), &client_metrics);
 
                 cerr << "Registering mp3 sender" << endl;
                 ph.registerSender(&sender);
@@ -923,47 +1426,62 @@ bool WebRadioInterface::send_stream(Socket& s, const string& stream)
     return false;
 }
 
-bool WebRadioInterface::send_slide(Socket& s, const string& stream)
+bool WebRadioInterface::send_slide(Socket& s, const string& stream,
+        const string& if_none_match)
 {
+    // The web interface appends a query to bust caches, ignore it
+    const string path = stream.substr(0, stream.find('?'));
+
+    string sid = path;
+    string hash;
+    const size_t slash = path.find('/');
+    if (slash != string::npos) {
+        sid = path.substr(0, slash);
+        hash = path.substr(slash + 1);
+    }
+
     for (const auto& wph : phs) {
-        if (to_hex(wph.first, 4) == stream or
-                (uint32_t)stoul(stream) == wph.first) {
+        if (to_hex(wph.first, 4) == sid or
+                (uint32_t)stoul(sid) == wph.first) {
             const auto mot = wph.second.getMOT();
 
-            if (mot.data.empty()) {
+            // A slide of the history never changes, the current slide of
+            // the service has to be revalidated.
+            const auto slide = hash.empty() ? mot.slide : slide_store.get(hash);
+            if (not slide) {
                 send_http_response(s, http_404, "404 Not Found\r\nSlide not available.\r\n");
                 return true;
             }
 
+            const bool not_modified = etag_matches(if_none_match, slide->etag());
+
             stringstream headers;
-            headers << http_ok;
+            headers << (not_modified ? http_304 : http_ok);
 
-            headers << "Content-Type: ";
-            switch (mot.subtype) {
-                case MOTType::Unknown:
-                    headers << "application/octet-stream";
-                    break;
-                case MOTType::JPEG:
-                    headers << "image/jpeg";
-                    break;
-                case MOTType::PNG:
-                    headers << "image/png";
-                    break;
+            if (not not_modified) {
+                headers << "Content-Type: " << slide->info.content_type << "\r\n";
+                headers << "Content-Length: " << slide->data.size() << "\r\n";
             }
-            headers << "\r\n";
 
-            headers << http_nocache;
+            if (hash.empty()) {
+                headers << http_nocache;
 
-            headers << "Last-Modified: ";
-            time_t t = chrono::system_clock::to_time_t(mot.time);
-            headers << put_time(gmtime(&t), "%a, %d %b %Y %T GMT");
-            headers << "\r\n";
+                headers << "Last-Modified: ";
+                time_t t = chrono::system_clock::to_time_t(mot.last_changed);
+                headers << put_time(gmtime(&t), "%a, %d %b %Y %T GMT");
+                headers << "\r\n";
+            }
+            else {
+                headers << "Cache-Control: max-age=31536000, immutable\r\n";
+            }
+
+            headers << "ETag: " << slide->etag() << "\r\n";
 
             headers << "\r\n";
             const auto headers_str = headers.str();
             int ret = s.send(headers_str.data(), headers_str.size(), MSG_NOSIGNAL);
-            if (ret == (ssize_t)headers_str.size()) {
-                ret = s.send(mot.data.data(), mot.data.size(), MSG_NOSIGNAL);
+            if (ret == (ssize_t)headers_str.size() and not not_modified) {
+                ret = s.send(slide->data.data(), slide->data.size(), MSG_NOSIGNAL);
             }
 
             if (ret == -1) {
@@ -976,6 +1494,68 @@ bool WebRadioInterface::send_slide(Socket& s, const string& stream)
     return false;
 }
 
+bool WebRadioInterface::send_slide_history(Socket& s)
+{
+    return send_http_response(s, http_ok,
+            build_slide_history_json(slide_store.getHistory()),
+            http_contenttype_json);
+}
+
+// Value of a parameter of the query string, empty if not given
+static string query_parameter(const string& url, const string& name)
+{
+    const size_t query = url.find('?');
+    if (query == string::npos) {
+        return "";
+    }
+
+    for (size_t pos = query + 1; pos < url.size();) {
+        size_t end = url.find('&', pos);
+        if (end == string::npos) {
+            end = url.size();
+        }
+
+        const size_t eq = url.find('=', pos);
+        if (eq < end and url.compare(pos, eq - pos, name) == 0) {
+            return url.substr(eq + 1, end - eq - 1);
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+bool WebRadioInterface::send_epg(Socket& s, const string& url)
+{
+    if (not epg_store) {
+        send_http_response(s, http_404,
+                "404 Not Found\r\nThe programme guide is not decoded, see option -G.\r\n");
+        return true;
+    }
+
+    EpgStore::Query q;
+    q.genre = query_parameter(url, "genre");
+    try {
+        const string sid = query_parameter(url, "sid");
+        const string from = query_parameter(url, "from");
+        const string to = query_parameter(url, "to");
+
+        // The service id in hex with 0x prefix, or in decimal
+        if (not sid.empty()) {
+            q.service_id = stoul(sid, nullptr, sid.compare(0, 2, "0x") == 0 ? 16 : 10);
+        }
+        q.from = from.empty() ? time(nullptr) : stoll(from);
+        q.to = to.empty() ? q.from + 24 * 3600 : stoll(to);
+    }
+    catch (const logic_error&) {
+        send_http_response(s, http_400, "400 Bad Request\r\nInvalid sid, from or to.\r\n");
+        return true;
+    }
+
+    return send_http_response(s, http_ok,
+            build_epg_json(epg_store->getServices(), epg_store->query(q), q.from, q.to),
+            http_contenttype_json);
+}
+
 bool WebRadioInterface::send_fic(Socket& s)
 {
     if (not send_http_response(s, http_ok, "", http_contenttype_data)) {
@@ -983,23 +1563,53 @@ bool WebRadioInterface::send_fic(Socket& s)
         return false;
     }
 
+    // Every client has its own cursor into the ring, and starts
+    // with all FIBs still available.
+    uint64_t cursor = fic_ring.oldest();
+    constexpr size_t max_fibs_per_send = 3 * 16;
+    vector<uint8_t> buf(max_fibs_per_send * FicRing::FIB_LENGTH);
+
+    ClientMetrics client_metrics("fic");
+
     while (true) {
-        unique_lock<mutex> lock(fib_mut);
-        while (fib_blocks.empty()) {
-            new_fib_block_available.wait_for(lock, chrono::seconds(1));
+        uint64_t lost = 0;
+        const size_t num_fibs = fic_ring.read(cursor, buf.data(),
+                max_fibs_per_send, lost, chrono::seconds(1));
+
+        if (lost > 0) {
+            cerr << "FIC client lagging, lost " << lost << " FIBs" << endl;
+            const auto& marker = FicRing::gapMarker();
+            ssize_t ret = s.send(marker.data(), marker.size(), MSG_NOSIGNAL);
+            if (ret == -1) {
+                cerr << "Failed to send FIC data" << endl;
+                return false;
+            }
+            client_metrics.bytes_sent.inc(ret);
         }
-        ssize_t ret = s.send(fib_blocks.front().data(),
-                fib_blocks.front().size(), MSG_NOSIGNAL);
-        if (ret == -1) {
-            cerr << "Failed to send FIC data" << endl;
-            return false;
+
+        if (num_fibs > 0) {
+            ssize_t ret = s.send(buf.data(),
+                    num_fibs * FicRing::FIB_LENGTH, MSG_NOSIGNAL);
+            if (ret == -1) {
+                cerr << "Failed to send FIC data" << endl;
+                return false;
+            }
+            client_metrics.bytes_sent.inc(ret);
         }
 
-        fib_blocks.pop_front();
+        const uint64_t head = fic_ring.head();
+        client_metrics.lag.set(head > cursor ?
+                (head - cursor) * CIF_DURATION / dabparams.fibsPerCIF : 0.0);
     }
     return true;
 }
 
+bool WebRadioInterface::send_metrics(Socket& s)
+{
+    return send_http_response(s, http_ok,
+            metrics::registry().render(), http_contenttype_metrics);
+}
+
 bool WebRadioInterface::send_impulseresponse(Socket& s)
 {
     if (not send_http_response(s, http_ok, "", http_contenttype_data)) {
@@ -1022,17 +1632,10 @@ bool WebRadioInterface::send_impulseresponse(Socket& s)
     return true;
 }
 
-static bool send_fft_data(Socket& s, DSPCOMPLEX *spectrumBuffer, size_t T_u)
+static bool send_fft_data(Socket& s, const vector<float>& spectrum)
 {
-    vector<float> spectrum(T_u);
-
-    // Shift FFT samples
-    const size_t half_Tu = T_u / 2;
-    for (size_t i = 0; i < half_Tu; i++) {
-        spectrum[i] = abs(spectrumBuffer[i + half_Tu]);
-    }
-    for (size_t i = half_Tu; i < T_u; i++) {
-        spectrum[i] = abs(spectrumBuffer[i - half_Tu]);
+    if (spectrum.empty()) {
+        return false;
     }
 
     if (not send_http_response(s, http_ok, "", http_contenttype_data)) {
@@ -1052,42 +1655,15 @@ static bool send_fft_data(Socket& s, DSPCOMPLEX *spectrumBuffer, size_t T_u)
 
 bool WebRadioInterface::send_spectrum(Socket& s)
 {
-    // Get FFT buffer
-    DSPCOMPLEX* spectrumBuffer = spectrum_fft_handler.getVector();
-    auto samples = input.getSpectrumSamples(dabparams.T_u);
-
-    // Continue only if we got data
-    if (samples.size() != (size_t)dabparams.T_u)
-        return false;
-
-    copy(samples.begin(), samples.end(), spectrumBuffer);
-
-    // Do FFT to get the spectrum
-    spectrum_fft_handler.do_FFT();
-
-    return send_fft_data(s, spectrumBuffer, dabparams.T_u);
+    // The engine keeps a reference to the data while we are sending it
+    const auto snapshot = spectrum_engine.getSnapshot();
+    return send_fft_data(s, snapshot->power_db);
 }
 
 bool WebRadioInterface::send_null_spectrum(Socket& s)
 {
-    // Get FFT buffer
-    DSPCOMPLEX* spectrumBuffer = spectrum_fft_handler.getVector();
-
-    lock_guard<mutex> lock(plotdata_mut);
-    if (last_NULL.empty()) {
-        return false;
-    }
-    else if (last_NULL.size() != (size_t)dabparams.T_null) {
-        cerr << "Invalid NULL size " << last_NULL.size() << endl;
-        return false;
-    }
-
-    copy(last_NULL.begin(), last_NULL.begin() + dabparams.T_u, spectrumBuffer);
-
-    // Do FFT to get the spectrum
-    spectrum_fft_handler.do_FFT();
-
-    return send_fft_data(s, spectrumBuffer, dabparams.T_u);
+    const auto snapshot = spectrum_engine.getSnapshot();
+    return send_fft_data(s, snapshot->null_power_db);
 }
 
 bool WebRadioInterface::send_constellation(Socket& s)
@@ -1156,6 +1732,18 @@ bool WebRadioInterface::send_channel(Socket& s)
     return true;
 }
 
+bool WebRadioInterface::send_tii_history(Socket& s)
+{
+    vector<TiiStats::History> histories;
+    {
+        lock_guard<mutex> lock(data_mut);
+        histories = tii_stats.getHistory();
+    }
+
+    return send_http_response(s, http_ok,
+            build_tii_history_json(histories), http_contenttype_json);
+}
+
 bool WebRadioInterface::handle_fft_window_placement_post(Socket& s, const string& fft_window_placement)
 {
     cerr << "POST fft window: " << fft_window_placement << endl;
@@ -1188,6 +1776,7 @@ bool WebRadioInterface::handle_fft_window_placement_post(Socket& s, const string
         ASSERT_RX;
         rx->setReceiverOptions(rro);
     }
+    mux_structure_changed();
 
     string response = http_ok;
     response += http_contenttype_text;
@@ -1231,6 +1820,7 @@ bool WebRadioInterface::handle_coarse_corrector_post(Socket& s, const string& co
         ASSERT_RX;
         rx->setReceiverOptions(rro);
     }
+    mux_structure_changed();
 
     string response = http_ok;
     response += http_contenttype_text;
@@ -1269,9 +1859,28 @@ void WebRadioInterface::handle_phs()
     while (running) {
         this_thread::sleep_for(chrono::seconds(2));
 
+        // Saving the programme guide does not need the receiver
+        if (epg_store and chrono::steady_clock::now() - time_epg_saved > chrono::minutes(1)) {
+            epg_store->save();
+            time_epg_saved = chrono::steady_clock::now();
+        }
+
+        // The gain changes with the AGC, and also without sync
+        const float gain = input.getGain();
+        if (gain != gain_in_mux_json) {
+            gain_in_mux_json = gain;
+            mux_json_measurement_changed();
+        }
+
         unique_lock<mutex> lock(rx_mut);
         ASSERT_RX;
 
+        // The ensemble changes rarely, do not rewrite the cache more
+        // than once a minute
+        if (chrono::steady_clock::now() - time_ensemble_cached > chrono::minutes(1)) {
+            save_cached_ensemble();
+        }
+
         auto serviceList = rx->getServiceList();
         for (auto& s : serviceList) {
             auto scs = rx->getComponents(s);
@@ -1288,7 +1897,9 @@ void WebRadioInterface::handle_phs()
             }
 
             if (phs.count(s.serviceId) == 0) {
-                WebProgrammeHandler ph(s.serviceId, decode_settings.outputCodec);
+                WebProgrammeHandler ph(s.serviceId, decode_settings.outputCodec,
+                        slide_store, [this]() { invalidate_mux_json(); },
+                        [this]() { mux_json_measurement_changed(); });
                 phs.emplace(make_pair(s.serviceId, move(ph)));
             }
         }
@@ -1479,6 +2090,7 @@ void WebRadioInterface::onSNR(float snr)
 {
     lock_guard<mutex> lock(data_mut);
     last_snr = snr;
+    mux_json_measurement_changed();
 }
 
 void WebRadioInterface::onFrequencyCorrectorChange(int fine, int coarse)
@@ -1486,66 +2098,64 @@ void WebRadioInterface::onFrequencyCorrectorChange(int fine, int coarse)
     lock_guard<mutex> lock(data_mut);
     last_fine_correction = fine;
     last_coarse_correction = coarse;
+    mux_json_measurement_changed();
 }
 
 void WebRadioInterface::onSyncChange(char isSync)
 {
     synced = isSync;
+    mux_json_measurement_changed();
 }
 
 void WebRadioInterface::onSignalPresence(bool /*isSignal*/) { }
-void WebRadioInterface::onServiceDetected(uint32_t /*sId*/) { }
-void WebRadioInterface::onNewEnsemble(uint16_t /*eId*/) { }
-void WebRadioInterface::onSetEnsembleLabel(DabLabel& /*label*/) { }
+void WebRadioInterface::onServiceDetected(uint32_t /*sId*/) { mux_structure_changed(); }
+void WebRadioInterface::onNewEnsemble(uint16_t /*eId*/) { mux_structure_changed(); }
+void WebRadioInterface::onSetEnsembleLabel(DabLabel& /*label*/) { mux_structure_changed(); }
 
 void WebRadioInterface::onDateTimeUpdate(const dab_date_time_t& dateTime)
 {
     lock_guard<mutex> lock(data_mut);
     last_dateTime = dateTime;
+    mux_json_measurement_changed();
 }
 
 void WebRadioInterface::onFIBDecodeSuccess(bool crcCheckOk, const uint8_t* fib)
 {
-    if (not crcCheckOk) {
+    if (crcCheckOk) {
+        fic_ring.stage(fib);
+    }
+    else {
         lock_guard<mutex> lock(fib_mut);
         num_fic_crc_errors++;
-        return;
+        mux_json_measurement_changed();
     }
 
-    // Convert the fib bitvector to bytes
-    vector<uint8_t> buf(32);
-    for (size_t i = 0; i < buf.size(); i++) {
-        uint8_t v = 0;
-        for (int j = 0; j < 8; j++) {
-            if (fib[8*i+j]) {
-                v |= 1 << (7-j);
-            }
-        }
-        buf[i] = v;
+    // Publish the FIBs of one CIF together. They also bring the time
+    // of the last FCT0 frame.
+    if (++num_fibs_in_cif == (size_t)dabparams.fibsPerCIF) {
+        num_fibs_in_cif = 0;
+        fic_ring.commit();
+        mux_json_measurement_changed();
     }
-
-    {
-        lock_guard<mutex> lock(fib_mut);
-        fib_blocks.push_back(move(buf));
-
-        if (fib_blocks.size() > 3*250) { // six seconds
-            fib_blocks.pop_front();
-        }
-    }
-
-    new_fib_block_available.notify_one();
 }
 
 void WebRadioInterface::onNewImpulseResponse(vector<float>&& data)
 {
     lock_guard<mutex> lock(plotdata_mut);
     last_CIR = move(data);
+    mux_json_measurement_changed();
 }
 
 void WebRadioInterface::onNewNullSymbol(vector<DSPCOMPLEX>&& data)
 {
-    lock_guard<mutex> lock(plotdata_mut);
-    last_NULL = move(data);
+    if (data.size() != (size_t)dabparams.T_null) {
+        cerr << "Invalid NULL size " << data.size() << endl;
+        return;
+    }
+
+    // The spectrum covers the first T_u samples
+    data.resize(dabparams.T_u);
+    spectrum_engine.setNullSymbol(move(data));
 }
 
 void WebRadioInterface::onConstellationPoints(vector<DSPCOMPLEX>&& data)
@@ -1570,74 +2180,17 @@ void WebRadioInterface::onMessage(message_level_t level, const string& text, con
     if (pending_messages.size() > MAX_PENDING_MESSAGES) {
         pending_messages.pop_front();
     }
+    invalidate_mux_json();
 }
 
 void WebRadioInterface::onTIIMeasurement(tii_measurement_t&& m)
 {
     lock_guard<mutex> lock(data_mut);
-    auto& l = tiis[make_pair(m.comb, m.pattern)];
-    l.push_back(move(m));
-
-    if (l.size() > 20) {
-        l.pop_front();
-    }
+    tii_stats.add(m);
+    mux_json_measurement_changed();
 }
 
 void WebRadioInterface::onInputFailure()
 {
     exit(1);
 }
-
-list<tii_measurement_t> WebRadioInterface::getTiiStats()
-{
-    list<tii_measurement_t> l;
-
-    for (const auto& cp_list : tiis) {
-        const auto comb = cp_list.first.first;
-        const auto pattern = cp_list.first.second;
-
-        if (cp_list.second.size() < 5) {
-            continue;
-        }
-
-        tii_measurement_t avg;
-        avg.comb = comb;
-        avg.pattern = pattern;
-        vector<int> delays;
-        double error = 0.0;
-        size_t len = 0;
-        for (const auto& meas : cp_list.second) {
-            delays.push_back(meas.delay_samples);
-            error += meas.error;
-            len++;
-        }
-
-        if (len > 0) {
-            avg.error = error / len;
-
-            // Calculate the median
-            nth_element(delays.begin(), delays.begin() + len/2, delays.end());
-            avg.delay_samples = delays[len/2];
-        }
-        else {
-            // To quiet static analysis check
-            avg.error = 0.0;
-            avg.delay_samples = 0;
-        }
-        l.push_back(move(avg));
-    }
-
-    using namespace chrono;
-    const auto now = steady_clock::now();
-    // Remove a single entry every second to make the flukes
-    // disappear
-    if (time_last_tiis_clean + seconds(1) > now) {
-        for (auto& cp_list : tiis) {
-            cp_list.second.pop_front();
-        }
-
-        time_last_tiis_clean = now;
-    }
-
-    return l;
-}
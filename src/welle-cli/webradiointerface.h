@@ -38,12 +38,17 @@
 #include <string>
 #include <cstdint>
 #include <cstddef>
+#include <ctime>
 #include "backend/dab-constants.h"
 #include "backend/radio-controller.h"
-#include "various/fft.h"
+#include "backend/ensemble-cache.h"
+#include "various/spectrum_engine.h"
 #include "various/Socket.h"
 #include "various/channels.h"
 #include "webprogrammehandler.h"
+#include "epgstore.h"
+#include "ficring.h"
+#include "jsonconvert.h"
 #include "radio-receiver-options.h"
 
 class CVirtualInput; // from input/virtual_input.h
@@ -70,6 +75,43 @@ class WebRadioInterface : public RadioControllerInterface {
             DecodeStrategy strategy = DecodeStrategy::OnDemand;
             int num_decoders_in_carousel = 0;
             OutputCodec outputCodec;
+            // Where the ensembles are cached, empty to disable the cache
+            std::string ensembleCacheDirectory;
+            // Where slides go that do not fit into memory anymore,
+            // empty to drop them
+            std::string slideDirectory;
+            // The programme guide, shared by the interfaces of all
+            // channels. Null to not decode the SPI services.
+            std::shared_ptr<EpgStore> epgStore;
+        };
+
+        // The subset of the receiver state that /events pushes as deltas
+        struct live_service_t {
+            uint32_t sid = 0;
+            std::string label;
+            std::string dls_label;
+            std::time_t dls_time = 0;
+            std::time_t dls_lastchange = 0;
+            std::time_t mot_time = 0;
+            std::time_t mot_lastchange = 0;
+            size_t frameerrors = 0;
+            size_t rserrors = 0;
+            size_t aacerrors = 0;
+            bool audiolevel_present = false;
+            std::time_t audiolevel_time = 0;
+            int audiolevel_left = -1;
+            int audiolevel_right = -1;
+        };
+
+        struct live_state_t {
+            std::chrono::steady_clock::time_point time;
+            uint64_t structure_generation = 0;
+            std::string channel;
+            bool synced = false;
+            int snr = 0;
+            int frequencycorrection = 0;
+            size_t fic_crc_errors = 0;
+            std::vector<live_service_t> services;
         };
 
         WebRadioInterface(
@@ -110,8 +152,37 @@ class WebRadioInterface : public RadioControllerInterface {
                 const unsigned int file_length,
                 const std::string& content_type);
 
-        // Generate and send the mux.json
-        bool send_mux_json(Socket& s);
+        // Send the mux.json, or 304 Not Modified if if_none_match
+        // carries the ETag of the current document.
+        bool send_mux_json(Socket& s, const std::string& if_none_match);
+
+        struct mux_json_t {
+            uint64_t generation = 0;
+            std::string etag;
+            std::string json;
+        };
+
+        // Return the cached mux.json, rebuilding it if it is out of date
+        std::shared_ptr<const mux_json_t> get_mux_json();
+
+        // Gather the data that goes into the mux.json
+        MuxJson collect_mux_json();
+
+        // Mark the cached mux.json as out of date. Measurements
+        // invalidate it at most every MUX_JSON_MEASUREMENT_INTERVAL.
+        void invalidate_mux_json() { mux_json_generation++; }
+        void mux_json_measurement_changed() { mux_json_measurements_changed = true; }
+
+        // Ensemble, service list or receiver settings changed, the
+        // /events clients need a new full mux.json
+        void mux_structure_changed() { mux_structure_generation++; invalidate_mux_json(); }
+
+        // Send a text/event-stream that starts with the full mux.json,
+        // followed by deltas at most once per transmission frame.
+        bool send_events(Socket& s);
+
+        // Shared by all /events clients, rebuilt at most once per frame
+        std::shared_ptr<const live_state_t> get_live_state();
 
         // Generate and send a m3u playlist with all services
         bool send_mux_playlist(Socket& s);
@@ -123,8 +194,21 @@ class WebRadioInterface : public RadioControllerInterface {
 
         // Send the slide for the selected programme.
         // stream is a service id, either in hex with 0x prefix or
-        // in decimal
-        bool send_slide(Socket& s, const std::string& stream);
+        // in decimal, optionally followed by a slash and the hash
+        // of an earlier slide of the slide history.
+        bool send_slide(Socket& s, const std::string& stream,
+                const std::string& if_none_match);
+
+        // Send the recent slides of every service
+        bool send_slide_history(Socket& s);
+
+        // Send the programme guide. The query string of the url selects
+        // the programmes: sid, from and to in seconds since the epoch,
+        // and genre. The next 24 hours of all services by default.
+        bool send_epg(Socket& s, const std::string& url);
+
+        // Send all metrics in the Prometheus text exposition format
+        bool send_metrics(Socket& s);
 
         // Send the Fast Information Channel as a stream.
         // Every FIB is 32 bytes long, there three FIBs per 24ms interval,
@@ -135,6 +219,9 @@ class WebRadioInterface : public RadioControllerInterface {
         bool send_impulseresponse(Socket& s);
 
         // Send the signal spectrum, in dB, as a sequence of float values.
+        // The spectra are computed by the spectrum_engine thread, requests
+        // only copy out the latest snapshot. The first request after an
+        // idle time starts the thread and gets an empty spectrum.
         bool send_spectrum(Socket& s);
         bool send_null_spectrum(Socket& s);
 
@@ -144,6 +231,9 @@ class WebRadioInterface : public RadioControllerInterface {
         // Send the currently tuned channel
         bool send_channel(Socket& s);
 
+        // Send the delay history of every transmitter seen since the last retune
+        bool send_tii_history(Socket& s);
+
         // Handle a POSTs
         bool handle_fft_window_placement_post(Socket& s, const std::string& request);
         bool handle_coarse_corrector_post(Socket& s, const std::string& request);
@@ -152,8 +242,19 @@ class WebRadioInterface : public RadioControllerInterface {
         bool handle_channel_post(Socket& s, const std::string& request);
 
         void handle_phs();
+
+        // Empty if the input frequency is not that of a channel
+        std::string tuned_channel();
+
+        // The cached ensemble of the channel the input is tuned to,
+        // nullptr if there is none. Caller must hold rx_mut.
+        std::shared_ptr<const EnsembleSnapshot> load_cached_ensemble();
+        // Caller must hold rx_mut, and the input must still be tuned
+        // to the channel of rx.
+        void save_cached_ensemble();
         void check_decoders_required();
-        std::list<tii_measurement_t> getTiiStats();
+        // Caller must hold rx_mut
+        void check_epg_decoders_required();
 
         std::thread programme_handler_thread;
         std::atomic<bool> running = ATOMIC_VAR_INIT(true);
@@ -161,13 +262,13 @@ class WebRadioInterface : public RadioControllerInterface {
         Channels channels;
         DABParams dabparams;
         CVirtualInput& input;
-        fft::Forward spectrum_fft_handler;
+        SpectrumEngine spectrum_engine;
 
         RadioReceiverOptions rro;
         DecodeSettings decode_settings;
 
         mutable std::mutex data_mut;
-        bool synced = 0;
+        std::atomic<bool> synced = ATOMIC_VAR_INIT(false);
         int last_snr = 0;
         int last_fine_correction = 0;
         int last_coarse_correction = 0;
@@ -183,25 +284,60 @@ class WebRadioInterface : public RadioControllerInterface {
 
         mutable std::mutex plotdata_mut;
         std::vector<float> last_CIR;
-        std::vector<DSPCOMPLEX> last_NULL;
         std::vector<DSPCOMPLEX> last_constellation;
 
+        std::mutex mux_json_mut;
+        std::shared_ptr<const mux_json_t> mux_json;
+        std::chrono::steady_clock::time_point mux_json_time_built;
+        // Distinguishes ETags of different welle-cli runs
+        uint64_t mux_json_epoch = 0;
+        std::atomic<uint64_t> mux_json_generation = ATOMIC_VAR_INIT(1);
+        std::atomic<bool> mux_json_measurements_changed = ATOMIC_VAR_INIT(false);
+        // Last gain seen by the programme handler thread
+        float gain_in_mux_json = 0;
+        std::atomic<uint64_t> mux_structure_generation = ATOMIC_VAR_INIT(1);
+
+        std::mutex live_state_mut;
+        std::shared_ptr<const live_state_t> live_state;
+
         mutable std::mutex fib_mut;
         size_t num_fic_crc_errors = 0;
-        std::condition_variable new_fib_block_available;
-        std::deque<std::vector<uint8_t> > fib_blocks;
 
-        using comb_pattern_t = std::pair<int, int>;
+        // Counts the calls to onFIBDecodeSuccess, the FIC handler calls
+        // it dabparams.fibsPerCIF times per CIF. Only used by the decoder
+        // thread.
+        size_t num_fibs_in_cif = 0;
+        FicRing fic_ring;
 
-        std::chrono::time_point<std::chrono::steady_clock> time_last_tiis_clean;
-        std::map<comb_pattern_t, std::list<tii_measurement_t> > tiis;
+        // Protected by data_mut
+        TiiStats tii_stats;
 
         Socket serverSocket;
 
+        // Only with DecodeSettings::epgStore
+        std::shared_ptr<EpgStore> epg_store;
+        std::chrono::time_point<std::chrono::steady_clock> time_epg_saved;
+
+        // Per subchannel and packet address of the SPI components.
+        // Protected by rx_mut. The handlers are destroyed only after rx,
+        // whose data decoder thread calls them.
+        struct EpgComponent {
+            std::unique_ptr<EpgDataHandler> handler;
+            bool decoded = false;
+        };
+        std::map<std::pair<int16_t, int16_t>, EpgComponent> epg_components;
+
         mutable std::mutex rx_mut;
         std::chrono::time_point<std::chrono::system_clock> time_rx_created;
         std::unique_ptr<RadioReceiver> rx;
 
+        std::unique_ptr<EnsembleCache> ensemble_cache;
+        uint64_t ensemble_version_cached = 0;
+        std::chrono::time_point<std::chrono::steady_clock> time_ensemble_cached;
+
+        // Must outlive phs
+        SlideStore slide_store;
+
         using SId_t = uint32_t;
         std::map<SId_t, WebProgrammeHandler> phs;
         std::map<SId_t, bool> programmes_being_decoded;
@@ -50,9 +50,13 @@
 #endif
 #include "welle-cli/webradiointerface.h"
 #include "welle-cli/tests.h"
+#include "backend/band-scanner.h"
 #include "backend/radio-receiver.h"
+#include "backend/tools.h"
+#include "input/channelizer.h"
 #include "input/input_factory.h"
 #include "input/raw_file.h"
+#include "input/synthetic_input.h"
 #include "various/channels.h"
 #include "libs/json.hpp"
 extern "C" {
@@ -262,7 +266,8 @@ class RadioInterface : public RadioControllerInterface {
                 {"pattern", m.pattern},
                 {"delay", m.delay_samples},
                 {"delay_km", m.getDelayKm()},
-                {"error", m.error}
+                {"error", m.error},
+                {"level", m.level_db}
             };
             cout << j << endl;
         }
@@ -281,6 +286,10 @@ struct options_t {
     string programme = "GRRIF";
     string frontend = "auto";
     string frontend_args = "";
+    // -F given more than once, further tuners for the band scan
+    list<string> extra_frontends;
+    bool channel_given = false;
+    bool band_scan = false;
     bool dump_programme = false;
     bool decode_all_programmes = false;
     int num_decoders_in_carousel = 0;
@@ -288,6 +297,9 @@ struct options_t {
     int web_port = -1; // positive value means enable
     list<int> tests;
     string outputcodec = "";
+    string ensemble_cache_dir = "";
+    string slide_dir = "";
+    string epg_dir = "";
 
     RadioReceiverOptions rro;
 };
@@ -304,7 +316,17 @@ static void usage()
     endl <<
     "Tuning:" << endl <<
     "    -c channel    Tune to <channel> (eg. 10B, 5A, LD...)." << endl <<
+    "                  With -w, several channels separated by commas (eg. 5A,5B,5C)" << endl <<
+    "                  are received from one wideband capture and served on" << endl <<
+    "                  consecutive ports starting at <port>. A raw file without" << endl <<
+    "                  SigMF metadata is assumed to be centred between them, at" << endl <<
+    "                  the smallest multiple of 2048000 sps covering them all." << endl <<
     "    -p programme  Play <programme> with ALSA (text name of the radio: eg. GRIFF)." << endl <<
+    "    -b            Scan the band, or the channels given with -c, for ensembles" << endl <<
+    "                  and print them with the time each channel took. Empty" << endl <<
+    "                  channels are rejected after a short precheck. With -F" << endl <<
+    "                  given several times, the channels are distributed among" << endl <<
+    "                  these tuners and scanned in parallel." << endl <<
     endl <<
     "Dumping:" << endl <<
     "    -D            Dump FIC and all programmes to files (cannot be used with -C)." << endl <<
@@ -323,6 +345,14 @@ static void usage()
     "                  With the -P option, welle-cli will switch once DLS and a" << endl <<
     "                  slide were decoded, staying at most 80 seconds on a given" << endl <<
     "                  programme." << endl <<
+    "    -e directory  Keep the organisation of the received ensembles in the" << endl <<
+    "                  existing <directory>, so that the services of a channel" << endl <<
+    "                  are listed right after tuning to it again." << endl <<
+    "    -S directory  Keep the slides that do not fit into memory anymore in" << endl <<
+    "                  the existing <directory>, instead of forgetting them." << endl <<
+    "    -G directory  Decode the programme guide (SPI) of the MOT data services," << endl <<
+    "                  serve it as /epg.json, and keep it in the existing" << endl <<
+    "                  <directory> across restarts." << endl <<
     endl <<
     "Backend and input options:" << endl <<
     "    -f file       Read an IQ file <file> and play with ALSA." << endl <<
@@ -334,12 +364,18 @@ static void usage()
     "                  Please note that some input drivers are available only if" << endl <<
     "                  they were enabled at build time." << endl <<
     "                  Possible values are: auto (default), airspy, rtl_sdr," << endl <<
-    "                  android_rtl_sdr, rtl_tcp, soapysdr." << endl <<
+    "                  android_rtl_sdr, rtl_tcp, soapysdr, synthetic." << endl <<
     "                  With \"rtl_tcp\", host IP and port can be specified as " << endl <<
     "                  \"rtl_tcp,<HOST_IP>:<PORT>\"." << endl <<
+    "                  With \"synthetic\", a DAB ensemble is generated in software," << endl <<
+    "                  e.g. \"synthetic,services=64,bitrate=16\". Further options:" << endl <<
+    "                  protection=<1-4>, audio=<DAB+ superframe file>, snr=<dB>," << endl <<
+    "                  offset=<Hz>, echo=<delay>:<gain>[:<phase>], seed=<n>," << endl <<
+    "                  throttle=<0|1>." << endl <<
     "    -s args       SoapySDR Driver arguments." << endl <<
     "    -A antenna    Set input antenna to ANT (for SoapySDR input only)." << endl <<
     "    -T            Disable TII decoding to reduce CPU usage." << endl <<
+    "    -I interval   Decode the TII of every <interval>th frame only (default 1)." << endl <<
     "    -O            Output Codec for web streaming : mp3 (default), flac (lossless)" << endl <<
     endl <<
     "Other options:" << endl <<
@@ -377,6 +413,9 @@ static void usage()
     "    Enable web server on port 8000, decode programmes one by one in a carousel" << endl <<
     "    on channel 10B; welle-cli will switch every 10 seconds." << endl <<
     endl <<
+    "welle-cli -b -F rtl_sdr -F rtl_sdr" << endl <<
+    "    Scan the band with two RTL-SDR dongles in parallel." << endl <<
+    endl <<
     "welle-cli -c 10B -PC 1 -w 8000" << endl <<
     "    Enable web server on port 8000, decode programmes one by one in a carousel" << endl <<
     "    on channel 10B; welle-cli will switch once DLS and a slide were decoded," << endl <<
@@ -402,6 +441,19 @@ static void version()
     cerr << "welle-cli " << VERSION << endl;
 }
 
+// Split the argument of -F into the driver and its arguments
+static void split_frontend(const string& fe_opt, string& frontend, string& frontend_args)
+{
+    size_t comma = fe_opt.find(',');
+    if (comma != string::npos) {
+        frontend      = fe_opt.substr(0,comma);
+        frontend_args = fe_opt.substr(comma+1);
+    } else {
+        frontend = fe_opt;
+        frontend_args = "";
+    }
+}
+
 options_t parse_cmdline(int argc, char **argv)
 {
     options_t options;
@@ -409,13 +461,17 @@ options_t parse_cmdline(int argc, char **argv)
     options.rro.decodeTII = true;
 
     int opt;
-    while ((opt = getopt(argc, argv, "A:c:C:dDf:F:g:hp:O:Ps:Tt:uvw:")) != -1) {
+    while ((opt = getopt(argc, argv, "A:bc:C:dDe:f:F:g:G:hI:p:O:Ps:S:Tt:uvw:")) != -1) {
         switch (opt) {
             case 'A':
                 options.antenna = optarg;
                 break;
+            case 'b':
+                options.band_scan = true;
+                break;
             case 'c':
                 options.channel = optarg;
+                options.channel_given = true;
                 break;
             case 'C':
                 options.num_decoders_in_carousel = std::atoi(optarg);
@@ -426,15 +482,27 @@ options_t parse_cmdline(int argc, char **argv)
             case 'D':
                 options.decode_all_programmes = true;
                 break;
+            case 'e':
+                options.ensemble_cache_dir = optarg;
+                break;
             case 'f':
                 options.iqsource = optarg;
                 break;
             case 'F':
+                if (not fe_opt.empty()) {
+                    options.extra_frontends.push_back(fe_opt);
+                }
                 fe_opt = optarg;
                 break;
             case 'g':
                 options.gain = std::atoi(optarg);
                 break;
+            case 'G':
+                options.epg_dir = optarg;
+                break;
+            case 'I':
+                options.rro.tiiFrameInterval = std::max(std::atoi(optarg), 1);
+                break;
             case 'p':
                 options.programme = optarg;
                 break;
@@ -450,6 +518,9 @@ options_t parse_cmdline(int argc, char **argv)
             case 's':
                 options.soapySDRDriverArgs = optarg;
                 break;
+            case 'S':
+                options.slide_dir = optarg;
+                break;
             case 't':
                 options.tests.push_back(std::atoi(optarg));
                 break;
@@ -474,13 +545,7 @@ options_t parse_cmdline(int argc, char **argv)
     }
 
     if (!fe_opt.empty()) {
-        size_t comma = fe_opt.find(',');
-        if (comma != string::npos) {
-            options.frontend      = fe_opt.substr(0,comma);
-            options.frontend_args = fe_opt.substr(comma+1);
-        } else {
-            options.frontend = fe_opt;
-        }
+        split_frontend(fe_opt, options.frontend, options.frontend_args);
     }
     if (options.decode_all_programmes and options.num_decoders_in_carousel > 0) {
         cerr << "Cannot select both -C and -D" << endl;
@@ -490,23 +555,225 @@ options_t parse_cmdline(int argc, char **argv)
     return options;
 }
 
-int main(int argc, char **argv)
+static bool get_decode_settings(const options_t& options,
+        WebRadioInterface::DecodeSettings& ds)
 {
-    auto options = parse_cmdline(argc, argv);
-    version();
+    using DS = WebRadioInterface::DecodeStrategy;
+    if (options.decode_all_programmes) {
+        ds.strategy = DS::All;
+    }
+    else if (options.num_decoders_in_carousel > 0) {
+        if (options.carousel_pad) {
+            ds.strategy = DS::CarouselPAD;
+        }
+        else {
+            ds.strategy = DS::Carousel10;
+        }
+        ds.num_decoders_in_carousel = options.num_decoders_in_carousel;
+    }
+    ds.ensembleCacheDirectory = options.ensemble_cache_dir;
+    ds.slideDirectory = options.slide_dir;
+    if (not options.epg_dir.empty()) {
+        // One guide for all channels, the services are distinct
+        ds.epgStore = make_shared<EpgStore>(options.epg_dir);
+        if (ds.epgStore->load(time(nullptr))) {
+            cerr << "Loaded " << ds.epgStore->getNumProgrammes() <<
+                " programmes of the programme guide" << endl;
+        }
+    }
+    if (options.outputcodec == "" || options.outputcodec == "mp3")
+    {
+        ds.outputCodec = OutputCodec::MP3;
 
-    RadioInterface ri;
+    }
+    else if (options.outputcodec == "flac")
+    {
+        #ifdef HAVE_FLAC
+            ds.outputCodec = OutputCodec::FLAC;
+        #else
+            cerr << "Flac support not compiled. Please enable flac support." << std::endl;
+            return false;
+        #endif
+    }
+    else
+    {
+        cerr << options.outputcodec << " not valid as an outputcodec." << endl;
+        return false;
+    }
+    return true;
+}
+
+// Receive several channels from one wideband capture, with one web
+// server per channel.
+static int serve_channels(unique_ptr<CVirtualInput> in,
+        const vector<string>& channel_names, const options_t& options)
+{
+    if (options.web_port == -1 or not options.tests.empty()) {
+        cerr << "Several channels can only be received with -w" << endl;
+        return 1;
+    }
+
+    WebRadioInterface::DecodeSettings ds;
+    if (not get_decode_settings(options, ds)) {
+        return 1;
+    }
 
     Channels channels;
+    vector<int> frequencies;
+    for (const auto& name : channel_names) {
+        const int freq = channels.getFrequency(name);
+        if (freq == 0) {
+            cerr << "Unknown channel " << name << endl;
+            return 1;
+        }
+        frequencies.push_back(freq);
+    }
+
+    const int decimation = CChannelizer::decimationFor(frequencies);
+    if (decimation == 0) {
+        cerr << "The channels are too far apart to be captured at once" << endl;
+        return 1;
+    }
+
+    // A capture wider than needed is fine. Rates that are no multiple of
+    // the DAB rate are resampled, so also try the usual hardware rates.
+    const int needed = decimation * INPUT_RATE;
+    bool wide_enough = in->getSampleRate() >= needed or in->setSampleRate(needed);
+    for (int rate : {3000000, 6000000, 8000000, 10000000, 20000000}) {
+        if (not wide_enough and rate >= needed) {
+            wide_enough = in->setSampleRate(rate);
+        }
+    }
+    if (not wide_enough) {
+        cerr << "The input cannot capture at " << needed << " sps" << endl;
+        return 1;
+    }
+
+    unique_ptr<CChannelizer> channelizer;
+    try {
+        channelizer = make_unique<CChannelizer>(move(in));
+    }
+    catch (const std::invalid_argument& e) {
+        cerr << "Cannot channelize the input: " << e.what() << endl;
+        return 1;
+    }
+
+    const auto minmax = minmax_element(frequencies.begin(), frequencies.end());
+    channelizer->setCenterFrequency(
+            (int)(((int64_t)*minmax.first + *minmax.second) / 2));
+
+    vector<unique_ptr<WebRadioInterface> > wris;
+    for (size_t i = 0; i < frequencies.size(); i++) {
+        if (not channelizer->canReceive(frequencies[i])) {
+            cerr << "Channel " << channel_names[i] << " is not in the captured band" << endl;
+            return 1;
+        }
+
+        auto& channel = channelizer->addChannel(frequencies[i]);
+        const int port = options.web_port + (int)i;
+        cerr << "Serving channel " << channel_names[i] << " on port " << port << endl;
+        wris.push_back(make_unique<WebRadioInterface>(channel, port, ds, options.rro));
+    }
+
+    vector<thread> servers;
+    for (auto& wri : wris) {
+        servers.emplace_back([&wri]() { wri->serve(); });
+    }
+    for (auto& t : servers) {
+        t.join();
+    }
+    return 0;
+}
+
+// Scan the channels for ensembles, the channels are distributed
+// among the tuners
+static int scan_band(vector<unique_ptr<CVirtualInput> >& tuners,
+        const options_t& options)
+{
+    vector<string> channel_names;
+    if (options.channel_given) {
+        channel_names = MiscTools::SplitString(options.channel, ',');
+    }
+    else {
+        Channels channels;
+        channel_names.push_back(Channels::firstChannel);
+        for (auto c = channels.getNextChannel(); not c.empty(); c = channels.getNextChannel()) {
+            channel_names.push_back(c);
+        }
+    }
+
+    vector<InputInterface*> inputs;
+    for (auto& t : tuners) {
+        inputs.push_back(t.get());
+    }
+
+    BandScanner::Options scan_options;
+    scan_options.rro = options.rro;
+    BandScanner scanner(inputs, scan_options);
+
+    cerr << "Scanning " << channel_names.size() << " channels with " <<
+        tuners.size() << " tuner(s)" << endl;
+
+    const auto start = chrono::steady_clock::now();
+    const auto results = scanner.scan(channel_names,
+            [](const ChannelScanResult& r) {
+                cout << r.channel << "\t" << scanOutcomeToString(r.outcome) <<
+                    "\t" << r.duration.count() << " ms\ttuner " << r.tuner;
+                if (r.outcome == ChannelScanResult::Outcome::Ensemble) {
+                    cout << "\t0x" << hex << r.ensemble->ensembleId << dec <<
+                        " " << r.ensemble->ensembleLabel.utf8_label() <<
+                        " (" << r.ensemble->services.size() << " services)";
+                }
+                cout << endl;
+            });
+    const auto total = chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now() - start);
+
+    size_t num_ensembles = 0;
+    for (const auto& r : results) {
+        if (r.outcome != ChannelScanResult::Outcome::Ensemble) {
+            continue;
+        }
+        num_ensembles++;
+
+        cout << endl << r.channel << " 0x" << hex << r.ensemble->ensembleId << dec <<
+            " " << r.ensemble->ensembleLabel.utf8_label() << endl;
+        for (const auto& s : r.ensemble->services) {
+            cout << "  [0x" << hex << s.serviceId << dec << "] " <<
+                s.serviceLabel.utf8_label() << endl;
+        }
+    }
+
+    cerr << "Scanned " << results.size() << " channels in " << total.count() <<
+        " ms, found " << num_ensembles << " ensembles" << endl;
+    return 0;
+}
 
+// Open the input given by the options, or a tuner of the band scan.
+// Returns nullptr after printing the reason if that fails.
+static unique_ptr<CVirtualInput> open_input(const options_t& options,
+        const string& frontend, const string& frontend_args,
+        RadioInterface& ri)
+{
     unique_ptr<CVirtualInput> in = nullptr;
 
-    if (options.iqsource.empty()) {
-        in.reset(CInputFactory::GetDevice(ri, options.frontend));
+    if (options.iqsource.empty() and frontend == "synthetic") {
+        try {
+            bool throttle = true;
+            auto config = CSyntheticInput::parseArgs(frontend_args, throttle);
+            in = make_unique<CSyntheticInput>(config, throttle);
+        }
+        catch (const std::invalid_argument& e) {
+            cerr << "Cannot generate the synthetic ensemble: " << e.what() << endl;
+            return nullptr;
+        }
+    }
+    else if (options.iqsource.empty()) {
+        in.reset(CInputFactory::GetDevice(ri, frontend));
 
         if (not in) {
             cerr << "Could not start device" << endl;
-            return 1;
+            return nullptr;
         }
     }
     else {
@@ -516,7 +783,7 @@ int main(int argc, char **argv)
         auto in_file = make_unique<CRAWFile>(ri, throttle, rewind);
         if (not in_file) {
             cerr << "Could not prepare CRAWFile" << endl;
-            return 1;
+            return nullptr;
         }
 
         in_file->setFileName(options.iqsource, "auto");
@@ -541,12 +808,12 @@ int main(int argc, char **argv)
         dynamic_cast<CSoapySdr*>(in.get())->setDeviceParam(DeviceParam::SoapySDRDriverArgs, options.soapySDRDriverArgs);
     }
 #endif
-    if (options.frontend == "rtl_tcp" && !options.frontend_args.empty()) {
-        string args = options.frontend_args;
+    if (frontend == "rtl_tcp" && !frontend_args.empty()) {
+        string args = frontend_args;
         size_t colon = args.find(':');
         if (colon == string::npos) {
             cerr << "I need a colon ':' to parse rtl_tcp options!" << endl;
-            return 1;
+            return nullptr;
         }
         else {
             string host = args.substr(0, colon);
@@ -560,6 +827,45 @@ int main(int argc, char **argv)
             // cout << "setting rtl_tcp host to '" << host << "', port to '" << atoi(port.c_str()) << "'" << endl;
         }
     }
+
+    return in;
+}
+
+int main(int argc, char **argv)
+{
+    auto options = parse_cmdline(argc, argv);
+    version();
+
+    RadioInterface ri;
+
+    Channels channels;
+
+    auto in = open_input(options, options.frontend, options.frontend_args, ri);
+    if (not in) {
+        return 1;
+    }
+
+    if (options.band_scan) {
+        vector<unique_ptr<CVirtualInput> > tuners;
+        tuners.push_back(move(in));
+        for (const auto& fe_opt : options.extra_frontends) {
+            string frontend;
+            string frontend_args;
+            split_frontend(fe_opt, frontend, frontend_args);
+            auto tuner = open_input(options, frontend, frontend_args, ri);
+            if (not tuner) {
+                return 1;
+            }
+            tuners.push_back(move(tuner));
+        }
+        return scan_band(tuners, options);
+    }
+
+    const auto channel_names = MiscTools::SplitString(options.channel, ',');
+    if (channel_names.size() > 1) {
+        return serve_channels(move(in), channel_names, options);
+    }
+
     auto freq = channels.getFrequency(options.channel);
     in->setFrequency(freq);
     string service_to_tune = options.programme;
@@ -571,37 +877,8 @@ int main(int argc, char **argv)
         }
     }
     else if (options.web_port != -1) {
-        using DS = WebRadioInterface::DecodeStrategy;
         WebRadioInterface::DecodeSettings ds;
-        if (options.decode_all_programmes) {
-            ds.strategy = DS::All;
-        }
-        else if (options.num_decoders_in_carousel > 0) {
-            if (options.carousel_pad) {
-                ds.strategy = DS::CarouselPAD;
-            }
-            else {
-                ds.strategy = DS::Carousel10;
-            }
-            ds.num_decoders_in_carousel = options.num_decoders_in_carousel;
-        }
-        if (options.outputcodec == "" || options.outputcodec == "mp3")
-        {
-            ds.outputCodec = OutputCodec::MP3;
-
-        }
-        else if (options.outputcodec == "flac")
-        {
-            #ifdef HAVE_FLAC
-                ds.outputCodec = OutputCodec::FLAC;
-            #else
-                cerr << "Flac support not compiled. Please enable flac support." << std::endl;
-                return 1;
-            #endif
-        }
-        else
-        {
-            cerr << options.outputcodec << " not valid as an outputcodec." << endl;
+        if (not get_decode_settings(options, ds)) {
             return 1;
         }
 
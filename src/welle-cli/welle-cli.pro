@@ -8,14 +8,22 @@ HEADERS += \
     alsa-output.h  \
     webprogrammehandler.h \
     webradiointerface.h \
-    jsonconvert.h
+    ficring.h \
+    slidestore.h \
+    epgstore.h \
+    jsonconvert.h \
+    jsonwriter.h
 
 SOURCES += \
     alsa-output.cpp \
     tests.cpp \
     webprogrammehandler.cpp \
     webradiointerface.cpp \
+    ficring.cpp \
+    slidestore.cpp \
+    epgstore.cpp \
     jsonconvert.cpp \
+    jsonwriter.cpp \
     welle-cli.cpp
 
 # Include git hash into build
@@ -81,7 +81,7 @@ SettingSection {
             WComboBox {
                 id: fileFormat
                 sizeToContents: true
-                model: [ "auto", "u8", "s8", "s16le", "s16be", "cf32"];
+                model: [ "auto", "u8", "s8", "s16le", "s16be", "cf32", "s16le-legacy", "s16be-legacy"];
                 onCurrentIndexChanged: {
                      if (isLoaded)
                          __openDevice()
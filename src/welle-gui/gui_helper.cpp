@@ -331,7 +331,6 @@ void CGUIHelper::tryHideWindow()
 // This function is called by the QML GUI
 void CGUIHelper::updateSpectrum()
 {
-    std::vector<DSPCOMPLEX> signalProbeBuffer;
     int T_u = radioController->getParams().T_u;
 
     qreal y = 0;
@@ -345,36 +344,17 @@ void CGUIHelper::updateSpectrum()
     qreal sampleFrequency_MHz = INPUT_RATE / 1e6;
     qreal dip_MHz = sampleFrequency_MHz / T_u;
 
-    signalProbeBuffer = radioController->getSignalProbe();
+    // The spectrum engine already did the FFT, shift and averaging
+    const auto spectrum = radioController->getSpectrum();
 
-    if (signalProbeBuffer.size() == (size_t)T_u) {
+    if (spectrum->power.size() == (size_t)T_u) {
         spectrumSeriesData.resize(T_u);
 
-        fft::Forward FFT(T_u);
-        DSPCOMPLEX* spectrumBuffer = FFT.getVector();
-
-        std::copy(signalProbeBuffer.begin(), signalProbeBuffer.begin() + T_u,
-                spectrumBuffer);
-
-        // Do FFT to get the spectrum
-        FFT.do_FFT();
-
         tunedFrequency_MHz = CurrentFrequency / 1e6;
 
         // Process samples one by one
         for (int i = 0; i < T_u; i++) {
-            int half_Tu = T_u / 2;
-
-            // Shift FFT samples
-            if (i < half_Tu)
-                y = abs(spectrumBuffer[i + half_Tu]);
-            else
-                y = abs(spectrumBuffer[i - half_Tu]);
-
-            // Apply a cumulative moving average filter
-            int avg = 4; // Number of y values to average
-            qreal CMA = spectrumSeriesData[i].y();
-            y = (CMA * avg + y) / (avg + 1);
+            y = std::sqrt(spectrum->power[i]);
 
             // Find maximum value to scale the plotter
             if (y > y_max)
@@ -431,9 +411,7 @@ void CGUIHelper::updateImpulseResponse()
 
 void CGUIHelper::updateNullSymbol()
 {
-    std::vector<DSPCOMPLEX> nullSymbolBuffer;
     int T_u = radioController->getParams().T_u;
-    int T_null = radioController->getParams().T_null;
 
     qreal y = 0;
     qreal x = 0;
@@ -446,36 +424,16 @@ void CGUIHelper::updateNullSymbol()
     qreal sampleFrequency_MHz = INPUT_RATE / 1e6;
     qreal dip_MHz = sampleFrequency_MHz / T_u;
 
-    nullSymbolBuffer = radioController->getNullSymbol();
+    const auto spectrum = radioController->getSpectrum();
 
-    if (nullSymbolBuffer.size() == (size_t)T_null) {
+    if (spectrum->null_power.size() == (size_t)T_u) {
         nullSymbolSeriesData.resize(T_u);
 
-        fft::Forward FFT(T_u);
-        DSPCOMPLEX* spectrumBuffer = FFT.getVector();
-
-        std::copy(nullSymbolBuffer.begin(), nullSymbolBuffer.begin() + T_u,
-                spectrumBuffer);
-
-        // Do FFT to get the spectrum
-        FFT.do_FFT();
-
         tunedFrequency_MHz = CurrentFrequency / 1e6;
 
         // Process samples one by one
         for (int i = 0; i < T_u; i++) {
-            int half_Tu = T_u / 2;
-
-            // Shift FFT samples
-            if (i < half_Tu)
-                y = abs(spectrumBuffer[i + half_Tu]);
-            else
-                y = abs(spectrumBuffer[i - half_Tu]);
-
-            // Apply a cumulative moving average filter
-            int avg = 4; // Number of y values to average
-            qreal CMA = nullSymbolSeriesData[i].y();
-            y = (CMA * avg + y) / (avg + 1);
+            y = std::sqrt(spectrum->null_power[i]);
 
             // Find maximum value to scale the plotter
             if (y > y_max)
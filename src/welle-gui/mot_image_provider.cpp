@@ -61,15 +61,19 @@ QPixmap CMOTImageProvider::requestPixmap(const QString &id, QSize *size, const Q
 void CMOTImageProvider::setPixmap(QPixmap pictureData, QString pictureName)
 {
     // Check if picture is already in list
-    for (auto const& picture : pictureList)
-        if(picture->name == pictureName) {
-            // Replace picture
-            picture->setData(pictureData);
+    for (auto it = pictureList.begin(); it != pictureList.end(); ++it)
+        if((*it)->name == pictureName) {
+            // Replace picture and move it to the front
+            (*it)->setData(pictureData);
+            pictureList.splice(pictureList.begin(), pictureList, it);
             return;
         }
 
     // New picture
     pictureList.push_front(std::make_shared<motPicture>(pictureData, pictureName));
+
+    while (pictureList.size() > maxPictures)
+        pictureList.pop_back();
 }
 
 void CMOTImageProvider::clear()
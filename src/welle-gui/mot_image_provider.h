@@ -46,6 +46,10 @@ public:
     void saveAll(QString folder);
 
 private:
+    // The pictures are kept decoded, only the most recent ones are kept
+    static const size_t maxPictures = 32;
+
+    // Most recently set first
     std::list<std::shared_ptr<motPicture>> pictureList;
 };
 
@@ -32,12 +32,15 @@
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QDir>
 #include <QSettings>
 #include <QStandardPaths>
 #include <QTimeZone>
+#include <algorithm>
 #include <stdexcept>
 
 #include "radio_controller.h"
+#include "band-scanner.h"
 #ifdef HAVE_SOAPYSDR
 #include "soapy_sdr.h"
 #endif /* HAVE_SOAPYSDR */
@@ -80,6 +83,10 @@ CRadioController::CRadioController(QVariantMap& commandLineOptions, QObject *par
     , commandLineOptions(commandLineOptions)
     , audioBuffer(2 * AUDIOBUFFERSIZE)
     , audio(audioBuffer)
+    , spectrumEngine(DABParams(1).T_u, [this](int num_samples) {
+            // Only called while the device is open, see closeDevice()
+            return device->getSpectrumSamples(num_samples);
+        })
     , originalServiceId_(0)
     , originalSubchannelId_(0)
 {
@@ -113,6 +120,13 @@ CRadioController::CRadioController(QVariantMap& commandLineOptions, QObject *par
     connect(this, &CRadioController::restartServiceRequested,
             this, &CRadioController::restartService);
 
+    // Remember the ensembles, to know the services right after tuning
+    const QString ensembleCacheDir =
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/ensembles";
+    if (QDir().mkpath(ensembleCacheDir)) {
+        ensembleCache = std::make_unique<EnsembleCache>(ensembleCacheDir.toStdString());
+    }
+
     // Initialize announcement manager
     announcementManager_ = std::make_unique<AnnouncementManager>();
 
@@ -159,10 +173,21 @@ CRadioController::~CRadioController()
     qDebug() << "RadioController: CRadioController destroyed (announcement state saved)";
 }
 
+void CRadioController::saveEnsembleCache()
+{
+    // Not for "File" or while nothing is tuned
+    if (ensembleCache && radioReceiver && channels.getFrequency(currentChannel.toStdString()) != 0) {
+        ensembleCache->save(currentChannel.toStdString(), *radioReceiver->getEnsemble());
+    }
+}
+
 void CRadioController::closeDevice()
 {
     qDebug() << "RadioController:" << "Close device";
 
+    spectrumEngine.stop();
+    spectrumEngine.reset();
+    saveEnsembleCache();
     radioReceiver.reset();
     device.reset();
     audio.reset();
@@ -393,6 +418,8 @@ void CRadioController::setVolume(qreal Volume)
 void CRadioController::setChannel(QString Channel, bool isScan, bool Force)
 {
     if (currentChannel != Channel || Force == true || isPlaying == false) {
+        std::shared_ptr<const EnsembleSnapshot> cachedEnsemble;
+
         if (device && device->getID() == CDeviceID::RAWFILE) {
             currentChannel = "File";
             if (!isScan)
@@ -402,6 +429,7 @@ void CRadioController::setChannel(QString Channel, bool isScan, bool Force)
             currentFrequency = 0;
         }
         else { // A real device
+            saveEnsembleCache();
             if(radioReceiver)
                 radioReceiver->stop(); // Stop the demodulator in order to avoid working with old data
             currentChannel = Channel;
@@ -416,15 +444,19 @@ void CRadioController::setChannel(QString Channel, bool isScan, bool Force)
             if(currentFrequency != 0 && device) {
                 qDebug() << "RadioController: Tune to channel" <<  Channel << "->" << currentFrequency/1e6 << "MHz";
                 device->setFrequency(currentFrequency);
+                device->updateRecorderFrequency();
                 device->reset(); // Clear buffer
             }
+
+            if (ensembleCache && !isScan)
+                cachedEnsemble = ensembleCache->load(Channel.toStdString());
         }
 
         // Restart demodulator and decoder
         if(device) {
             radioReceiver = std::make_unique<RadioReceiver>(*this, *device, rro, 1);
             radioReceiver->setReceiverOptions(rro);
-            radioReceiver->restart(isScan);
+            radioReceiver->restart(isScan, cachedEnsemble);
         }
 
         emit channelChanged();
@@ -482,6 +514,7 @@ void CRadioController::startScan(void)
     {
         // Start with lowest frequency
         QString Channel = QString::fromStdString(Channels::firstChannel);
+        scanChannelStart = std::chrono::steady_clock::now();
         setChannel(Channel, true);
 
         isChannelScan = true;
@@ -610,15 +643,26 @@ void CRadioController::setGain(int Gain)
 
 void CRadioController::initRecorder(int size)
 {
-    device->initRecordBuffer(size);
+    if (!device)
+        return;
+
+    // The ring buffer of size bytes is kept on disk as the last segments
+    // of a pre-trigger recording, instead of in memory.
+    IQRecorder::Config config;
+    config.directory = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation).toStdString();
+    config.mode = IQRecorder::Mode::PreTrigger;
+    config.maxSegments = 5;
+    config.segmentBytes = std::max(size / 4, 1024 * 1024);
+    device->startRecorder(config);
 }
 
 void CRadioController::triggerRecorder(QString filename)
 {
-    // TODO just for testing
-    filename = QStandardPaths::writableLocation(QStandardPaths::DesktopLocation) + "/welle-io-record.iq";
-    std::string filename_tmp = filename.toStdString();
-    device->writeRecordBufferToFile(filename_tmp);
+    (void)filename;
+    if (!device)
+        return;
+
+    device->triggerRecorder();
 }
 
 DABParams& CRadioController::getParams()
@@ -656,11 +700,9 @@ std::vector<DSPCOMPLEX> CRadioController::getSignalProbe()
     }
 }
 
-std::vector<DSPCOMPLEX> CRadioController::getNullSymbol()
+std::shared_ptr<const SpectrumEngine::Snapshot> CRadioController::getSpectrum()
 {
-    std::lock_guard<std::mutex> lock(nullSymbolBufferMutex);
-    auto buf = std::move(nullSymbolBuffer);
-    return buf;
+    return spectrumEngine.getSnapshot();
 }
 
 std::vector<DSPCOMPLEX> CRadioController::getConstellationPoint()
@@ -707,6 +749,8 @@ void CRadioController::initialise(void)
     deviceId = device->getID();
     emit deviceIdChanged();
 
+    spectrumEngine.start();
+
     if(isAutoPlay) {
         play(autoChannel, tr("Playing last station"), autoService);
     }
@@ -966,10 +1010,41 @@ void CRadioController::stationTimerTimeout()
 
 void CRadioController::channelTimerTimeout(void)
 {
+    using namespace std::chrono;
     channelTimer.stop();
 
-    if(isChannelScan)
+    if (!isChannelScan)
+        return;
+
+    // Move on once the ensemble is complete and did not change for a
+    // second, at the latest after 10 seconds
+    const auto now = steady_clock::now();
+    bool complete = false;
+    if (radioReceiver) {
+        const auto ensemble = radioReceiver->getEnsemble();
+        if (ensemble->version != scanEnsembleVersion) {
+            scanEnsembleVersion = ensemble->version;
+            scanEnsembleChangeTime = now;
+        }
+        complete = BandScanner::isComplete(*ensemble) &&
+            now - scanEnsembleChangeTime >= seconds(1);
+    }
+
+    if (complete || now - scanSignalTime >= seconds(10)) {
         nextChannel(false);
+    }
+    else {
+        channelTimer.start(200);
+    }
+}
+
+void CRadioController::logChannelScanTime()
+{
+    using namespace std::chrono;
+    const bool signal = scanSignalTime >= scanChannelStart;
+    const auto duration = duration_cast<milliseconds>(steady_clock::now() - scanChannelStart);
+    qDebug() << "RadioController: Scanned channel" << currentChannel << "in" <<
+        duration.count() << "ms," << (signal ? "signal found" : "no signal");
 }
 
 void CRadioController::announcementDurationTimerTimeout(void)
@@ -1000,13 +1075,18 @@ void CRadioController::displayDateTime(const dab_date_time_t& dateTime)
 
 void CRadioController::nextChannel(bool isWait)
 {
-    if (isWait) { // It might be a channel, wait 10 seconds
-        channelTimer.start(10000);
+    if (isWait) { // It might be a channel, wait for its ensemble
+        scanSignalTime = std::chrono::steady_clock::now();
+        scanEnsembleChangeTime = scanSignalTime;
+        scanEnsembleVersion = 0;
+        channelTimer.start(200);
     }
     else {
+        logChannelScanTime();
         auto Channel = QString::fromStdString(channels.getNextChannel());
 
         if(!Channel.isEmpty()) {
+            scanChannelStart = std::chrono::steady_clock::now();
             setChannel(Channel, true);
 
             int index = channels.getCurrentIndex() + 1;
@@ -1084,8 +1164,9 @@ void CRadioController::onConstellationPoints(std::vector<DSPCOMPLEX>&& data)
 
 void CRadioController::onNewNullSymbol(std::vector<DSPCOMPLEX>&& data)
 {
-    std::lock_guard<std::mutex> lock(nullSymbolBufferMutex);
-    nullSymbolBuffer = std::move(data);
+    // The spectrum covers the first T_u samples
+    data.resize(getParams().T_u);
+    spectrumEngine.setNullSymbol(std::move(data));
 }
 
 void CRadioController::onTIIMeasurement(tii_measurement_t&& m)
@@ -1094,7 +1175,8 @@ void CRadioController::onTIIMeasurement(tii_measurement_t&& m)
         " pattern " << m.pattern <<
         " delay " << m.delay_samples <<
         "= " << m.getDelayKm() << " km" <<
-        " with error " << m.error;
+        " with error " << m.error <<
+        " level " << m.level_db << " dB";
 }
 
 void CRadioController::onMessage(message_level_t level, const std::string& text, const std::string& text2)
@@ -1143,6 +1225,9 @@ void CRadioController::onSyncChange(char isSync)
     if (this->isSync == sync)
         return;
     this->isSync = sync;
+
+    if (device)
+        device->updateRecorderSync(sync);
     emit isSyncChanged(isSync);
 }
 
@@ -39,6 +39,7 @@
 #include <QImage>
 #include <QVariantMap>
 #include <QFile>
+#include <chrono>
 #include <mutex>
 #include <deque>
 #include <set>
@@ -47,7 +48,9 @@
 #include "audio_output.h"
 #include "dab-constants.h"
 #include "radio-receiver.h"
+#include "ensemble-cache.h"
 #include "ringbuffer.h"
+#include "spectrum_engine.h"
 #include "channels.h"
 #include "../backend/announcement-manager.h"
 #include "../backend/announcement-types.h"
@@ -169,7 +172,7 @@ public:
     // Buffer getter
     std::vector<float> getImpulseResponse(void);
     std::vector<DSPCOMPLEX> getSignalProbe(void);
-    std::vector<DSPCOMPLEX> getNullSymbol(void);
+    std::shared_ptr<const SpectrumEngine::Snapshot> getSpectrum(void);
     std::vector<DSPCOMPLEX> getConstellationPoint(void);
 
     //called from the backend
@@ -238,6 +241,8 @@ private:
     void initialise(void);
     void resetTechnicalData(void);
     bool deviceRestart(void);
+    void saveEnsembleCache(void);
+    void logChannelScanTime(void);
     void addAnnouncementToHistory(const AnnouncementHistoryEntry& entry);
     void loadAnnouncementSettings();
 
@@ -255,12 +260,12 @@ private:
     RadioReceiverOptions rro;
 
     std::unique_ptr<RadioReceiver> radioReceiver;
+    std::unique_ptr<EnsembleCache> ensembleCache;
     RingBuffer<int16_t> audioBuffer;
     CAudio audio;
     std::mutex impulseResponseBufferMutex;
     std::vector<float> impulseResponseBuffer;
-    std::mutex nullSymbolBufferMutex;
-    std::vector<DSPCOMPLEX> nullSymbolBuffer;
+    SpectrumEngine spectrumEngine;
     std::mutex constellationPointBufferMutex;
     std::vector<DSPCOMPLEX> constellationPointBuffer;
 
@@ -307,6 +312,11 @@ private:
     QTimer announcementDurationTimer;  // NEW: Timer for announcement duration updates
 
     bool isChannelScan = false;
+    // A channel with a signal is left once its ensemble is complete
+    std::chrono::steady_clock::time_point scanChannelStart;
+    std::chrono::steady_clock::time_point scanSignalTime;
+    std::chrono::steady_clock::time_point scanEnsembleChangeTime;
+    uint64_t scanEnsembleVersion = 0;
     bool isAGC = false;
     bool isAutoPlay = false;
     QString autoChannel;